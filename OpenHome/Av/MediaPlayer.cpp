@@ -21,6 +21,7 @@
 #include <OpenHome/Media/MimeTypeList.h>
 #include <OpenHome/Av/Logger.h>
 #include <OpenHome/UnixTimestamp.h>
+#include <OpenHome/Av/TrackLookAhead.h>
 
 #include <memory>
 
@@ -40,7 +41,8 @@ MediaPlayer::MediaPlayer(Net::DvStack& aDvStack, Net::DvDeviceStandard& aDevice,
                          IInfoAggregator& aInfoAggregator,
                          const Brx& aEntropy,
                          const Brx& aDefaultRoom,
-                         const Brx& aDefaultName)
+                         const Brx& aDefaultName,
+                         TUint aMaxPlaylistTracks)
     : iDvStack(aDvStack)
     , iDevice(aDevice)
     , iReadWriteStore(aReadWriteStore)
@@ -49,10 +51,12 @@ MediaPlayer::MediaPlayer(Net::DvStack& aDvStack, Net::DvDeviceStandard& aDevice,
     , iConfigAutoPlay(nullptr)
     , iConfigStartupSource(nullptr)
     , iLoggerBuffered(nullptr)
+    , iMaxPlaylistTracks(aMaxPlaylistTracks)
 {
     iUnixTimestamp = new OpenHome::UnixTimestamp(iDvStack.Env());
     iKvpStore = new KvpStore(aStaticDataSource);
-    iTrackFactory = new Media::TrackFactory(aInfoAggregator, kTrackCount);
+    iTrackFactory = new Media::TrackFactory(aInfoAggregator, aMaxPlaylistTracks + kTrackCountNonPlaylist);
+    iTrackLookAhead = new Av::TrackLookAhead();
     iConfigManager = new Configuration::ConfigManager(iReadWriteStore);
     iPowerManager = new OpenHome::PowerManager(*iConfigManager);
     iConfigProductRoom = new ConfigText(*iConfigManager, Product::kConfigIdRoomBase /* + Brx::Empty() */, Product::kMaxRoomBytes, aDefaultRoom);
@@ -80,6 +84,7 @@ MediaPlayer::MediaPlayer(Net::DvStack& aDvStack, Net::DvDeviceStandard& aDevice,
 MediaPlayer::~MediaPlayer()
 {
     ASSERT(!iDevice.Enabled());
+    iTrackLookAhead->Stop(); // observers are owned by protocols, destroyed along with iPipeline
     delete iPipeline;
     delete iCredentials;
     /**
@@ -100,6 +105,7 @@ MediaPlayer::~MediaPlayer()
     delete iConfigProductRoom;
     delete iConfigProductName;
     delete iPowerManager;
+    delete iTrackLookAhead;
     delete iConfigManager;
     delete iTrackFactory;
     delete iKvpStore;
@@ -183,6 +189,11 @@ Media::TrackFactory& MediaPlayer::TrackFactory()
     return *iTrackFactory;
 }
 
+TUint MediaPlayer::MaxPlaylistTracks() const
+{
+    return iMaxPlaylistTracks;
+}
+
 IReadStore& MediaPlayer::ReadStore()
 {
     return *iKvpStore;
@@ -240,6 +251,11 @@ MimeTypeList& MediaPlayer::MimeTypes()
     return iMimeTypes;
 }
 
+Av::ITrackLookAhead& MediaPlayer::TrackLookAhead()
+{
+    return *iTrackLookAhead;
+}
+
 void MediaPlayer::Add(UriProvider* aUriProvider)
 {
     iPipeline->Add(aUriProvider);
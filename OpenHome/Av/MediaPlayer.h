@@ -58,6 +58,7 @@ class VolumeConsumer;
 class IVolumeManager;
 class IVolumeProfile;
 class ConfigStartupSource;
+class ITrackLookAhead;
 
 class IMediaPlayer
 {
@@ -68,6 +69,7 @@ public:
     virtual Net::DvDeviceStandard& Device() = 0;
     virtual Media::PipelineManager& Pipeline() = 0;
     virtual Media::TrackFactory& TrackFactory() = 0;
+    virtual TUint MaxPlaylistTracks() const = 0; // TrackFactory() is sized to allow a playlist this long
     virtual IReadStore& ReadStore() = 0;
     virtual Configuration::IStoreReadWrite& ReadWriteStore() = 0;
     virtual Configuration::IConfigManager& ConfigManager() = 0;
@@ -79,6 +81,7 @@ public:
     virtual Media::IMute& SystemMute() = 0;
     virtual Credentials& CredentialsManager() = 0;
     virtual Media::MimeTypeList& MimeTypes() = 0;
+    virtual Av::ITrackLookAhead& TrackLookAhead() = 0;
     virtual void Add(Media::UriProvider* aUriProvider) = 0;
     virtual void AddAttribute(const TChar* aAttribute) = 0;
     virtual ILoggerSerial& BufferLogOutput(TUint aBytes, IShell& aShell, Optional<ILogPoster> aLogPoster) = 0; // must be called before Start()
@@ -87,7 +90,9 @@ public:
 
 class MediaPlayer : public IMediaPlayer, private INonCopyable
 {
-    static const TUint kTrackCount = 1200;
+    static const TUint kTrackCountNonPlaylist = 200; // tracks referenced by the pipeline and sources other than playlist
+public:
+    static const TUint kDefaultMaxPlaylistTracks = 1000;
 public:
     MediaPlayer(Net::DvStack& aDvStack, Net::DvDeviceStandard& aDevice,
                 IStaticDataSource& aStaticDataSource,
@@ -97,7 +102,8 @@ public:
                 IInfoAggregator& aInfoAggregator,
                 const Brx& aEntropy,
                 const Brx& aDefaultRoom,
-                const Brx& aDefaultName);
+                const Brx& aDefaultName,
+                TUint aMaxPlaylistTracks = kDefaultMaxPlaylistTracks);
     ~MediaPlayer();
     void Quit();
     void Add(Media::Codec::ContainerBase* aContainer);
@@ -112,6 +118,7 @@ public: // from IMediaPlayer
     Net::DvDeviceStandard& Device() override;
     Media::PipelineManager& Pipeline() override;
     Media::TrackFactory& TrackFactory() override;
+    TUint MaxPlaylistTracks() const override;
     IReadStore& ReadStore() override;
     Configuration::IStoreReadWrite& ReadWriteStore() override;
     Configuration::IConfigManager& ConfigManager() override;
@@ -123,6 +130,7 @@ public: // from IMediaPlayer
     Media::IMute& SystemMute() override;
     Credentials& CredentialsManager() override;
     Media::MimeTypeList& MimeTypes() override;
+    Av::ITrackLookAhead& TrackLookAhead() override;
     void Add(Media::UriProvider* aUriProvider) override;
     void AddAttribute(const TChar* aAttribute) override;
     ILoggerSerial& BufferLogOutput(TUint aBytes, IShell& aShell, Optional<ILogPoster> aLogPoster) override; // must be called before Start()
@@ -146,11 +154,13 @@ private:
     ConfigStartupSource* iConfigStartupSource;
     Credentials* iCredentials;
     Media::MimeTypeList iMimeTypes;
+    Av::TrackLookAhead* iTrackLookAhead;
     ProviderTime* iProviderTime;
     ProviderInfo* iProviderInfo;
     Configuration::ProviderConfig* iProviderConfig;
     LoggerBuffered* iLoggerBuffered;
     IUnixTimestamp* iUnixTimestamp;
+    const TUint iMaxPlaylistTracks;
     //TransportControl* iTransportControl;
 };
 
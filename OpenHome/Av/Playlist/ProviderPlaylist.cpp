@@ -25,6 +25,8 @@ static const TUint kIndexNotFoundCode = 802;
 static const Brn kIndexNotFoundMsg("Index not found");
 static const TUint kSeekFailureCode = 803;
 static const Brn kSeekFailureMsg("Seek failed");
+static const TUint kTokenExpiredCode = 804;
+static const Brn kTokenExpiredMsg("Token expired");
 
 // ProviderPlaylist
 
@@ -34,6 +36,7 @@ ProviderPlaylist::ProviderPlaylist(Net::DvDevice& aDevice, Environment& aEnv, IS
     , iSource(aSource)
     , iDatabase(aDatabase)
     , iRepeater(aRepeater)
+    , iIdArrayBuf(aDatabase.TracksMax() * sizeof(TUint32))
     , iTimerLock("PPL2")
     , iTimerActive(false)
 {
@@ -71,6 +74,7 @@ ProviderPlaylist::ProviderPlaylist(Net::DvDevice& aDevice, Environment& aEnv, IS
     EnableActionTracksMax();
     EnableActionIdArray();
     EnableActionIdArrayChanged();
+    EnableActionIdArrayDelta();
     EnableActionProtocolInfo();
 
     NotifyPipelineState(Media::EPipelineStopped);
@@ -78,7 +82,7 @@ ProviderPlaylist::ProviderPlaylist(Net::DvDevice& aDevice, Environment& aEnv, IS
     SetShuffle(false);
     NotifyTrack(ITrackDatabase::kTrackIdNone);
     UpdateIdArrayProperty();
-    (void)SetPropertyTracksMax(ITrackDatabase::kMaxTracks);
+    (void)SetPropertyTracksMax(iDatabase.TracksMax());
 }
 
 ProviderPlaylist::~ProviderPlaylist()
@@ -301,11 +305,10 @@ void ProviderPlaylist::Read(IDvInvocation& aInvocation, TUint aId, IDvInvocation
 
 void ProviderPlaylist::ReadList(IDvInvocation& aInvocation, const Brx& aIdList, IDvInvocationResponseString& aTrackList)
 {
-    iLock.Wait();
-    const TUint seq = iDbSeq;
-    iLock.Signal();
+    /* Each entry is written (and escaped) straight into the response as its track is looked up
+       so memory use doesn't depend on the number of ids requested.  Only one track reference
+       is held at a time. */
     Parser parser(aIdList);
-    TUint index = 0;
     const Brn entryStart("<Entry>");
     const Brn entryEnd("</Entry>");
     const Brn idStart("<Id>");
@@ -318,20 +321,20 @@ void ProviderPlaylist::ReadList(IDvInvocation& aInvocation, const Brx& aIdList,
     idBuf.Set(parser.Next(' '));
 
     aInvocation.StartResponse();
+    WriterInvocationResponseString writer(aTrackList);
     aTrackList.Write(Brn("<TrackList>"));
     do {
         try {
             TUint id = Ascii::Uint(idBuf);
             try {
                 Track* track;
-                iDatabase.GetTrackById(id, seq, track, index);
+                iDatabase.GetTrackById(id, track);
                 AutoAllocatedRef a(track);
                 aTrackList.Write(entryStart);
                 aTrackList.Write(idStart);
                 aTrackList.Write(idBuf);
                 aTrackList.Write(idEnd);
                 aTrackList.Write(uriStart);
-                WriterInvocationResponseString writer(aTrackList);
                 Converter::ToXmlEscaped(writer, track->Uri());
                 aTrackList.Write(uriEnd);
                 aTrackList.Write(metaStart);
@@ -418,6 +421,49 @@ void ProviderPlaylist::IdArrayChanged(IDvInvocation& aInvocation, TUint aToken,
     aInvocation.EndResponse();
 }
 
+void ProviderPlaylist::IdArrayDelta(IDvInvocation& aInvocation, TUint aToken, IDvInvocationResponseUint& aNewToken, IDvInvocationResponseBinary& aDelta)
+{
+    /* Lets control points holding the id array for aToken catch up without fetching the whole
+       array again.  Delta is a sequence of 9 byte records, oldest first:
+           [type:1][id:4][afterId:4]  (ids big endian)
+       type 0 - id inserted after afterId (0 => at the start of the playlist)
+       type 1 - id deleted (afterId is 0)
+       type 2 - all tracks deleted (id and afterId are 0)
+       Error 804 is reported if aToken is too old for its changes to still be known; the whole
+       array should then be read using IdArray. */
+    std::vector<TrackDbChange> changes;
+    TUint seq;
+    if (!iDatabase.GetChanges(aToken, changes, seq)) {
+        aInvocation.Error(kTokenExpiredCode, kTokenExpiredMsg);
+    }
+    aInvocation.StartResponse();
+    aNewToken.Write(seq);
+    Bws<9> record;
+    for (TUint i=0; i<changes.size(); i++) {
+        const TrackDbChange& change = changes[i];
+        record.SetBytes(0);
+        switch (change.iType)
+        {
+        case TrackDbChange::eInsert:
+            record.Append(static_cast<TByte>(0));
+            break;
+        case TrackDbChange::eDelete:
+            record.Append(static_cast<TByte>(1));
+            break;
+        case TrackDbChange::eClear:
+            record.Append(static_cast<TByte>(2));
+            break;
+        }
+        TUint32 bigEndianId = Arch::BigEndian4(change.iId);
+        record.Append(reinterpret_cast<const TByte*>(&bigEndianId), sizeof(bigEndianId));
+        bigEndianId = Arch::BigEndian4(change.iIdAfter);
+        record.Append(reinterpret_cast<const TByte*>(&bigEndianId), sizeof(bigEndianId));
+        aDelta.Write(record);
+    }
+    aDelta.WriteFlush();
+    aInvocation.EndResponse();
+}
+
 void ProviderPlaylist::ProtocolInfo(IDvInvocation& aInvocation, IDvInvocationResponseString& aValue)
 {
     aInvocation.StartResponse();
@@ -452,10 +498,7 @@ void ProviderPlaylist::UpdateIdArray()
 {
     iDatabase.GetIdArray(iIdArray, iDbSeq);
     iIdArrayBuf.SetBytes(0);
-    for (TUint i=0; i<ITrackDatabase::kMaxTracks; i++) {
-        if (iIdArray[i] == ITrackDatabase::kTrackIdNone) {
-            break;
-        }
+    for (TUint i=0; i<iIdArray.size(); i++) {
         TUint32 bigEndianId = Arch::BigEndian4(iIdArray[i]);
         Brn idBuf(reinterpret_cast<const TByte*>(&bigEndianId), sizeof(bigEndianId));
         iIdArrayBuf.Append(idBuf);
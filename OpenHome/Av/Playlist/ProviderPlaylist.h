@@ -9,7 +9,7 @@
 #include <OpenHome/Media/PipelineObserver.h>
 #include <OpenHome/Av/Playlist/TrackDatabase.h>
 
-#include <array>
+#include <vector>
 
 namespace OpenHome {
     class Environment;
@@ -70,6 +70,7 @@ private: // from Net::DvProviderAvOpenhomeOrgPlaylist1
     void TracksMax(Net::IDvInvocation& aInvocation, Net::IDvInvocationResponseUint& aValue) override;
     void IdArray(Net::IDvInvocation& aInvocation, Net::IDvInvocationResponseUint& aToken, Net::IDvInvocationResponseBinary& aArray) override;
     void IdArrayChanged(Net::IDvInvocation& aInvocation, TUint aToken, Net::IDvInvocationResponseBool& aValue) override;
+    void IdArrayDelta(Net::IDvInvocation& aInvocation, TUint aToken, Net::IDvInvocationResponseUint& aNewToken, Net::IDvInvocationResponseBinary& aDelta) override;
     void ProtocolInfo(Net::IDvInvocation& aInvocation, Net::IDvInvocationResponseString& aValue) override;
 private:
     void TrackDatabaseChanged();
@@ -86,8 +87,8 @@ private:
     Brn iProtocolInfo;
     Media::EPipelineState iPipelineState;
     TUint iDbSeq;
-    std::array<TUint, ITrackDatabase::kMaxTracks> iIdArray;
-    Bws<ITrackDatabase::kMaxTracks * sizeof(TUint32)> iIdArrayBuf;
+    std::vector<TUint32> iIdArray;
+    Bwh iIdArrayBuf;
     Timer* iTimer;
     Mutex iTimerLock;
     TBool iTimerActive;
@@ -4,6 +4,7 @@
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Pipeline/Pipeline.h> // for PipelineStreamNotPausable
 #include <OpenHome/Av/Playlist/TrackDatabase.h>
+#include <OpenHome/Av/Playlist/TrackDatabaseJournal.h>
 #include <OpenHome/Av/Playlist/ProviderPlaylist.h>
 #include <OpenHome/Av/Playlist/UriProviderPlaylist.h>
 #include <OpenHome/Media/PipelineManager.h>
@@ -11,6 +12,9 @@
 #include <OpenHome/Av/SourceFactory.h>
 #include <OpenHome/Av/MediaPlayer.h>
 #include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Av/TrackLookAhead.h>
+#include <OpenHome/Optional.h>
+#include <OpenHome/Configuration/IStore.h>
 
 #include <limits.h>
 
@@ -32,7 +36,8 @@ class SourcePlaylist : public Source, private ISourcePlaylist, private ITrackDat
 {
 public:
     SourcePlaylist(Environment& aEnv, Net::DvDevice& aDevice, Media::PipelineManager& aPipeline,
-                   Media::TrackFactory& aTrackFactory, Media::MimeTypeList& aMimeTypeList, IPowerManager& aPowerManager);
+                   Media::TrackFactory& aTrackFactory, Media::MimeTypeList& aMimeTypeList, IPowerManager& aPowerManager,
+                   ITrackLookAheadObserver& aLookAheadObserver, Optional<Configuration::IStoreReadWrite> aStore, TUint aMaxTracks);
     ~SourcePlaylist();
 private:
     void EnsureActive();
@@ -43,6 +48,7 @@ private: // from ISource
     void Deactivate() override;
     void StandbyEnabled() override;
     void PipelineStopped() override;
+    void ProductStarted() override;
 private: // from ISourcePlaylist
     void Play() override;
     void Pause() override;
@@ -69,6 +75,7 @@ private:
     Mutex iLock;
     Mutex iActivationLock;
     TrackDatabase* iDatabase;
+    TrackDatabaseJournal* iJournal;
     Shuffler* iShuffler;
     Repeater* iRepeater;
     UriProviderPlaylist* iUriProvider;
@@ -94,7 +101,27 @@ using namespace OpenHome::Media;
 
 ISource* SourceFactory::NewPlaylist(IMediaPlayer& aMediaPlayer)
 { // static
-    return new SourcePlaylist(aMediaPlayer.Env(), aMediaPlayer.Device(), aMediaPlayer.Pipeline(), aMediaPlayer.TrackFactory(), aMediaPlayer.MimeTypes(), aMediaPlayer.PowerManager());
+    return NewPlaylist(aMediaPlayer, aMediaPlayer.MaxPlaylistTracks());
+}
+
+ISource* SourceFactory::NewPlaylist(IMediaPlayer& aMediaPlayer, Configuration::IStoreReadWrite& aStore)
+{ // static
+    return NewPlaylist(aMediaPlayer, aStore, aMediaPlayer.MaxPlaylistTracks());
+}
+
+ISource* SourceFactory::NewPlaylist(IMediaPlayer& aMediaPlayer, TUint aMaxTracks)
+{ // static
+    ASSERT(aMaxTracks <= aMediaPlayer.MaxPlaylistTracks());
+    return new SourcePlaylist(aMediaPlayer.Env(), aMediaPlayer.Device(), aMediaPlayer.Pipeline(), aMediaPlayer.TrackFactory(),
+                              aMediaPlayer.MimeTypes(), aMediaPlayer.PowerManager(), aMediaPlayer.TrackLookAhead(),
+                              Optional<Configuration::IStoreReadWrite>(), aMaxTracks);
+}
+
+ISource* SourceFactory::NewPlaylist(IMediaPlayer& aMediaPlayer, Configuration::IStoreReadWrite& aStore, TUint aMaxTracks)
+{ // static
+    ASSERT(aMaxTracks <= aMediaPlayer.MaxPlaylistTracks());
+    return new SourcePlaylist(aMediaPlayer.Env(), aMediaPlayer.Device(), aMediaPlayer.Pipeline(), aMediaPlayer.TrackFactory(),
+                              aMediaPlayer.MimeTypes(), aMediaPlayer.PowerManager(), aMediaPlayer.TrackLookAhead(), aStore, aMaxTracks);
 }
 
 const TChar* SourceFactory::kSourceTypePlaylist = "Playlist";
@@ -104,10 +131,12 @@ const Brn SourceFactory::kSourceNamePlaylist("Playlist");
 // SourcePlaylist
 
 SourcePlaylist::SourcePlaylist(Environment& aEnv, Net::DvDevice& aDevice, PipelineManager& aPipeline,
-                               TrackFactory& aTrackFactory, MimeTypeList& aMimeTypeList, IPowerManager& aPowerManager)
+                               TrackFactory& aTrackFactory, MimeTypeList& aMimeTypeList, IPowerManager& aPowerManager,
+                               ITrackLookAheadObserver& aLookAheadObserver, Optional<Configuration::IStoreReadWrite> aStore, TUint aMaxTracks)
     : Source(SourceFactory::kSourceNamePlaylist, SourceFactory::kSourceTypePlaylist, aPipeline, aPowerManager)
     , iLock("SPL1")
     , iActivationLock("SPL2")
+    , iJournal(nullptr)
     , iTrackPosSeconds(0)
     , iStreamId(UINT_MAX)
     , iTransportState(EPipelineStopped)
@@ -115,18 +144,23 @@ SourcePlaylist::SourcePlaylist(Environment& aEnv, Net::DvDevice& aDevice, Pipeli
     , iNoPipelineStateChangeOnActivation(false)
     , iNewPlaylist(true)
 {
-    iDatabase = new TrackDatabase(aTrackFactory);
+    iDatabase = new TrackDatabase(aTrackFactory, aMaxTracks);
     iShuffler = new Shuffler(aEnv, *iDatabase);
     iRepeater = new Repeater(*iShuffler);
-    iUriProvider = new UriProviderPlaylist(*iRepeater, aPipeline, *this);
+    iUriProvider = new UriProviderPlaylist(*iRepeater, aPipeline, *this, aLookAheadObserver);
     iPipeline.Add(iUriProvider); // ownership passes to iPipeline
     iProviderPlaylist = new ProviderPlaylist(aDevice, aEnv, *this, *iDatabase, *iRepeater);
     aMimeTypeList.AddUpnpProtocolInfoObserver(MakeFunctorGeneric(*iProviderPlaylist, &ProviderPlaylist::NotifyProtocolInfo));
     iPipeline.AddObserver(*this);
+    if (aStore.Ok()) {
+        // all other observers of iDatabase must already be registered
+        iJournal = new TrackDatabaseJournal(aStore.Unwrap(), *iDatabase, Brn("Playlist.Tracks"));
+    }
 }
 
 SourcePlaylist::~SourcePlaylist()
 {
+    delete iJournal;
     delete iProviderPlaylist;
     delete iDatabase;
     delete iShuffler;
@@ -220,6 +254,15 @@ void SourcePlaylist::PipelineStopped()
     // FIXME - could nullptr iPipeline (if we also changed it to be a pointer)
 }
 
+void SourcePlaylist::ProductStarted()
+{
+    // restoring inserts tracks, which are passed on to the pipeline, so has to wait until the
+    // pipeline is running.  Restore then happens in the background.
+    if (iJournal != nullptr) {
+        iJournal->Start();
+    }
+}
+
 void SourcePlaylist::Play()
 {
     if (!IsActive()) {
@@ -8,7 +8,6 @@
 #include <OpenHome/Av/Debug.h>
 
 #include <algorithm>
-#include <array>
 #include <vector>
 
 using namespace OpenHome;
@@ -31,13 +30,16 @@ static inline void RemoveRefIfNonNull(Track* aTrack)
 
 // TrackDatabase
 
-TrackDatabase::TrackDatabase(TrackFactory& aTrackFactory)
+TrackDatabase::TrackDatabase(TrackFactory& aTrackFactory, TUint aMaxTracks)
     : iLock("TDB1")
     , iObserverLock("TDB2")
     , iTrackFactory(aTrackFactory)
+    , iMaxTracks(aMaxTracks)
     , iSeq(0)
+    , iIdArrayValid(0)
+    , iChanges(kMaxChanges)
+    , iChangeCount(0)
 {
-    iTrackList.reserve(kMaxTracks);
 }
 
 TrackDatabase::~TrackDatabase()
@@ -50,17 +52,36 @@ void TrackDatabase::AddObserver(ITrackDatabaseObserver& aObserver)
     iObservers.push_back(&aObserver);
 }
 
-void TrackDatabase::GetIdArray(std::array<TUint32, kMaxTracks>& aIdArray, TUint& aSeq) const
+TUint TrackDatabase::TracksMax() const
+{
+    return iMaxTracks;
+}
+
+void TrackDatabase::GetIdArray(std::vector<TUint32>& aIdArray, TUint& aSeq) const
 {
     AutoMutex a(iLock);
-    TUint i;
-    for (i=0; i<iTrackList.size(); i++) {
-        aIdArray[i] = iTrackList[i]->Id();
+    // only rewrite the part of the snapshot that has changed since it was last taken;
+    // typically this is just the tail of a playlist that is being appended to
+    iTrackList.CopyIds(iIdArray, iIdArrayValid);
+    iIdArrayValid = iTrackList.Count();
+    aIdArray = iIdArray;
+    aSeq = iSeq;
+}
+
+TBool TrackDatabase::GetChanges(TUint aSeqFrom, std::vector<TrackDbChange>& aChanges, TUint& aSeq) const
+{
+    AutoMutex a(iLock);
+    aChanges.clear();
+    aSeq = iSeq;
+    const TUint behind = iSeq - aSeqFrom;
+    if (behind > iChangeCount) {
+        return false;
     }
-    for (i=iTrackList.size(); i<kMaxTracks; i++) {
-        aIdArray[i] = kTrackIdNone;
+    aChanges.reserve(behind);
+    for (TUint seq=aSeqFrom+1; seq!=iSeq+1; seq++) {
+        aChanges.push_back(iChanges[seq & (kMaxChanges-1)]);
     }
-    aSeq = iSeq;
+    return true;
 }
 
 void TrackDatabase::GetTrackById(TUint aId, Track*& aTrack) const
@@ -71,25 +92,21 @@ void TrackDatabase::GetTrackById(TUint aId, Track*& aTrack) const
 
 void TrackDatabase::GetTrackByIdLocked(TUint aId, Track*& aTrack) const
 {
-    const TUint index = TrackListUtils::IndexFromId(iTrackList, aId);
-    aTrack = iTrackList[index];
+    aTrack = iTrackList.Find(aId);
+    if (aTrack == nullptr) {
+        THROW(TrackDbIdNotFound);
+    }
     aTrack->AddRef();
 }
 
-void TrackDatabase::GetTrackById(TUint aId, TUint aSeq, Track*& aTrack, TUint& aIndex) const
+void TrackDatabase::GetTrackById(TUint aId, TUint /*aSeq*/, Track*& aTrack, TUint& aIndex) const
 {
+    /* Lookups by id no longer involve a search so there's no benefit in callers that walk an
+       id array passing the previous index as a hint.  aIndex is still updated for them. */
     AutoMutex a(iLock);
     aTrack = nullptr;
-    if (iSeq != aSeq) {
-        GetTrackByIdLocked(aId, aTrack);
-        return;
-    }
-    if (!TryGetTrackById(aId, aTrack, aIndex, iTrackList.size(), aIndex)) {
-        TUint endIndex = std::min(aIndex, (TUint)iTrackList.size());
-        if (!TryGetTrackById(aId, aTrack, 0, endIndex, aIndex)) {
-            THROW(TrackDbIdNotFound);
-        }
-    }
+    aIndex = TrackListUtils::IndexFromId(iTrackList, aId);
+    GetTrackByIdLocked(aId, aTrack);
 }
 
 void TrackDatabase::Insert(TUint aIdAfter, const Brx& aUri, const Brx& aMetaData, TUint& aIdInserted)
@@ -99,7 +116,7 @@ void TrackDatabase::Insert(TUint aIdAfter, const Brx& aUri, const Brx& aMetaData
     AutoMutex _(iObserverLock);
     {
         AutoMutex a(iLock);
-        if (iTrackList.size() == kMaxTracks) {
+        if (iTrackList.Count() >= iMaxTracks) {
             THROW(TrackDbFull);
         }
         TUint index = 0;
@@ -108,10 +125,13 @@ void TrackDatabase::Insert(TUint aIdAfter, const Brx& aUri, const Brx& aMetaData
         }
         track = iTrackFactory.CreateTrack(aUri, aMetaData);
         aIdInserted = track->Id();
-        iTrackList.insert(iTrackList.begin() + index, track);
+        iTrackList.Insert(index, *track);
         iSeq++;
+        IdArrayChangedFrom(index);
+        LogChange(TrackDbChange::eInsert, aIdInserted, aIdAfter);
         idBefore = aIdAfter;
-        idAfter = (index == iTrackList.size()-1? kTrackIdNone : index+1);
+        Track* after = iTrackList.At(index+1);
+        idAfter = (after == nullptr? kTrackIdNone : after->Id());
     }
     for (TUint i=0; i<iObservers.size(); i++) {
         iObservers[i]->NotifyTrackInserted(*track, idBefore, idAfter);
@@ -125,18 +145,17 @@ void TrackDatabase::DeleteId(TUint aId)
     AutoMutex _(iObserverLock);
     {
         AutoMutex a(iLock);
-        TUint index = TrackListUtils::IndexFromId(iTrackList, aId);
+        const TUint index = TrackListUtils::IndexFromId(iTrackList, aId);
         if (index > 0) {
-            before = iTrackList[index-1];
+            before = iTrackList.At(index-1);
             before->AddRef();
         }
-        if (index < iTrackList.size()-1) {
-            after = iTrackList[index+1];
-            after->AddRef();
-        }
-        iTrackList[index]->RemoveRef();
-        (void)iTrackList.erase(iTrackList.begin() + index);
+        after = iTrackList.At(index+1);
+        AddRefIfNonNull(after);
+        iTrackList.Remove(aId)->RemoveRef();
         iSeq++;
+        IdArrayChangedFrom(index);
+        LogChange(TrackDbChange::eDelete, aId, kTrackIdNone);
     }
     for (TUint i=0; i<iObservers.size(); i++) {
         iObservers[i]->NotifyTrackDeleted(aId, before, after);
@@ -149,10 +168,12 @@ void TrackDatabase::DeleteAll()
 {
     AutoMutex _(iObserverLock);
     iLock.Wait();
-    const TBool changed = (iTrackList.size() > 0);
+    const TBool changed = (iTrackList.Count() > 0);
     if (changed) {
         TrackListUtils::Clear(iTrackList);
         iSeq++;
+        IdArrayChangedFrom(0);
+        LogChange(TrackDbChange::eClear, kTrackIdNone, kTrackIdNone);
     }
     iLock.Signal();
     if (changed) {
@@ -165,7 +186,7 @@ void TrackDatabase::DeleteAll()
 TUint TrackDatabase::TrackCount() const
 {
     iLock.Wait();
-    const TUint count = iTrackList.size();
+    const TUint count = iTrackList.Count();
     iLock.Signal();
     return count;
 }
@@ -179,14 +200,9 @@ void TrackDatabase::SetObserver(ITrackDatabaseObserver& aObserver)
 
 Track* TrackDatabase::TrackRef(TUint aId)
 {
-    Track* track = nullptr;
     AutoMutex a(iLock);
-    try {
-        const TUint index = TrackListUtils::IndexFromId(iTrackList, aId);
-        track = iTrackList[index];
-        track->AddRef();
-    }
-    catch (TrackDbIdNotFound&) { }
+    Track* track = iTrackList.Find(aId);
+    AddRefIfNonNull(track);
     return track;
 }
 
@@ -195,47 +211,40 @@ Track* TrackDatabase::NextTrackRef(TUint aId)
     Track* track = nullptr;
     AutoMutex a(iLock);
     if (aId == kTrackIdNone) {
-        if (iTrackList.size() > 0) {
-            track = iTrackList[0];
-            track->AddRef();
-        }
+        track = iTrackList.At(0);
     }
     else {
-        try {
-            const TUint index = TrackListUtils::IndexFromId(iTrackList, aId);
-            if (index < iTrackList.size()-1) {
-                track = iTrackList[index+1];
-                track->AddRef();
-            }
+        TUint index;
+        if (iTrackList.TryGetIndex(aId, index)) {
+            track = iTrackList.At(index+1);
         }
-        catch (TrackDbIdNotFound&) { }
     }
+    AddRefIfNonNull(track);
     return track;
 }
 
+Track* TrackDatabase::PeekNextTrackRef(TUint aId)
+{
+    return NextTrackRef(aId);
+}
+
 Track* TrackDatabase::PrevTrackRef(TUint aId)
 {
     Track* track = nullptr;
     AutoMutex a(iLock);
-    try {
-        const TUint index = TrackListUtils::IndexFromId(iTrackList, aId);
-        if (index > 0) {
-            track = iTrackList[index-1];
-            track->AddRef();
-        }
+    TUint index;
+    if (iTrackList.TryGetIndex(aId, index) && index > 0) {
+        track = iTrackList.At(index-1);
+        track->AddRef();
     }
-    catch (TrackDbIdNotFound&) { }
     return track;
 }
 
 Track* TrackDatabase::TrackRefByIndex(TUint aIndex)
 {
-    Track* track = nullptr;
     iLock.Wait();
-    if (aIndex < iTrackList.size()) {
-        track = iTrackList[aIndex];
-        track->AddRef();
-    }
+    Track* track = iTrackList.At(aIndex);
+    AddRefIfNonNull(track);
     iLock.Signal();
     return track;
 }
@@ -249,26 +258,23 @@ Track* TrackDatabase::TrackRefByIndexSorted(TUint /*aIndex*/)
 TBool TrackDatabase::IsValid(TUint aId) const
 {
     AutoMutex _(iLock);
-    try {
-        (void)TrackListUtils::IndexFromId(iTrackList, aId);
-        return true;
-    }
-    catch (TrackDbIdNotFound&) {
-        return false;
-    }
+    return iTrackList.Find(aId) != nullptr;
 }
 
-TBool TrackDatabase::TryGetTrackById(TUint aId, Track*& aTrack, TUint aStartIndex, TUint aEndIndex, TUint& aFoundIndex) const
+void TrackDatabase::IdArrayChangedFrom(TUint aIndex)
 {
-    for (TUint i=aStartIndex; i<aEndIndex; i++) {
-        if (iTrackList[i]->Id() == aId) {
-            aTrack = iTrackList[i];
-            aTrack->AddRef();
-            aFoundIndex = i;
-            return true;
-        }
+    iIdArrayValid = std::min(iIdArrayValid, aIndex);
+}
+
+void TrackDatabase::LogChange(TrackDbChange::EType aType, TUint aId, TUint aIdAfter)
+{
+    TrackDbChange& change = iChanges[iSeq & (kMaxChanges-1)];
+    change.iType = aType;
+    change.iId = aId;
+    change.iIdAfter = aIdAfter;
+    if (iChangeCount < kMaxChanges) {
+        iChangeCount++;
     }
-    return false;
 }
 
 
@@ -276,14 +282,13 @@ TBool TrackDatabase::TryGetTrackById(TUint aId, Track*& aTrack, TUint aStartInde
 
 Shuffler::Shuffler(Environment& aEnv, ITrackDatabaseReader& aReader)
     : iLock("TSHF")
-    , iEnv(aEnv)
     , iReader(aReader)
     , iObserver(nullptr)
     , iPrevTrackId(ITrackDatabase::kTrackIdNone)
     , iShuffle(false)
 {
+    SetSeed(aEnv.Random(0x7fffffff));
     aReader.SetObserver(*this);
-    iShuffleList.reserve(ITrackDatabase::kMaxTracks);
 }
 
 TBool Shuffler::Enabled() const
@@ -314,17 +319,25 @@ void Shuffler::Reshuffle()
     iLock.Signal();
 }
 
+void Shuffler::SetSeed(TUint aSeed)
+{
+    iLock.Wait();
+    iRandom = (aSeed == 0? 0x9e3779b9 : aSeed); // xorshift never leaves (or reaches) zero
+    iLock.Signal();
+}
+
 TBool Shuffler::TryMoveToStart(TUint aId)
 {
     AutoMutex a(iLock);
     if (iShuffle) {
-        try {
-            const TUint index = TrackListUtils::IndexFromId(iShuffleList, aId);
-            Track* track = iShuffleList[index];
-            MoveToStartOfUnplayed(track, "MoveToStart");
-            return true;
+        Track* track = iShuffleList.Find(aId);
+        if (track != nullptr) {
+            try {
+                MoveToStartOfUnplayed(track, "MoveToStart");
+                return true;
+            }
+            catch (TrackDbIdNotFound&) {}
         }
-        catch (TrackDbIdNotFound&) {}
     }
     return false;
 }
@@ -341,16 +354,15 @@ Track* Shuffler::TrackRef(TUint aId)
     Track* track = nullptr;
     AutoMutex a(iLock);
     if (iShuffle) {
-        try {
-            const TUint index = TrackListUtils::IndexFromId(iShuffleList, aId);
-            track = iShuffleList[index];
+        track = iShuffleList.Find(aId);
+        if (track == nullptr) {
+            iPrevTrackId = ITrackDatabase::kTrackIdNone;
+        }
+        else {
             track->AddRef();
             iPrevTrackId = track->Id();
             LogIds("TrackRef");
         }
-        catch (TrackDbIdNotFound&) {
-            iPrevTrackId = ITrackDatabase::kTrackIdNone;
-        }
     }
     else {
         track = iReader.TrackRef(aId);
@@ -367,32 +379,49 @@ Track* Shuffler::NextTrackRef(TUint aId)
     }
     else {
         if (aId == ITrackDatabase::kTrackIdNone) {
-            if (iShuffleList.size() > 0) {
-                track = iShuffleList[0];
-                track->AddRef();
-            }
+            track = iShuffleList.At(0);
+            AddRefIfNonNull(track);
         }
         else {
-            try {
-                const TUint index = TrackListUtils::IndexFromId(iShuffleList, aId);
-                if (index < iShuffleList.size()-1) {
-                    track = iShuffleList[index+1];
+            TUint index;
+            if (iShuffleList.TryGetIndex(aId, index)) {
+                if (index < iShuffleList.Count()-1) {
+                    track = iShuffleList.At(index+1);
                     track->AddRef();
                 }
-                else if (index == iShuffleList.size()-1) {
+                else {
                     // we've run through the entire list
                     // prefer re-shuffling over repeating the order of tracks if we play again
-                    std::random_shuffle(iShuffleList.begin(), iShuffleList.end());
+                    ShuffleList();
                     LogIds("NextTrackRef");
                 }
             }
-            catch (TrackDbIdNotFound&) { }
         }
         iPrevTrackId = (track == nullptr? ITrackDatabase::kTrackIdNone : track->Id());
     }
     return track;
 }
 
+Track* Shuffler::PeekNextTrackRef(TUint aId)
+{
+    AutoMutex a(iLock);
+    if (!iShuffle) {
+        return iReader.PeekNextTrackRef(aId);
+    }
+    Track* track = nullptr;
+    if (aId == ITrackDatabase::kTrackIdNone) {
+        track = iShuffleList.At(0);
+    }
+    else {
+        TUint index;
+        if (iShuffleList.TryGetIndex(aId, index)) {
+            track = iShuffleList.At(index+1); // nullptr at the end of the list, where NextTrackRef would reshuffle
+        }
+    }
+    AddRefIfNonNull(track);
+    return track;
+}
+
 Track* Shuffler::PrevTrackRef(TUint aId)
 {
     Track* track = nullptr;
@@ -401,14 +430,11 @@ Track* Shuffler::PrevTrackRef(TUint aId)
         track = iReader.PrevTrackRef(aId);
     }
     else {
-        try {
-            const TUint index = TrackListUtils::IndexFromId(iShuffleList, aId);
-            if (index != 0) {
-                track = iShuffleList[index-1];
-                track->AddRef();
-            }
+        TUint index;
+        if (iShuffleList.TryGetIndex(aId, index) && index != 0) {
+            track = iShuffleList.At(index-1);
+            track->AddRef();
         }
-        catch (TrackDbIdNotFound&) { }
     }
     if (iShuffle) {
         if (track == nullptr) {
@@ -440,9 +466,9 @@ Track* Shuffler::TrackRefByIndexSorted(TUint aIndex)
     if (!iShuffle) {
         track = iReader.TrackRefByIndex(aIndex);
     }
-    else if (aIndex < iShuffleList.size()) {
-        track = iShuffleList[aIndex];
-        track->AddRef();
+    else {
+        track = iShuffleList.At(aIndex);
+        AddRefIfNonNull(track);
     }
     return track;
 }
@@ -458,24 +484,22 @@ void Shuffler::NotifyTrackInserted(Track& aTrack, TUint aIdBefore, TUint aIdAfte
     TUint idAfter = aIdAfter;
     try {
         AutoMutex a(iLock);
-        TUint index = 0;
-        if (iShuffleList.size() > 0) {
+        // new tracks go to a random position amongst those still to be played
+        // order is irrelevant while shuffle is off; ShuffleList() starts from a canonical order
+        TUint index = iShuffleList.Count();
+        if (iShuffle) {
             TUint min = 0;
             if (iPrevTrackId != ITrackDatabase::kTrackIdNone) {
                 min = TrackListUtils::IndexFromId(iShuffleList, iPrevTrackId) + 1;
             }
-            if (min == iShuffleList.size()) {
-                index = min;
-            }
-            else {
-                index = iEnv.Random(iShuffleList.size(), min);
-            }
+            index = min + NextRandom(index - min + 1);
         }
-        iShuffleList.insert(iShuffleList.begin() + index, &aTrack);
+        iShuffleList.Insert(index, aTrack);
         aTrack.AddRef();
         if (iShuffle) {
-            idBefore = (index == 0? ITrackDatabase::kTrackIdNone : iShuffleList[index-1]->Id());
-            idAfter = (index == iShuffleList.size()-1? ITrackDatabase::kTrackIdNone : iShuffleList[index+1]->Id());
+            idBefore = (index == 0? ITrackDatabase::kTrackIdNone : iShuffleList.At(index-1)->Id());
+            Track* after = iShuffleList.At(index+1);
+            idAfter = (after == nullptr? ITrackDatabase::kTrackIdNone : after->Id());
             LogIds("TrackInserted");
         }
     }
@@ -493,19 +517,18 @@ void Shuffler::NotifyTrackDeleted(TUint aId, Track* aBefore, Track* aAfter)
         AutoMutex a(iLock);
         const TUint index = TrackListUtils::IndexFromId(iShuffleList, aId);
         if (iShuffle) {
-            before = (index==0? nullptr : iShuffleList[index-1]);
-            after = (index==iShuffleList.size()-1? nullptr : iShuffleList[index+1]);
-            if (iShuffleList[index]->Id() == iPrevTrackId) {
+            before = (index==0? nullptr : iShuffleList.At(index-1));
+            after = iShuffleList.At(index+1);
+            if (aId == iPrevTrackId) {
                 if (index == 0) {
                     iPrevTrackId = ITrackDatabase::kTrackIdNone;
                 }
                 else {
-                    iPrevTrackId = iShuffleList[index-1]->Id();
+                    iPrevTrackId = before->Id();
                 }
             }
         }
-        iShuffleList[index]->RemoveRef();
-        iShuffleList.erase(iShuffleList.begin() + index);
+        iShuffleList.Remove(aId)->RemoveRef();
         LogIds("TrackDeleted");
         AddRefIfNonNull(before);
         AddRefIfNonNull(after);
@@ -530,20 +553,42 @@ void Shuffler::NotifyAllDeleted()
 void Shuffler::DoReshuffle(const TChar* aLogPrefix)
 {
     if (iShuffle) { // prefer re-shuffling over repeating the order of tracks if we play again
-        std::random_shuffle(iShuffleList.begin(), iShuffleList.end());
+        ShuffleList();
         LogIds(aLogPrefix);
         iPrevTrackId = ITrackDatabase::kTrackIdNone;
     }
 }
 
+void Shuffler::ShuffleList()
+{
+    std::vector<Track*> tracks;
+    iShuffleList.CopyItems(tracks);
+    // start from insertion order so that a given seed always gives the same result
+    std::sort(tracks.begin(), tracks.end(), [](const Track* aTrack1, const Track* aTrack2) {
+        return aTrack1->Id() < aTrack2->Id();
+    });
+    for (TUint i=tracks.size(); i>1; i--) { // Fisher-Yates
+        std::swap(tracks[i-1], tracks[NextRandom(i)]);
+    }
+    iShuffleList.Assign(tracks); // references are carried over to the re-ordered list
+}
+
+TUint Shuffler::NextRandom(TUint aRange)
+{ // xorshift32
+    iRandom ^= iRandom << 13;
+    iRandom ^= iRandom >> 17;
+    iRandom ^= iRandom << 5;
+    return iRandom % aRange;
+}
+
 void Shuffler::MoveToStartOfUnplayed(Track* aTrack, const TChar* aLogPrefix)
 {
     const TUint index = TrackListUtils::IndexFromId(iShuffleList, aTrack->Id());
     const TUint cursorIndex = (iPrevTrackId == ITrackDatabase::kTrackIdNone?
             0 : TrackListUtils::IndexFromId(iShuffleList, iPrevTrackId));
     if (index > cursorIndex+1) {
-        iShuffleList.erase(iShuffleList.begin() + index);
-        iShuffleList.insert(iShuffleList.begin() + cursorIndex, aTrack);
+        iShuffleList.Remove(aTrack->Id());
+        iShuffleList.Insert(cursorIndex, *aTrack);
     }
     iPrevTrackId = aTrack->Id();
     LogIds(aLogPrefix);
@@ -551,14 +596,16 @@ void Shuffler::MoveToStartOfUnplayed(Track* aTrack, const TChar* aLogPrefix)
 
 void Shuffler::LogIds(const TChar* aPrefix)
 {
-    LOG(kSources, "%s.  New track order is: { ", aPrefix);
-    if (iShuffleList.size() > 0) {
-        LOG(kSources, "%u", iShuffleList[0]->Id());
-        for (TUint i=1; i<iShuffleList.size(); i++) {
-            LOG(kSources, ", %u", iShuffleList[i]->Id());
-        }
+    if (!Debug::TestLevel(Debug::kSources)) {
+        return; // avoid walking the (potentially very long) list when logging is disabled
     }
-    LOG(kSources, "}\n");
+    std::vector<TUint32> ids;
+    iShuffleList.CopyIds(ids, 0);
+    Log::Print("%s.  New track order is: { ", aPrefix);
+    for (TUint i=0; i<ids.size(); i++) {
+        Log::Print(i == 0? "%u" : ", %u", ids[i]);
+    }
+    Log::Print("}\n");
 }
 
 
@@ -604,6 +651,16 @@ Track* Repeater::NextTrackRef(TUint aId)
     return track;
 }
 
+Track* Repeater::PeekNextTrackRef(TUint aId)
+{
+    AutoMutex a(iLock);
+    Track* track = iReader.PeekNextTrackRef(aId);
+    if (track == nullptr && iRepeat) {
+        track = iReader.PeekNextTrackRef(ITrackDatabase::kTrackIdNone);
+    }
+    return track;
+}
+
 Track* Repeater::PrevTrackRef(TUint aId)
 {
     AutoMutex a(iLock);
@@ -634,7 +691,6 @@ void Repeater::NotifyTrackInserted(Track& aTrack, TUint aIdBefore, TUint aIdAfte
 {
     iLock.Wait();
     iTrackCount++;
-    ASSERT(iTrackCount <= ITrackDatabase::kMaxTracks);
     iLock.Signal();
     iObserver->NotifyTrackInserted(aTrack, aIdBefore, aIdAfter);
 }
@@ -642,8 +698,8 @@ void Repeater::NotifyTrackInserted(Track& aTrack, TUint aIdBefore, TUint aIdAfte
 void Repeater::NotifyTrackDeleted(TUint aId, Track* aBefore, Track* aAfter)
 {
     iLock.Wait();
+    ASSERT(iTrackCount > 0);
     iTrackCount--;
-    ASSERT(iTrackCount <= ITrackDatabase::kMaxTracks);
     iLock.Signal();
     iObserver->NotifyTrackDeleted(aId, aBefore, aAfter);
 }
@@ -659,20 +715,21 @@ void Repeater::NotifyAllDeleted()
 
 // TrackListUtils
 
-TUint TrackListUtils::IndexFromId(const std::vector<Track*>& aList, TUint aId)
+TUint TrackListUtils::IndexFromId(const TrackList<Track>& aList, TUint aId)
 { // static
-    for (TUint i=0; i<aList.size(); i++) {
-        if (aList[i]->Id() == aId) {
-            return i;
-        }
+    TUint index;
+    if (!aList.TryGetIndex(aId, index)) {
+        THROW(TrackDbIdNotFound);
     }
-    THROW(TrackDbIdNotFound);
+    return index;
 }
 
-void TrackListUtils::Clear(std::vector<Track*>& aList)
+void TrackListUtils::Clear(TrackList<Track>& aList)
 { // static
-    for (TUint i=0; i<aList.size(); i++) {
-        aList[i]->RemoveRef();
+    std::vector<Track*> tracks;
+    aList.CopyItems(tracks);
+    aList.Clear();
+    for (TUint i=0; i<tracks.size(); i++) {
+        tracks[i]->RemoveRef();
     }
-    aList.clear();
 }
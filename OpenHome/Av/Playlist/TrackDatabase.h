@@ -4,8 +4,8 @@
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Exception.h>
 #include <OpenHome/Private/Thread.h>
+#include <OpenHome/Av/Playlist/TrackList.h>
 
-#include <array>
 #include <vector>
 
 EXCEPTION(TrackDbIdNotFound);
@@ -28,15 +28,41 @@ public:
     virtual void NotifyAllDeleted() = 0;
 };
 
+/*
+ * One edit to the database.  The change that moved the database to sequence number N is
+ * recorded against N.
+ */
+class TrackDbChange
+{
+public:
+    enum EType
+    {
+        eInsert // iId inserted immediately after iIdAfter (kTrackIdNone => at the start)
+       ,eDelete // iId deleted
+       ,eClear  // all tracks deleted
+    };
+public:
+    EType iType;
+    TUint iId;
+    TUint iIdAfter;
+};
+
 class ITrackDatabase
 {
 public:
-    static const TUint kMaxTracks = 1000;
+    static const TUint kMaxTracks = 1000; // default capacity; see TrackDatabase's constructor
     static const TUint kTrackIdNone = 0;
 public:
     virtual ~ITrackDatabase() {}
     virtual void AddObserver(ITrackDatabaseObserver& aObserver) = 0;
-    virtual void GetIdArray(std::array<TUint32, kMaxTracks>& aIdArray, TUint& aSeq) const = 0;
+    virtual TUint TracksMax() const = 0;
+    virtual void GetIdArray(std::vector<TUint32>& aIdArray, TUint& aSeq) const = 0; // resizes aIdArray to TrackCount()
+    /*
+     * Sets aChanges to the edits (oldest first) that move the id array from sequence number
+     * aSeqFrom to aSeq, the current sequence number.  Returns false if some of those edits are
+     * no longer held (or aSeqFrom is unknown); callers should then fetch the whole id array.
+     */
+    virtual TBool GetChanges(TUint aSeqFrom, std::vector<TrackDbChange>& aChanges, TUint& aSeq) const = 0;
     virtual void GetTrackById(TUint aId, Media::Track*& aTrack) const = 0;
     virtual void GetTrackById(TUint aId, TUint aSeq, Media::Track*& aTrack, TUint& aIndex) const = 0;
     virtual void Insert(TUint aIdAfter, const Brx& aUri, const Brx& aMetaData, TUint& aIdInserted) = 0;
@@ -52,6 +78,8 @@ public:
     virtual void SetObserver(ITrackDatabaseObserver& aObserver) = 0;
     virtual Media::Track* TrackRef(TUint aId) = 0;
     virtual Media::Track* NextTrackRef(TUint aId) = 0;
+    // as NextTrackRef but leaves any playback state (e.g. a shuffled order's position) untouched
+    virtual Media::Track* PeekNextTrackRef(TUint aId) = 0;
     virtual Media::Track* PrevTrackRef(TUint aId) = 0;
     virtual Media::Track* TrackRefByIndex(TUint aIndex) = 0;
     virtual Media::Track* TrackRefByIndexSorted(TUint aIndex) = 0;
@@ -67,12 +95,20 @@ public:
 
 class TrackDatabase : public ITrackDatabase, public ITrackDatabaseReader
 {
+    static const TUint kMaxChanges = 1024; // power of two so that slots survive iSeq wrapping
 public:
-    TrackDatabase(Media::TrackFactory& aTrackFactory);
+    /*
+     * aMaxTracks is limited only by memory.  Lookups by id are O(1) and positional changes
+     * O(log n) so very large playlists remain cheap to edit.  Note that every track held
+     * also holds a cell from aTrackFactory's allocator.
+     */
+    TrackDatabase(Media::TrackFactory& aTrackFactory, TUint aMaxTracks = kMaxTracks);
     ~TrackDatabase();
 private: // from ITrackDatabase
     void AddObserver(ITrackDatabaseObserver& aObserver) override;
-    void GetIdArray(std::array<TUint32, kMaxTracks>& aIdArray, TUint& aSeq) const override;
+    TUint TracksMax() const override;
+    void GetIdArray(std::vector<TUint32>& aIdArray, TUint& aSeq) const override;
+    TBool GetChanges(TUint aSeqFrom, std::vector<TrackDbChange>& aChanges, TUint& aSeq) const override;
     void GetTrackById(TUint aId, Media::Track*& aTrack) const override;
     void GetTrackById(TUint aId, TUint aSeq, Media::Track*& aTrack, TUint& aIndex) const override;
     void Insert(TUint aIdAfter, const Brx& aUri, const Brx& aMetaData, TUint& aIdInserted) override;
@@ -83,22 +119,36 @@ private: // from ITrackDatabaseReader
     void SetObserver(ITrackDatabaseObserver& aObserver) override;
     Media::Track* TrackRef(TUint aId) override;
     Media::Track* NextTrackRef(TUint aId) override;
+    Media::Track* PeekNextTrackRef(TUint aId) override;
     Media::Track* PrevTrackRef(TUint aId) override;
     Media::Track* TrackRefByIndex(TUint aIndex) override;
     Media::Track* TrackRefByIndexSorted(TUint aIndex) override;
     TBool IsValid(TUint aId) const override;
 private:
     void GetTrackByIdLocked(TUint aId, Media::Track*& aTrack) const;
-    TBool TryGetTrackById(TUint aId, Media::Track*& aTrack, TUint aStartIndex, TUint aEndIndex, TUint& aFoundIndex) const;
+    void IdArrayChangedFrom(TUint aIndex);
+    void LogChange(TrackDbChange::EType aType, TUint aId, TUint aIdAfter);
 private:
     mutable Mutex iLock;
     Mutex iObserverLock;
     Media::TrackFactory& iTrackFactory;
+    const TUint iMaxTracks;
     std::vector<ITrackDatabaseObserver*> iObservers;
-    std::vector<Media::Track*> iTrackList;
+    TrackList<Media::Track> iTrackList;
     TUint iSeq;
+    mutable std::vector<TUint32> iIdArray; // snapshot, refreshed incrementally by GetIdArray()
+    mutable TUint iIdArrayValid;           // count of leading entries in iIdArray that are still current
+    std::vector<TrackDbChange> iChanges;   // ring of the most recent changes, indexed by seq
+    TUint iChangeCount;
 };
 
+/*
+ * Maintains a shuffled order of the tracks in a database alongside the database's own order.
+ * Lookups, next/prev, inserting or removing a track and moving a track to play next are all
+ * O(log n); reshuffling is O(n log n) (a sort by track id, then a linear shuffle).
+ * Shuffled orders are drawn from a generator seeded from aEnv.  Calling SetSeed() makes all
+ * subsequent orders depend only on the seed, the tracks present and the sequence of calls made.
+ */
 class Shuffler : public ITrackDatabaseReader, public ITrackDatabaseObserver
 {
     friend class SuiteShuffler;
@@ -108,11 +158,13 @@ public:
     TBool Enabled() const;
     void SetShuffle(TBool aShuffle);
     void Reshuffle();
+    void SetSeed(TUint aSeed);
     TBool TryMoveToStart(TUint aId); // moves aId to follow iPrevTrackId iff Enabled()
 private: // from ITrackDatabaseReader
     void SetObserver(ITrackDatabaseObserver& aObserver) override;
     Media::Track* TrackRef(TUint aId) override;
     Media::Track* NextTrackRef(TUint aId) override;
+    Media::Track* PeekNextTrackRef(TUint aId) override;
     Media::Track* PrevTrackRef(TUint aId) override;
     Media::Track* TrackRefByIndex(TUint aIndex) override;
     Media::Track* TrackRefByIndexSorted(TUint aIndex) override;
@@ -123,16 +175,18 @@ private: // from ITrackDatabaseObserver
     void NotifyAllDeleted() override;
 private:
     void DoReshuffle(const TChar* aLogPrefix);
+    void ShuffleList();
+    TUint NextRandom(TUint aRange); // [0..aRange)
     void MoveToStartOfUnplayed(Media::Track* aTrack, const TChar* aLogPrefix);
     void LogIds(const TChar* aPrefix);
 private:
     mutable Mutex iLock;
-    Environment& iEnv;
     ITrackDatabaseReader& iReader;
     ITrackDatabaseObserver* iObserver;
-    std::vector<Media::Track*> iShuffleList;
+    TrackList<Media::Track> iShuffleList;
     TUint iPrevTrackId;
     TBool iShuffle;
+    TUint iRandom;
 };
 
 class Repeater : public IRepeater, public ITrackDatabaseReader, public ITrackDatabaseObserver
@@ -145,6 +199,7 @@ private: // from ITrackDatabaseReader
     void SetObserver(ITrackDatabaseObserver& aObserver) override;
     Media::Track* TrackRef(TUint aId) override;
     Media::Track* NextTrackRef(TUint aId) override;
+    Media::Track* PeekNextTrackRef(TUint aId) override;
     Media::Track* PrevTrackRef(TUint aId) override;
     Media::Track* TrackRefByIndex(TUint aIndex) override;
     Media::Track* TrackRefByIndexSorted(TUint aIndex) override;
@@ -164,8 +219,8 @@ private:
 class TrackListUtils
 {
 public:
-    static TUint IndexFromId(const std::vector<Media::Track*>& aList, TUint aId);
-    static void Clear(std::vector<Media::Track*>& aList);
+    static TUint IndexFromId(const TrackList<Media::Track>& aList, TUint aId);
+    static void Clear(TrackList<Media::Track>& aList); // also releases the list's references
 };
 
 } // namespace Av
@@ -0,0 +1,572 @@
+#include <OpenHome/Av/Playlist/TrackDatabaseJournal.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Arch.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Debug.h>
+#include <OpenHome/Configuration/IStore.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Av/Playlist/TrackList.h>
+#include <OpenHome/Av/Debug.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+using namespace OpenHome::Configuration;
+using namespace OpenHome::Media;
+
+/* Store layout (all integers big endian)
+
+   <prefix>.Header     [version:4][slot:4][snapshot chunk count:4]
+   <prefix>.<slot>.S<n> snapshot chunks; the playlist in order as a series of insert records
+   <prefix>.<slot>.J<n> journal chunks; records for each edit made after the snapshot was taken
+
+   Records:
+       insert   [1][id:4][idAfter:4][uri bytes:2][uri][metadata bytes:2][metadata]
+       delete   [2][id:4]
+       clear    [3]
+       renumber [4][index:4][count:2][id:4]*count
+
+   A run of renumber records gives new ids to every track in the playlist, in order.  The run
+   starts at index 0 and only takes effect once it has covered the whole playlist.
+
+   No chunk is larger than kChunkBytes and no record spans chunks. */
+
+static void AppendUint16(Bwx& aBuf, TUint aVal)
+{
+    aBuf.Append(static_cast<TByte>(aVal >> 8));
+    aBuf.Append(static_cast<TByte>(aVal));
+}
+
+static void AppendUint32(Bwx& aBuf, TUint aVal)
+{
+    const TUint32 bigEndian = Arch::BigEndian4(static_cast<TUint32>(aVal));
+    aBuf.Append(reinterpret_cast<const TByte*>(&bigEndian), sizeof(bigEndian));
+}
+
+static TUint ReadUint16(const TByte* aPtr)
+{
+    return (static_cast<TUint>(aPtr[0]) << 8) | aPtr[1];
+}
+
+static TUint ReadUint32(const TByte* aPtr)
+{
+    return (static_cast<TUint>(aPtr[0]) << 24) | (static_cast<TUint>(aPtr[1]) << 16) |
+           (static_cast<TUint>(aPtr[2]) << 8) | aPtr[3];
+}
+
+
+// TrackDatabaseJournal::RestoreEntry
+
+TrackDatabaseJournal::RestoreEntry::RestoreEntry(TUint aId, const Brx& aUri, const Brx& aMetaData)
+    : iId(aId)
+    , iUri(aUri)
+    , iMetaData(aMetaData)
+{
+}
+
+TUint TrackDatabaseJournal::RestoreEntry::Id() const
+{
+    return iId;
+}
+
+
+// TrackDatabaseJournal
+
+TrackDatabaseJournal::TrackDatabaseJournal(IStoreReadWrite& aStore, ITrackDatabase& aDatabase, const Brx& aKeyPrefix)
+    : iStore(aStore)
+    , iDatabase(aDatabase)
+    , iLock("TDBJ")
+    , iSemFlushed("TDBF", 0)
+    , iSemFlushNow("TDBN", 0)
+    , iKeyPrefix(aKeyPrefix)
+    , iPending(kChunkBytes)
+    , iWriting(kChunkBytes)
+    , iTail(kChunkBytes)
+    , iRecording(false)
+    , iFlushWaiters(0)
+    , iSlot(0)
+    , iSnapshotChunks(0)
+    , iJournalChunks(0)
+{
+    iKeyHeader.Replace(iKeyPrefix);
+    iKeyHeader.Append(".Header");
+    iDatabase.AddObserver(*this);
+    iThread = new ThreadFunctor("TrackDbJournal", MakeFunctor(*this, &TrackDatabaseJournal::Run), kPriorityLow);
+}
+
+TrackDatabaseJournal::~TrackDatabaseJournal()
+{
+    iSemFlushNow.Signal(); // don't wait out kFlushDelayMs before the thread can exit
+    delete iThread;
+}
+
+void TrackDatabaseJournal::Start()
+{
+    iThread->Start();
+}
+
+void TrackDatabaseJournal::Flush()
+{
+    iLock.Wait();
+    iFlushWaiters++;
+    iLock.Signal();
+    iThread->Signal();
+    iSemFlushNow.Signal();
+    iSemFlushed.Wait();
+}
+
+void TrackDatabaseJournal::NotifyTrackInserted(Track& aTrack, TUint aIdBefore, TUint /*aIdAfter*/)
+{
+    AutoMutex _(iLock);
+    if (PrepareRecordLocked(InsertBytes(aTrack.Uri(), aTrack.MetaData()))) {
+        AppendInsert(iPending, aTrack.Id(), aIdBefore, aTrack.Uri(), aTrack.MetaData());
+    }
+}
+
+void TrackDatabaseJournal::NotifyTrackDeleted(TUint aId, Track* /*aBefore*/, Track* /*aAfter*/)
+{
+    AutoMutex _(iLock);
+    if (PrepareRecordLocked(5)) {
+        iPending.Append(kRecordDelete);
+        AppendUint32(iPending, aId);
+    }
+}
+
+void TrackDatabaseJournal::NotifyAllDeleted()
+{
+    AutoMutex _(iLock);
+    if (PrepareRecordLocked(1)) {
+        iPending.Append(kRecordClear);
+    }
+}
+
+TUint TrackDatabaseJournal::InsertBytes(const Brx& aUri, const Brx& aMetaData)
+{ // static
+    return 1 + 4 + 4 + 2 + aUri.Bytes() + 2 + aMetaData.Bytes();
+}
+
+void TrackDatabaseJournal::AppendInsert(Bwx& aBuf, TUint aId, TUint aIdAfter, const Brx& aUri, const Brx& aMetaData)
+{ // static
+    aBuf.Append(kRecordInsert);
+    AppendUint32(aBuf, aId);
+    AppendUint32(aBuf, aIdAfter);
+    AppendUint16(aBuf, aUri.Bytes());
+    aBuf.Append(aUri);
+    AppendUint16(aBuf, aMetaData.Bytes());
+    aBuf.Append(aMetaData);
+}
+
+TUint TrackDatabaseJournal::RecordBytes(const Brx& aBuf, TUint aOffset)
+{ // static
+    const TUint remaining = aBuf.Bytes() - aOffset;
+    const TByte* ptr = aBuf.Ptr() + aOffset;
+    switch (ptr[0])
+    {
+    case kRecordInsert:
+    {
+        TUint bytes = 1 + 4 + 4 + 2;
+        if (remaining < bytes) {
+            return 0;
+        }
+        bytes += ReadUint16(ptr + bytes - 2) + 2;
+        if (remaining < bytes) {
+            return 0;
+        }
+        bytes += ReadUint16(ptr + bytes - 2);
+        return (remaining < bytes? 0 : bytes);
+    }
+    case kRecordDelete:
+        return (remaining < 5? 0 : 5);
+    case kRecordClear:
+        return 1;
+    case kRecordRenumber:
+    {
+        if (remaining < 7) {
+            return 0;
+        }
+        const TUint bytes = 7 + 4 * ReadUint16(ptr + 5);
+        return (remaining < bytes? 0 : bytes);
+    }
+    default:
+        return 0;
+    }
+}
+
+TBool TrackDatabaseJournal::PrepareRecordLocked(TUint aBytes)
+{
+    /* Edits reported before the first snapshot is taken (including those made by Restore())
+       will be captured by that snapshot so needn't be journalled. */
+    if (!iRecording) {
+        return false;
+    }
+    if (iPending.Bytes() == 0) {
+        iThread->Signal();
+    }
+    if (iPending.Bytes() + aBytes > iPending.MaxBytes()) {
+        iPending.Grow(std::max(iPending.MaxBytes() * 2, iPending.Bytes() + aBytes));
+    }
+    return true;
+}
+
+void TrackDatabaseJournal::Run()
+{
+    if (!Restore()) {
+        Compact();
+    }
+    for (;;) {
+        iThread->Wait();
+        iLock.Wait();
+        const TBool flushNow = (iFlushWaiters > 0);
+        iLock.Signal();
+        if (!flushNow) {
+            // give any further edits (e.g. the rest of a multi-track insert) a chance to arrive
+            try {
+                iSemFlushNow.Wait(kFlushDelayMs);
+            }
+            catch (Timeout&) {}
+        }
+        (void)iSemFlushNow.Clear();
+        iLock.Wait();
+        const TUint waiters = iFlushWaiters;
+        iFlushWaiters = 0;
+        iLock.Signal();
+        FlushJournal();
+        if (iJournalChunks >= kCompactMinChunks && iJournalChunks >= iSnapshotChunks) {
+            Compact();
+        }
+        for (TUint i=0; i<waiters; i++) {
+            iSemFlushed.Signal();
+        }
+    }
+}
+
+TBool TrackDatabaseJournal::Restore()
+{
+    Bws<12> header;
+    try {
+        iStore.Read(iKeyHeader, header);
+    }
+    catch (StoreKeyNotFound&) {
+        return false;
+    }
+    catch (StoreReadBufferUndersized&) {
+        LOG(kError, "TrackDatabaseJournal: unrecognised header\n");
+        return false;
+    }
+    if (header.Bytes() != header.MaxBytes() || ReadUint32(header.Ptr()) != kVersion) {
+        LOG(kError, "TrackDatabaseJournal: unrecognised header\n");
+        return false;
+    }
+    iSlot = ReadUint32(header.Ptr() + 4) & 1;
+    iSnapshotChunks = ReadUint32(header.Ptr() + 8);
+
+    // Chunks are kept in memory until the playlist has been rebuilt as entries refer into them.
+    // Replaying uses a TrackList so each record costs O(log n) however long the playlist.
+    TBool intact = true;
+    std::vector<Bwh*> chunks;
+    TrackList<RestoreEntry> list;
+    std::vector<RestoreEntry*> entries;
+    std::vector<TUint32> renumber;
+    Bws<kMaxKeyBytes> key;
+    for (TUint i=0; ; i++) {
+        const TBool snapshot = (i < iSnapshotChunks);
+        ChunkKey(key, iSlot, snapshot? 'S' : 'J', snapshot? i : i - iSnapshotChunks);
+        Bwh* chunk = new Bwh(kChunkBytes);
+        try {
+            iStore.Read(key, *chunk);
+        }
+        catch (StoreKeyNotFound&) {
+            delete chunk;
+            if (snapshot) {
+                // restore what we can; the journal may still refer to tracks from earlier chunks
+                LOG(kError, "TrackDatabaseJournal: snapshot chunk %u of %u missing\n", i, iSnapshotChunks);
+                intact = false;
+                iSnapshotChunks = i;
+                i--;
+                continue;
+            }
+            break;
+        }
+        catch (StoreReadBufferUndersized&) {
+            delete chunk;
+            LOG(kError, "TrackDatabaseJournal: chunk %.*s too large\n", PBUF(key));
+            intact = false;
+            continue;
+        }
+        chunks.push_back(chunk);
+        Replay(*chunk, list, entries, renumber);
+    }
+    const TUint journalChunks = (TUint)chunks.size() - std::min((TUint)chunks.size(), iSnapshotChunks);
+
+    std::vector<RestoreEntry*> ordered;
+    list.CopyItems(ordered);
+    list.Clear();
+    LOG(kSources, "TrackDatabaseJournal: restoring %u tracks from %u chunks\n", (TUint)ordered.size(), (TUint)chunks.size());
+    std::vector<TUint32> restoredIds;
+    restoredIds.reserve(ordered.size());
+    TUint idAfter = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<ordered.size(); ) {
+        try {
+            TUint id;
+            iDatabase.Insert(idAfter, ordered[i]->iUri, ordered[i]->iMetaData, id);
+            restoredIds.push_back(id);
+            idAfter = id;
+            i++;
+        }
+        catch (TrackDbIdNotFound&) {
+            // the track we were inserting after has been deleted by a control point; carry on
+            // from the end of the playlist
+            std::vector<TUint32> ids;
+            TUint seq;
+            iDatabase.GetIdArray(ids, seq);
+            idAfter = (ids.size() == 0? ITrackDatabase::kTrackIdNone : ids.back());
+            intact = false;
+        }
+        catch (TrackDbFull&) {
+            LOG(kError, "TrackDatabaseJournal: playlist full, %u tracks not restored\n", (TUint)(ordered.size() - i));
+            intact = false;
+            break;
+        }
+    }
+
+    if (intact && journalChunks > 0) {
+        // carry on appending to the last journal chunk
+        iJournalChunks = journalChunks - 1;
+        iTail.Replace(*chunks.back());
+    }
+    for (auto entry : entries) {
+        delete entry;
+    }
+    for (auto chunk : chunks) {
+        delete chunk;
+    }
+    if (!intact) {
+        return false;
+    }
+
+    /* The database now holds the stored playlist under new ids.  Provided no control point has
+       edited it in the meantime, journal the new ids rather than rewriting the store.  Edits
+       from here on are reported after the renumber records so are journalled in order. */
+    AutoMutex _(iLock);
+    iRecording = true;
+    std::vector<TUint32> ids;
+    TUint seq;
+    iDatabase.GetIdArray(ids, seq);
+    if (ids != restoredIds) {
+        return false;
+    }
+    AppendRenumberLocked(ids);
+    return true;
+}
+
+void TrackDatabaseJournal::AppendRenumberLocked(const std::vector<TUint32>& aIds)
+{
+    for (TUint index=0; index<aIds.size(); ) {
+        TUint count = (TUint)aIds.size() - index;
+        if (count > kMaxRenumberIds) {
+            count = kMaxRenumberIds;
+        }
+        (void)PrepareRecordLocked(7 + 4 * count);
+        iPending.Append(kRecordRenumber);
+        AppendUint32(iPending, index);
+        AppendUint16(iPending, count);
+        for (TUint i=0; i<count; i++) {
+            AppendUint32(iPending, aIds[index++]);
+        }
+    }
+}
+
+void TrackDatabaseJournal::Replay(const Brx& aChunk, TrackList<RestoreEntry>& aList, std::vector<RestoreEntry*>& aEntries, std::vector<TUint32>& aRenumber)
+{
+    /* Journal records from just before a snapshot was taken may also be reflected in that
+       snapshot.  Inserting an id that is already present and deleting one that isn't are
+       therefore ignored.  Ids are only ever reused across a renumber run so this always converges
+       on the playlist as it was when the last record was written. */
+    TUint offset = 0;
+    while (offset < aChunk.Bytes()) {
+        const TUint bytes = RecordBytes(aChunk, offset);
+        if (bytes == 0) {
+            LOG(kError, "TrackDatabaseJournal: corrupt record at offset %u\n", offset);
+            return;
+        }
+        const TByte* ptr = aChunk.Ptr() + offset;
+        switch (ptr[0])
+        {
+        case kRecordInsert:
+        {
+            const TUint id = ReadUint32(ptr + 1);
+            if (aList.Find(id) == nullptr) {
+                const TUint idAfter = ReadUint32(ptr + 5);
+                const TUint uriBytes = ReadUint16(ptr + 9);
+                const Brn uri(ptr + 11, uriBytes);
+                const Brn metaData(ptr + 13 + uriBytes, ReadUint16(ptr + 11 + uriBytes));
+                TUint index = 0;
+                if (idAfter != ITrackDatabase::kTrackIdNone) {
+                    index = (aList.TryGetIndex(idAfter, index)? index + 1 : aList.Count());
+                }
+                RestoreEntry* entry = new RestoreEntry(id, uri, metaData);
+                aEntries.push_back(entry);
+                aList.Insert(index, *entry);
+            }
+            break;
+        }
+        case kRecordDelete:
+            (void)aList.Remove(ReadUint32(ptr + 1));
+            break;
+        case kRecordClear:
+            aList.Clear();
+            break;
+        case kRecordRenumber:
+        {
+            const TUint index = ReadUint32(ptr + 1);
+            const TUint count = ReadUint16(ptr + 5);
+            if (index == 0) {
+                aRenumber.clear();
+            }
+            if (index != aRenumber.size() || index + count > aList.Count()) {
+                LOG(kError, "TrackDatabaseJournal: ignoring out of sequence renumber record\n");
+                aRenumber.clear();
+                break;
+            }
+            for (TUint i=0; i<count; i++) {
+                aRenumber.push_back(ReadUint32(ptr + 7 + 4*i));
+            }
+            if (aRenumber.size() == aList.Count()) {
+                std::vector<RestoreEntry*> items;
+                aList.CopyItems(items);
+                for (TUint i=0; i<items.size(); i++) {
+                    items[i]->iId = aRenumber[i];
+                }
+                aList.Assign(items);
+                aRenumber.clear();
+            }
+            break;
+        }
+        }
+        offset += bytes;
+    }
+}
+
+void TrackDatabaseJournal::Compact()
+{
+    FlushJournal();
+    const TUint slot = iSlot ^ 1;
+    DeleteJournal(slot); // in case an earlier compaction was interrupted
+
+    iLock.Wait();
+    // Edits from here on are journalled against the new snapshot.  Some may also be reflected
+    // in it; Replay() copes with this.
+    iRecording = true;
+    iLock.Signal();
+
+    std::vector<TUint32> ids;
+    TUint seq;
+    iDatabase.GetIdArray(ids, seq);
+    Bwh chunk(kChunkBytes);
+    Bws<kMaxKeyBytes> key;
+    TUint chunks = 0;
+    TUint idAfter = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<ids.size(); i++) {
+        Track* track;
+        try {
+            iDatabase.GetTrackById(ids[i], track);
+        }
+        catch (TrackDbIdNotFound&) {
+            continue; // deleted since ids was read; the new journal records this
+        }
+        AutoAllocatedRef a(track);
+        if (chunk.Bytes() + InsertBytes(track->Uri(), track->MetaData()) > chunk.MaxBytes()) {
+            ChunkKey(key, slot, 'S', chunks++);
+            iStore.Write(key, chunk);
+            chunk.SetBytes(0);
+        }
+        AppendInsert(chunk, track->Id(), idAfter, track->Uri(), track->MetaData());
+        idAfter = track->Id();
+    }
+    if (chunk.Bytes() > 0) {
+        ChunkKey(key, slot, 'S', chunks++);
+        iStore.Write(key, chunk);
+    }
+
+    Bws<12> header;
+    AppendUint32(header, kVersion);
+    AppendUint32(header, slot);
+    AppendUint32(header, chunks);
+    iStore.Write(iKeyHeader, header);
+    LOG(kSources, "TrackDatabaseJournal: compacted %u tracks into %u chunks\n", (TUint)ids.size(), chunks);
+
+    for (TUint i=0; i<iSnapshotChunks; i++) {
+        ChunkKey(key, iSlot, 'S', i);
+        try {
+            iStore.Delete(key);
+        }
+        catch (StoreKeyNotFound&) {}
+    }
+    DeleteJournal(iSlot);
+    iSlot = slot;
+    iSnapshotChunks = chunks;
+    iJournalChunks = 0;
+    iTail.SetBytes(0);
+}
+
+void TrackDatabaseJournal::FlushJournal()
+{
+    {
+        AutoMutex _(iLock);
+        if (iPending.Bytes() == 0) {
+            return;
+        }
+        if (iPending.Bytes() > iWriting.MaxBytes()) {
+            iWriting.Grow(iPending.MaxBytes());
+        }
+        iWriting.Replace(iPending);
+        iPending.SetBytes(0);
+    }
+
+    /* The journal is append only.  Records fill the last chunk, which is rewritten each time
+       it grows; once full, a new chunk is started. */
+    Bws<kMaxKeyBytes> key;
+    TUint offset = 0;
+    while (offset < iWriting.Bytes()) {
+        const TUint bytes = RecordBytes(iWriting, offset);
+        ASSERT(bytes > 0);
+        if (iTail.Bytes() + bytes > iTail.MaxBytes()) {
+            ChunkKey(key, iSlot, 'J', iJournalChunks++);
+            iStore.Write(key, iTail);
+            iTail.SetBytes(0);
+        }
+        iTail.Append(iWriting.Ptr() + offset, bytes);
+        offset += bytes;
+    }
+    ChunkKey(key, iSlot, 'J', iJournalChunks);
+    iStore.Write(key, iTail);
+}
+
+void TrackDatabaseJournal::DeleteJournal(TUint aSlot)
+{
+    Bws<kMaxKeyBytes> key;
+    for (TUint i=0; ; i++) {
+        ChunkKey(key, aSlot, 'J', i);
+        try {
+            iStore.Delete(key);
+        }
+        catch (StoreKeyNotFound&) {
+            break;
+        }
+    }
+}
+
+void TrackDatabaseJournal::ChunkKey(Bwx& aKey, TUint aSlot, TChar aType, TUint aIndex) const
+{
+    aKey.Replace(iKeyPrefix);
+    aKey.Append('.');
+    Ascii::AppendDec(aKey, aSlot);
+    aKey.Append('.');
+    aKey.Append(aType);
+    Ascii::AppendDec(aKey, aIndex);
+}
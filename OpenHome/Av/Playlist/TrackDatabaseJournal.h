@@ -0,0 +1,98 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Av/Playlist/TrackDatabase.h>
+
+#include <vector>
+
+namespace OpenHome {
+namespace Configuration {
+    class IStoreReadWrite;
+}
+namespace Av {
+
+/*
+ * Persists the contents of a TrackDatabase so that a playlist survives a reboot.
+ *
+ * Edits are encoded as they are reported to ITrackDatabaseObserver and appended to a journal
+ * held in aStore as a series of chunks.  Records are batched, being written at most once every
+ * kFlushDelayMs.  Once the journal grows larger than the snapshot it follows, the database is
+ * compacted into a new snapshot.  All store access (including the initial restore) happens on a
+ * low priority thread so neither UPnP actions nor startup wait for the store.
+ *
+ * Restored tracks are given new ids.  Rather than rewriting the snapshot, the journal records
+ * the new ids so a restore normally costs only a few extra journal bytes.
+ *
+ * Stored data alternates between two slots.  A new snapshot is only used once a header naming
+ * its slot has been written so a power cut part way through compaction leaves the previous
+ * snapshot and journal intact.
+ */
+class TrackDatabaseJournal : private ITrackDatabaseObserver, private INonCopyable
+{
+    static const TUint kVersion = 1;
+    static const TUint kChunkBytes = 32 * 1024;
+    static const TUint kCompactMinChunks = 8;
+    static const TUint kMaxKeyBytes = 64;
+    static const TUint kFlushDelayMs = 1000;
+    static const TUint kMaxRenumberIds = 1024; // per record
+    static const TByte kRecordInsert   = 1;
+    static const TByte kRecordDelete   = 2;
+    static const TByte kRecordClear    = 3;
+    static const TByte kRecordRenumber = 4;
+public:
+    TrackDatabaseJournal(Configuration::IStoreReadWrite& aStore, ITrackDatabase& aDatabase, const Brx& aKeyPrefix);
+    ~TrackDatabaseJournal();
+    void Start(); // restores any stored playlist in the background then starts recording changes.  Call once the pipeline has started.
+    void Flush(); // blocks until restore is complete and all changes reported so far are in aStore
+private: // from ITrackDatabaseObserver
+    void NotifyTrackInserted(Media::Track& aTrack, TUint aIdBefore, TUint aIdAfter) override;
+    void NotifyTrackDeleted(TUint aId, Media::Track* aBefore, Media::Track* aAfter) override;
+    void NotifyAllDeleted() override;
+private:
+    class RestoreEntry
+    {
+    public:
+        RestoreEntry(TUint aId, const Brx& aUri, const Brx& aMetaData);
+        TUint Id() const;
+    public:
+        TUint iId;
+        Brn iUri;
+        Brn iMetaData;
+    };
+private:
+    static TUint InsertBytes(const Brx& aUri, const Brx& aMetaData);
+    static void AppendInsert(Bwx& aBuf, TUint aId, TUint aIdAfter, const Brx& aUri, const Brx& aMetaData);
+    static TUint RecordBytes(const Brx& aBuf, TUint aOffset); // 0 => incomplete/invalid record
+    TBool PrepareRecordLocked(TUint aBytes);
+    void Run();
+    TBool Restore(); // true if the stored playlist was restored intact and its journal can be extended
+    void Replay(const Brx& aChunk, TrackList<RestoreEntry>& aList, std::vector<RestoreEntry*>& aEntries, std::vector<TUint32>& aRenumber);
+    void AppendRenumberLocked(const std::vector<TUint32>& aIds);
+    void Compact();
+    void FlushJournal();
+    void DeleteJournal(TUint aSlot);
+    void ChunkKey(Bwx& aKey, TUint aSlot, TChar aType, TUint aIndex) const;
+private:
+    Configuration::IStoreReadWrite& iStore;
+    ITrackDatabase& iDatabase;
+    Mutex iLock;
+    Semaphore iSemFlushed;
+    Semaphore iSemFlushNow;
+    const Bws<kMaxKeyBytes> iKeyPrefix;
+    Bws<kMaxKeyBytes> iKeyHeader;
+    ThreadFunctor* iThread;
+    Bwh iPending;       // records reported since the journal was last written
+    Bwh iWriting;       // records being written; only accessed by iThread
+    Bwh iTail;          // most recent (partially filled) journal chunk; only accessed by iThread
+    TBool iRecording;
+    TUint iFlushWaiters;
+    TUint iSlot;
+    TUint iSnapshotChunks;
+    TUint iJournalChunks;
+};
+
+} // namespace Av
+} // namespace OpenHome
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace OpenHome {
+namespace Av {
+
+/*
+ * Ordered list of items, each identified by a unique Id(), that stays fast for playlists of
+ * 100k+ entries.
+ *
+ * Items are held in a treap keyed implicitly by position (each node records the size of its
+ * subtree) alongside a hash map from id to node.  Looking an item up by id is O(1); finding
+ * its position, fetching the item at a position, inserting and removing are O(log n).
+ * Walking the list in order from any position costs O(1) per item (amortised).
+ *
+ * Node priorities come from a fixed-seed generator so a given sequence of operations always
+ * produces the same tree shape.
+ *
+ * Items are not owned or reference counted.
+ * Not thread safe; callers are expected to serialise access.
+ */
+template <class T>
+class TrackList : private INonCopyable
+{
+public:
+    TrackList();
+    ~TrackList();
+    TUint Count() const;
+    T* Find(TUint aId) const;                     // nullptr if aId isn't held
+    TBool TryGetIndex(TUint aId, TUint& aIndex) const;
+    T* At(TUint aIndex) const;                    // nullptr if aIndex >= Count()
+    void Insert(TUint aIndex, T& aItem);          // aIndex <= Count(); item must not already be held
+    T* Remove(TUint aId);                         // nullptr if aId isn't held
+    void Clear();
+    void Assign(const std::vector<T*>& aItems); // replaces the contents with aItems (in order) in O(n)
+    /*
+     * Resizes aIds to Count() and writes the ids of items at aFrom onwards.  Entries before
+     * aFrom are left untouched so a caller that knows only the tail of the list has changed
+     * can refresh an earlier snapshot cheaply.
+     */
+    void CopyIds(std::vector<TUint32>& aIds, TUint aFrom) const;
+    void CopyItems(std::vector<T*>& aItems) const;
+private:
+    class Node
+    {
+    public:
+        Node(T& aItem, TUint aPriority);
+    public:
+        T* iItem;
+        Node* iLeft;
+        Node* iRight;
+        Node* iParent;
+        TUint iSize;
+        TUint iPriority;
+    };
+private:
+    static TUint Size(const Node* aNode);
+    static void Update(Node* aNode);
+    static void Split(Node* aNode, TUint aCount, Node*& aLeft, Node*& aRight);
+    static Node* Merge(Node* aLeft, Node* aRight);
+    static void UpdateSubtree(Node* aNode);
+    static TUint Rank(const Node* aNode);
+    static const Node* Successor(const Node* aNode);
+    const Node* NodeAt(TUint aIndex) const;
+    TUint NextPriority();
+private:
+    std::unordered_map<TUint, Node*> iMap;
+    Node* iRoot;
+    TUint iRandom;
+};
+
+// TrackList::Node
+
+template <class T>
+TrackList<T>::Node::Node(T& aItem, TUint aPriority)
+    : iItem(&aItem)
+    , iLeft(nullptr)
+    , iRight(nullptr)
+    , iParent(nullptr)
+    , iSize(1)
+    , iPriority(aPriority)
+{
+}
+
+// TrackList
+
+template <class T>
+TrackList<T>::TrackList()
+    : iRoot(nullptr)
+    , iRandom(0x9e3779b9)
+{
+}
+
+template <class T>
+TrackList<T>::~TrackList()
+{
+    Clear();
+}
+
+template <class T>
+TUint TrackList<T>::Count() const
+{
+    return Size(iRoot);
+}
+
+template <class T>
+T* TrackList<T>::Find(TUint aId) const
+{
+    auto it = iMap.find(aId);
+    if (it == iMap.end()) {
+        return nullptr;
+    }
+    return it->second->iItem;
+}
+
+template <class T>
+TBool TrackList<T>::TryGetIndex(TUint aId, TUint& aIndex) const
+{
+    auto it = iMap.find(aId);
+    if (it == iMap.end()) {
+        return false;
+    }
+    aIndex = Rank(it->second);
+    return true;
+}
+
+template <class T>
+T* TrackList<T>::At(TUint aIndex) const
+{
+    const Node* node = NodeAt(aIndex);
+    return (node == nullptr? nullptr : node->iItem);
+}
+
+template <class T>
+void TrackList<T>::Insert(TUint aIndex, T& aItem)
+{
+    ASSERT(aIndex <= Count());
+    Node* node = new Node(aItem, NextPriority());
+    const TBool added = iMap.insert(std::make_pair(aItem.Id(), node)).second;
+    ASSERT(added);
+    Node* left;
+    Node* right;
+    Split(iRoot, aIndex, left, right);
+    iRoot = Merge(Merge(left, node), right);
+    iRoot->iParent = nullptr;
+}
+
+template <class T>
+T* TrackList<T>::Remove(TUint aId)
+{
+    auto it = iMap.find(aId);
+    if (it == iMap.end()) {
+        return nullptr;
+    }
+    Node* node = it->second;
+    iMap.erase(it);
+    Node* left;
+    Node* mid;
+    Node* right;
+    Split(iRoot, Rank(node), left, right);
+    Split(right, 1, mid, right);
+    ASSERT(mid == node);
+    iRoot = Merge(left, right);
+    if (iRoot != nullptr) {
+        iRoot->iParent = nullptr;
+    }
+    T* item = node->iItem;
+    delete node;
+    return item;
+}
+
+template <class T>
+void TrackList<T>::Clear()
+{
+    for (auto it=iMap.begin(); it!=iMap.end(); ++it) {
+        delete it->second;
+    }
+    iMap.clear();
+    iRoot = nullptr;
+}
+
+template <class T>
+void TrackList<T>::Assign(const std::vector<T*>& aItems)
+{
+    /* Builds the tree directly rather than inserting items one at a time.  Each new node is
+       attached to the right spine of the tree built so far, adopting as its left subtree any
+       nodes on that spine with lower priority. */
+    Clear();
+    std::vector<Node*> spine;
+    for (auto item : aItems) {
+        Node* node = new Node(*item, NextPriority());
+        const TBool added = iMap.insert(std::make_pair(item->Id(), node)).second;
+        ASSERT(added);
+        Node* left = nullptr;
+        while (spine.size() > 0 && spine.back()->iPriority <= node->iPriority) {
+            left = spine.back();
+            spine.pop_back();
+        }
+        node->iLeft = left;
+        if (spine.size() > 0) {
+            spine.back()->iRight = node;
+        }
+        spine.push_back(node);
+    }
+    if (spine.size() > 0) {
+        iRoot = spine[0];
+        UpdateSubtree(iRoot);
+        iRoot->iParent = nullptr;
+    }
+}
+
+template <class T>
+void TrackList<T>::CopyIds(std::vector<TUint32>& aIds, TUint aFrom) const
+{
+    const TUint count = Count();
+    aIds.resize(count);
+    TUint i = aFrom;
+    for (const Node* node = NodeAt(aFrom); node != nullptr; node = Successor(node)) {
+        aIds[i++] = node->iItem->Id();
+    }
+}
+
+template <class T>
+void TrackList<T>::CopyItems(std::vector<T*>& aItems) const
+{
+    aItems.clear();
+    aItems.reserve(Count());
+    for (const Node* node = NodeAt(0); node != nullptr; node = Successor(node)) {
+        aItems.push_back(node->iItem);
+    }
+}
+
+template <class T>
+TUint TrackList<T>::Size(const Node* aNode)
+{ // static
+    return (aNode == nullptr? 0 : aNode->iSize);
+}
+
+template <class T>
+void TrackList<T>::Update(Node* aNode)
+{ // static
+    aNode->iSize = 1 + Size(aNode->iLeft) + Size(aNode->iRight);
+    if (aNode->iLeft != nullptr) {
+        aNode->iLeft->iParent = aNode;
+    }
+    if (aNode->iRight != nullptr) {
+        aNode->iRight->iParent = aNode;
+    }
+}
+
+template <class T>
+void TrackList<T>::Split(Node* aNode, TUint aCount, Node*& aLeft, Node*& aRight)
+{ // static
+    // aLeft receives the first aCount nodes from aNode's subtree, aRight the remainder
+    if (aNode == nullptr) {
+        aLeft = aRight = nullptr;
+        return;
+    }
+    const TUint leftSize = Size(aNode->iLeft);
+    if (aCount <= leftSize) {
+        Split(aNode->iLeft, aCount, aLeft, aNode->iLeft);
+        aRight = aNode;
+        if (aLeft != nullptr) {
+            aLeft->iParent = nullptr;
+        }
+    }
+    else {
+        Split(aNode->iRight, aCount - leftSize - 1, aNode->iRight, aRight);
+        aLeft = aNode;
+        if (aRight != nullptr) {
+            aRight->iParent = nullptr;
+        }
+    }
+    Update(aNode);
+}
+
+template <class T>
+typename TrackList<T>::Node* TrackList<T>::Merge(Node* aLeft, Node* aRight)
+{ // static
+    if (aLeft == nullptr) {
+        return aRight;
+    }
+    if (aRight == nullptr) {
+        return aLeft;
+    }
+    if (aLeft->iPriority > aRight->iPriority) {
+        aLeft->iRight = Merge(aLeft->iRight, aRight);
+        Update(aLeft);
+        return aLeft;
+    }
+    aRight->iLeft = Merge(aLeft, aRight->iLeft);
+    Update(aRight);
+    return aRight;
+}
+
+template <class T>
+void TrackList<T>::UpdateSubtree(Node* aNode)
+{ // static
+    if (aNode != nullptr) {
+        UpdateSubtree(aNode->iLeft);
+        UpdateSubtree(aNode->iRight);
+        Update(aNode);
+    }
+}
+
+template <class T>
+TUint TrackList<T>::Rank(const Node* aNode)
+{ // static
+    TUint rank = Size(aNode->iLeft);
+    for (const Node* parent = aNode->iParent; parent != nullptr; aNode = parent, parent = parent->iParent) {
+        if (parent->iRight == aNode) {
+            rank += Size(parent->iLeft) + 1;
+        }
+    }
+    return rank;
+}
+
+template <class T>
+const typename TrackList<T>::Node* TrackList<T>::Successor(const Node* aNode)
+{ // static
+    if (aNode->iRight != nullptr) {
+        aNode = aNode->iRight;
+        while (aNode->iLeft != nullptr) {
+            aNode = aNode->iLeft;
+        }
+        return aNode;
+    }
+    const Node* parent = aNode->iParent;
+    while (parent != nullptr && parent->iRight == aNode) {
+        aNode = parent;
+        parent = parent->iParent;
+    }
+    return parent;
+}
+
+template <class T>
+const typename TrackList<T>::Node* TrackList<T>::NodeAt(TUint aIndex) const
+{
+    if (aIndex >= Count()) {
+        return nullptr;
+    }
+    const Node* node = iRoot;
+    for (;;) {
+        const TUint leftSize = Size(node->iLeft);
+        if (aIndex < leftSize) {
+            node = node->iLeft;
+        }
+        else if (aIndex == leftSize) {
+            return node;
+        }
+        else {
+            aIndex -= leftSize + 1;
+            node = node->iRight;
+        }
+    }
+}
+
+template <class T>
+TUint TrackList<T>::NextPriority()
+{ // xorshift32
+    iRandom ^= iRandom << 13;
+    iRandom ^= iRandom >> 17;
+    iRandom ^= iRandom << 5;
+    return iRandom;
+}
+
+} // namespace Av
+} // namespace OpenHome
@@ -9,6 +9,7 @@
 #include <OpenHome/Media/PipelineManager.h>
 #include <OpenHome/Av/Playlist/TrackDatabase.h>
 #include <OpenHome/Media/Pipeline/TrackInspector.h>
+#include <OpenHome/Av/TrackLookAhead.h>
 
 using namespace OpenHome;
 using namespace OpenHome::Av;
@@ -19,18 +20,21 @@ using namespace OpenHome::Media;
 const Brn UriProviderPlaylist::kCommandId("id");
 const Brn UriProviderPlaylist::kCommandIndex("index");
 
-UriProviderPlaylist::UriProviderPlaylist(ITrackDatabaseReader& aDatabase, PipelineManager& aPipeline, ITrackDatabaseObserver& aObserver)
+UriProviderPlaylist::UriProviderPlaylist(ITrackDatabaseReader& aDatabase, PipelineManager& aPipeline,
+                                         ITrackDatabaseObserver& aObserver, ITrackLookAheadObserver& aLookAheadObserver)
     : UriProvider("Playlist", Latency::NotSupported, Next::Supported, Prev::Supported)
     , iLock("UPPL")
     , iDatabase(aDatabase)
     , iIdManager(aPipeline)
     , iObserver(aObserver)
+    , iLookAheadObserver(aLookAheadObserver)
     , iPending(nullptr)
     , iLastTrackId(ITrackDatabase::kTrackIdNone)
     , iPlayingTrackId(ITrackDatabase::kTrackIdNone)
     , iFirstFailedTrackId(ITrackDatabase::kTrackIdNone)
     , iActive(false)
 {
+    iUpcomingTracks.reserve(kLookAheadTracks);
     aPipeline.AddObserver(static_cast<IPipelineObserver&>(*this));
     iDatabase.SetObserver(*this);
     aPipeline.AddObserver(static_cast<ITrackObserver&>(*this));
@@ -69,7 +73,7 @@ void UriProviderPlaylist::BeginLater(TUint aTrackId)
 EStreamPlay UriProviderPlaylist::GetNext(Media::Track*& aTrack)
 {
     EStreamPlay canPlay = ePlayYes;
-    AutoMutex a(iLock);
+    iLock.Wait();
     const TUint prevLastTrackId = iLastTrackId;
     if (iPending != nullptr) {
         aTrack = iPending;
@@ -95,6 +99,12 @@ EStreamPlay UriProviderPlaylist::GetNext(Media::Track*& aTrack)
         }
         canPlay = ePlayNo;
     }
+    const TUint lastTrackId = iLastTrackId;
+    iLock.Signal();
+
+    if (aTrack != nullptr) {
+        ReportUpcomingTracks(lastTrackId);
+    }
     return canPlay;
 }
 
@@ -230,6 +240,33 @@ Track* UriProviderPlaylist::ProcessCommandIndex(const Brx& aCommand)
     return track;
 }
 
+void UriProviderPlaylist::ReportUpcomingTracks(TUint aTrackId)
+{
+    /* Only called from GetNext so runs in the Filler thread.
+       Repeater/Shuffler decide the order so this matches what future calls to GetNext will return
+       (unless the playlist is modified, the user skips or a shuffled list is reshuffled).
+       Peek rather than NextTrackRef so that looking ahead doesn't advance the shuffled order. */
+    TUint id = aTrackId;
+    for (TUint i=0; i<kLookAheadTracks; i++) {
+        Track* track = iDatabase.PeekNextTrackRef(id);
+        if (track == nullptr || track->Id() == aTrackId) {
+            if (track != nullptr) {
+                track->RemoveRef();
+            }
+            break;
+        }
+        iUpcomingTracks.push_back(track);
+        id = track->Id();
+    }
+    if (iUpcomingTracks.size() > 0) {
+        iLookAheadObserver.NotifyUpcomingTracks(iUpcomingTracks);
+        for (auto it=iUpcomingTracks.begin(); it!=iUpcomingTracks.end(); ++it) {
+            (*it)->RemoveRef();
+        }
+        iUpcomingTracks.clear();
+    }
+}
+
 void UriProviderPlaylist::NotifyTrackInserted(Track& aTrack, TUint aIdBefore, TUint aIdAfter)
 {
     {
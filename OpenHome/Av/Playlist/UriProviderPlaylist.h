@@ -19,12 +19,16 @@ namespace Media {
 }
 namespace Av {
 
+class ITrackLookAheadObserver;
+
 class UriProviderPlaylist : public Media::UriProvider, private ITrackDatabaseObserver, private Media::IPipelineObserver, private Media::ITrackObserver
 {
     static const Brn kCommandId;
     static const Brn kCommandIndex;
+    static const TUint kLookAheadTracks = 3;
 public:
-    UriProviderPlaylist(ITrackDatabaseReader& aDatabase, Media::PipelineManager& aPipeline, ITrackDatabaseObserver& aObserver);
+    UriProviderPlaylist(ITrackDatabaseReader& aDatabase, Media::PipelineManager& aPipeline,
+                        ITrackDatabaseObserver& aObserver, ITrackLookAheadObserver& aLookAheadObserver);
     ~UriProviderPlaylist();
     void SetActive(TBool aActive);
 public: // from UriProvider
@@ -56,6 +60,7 @@ private:
     TUint ParseCommand(const Brx& aCommand) const;
     Media::Track* ProcessCommandId(const Brx& aCommand);
     Media::Track* ProcessCommandIndex(const Brx& aCommand);
+    void ReportUpcomingTracks(TUint aTrackId);
 private:
     enum EPendingDirection
     {
@@ -68,6 +73,8 @@ private:
     ITrackDatabaseReader& iDatabase;
     Media::IPipelineIdManager& iIdManager;
     ITrackDatabaseObserver& iObserver;
+    ITrackLookAheadObserver& iLookAheadObserver;
+    std::vector<Media::Track*> iUpcomingTracks;
     Media::Track* iPending;
     Media::EStreamPlay iPendingCanPlay;
     EPendingDirection iPendingDirection;
@@ -119,6 +119,9 @@ void Product::Start()
     // All sources must have been registered; construct startup source config val.
     iConfigStartupSource = &iConfigReader.GetText(ConfigStartupSource::kKeySource);
     iListenerIdStartupSource = iConfigStartupSource->Subscribe(MakeFunctorConfigText(*this, &Product::StartupSourceChanged));
+    for (auto it=iSources.begin(); it!=iSources.end(); ++it) {
+        (*it)->ProductStarted();
+    }
 
     iLock.Wait();
     const Bws<ISource::kMaxSystemNameBytes> startupSourceVal(iStartupSourceVal);
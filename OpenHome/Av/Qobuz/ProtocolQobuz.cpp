@@ -12,6 +12,8 @@
 #include <OpenHome/Private/Parser.h>
 #include <OpenHome/Private/Ascii.h>
 #include <OpenHome/Av/Qobuz/Qobuz.h>
+#include <OpenHome/Av/TrackLookAhead.h>
+#include <OpenHome/Av/Utils/StreamUrlCache.h>
 #include <OpenHome/Media/SupplyAggregator.h>
 
 namespace OpenHome {
@@ -24,7 +26,7 @@ class ProtocolQobuz : public Media::ProtocolNetwork, private IReader
 public:
     ProtocolQobuz(Environment& aEnv, const Brx& aAppId, const Brx& aAppSecret,
                   Credentials& aCredentialsManager, Configuration::IConfigInitialiser& aConfigInitialiser,
-                  IUnixTimestamp& aUnixTimestamp);
+                  IUnixTimestamp& aUnixTimestamp, ITrackLookAhead& aTrackLookAhead);
     ~ProtocolQobuz();
 private: // from Media::Protocol
     void Initialise(Media::MsgFactory& aMsgFactory, Media::IPipelineElementDownstream& aDownstream) override;
@@ -41,7 +43,7 @@ private: // from IProtocolReader
     void ReadFlush() override;
     void ReadInterrupt() override;
 private:
-    static TBool TryGetTrackId(const Brx& aQuery, Bwx& aTrackId);
+    TBool TryGetStreamUrl(const Brx& aTrackUri);
     Media::ProtocolStreamResult DoStream();
     Media::ProtocolStreamResult DoSeek(TUint64 aOffset);
     TUint WriteRequest(TUint64 aOffset);
@@ -52,7 +54,7 @@ private:
     Qobuz* iQobuz;
     Media::SupplyAggregator* iSupply;
     Uri iUri;
-    Bws<12> iTrackId;
+    Bws<Qobuz::kMaxTrackIdBytes> iTrackId;
     Bws<1024> iStreamUrl;
     Bws<64> iSessionId;
     WriterHttpRequest iWriterRequest;
@@ -87,7 +89,7 @@ Protocol* ProtocolFactory::NewQobuz(const Brx& aAppId, const Brx& aAppSecret, Av
 { // static
     return new ProtocolQobuz(aMediaPlayer.Env(), aAppId, aAppSecret,
                              aMediaPlayer.CredentialsManager(), aMediaPlayer.ConfigInitialiser(),
-                             aMediaPlayer.UnixTimestamp());
+                             aMediaPlayer.UnixTimestamp(), aMediaPlayer.TrackLookAhead());
 }
 
 
@@ -95,8 +97,8 @@ Protocol* ProtocolFactory::NewQobuz(const Brx& aAppId, const Brx& aAppSecret, Av
 
 ProtocolQobuz::ProtocolQobuz(Environment& aEnv, const Brx& aAppId, const Brx& aAppSecret,
                              Credentials& aCredentialsManager, IConfigInitialiser& aConfigInitialiser,
-                             IUnixTimestamp& aUnixTimestamp)
-    : ProtocolNetwork(aEnv)
+                             IUnixTimestamp& aUnixTimestamp, ITrackLookAhead& aTrackLookAhead)
+    : ProtocolNetwork(aEnv, "qobuz")
     , iSupply(nullptr)
     , iWriterRequest(iWriterBuf)
     , iReaderUntil(iReaderBuf)
@@ -111,6 +113,7 @@ ProtocolQobuz::ProtocolQobuz(Environment& aEnv, const Brx& aAppId, const Brx& aA
 
     iQobuz = new Qobuz(aEnv, aAppId, aAppSecret, aCredentialsManager, aConfigInitialiser, aUnixTimestamp);
     aCredentialsManager.Add(iQobuz);
+    aTrackLookAhead.AddObserver(iQobuz->StreamUrls());
 }
 
 ProtocolQobuz::~ProtocolQobuz()
@@ -151,21 +154,29 @@ ProtocolStreamResult ProtocolQobuz::Stream(const Brx& aUri)
         return EProtocolErrorNotSupported;
     }
     LOG(kMedia, "ProtocolQobuz::Stream(%.*s)\n", PBUF(aUri));
-    if (!TryGetTrackId(iUri.Query(), iTrackId)) {
+    if (!Qobuz::TryGetTrackId(iUri.Query(), iTrackId)) {
         return EProtocolStreamErrorUnrecoverable;
     }
 
     ProtocolStreamResult res = EProtocolStreamErrorUnrecoverable;
-    if (!iQobuz->TryGetStreamUrl(iTrackId, iStreamUrl)) {
-        // any error might be due to our session having expired
-        // attempt login, getStreamUrl to see if that fixes things
-        if (!iQobuz->TryLogin() || !iQobuz->TryGetStreamUrl(iTrackId, iStreamUrl)) {
-            return EProtocolStreamErrorUnrecoverable;
-        }
+    StreamUrlCache& cache = iQobuz->StreamUrls();
+    const TBool cached = cache.TryGet(aUri, iStreamUrl);
+    if (!cached && !TryGetStreamUrl(aUri)) {
+        return EProtocolStreamErrorUnrecoverable;
     }
     iUri.Replace(iStreamUrl);
 
     res = DoStream();
+    if (res == EProtocolStreamErrorUnrecoverable && cached && !iStarted && !iStopped) {
+        // cached url may have been revoked early by the service; fall back to requesting a new one
+        LOG(kMedia, "ProtocolQobuz - cached url failed, re-requesting\n");
+        cache.Remove(aUri);
+        if (!TryGetStreamUrl(aUri)) {
+            return EProtocolStreamErrorUnrecoverable;
+        }
+        iUri.Replace(iStreamUrl);
+        res = DoStream();
+    }
     if (res == EProtocolStreamErrorUnrecoverable) {
         return res;
     }
@@ -289,37 +300,16 @@ void ProtocolQobuz::ReadInterrupt()
     iDechunker.ReadInterrupt();
 }
 
-TBool ProtocolQobuz::TryGetTrackId(const Brx& aQuery, Bwx& aTrackId)
-{ // static
-    Parser parser(aQuery);
-    (void)parser.Next('?');
-    Brn buf = parser.Next('=');
-    if (buf != Brn("version")) {
-        LOG2(kPipeline, kError, "TryGetTrackId failed - no version\n");
-        return false;
-    }
-    Brn verBuf = parser.Next('&');
-    try {
-        const TUint ver = Ascii::Uint(verBuf);
-        if (ver != 2) {
-            LOG2(kPipeline, kError, "TryGetTrackId failed - unsupported version - %d\n", ver);
+TBool ProtocolQobuz::TryGetStreamUrl(const Brx& aTrackUri)
+{
+    if (!iQobuz->TryGetStreamUrl(iTrackId, iStreamUrl)) {
+        // any error might be due to our session having expired
+        // attempt login, getStreamUrl to see if that fixes things
+        if (!iQobuz->TryLogin() || !iQobuz->TryGetStreamUrl(iTrackId, iStreamUrl)) {
             return false;
         }
     }
-    catch (AsciiError&) {
-        LOG2(kPipeline, kError, "TryGetTrackId failed - invalid version\n");
-        return false;
-    }
-    buf.Set(parser.Next('='));
-    if (buf != Brn("trackId")) {
-        LOG2(kPipeline, kError, "TryGetTrackId failed - no track id tag\n");
-        return false;
-    }
-    aTrackId.Replace(parser.Remaining());
-    if (aTrackId.Bytes() == 0) {
-        LOG2(kPipeline, kError, "TryGetTrackId failed - no track id value\n");
-        return false;
-    }
+    iQobuz->StreamUrls().Add(aTrackUri, iStreamUrl);
     return true;
 }
 
@@ -14,6 +14,8 @@
 #include <OpenHome/Media/Debug.h>
 #include <OpenHome/Private/md5.h>
 #include <OpenHome/Json.h>
+#include <OpenHome/Private/Parser.h>
+#include <OpenHome/Av/Utils/StreamUrlCache.h>
 
 #include <algorithm>
 #include <vector>
@@ -30,6 +32,25 @@ const Brn Qobuz::kConfigKeySoundQuality("qobuz.com.SoundQuality");
 
 static const TUint kQualityValues[] ={ 5, 6, 7, 27 };
 
+
+// Qobuz::Connection
+
+Qobuz::Connection::Connection(Environment& aEnv)
+    : iReaderBuf(iSocket)
+    , iReaderUntil1(iReaderBuf)
+    , iWriterBuf(iSocket)
+    , iWriterRequest(iWriterBuf)
+    , iReaderResponse(aEnv, iReaderUntil1)
+    , iDechunker(iReaderUntil1)
+    , iReaderUntil2(iDechunker)
+{
+    iReaderResponse.AddHeader(iHeaderContentLength);
+    iReaderResponse.AddHeader(iHeaderTransferEncoding);
+}
+
+
+// Qobuz
+
 Qobuz::Qobuz(Environment& aEnv, const Brx& aAppId, const Brx& aAppSecret,
              ICredentialsState& aCredentialsState, IConfigInitialiser& aConfigInitialiser,
              IUnixTimestamp& aUnixTimestamp)
@@ -38,21 +59,14 @@ Qobuz::Qobuz(Environment& aEnv, const Brx& aAppId, const Brx& aAppSecret,
     , iLockConfig("QBZ2")
     , iCredentialsState(aCredentialsState)
     , iUnixTimestamp(aUnixTimestamp)
-    , iReaderBuf(iSocket)
-    , iReaderUntil1(iReaderBuf)
-    , iWriterBuf(iSocket)
-    , iWriterRequest(iWriterBuf)
-    , iReaderResponse(aEnv, iReaderUntil1)
-    , iDechunker(iReaderUntil1)
-    , iReaderUntil2(iDechunker)
+    , iConnection(aEnv)
     , iAppId(aAppId)
     , iAppSecret(aAppSecret)
     , iUsername(kGranularityUsername)
     , iPassword(kGranularityPassword)
+    , iLockLookAhead("QBZ3")
+    , iConnectionLookAhead(aEnv)
 {
-    iReaderResponse.AddHeader(iHeaderContentLength);
-    iReaderResponse.AddHeader(iHeaderTransferEncoding);
-
     const int arr[] = {0, 1, 2, 3};
     /* 'arr' above describes the highest possible quality of a Qobuz stream
          5:  320kbps AAC
@@ -62,11 +76,14 @@ Qobuz::Qobuz(Environment& aEnv, const Brx& aAppId, const Brx& aAppSecret,
     */
     std::vector<TUint> qualities(arr, arr + sizeof(arr)/sizeof(arr[0]));
     iConfigQuality = new ConfigChoice(aConfigInitialiser, kConfigKeySoundQuality, qualities, 3);
+    iStreamUrlCache = new StreamUrlCache(aEnv, "QobuzLookAhead", Brn("qobuz"), *this, kStreamUrlExpiryMs);
     iSubscriberIdQuality = iConfigQuality->Subscribe(MakeFunctorConfigChoice(*this, &Qobuz::QualityChanged));
 }
 
 Qobuz::~Qobuz()
 {
+    iConnectionLookAhead.iSocket.Interrupt(true);
+    delete iStreamUrlCache;
     iConfigQuality->Unsubscribe(iSubscriberIdQuality);
     delete iConfigQuality;
 }
@@ -78,13 +95,19 @@ TBool Qobuz::TryLogin()
 }
 
 TBool Qobuz::TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl)
+{
+    AutoMutex _(iLock);
+    return TryGetStreamUrl(iConnection, aTrackId, iAuthToken, aStreamUrl);
+}
+
+TBool Qobuz::TryGetStreamUrl(Connection& aConnection, const Brx& aTrackId, const Brx& aAuthToken, Bwx& aStreamUrl)
 {
     TBool success = false;
-    if (!TryConnect()) {
+    if (!TryConnect(aConnection)) {
         LOG2(kPipeline, kError, "Qobuz::TryGetStreamUrl - connection failure\n");
         return false;
     }
-    AutoSocketReader _(iSocket, iReaderUntil2);
+    AutoSocketReader _(aConnection.iSocket, aConnection.iReaderUntil2);
 
     // see https://github.com/Qobuz/api-documentation#request-signature for rules on creating request_sig value
     TUint timestamp;
@@ -106,28 +129,29 @@ TBool Qobuz::TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl)
     Ascii::AppendDec(sig, timestamp);
     sig.Append(iAppSecret);
 
-    iPathAndQuery.Replace(kVersionAndFormat);
-    iPathAndQuery.Append("track/getFileUrl?app_id=");
-    iPathAndQuery.Append(iAppId);
-    iPathAndQuery.Append("&user_auth_token=");
-    iPathAndQuery.Append(iAuthToken);
-    iPathAndQuery.Append("&request_ts=");
-    Ascii::AppendDec(iPathAndQuery, timestamp);
-    iPathAndQuery.Append("&request_sig=");
-    AppendMd5(iPathAndQuery, sig);
-    iPathAndQuery.Append("&track_id=");
-    iPathAndQuery.Append(aTrackId);
-    iPathAndQuery.Append("&format_id=");
-    iPathAndQuery.Append(audioFormatBuf);
-    iPathAndQuery.Append("&intent=stream");
+    Bwx& pathAndQuery = aConnection.iPathAndQuery;
+    pathAndQuery.Replace(kVersionAndFormat);
+    pathAndQuery.Append("track/getFileUrl?app_id=");
+    pathAndQuery.Append(iAppId);
+    pathAndQuery.Append("&user_auth_token=");
+    pathAndQuery.Append(aAuthToken);
+    pathAndQuery.Append("&request_ts=");
+    Ascii::AppendDec(pathAndQuery, timestamp);
+    pathAndQuery.Append("&request_sig=");
+    AppendMd5(pathAndQuery, sig);
+    pathAndQuery.Append("&track_id=");
+    pathAndQuery.Append(aTrackId);
+    pathAndQuery.Append("&format_id=");
+    pathAndQuery.Append(audioFormatBuf);
+    pathAndQuery.Append("&intent=stream");
 
     try {
-        const TUint code = WriteRequestReadResponse(Http::kMethodGet, iPathAndQuery);
+        const TUint code = WriteRequestReadResponse(aConnection, Http::kMethodGet, pathAndQuery);
         if (code != 200) {
             LOG2(kPipeline, kError, "Http error - %d - in response to Qobuz::TryGetStreamUrl.\n", code);
-            LOG2(kPipeline, kError, "...path/query is %.*s\n", PBUF(iPathAndQuery));
+            LOG2(kPipeline, kError, "...path/query is %.*s\n", PBUF(pathAndQuery));
             LOG2(kPipeline, kError, "Some/all of response is:\n");
-            Brn buf = iDechunker.Read(kReadBufferBytes);
+            Brn buf = aConnection.iDechunker.Read(kReadBufferBytes);
             LOG2(kPipeline, kError, "%.*s\n", PBUF(buf));
             THROW(ReaderError);
         }
@@ -135,9 +159,9 @@ TBool Qobuz::TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl)
         static const Brn kTagUrl("url");
         Brn val;
         do {
-            val.Set(ReadString());
+            val.Set(ReadString(aConnection));
         } while (val != kTagUrl);
-        aStreamUrl.Replace(ReadString());
+        aStreamUrl.Replace(ReadString(aConnection));
         Json::Unescape(aStreamUrl);
         success = true;
     }
@@ -155,7 +179,46 @@ TBool Qobuz::TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl)
 
 void Qobuz::Interrupt(TBool aInterrupt)
 {
-    iSocket.Interrupt(aInterrupt);
+    iConnection.iSocket.Interrupt(aInterrupt);
+}
+
+StreamUrlCache& Qobuz::StreamUrls()
+{
+    return *iStreamUrlCache;
+}
+
+TBool Qobuz::TryGetTrackId(const Brx& aQuery, Bwx& aTrackId)
+{ // static
+    Parser parser(aQuery);
+    (void)parser.Next('?');
+    Brn buf = parser.Next('=');
+    if (buf != Brn("version")) {
+        LOG2(kPipeline, kError, "TryGetTrackId failed - no version\n");
+        return false;
+    }
+    Brn verBuf = parser.Next('&');
+    try {
+        const TUint ver = Ascii::Uint(verBuf);
+        if (ver != 2) {
+            LOG2(kPipeline, kError, "TryGetTrackId failed - unsupported version - %d\n", ver);
+            return false;
+        }
+    }
+    catch (AsciiError&) {
+        LOG2(kPipeline, kError, "TryGetTrackId failed - invalid version\n");
+        return false;
+    }
+    buf.Set(parser.Next('='));
+    if (buf != Brn("trackId")) {
+        LOG2(kPipeline, kError, "TryGetTrackId failed - no track id tag\n");
+        return false;
+    }
+    aTrackId.Replace(parser.Remaining());
+    if (aTrackId.Bytes() == 0) {
+        LOG2(kPipeline, kError, "TryGetTrackId failed - no track id value\n");
+        return false;
+    }
+    return true;
 }
 
 const Brx& Qobuz::Id() const
@@ -170,6 +233,7 @@ void Qobuz::CredentialsChanged(const Brx& aUsername, const Brx& aPassword)
     iUsername.Write(aUsername);
     iPassword.Reset();
     iPassword.Write(aPassword);
+    iStreamUrlCache->Clear();
 }
 
 void Qobuz::UpdateStatus()
@@ -206,14 +270,36 @@ void Qobuz::ReLogin(const Brx& aCurrentToken, Bwx& aNewToken)
     aNewToken.Replace(iAuthToken);
 }
 
-TBool Qobuz::TryConnect()
+TBool Qobuz::TryResolveStreamUrl(const Brx& aTrackUri, Bwx& aStreamUrl)
+{
+    AutoMutex _(iLockLookAhead);
+    {
+        AutoMutex __(iLock);
+        if (iAuthToken.Bytes() == 0) {
+            return false; // don't log in on a speculative request; wait for ProtocolQobuz to do so
+        }
+        iLookAheadAuthToken.Replace(iAuthToken);
+    }
+    try {
+        iLookAheadUri.Replace(aTrackUri);
+    }
+    catch (UriError&) {
+        return false;
+    }
+    if (!TryGetTrackId(iLookAheadUri.Query(), iLookAheadTrackId)) {
+        return false;
+    }
+    return TryGetStreamUrl(iConnectionLookAhead, iLookAheadTrackId, iLookAheadAuthToken, aStreamUrl);
+}
+
+TBool Qobuz::TryConnect(Connection& aConnection)
 {
     OpenHome::Endpoint ep;
     try {
-        iSocket.Open(iEnv);
+        aConnection.iSocket.Open(iEnv);
         ep.SetAddress(kHost);
         ep.SetPort(kPort);
-        iSocket.Connect(ep, kConnectTimeoutMs);
+        aConnection.iSocket.Connect(ep, kConnectTimeoutMs);
     }
     catch (NetworkTimeout&) {
         return false;
@@ -230,35 +316,35 @@ TBool Qobuz::TryLoginLocked()
     Bws<50> error;
     TBool success = false;
 
-    if (!TryConnect()) {
+    if (!TryConnect(iConnection)) {
         LOG2(kMedia, kError, "Qobuz::TryLogin - connection failure\n");
         iCredentialsState.SetState(kId, Brn("Login Error (Connection Failed): Please Try Again."), Brx::Empty());
         return false;
     }
-    AutoSocketReader _(iSocket, iReaderUntil2);
+    AutoSocketReader _(iConnection.iSocket, iConnection.iReaderUntil2);
 
-    iPathAndQuery.Replace(kVersionAndFormat);
-    iPathAndQuery.Append("user/login?app_id=");
-    iPathAndQuery.Append(iAppId);
-    iPathAndQuery.Append("&username=");
+    iConnection.iPathAndQuery.Replace(kVersionAndFormat);
+    iConnection.iPathAndQuery.Append("user/login?app_id=");
+    iConnection.iPathAndQuery.Append(iAppId);
+    iConnection.iPathAndQuery.Append("&username=");
     iLockConfig.Wait();
-    iPathAndQuery.Append(iUsername.Buffer());
-    iPathAndQuery.Append("&password=");
-    AppendMd5(iPathAndQuery, iPassword.Buffer());
+    iConnection.iPathAndQuery.Append(iUsername.Buffer());
+    iConnection.iPathAndQuery.Append("&password=");
+    AppendMd5(iConnection.iPathAndQuery, iPassword.Buffer());
     iLockConfig.Signal();
 
     try {
-        const TUint code = WriteRequestReadResponse(Http::kMethodGet, iPathAndQuery);
+        const TUint code = WriteRequestReadResponse(iConnection, Http::kMethodGet, iConnection.iPathAndQuery);
         if (code != 200) {
             Bws<kMaxStatusBytes> status;
-            TUint len = std::min(status.MaxBytes(), iHeaderContentLength.ContentLength());
+            TUint len = std::min(status.MaxBytes(), iConnection.iHeaderContentLength.ContentLength());
             if (len > 0) {
-                status.Replace(iDechunker.Read(len));
+                status.Replace(iConnection.iDechunker.Read(len));
                 iCredentialsState.SetState(kId, status, Brx::Empty());
             }
             else {
                 status.AppendPrintf("Login Error (Response Code %d): ", code);
-                Brn buf = iDechunker.Read(kReadBufferBytes);
+                Brn buf = iConnection.iDechunker.Read(kReadBufferBytes);
                 len = std::min(status.MaxBytes() - status.Bytes(), buf.Bytes());
                 buf.Set(buf.Ptr(), len);
                 status.Append(buf);
@@ -272,9 +358,9 @@ TBool Qobuz::TryLoginLocked()
         static const Brn kUserAuthToken("user_auth_token");
         Brn val;
         do {
-            val.Set(ReadString());
+            val.Set(ReadString(iConnection));
         } while (val != kUserAuthToken);
-        iAuthToken.Replace(ReadString());
+        iAuthToken.Replace(ReadString(iConnection));
         iCredentialsState.SetState(kId, Brx::Empty(), iAppId);
         updatedStatus = true;
         success = true;
@@ -298,22 +384,22 @@ TBool Qobuz::TryLoginLocked()
     return success;
 }
 
-TUint Qobuz::WriteRequestReadResponse(const Brx& aMethod, const Brx& aPathAndQuery)
+TUint Qobuz::WriteRequestReadResponse(Connection& aConnection, const Brx& aMethod, const Brx& aPathAndQuery)
 {
-    iWriterRequest.WriteMethod(aMethod, aPathAndQuery, Http::eHttp11);
-    Http::WriteHeaderHostAndPort(iWriterRequest, kHost, kPort);
-    Http::WriteHeaderConnectionClose(iWriterRequest);
-    iWriterRequest.WriteFlush();
-    iReaderResponse.Read();
-    const TUint code = iReaderResponse.Status().Code();
-    iDechunker.SetChunked(iHeaderTransferEncoding.IsChunked());
+    aConnection.iWriterRequest.WriteMethod(aMethod, aPathAndQuery, Http::eHttp11);
+    Http::WriteHeaderHostAndPort(aConnection.iWriterRequest, kHost, kPort);
+    Http::WriteHeaderConnectionClose(aConnection.iWriterRequest);
+    aConnection.iWriterRequest.WriteFlush();
+    aConnection.iReaderResponse.Read();
+    const TUint code = aConnection.iReaderResponse.Status().Code();
+    aConnection.iDechunker.SetChunked(aConnection.iHeaderTransferEncoding.IsChunked());
     return code;
 }
 
-Brn Qobuz::ReadString()
-{
-    (void)iReaderUntil2.ReadUntil('\"');
-    return iReaderUntil2.ReadUntil('\"');
+Brn Qobuz::ReadString(Connection& aConnection)
+{ // static
+    (void)aConnection.iReaderUntil2.ReadUntil('\"');
+    return aConnection.iReaderUntil2.ReadUntil('\"');
 }
 
 void Qobuz::QualityChanged(Configuration::KeyValuePair<TUint>& aKvp)
@@ -321,6 +407,7 @@ void Qobuz::QualityChanged(Configuration::KeyValuePair<TUint>& aKvp)
     iLockConfig.Wait();
     iSoundQuality = kQualityValues[aKvp.Value()];
     iLockConfig.Signal();
+    iStreamUrlCache->Clear(); // cached urls were for the previous quality
 }
 
 void Qobuz::AppendMd5(Bwx& aBuffer, const Brx& aToHash)
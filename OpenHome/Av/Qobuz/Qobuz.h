@@ -1,12 +1,14 @@
 #pragma once
 
 #include <OpenHome/Av/Credentials.h>
+#include <OpenHome/Av/Utils/StreamUrlCache.h>
 #include <OpenHome/Types.h>
 #include <OpenHome/Configuration/ConfigManager.h>
 #include <OpenHome/Private/Network.h>
 #include <OpenHome/Private/Thread.h>
 #include <OpenHome/Private/Http.h>
 #include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Uri.h>
 #include <OpenHome/Buffer.h>
 
 namespace OpenHome {
@@ -18,7 +20,7 @@ namespace Configuration {
 }
 namespace Av {
 
-class Qobuz : public ICredentialConsumer
+class Qobuz : public ICredentialConsumer, private IStreamUrlResolver
 {
     friend class TestQobuz;
     static const TUint kReadBufferBytes = 4 * 1024;
@@ -32,8 +34,10 @@ class Qobuz : public ICredentialConsumer
     static const Brn kVersionAndFormat;
     static const TUint kSecsBetweenNtpAndUnixEpoch = 2208988800; // secs between 1900 and 1970
     static const TUint kMaxStatusBytes = 512;
+    static const TUint kStreamUrlExpiryMs = 5 * 60 * 1000; // conservative; file urls are signed for a limited period
 public:
     static const Brn kConfigKeySoundQuality;
+    static const TUint kMaxTrackIdBytes = 12;
 public:
     Qobuz(Environment& aEnv, const Brx& aAppId, const Brx& aAppSecret,
           ICredentialsState& aCredentialsState, Configuration::IConfigInitialiser& aConfigInitialiser,
@@ -42,17 +46,40 @@ public:
     TBool TryLogin();
     TBool TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl);
     void Interrupt(TBool aInterrupt);
+    StreamUrlCache& StreamUrls();
+    static TBool TryGetTrackId(const Brx& aQuery, Bwx& aTrackId);
 private: // from ICredentialConsumer
     const Brx& Id() const override;
     void CredentialsChanged(const Brx& aUsername, const Brx& aPassword) override;
     void UpdateStatus() override;
     void Login(Bwx& aToken) override;
     void ReLogin(const Brx& aCurrentToken, Bwx& aNewToken) override;
+private: // from IStreamUrlResolver
+    TBool TryResolveStreamUrl(const Brx& aTrackUri, Bwx& aStreamUrl) override;
 private:
-    TBool TryConnect();
+    class Connection : private INonCopyable
+    {
+    public:
+        Connection(Environment& aEnv);
+    public:
+        SocketTcpClient iSocket;
+        Srs<1024> iReaderBuf;
+        ReaderUntilS<1024> iReaderUntil1;
+        Sws<kWriteBufferBytes> iWriterBuf;
+        WriterHttpRequest iWriterRequest;
+        ReaderHttpResponse iReaderResponse;
+        ReaderHttpChunked iDechunker;
+        ReaderUntilS<kReadBufferBytes> iReaderUntil2;
+        HttpHeaderContentLength iHeaderContentLength;
+        HttpHeaderTransferEncoding iHeaderTransferEncoding;
+        Bws<512> iPathAndQuery; // slightly too large for the stack; requires that all network operations on a connection are serialised
+    };
+private:
+    TBool TryConnect(Connection& aConnection);
     TBool TryLoginLocked();
-    TUint WriteRequestReadResponse(const Brx& aMethod, const Brx& aPathAndQuery);
-    Brn ReadString();
+    TBool TryGetStreamUrl(Connection& aConnection, const Brx& aTrackId, const Brx& aAuthToken, Bwx& aStreamUrl);
+    TUint WriteRequestReadResponse(Connection& aConnection, const Brx& aMethod, const Brx& aPathAndQuery);
+    static Brn ReadString(Connection& aConnection);
     void QualityChanged(Configuration::KeyValuePair<TUint>& aKvp);
     static void AppendMd5(Bwx& aBuffer, const Brx& aToHash);
 private:
@@ -61,25 +88,22 @@ private:
     Mutex iLockConfig;
     ICredentialsState& iCredentialsState;
     IUnixTimestamp& iUnixTimestamp;
-    SocketTcpClient iSocket;
-    Srs<1024> iReaderBuf;
-    ReaderUntilS<1024> iReaderUntil1;
-    Sws<kWriteBufferBytes> iWriterBuf;
-    WriterHttpRequest iWriterRequest;
-    ReaderHttpResponse iReaderResponse;
-    ReaderHttpChunked iDechunker;
-    ReaderUntilS<kReadBufferBytes> iReaderUntil2;
-    HttpHeaderContentLength iHeaderContentLength;
-    HttpHeaderTransferEncoding iHeaderTransferEncoding;
+    Connection iConnection;
     const Bws<32> iAppId;
     const Bws<32> iAppSecret;
     WriterBwh iUsername;
     WriterBwh iPassword;
     TUint iSoundQuality;
     Bws<128> iAuthToken;
-    Bws<512> iPathAndQuery; // slightly too large for the stack; requires that all network operations are serialised
     Configuration::ConfigChoice* iConfigQuality;
     TUint iSubscriberIdQuality;
+    StreamUrlCache* iStreamUrlCache;
+    // look-ahead resolves use their own connection so never delay (or get interrupted by) ProtocolQobuz
+    Mutex iLockLookAhead;
+    Connection iConnectionLookAhead;
+    Uri iLookAheadUri;
+    Bws<kMaxTrackIdBytes> iLookAheadTrackId;
+    Bws<128> iLookAheadAuthToken;
 };
 
 };  // namespace Av
@@ -6,6 +6,7 @@
 #include <OpenHome/Media/Debug.h>
 #include <OpenHome/Av/Radio/ContentProcessorFactory.h>
 #include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Av/Radio/UriRacer.h>
 
 /* Example pls file
 
@@ -26,14 +27,19 @@ class ContentM3u : public Media::ContentProcessor
 {
     static const TUint kMaxLineBytes = 2 * 1024;
 public:
-    ContentM3u(Media::IMimeTypeList& aMimeTypeList);
+    ContentM3u(Media::IMimeTypeList& aMimeTypeList, IUriRacer* aUriRacer);
     ~ContentM3u();
 private: // from ContentProcessor
     TBool Recognise(const Brx& aUri, const Brx& aMimeType, const Brx& aData) override;
     Media::ProtocolStreamResult Stream(IReader& aReader, TUint64 aTotalBytes) override;
     void Reset() override;
+    void Interrupt(TBool aInterrupt) override;
+private:
+    void StreamEntry(const Brx& aUri, TBool& aStopped, TBool& aStreamSucceeded);
 private:
     ReaderUntil* iReaderUntil;
+    IUriRacer* iUriRacer;
+    UriList iUris;
 };
 
 } // namespace Av
@@ -46,13 +52,19 @@ using namespace OpenHome::Av;
 
 ContentProcessor* ContentProcessorFactory::NewM3u(IMimeTypeList& aMimeTypeList)
 { // static
-    return new ContentM3u(aMimeTypeList);
+    return new ContentM3u(aMimeTypeList, nullptr);
+}
+
+ContentProcessor* ContentProcessorFactory::NewM3u(IMimeTypeList& aMimeTypeList, IUriRacer& aUriRacer)
+{ // static
+    return new ContentM3u(aMimeTypeList, &aUriRacer);
 }
 
 
 // ContentM3u
 
-ContentM3u::ContentM3u(IMimeTypeList& aMimeTypeList)
+ContentM3u::ContentM3u(IMimeTypeList& aMimeTypeList, IUriRacer* aUriRacer)
+    : iUriRacer(aUriRacer)
 {
     iReaderUntil = new ReaderUntilS<kMaxLineBytes>(*this);
     aMimeTypeList.Add("audio/x-mpegurl");
@@ -84,19 +96,37 @@ ProtocolStreamResult ContentM3u::Stream(IReader& aReader, TUint64 aTotalBytes)
     TUint64 bytesRemaining = aTotalBytes;
     TBool stopped = false;
     TBool streamSucceeded = false;
+    TBool readAll = false;
+    iUris.Clear();
     try {
-        while (!stopped) {
+        // read as many entries as can be raced before streaming any
+        while (iUris.Count() < UriRacer::kMaxRacers) {
             Brn line = ReadLine(*iReaderUntil, bytesRemaining);
             if (line.Bytes() == 0 || line.BeginsWith(Brn("#"))) {
                 continue; // empty/comment line
             }
-            ProtocolStreamResult res = iProtocolSet->Stream(line);
-            if (res == EProtocolStreamStopped) {
-                stopped = true;
-            }
-            else if (res == EProtocolStreamSuccess) {
-                streamSucceeded = true;
+            iUris.Add(line);
+        }
+    }
+    catch (ReaderError&) {
+        readAll = true;
+    }
+
+    if (iUriRacer != nullptr) {
+        iUriRacer->Race(iUris);
+    }
+    for (TUint i=0; i<iUris.Count() && !stopped; i++) {
+        StreamEntry(iUris.At(i), stopped, streamSucceeded);
+    }
+
+    // stream any remaining entries as they're read
+    try {
+        while (!readAll && !stopped) {
+            Brn line = ReadLine(*iReaderUntil, bytesRemaining);
+            if (line.Bytes() == 0 || line.BeginsWith(Brn("#"))) {
+                continue; // empty/comment line
             }
+            StreamEntry(line, stopped, streamSucceeded);
         }
     }
     catch (ReaderError&) {
@@ -119,4 +149,23 @@ void ContentM3u::Reset()
 {
     iReaderUntil->ReadFlush();
     ContentProcessor::Reset();
+    iUris.Clear();
+}
+
+void ContentM3u::StreamEntry(const Brx& aUri, TBool& aStopped, TBool& aStreamSucceeded)
+{
+    ProtocolStreamResult res = iProtocolSet->Stream(aUri);
+    if (res == EProtocolStreamStopped) {
+        aStopped = true;
+    }
+    else if (res == EProtocolStreamSuccess) {
+        aStreamSucceeded = true;
+    }
+}
+
+void ContentM3u::Interrupt(TBool aInterrupt)
+{
+    if (iUriRacer != nullptr) {
+        iUriRacer->Interrupt(aInterrupt);
+    }
 }
@@ -6,6 +6,7 @@
 #include <OpenHome/Media/Debug.h>
 #include <OpenHome/Av/Radio/ContentProcessorFactory.h>
 #include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Av/Radio/UriRacer.h>
 
 /* Example pls file
 
@@ -35,14 +36,19 @@ class ContentPls : public Media::ContentProcessor
 {
     static const TUint kMaxLineBytes = 2 * 1024;
 public:
-    ContentPls(Media::IMimeTypeList& aMimeTypeList);
+    ContentPls(Media::IMimeTypeList& aMimeTypeList, IUriRacer* aUriRacer);
     ~ContentPls();
 private: // from ContentProcessor
     TBool Recognise(const Brx& aUri, const Brx& aMimeType, const Brx& aData) override;
     Media::ProtocolStreamResult Stream(IReader& aReader, TUint64 aTotalBytes) override;
     void Reset() override;
+    void Interrupt(TBool aInterrupt) override;
+private:
+    void StreamEntry(const Brx& aUri, TBool& aStopped, TBool& aStreamSucceeded);
 private:
     ReaderUntil* iReaderUntil;
+    IUriRacer* iUriRacer;
+    UriList iUris;
     TBool iIsPlaylist;
 };
 
@@ -56,13 +62,19 @@ using namespace OpenHome::Av;
 
 ContentProcessor* ContentProcessorFactory::NewPls(IMimeTypeList& aMimeTypeList)
 { // static
-    return new ContentPls(aMimeTypeList);
+    return new ContentPls(aMimeTypeList, nullptr);
+}
+
+ContentProcessor* ContentProcessorFactory::NewPls(IMimeTypeList& aMimeTypeList, IUriRacer& aUriRacer)
+{ // static
+    return new ContentPls(aMimeTypeList, &aUriRacer);
 }
 
 
 // ContentPls
 
-ContentPls::ContentPls(IMimeTypeList& aMimeTypeList)
+ContentPls::ContentPls(IMimeTypeList& aMimeTypeList, IUriRacer* aUriRacer)
+    : iUriRacer(aUriRacer)
 {
     iReaderUntil = new ReaderUntilS<kMaxLineBytes>(*this);
     aMimeTypeList.Add("audio/x-scpls");
@@ -96,6 +108,8 @@ ProtocolStreamResult ContentPls::Stream(IReader& aReader, TUint64 aTotalBytes)
     TUint64 bytesRemaining = aTotalBytes;
     TBool stopped = false;
     TBool streamSucceeded = false;
+    TBool readAll = false;
+    iUris.Clear();
     try {
         // Find [playlist]
         while (!iIsPlaylist) {
@@ -105,19 +119,35 @@ ProtocolStreamResult ContentPls::Stream(IReader& aReader, TUint64 aTotalBytes)
             }
         }
 
-        while (!stopped) {
+        // read as many entries as can be raced before streaming any
+        while (iUris.Count() < UriRacer::kMaxRacers) {
             Brn line = ReadLine(*iReaderUntil, bytesRemaining);
             Parser parser(line);
             Brn key = parser.Next('=');
             if (key.BeginsWith(Brn("File"))) {
-                Brn value = parser.Next();
-                ProtocolStreamResult res = iProtocolSet->Stream(value);
-                if (res == EProtocolStreamStopped) {
-                    stopped = true;
-                }
-                else if (res == EProtocolStreamSuccess) {
-                    streamSucceeded = true;
-                }
+                iUris.Add(parser.Next());
+            }
+        }
+    }
+    catch (ReaderError&) {
+        readAll = true;
+    }
+
+    if (iUriRacer != nullptr) {
+        iUriRacer->Race(iUris);
+    }
+    for (TUint i=0; i<iUris.Count() && !stopped; i++) {
+        StreamEntry(iUris.At(i), stopped, streamSucceeded);
+    }
+
+    // stream any remaining entries as they're read
+    try {
+        while (!readAll && !stopped) {
+            Brn line = ReadLine(*iReaderUntil, bytesRemaining);
+            Parser parser(line);
+            Brn key = parser.Next('=');
+            if (key.BeginsWith(Brn("File"))) {
+                StreamEntry(parser.Next(), stopped, streamSucceeded);
             }
         }
     }
@@ -142,4 +172,23 @@ void ContentPls::Reset()
     iReaderUntil->ReadFlush();
     ContentProcessor::Reset();
     iIsPlaylist = false;
+    iUris.Clear();
+}
+
+void ContentPls::StreamEntry(const Brx& aUri, TBool& aStopped, TBool& aStreamSucceeded)
+{
+    ProtocolStreamResult res = iProtocolSet->Stream(aUri);
+    if (res == EProtocolStreamStopped) {
+        aStopped = true;
+    }
+    else if (res == EProtocolStreamSuccess) {
+        aStreamSucceeded = true;
+    }
+}
+
+void ContentPls::Interrupt(TBool aInterrupt)
+{
+    if (iUriRacer != nullptr) {
+        iUriRacer->Interrupt(aInterrupt);
+    }
 }
@@ -7,12 +7,16 @@ namespace Media {
 } // namespace Media
 namespace Av {
 
+class IUriRacer;
+
 class ContentProcessorFactory
 {
 public:
     static Media::ContentProcessor* NewM3u(Media::IMimeTypeList& aMimeTypeList);
+    static Media::ContentProcessor* NewM3u(Media::IMimeTypeList& aMimeTypeList, IUriRacer& aUriRacer);
     static Media::ContentProcessor* NewM3uX();
     static Media::ContentProcessor* NewPls(Media::IMimeTypeList& aMimeTypeList);
+    static Media::ContentProcessor* NewPls(Media::IMimeTypeList& aMimeTypeList, IUriRacer& aUriRacer);
     static Media::ContentProcessor* NewOpml(Media::IMimeTypeList& aMimeTypeList);
     static Media::ContentProcessor* NewAsx();
 };
@@ -1,21 +1,29 @@
 #include <OpenHome/Av/Radio/PresetDatabase.h>
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Configuration/IStore.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Av/Debug.h>
 
-#include <array>
+#include <algorithm>
+#include <vector>
 
 using namespace OpenHome;
 using namespace OpenHome::Av;
 
 // PresetDatabase
 
-PresetDatabase::PresetDatabase(Media::TrackFactory& aTrackFactory)
+PresetDatabase::PresetDatabase(Media::TrackFactory& aTrackFactory, TUint aMaxPresets)
     : iTrackFactory(aTrackFactory)
     , iLock("RADB")
+    , iPresets(aMaxPresets)
+    , iArenaGarbageBytes(0)
     , iNextId(kPresetIdNone + 1)
     , iSeq(0)
     , iUpdated(false)
 {
+    ASSERT(aMaxPresets > 0);
 }
 
 PresetDatabase::~PresetDatabase()
@@ -27,11 +35,12 @@ void PresetDatabase::AddObserver(IPresetDatabaseObserver& aObserver)
     iObservers.push_back(&aObserver);
 }
 
-void PresetDatabase::GetIdArray(std::array<TUint32, kMaxPresets>& aIdArray, TUint& aSeq) const
+void PresetDatabase::GetIdArray(std::vector<TUint32>& aIdArray, TUint& aSeq) const
 {
     iLock.Wait();
-    for (TUint i=0; i<kMaxPresets; i++) {
-        aIdArray[i] = (TUint32)iPresets[i].Id();
+    aIdArray.resize(iPresets.size());
+    for (TUint i=0; i<iPresets.size(); i++) {
+        aIdArray[i] = (TUint32)iPresets[i].iId;
     }
     aSeq = iSeq;
     iLock.Signal();
@@ -39,17 +48,17 @@ void PresetDatabase::GetIdArray(std::array<TUint32, kMaxPresets>& aIdArray, TUin
 
 void PresetDatabase::GetPreset(TUint aIndex, TUint& aId, Bwx& aMetaData) const
 {
-    ASSERT(aIndex < kMaxPresets);
+    ASSERT(aIndex < iPresets.size());
     iLock.Wait();
     const Preset& preset = iPresets[aIndex];
-    aId = preset.Id();
-    aMetaData.Replace(preset.MetaData());
+    aId = preset.iId;
+    aMetaData.Replace(MetaData(preset));
     iLock.Signal();
 }
 
 TUint PresetDatabase::GetPresetId(TUint aPresetNumber) const
 {
-    if (aPresetNumber == 0 || aPresetNumber > kMaxPresets) {
+    if (aPresetNumber == 0 || aPresetNumber > iPresets.size()) {
         return kPresetIdNone;
     }
     TUint id;
@@ -57,7 +66,7 @@ TUint PresetDatabase::GetPresetId(TUint aPresetNumber) const
 
     iLock.Wait();
     const Preset& preset = iPresets[index];
-    id = preset.Id();
+    id = preset.iId;
     iLock.Signal();
 
     return id;
@@ -66,65 +75,47 @@ TUint PresetDatabase::GetPresetId(TUint aPresetNumber) const
 TUint PresetDatabase::GetPresetNumber(TUint aPresetId) const
 {
     AutoMutex a(iLock);
-    for (TUint i=0; i<kMaxPresets; i++) {
-        if (iPresets[i].Id() == aPresetId) {
-            return (i+1);
-        }
+    TUint index;
+    if (!TryFindIndexLocked(aPresetId, index)) {
+        return kPresetIdNone;
     }
-    return kPresetIdNone;
+    return index + 1;
 }
 
 TBool PresetDatabase::TryGetPresetById(TUint aId, Bwx& aMetaData) const
 {
     AutoMutex a(iLock);
-    return TryGetPresetByIdLocked(aId, aMetaData);
-}
-
-TBool PresetDatabase::TryGetPresetByIdLocked(TUint aId, Bwx& aMetaData) const
-{
-    for (TUint i=0; i<kMaxPresets; i++) {
-        if (iPresets[i].Id() == aId) {
-            aMetaData.Replace(iPresets[i].MetaData());
-            return true;
-        }
+    TUint index;
+    if (!TryFindIndexLocked(aId, index)) {
+        return false;
     }
-    return false;
+    aMetaData.Replace(MetaData(iPresets[index]));
+    return true;
 }
 
 TBool PresetDatabase::TryGetPresetById(TUint aId, Bwx& aUri, Bwx& aMetaData) const
 {
     AutoMutex a(iLock);
-    for (TUint i=0; i<kMaxPresets; i++) {
-        if (iPresets[i].Id() == aId) {
-            aUri.Replace(iPresets[i].Uri());
-            aMetaData.Replace(iPresets[i].MetaData());
-            return true;
-        }
+    TUint index;
+    if (!TryFindIndexLocked(aId, index)) {
+        return false;
     }
-    return false;
+    aUri.Replace(Uri(iPresets[index]));
+    aMetaData.Replace(MetaData(iPresets[index]));
+    return true;
 }
 
-TBool PresetDatabase::TryGetPresetById(TUint aId, TUint aSeq, Bwx& aMetaData, TUint& aIndex) const
+TBool PresetDatabase::TryGetPresetById(TUint aId, TUint /*aSeq*/, Bwx& aMetaData, TUint& aIndex) const
 {
+    // lookups by id are cheap so aSeq/aIndex are no longer needed as a search hint
     AutoMutex a(iLock);
-    if (iSeq != aSeq) {
-        return TryGetPresetByIdLocked(aId, aMetaData);
-    }
-    for (TUint i=aIndex; i<kMaxPresets; i++) {
-        if (iPresets[i].Id() == aId) {
-            aMetaData.Replace(iPresets[i].MetaData());
-            aIndex = i;
-            return true;
-        }
-    }
-    for (TUint i=0; i<aIndex; i++) {
-        if (iPresets[i].Id() == aId) {
-            aMetaData.Replace(iPresets[i].MetaData());
-            aIndex = i;
-            return true;
-        }
+    TUint index;
+    if (!TryFindIndexLocked(aId, index)) {
+        return false;
     }
-    return false;
+    aMetaData.Replace(MetaData(iPresets[index]));
+    aIndex = index;
+    return true;
 }
 
 TBool PresetDatabase::TryGetPresetByMetaData(const Brx& aMetaData, TUint& aId) const
@@ -132,9 +123,10 @@ TBool PresetDatabase::TryGetPresetByMetaData(const Brx& aMetaData, TUint& aId) c
     // FIXME - this could be pretty slow
     aId = kPresetIdNone;
     AutoMutex a(iLock);
-    for (TUint i=0; i<kMaxPresets; i++) {
-        if (iPresets[i].MetaData() == aMetaData) {
-            aId = iPresets[i].Id();
+    for (TUint i=0; i<iPresets.size(); i++) {
+        const Preset& preset = iPresets[i];
+        if (!preset.IsEmpty() && MetaData(preset) == aMetaData) {
+            aId = preset.iId;
             return true;
         }
     }
@@ -143,17 +135,27 @@ TBool PresetDatabase::TryGetPresetByMetaData(const Brx& aMetaData, TUint& aId) c
 
 void PresetDatabase::SetPreset(TUint aIndex, const Brx& aUri, const Brx& aMetaData, TUint& aId)
 {
+    ASSERT(aIndex < iPresets.size());
+    Brn metaData(aMetaData);
+    if (metaData.Bytes() > kMaxMetaDataBytes) {
+        metaData.Set(aMetaData.Ptr(), kMaxMetaDataBytes);
+    }
     iLock.Wait();
     Preset& preset = iPresets[aIndex];
-    aId = preset.Id();
-    if (preset.MetaData() != aMetaData) {
+    aId = preset.iId;
+    if (MetaData(preset) != metaData) {
+        if (preset.iId != kPresetIdNone) {
+            iIndexById.erase(preset.iId);
+        }
         if (aMetaData == Brx::Empty()) {
             aId = kPresetIdNone;
+            StoreLocked(preset, aId, Brx::Empty(), Brx::Empty());
         }
         else {
             aId = iNextId++;
+            StoreLocked(preset, aId, aUri, metaData);
+            iIndexById.insert(std::make_pair(aId, aIndex));
         }
-        preset.Set(aId, aUri, aMetaData);
         iSeq++;
         iUpdated = true;
     }
@@ -162,7 +164,7 @@ void PresetDatabase::SetPreset(TUint aIndex, const Brx& aUri, const Brx& aMetaDa
 
 TUint PresetDatabase::MaxNumPresets() const
 {
-    return kMaxPresets;
+    return (TUint)iPresets.size();
 }
 
 void PresetDatabase::BeginSetPresets()
@@ -177,9 +179,10 @@ void PresetDatabase::SetPreset(TUint aIndex, const Brx& aUri, const Brx& aMetaDa
 
 void PresetDatabase::ReadPreset(TUint aIndex, Bwx& aUri, Bwx& aMetaData)
 {
-    ASSERT(aIndex < kMaxPresets);
-    aUri.Replace(iPresets[aIndex].Uri());
-    aMetaData.Replace(iPresets[aIndex].MetaData());
+    ASSERT(aIndex < iPresets.size());
+    AutoMutex a(iLock);
+    aUri.Replace(Uri(iPresets[aIndex]));
+    aMetaData.Replace(MetaData(iPresets[aIndex]));
 }
 
 void PresetDatabase::ClearPreset(TUint aIndex)
@@ -203,28 +206,23 @@ void PresetDatabase::EndSetPresets()
 Media::Track* PresetDatabase::TrackRefById(TUint aId)
 {
     AutoMutex _(iLock);
-    for (TUint i=0; i<kMaxPresets; i++) {
-        const Preset& preset = iPresets[i];
-        if (preset.Id() == aId) {
-            return iTrackFactory.CreateTrack(preset.Uri(), preset.MetaData());
-        }
+    TUint index;
+    if (!TryFindIndexLocked(aId, index)) {
+        return nullptr;
     }
-    return nullptr;
+    return CreateTrackLocked(iPresets[index]);
 }
 
 Media::Track* PresetDatabase::NextTrackRef(TUint aId)
 {
     AutoMutex _(iLock);
-    for (TUint i=0; i<kMaxPresets; i++) {
-        const Preset& preset = iPresets[i];
-        if (preset.Id() == aId) {
-            for (TUint j=i+1; j<kMaxPresets; j++) {
-                const Preset& preset2 = iPresets[j];
-                if (!preset2.IsEmpty()) {
-                    return iTrackFactory.CreateTrack(preset2.Uri(), preset2.MetaData());
-                }
-            }
-            return nullptr;
+    TUint index;
+    if (!TryFindIndexLocked(aId, index)) {
+        return nullptr;
+    }
+    for (TUint i=index+1; i<iPresets.size(); i++) {
+        if (!iPresets[i].IsEmpty()) {
+            return CreateTrackLocked(iPresets[i]);
         }
     }
     return nullptr;
@@ -233,16 +231,13 @@ Media::Track* PresetDatabase::NextTrackRef(TUint aId)
 Media::Track* PresetDatabase::PrevTrackRef(TUint aId)
 {
     AutoMutex _(iLock);
-    for (TUint i=0; i<kMaxPresets; i++) {
-        const Preset& preset = iPresets[i];
-        if (preset.Id() == aId) {
-            for (TInt j=i-1; j>=0; j--) {
-                const Preset& preset2 = iPresets[j];
-                if (!preset2.IsEmpty()) {
-                    return iTrackFactory.CreateTrack(preset2.Uri(), preset2.MetaData());
-                }
-            }
-            return nullptr;
+    TUint index;
+    if (!TryFindIndexLocked(aId, index)) {
+        return nullptr;
+    }
+    for (TInt i=(TInt)index-1; i>=0; i--) {
+        if (!iPresets[i].IsEmpty()) {
+            return CreateTrackLocked(iPresets[i]);
         }
     }
     return nullptr;
@@ -251,10 +246,9 @@ Media::Track* PresetDatabase::PrevTrackRef(TUint aId)
 Media::Track* PresetDatabase::FirstTrackRef()
 {
     AutoMutex _(iLock);
-    for (TUint i=0; i<kMaxPresets; i++) {
-        const Preset& preset = iPresets[i];
-        if (!preset.IsEmpty()) {
-            return iTrackFactory.CreateTrack(preset.Uri(), preset.MetaData());
+    for (TUint i=0; i<iPresets.size(); i++) {
+        if (!iPresets[i].IsEmpty()) {
+            return CreateTrackLocked(iPresets[i]);
         }
     }
     return nullptr;
@@ -263,30 +257,160 @@ Media::Track* PresetDatabase::FirstTrackRef()
 Media::Track* PresetDatabase::LastTrackRef()
 {
     AutoMutex _(iLock);
-    for (TInt i=kMaxPresets-1; i>=0; i--) {
-        const Preset& preset = iPresets[i];
-        if (!preset.IsEmpty()) {
-            return iTrackFactory.CreateTrack(preset.Uri(), preset.MetaData());
+    for (TInt i=(TInt)iPresets.size()-1; i>=0; i--) {
+        if (!iPresets[i].IsEmpty()) {
+            return CreateTrackLocked(iPresets[i]);
         }
     }
     return nullptr;
 }
 
+TBool PresetDatabase::TryFindIndexLocked(TUint aId, TUint& aIndex) const
+{
+    auto it = iIndexById.find(aId);
+    if (it == iIndexById.end()) {
+        return false;
+    }
+    aIndex = it->second;
+    return true;
+}
+
+Brn PresetDatabase::Uri(const Preset& aPreset) const
+{
+    if (aPreset.iUriBytes == 0) {
+        return Brn(Brx::Empty());
+    }
+    return Brn(&iArena[aPreset.iOffset], aPreset.iUriBytes);
+}
+
+Brn PresetDatabase::MetaData(const Preset& aPreset) const
+{
+    if (aPreset.iMetaDataBytes == 0) {
+        return Brn(Brx::Empty());
+    }
+    return Brn(&iArena[aPreset.iOffset + aPreset.iUriBytes], aPreset.iMetaDataBytes);
+}
+
+Media::Track* PresetDatabase::CreateTrackLocked(const Preset& aPreset)
+{
+    return iTrackFactory.CreateTrack(Uri(aPreset), MetaData(aPreset));
+}
+
+void PresetDatabase::StoreLocked(Preset& aPreset, TUint aId, const Brx& aUri, const Brx& aMetaData)
+{
+    iArenaGarbageBytes += aPreset.iUriBytes + aPreset.iMetaDataBytes;
+    aPreset.iId = aId;
+    aPreset.iOffset = 0;
+    aPreset.iUriBytes = 0;
+    aPreset.iMetaDataBytes = 0;
+    const TUint bytes = aUri.Bytes() + aMetaData.Bytes();
+    if (iArenaGarbageBytes > 0 && iArenaGarbageBytes >= iArena.size() / 2) {
+        CompactLocked(bytes);
+    }
+    if (bytes == 0) {
+        return;
+    }
+    aPreset.iOffset = (TUint)iArena.size();
+    aPreset.iUriBytes = aUri.Bytes();
+    aPreset.iMetaDataBytes = aMetaData.Bytes();
+    iArena.insert(iArena.end(), aUri.Ptr(), aUri.Ptr() + aUri.Bytes());
+    iArena.insert(iArena.end(), aMetaData.Ptr(), aMetaData.Ptr() + aMetaData.Bytes());
+}
+
+void PresetDatabase::CompactLocked(TUint aExtraBytes)
+{
+    // copy presets into a new arena that is only as large as they (plus aExtraBytes) require
+    std::vector<TByte> arena;
+    arena.reserve(iArena.size() - iArenaGarbageBytes + aExtraBytes);
+    for (auto& preset : iPresets) {
+        const TUint bytes = preset.iUriBytes + preset.iMetaDataBytes;
+        if (bytes > 0) {
+            const TUint offset = (TUint)arena.size();
+            const TByte* src = &iArena[preset.iOffset];
+            arena.insert(arena.end(), src, src + bytes);
+            preset.iOffset = offset;
+        }
+    }
+    iArena.swap(arena);
+    iArenaGarbageBytes = 0;
+}
+
 
 // PresetDatabase::Preset
 
 PresetDatabase::Preset::Preset()
     : iId(kPresetIdNone)
+    , iOffset(0)
+    , iUriBytes(0)
+    , iMetaDataBytes(0)
+{
+}
+
+
+// PresetCache
+
+PresetCache::PresetCache(Configuration::IStoreReadWrite& aStore, const Brx& aKeyPrefix)
+    : iStore(aStore)
+    , iKeyPrefix(aKeyPrefix)
 {
 }
 
-void PresetDatabase::Preset::Set(TUint aId, const Brx& aUri, const Brx& aMetaData)
+void PresetCache::Write(TUint aIndex, const Brx& aUri, const Brx& aMetaData)
 {
-    iId = aId;
-    iUri.Replace(aUri);
+    ASSERT(aUri.Bytes() <= Media::kTrackUriMaxBytes);
     Brn metaData(aMetaData);
-    if (metaData.Bytes() > iMetaData.MaxBytes()) {
-        metaData.Split(iMetaData.MaxBytes());
+    if (metaData.Bytes() > IPresetDatabaseWriter::kMaxMetaDataBytes) {
+        metaData.Set(aMetaData.Ptr(), IPresetDatabaseWriter::kMaxMetaDataBytes);
+    }
+    iBuf.SetBytes(0);
+    iBuf.Append(static_cast<TByte>(aUri.Bytes() >> 8));
+    iBuf.Append(static_cast<TByte>(aUri.Bytes()));
+    iBuf.Append(aUri);
+    iBuf.Append(metaData);
+    SetKey(aIndex);
+    iStore.Write(iKey, iBuf);
+}
+
+TBool PresetCache::TryRead(TUint aIndex, Bwx& aUri, Bwx& aMetaData)
+{
+    SetKey(aIndex);
+    try {
+        iStore.Read(iKey, iBuf);
+    }
+    catch (StoreKeyNotFound&) {
+        return false;
+    }
+    catch (StoreReadBufferUndersized&) {
+        LOG2(kSources, kError, "PresetCache: ignoring oversized entry %.*s\n", PBUF(iKey));
+        return false;
     }
-    iMetaData.Replace(metaData);
+    const TUint bytes = iBuf.Bytes();
+    const TUint uriBytes = (bytes < 2? 0 : (iBuf[0] << 8) | iBuf[1]);
+    if (bytes < 2 || uriBytes > bytes - 2) {
+        LOG2(kSources, kError, "PresetCache: ignoring corrupt entry %.*s\n", PBUF(iKey));
+        return false;
+    }
+    const TUint metaDataBytes = bytes - 2 - uriBytes;
+    if (uriBytes > aUri.MaxBytes() || metaDataBytes > aMetaData.MaxBytes()) {
+        LOG2(kSources, kError, "PresetCache: ignoring oversized entry %.*s\n", PBUF(iKey));
+        return false;
+    }
+    aUri.Replace(iBuf.Ptr() + 2, uriBytes);
+    aMetaData.Replace(iBuf.Ptr() + 2 + uriBytes, metaDataBytes);
+    return true;
+}
+
+void PresetCache::Delete(TUint aIndex)
+{
+    SetKey(aIndex);
+    try {
+        iStore.Delete(iKey);
+    }
+    catch (StoreKeyNotFound&) {}
+}
+
+void PresetCache::SetKey(TUint aIndex)
+{
+    iKey.Replace(iKeyPrefix);
+    Ascii::AppendDec(iKey, aIndex);
 }
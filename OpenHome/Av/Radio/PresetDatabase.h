@@ -3,15 +3,20 @@
 #include <OpenHome/Types.h>
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 
-#include <array>
+#include <unordered_map>
+#include <vector>
 
 namespace OpenHome {
 class Environment;
 namespace Media {
     class TrackFactory;
 }
+namespace Configuration {
+    class IStoreReadWrite;
+}
 namespace Av {
 
 class IPresetDatabaseObserver
@@ -23,6 +28,8 @@ public:
 
 class IPresetDatabaseWriter
 {
+public:
+    static const TUint kMaxMetaDataBytes = 1024 * 2; // longer metadata is truncated
 public:
     virtual ~IPresetDatabaseWriter() {}
     virtual TUint MaxNumPresets() const = 0;
@@ -36,12 +43,12 @@ public:
 class IPresetDatabaseReader
 {
 public:
-    static const TUint kMaxPresets = 100;
     static const TUint kPresetIdNone = 0;
 public:
     virtual ~IPresetDatabaseReader() {}
     virtual void AddObserver(IPresetDatabaseObserver& aObserver) = 0;
-    virtual void GetIdArray(std::array<TUint32, kMaxPresets>& aIdArray, TUint& aSeq) const = 0;
+    virtual TUint MaxNumPresets() const = 0;
+    virtual void GetIdArray(std::vector<TUint32>& aIdArray, TUint& aSeq) const = 0; // aIdArray is resized to MaxNumPresets()
     virtual void GetPreset(TUint aIndex, TUint& aId, Bwx& aMetaData) const = 0;
     virtual TUint GetPresetId(TUint aPresetNumber) const = 0;
     virtual TUint GetPresetNumber(TUint aPresetId) const = 0;
@@ -62,21 +69,30 @@ public:
     virtual Media::Track* LastTrackRef() = 0;
 };
 
+/*
+ * Holds up to aMaxPresets presets, indexed by preset number (less one).
+ *
+ * Uri and metadata for all presets are packed into a single arena so memory use follows the
+ * presets actually held rather than the maximum that could be.  Replaced or cleared presets
+ * leave garbage in the arena which is reclaimed once it reaches half the arena's size.
+ * Lookups by id are O(1).
+ */
 class PresetDatabase : public IPresetDatabaseWriter
                      , public IPresetDatabaseReader
                      , public IPresetDatabaseReaderTrack
                      , private INonCopyable
 {
+    friend class SuitePresetDatabase;
 public:
-    static const TUint kMaxPresets = 100;
+    static const TUint kDefaultMaxPresets = 100;
     static const TUint kPresetIdNone = 0;
 public:
-    PresetDatabase(Media::TrackFactory& aTrackFactory);
+    PresetDatabase(Media::TrackFactory& aTrackFactory, TUint aMaxPresets = kDefaultMaxPresets);
     ~PresetDatabase();
     void SetPreset(TUint aIndex, const Brx& aUri, const Brx& aMetaData, TUint& aId);
 public: // from IPresetDatabaseReader
     void AddObserver(IPresetDatabaseObserver& aObserver) override;
-    void GetIdArray(std::array<TUint32, kMaxPresets>& aIdArray, TUint& aSeq) const override;
+    void GetIdArray(std::vector<TUint32>& aIdArray, TUint& aSeq) const override;
     void GetPreset(TUint aIndex, TUint& aId, Bwx& aMetaData) const override;
     TUint GetPresetId(TUint aPresetNumber) const override;
     TUint GetPresetNumber(TUint aPresetId) const override;
@@ -84,7 +100,7 @@ public: // from IPresetDatabaseReader
     TBool TryGetPresetById(TUint aId, Bwx& aUri, Bwx& aMetaData) const override;
     TBool TryGetPresetById(TUint aId, TUint aSeq, Bwx& aMetaData, TUint& aIndex) const override;
     TBool TryGetPresetByMetaData(const Brx& aMetaData, TUint& aId) const override;
-public: // from IPresetDatabaseWriter
+public: // from IPresetDatabaseWriter (MaxNumPresets() is also from IPresetDatabaseReader)
     TUint MaxNumPresets() const override;
     void BeginSetPresets() override;
     void SetPreset(TUint aIndex, const Brx& aUri, const Brx& aMetaData) override;
@@ -97,34 +113,63 @@ public: // from IPresetDatabaseReaderTrack
     Media::Track* PrevTrackRef(TUint aId) override;
     Media::Track* FirstTrackRef() override;
     Media::Track* LastTrackRef() override;
-private:
-    TBool TryGetPresetByIdLocked(TUint aId, Bwx& aMetaData) const;
 private:
     class Preset
     {
-        static const TUint kMaxMetaDataBytes = 1024 * 2;
     public:
         Preset();
-        void Set(TUint aId, const Brx& aUri, const Brx& aMetaData);
-        TUint Id() const { return iId; }
-        TBool IsEmpty() const { return iId != IPresetDatabaseReader::kPresetIdNone; }
-        const Brx& Uri() const { return iUri; }
-        const Brx& MetaData() const { return iMetaData; }
-    private:
+        TBool IsEmpty() const { return iId == IPresetDatabaseReader::kPresetIdNone; }
+    public:
         TUint iId;
-        Media::BwsTrackUri iUri;
-        Bws<kMaxMetaDataBytes> iMetaData;
+        TUint iOffset; // into iArena
+        TUint iUriBytes;
+        TUint iMetaDataBytes;
     };
+private:
+    TBool TryFindIndexLocked(TUint aId, TUint& aIndex) const;
+    Brn Uri(const Preset& aPreset) const;
+    Brn MetaData(const Preset& aPreset) const;
+    Media::Track* CreateTrackLocked(const Preset& aPreset);
+    void StoreLocked(Preset& aPreset, TUint aId, const Brx& aUri, const Brx& aMetaData);
+    void CompactLocked(TUint aExtraBytes);
 private:
     Media::TrackFactory& iTrackFactory;
     mutable Mutex iLock;
     std::vector<IPresetDatabaseObserver*> iObservers;
-    Preset iPresets[kMaxPresets];
+    std::vector<Preset> iPresets;
+    std::unordered_map<TUint, TUint> iIndexById;
+    std::vector<TByte> iArena;
+    TUint iArenaGarbageBytes;
     TUint iNextId;
     TUint iSeq;
     TBool iUpdated;
 };
 
+/*
+ * Persists individual presets so a writer can restore its last good set at startup.
+ *
+ * Each preset is stored under <aKeyPrefix><index> as [uriBytes:2][uri][metadata].  Metadata
+ * is truncated as PresetDatabase would.  Not thread-safe.
+ */
+class PresetCache : private INonCopyable
+{
+    static const TUint kMaxKeyBytes = 64;
+public:
+    static const TUint kMaxEntryBytes = 2 + Media::kTrackUriMaxBytes + IPresetDatabaseWriter::kMaxMetaDataBytes;
+public:
+    PresetCache(Configuration::IStoreReadWrite& aStore, const Brx& aKeyPrefix);
+    void Write(TUint aIndex, const Brx& aUri, const Brx& aMetaData);
+    TBool TryRead(TUint aIndex, Bwx& aUri, Bwx& aMetaData); // false if there's no (valid) entry
+    void Delete(TUint aIndex);
+private:
+    void SetKey(TUint aIndex);
+private:
+    Configuration::IStoreReadWrite& iStore;
+    Bws<kMaxKeyBytes> iKeyPrefix;
+    Bws<kMaxKeyBytes> iKey;
+    Bws<kMaxEntryBytes> iBuf;
+};
+
 } // namespace Av
 } // namespace OpenHome
 
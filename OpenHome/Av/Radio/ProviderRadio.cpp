@@ -32,6 +32,7 @@ ProviderRadio::ProviderRadio(Net::DvDevice& aDevice, ISourceRadio& aSource, IPre
     , iSource(aSource)
     , iDbReader(aDbReader)
     , iDbSeq(0)
+    , iIdArrayBuf(aDbReader.MaxNumPresets() * sizeof(TUint32))
     , iTempVarLock("PRD3")
 {
     iDbReader.AddObserver(*this);
@@ -66,7 +67,7 @@ ProviderRadio::ProviderRadio(Net::DvDevice& aDevice, ISourceRadio& aSource, IPre
     SetTransportState(Media::EPipelineStopped);
     (void)SetPropertyId(IPresetDatabaseReader::kPresetIdNone);
     UpdateIdArrayProperty();
-    (void)SetPropertyChannelsMax(IPresetDatabaseReader::kMaxPresets);
+    (void)SetPropertyChannelsMax(iDbReader.MaxNumPresets());
 }
 
 ProviderRadio::~ProviderRadio()
@@ -277,7 +278,7 @@ void ProviderRadio::IdArrayChanged(IDvInvocation& aInvocation, TUint aToken, IDv
 void ProviderRadio::ChannelsMax(IDvInvocation& aInvocation, IDvInvocationResponseUint& aValue)
 {
     aInvocation.StartResponse();
-    aValue.Write(IPresetDatabaseReader::kMaxPresets);
+    aValue.Write(iDbReader.MaxNumPresets());
     aInvocation.EndResponse();
 }
 
@@ -293,7 +294,7 @@ void ProviderRadio::UpdateIdArray()
 {
     iDbReader.GetIdArray(iIdArray, iDbSeq);
     iIdArrayBuf.SetBytes(0);
-    for (TUint i=0; i<IPresetDatabaseReader::kMaxPresets; i++) {
+    for (TUint i=0; i<iIdArray.size(); i++) {
         TUint32 bigEndianId = Arch::BigEndian4(iIdArray[i]);
         Brn idBuf(reinterpret_cast<const TByte*>(&bigEndianId), sizeof(bigEndianId));
         iIdArrayBuf.Append(idBuf);
@@ -56,8 +56,8 @@ private:
     TUint iDbSeq;
     Media::BwsTrackUri iUri;
     Media::BwsTrackMetaData iMetaData;
-    std::array<TUint, IPresetDatabaseReader::kMaxPresets> iIdArray;
-    Bws<IPresetDatabaseReader::kMaxPresets * sizeof(TUint32)> iIdArrayBuf;
+    std::vector<TUint32> iIdArray;
+    Bwh iIdArrayBuf;
     // only required locally by certain functions but too large for the stack
     Mutex iTempVarLock;
     Media::BwsTrackMetaData iTempMetadata;
@@ -9,6 +9,7 @@
 #include <OpenHome/Av/Radio/TuneIn.h>
 #include <OpenHome/Media/PipelineManager.h>
 #include <OpenHome/Av/Radio/ContentProcessorFactory.h>
+#include <OpenHome/Av/Radio/UriRacer.h>
 #include <OpenHome/Media/UriProviderSingleTrack.h>
 #include <OpenHome/Av/SourceFactory.h>
 #include <OpenHome/Av/MediaPlayer.h>
@@ -31,12 +32,17 @@ using namespace OpenHome::Media;
 
 ISource* SourceFactory::NewRadio(IMediaPlayer& aMediaPlayer)
 { // static
-    return new SourceRadio(aMediaPlayer, Brx::Empty());
+    return new SourceRadio(aMediaPlayer, Brx::Empty(), PresetDatabase::kDefaultMaxPresets);
 }
 
 ISource* SourceFactory::NewRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId)
 { // static
-    return new SourceRadio(aMediaPlayer, aTuneInPartnerId);
+    return new SourceRadio(aMediaPlayer, aTuneInPartnerId, PresetDatabase::kDefaultMaxPresets);
+}
+
+ISource* SourceFactory::NewRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId, TUint aMaxPresets)
+{ // static
+    return new SourceRadio(aMediaPlayer, aTuneInPartnerId, aMaxPresets);
 }
 
 const TChar* SourceFactory::kSourceTypeRadio = "Radio";
@@ -44,7 +50,7 @@ const Brn SourceFactory::kSourceNameRadio("Radio");
 
 // SourceRadio
 
-SourceRadio::SourceRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId)
+SourceRadio::SourceRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId, TUint aMaxPresets)
     : Source(SourceFactory::kSourceNameRadio, SourceFactory::kSourceTypeRadio, aMediaPlayer.Pipeline(), aMediaPlayer.PowerManager())
     , iLock("SRAD")
     , iUriProvider(nullptr)
@@ -57,12 +63,13 @@ SourceRadio::SourceRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId
 {
     MimeTypeList& mimeTypes = aMediaPlayer.MimeTypes();
 
-    iPipeline.Add(ContentProcessorFactory::NewM3u(mimeTypes));
-    iPipeline.Add(ContentProcessorFactory::NewM3u(mimeTypes));
+    iUriRacer = new UriRacer(aMediaPlayer.Env());
+    iPipeline.Add(ContentProcessorFactory::NewM3u(mimeTypes, *iUriRacer));
+    iPipeline.Add(ContentProcessorFactory::NewM3u(mimeTypes, *iUriRacer));
     iPipeline.Add(ContentProcessorFactory::NewM3uX());
     iPipeline.Add(ContentProcessorFactory::NewM3uX());
-    iPipeline.Add(ContentProcessorFactory::NewPls(mimeTypes));
-    iPipeline.Add(ContentProcessorFactory::NewPls(mimeTypes));
+    iPipeline.Add(ContentProcessorFactory::NewPls(mimeTypes, *iUriRacer));
+    iPipeline.Add(ContentProcessorFactory::NewPls(mimeTypes, *iUriRacer));
     iPipeline.Add(ContentProcessorFactory::NewOpml(mimeTypes));
     iPipeline.Add(ContentProcessorFactory::NewOpml(mimeTypes));
     iPipeline.Add(ContentProcessorFactory::NewAsx());
@@ -72,7 +79,7 @@ SourceRadio::SourceRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId
                                   kPowerPriorityNormal, Brn("Radio.PresetId"),
                                   IPresetDatabaseReader::kPresetIdNone);
 
-    iPresetDatabase = new PresetDatabase(aMediaPlayer.TrackFactory());
+    iPresetDatabase = new PresetDatabase(aMediaPlayer.TrackFactory(), aMaxPresets);
     iPresetDatabase->AddObserver(*this);
 
     iUriProvider = new UriProviderRadio(aMediaPlayer.TrackFactory(), *iPresetDatabase);
@@ -86,6 +93,7 @@ SourceRadio::SourceRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId
     else {
         iTuneIn = new RadioPresetsTuneIn(aMediaPlayer.Env(), aTuneInPartnerId,
                                          *iPresetDatabase, aMediaPlayer.ConfigInitialiser(),
+                                         aMediaPlayer.ReadWriteStore(),
                                          aMediaPlayer.CredentialsManager(), mimeTypes);
     }
 }
@@ -96,6 +104,7 @@ SourceRadio::~SourceRadio()
     delete iPresetDatabase;
     delete iStorePresetNumber;
     delete iProviderRadio;
+    delete iUriRacer; // pipeline (and so the content processors using this) is destroyed before sources
     if (iTrack != nullptr) {
         iTrack->RemoveRef();
     }
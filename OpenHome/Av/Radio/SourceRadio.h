@@ -37,6 +37,7 @@ class ProviderRadio;
 class RadioPresetsTuneIn;
 class IMediaPlayer;
 class UriProviderRadio;
+class UriRacer;
 
 class SourceRadio : public Source
                   , private ISourceRadio
@@ -44,7 +45,7 @@ class SourceRadio : public Source
                   , private IPresetDatabaseObserver
 {
 public:
-    SourceRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId);
+    SourceRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId, TUint aMaxPresets);
     ~SourceRadio();
 private: // from ISource
     void Activate(TBool aAutoPlay) override;
@@ -76,6 +77,7 @@ private:
     ProviderRadio* iProviderRadio;
     PresetDatabase* iPresetDatabase;
     RadioPresetsTuneIn* iTuneIn;
+    UriRacer* iUriRacer;
     Media::Track* iTrack;
     TUint iTrackPosSeconds;
     TUint iStreamId;
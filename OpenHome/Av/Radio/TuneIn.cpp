@@ -17,6 +17,7 @@
 #include <OpenHome/Media/PipelineManager.h>
 #include <OpenHome/Media/MimeTypeList.h>
 #include <OpenHome/Private/NetworkAdapterList.h>
+#include <OpenHome/Configuration/IStore.h>
 
 #include <limits.h>
 
@@ -30,6 +31,7 @@ const Brn RadioPresetsTuneIn::kTuneInPresetsRequest("http://opml.radiotime.com/B
 //const Brn RadioPresetsTuneIn::kFormats("&formats=mp3,wma,aac,wmvideo,ogg,hls");
 const Brn RadioPresetsTuneIn::kPartnerId("&partnerId=");
 const Brn RadioPresetsTuneIn::kUsername("&username=");
+const Brn RadioPresetsTuneIn::kCacheKeyPrefix("Radio.TuneInPreset.");
 
 typedef struct MimeTuneInPair
 {
@@ -39,15 +41,20 @@ typedef struct MimeTuneInPair
 
 RadioPresetsTuneIn::RadioPresetsTuneIn(Environment& aEnv, const Brx& aPartnerId,
                                        IPresetDatabaseWriter& aDbWriter, IConfigInitialiser& aConfigInit,
+                                       IStoreReadWrite& aStore,
                                        Credentials& aCredentialsManager, Media::MimeTypeList& aMimeTypeList)
     : iLock("RPTI")
     , iEnv(aEnv)
     , iDbWriter(aDbWriter)
+    , iCache(aStore, kCacheKeyPrefix)
+    , iCachedPresets(aDbWriter.MaxNumPresets(), false)
     , iWriteBuffer(iSocket)
     , iWriterRequest(iWriteBuffer)
     , iReadBuffer(iSocket)
     , iReaderUntil(iReadBuffer)
     , iReaderResponse(aEnv, iReaderUntil)
+    , iHeaderETag("ETag")
+    , iHeaderLastModified("Last-Modified")
     , iSupportedFormats("&formats=")
     , iPartnerId(aPartnerId)
 {
@@ -77,6 +84,9 @@ RadioPresetsTuneIn::RadioPresetsTuneIn(Environment& aEnv, const Brx& aPartnerId,
     Log::Print("\n");
 
     iReaderResponse.AddHeader(iHeaderContentLength);
+    iReaderResponse.AddHeader(iHeaderETag);
+    iReaderResponse.AddHeader(iHeaderLastModified);
+    RestoreCache();
     iRefreshThread = new ThreadFunctor("TuneInRefresh", MakeFunctor(*this, &RadioPresetsTuneIn::RefreshThread));
     iRefreshThread->Start();
     iRefreshTimer = new Timer(aEnv, MakeFunctor(*this, &RadioPresetsTuneIn::TimerCallback), "RadioPresetsTuneIn");
@@ -111,7 +121,10 @@ void RadioPresetsTuneIn::UpdateUsername(const Brx& aUsername)
     uriBuf.Append(iPartnerId);
     uriBuf.Append(kUsername);
     uriBuf.Append(aUsername);
+    AutoMutex _(iLock);
     iRequestUri.Replace(uriBuf);
+    iETag.SetBytes(0);
+    iLastModified.SetBytes(0);
 }
 
 void RadioPresetsTuneIn::UsernameChanged(KeyValuePair<const Brx&>& aKvp)
@@ -127,7 +140,8 @@ void RadioPresetsTuneIn::Refresh()
 
 void RadioPresetsTuneIn::CurrentAdapterChanged()
 {
-    Refresh();
+    // many devices may see the same network change; don't have them all refresh at once
+    iRefreshTimer->FireIn(iEnv.Random(kRefreshJitterMs));
 }
 
 void RadioPresetsTuneIn::TimerCallback()
@@ -139,7 +153,7 @@ void RadioPresetsTuneIn::RefreshThread()
 {
     for (;;) {
         iRefreshThread->Wait();
-        iRefreshTimer->FireIn(kRefreshRateMs);
+        iRefreshTimer->FireIn(kRefreshRateMs + iEnv.Random(kRefreshJitterMs));
         try {
             iSocket.Open(iEnv);
             DoRefresh(); // doesn't throw
@@ -153,20 +167,38 @@ void RadioPresetsTuneIn::RefreshThread()
 void RadioPresetsTuneIn::DoRefresh()
 {
     TBool startedUpdates = false;
+    TBool complete = false; // only clear presets we didn't see if the whole list was read
     try {
-        Endpoint ep(80, iRequestUri.Host());
-        iSocket.Connect(ep, 20 * 1000); // hard-coded timeout.  Ignores .InitParams().TcpConnectTimeoutMs() on the assumption that is set for lan connections
-
-        // FIXME - try sending If-Modified-Since header with request. See rfr2616 14.25
-        // ... this may require that we use http 1.1 in the request, so cope with a chunked response
-        iWriterRequest.WriteMethod(Http::kMethodGet, iRequestUri.PathAndQuery(), Http::eHttp10);
-        const TUint port = (iRequestUri.Port() == -1? 80 : (TUint)iRequestUri.Port());
-        Http::WriteHeaderHostAndPort(iWriterRequest, iRequestUri.Host(), port);
+        Uri requestUri;
+        Bws<HttpHeaderValidator::kMaxValueBytes> etag;
+        Bws<HttpHeaderValidator::kMaxValueBytes> lastModified;
+        {
+            AutoMutex _(iLock);
+            requestUri.Replace(iRequestUri.AbsoluteUri());
+            etag.Replace(iETag);
+            lastModified.Replace(iLastModified);
+        }
+        Endpoint ep(80, requestUri.Host());
+        iSocket.Connect(ep, kConnectTimeoutMs);
+
+        iWriterRequest.WriteMethod(Http::kMethodGet, requestUri.PathAndQuery(), Http::eHttp10);
+        const TUint port = (requestUri.Port() == -1? 80 : (TUint)requestUri.Port());
+        Http::WriteHeaderHostAndPort(iWriterRequest, requestUri.Host(), port);
         Http::WriteHeaderConnectionClose(iWriterRequest);
+        if (etag.Bytes() > 0) {
+            iWriterRequest.WriteHeader(Brn("If-None-Match"), etag);
+        }
+        if (lastModified.Bytes() > 0) {
+            iWriterRequest.WriteHeader(Brn("If-Modified-Since"), lastModified);
+        }
         iWriterRequest.WriteFlush();
 
         iReaderResponse.Read(kReadResponseTimeoutMs);
         const HttpStatus& status = iReaderResponse.Status();
+        if (status == HttpStatus::kNotModified) {
+            LOG(kSources, "TuneIn presets not modified\n");
+            return;
+        }
         if (status != HttpStatus::kOk) {
             LOG2(kError, kSources, "Error fetching TuneIn xml - status=%u\n", status.Code());
             THROW(HttpError);
@@ -209,9 +241,13 @@ void RadioPresetsTuneIn::DoRefresh()
         try {
             // Find the default container (there may be multiple containers if TuneIn folders are used)
             TBool foundDefault = false;
-            for (; !foundDefault;) {
+            for (; !foundDefault && !complete;) {
                 iReaderUntil.ReadUntil('<');
                 buf.Set(iReaderUntil.ReadUntil('>'));
+                if (buf == Brn("/opml")) {
+                    complete = true; // no default container => no presets
+                    break;
+                }
                 const TBool isContainer = buf.BeginsWith(Brn("outline type=\"container\""));
                 if (!isContainer) {
                     continue;
@@ -228,10 +264,11 @@ void RadioPresetsTuneIn::DoRefresh()
                 }
             }
             // Read presets for the current container only
-            for (;;) {
+            while (!complete) {
                 iReaderUntil.ReadUntil('<');
                 buf.Set(iReaderUntil.ReadUntil('>'));
                 if (buf == Brn("/outline")) {
+                    complete = true;
                     break;
                 }
                 const TBool isAudio = buf.BeginsWith(Brn("outline type=\"audio\""));
@@ -309,6 +346,9 @@ void RadioPresetsTuneIn::DoRefresh()
                    a station changes its preset id. */
                 iDbWriter.ReadPreset(presetIndex, iDbUri, iDbMetaData);
                 if (iDbUri == iPresetUrl) {
+                    if (!iCachedPresets[presetIndex]) {
+                        CachePreset(presetIndex); // preset is current but its cache entry was lost or corrupt
+                    }
                     continue;
                 }
 
@@ -340,13 +380,28 @@ void RadioPresetsTuneIn::DoRefresh()
 
                 //Log::Print("++ Add preset #%u: %.*s\n", presetIndex, PBUF(iPresetUrl));
                 iDbWriter.SetPreset(presetIndex, iPresetUrl, iDidlLite);
+                CachePreset(presetIndex);
             }
         }
         catch (ReaderError&) {
         }
-        for (TUint i=0; i<maxPresets; i++) {
-            if (iAllocatedPresets[i] == 0) {
-                iDbWriter.ClearPreset(i);
+        if (!complete) {
+            LOG2(kError, kSources, "TuneIn presets truncated; retaining any presets not read\n");
+        }
+        else {
+            for (TUint i=0; i<maxPresets; i++) {
+                if (iAllocatedPresets[i] == 0) {
+                    iDbWriter.ReadPreset(i, iDbUri, iDbMetaData);
+                    if (iDbUri.Bytes() > 0) {
+                        iDbWriter.ClearPreset(i);
+                        UncachePreset(i);
+                    }
+                }
+            }
+            AutoMutex _(iLock);
+            if (requestUri.AbsoluteUri() == iRequestUri.AbsoluteUri()) {
+                iETag.Replace(iHeaderETag.Value());
+                iLastModified.Replace(iHeaderLastModified.Value());
             }
         }
     }
@@ -398,6 +453,62 @@ TBool RadioPresetsTuneIn::ReadValue(Parser& aParser, const TChar* aKey, Bwx& aVa
     return true;
 }
 
+void RadioPresetsTuneIn::RestoreCache()
+{
+    const TUint maxPresets = iDbWriter.MaxNumPresets();
+    iDbWriter.BeginSetPresets();
+    for (TUint i=0; i<maxPresets; i++) {
+        if (iCache.TryRead(i, iDbUri, iDbMetaData)) {
+            iDbWriter.SetPreset(i, iDbUri, iDbMetaData);
+            iCachedPresets[i] = true;
+        }
+    }
+    iDbWriter.EndSetPresets();
+}
+
+void RadioPresetsTuneIn::CachePreset(TUint aIndex)
+{
+    // cache what the database actually holds (it may truncate metadata)
+    iDbWriter.ReadPreset(aIndex, iDbUri, iDbMetaData);
+    iCache.Write(aIndex, iDbUri, iDbMetaData);
+    iCachedPresets[aIndex] = true;
+}
+
+void RadioPresetsTuneIn::UncachePreset(TUint aIndex)
+{
+    iCache.Delete(aIndex);
+    iCachedPresets[aIndex] = false;
+}
+
+
+// HttpHeaderValidator
+
+HttpHeaderValidator::HttpHeaderValidator(const TChar* aName)
+    : iName(aName)
+{
+}
+
+const Brx& HttpHeaderValidator::Value() const
+{
+    if (Received()) {
+        return iValue;
+    }
+    return Brx::Empty();
+}
+
+TBool HttpHeaderValidator::Recognise(const Brx& aHeader)
+{
+    return Ascii::CaseInsensitiveEquals(aHeader, iName);
+}
+
+void HttpHeaderValidator::Process(const Brx& aValue)
+{
+    if (aValue.Bytes() <= iValue.MaxBytes()) {
+        iValue.Replace(aValue);
+        SetReceived();
+    }
+}
+
 
 // CredentialsTuneIn
 
@@ -21,6 +21,7 @@ namespace OpenHome {
 namespace Configuration {
     class IConfigInitialiser;
     class ConfigText;
+    class IStoreReadWrite;
 }
 namespace Media {
     class PipelineManager;
@@ -28,6 +29,29 @@ namespace Media {
 }
 namespace Av {
 
+class HttpHeaderValidator : public HttpHeader
+{
+public:
+    static const TUint kMaxValueBytes = 128;
+public:
+    HttpHeaderValidator(const TChar* aName);
+    const Brx& Value() const; // empty if not received (or too long to use)
+private: // from HttpHeader
+    TBool Recognise(const Brx& aHeader) override;
+    void Process(const Brx& aValue) override;
+private:
+    Brn iName;
+    Bws<kMaxValueBytes> iValue;
+};
+
+/*
+ * Keeps the Radio presets in step with a TuneIn account.
+ *
+ * Presets are only rewritten when their url changes.  Each refresh is a conditional GET so an
+ * unchanged preset list costs a 304 response rather than a full download.  The last good set
+ * of presets is kept in aStore and restored at startup so presets are available before
+ * TuneIn can be reached.
+ */
 class RadioPresetsTuneIn
 {
 private:
@@ -35,8 +59,10 @@ private:
     static const TUint kWriteBufBytes = 1024;
     static const TUint kMaxUserNameBytes = 64;
     static const TUint kMaxPartnerIdBytes = 64;
+    static const TUint kConnectTimeoutMs = 20 * 1000; // Ignores .InitParams().TcpConnectTimeoutMs() on the assumption that is set for lan connections
     static const TUint kReadResponseTimeoutMs = 30 * 1000; // 30 seconds
     static const TUint kRefreshRateMs = 5 * 60 * 1000; // 5 minutes
+    static const TUint kRefreshJitterMs = 60 * 1000; // spreads refreshes from many devices over time
     static const TUint kMaxPresetTitleBytes = 256;
     static const Brn kConfigKeyUsername;
     static const Brn kConfigUsernameDefault;
@@ -44,9 +70,11 @@ private:
     static const Brn kFormats;
     static const Brn kPartnerId;
     static const Brn kUsername;
+    static const Brn kCacheKeyPrefix;
 public:
     RadioPresetsTuneIn(Environment& aEnv, const Brx& aPartnerId,
                        IPresetDatabaseWriter& aDbWriter, Configuration::IConfigInitialiser& aConfigInit,
+                       Configuration::IStoreReadWrite& aStore,
                        Credentials& aCredentialsManager, Media::MimeTypeList& aMimeTypeList);
     ~RadioPresetsTuneIn();
     void Refresh();
@@ -60,10 +88,15 @@ private:
     TBool ReadElement(Parser& aParser, const TChar* aKey, Bwx& aValue);
     TBool ValidateKey(Parser& aParser, const TChar* aKey, TBool aLogErrors);
     TBool ReadValue(Parser& aParser, const TChar* aKey, Bwx& aValue);
+    void RestoreCache();
+    void CachePreset(TUint aIndex);
+    void UncachePreset(TUint aIndex);
 private:
     Mutex iLock;
     Environment& iEnv;
     IPresetDatabaseWriter& iDbWriter;
+    PresetCache iCache;
+    std::vector<TBool> iCachedPresets; // whether iCache holds an entry for each preset
     ThreadFunctor* iRefreshThread;
     SocketTcpClient iSocket;
     Uri iRequestUri;
@@ -73,6 +106,10 @@ private:
     ReaderUntilS<kReadBufBytes> iReaderUntil;
     ReaderHttpResponse iReaderResponse;
     HttpHeaderContentLength iHeaderContentLength;
+    HttpHeaderValidator iHeaderETag;
+    HttpHeaderValidator iHeaderLastModified;
+    Bws<HttpHeaderValidator::kMaxValueBytes> iETag;         // validators from the last complete response
+    Bws<HttpHeaderValidator::kMaxValueBytes> iLastModified; // ...cleared if the request changes
     Timer* iRefreshTimer;
     Bws<40> iSupportedFormats;
     // Following members provide temp storage used while converting OPML elements to Didl-Lite
@@ -85,7 +122,7 @@ private:
     TUint iListenerId;
     std::vector<TUint> iAllocatedPresets;
     Media::BwsTrackUri iDbUri; // only required in a single function but too large for the stack
-    Bws<2*1024> iDbMetaData;
+    Bws<IPresetDatabaseWriter::kMaxMetaDataBytes> iDbMetaData;
     const Bws<kMaxPartnerIdBytes> iPartnerId;
     TUint iNacnId;
 };
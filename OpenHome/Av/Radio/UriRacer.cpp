@@ -0,0 +1,488 @@
+#include <OpenHome/Av/Radio/UriRacer.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Exception.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Uri.h>
+#include <OpenHome/Private/Timer.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Media/Debug.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+// UriList
+
+UriList::UriList()
+{
+}
+
+UriList::~UriList()
+{
+    Clear();
+}
+
+void UriList::Add(const Brx& aUri)
+{
+    iUris.push_back(new Bwh(aUri));
+}
+
+void UriList::Clear()
+{
+    for (auto it=iUris.begin(); it!=iUris.end(); ++it) {
+        delete *it;
+    }
+    iUris.clear();
+}
+
+TUint UriList::Count() const
+{
+    return (TUint)iUris.size();
+}
+
+const Brx& UriList::At(TUint aIndex) const
+{
+    ASSERT(aIndex < iUris.size());
+    return *iUris[aIndex];
+}
+
+void UriList::Reorder(const std::vector<TUint>& aOrder)
+{
+    ASSERT(aOrder.size() == iUris.size());
+    std::vector<Bwh*> uris;
+    uris.reserve(iUris.size());
+    for (auto it=aOrder.begin(); it!=aOrder.end(); ++it) {
+        uris.push_back(iUris[*it]);
+    }
+    iUris.swap(uris);
+}
+
+
+// UriRacer::Racer
+
+UriRacer::Racer::Racer(UriRacer& aParent, Environment& aEnv, TUint aId)
+    : iLock("URRC")
+    , iParent(&aParent)
+    , iEnv(aEnv)
+    , iPort(0)
+    , iIndex(0)
+    , iStartMs(0)
+    , iDurationMs(0)
+    , iOpen(false)
+    , iBusy(false)
+    , iCancelled(false)
+    , iResult(eNotRaced)
+{
+    Bws<16> name("UriRacer");
+    Ascii::AppendDec(name, aId);
+    iThread = new ThreadFunctor(name.PtrZ(), MakeFunctor(*this, &UriRacer::Racer::Run), kPriorityNormal);
+    iThread->Start();
+}
+
+UriRacer::Racer::~Racer()
+{
+    delete iThread;
+}
+
+TBool UriRacer::Racer::IsBusy() const
+{
+    AutoMutex _(iLock);
+    return iBusy;
+}
+
+TBool UriRacer::Racer::TrySetUri(const Brx& aUri, TUint aIndex)
+{
+    try {
+        iUri.Replace(aUri);
+    }
+    catch (UriError&) {
+        return false;
+    }
+    TInt port = iUri.Port();
+    if (port == -1) {
+        if (Ascii::CaseInsensitiveEquals(iUri.Scheme(), Brn("http"))) {
+            port = 80;
+        }
+        else if (Ascii::CaseInsensitiveEquals(iUri.Scheme(), Brn("https"))) {
+            port = 443;
+        }
+        else {
+            return false;
+        }
+    }
+    iPort = (TUint)port;
+    iIndex = aIndex;
+    return true;
+}
+
+void UriRacer::Racer::Start(TUint aStartMs)
+{
+    AutoMutex _(iLock);
+    ASSERT(!iBusy);
+    iStartMs = aStartMs;
+    iDurationMs = 0;
+    iBusy = true;
+    iCancelled = false;
+    iResult = eNotRaced;
+    iThread->Signal();
+}
+
+void UriRacer::Racer::Cancel()
+{
+    AutoMutex _(iLock);
+    if (iBusy) {
+        iCancelled = true;
+        if (iOpen) {
+            iSocket.Interrupt(true);
+        }
+    }
+}
+
+TBool UriRacer::Racer::TryOrphan()
+{
+    AutoMutex _(iLock);
+    if (!iBusy) {
+        return false;
+    }
+    iCancelled = true;
+    if (iOpen) {
+        // connect is interruptible so the caller can delete (and so join) us promptly
+        iSocket.Interrupt(true);
+        return false;
+    }
+    iParent = nullptr;
+    return true;
+}
+
+TUint UriRacer::Racer::Index() const
+{
+    return iIndex;
+}
+
+UriRacer::EOutcome UriRacer::Racer::Result() const
+{
+    AutoMutex _(iLock);
+    return iResult;
+}
+
+TUint UriRacer::Racer::DurationMs() const
+{
+    AutoMutex _(iLock);
+    return iDurationMs;
+}
+
+void UriRacer::Racer::Run()
+{
+    for (;;) {
+        iThread->Wait();
+        TBool connected = false;
+        try {
+            Endpoint endpoint;
+            endpoint.SetAddress(iUri.Host()); // may block for some time; can't be interrupted
+            endpoint.SetPort(iPort);
+            iLock.Wait();
+            if (!iCancelled) {
+                iSocket.Open(iEnv);
+                iOpen = true;
+            }
+            iLock.Signal();
+            if (iOpen) {
+                iSocket.Connect(endpoint, kConnectTimeoutMs);
+                connected = true;
+            }
+        }
+        catch (NetworkTimeout&) {
+        }
+        catch (NetworkError&) {
+        }
+        AutoMutex _(iLock);
+        if (iOpen) {
+            try {
+                iSocket.Close();
+            }
+            catch (NetworkError&) {
+            }
+            iOpen = false;
+        }
+        iBusy = false;
+        if (iParent == nullptr) {
+            /* our UriRacer was destroyed while we resolved a hostname.  Nothing else references
+               us and iEnv may no longer be valid; we're cancelled so never opened iSocket. */
+            iResult = eCancelled;
+            return;
+        }
+        iDurationMs = Time::Now(iEnv) - iStartMs;
+        if (iCancelled) {
+            iResult = eCancelled;
+        }
+        else {
+            iResult = (connected? eWon : eFailed);
+        }
+        iParent->iSemDone.Signal();
+    }
+}
+
+
+// UriRacer
+
+UriRacer::UriRacer(Environment& aEnv)
+    : iEnv(aEnv)
+    , iLock("URCR")
+    , iSemDone("URCR", 0)
+    , iInterrupted(false)
+    , iRaces(0)
+    , iReordered(0)
+    , iLost(0)
+    , iFailed(0)
+    , iCancelled(0)
+{
+    for (TUint i=0; i<kMaxRacers; i++) {
+        iRacers.push_back(new Racer(*this, aEnv, i));
+    }
+}
+
+UriRacer::~UriRacer()
+{
+    Destroy(iRacers);
+    Destroy(iOrphans);
+}
+
+UriRacer::EOutcome UriRacer::Outcome(TUint aIndex) const
+{
+    AutoMutex _(iLock);
+    if (aIndex >= iOutcomes.size()) {
+        return eNotRaced;
+    }
+    return iOutcomes[aIndex];
+}
+
+void UriRacer::GetStats(TUint& aRaces, TUint& aReordered, TUint& aLost, TUint& aFailed, TUint& aCancelled) const
+{
+    AutoMutex _(iLock);
+    aRaces = iRaces;
+    aReordered = iReordered;
+    aLost = iLost;
+    aFailed = iFailed;
+    aCancelled = iCancelled;
+}
+
+void UriRacer::Race(UriList& aUris)
+{
+    const TUint count = aUris.Count();
+    std::vector<EOutcome> outcomes(count, eNotRaced);
+    std::vector<Racer*> racing;
+    iLock.Wait();
+    ReapOrphansLocked();
+    if (!iInterrupted) {
+        for (TUint i=0; i<count && racing.size()<kMaxRacers; i++) {
+            Racer* racer = IdleRacerLocked(racing);
+            if (racer == nullptr) {
+                break;
+            }
+            if (racer->TrySetUri(aUris.At(i), i)) {
+                racing.push_back(racer);
+            }
+        }
+    }
+    if (racing.size() < 2) {
+        // nothing to be gained from racing a single entry
+        iOutcomes.swap(outcomes);
+        iLock.Signal();
+        return;
+    }
+
+    LOG(kMedia, "UriRacer::Race - racing %u of %u entries\n", (TUint)racing.size(), count);
+    (void)iSemDone.Clear(); // discard signals from attempts cancelled by an earlier race
+    const TUint startMs = Time::Now(iEnv);
+    for (auto it=racing.begin(); it!=racing.end(); ++it) {
+        (*it)->Start(startMs);
+    }
+    iLock.Signal();
+
+    // wait until one entry connects, all fail, the connect timeout expires or we're interrupted
+    for (;;) {
+        iLock.Wait();
+        const TBool decided = (iInterrupted || IsDecided(racing));
+        iLock.Signal();
+        if (decided) {
+            break;
+        }
+        const TUint elapsedMs = Time::Now(iEnv) - startMs;
+        if (elapsedMs >= kConnectTimeoutMs) {
+            break;
+        }
+        try {
+            iSemDone.Wait(kConnectTimeoutMs - elapsedMs);
+        }
+        catch (Timeout&) {
+            break;
+        }
+    }
+
+    AutoMutex _(iLock);
+    iRaces++;
+    if (iInterrupted) {
+        LOG(kMedia, "UriRacer::Race - interrupted\n");
+    }
+    Racer* winner = Winner(racing);
+    TUint winnerIndex = count;
+    for (auto it=racing.begin(); it!=racing.end(); ++it) {
+        Racer& racer = **it;
+        EOutcome outcome = racer.Result();
+        if (&racer == winner) {
+            winnerIndex = racer.Index();
+        }
+        else if (outcome == eWon) {
+            outcome = eLost;
+            iLost++;
+        }
+        else if (outcome == eFailed) {
+            iFailed++;
+        }
+        else {
+            racer.Cancel();
+            outcome = eCancelled;
+            iCancelled++;
+            if (racer.IsBusy()) {
+                iRacers.erase(std::find(iRacers.begin(), iRacers.end(), &racer));
+                iOrphans.push_back(&racer);
+            }
+        }
+        outcomes[racer.Index()] = outcome;
+        const TUint durationMs = (outcome == eCancelled? Time::Now(iEnv) - startMs : racer.DurationMs());
+        LOG(kMedia, "UriRacer::Race - entry %u %s after %ums: %.*s\n",
+            racer.Index(), OutcomeName(outcome), durationMs, PBUF(aUris.At(racer.Index())));
+    }
+
+    // winner first, entries that failed to connect last, otherwise preserve playlist order
+    std::vector<TUint> order;
+    order.reserve(count);
+    if (winnerIndex < count) {
+        order.push_back(winnerIndex);
+        if (winnerIndex != 0) {
+            iReordered++;
+        }
+    }
+    for (TUint i=0; i<count; i++) {
+        if (i != winnerIndex && outcomes[i] != eFailed) {
+            order.push_back(i);
+        }
+    }
+    for (TUint i=0; i<count; i++) {
+        if (outcomes[i] == eFailed) {
+            order.push_back(i);
+        }
+    }
+    aUris.Reorder(order);
+    iOutcomes.resize(count);
+    for (TUint i=0; i<count; i++) {
+        iOutcomes[i] = outcomes[order[i]];
+    }
+}
+
+void UriRacer::Interrupt(TBool aInterrupt)
+{
+    AutoMutex _(iLock);
+    iInterrupted = aInterrupt;
+    if (aInterrupt) {
+        for (auto it=iRacers.begin(); it!=iRacers.end(); ++it) {
+            (*it)->Cancel();
+        }
+        iSemDone.Signal();
+    }
+}
+
+const TChar* UriRacer::OutcomeName(EOutcome aOutcome)
+{ // static
+    switch (aOutcome)
+    {
+    case eWon:
+        return "won";
+    case eLost:
+        return "lost";
+    case eFailed:
+        return "failed";
+    case eCancelled:
+        return "cancelled";
+    default:
+        return "not raced";
+    }
+}
+
+UriRacer::Racer* UriRacer::IdleRacerLocked(const std::vector<Racer*>& aRacing)
+{
+    /* Attempts cancelled by an earlier race may still be resolving a hostname.
+       Use another racer (creating one if necessary) rather than wait for them. */
+    for (auto it=iRacers.begin(); it!=iRacers.end(); ++it) {
+        Racer* racer = *it;
+        if (!racer->IsBusy() && std::find(aRacing.begin(), aRacing.end(), racer) == aRacing.end()) {
+            return racer;
+        }
+    }
+    if (iRacers.size() + iOrphans.size() >= kMaxRacerThreads) {
+        return nullptr;
+    }
+    Racer* racer = new Racer(*this, iEnv, (TUint)iRacers.size());
+    iRacers.push_back(racer);
+    return racer;
+}
+
+void UriRacer::ReapOrphansLocked()
+{
+    for (auto it=iOrphans.begin(); it!=iOrphans.end();) {
+        if ((*it)->IsBusy()) {
+            ++it;
+        }
+        else {
+            delete *it;
+            it = iOrphans.erase(it);
+        }
+    }
+}
+
+void UriRacer::Destroy(std::vector<Racer*>& aRacers)
+{ // static
+    for (auto it=aRacers.begin(); it!=aRacers.end(); ++it) {
+        if ((*it)->TryOrphan()) {
+            // still resolving a hostname, which can't be interrupted; leak rather than block shutdown
+            LOG(kMedia, "UriRacer - racer still resolving on destruction, leaving it to exit\n");
+        }
+        else {
+            delete *it;
+        }
+    }
+    aRacers.clear();
+}
+
+TBool UriRacer::IsDecided(const std::vector<Racer*>& aRacing)
+{ // static
+    TBool outstanding = false;
+    for (auto it=aRacing.begin(); it!=aRacing.end(); ++it) {
+        const EOutcome outcome = (*it)->Result();
+        if (outcome == eWon) {
+            return true;
+        }
+        if (outcome == eNotRaced) {
+            outstanding = true;
+        }
+    }
+    return !outstanding;
+}
+
+UriRacer::Racer* UriRacer::Winner(const std::vector<Racer*>& aRacing)
+{ // static
+    // earliest to connect; ties go to the entry nearest the top of the playlist
+    Racer* winner = nullptr;
+    for (auto it=aRacing.begin(); it!=aRacing.end(); ++it) {
+        Racer* racer = *it;
+        if (racer->Result() == eWon && (winner == nullptr || racer->DurationMs() < winner->DurationMs())) {
+            winner = racer;
+        }
+    }
+    return winner;
+}
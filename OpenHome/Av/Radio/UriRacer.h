@@ -0,0 +1,135 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Uri.h>
+
+#include <vector>
+
+namespace OpenHome {
+    class Environment;
+namespace Av {
+
+/*
+ * Stream uris read from a playlist (pls, m3u, ...), in the order they should be tried.
+ */
+class UriList : private INonCopyable
+{
+public:
+    UriList();
+    ~UriList();
+    void Add(const Brx& aUri);
+    void Clear();
+    TUint Count() const;
+    const Brx& At(TUint aIndex) const;
+    void Reorder(const std::vector<TUint>& aOrder); // aOrder lists each current index exactly once
+private:
+    std::vector<Bwh*> iUris;
+};
+
+class IUriRacer
+{
+public:
+    virtual ~IUriRacer() {}
+    virtual void Race(UriList& aUris) = 0;
+    virtual void Interrupt(TBool aInterrupt) = 0; // Race() returns promptly, leaving aUris unordered, while interrupted
+};
+
+/*
+ * Avoids a dead or slow first entry in a playlist delaying tuning to a station.
+ *
+ * Race() opens TCP connections to the first kMaxRacers http(s) entries concurrently.  The
+ * first entry to accept a connection is moved to the front of the list and any that failed
+ * are moved to the back.  Attempts still outstanding at that point are cancelled.  Probe
+ * connections are always closed; the caller then streams the list in its new order.
+ *
+ * Only one race runs at a time.  A single racer can be shared by several content processors
+ * as each completes its race before streaming any entry.
+ *
+ * Cancelled attempts may still be resolving a hostname, which can't be interrupted.  Race()
+ * doesn't wait for these; they're set aside as orphans, replaced by new racers (up to
+ * kMaxRacerThreads in total) and deleted by a later race once their lookup completes.  The
+ * destructor joins all racers except those still resolving a hostname.  These are left to exit
+ * once their lookup completes and don't use the socket or Environment after this.
+ */
+class UriRacer : public IUriRacer, private INonCopyable
+{
+public:
+    static const TUint kMaxRacers = 3;
+    static const TUint kMaxRacerThreads = 2 * kMaxRacers;
+    static const TUint kConnectTimeoutMs = 3000;
+    enum EOutcome
+    {
+        eNotRaced
+       ,eWon
+       ,eLost       // connected, but after the winner
+       ,eFailed
+       ,eCancelled  // still connecting when the race was decided
+    };
+public:
+    UriRacer(Environment& aEnv);
+    ~UriRacer();
+    EOutcome Outcome(TUint aIndex) const; // outcome of the last race for the entry now at aIndex
+    void GetStats(TUint& aRaces, TUint& aReordered, TUint& aLost, TUint& aFailed, TUint& aCancelled) const;
+public: // from IUriRacer
+    void Race(UriList& aUris) override;
+    void Interrupt(TBool aInterrupt) override;
+private:
+    class Racer : private INonCopyable
+    {
+    public:
+        Racer(UriRacer& aParent, Environment& aEnv, TUint aId);
+        ~Racer();
+        TBool IsBusy() const;
+        TBool TrySetUri(const Brx& aUri, TUint aIndex); // only valid while !IsBusy()
+        void Start(TUint aStartMs);
+        void Cancel();
+        TBool TryOrphan(); // returns true if resolving a hostname; caller must not then delete the racer, whose thread exits once its lookup completes
+        TUint Index() const;
+        EOutcome Result() const; // eNotRaced while still connecting
+        TUint DurationMs() const;
+    private:
+        void Run();
+    private:
+        mutable Mutex iLock;
+        UriRacer* iParent; // nullptr once orphaned
+        Environment& iEnv;
+        SocketTcpClient iSocket;
+        Uri iUri;
+        TUint iPort;
+        TUint iIndex;
+        TUint iStartMs;
+        TUint iDurationMs;
+        TBool iOpen;
+        TBool iBusy;
+        TBool iCancelled;
+        EOutcome iResult;
+        ThreadFunctor* iThread;
+    };
+private:
+    static const TChar* OutcomeName(EOutcome aOutcome);
+    Racer* IdleRacerLocked(const std::vector<Racer*>& aRacing);
+    void ReapOrphansLocked();
+    static void Destroy(std::vector<Racer*>& aRacers);
+    static TBool IsDecided(const std::vector<Racer*>& aRacing);
+    static Racer* Winner(const std::vector<Racer*>& aRacing);
+private:
+    Environment& iEnv;
+    mutable Mutex iLock;
+    Semaphore iSemDone; // signalled as each attempt completes and on Interrupt()
+    std::vector<Racer*> iRacers;
+    std::vector<Racer*> iOrphans; // cancelled while resolving a hostname
+    std::vector<EOutcome> iOutcomes;
+    TBool iInterrupted;
+    TUint iRaces;
+    TUint iReordered;
+    TUint iLost;
+    TUint iFailed;
+    TUint iCancelled;
+};
+
+} // namespace Av
+} // namespace OpenHome
@@ -270,7 +270,7 @@ TUint RaopPacketAudio::Ssrc() const
 // ProtocolRaop
 
 ProtocolRaop::ProtocolRaop(Environment& aEnv, Media::TrackFactory& aTrackFactory, IRaopDiscovery& aDiscovery, UdpServerManager& aServerManager, TUint aAudioId, TUint aControlId)
-    : Protocol(aEnv)
+    : Protocol(aEnv, "raop")
     , iTrackFactory(aTrackFactory)
     , iDiscovery(aDiscovery)
     , iServerManager(aServerManager)
@@ -524,6 +524,7 @@ ProtocolStreamResult ProtocolRaop::Stream(const Brx& aUri)
             //LOG(kMedia, "ProtocolRaop::Stream validSession: %u, shouldFlush: %u\n", validSession, shouldFlush);
 
             if (validSession && !shouldFlush) {
+                DecryptPayload(audioPacket);
                 IRepairable* repairable = iRepairableAllocator.Allocate(audioPacket);
                 try {
                     iRepairer.OutputAudio(*repairable);
@@ -571,6 +572,11 @@ ProtocolGetResult ProtocolRaop::Get(IWriter& /*aWriter*/, const Brx& /*aUri*/, T
     return EProtocolGetErrorNotSupported;
 }
 
+void ProtocolRaop::WriteInfo(IWriter& aWriter)
+{
+    iServerManager.WriteInfo(aWriter);
+}
+
 void ProtocolRaop::Reset()
 {
     AutoMutex a(iLockRaop);
@@ -678,8 +684,22 @@ void ProtocolRaop::OutputAudio(const Brx& aAudio)
         iSupply->OutputDelay(Delay(latency));
     }
 
-    iAudioDecryptor.Decrypt(aAudio, iAudioDecrypted);
-    iSupply->OutputData(iAudioDecrypted);
+    // CodecRaopApple expects each (already decrypted) packet to be prefixed by its size
+    Bws<kPacketSizeBytes> packetSize;
+    WriterBuffer writerBuffer(packetSize);
+    WriterBinary writerBinary(writerBuffer);
+    writerBinary.WriteUint32Be(aAudio.Bytes());
+    iSupply->OutputData(packetSize);
+    iSupply->OutputData(aAudio);
+}
+
+void ProtocolRaop::DecryptPayload(const RaopPacketAudio& aPacket)
+{
+    // Payload always refers to one of our own receive buffers so is safe to decrypt in place
+    const Brx& payload = aPacket.Payload();
+    Bwn payloadW(payload.Ptr(), payload.Bytes());
+    payloadW.SetBytes(payload.Bytes());
+    iAudioDecryptor.Decrypt(payloadW);
 }
 
 void ProtocolRaop::OutputDiscontinuity()
@@ -795,6 +815,7 @@ void ProtocolRaop::NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStar
 void ProtocolRaop::ResendReceive(const RaopPacketResendResponse& aPacket)
 {
     LOG(kMedia, ">ProtocolRaop::ResendReceive timestamp: %u, seq: %u\n", aPacket.AudioPacket().Timestamp(), aPacket.AudioPacket().Header().Seq());
+    DecryptPayload(aPacket.AudioPacket());
     IRepairable* repairable = iRepairableAllocator.Allocate(aPacket);
     try {
         iRepairer.OutputAudio(*repairable);
@@ -1007,7 +1028,7 @@ void RaopResendRangeRequester::RequestResendSequences(const std::vector<const IR
     for (auto range : aRanges) {
         const TUint start = range->Start();
         const TUint end = range->End();
-        const TUint count = (end-start)+1;  // +1 to include start packet.
+        const TUint count = ((end-start) & 0xffff)+1;  // +1 to include start packet. Mask as range may span a seq no wrap.
         LOG(kMedia, " %d->%d", start, end);
         iResendRequester.RequestResend(start, count);
     }
@@ -1146,35 +1167,45 @@ void RaopAudioServer::ReadPacket(Bwx& aBuf)
 
 // RaopAudioDecryptor
 
+RaopAudioDecryptor::RaopAudioDecryptor()
+    : iLock("RADL")
+    , iCtx(EVP_CIPHER_CTX_new())
+    , iInitialised(false)
+{
+    ASSERT(iCtx != nullptr);
+}
+
+RaopAudioDecryptor::~RaopAudioDecryptor()
+{
+    EVP_CIPHER_CTX_free(iCtx);
+}
+
 void RaopAudioDecryptor::Init(const Brx& aAesKey, const Brx& aAesInitVector)
 {
-    iKey.Replace(aAesKey);
+    ASSERT(aAesKey.Bytes() == kAesKeyBytes);
+    AutoMutex _(iLock);
     iInitVector.Replace(aAesInitVector);
+    ASSERT(iInitVector.Bytes() == kAesInitVectorBytes);
+    const TInt ok = EVP_DecryptInit_ex(iCtx, EVP_aes_128_cbc(), nullptr, aAesKey.Ptr(), iInitVector.Ptr());
+    ASSERT(ok == 1);
+    (void)EVP_CIPHER_CTX_set_padding(iCtx, 0); // payloads aren't padded; any partial block is left unencrypted
+    iInitialised = true;
 }
 
-void RaopAudioDecryptor::Decrypt(const Brx& aEncryptedIn, Bwx& aAudioOut) const
+void RaopAudioDecryptor::Decrypt(Bwx& aPayload)
 {
-    //LOG(kMedia, ">RaopAudioDecryptor::Decrypt aEncryptedIn.Bytes(): %u\n", aEncryptedIn.Bytes());
-    ASSERT(iKey.Bytes() > 0);
-    ASSERT(iInitVector.Bytes() > 0);
-    ASSERT(aAudioOut.MaxBytes() >= kPacketSizeBytes+aEncryptedIn.Bytes());
-
-    aAudioOut.SetBytes(0);
-    WriterBuffer writerBuffer(aAudioOut);
-    WriterBinary writerBinary(writerBuffer);
-    writerBinary.WriteUint32Be(aEncryptedIn.Bytes());    // Write out payload size.
-
-    unsigned char* inBuf = const_cast<unsigned char*>(aEncryptedIn.Ptr());
-    unsigned char* outBuf = const_cast<unsigned char*>(aAudioOut.Ptr()+aAudioOut.Bytes());
-    unsigned char initVector[16];
-    memcpy(initVector, iInitVector.Ptr(), sizeof(initVector));  // Use same initVector at start of each decryption block.
-
-    AES_cbc_encrypt(inBuf, outBuf, aEncryptedIn.Bytes(), (AES_KEY*)iKey.Ptr(), initVector, AES_DECRYPT);
-    const TUint audioRemaining = aEncryptedIn.Bytes() % 16;
-    const TUint audioWritten = aEncryptedIn.Bytes()-audioRemaining;
-    if (audioRemaining > 0) {
-        // Copy remaining audio to outBuf if <16 bytes.
-        memcpy(outBuf+audioWritten, inBuf+audioWritten, audioRemaining);
+    const TUint blockBytes = aPayload.Bytes() - (aPayload.Bytes() % kAesInitVectorBytes);
+    if (blockBytes == 0) {
+        return;
     }
-    aAudioOut.SetBytes(kPacketSizeBytes+aEncryptedIn.Bytes());
+    AutoMutex _(iLock);
+    ASSERT(iInitialised);
+    // Every packet restarts from the session IV.  Passing no cipher or key keeps the existing key schedule.
+    TInt ok = EVP_DecryptInit_ex(iCtx, nullptr, nullptr, nullptr, iInitVector.Ptr());
+    ASSERT(ok == 1);
+    unsigned char* ptr = const_cast<unsigned char*>(aPayload.Ptr());
+    TInt bytesOut = 0;
+    ok = EVP_DecryptUpdate(iCtx, ptr, &bytesOut, ptr, (TInt)blockBytes);
+    ASSERT(ok == 1);
+    ASSERT(bytesOut == (TInt)blockBytes);
 }
@@ -2,14 +2,17 @@
 
 #include <OpenHome/Media/Protocol/Protocol.h>
 #include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
 #include <OpenHome/Private/Network.h>
 #include <OpenHome/Private/Thread.h>
 #include <OpenHome/Private/Timer.h>
 #include <OpenHome/Media/SupplyAggregator.h>
 #include <OpenHome/Media/Debug.h>
+#include <OpenHome/Av/Utils/ResendPacer.h>
+#include <OpenHome/Av/Utils/SequenceRepairBuffer.h>
 
 #include  <openssl/rsa.h>
-#include  <openssl/aes.h>
+#include  <openssl/evp.h>
 
 EXCEPTION(InvalidRaopPacket)
 EXCEPTION(RepairerBufferFull)
@@ -159,21 +162,31 @@ private:
     TBool iOpen;
 };
 
-// FIXME - this class currently writes out the packet length at the start of decoded audio.
-// That shouldn't be a responsibility of a generic decryptor.
-// Maybe have a chain of elements that write into the same buffer (i.e., one element to write the packet length at the start, then pass onto decryptor to decrypt the audio into the buffer).
-class RaopAudioDecryptor
+/*
+ * Decrypts AirPlay audio payloads in place.
+ *
+ * Each packet is a separate AES-128-CBC chain starting from the session's IV, with any
+ * trailing partial block sent unencrypted.  The key schedule is set up once per session and
+ * the cipher context reused so decrypting a packet only resets the IV before running the
+ * cipher (via EVP, so AES-NI or ARMv8 crypto extensions are used where available).
+ *
+ * Audio and resent packets arrive on different threads so calls are serialised internally.
+ */
+class RaopAudioDecryptor : private INonCopyable
 {
-private:
-    static const TUint kAesKeyBytes = sizeof(AES_KEY);
+public:
+    static const TUint kAesKeyBytes = 16;
     static const TUint kAesInitVectorBytes = 16;
-    static const TUint kPacketSizeBytes = sizeof(TUint);
 public:
+    RaopAudioDecryptor();
+    ~RaopAudioDecryptor();
     void Init(const Brx& aAesKey, const Brx& aAesInitVector);
-    void Decrypt(const Brx& aEncryptedIn, Bwx& aAudioOut) const;
+    void Decrypt(Bwx& aPayload);
 private:
-    Bws<kAesKeyBytes> iKey;
+    Mutex iLock;
+    EVP_CIPHER_CTX* iCtx;
     Bws<kAesInitVectorBytes> iInitVector;
+    TBool iInitialised;
 };
 
 class IRaopResendReceiver
@@ -414,109 +427,89 @@ private:
     TUint iEnd;
 };
 
-template <TUint MaxFrames> class Repairer
+/*
+ * Reorders audio packets and requests resends of any that are missing.
+ *
+ * Packets that arrive ahead of a gap are held in a SequenceRepairBuffer of MaxFrames packets.
+ * Each time the repair timer fires, up to MaxRanges runs of missing packets are requested.
+ * Timeouts follow the round trip time measured from those requests (see ResendPacer).
+ *
+ * If a packet arrives too far ahead to fit in the buffer, the oldest gaps are given up on
+ * (and the packets held after them output) until it fits.  RepairerBufferFull is only thrown
+ * if a packet couldn't fit even with every gap given up on, implying that the sender skipped
+ * ahead.
+ */
+template <TUint MaxFrames, TUint MaxRanges> class Repairer
 {
-private:
-    static const TUint kMaxMissedRanges = MaxFrames/2;
-    static const TUint kInitialRepairTimeoutMs = 10;
-    static const TUint kSubsequentRepairTimeoutMs = 30;
 public:
     Repairer(Environment& aEnv, IResendRangeRequester& aResendRequester, IAudioSupply& aAudioSupply, IRepairerTimer& aTimer);
     ~Repairer();
     void OutputAudio(IRepairable& aRepairable);  // THROWS RepairerBufferFull, RepairerStreamRestarted
     void DropAudio();
 private:
-    TBool RepairBegin(IRepairable& aRepairable);
+    typedef SequenceRepairBuffer<IRepairable, MaxFrames, 16> RepairBuffer; // RAOP seq no is 16-bit uint.
+private:
     void RepairReset();
-    TBool Repair(IRepairable& aRepairable);
+    void DestroyBuffered();
+    void Repair(IRepairable& aRepairable);
+    void Restart(IRepairable& aRepairable);
+    void PopReady();
     void TimerRepairExpired();
 private:
     Environment& iEnv;
     IResendRangeRequester& iResendRequester;
     IAudioSupply& iAudioSupply;
     IRepairerTimer& iTimer;
-    IRepairable* iRepairFirst;
-    std::vector<IRepairable*> iRepairFrames;
+    RepairBuffer iRepairBuffer;
+    ResendPacer iResendPacer;
     std::vector<IRepairable*> iOutput;
-    std::vector<ResendRange*> iResend;              // Ranges to be requested.
+    ResendRange iResend[MaxRanges];                 // Ranges to be requested.
     std::vector<const IResendRange*> iResendConst;  // Populated at same time as iResend, and used to pass immutable resend list to resend requester.
-    FifoLite<ResendRange*, kMaxMissedRanges> iFifoResend;
     TBool iRunning;
     TBool iRepairing;
-    TUint16 iFrame;     // RAOP seq no is 16-bit uint.
     Mutex iMutexTransport;
     Mutex iMutexAudioOutput;
 };
 
 // Repairer
 
-template <TUint MaxFrames> Repairer<MaxFrames>::Repairer(Environment& aEnv, IResendRangeRequester& aResendRequester, IAudioSupply& aAudioSupply, IRepairerTimer& aTimer)
+template <TUint MaxFrames, TUint MaxRanges> Repairer<MaxFrames, MaxRanges>::Repairer(Environment& aEnv, IResendRangeRequester& aResendRequester, IAudioSupply& aAudioSupply, IRepairerTimer& aTimer)
     : iEnv(aEnv)
     , iResendRequester(aResendRequester)
     , iAudioSupply(aAudioSupply)
     , iTimer(aTimer)
-    , iRepairFirst(nullptr)
     , iRunning(false)
     , iRepairing(false)
-    , iFrame(0)
     , iMutexTransport("REPL")
     , iMutexAudioOutput("REAO")
 {
-    for (TUint i=0; i<kMaxMissedRanges; i++) {
-        iFifoResend.Write(new ResendRange());
-    }
+    iOutput.reserve(MaxFrames + 1);
+    iResendConst.reserve(MaxRanges);
 }
 
-template <TUint MaxFrames> Repairer<MaxFrames>::~Repairer()
+template <TUint MaxFrames, TUint MaxRanges> Repairer<MaxFrames, MaxRanges>::~Repairer()
 {
     iTimer.Cancel();
-    ASSERT(iFifoResend.SlotsFree() == 0);
-    while (iFifoResend.SlotsUsed() > 0) {
-        auto resend = iFifoResend.Read();
-        delete resend;
-    }
+    DestroyBuffered();
 }
 
-template <TUint MaxFrames> void Repairer<MaxFrames>::OutputAudio(IRepairable& aRepairable)
+template <TUint MaxFrames, TUint MaxRanges> void Repairer<MaxFrames, MaxRanges>::OutputAudio(IRepairable& aRepairable)
 {
     // Must only be held by this method to protect iOutput.
     AutoMutex ao(iMutexAudioOutput);
 
     {
         AutoMutex a(iMutexTransport);
+        if (aRepairable.Resend()) {
+            iResendPacer.NotifyResent(aRepairable.Frame(), OsTimeInUs(iEnv.OsCtx()));
+        }
         if (!iRunning) {
-            iFrame = static_cast<TUint16>(aRepairable.Frame());
+            iRepairBuffer.SetLast(aRepairable.Frame());
             iRunning = true;
             iOutput.push_back(&aRepairable);
         }
-        if (iRepairing) {
-            iRepairing = Repair(aRepairable);
-        }
-
-        // The above code may result in audio being pushed into iOutput.
-        // If that's the case, aRepairable was incorporated into messages to be
-        // output, so don't want to enter the code blocks below.
-        if (!iRepairing && iOutput.size() == 0) {
-
-            const TInt16 diff = static_cast<TUint16>(aRepairable.Frame()) - iFrame;
-            if (diff == 1) {
-                iFrame++;
-                iOutput.push_back(&aRepairable);
-            }
-            else if (diff < 1) {
-                if (!aRepairable.Resend()) {
-                    LOG(kMedia, "Repairer::OutputAudio RepairerStreamRestarted frame: %u, resend: %u\n", aRepairable.Frame(), aRepairable.Resend());
-                    // A frame in the past that is not a resend implies that the sender has reset their frame count
-                    aRepairable.Destroy();
-                    // accept the next received frame as the start of a new stream
-                    iRunning = false;
-                    THROW(RepairerStreamRestarted);
-                }
-                aRepairable.Destroy();
-            }
-            else {
-                iRepairing = RepairBegin(aRepairable);
-            }
+        else {
+            Repair(aRepairable);
         }
     }
 
@@ -524,7 +517,7 @@ template <TUint MaxFrames> void Repairer<MaxFrames>::OutputAudio(IRepairable& aR
     // in case this class receives an interrupt of some form (such as DropAudio()).
     if (iOutput.size() > 0) {
         for (auto* repairable : iOutput) {
-            //LOG(kMedia, "Repairer<MaxFrames>::OutputAudio %u\n", repairable->Frame());
+            //LOG(kMedia, "Repairer::OutputAudio %u\n", repairable->Frame());
             iAudioSupply.OutputAudio(repairable->Data());
             repairable->Destroy();
         }
@@ -532,21 +525,13 @@ template <TUint MaxFrames> void Repairer<MaxFrames>::OutputAudio(IRepairable& aR
     }
 }
 
-template <TUint MaxFrames> void Repairer<MaxFrames>::DropAudio()
+template <TUint MaxFrames, TUint MaxRanges> void Repairer<MaxFrames, MaxRanges>::DropAudio()
 {
     AutoMutex a(iMutexTransport);
     RepairReset();
 }
 
-template <TUint MaxFrames> TBool Repairer<MaxFrames>::RepairBegin(IRepairable& aRepairable)
-{
-    LOG(kMedia, "Repairer::RepairBegin BEGIN ON %d\n", aRepairable.Frame());
-    iRepairFirst = &aRepairable;
-    iTimer.Start(MakeFunctor(*this, &Repairer<MaxFrames>::TimerRepairExpired), iEnv.Random(kInitialRepairTimeoutMs));
-    return true;
-}
-
-template <TUint MaxFrames> void Repairer<MaxFrames>::RepairReset()
+template <TUint MaxFrames, TUint MaxRanges> void Repairer<MaxFrames, MaxRanges>::RepairReset()
 {
     LOG(kMedia, "Repairer::RepairReset RESET\n");
     /* TimerRepairExpired() claims iMutexTransport.  Release it briefly to avoid possible deadlock.
@@ -554,188 +539,109 @@ template <TUint MaxFrames> void Repairer<MaxFrames>::RepairReset()
     iMutexTransport.Signal();
     iTimer.Cancel();
     iMutexTransport.Wait();
-    if (iRepairFirst != nullptr) {
-        iRepairFirst->Destroy();
-        iRepairFirst = nullptr;
-    }
-    for (TUint i=0; i<iRepairFrames.size(); i++) {
-        iRepairFrames[i]->Destroy();
-    }
-    iRepairFrames.clear();
+    DestroyBuffered();
     iRunning = false;
     iRepairing = false;
 }
 
-template <TUint MaxFrames> TBool Repairer<MaxFrames>::Repair(IRepairable& aRepairable)
-{
-    // get the incoming frame number
-    const TUint16 frame = static_cast<TUint16>(aRepairable.Frame());
-    LOG(kMedia, "Repairer::Repair GOT %d\n", frame);
-
-    // get difference between this and the last frame sent down the pipeline
-    TInt16 diff = frame - iFrame;
-    if (diff < 1) {
-        TBool repairing = true;
-        if (!aRepairable.Resend()) {
-            // A frame in the past that is not a resend implies that the sender has reset their frame count
-            RepairReset();
-            repairing = false;
-            LOG(kMedia, "Repairer::OutputAudio Repair frame: %u, resend: %u\n", aRepairable.Frame(), aRepairable.Resend());
-            aRepairable.Destroy();
-            THROW(RepairerStreamRestarted);
-        }
-        // incoming frames is equal to or earlier than the last frame sent down the pipeline
-        // in other words, it's a duplicate, so discard it and continue
-        aRepairable.Destroy();
-        return repairing;
-    }
-    if (diff == 1) {
-        // incoming frame is one greater than the last frame sent down the pipeline, so send this ...
-        iFrame++;
-        iOutput.push_back(&aRepairable);
-        // ... and see if the current first waiting frame is now also ready to be sent
-        while (static_cast<TUint16>(iRepairFirst->Frame()) == static_cast<TUint16>(iFrame + 1)) {
-            // ... yes, it is, so send it
-            iFrame++;
-            iOutput.push_back(iRepairFirst);
-            // ... and see if there are further messages waiting
-            if (iRepairFrames.size() == 0) {
-                // ... no, so we have completed the repair
-                iRepairFirst = nullptr;
-                LOG(kMedia, "END\n");
-                return false;
-            }
-            // ... yes, so update the current first waiting frame and continue testing to see if this can also be sent
-            iRepairFirst = iRepairFrames[0];
-            iRepairFrames.erase(iRepairFrames.begin());
-        }
-        // ... we're done
-        return true;
+template <TUint MaxFrames, TUint MaxRanges> void Repairer<MaxFrames, MaxRanges>::DestroyBuffered()
+{
+    while (!iRepairBuffer.Empty()) {
+        iRepairBuffer.SkipGap();
+        iRepairBuffer.Pop()->Destroy();
     }
+}
 
-    // Ok, its a frame that needs to be put into the backlog, but where?
-    // compare it to the current first waiting frame
-    diff = frame - static_cast<TUint16>(iRepairFirst->Frame());
-    if (diff == 0) {
-        // it's equal to the currently first waiting frame, so discard it - it's a duplicate
-        aRepairable.Destroy();
-        return true;
-    }
-    if (diff < 0) {
-        // it's earlier than the current first waiting message, so it should become the new current first waiting frame
-        // and the old first waiting frame needs to be injected into the start of the backlog, so inject it into the end
-        // and rotate the others (if there is space to add another frame)
-        if (iRepairFrames.size() == MaxFrames) {
-            // can't fit another frame into the backlog
-            RepairReset();
-            aRepairable.Destroy();
+template <TUint MaxFrames, TUint MaxRanges> void Repairer<MaxFrames, MaxRanges>::Repair(IRepairable& aRepairable)
+{
+    // must be called with iMutexTransport held
+    const TUint frame = aRepairable.Frame();
+    auto res = iRepairBuffer.Insert(aRepairable, frame);
+    while (res == RepairBuffer::eTooFar) {
+        if (RepairBuffer::Diff(frame, iRepairBuffer.Newest()) > static_cast<TInt>(MaxFrames)) {
+            // can't fit even if we give up on every gap; the sender must have skipped ahead
+            LOG(kMedia, "Repairer::Repair RepairerBufferFull frame: %u, last: %u\n", frame, iRepairBuffer.Last());
+            Restart(aRepairable);
             THROW(RepairerBufferFull);
         }
-        iRepairFrames.insert(iRepairFrames.begin(), iRepairFirst);
-        iRepairFirst = &aRepairable;
-        return true;
+        // give up on the oldest gap, rather than everything we've buffered, until this frame fits
+        iRepairBuffer.SkipGap();
+        LOG(kMedia, "Repairer::Repair ABANDON BEFORE %u\n", iRepairBuffer.Next());
+        PopReady();
+        res = iRepairBuffer.Insert(aRepairable, frame);
     }
-    // ok, it's after the currently first waiting frame, so it needs to go into the backlog
-    // first check if the backlog is empty
-    if (iRepairFrames.size() == 0) {
-        // ... yes, so just inject it
-        iRepairFrames.insert(iRepairFrames.begin(), &aRepairable);
-        return true;
+
+    if (res == RepairBuffer::eLate && !aRepairable.Resend()) {
+        // A frame in the past that is not a resend implies that the sender has reset their frame count
+        LOG(kMedia, "Repairer::Repair RepairerStreamRestarted frame: %u, resend: %u\n", frame, aRepairable.Resend());
+        Restart(aRepairable);
+        THROW(RepairerStreamRestarted);
     }
-    // ok, so the backlog is not empty
-    // is it a duplicate of the last frame in the backlog?
-    diff = frame - static_cast<TUint16>(iRepairFrames[iRepairFrames.size()-1]->Frame());
-    if (diff == 0) {
-        // ... yes, so discard
+    if (res == RepairBuffer::eStored) {
+        PopReady();
+    }
+    else {
+        // a duplicate, or a resend we no longer need
         aRepairable.Destroy();
-        return true;
     }
-    // is the incoming frame later than the last one currently in the backlog?
-    if (diff > 0) {
-        // ... yes, so, again, just inject it (if there is space)
-        if (iRepairFrames.size() == MaxFrames) {
-            // can't fit another frame into the backlog
-            RepairReset();
-            aRepairable.Destroy();
-            THROW(RepairerBufferFull);
+
+    if (iRepairBuffer.Empty()) {
+        if (iRepairing) {
+            LOG(kMedia, "Repairer::Repair END\n");
+            iRepairing = false;
         }
-        iRepairFrames.push_back(&aRepairable);
-        return true;
     }
-    // ... no, so it has to go somewhere in the middle of the backlog, so iterate through and inject it at the right place (if there is space)
-    TUint count = iRepairFrames.size();
-    for (auto it = iRepairFrames.begin(); it != iRepairFrames.end(); ++it) {
-        diff = frame - static_cast<TUint16>((*it)->Frame());
-        if (diff > 0) {
-            continue;
-        }
-        if (diff == 0) {
-            aRepairable.Destroy();
-        }
-        else {
-            if (count == MaxFrames) {
-                // can't fit another frame into the backlog
-                aRepairable.Destroy();
-                RepairReset();
-                THROW(RepairerBufferFull);
-            }
-            iRepairFrames.insert(it, &aRepairable);
-        }
-        break;
+    else if (!iRepairing) {
+        LOG(kMedia, "Repairer::Repair BEGIN ON %u\n", frame);
+        iRepairing = true;
+        iTimer.Start(MakeFunctor(*this, &Repairer<MaxFrames, MaxRanges>::TimerRepairExpired), iEnv.Random(iResendPacer.InitialTimeoutMs()));
+    }
+}
+
+template <TUint MaxFrames, TUint MaxRanges> void Repairer<MaxFrames, MaxRanges>::Restart(IRepairable& aRepairable)
+{
+    if (iRepairing) {
+        RepairReset();
     }
+    aRepairable.Destroy();
+    // accept the next received frame as the start of a new stream
+    iRunning = false;
+}
 
-    return true;
+template <TUint MaxFrames, TUint MaxRanges> void Repairer<MaxFrames, MaxRanges>::PopReady()
+{
+    IRepairable* repairable;
+    while ((repairable = iRepairBuffer.Pop()) != nullptr) {
+        iOutput.push_back(repairable);
+    }
 }
 
-template <TUint MaxFrames> void Repairer<MaxFrames>::TimerRepairExpired()
+template <TUint MaxFrames, TUint MaxRanges> void Repairer<MaxFrames, MaxRanges>::TimerRepairExpired()
 {
     AutoMutex a(iMutexTransport);
     if (iRepairing) {
         LOG(kMedia, ">Repairer::TimerRepairExpired REQUEST RESEND");
 
-        TUint rangeCount = 0;
-        TUint16 start = iFrame + 1;
-        TUint16 end = static_cast<TUint16>(iRepairFirst->Frame());
-
-        // phase 1 - request the frames between the last sent down the pipeline and the first waiting frame
-        ResendRange* range = iFifoResend.Read();
-        range->Set(start, end-1);
-        iResend.push_back(range);
-        iResendConst.push_back(range);
-        rangeCount++;
-
-
-        // phase 2 - if there is room add the missing frames in the backlog
-        for (TUint i=0; rangeCount < kMaxMissedRanges && i < iRepairFrames.size(); i++) {
-            IRepairable* repairable = iRepairFrames[i];
-            start = end + 1;
-            end = static_cast<TUint16>(repairable->Frame());
-
-            if (end-start > 0) {
-                ResendRange* range = iFifoResend.Read();
-                range->Set(start, end-1);
-                iResend.push_back(range);
-                iResendConst.push_back(range);
-
-                LOG(kMedia, " %d-%d", start, end);
-                if (++rangeCount == kMaxMissedRanges) {
-                    break;
-                }
-            }
-
+        // request each run of missing frames, oldest first, as a single range
+        TUint count = 0;
+        TUint from = iRepairBuffer.Next();
+        TUint start, end;
+        while (count < MaxRanges && iRepairBuffer.FindMissing(from, start, end)) {
+            ResendRange& range = iResend[count++];
+            range.Set(start, end);
+            iResendConst.push_back(&range);
+            LOG(kMedia, " %u-%u", start, end);
+            from = end + 1;
         }
         LOG(kMedia, "\n");
 
-        iResendRequester.RequestResendSequences(iResendConst);
-
-        for (auto repairable : iResend) {
-            repairable->Set(0, 0);
-            iFifoResend.Write(repairable);
+        if (count > 0) {
+            iResendPacer.NotifyRequested(iResend[0].Start(), OsTimeInUs(iEnv.OsCtx()));
+            iResendRequester.RequestResendSequences(iResendConst);
+            iResendConst.clear();
         }
-        iResend.clear();
-        iResendConst.clear();
 
-        iTimer.Start(MakeFunctor(*this, &Repairer<MaxFrames>::TimerRepairExpired), kSubsequentRepairTimeoutMs);
+        iTimer.Start(MakeFunctor(*this, &Repairer<MaxFrames, MaxRanges>::TimerRepairExpired), iResendPacer.TimeoutMs());
     }
 }
 
@@ -752,8 +658,10 @@ class ProtocolRaop : public Media::Protocol, public IRaopResendReceiver, public
 private:
     static const TUint kSampleRate = 44100;     // Always 44.1KHz. Can get this from fmtp field.
     static const TUint kMaxFrameBytes = 2048;
-    static const TUint kMaxRepairFrames = 50;
+    static const TUint kMaxRepairFrames = 64;    // must be a power of two
+    static const TUint kMaxRepairRanges = kMaxRepairFrames/2;
     static const TUint kMinDelayChangeSamples = 441; // Require min change of 10 ms at 44.1KHz to cause delay value to be updated/output.
+    static const TUint kPacketSizeBytes = sizeof(TUint32);
 public:
     ProtocolRaop(Environment& aEnv, Media::TrackFactory& aTrackFactory, IRaopDiscovery& aDiscovery, UdpServerManager& aServerManager, TUint aAudioId, TUint aControlId);
     ~ProtocolRaop();
@@ -763,6 +671,7 @@ private: // from Protocol
     void Initialise(Media::MsgFactory& aMsgFactory, Media::IPipelineElementDownstream& aDownstream) override;
     Media::ProtocolStreamResult Stream(const Brx& aUri) override;
     Media::ProtocolGetResult Get(IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes) override;
+    void WriteInfo(IWriter& aWriter) override;
 private: // from IStreamHandler
     TUint TryStop(TUint aStreamId) override;
     void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
@@ -777,6 +686,7 @@ private:
     TBool IsValidSession(TUint aSessionId) const;
     TBool ShouldFlush(TUint aSeq, TUint aTimestamp) const;
     //void OutputAudio(const Brx& aAudio);
+    void DecryptPayload(const RaopPacketAudio& aPacket);
     void OutputDiscontinuity();
     void OutputContainer(const Brx& aFmtp);
     void DoInterrupt();
@@ -798,7 +708,6 @@ private:
     // thread.
     UdpServerManager& iServerManager;
     Bws<RtpPacketRaop::kMaxPacketBytes> iPacketBuf;
-    Bws<RtpPacketRaop::kMaxPacketBytes> iAudioDecrypted;
     RaopAudioDecryptor iAudioDecryptor;
     RaopAudioServer iAudioServer;
     RaopControlServer iControlServer;
@@ -821,11 +730,13 @@ private:
     mutable Mutex iLockRaop;
     Semaphore iSemDrain;
 
-    // +3 as must be able to cause repairer to overflow (which requires kMaxRepairFrames+2), plus could be sending from normal audio channel and control channel simultaneously.
+    // Repairer holds at most kMaxRepairFrames-1 frames (the frame after its last output is always missing while
+    // any are held), plus one being inserted from the audio channel and one resend allocated by the control
+    // channel at the same time.  That's kMaxRepairFrames+1; +3 leaves some margin.
     RaopRepairableAllocator<kMaxRepairFrames+3,kMaxFrameBytes> iRepairableAllocator;
     RaopResendRangeRequester iResendRangeRequester;
     RepairerTimer iRepairerTimer;
-    Repairer<kMaxRepairFrames> iRepairer;
+    Repairer<kMaxRepairFrames, kMaxRepairRanges> iRepairer;
 };
 
 };  // namespace Av
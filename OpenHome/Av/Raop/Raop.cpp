@@ -700,10 +700,9 @@ void RaopDiscoverySession::DecryptAeskey()
     Brn rsaaeskey(iSdpInfo.Rsaaeskey());
     unsigned char aeskey[128];
     TInt res = RSA_private_decrypt(rsaaeskey.Bytes(), rsaaeskey.Ptr(), aeskey, iRsa, RSA_PKCS1_OAEP_PADDING);
-    if(res > 0) {
-        AES_KEY key;
-        AES_set_decrypt_key(aeskey, 128, &key);
-        iAeskey.Replace((const TByte* )&key, sizeof(AES_KEY));
+    if(res >= (TInt)kAesKeyBytes) {
+        // Raw key; ProtocolRaop sets up its own key schedule
+        iAeskey.Replace(aeskey, kAesKeyBytes);
         iAeskeyPresent = true;
         iAesSid++;
     }
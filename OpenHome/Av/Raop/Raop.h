@@ -11,7 +11,6 @@
 #include <OpenHome/Media/Pipeline/Attenuator.h>
 
 #include  <openssl/rsa.h>
-#include  <openssl/aes.h>
 
 EXCEPTION(RaopError);
 EXCEPTION(RaopVolumeInvalid);
@@ -184,6 +183,7 @@ private:
     void DeactivateCallback();
 private:
     static const TUint kMaxPortNumBytes = 5;
+    static const TUint kAesKeyBytes = 16; // AES-128
     Srx* iReaderBuffer;
     ReaderUntil* iReaderUntil;
     ReaderProtocol* iReaderProtocol;
@@ -199,7 +199,7 @@ private:
     HeaderCSeq iHeaderCSeq;
     HeaderRtpInfo iHeaderRtpInfo;
     Media::SdpInfo iSdpInfo;
-    Bws<sizeof(AES_KEY)> iAeskey;
+    Bws<kAesKeyBytes> iAeskey;
     TBool iAeskeyPresent;
     TUint iAesSid;
     RSA *iRsa;
@@ -103,6 +103,8 @@ SourceRaop::SourceRaop(IMediaPlayer& aMediaPlayer, UriProviderRaop& aUriProvider
     SocketUdpServer& serverAudio = iServerManager.Find(iAudioId);
     SocketUdpServer& serverControl = iServerManager.Find(iControlId);
     SocketUdpServer& serverTiming = iServerManager.Find(iTimingId);    // never Open() this
+    serverAudio.SetRecvBufBytes(kUdpRecvBufBytes);
+    serverControl.SetRecvBufBytes(kUdpRecvBufBytes);
     iRaopDiscovery->SetListeningPorts(serverAudio.Port(), serverControl.Port(), serverTiming.Port());
 
     NetworkAdapterList& adapterList = iEnv.NetworkAdapterList();
@@ -61,7 +61,8 @@ private:
     void SessionStartThread();
 private:
     static const TUint kMaxUdpSize = 1472;
-    static const TUint kMaxUdpPackets = 25;
+    static const TUint kMaxUdpPackets = 64;             // ~0.5s of audio; absorbs bursts as Wi-Fi wakes from power save
+    static const TUint kUdpRecvBufBytes = 128 * 1024;
     static const TUint kRaopPrefixBytes = 7;
     static const TUint kMaxPortBytes = 5; // 0-65535
     static const TUint kMaxUriBytes = kRaopPrefixBytes+kMaxPortBytes*2+1;   // raop://xxxxx.yyyyy
@@ -2,6 +2,9 @@
 #include <OpenHome/Private/Env.h>
 #include <OpenHome/Private/NetworkAdapterList.h>
 #include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Media/Debug.h>
+#include <OpenHome/OsWrapper.h>
 
 using namespace OpenHome;
 using namespace Av;
@@ -10,12 +13,20 @@ using namespace Av;
 // MsgUdp
 
 MsgUdp::MsgUdp(TUint aMaxSize)
-    : iBuf(aMaxSize)
+    : iStorage(new TByte[aMaxSize])
+    , iBuf(iStorage, aMaxSize)
+{
+}
+
+MsgUdp::MsgUdp(TByte* aPtr, TUint aMaxSize)
+    : iStorage(nullptr)
+    , iBuf(aPtr, aMaxSize)
 {
 }
 
 MsgUdp::~MsgUdp()
 {
+    delete[] iStorage;
 }
 
 void MsgUdp::Read(SocketUdp& aSocket)
@@ -34,6 +45,89 @@ Endpoint& MsgUdp::Endpoint()
 }
 
 
+// UdpPacketRing
+
+UdpPacketRing::UdpPacketRing(TUint aMaxSize, TUint aMaxPackets)
+    : iMsgs(aMaxPackets + 1)
+    , iTimesUs(aMaxPackets + 1)
+    , iReadIndex(0)
+    , iWriteIndex(0)
+{
+    ASSERT(aMaxPackets > 0);
+    ASSERT(iReadIndex.is_lock_free());
+    // one slot more than can be queued; the writer always owns the slot at iWriteIndex
+    iStorage = new TByte[aMaxSize * iMsgs.size()];
+    for (size_t i=0; i<iMsgs.size(); i++) {
+        iMsgs[i] = new MsgUdp(iStorage + i*aMaxSize, aMaxSize);
+    }
+}
+
+UdpPacketRing::~UdpPacketRing()
+{
+    for (size_t i=0; i<iMsgs.size(); i++) {
+        delete iMsgs[i];
+    }
+    delete[] iStorage;
+}
+
+TUint UdpPacketRing::Slots() const
+{
+    return (TUint)iMsgs.size() - 1;
+}
+
+TUint UdpPacketRing::SlotsUsed() const
+{
+    const TUint read = iReadIndex.load(std::memory_order_acquire);
+    const TUint write = iWriteIndex.load(std::memory_order_acquire);
+    const TUint size = (TUint)iMsgs.size();
+    return (write + size - read) % size;
+}
+
+MsgUdp& UdpPacketRing::WriteSlot()
+{
+    return *iMsgs[iWriteIndex.load(std::memory_order_relaxed)];
+}
+
+TBool UdpPacketRing::TryWriteCommit(TUint64 aTimeUs)
+{
+    const TUint write = iWriteIndex.load(std::memory_order_relaxed);
+    const TUint next = Next(write);
+    if (next == iReadIndex.load(std::memory_order_acquire)) {
+        return false;
+    }
+    iTimesUs[write] = aTimeUs;
+    iWriteIndex.store(next, std::memory_order_release);
+    return true;
+}
+
+MsgUdp* UdpPacketRing::TryRead(TUint64& aTimeUs)
+{
+    const TUint read = iReadIndex.load(std::memory_order_relaxed);
+    if (read == iWriteIndex.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    aTimeUs = iTimesUs[read];
+    return iMsgs[read];
+}
+
+void UdpPacketRing::ReadCommit()
+{
+    const TUint read = iReadIndex.load(std::memory_order_relaxed);
+    ASSERT(read != iWriteIndex.load(std::memory_order_acquire));
+    iReadIndex.store(Next(read), std::memory_order_release);
+}
+
+void UdpPacketRing::Clear()
+{
+    iReadIndex.store(iWriteIndex.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+TUint UdpPacketRing::Next(TUint aIndex) const
+{
+    return (aIndex + 1 == iMsgs.size()? 0 : aIndex + 1);
+}
+
+
 // SocketUdpServer
 
 SocketUdpServer::SocketUdpServer(Environment& aEnv, TUint aMaxSize, TUint aMaxPackets, TUint aThreadPriority, TUint aPort, TIpAddress aInterface)
@@ -41,21 +135,22 @@ SocketUdpServer::SocketUdpServer(Environment& aEnv, TUint aMaxSize, TUint aMaxPa
     , iSocket(aEnv, aPort, aInterface)
     , iMaxSize(aMaxSize)
     , iOpen(false)
-    , iFifoWaiting(aMaxPackets)
-    , iFifoReady(aMaxPackets)
+    , iRing(aMaxSize, aMaxPackets)
     , iLock("UDPL")
     , iReadyLock("UDPR")
+    , iReaderWaiting(false)
+    , iReaderInterrupted(false)
+    , iSemaphoreReady("UDPW", 0)
+    , iStatsLock("UDPT")
+    , iStats()
+    , iLatencySamples(0)
+    , iLatencyTotalUs(0)
     , iSemaphore("UDPS", 0)
     , iSemaphoreOpen("UDPO", 0)
     , iQuit(false)
     , iAdapterListenerId(0)
     , iRebindPosted(false)
 {
-    // Populate iFifoWaiting with empty packets/bufs
-    while (iFifoWaiting.SlotsFree() > 0) {
-        iFifoWaiting.Write(new MsgUdp(iMaxSize));
-    }
-
     iDiscard = new MsgUdp(iMaxSize);
 
     iServerThread = new ThreadFunctor("UdpServer", MakeFunctor(*this, &SocketUdpServer::ServerThread), aThreadPriority);
@@ -85,24 +180,12 @@ SocketUdpServer::~SocketUdpServer()
     iLock.Signal();
 
     iSocket.Interrupt(true);
-    iFifoReady.ReadInterrupt(true);
+    InterruptReader();
 
     delete iServerThread;
 
-    iReadyLock.Wait();
-    iFifoReady.ReadInterrupt(false); // Clear read interrupt so that FIFO can be emptied.
-    while (iFifoReady.SlotsUsed() > 0) {
-        MsgUdp* msg = iFifoReady.Read();
-        delete msg;
-    }
+    iReadyLock.Wait(); // wait for any reader to leave Receive()
     iReadyLock.Signal();
-
-    iFifoWaiting.ReadInterrupt(false); // Clear read interrupt so that FIFO can be emptied.
-    while (iFifoWaiting.SlotsUsed() > 0) {
-        MsgUdp* msg = iFifoWaiting.Read();
-        delete msg;
-    }
-
     delete iDiscard;
 }
 
@@ -138,11 +221,16 @@ void SocketUdpServer::Close()
     iOpen = false;
 
     iSocket.Interrupt(true);
-    iFifoReady.ReadInterrupt(true);
+    InterruptReader(); // cleared by ServerThread once the ring is emptied
 
     iLock.Signal();
 
     iSemaphore.Wait();
+
+    Stats stats;
+    GetStats(stats);
+    LOG(kMedia, "SocketUdpServer::Close port %u: received %u, discarded %u, overflows %u, max queued %u, latency avg %uus max %uus\n",
+                iSocket.Port(), stats.iReceived, stats.iDiscarded, stats.iOverflows, stats.iMaxQueued, stats.iLatencyAvgUs, stats.iLatencyMaxUs);
 }
 
 TBool SocketUdpServer::IsOpen()
@@ -182,28 +270,39 @@ Endpoint SocketUdpServer::Receive(Bwx& aBuf)
 
     iLock.Signal();
 
-    // Get data from msg
-    try {
-        iReadyLock.Wait();
-        MsgUdp* msg = iFifoReady.Read(); // will block until msg available
-        iReadyLock.Signal();
+    AutoMutex _(iReadyLock);
+    for (;;) {
+        // Clear any wakeup left over from an earlier wait before checking for packets.
+        // The writer only signals after seeing iReaderWaiting so can't be lost here.
+        (void)iSemaphoreReady.Clear();
+        iReaderWaiting.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with fence in ServerThread
+        if (iReaderInterrupted.load()) {
+            iReaderWaiting.store(false);
+            THROW(ReaderError);
+        }
+        TUint64 receivedUs;
+        MsgUdp* msg = iRing.TryRead(receivedUs);
+        if (msg == nullptr) {
+            iSemaphoreReady.Wait();
+            continue;
+        }
+        iReaderWaiting.store(false);
 
         Endpoint ep;
         CopyMsgToBuf(*msg, aBuf, ep);
-
-        // Requeue msg
-        iLock.Wait();
-
-        iFifoWaiting.Write(msg);
-
-        iLock.Signal();
-
+        iRing.ReadCommit();
+
+        const TUint64 now = OsTimeInUs(iEnv.OsCtx());
+        const TUint latencyUs = (now > receivedUs? static_cast<TUint>(now - receivedUs) : 0);
+        AutoMutex __(iStatsLock);
+        iLatencySamples++;
+        iLatencyTotalUs += latencyUs;
+        if (latencyUs > iStats.iLatencyMaxUs) {
+            iStats.iLatencyMaxUs = latencyUs;
+        }
         return ep;
     }
-    catch (FifoReadError&) {
-        iReadyLock.Signal();
-        THROW(ReaderError);
-    }
 }
 
 Endpoint SocketUdpServer::Sender() const
@@ -217,6 +316,37 @@ TUint SocketUdpServer::Port() const
     return iSocket.Port();
 }
 
+void SocketUdpServer::GetStats(Stats& aStats) const
+{
+    AutoMutex _(iStatsLock);
+    aStats = iStats;
+    aStats.iLatencyAvgUs = (iLatencySamples == 0? 0 : static_cast<TUint>(iLatencyTotalUs / iLatencySamples));
+}
+
+void SocketUdpServer::WriteInfo(IWriter& aWriter) const
+{
+    Stats stats;
+    GetStats(stats);
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("    UDP port "));
+    writer.WriteUint(iSocket.Port());
+    writer.Write(Brn(" received:"));
+    writer.WriteUint(stats.iReceived);
+    writer.Write(Brn(", discarded:"));
+    writer.WriteUint(stats.iDiscarded);
+    writer.Write(Brn(", overflows:"));
+    writer.WriteUint(stats.iOverflows);
+    writer.Write(Brn(", max queued:"));
+    writer.WriteUint(stats.iMaxQueued);
+    writer.Write(Brn("/"));
+    writer.WriteUint(iRing.Slots());
+    writer.Write(Brn(", latency avg:"));
+    writer.WriteUint(stats.iLatencyAvgUs);
+    writer.Write(Brn("us max:"));
+    writer.WriteUint(stats.iLatencyMaxUs);
+    writer.Write(Brn("us\n"));
+}
+
 void SocketUdpServer::SetSendBufBytes(TUint aBytes)
 {
     iSocket.SetSendBufBytes(aBytes);
@@ -256,13 +386,13 @@ void SocketUdpServer::ReadFlush()
 
 void SocketUdpServer::ReadInterrupt()
 {
-    // Clients read from iFifoReady - never iSocket, so interrupt any waiting
-    // Read()s on the FIFO.
+    // Clients read from iRing - never iSocket, so interrupt any waiting
+    // Read()s on the ring.
 
-    iFifoReady.ReadInterrupt(true);
+    InterruptReader();
 
     iReadyLock.Wait();
-    iFifoReady.ReadInterrupt(false);
+    iReaderInterrupted.store(false);
     iReadyLock.Signal();
 }
 
@@ -274,6 +404,12 @@ void SocketUdpServer::CopyMsgToBuf(MsgUdp& aMsg, Bwx& aBuf, Endpoint& aEndpoint)
     aEndpoint.Replace(aMsg.Endpoint());
 }
 
+void SocketUdpServer::InterruptReader()
+{
+    iReaderInterrupted.store(true);
+    iSemaphoreReady.Signal();
+}
+
 void SocketUdpServer::ServerThread()
 {
     iSemaphore.Signal();
@@ -303,7 +439,10 @@ void SocketUdpServer::ServerThread()
             }
             catch (NetworkError&) {
                 CheckRebind();
+                continue;
             }
+            AutoMutex _(iStatsLock);
+            iStats.iDiscarded++;
         }
 
         iSocket.Interrupt(false);
@@ -327,32 +466,39 @@ void SocketUdpServer::ServerThread()
 
             iLock.Signal();
 
+            // Receive directly into the ring.  If readers have fallen a full ring behind
+            // the packet is dropped and its slot reused for the next one.
             try {
-                iDiscard->Read(iSocket);
+                iRing.WriteSlot().Read(iSocket);
             }
             catch (NetworkError&) {
                 CheckRebind();
                 continue;
             }
 
-            if (iFifoWaiting.SlotsUsed() == 0) {
-                continue;
+            const TBool queued = iRing.TryWriteCommit(OsTimeInUs(iEnv.OsCtx()));
+            std::atomic_thread_fence(std::memory_order_seq_cst); // publish packet before checking for a waiting reader
+            if (queued && iReaderWaiting.exchange(false)) {
+                // a burst of packets only costs the reader a single wakeup
+                iSemaphoreReady.Signal();
+            }
+            const TUint used = iRing.SlotsUsed();
+            AutoMutex _(iStatsLock);
+            if (!queued) {
+                iStats.iOverflows++;
+            }
+            else {
+                iStats.iReceived++;
+                if (used > iStats.iMaxQueued) {
+                    iStats.iMaxQueued = used;
+                }
             }
-
-            iFifoReady.Write(iDiscard);
-            iDiscard = iFifoWaiting.Read();
         }
 
         iReadyLock.Wait();
-        iFifoReady.ReadInterrupt(false);
-        // Move all messages from ready queue back to waiting queue
-
-        while (iFifoReady.SlotsUsed() > 0) {
-            MsgUdp* msg = iFifoReady.Read();
-            iFifoWaiting.Write(msg);
-        }
-
-        iFifoReady.ReadInterrupt(false);
+        // Discard all messages not yet read
+        iRing.Clear();
+        iReaderInterrupted.store(false);
         iReadyLock.Signal();
 
         iSocket.Interrupt(false);
@@ -457,3 +603,11 @@ void UdpServerManager::OpenAll()
         iServers[i]->Open();
     }
 }
+
+void UdpServerManager::WriteInfo(IWriter& aWriter)
+{
+    AutoMutex a(iLock);
+    for (size_t i=0; i<iServers.size(); i++) {
+        iServers[i]->WriteInfo(aWriter);
+    }
+}
@@ -1,7 +1,10 @@
 #pragma once
 
-#include <OpenHome/Private/Fifo.h>
 #include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Thread.h>
+
+#include <atomic>
+#include <vector>
 
 EXCEPTION(UdpServerClosed);
 
@@ -15,21 +18,66 @@ class MsgUdp
 {
 public:
     MsgUdp(TUint aMaxSize);
+    MsgUdp(TByte* aPtr, TUint aMaxSize); // uses, but doesn't take ownership of, aPtr
     ~MsgUdp();
     void Read(SocketUdp& aSocket);
     const Brx& Buffer();
     OpenHome::Endpoint& Endpoint();
 private:
-    Bwh iBuf;
+    TByte* iStorage;
+    Bwn iBuf;
     OpenHome::Endpoint iEndpoint;
 };
 
+/**
+ * Fixed ring of packets, all allocated from a single block when constructed.
+ *
+ * Intended for exactly one writer thread, which receives directly into WriteSlot(),
+ * and one reader thread.  Neither side blocks or takes a lock.  The writer always owns
+ * one slot so can keep receiving (and so discarding) packets when the ring is full.
+ *
+ * Clear() moves the read index so must not overlap a reader.  SocketUdpServer calls it from
+ * its writer thread, between packets, while holding the lock that serialises readers.
+ */
+class UdpPacketRing : private INonCopyable
+{
+public:
+    UdpPacketRing(TUint aMaxSize, TUint aMaxPackets);
+    ~UdpPacketRing();
+    TUint Slots() const;
+    TUint SlotsUsed() const;                   // exact from writer or reader thread, a snapshot from anywhere else
+    MsgUdp& WriteSlot();                       // writer only.  Not visible to the reader until committed
+    TBool TryWriteCommit(TUint64 aTimeUs);     // writer only.  Returns false if the ring is full
+    MsgUdp* TryRead(TUint64& aTimeUs);         // reader only.  Returns nullptr if the ring is empty
+    void ReadCommit();                         // reader only.  Releases the packet returned by TryRead()
+    void Clear();                              // reader, or writer between commits while no reader is active
+private:
+    TUint Next(TUint aIndex) const;
+private:
+    TByte* iStorage;
+    std::vector<MsgUdp*> iMsgs;
+    std::vector<TUint64> iTimesUs;
+    std::atomic<TUint> iReadIndex;
+    std::atomic<TUint> iWriteIndex;
+};
+
 /**
  * Class for a continuously running server which buffers packets while active
  * and discards packets when deactivated
  */
 class SocketUdpServer : public IReaderSource
 {
+public:
+    class Stats
+    {
+    public:
+        TUint iReceived;        // packets queued for readers
+        TUint iDiscarded;       // packets received while closed
+        TUint iOverflows;       // packets dropped as readers had fallen a full ring behind
+        TUint iMaxQueued;
+        TUint iLatencyAvgUs;    // time between a packet being received and read
+        TUint iLatencyMaxUs;
+    };
 public:
     SocketUdpServer(Environment& aEnv, TUint aMaxSize, TUint aMaxPackets, TUint aThreadPriority, TUint aPort, TIpAddress aInterface);
     ~SocketUdpServer();
@@ -42,6 +90,8 @@ public:
     Endpoint Receive(Bwx& aBuf);
     Endpoint Sender() const; // sender of last completed Read()
     TUint Port() const;
+    void GetStats(Stats& aStats) const;
+    void WriteInfo(IWriter& aWriter) const;
 
     void SetSendBufBytes(TUint aBytes);
     void SetRecvBufBytes(TUint aBytes);
@@ -53,6 +103,7 @@ public: // from IReaderSource
     void ReadInterrupt() override;
 private:
     static void CopyMsgToBuf(MsgUdp& aMsg, Bwx& aBuf, Endpoint& aEndpoint);
+    void InterruptReader();
     void ServerThread();
     void CurrentAdapterChanged();
     struct RebindJob {
@@ -67,12 +118,18 @@ private:
     SocketUdp iSocket;
     TUint iMaxSize;
     TBool iOpen;
-    Fifo<MsgUdp*> iFifoWaiting;
-    Fifo<MsgUdp*> iFifoReady;
+    UdpPacketRing iRing;
     MsgUdp* iDiscard;
     Endpoint iSender;
     mutable Mutex iLock;
-    Mutex iReadyLock;
+    Mutex iReadyLock;       // serialises readers, so the ring only ever sees one at a time
+    std::atomic<TBool> iReaderWaiting;
+    std::atomic<TBool> iReaderInterrupted;
+    Semaphore iSemaphoreReady;
+    mutable Mutex iStatsLock;
+    Stats iStats;
+    TUint iLatencySamples;
+    TUint64 iLatencyTotalUs;
     Semaphore iSemaphore;
     Semaphore iSemaphoreOpen;
     ThreadFunctor* iServerThread;
@@ -95,6 +152,7 @@ public:
     SocketUdpServer& Find(TUint aId); // find server by ID
     void CloseAll();
     void OpenAll();
+    void WriteInfo(IWriter& aWriter);
 private:
     std::vector<SocketUdpServer*> iServers;
     Environment& iEnv;
@@ -0,0 +1,195 @@
+#include <OpenHome/Av/Songcast/ClockPullerSongcast.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Debug.h>
+#include <OpenHome/Av/Debug.h>
+#include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+using namespace OpenHome::Media;
+
+// Loop gains.  Buffer level error is measured in microseconds of audio.
+// Proportional and integral gains give a critically damped loop with a time constant of ~40s.
+static const double kProportionalPpmPerUs = 0.05;
+static const double kIntegralPpmPerUs = 0.000625;
+// Fraction of each timestamp-derived frequency error applied to the integrator.
+static const double kTimestampGain = 0.5;
+// Timestamp windows implying a larger error than this are assumed to be glitches (e.g. a sender restart).
+static const double kMaxTimestampErrorPpm = 4.0 * ClockPullerSongcast::kMaxPullPpm;
+
+ClockPullerSongcast::ClockPullerSongcast(IPullableClock& aPullableClock)
+    : iPullableClock(aPullableClock)
+    , iLock("CPSC")
+    , iRunning(false)
+    , iOccupancy(0)
+    , iMultiplier(IPullableClock::kNominalFreq)
+    , iSampleRate(0)
+{
+    ResetLoopLocked();
+    ResetTimestampsLocked();
+}
+
+TInt ClockPullerSongcast::PullPpm() const
+{
+    AutoMutex _(iLock);
+    return static_cast<TInt>(std::lround(iPull));
+}
+
+void ClockPullerSongcast::Update(TInt aDelta)
+{
+    AutoMutex _(iLock);
+    iOccupancy += aDelta;
+    if (!iRunning) {
+        return;
+    }
+    iOccupancySum += iOccupancy;
+    iOccupancySamples++;
+    if (aDelta < 0) {
+        iConsumed += -aDelta;
+    }
+    if (iConsumed < Jiffies::kPerSecond) {
+        return;
+    }
+
+    const TInt64 level = iOccupancySum / iOccupancySamples;
+    const double errorUs = static_cast<double>(level - iTarget) * 1000000.0 / Jiffies::kPerSecond;
+    iConsumed -= Jiffies::kPerSecond;
+    iOccupancySum = 0;
+    iOccupancySamples = 0;
+    iLoopSecs++;
+
+    const double maxPpm = static_cast<double>(kMaxPullPpm);
+    iIntegral = std::max(-maxPpm, std::min(maxPpm, iIntegral + kIntegralPpmPerUs * errorUs));
+    iPull = std::max(-maxPpm, std::min(maxPpm, iIntegral + kProportionalPpmPerUs * errorUs));
+    PullLocked();
+}
+
+void ClockPullerSongcast::Start()
+{
+    AutoMutex _(iLock);
+    ResetLoopLocked();
+    ResetTimestampsLocked();
+    iTarget = iOccupancy;
+    iRunning = true;
+    LOG(kSongcast, "ClockPullerSongcast::Start() target=%dms\n", static_cast<TInt>(iTarget / Jiffies::kPerMs));
+}
+
+void ClockPullerSongcast::Stop()
+{
+    AutoMutex _(iLock);
+    if (!iRunning) {
+        return;
+    }
+    iRunning = false;
+    ResetLoopLocked();
+    ResetTimestampsLocked();
+    PullLocked();
+}
+
+void ClockPullerSongcast::Reset()
+{
+    AutoMutex _(iLock);
+    ResetTimestampsLocked();
+}
+
+void ClockPullerSongcast::NotifyTimestamp(TUint aNetworkTimestamp, TUint aRxTimestamp, TUint aSampleRate)
+{
+    AutoMutex _(iLock);
+    if (!iRunning) {
+        return;
+    }
+    if (aSampleRate != iSampleRate) {
+        ResetTimestampsLocked();
+        iSampleRate = aSampleRate;
+    }
+    const TUint offset = aRxTimestamp - aNetworkTimestamp;
+    if (!iTimestampValid) {
+        iTimestampValid = true;
+        iOffsetBase = offset;
+        iWindowStart = aRxTimestamp;
+    }
+    iWindowMinOffset = std::min(iWindowMinOffset, static_cast<TInt>(offset - iOffsetBase));
+
+    const TUint windowTicks = Jiffies::SongcastTicksPerSecond(iSampleRate) * kTimestampWindowSecs;
+    const TUint elapsed = aRxTimestamp - iWindowStart;
+    if (elapsed < windowTicks) {
+        return;
+    }
+    if (elapsed >= 2 * windowTicks) {
+        // we've missed (or the rx timestamper has jumped over) a whole window; start again
+        ResetTimestampsLocked();
+        return;
+    }
+    TBool useWindow = true;
+    if (iPrevMinOffsetValid) {
+        // the local clock running fast relative to the sender's shows up as a growing offset
+        const double errorPpm = -static_cast<double>(iWindowMinOffset - iPrevMinOffset) * 1000000.0 / elapsed;
+        if (std::fabs(errorPpm) > kMaxTimestampErrorPpm) {
+            // this window straddles a discontinuity so its minimum isn't a reliable reference for the next one either
+            LOG(kSongcast, "ClockPullerSongcast - ignoring timestamp window (%dppm)\n", static_cast<TInt>(errorPpm));
+            useWindow = false;
+        }
+        else {
+            const double maxPpm = static_cast<double>(kMaxPullPpm);
+            const double correction = kTimestampGain * errorPpm;
+            iIntegral = std::max(-maxPpm, std::min(maxPpm, iIntegral + correction));
+            iPull = std::max(-maxPpm, std::min(maxPpm, iPull + correction));
+            iTimestampLocked = true;
+            PullLocked();
+        }
+    }
+    iPrevMinOffset = iWindowMinOffset;
+    iPrevMinOffsetValid = useWindow;
+    iWindowMinOffset = INT_MAX;
+    iWindowStart = aRxTimestamp;
+}
+
+TBool ClockPullerSongcast::TryGetDriftPpm(TInt& aPpm) const
+{
+    AutoMutex _(iLock);
+    if (!iRunning || (!iTimestampLocked && iLoopSecs < kMinDriftEstimateSecs)) {
+        return false;
+    }
+    aPpm = static_cast<TInt>(std::lround(iIntegral));
+    return true;
+}
+
+void ClockPullerSongcast::ResetLoopLocked()
+{
+    iTarget = 0;
+    iOccupancySum = 0;
+    iOccupancySamples = 0;
+    iConsumed = 0;
+    iIntegral = 0;
+    iPull = 0;
+    iLoopSecs = 0;
+    iTimestampLocked = false;
+}
+
+void ClockPullerSongcast::ResetTimestampsLocked()
+{
+    iTimestampValid = false;
+    iOffsetBase = 0;
+    iWindowStart = 0;
+    iWindowMinOffset = INT_MAX;
+    iPrevMinOffsetValid = false;
+    iPrevMinOffset = 0;
+}
+
+void ClockPullerSongcast::PullLocked()
+{
+    const TInt64 delta = static_cast<TInt64>(std::llround(iPull * IPullableClock::kNominalFreq / 1000000.0));
+    const TUint multiplier = static_cast<TUint>(static_cast<TInt64>(IPullableClock::kNominalFreq) + delta);
+    if (multiplier != iMultiplier) {
+        iMultiplier = multiplier;
+        LOG(kSongcast, "ClockPullerSongcast - pull %dppm (multiplier %08x)\n", static_cast<TInt>(std::lround(iPull)), iMultiplier);
+        iPullableClock.PullClock(iMultiplier);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/ClockPuller.h>
+
+namespace OpenHome {
+namespace Av {
+
+/*
+ * Clock puller for Songcast receivers.
+ *
+ * Drift between sender and receiver clocks shows up as the pipeline's buffered audio slowly
+ * growing or shrinking.  A PI loop, evaluated once per second of audio played, pulls the local
+ * clock so that the (averaged) buffer level returns to the level it had when playback started.
+ *
+ * If the receiver has an rx timestamper, sender/receiver timestamp pairs give a more direct
+ * measure of the residual frequency error.  The minimum offset between the two clocks is tracked
+ * over long windows (rejecting network queuing jitter) and the change in that offset between
+ * windows is fed into the loop's integrator.  This lets the loop lock faster, with the buffer
+ * level term still correcting any remaining offset.
+ */
+class ClockPullerSongcast : public Media::IClockPuller, public Media::IClockPullerTimestamp
+{
+public:
+    static const TUint kMaxPullPpm = 1000;
+    static const TUint kTimestampWindowSecs = 10;
+    static const TUint kMinDriftEstimateSecs = 2 * kTimestampWindowSecs; // before this, the loop alone won't have locked
+public:
+    ClockPullerSongcast(Media::IPullableClock& aPullableClock);
+    TInt PullPpm() const;
+private: // from Media::IPipelineBufferObserver
+    void Update(TInt aDelta) override;
+private: // from Media::IClockPuller
+    void Start() override;
+    void Stop() override;
+private: // from Media::IClockPullerTimestamp
+    void Reset() override;
+    void NotifyTimestamp(TUint aNetworkTimestamp, TUint aRxTimestamp, TUint aSampleRate) override;
+    TBool TryGetDriftPpm(TInt& aPpm) const override;
+private:
+    void ResetLoopLocked();
+    void ResetTimestampsLocked();
+    void PullLocked();
+private:
+    Media::IPullableClock& iPullableClock;
+    mutable Mutex iLock;
+    TBool iRunning;
+    TInt64 iOccupancy;      // jiffies
+    TInt64 iTarget;         // jiffies
+    TInt64 iOccupancySum;   // jiffies, since last loop evaluation
+    TUint iOccupancySamples;
+    TUint64 iConsumed;      // jiffies, since last loop evaluation
+    double iIntegral;       // ppm; the loop's estimate of drift
+    TUint iLoopSecs;        // loop evaluations since Start()
+    TBool iTimestampLocked; // a timestamp window has corrected iIntegral since Start()
+    double iPull;           // ppm
+    TUint iMultiplier;
+    TBool iTimestampValid;
+    TUint iSampleRate;
+    TUint iOffsetBase;
+    TUint iWindowStart;     // rx ticks
+    TInt iWindowMinOffset;
+    TBool iPrevMinOffsetValid;
+    TInt iPrevMinOffset;
+};
+
+} // namespace Av
+} // namespace OpenHome
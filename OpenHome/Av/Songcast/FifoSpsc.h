@@ -0,0 +1,87 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+#include <atomic>
+#include <vector>
+
+namespace OpenHome {
+namespace Av {
+
+/*
+ * Bounded fifo for exactly one writer thread and one reader thread.
+ * TryWrite and TryRead never block or take a lock so are safe to call from time critical threads.
+ * Callers are responsible for any waiting/signalling when the fifo is full or empty.
+ */
+template <class T>
+class FifoSpsc : private INonCopyable
+{
+public:
+    FifoSpsc(TUint aMaxSlots);
+    TUint Slots() const;
+    TUint SlotsUsed() const; // exact from writer or reader thread, a snapshot from anywhere else
+    TBool TryWrite(T aEntry); // writer thread only.  Returns false if the fifo is full
+    TBool TryRead(T& aEntry); // reader thread only.  Returns false if the fifo is empty
+private:
+    TUint Next(TUint aIndex) const;
+private:
+    std::vector<T> iEntries; // one unused slot distinguishes full from empty
+    std::atomic<TUint> iReadIndex;
+    std::atomic<TUint> iWriteIndex;
+};
+
+// FifoSpsc
+
+template <class T> FifoSpsc<T>::FifoSpsc(TUint aMaxSlots)
+    : iEntries(aMaxSlots + 1)
+    , iReadIndex(0)
+    , iWriteIndex(0)
+{
+    ASSERT(aMaxSlots > 0);
+    ASSERT(iReadIndex.is_lock_free());
+}
+
+template <class T> TUint FifoSpsc<T>::Slots() const
+{
+    return (TUint)iEntries.size() - 1;
+}
+
+template <class T> TUint FifoSpsc<T>::SlotsUsed() const
+{
+    const TUint read = iReadIndex.load(std::memory_order_acquire);
+    const TUint write = iWriteIndex.load(std::memory_order_acquire);
+    const TUint size = (TUint)iEntries.size();
+    return (write + size - read) % size;
+}
+
+template <class T> TBool FifoSpsc<T>::TryWrite(T aEntry)
+{
+    const TUint write = iWriteIndex.load(std::memory_order_relaxed);
+    const TUint next = Next(write);
+    if (next == iReadIndex.load(std::memory_order_acquire)) {
+        return false;
+    }
+    iEntries[write] = aEntry;
+    iWriteIndex.store(next, std::memory_order_release);
+    return true;
+}
+
+template <class T> TBool FifoSpsc<T>::TryRead(T& aEntry)
+{
+    const TUint read = iReadIndex.load(std::memory_order_relaxed);
+    if (read == iWriteIndex.load(std::memory_order_acquire)) {
+        return false;
+    }
+    aEntry = iEntries[read];
+    iReadIndex.store(Next(read), std::memory_order_release);
+    return true;
+}
+
+template <class T> TUint FifoSpsc<T>::Next(TUint aIndex) const
+{
+    return (aIndex + 1 == iEntries.size()? 0 : aIndex + 1);
+}
+
+} // namespace Av
+} // namespace OpenHome
@@ -32,7 +32,7 @@ void OhmHeader::Internalise(IReader& aReader)
         THROW(OhmError);
     }
     iMsgType  = reader.ReadUintBe(1);
-    if(iMsgType > kMsgTypeResend && iMsgType != kMsgTypeAudioBlob) {
+    if(iMsgType > kMsgTypeParity && iMsgType != kMsgTypeAudioBlob) {
         THROW(OhmError);
     }
     iBytes = reader.ReadUintBe(2);
@@ -271,6 +271,38 @@ void OhmHeaderMetatext::Externalise(IWriter& aWriter) const
     writer.WriteUint32Be(iMetatextBytes);
 }
     
+// OhmHeaderJoin
+
+OhmHeaderJoin::OhmHeaderJoin()
+    : iCapabilities(0)
+{
+}
+
+OhmHeaderJoin::OhmHeaderJoin(TUint aCapabilities)
+    : iCapabilities(aCapabilities)
+{
+}
+
+void OhmHeaderJoin::Internalise(IReader& aReader, const OhmHeader& aHeader)
+{
+    ASSERT (aHeader.MsgType() == OhmHeader::kMsgTypeJoin || aHeader.MsgType() == OhmHeader::kMsgTypeListen);
+
+    iCapabilities = 0;
+    if (aHeader.MsgBytes() >= kHeaderBytes) {
+        ReaderBinary readerBinary(aReader);
+        iCapabilities = readerBinary.ReadUintBe(4);
+    }
+}
+
+void OhmHeaderJoin::Externalise(IWriter& aWriter) const
+{
+    WriterBinary writer(aWriter);
+
+    writer.WriteUint32Be(iCapabilities);
+}
+
+
+
 // OhmHeaderSlave
 
 OhmHeaderSlave::OhmHeaderSlave()
@@ -329,6 +361,50 @@ void OhmHeaderResend::Externalise(IWriter& aWriter) const
     
     
 
+// OhmHeaderParity
+
+OhmHeaderParity::OhmHeaderParity()
+    : iFirstFrame(0)
+    , iFrameCount(0)
+    , iFrameBytesXor(0)
+    , iParityBytes(0)
+{
+}
+
+OhmHeaderParity::OhmHeaderParity(TUint aFirstFrame, TUint aFrameCount, TUint aFrameBytesXor, TUint aParityBytes)
+    : iFirstFrame(aFirstFrame)
+    , iFrameCount(aFrameCount)
+    , iFrameBytesXor(aFrameBytesXor)
+    , iParityBytes(aParityBytes)
+{
+}
+
+void OhmHeaderParity::Internalise(IReader& aReader, const OhmHeader& aHeader)
+{
+    ASSERT (aHeader.MsgType() == OhmHeader::kMsgTypeParity);
+    if (aHeader.MsgBytes() < kHeaderBytes) {
+        THROW(OhmError);
+    }
+
+    ReaderBinary readerBinary(aReader);
+
+    iFirstFrame = readerBinary.ReadUintBe(4);
+    iFrameCount = readerBinary.ReadUintBe(2);
+    iFrameBytesXor = readerBinary.ReadUintBe(2);
+    iParityBytes = aHeader.MsgBytes() - kHeaderBytes;
+}
+
+void OhmHeaderParity::Externalise(IWriter& aWriter) const
+{
+    WriterBinary writer(aWriter);
+
+    writer.WriteUint32Be(iFirstFrame);
+    writer.WriteUint16Be(iFrameCount);
+    writer.WriteUint16Be(iFrameBytesXor);
+}
+
+
+
 ////////////////////////////////////////////////////////
 // OHZ Protocol                        
     
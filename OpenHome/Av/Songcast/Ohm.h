@@ -38,6 +38,7 @@ public:
     static const TUint kMsgTypeMetatext = 5;
     static const TUint kMsgTypeSlave = 6;
     static const TUint kMsgTypeResend = 7;
+    static const TUint kMsgTypeParity = 8; // only sent to receivers advertising OhmHeaderJoin::kCapabilityFec
     static const TUint kMsgTypeAudioBlob = 255; // locally generated, is never sent over the network
 
 public:
@@ -214,10 +215,37 @@ private:
     TUint iMetatextBytes;
 };
 
+class OhmHeaderJoin // also used for Listen
+{
+public:
+    static const TUint kHeaderBytes = 4;
+    static const TUint kCapabilityLossless = 1 << 0; // receiver can decode OhmMsgAudio::kFlagCompressed frames
+    static const TUint kCapabilityFec      = 1 << 1; // receiver can handle OhmHeader::kMsgTypeParity
+    static const TUint kCapabilitySlaves   = 1 << 2; // receiver can forward to OhmHeaderSlave::kMaxSlaveCount slaves
+
+public:
+    OhmHeaderJoin();
+    OhmHeaderJoin(TUint aCapabilities);
+
+    void Internalise(IReader& aReader, const OhmHeader& aHeader);
+    void Externalise(IWriter& aWriter) const;
+
+    TUint Capabilities() const {return iCapabilities;}
+    TUint MsgBytes() const {return kHeaderBytes;}
+
+private:
+    //Offset    Bytes                   Desc
+    //0         4                       Capabilities (absent - and so zero - for older receivers)
+
+    TUint iCapabilities;
+};
+
 class OhmHeaderSlave
 {
 public:
     static const TUint kHeaderBytes = 4;
+    static const TUint kMaxSlaveCount = 32;
+    static const TUint kMaxSlaveCountLegacy = 4; // receivers not advertising OhmHeaderJoin::kCapabilitySlaves
 
 public:
     OhmHeaderSlave();
@@ -260,6 +288,37 @@ private:
     TUint iFramesCount;
 };
 
+class OhmHeaderParity
+{
+public:
+    static const TUint kHeaderBytes = 8;
+
+public:
+    OhmHeaderParity();
+    OhmHeaderParity(TUint aFirstFrame, TUint aFrameCount, TUint aFrameBytesXor, TUint aParityBytes);
+
+    void Internalise(IReader& aReader, const OhmHeader& aHeader);
+    void Externalise(IWriter& aWriter) const;
+
+    TUint FirstFrame() const {return iFirstFrame;}
+    TUint FrameCount() const {return iFrameCount;}
+    TUint FrameBytesXor() const {return iFrameBytesXor;}
+    TUint ParityBytes() const {return iParityBytes;}
+    TUint MsgBytes() const {return (kHeaderBytes + iParityBytes);}
+
+private:
+    //Offset    Bytes                   Desc
+    //0         4                       First frame (f)
+    //4         2                       Frame count (n)
+    //6         2                       XOR of the total bytes of audio msgs f..f+n-1
+    //8         m                       XOR of audio msgs f..f+n-1 (each zero padded to m bytes)
+
+    TUint iFirstFrame;
+    TUint iFrameCount;
+    TUint iFrameBytesXor;
+    TUint iParityBytes;
+};
+
 class OhzHeader
 {
 public:
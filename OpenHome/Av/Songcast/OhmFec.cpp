@@ -0,0 +1,244 @@
+#include <OpenHome/Av/Songcast/OhmFec.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Converter.h>
+#include <OpenHome/Av/Songcast/Ohm.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+
+#include <algorithm>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+static const TUint kOffsetAudioHeaderBytes = OhmHeader::kHeaderBytes;
+static const TUint kOffsetAudioFlags = OhmHeader::kHeaderBytes + 1;
+static const TUint kOffsetAudioFrame = OhmHeader::kHeaderBytes + 4;
+
+// OhmFecGroup
+
+OhmFecGroup::OhmFecGroup()
+{
+    Reset(0, 0);
+}
+
+void OhmFecGroup::Reset(TUint aFirstFrame, TUint aFrameCount)
+{
+    ASSERT(aFrameCount <= kMaxFrames);
+    iFirstFrame = aFirstFrame;
+    iFrameCount = aFrameCount;
+    iAddedMask = 0;
+    iFramesAdded = 0;
+    iBytesXor = 0;
+    iXor.SetBytes(0);
+}
+
+TBool OhmFecGroup::Contains(TUint aFrame) const
+{
+    return (aFrame - iFirstFrame) < iFrameCount;
+}
+
+TBool OhmFecGroup::Add(TUint aFrame, const Brx& aMsg)
+{
+    if (!Contains(aFrame) || aMsg.Bytes() > kMaxFrameBytes) {
+        return false;
+    }
+    const TUint bit = 1u << (aFrame - iFirstFrame);
+    if ((iAddedMask & bit) != 0) {
+        return false;
+    }
+    iAddedMask |= bit;
+    iFramesAdded++;
+    iBytesXor ^= aMsg.Bytes();
+
+    const TUint bytes = aMsg.Bytes();
+    while (iXor.Bytes() < bytes) { // zero pad
+        iXor.Append((TByte)0);
+    }
+    const TByte* src = aMsg.Ptr();
+    for (TUint i=0; i<bytes; i++) {
+        iXor[i] ^= src[i];
+    }
+    if (bytes > kOffsetAudioFlags) {
+        iXor[kOffsetAudioFlags] ^= (src[kOffsetAudioFlags] & OhmMsgAudio::kFlagResent);
+    }
+    return true;
+}
+
+TUint OhmFecGroup::FirstFrame() const
+{
+    return iFirstFrame;
+}
+
+TUint OhmFecGroup::FrameCount() const
+{
+    return iFrameCount;
+}
+
+TUint OhmFecGroup::FramesAdded() const
+{
+    return iFramesAdded;
+}
+
+TBool OhmFecGroup::Complete() const
+{
+    return iFrameCount > 0 && iFramesAdded == iFrameCount;
+}
+
+TUint OhmFecGroup::MissingFrame() const
+{
+    ASSERT(iFramesAdded + 1 == iFrameCount);
+    for (TUint i=0; i<iFrameCount; i++) {
+        if ((iAddedMask & (1u << i)) == 0) {
+            return iFirstFrame + i;
+        }
+    }
+    ASSERTS();
+    return 0;
+}
+
+TUint OhmFecGroup::BytesXor() const
+{
+    return iBytesXor;
+}
+
+const Brx& OhmFecGroup::Xor() const
+{
+    return iXor;
+}
+
+
+// OhmFecEncoder
+
+OhmFecEncoder::OhmFecEncoder()
+    : iGroupFrames(0)
+{
+}
+
+void OhmFecEncoder::SetGroupFrames(TUint aGroupFrames)
+{
+    ASSERT(aGroupFrames <= OhmFecGroup::kMaxFrames);
+    iGroupFrames = aGroupFrames;
+    Reset();
+}
+
+TUint OhmFecEncoder::GroupFrames() const
+{
+    return iGroupFrames;
+}
+
+void OhmFecEncoder::Reset()
+{
+    iGroup.Reset(0, 0);
+    iParity.SetBytes(0);
+}
+
+TBool OhmFecEncoder::Add(TUint aFrame, const Brx& aMsg)
+{
+    if (iGroupFrames == 0) {
+        return false;
+    }
+    if (aFrame % iGroupFrames == 0) {
+        iGroup.Reset(aFrame, iGroupFrames);
+    }
+    else if (iGroup.FirstFrame() + iGroup.FramesAdded() != aFrame) {
+        // started mid-group or skipped a frame; wait for the next group boundary
+        iGroup.Reset(0, 0);
+        return false;
+    }
+    if (!iGroup.Add(aFrame, aMsg) || !iGroup.Complete()) {
+        return false;
+    }
+
+    const Brx& parity = iGroup.Xor();
+    OhmHeaderParity headerParity(iGroup.FirstFrame(), iGroup.FrameCount(), iGroup.BytesXor() & 0xffff, parity.Bytes());
+    OhmHeader header(OhmHeader::kMsgTypeParity, headerParity.MsgBytes());
+    iParity.SetBytes(0);
+    WriterBuffer writer(iParity);
+    header.Externalise(writer);
+    headerParity.Externalise(writer);
+    writer.Write(parity);
+    iGroup.Reset(0, 0);
+    return true;
+}
+
+const Brx& OhmFecEncoder::Parity() const
+{
+    return iParity;
+}
+
+
+// OhmFecDecoder
+
+OhmFecDecoder::OhmFecDecoder()
+    : iGroupFrames(0)
+{
+}
+
+void OhmFecDecoder::Reset()
+{
+    iGroupFrames = 0;
+    for (TUint i=0; i<kMaxGroups; i++) {
+        iGroups[i].Reset(0, 0);
+    }
+}
+
+void OhmFecDecoder::Add(TUint aFrame, const Brx& aMsg)
+{
+    if (iGroupFrames == 0) {
+        return;
+    }
+    OhmFecGroup& group = GroupFor(aFrame);
+    const TUint first = aFrame - (aFrame % iGroupFrames);
+    if (group.FirstFrame() != first || group.FrameCount() != iGroupFrames) {
+        group.Reset(first, iGroupFrames);
+    }
+    (void)group.Add(aFrame, aMsg);
+}
+
+TBool OhmFecDecoder::Recover(const OhmHeaderParity& aHeader, const Brx& aParity, TUint& aFrame, Bwx& aMsg)
+{
+    const TUint count = aHeader.FrameCount();
+    if (count < 2 || count > OhmFecGroup::kMaxFrames || (aHeader.FirstFrame() % count) != 0
+        || aParity.Bytes() != aHeader.ParityBytes() || aParity.Bytes() > OhmFecGroup::kMaxFrameBytes) {
+        return false;
+    }
+    if (count != iGroupFrames) {
+        // first parity msg (or sender changed group size); start collecting from the next group
+        Reset();
+        iGroupFrames = count;
+        return false;
+    }
+    OhmFecGroup& group = GroupFor(aHeader.FirstFrame());
+    if (group.FirstFrame() != aHeader.FirstFrame() || group.FrameCount() != count || group.FramesAdded() + 1 != count) {
+        return false;
+    }
+
+    const TUint bytes = (aHeader.FrameBytesXor() ^ group.BytesXor()) & 0xffff;
+    const Brx& partial = group.Xor();
+    if (bytes <= kOffsetAudioFrame + 4 || bytes > std::max(aParity.Bytes(), partial.Bytes()) || bytes > aMsg.MaxBytes()) {
+        return false;
+    }
+    aMsg.SetBytes(0);
+    for (TUint i=0; i<bytes; i++) {
+        const TByte p = (i < aParity.Bytes()? aParity[i] : 0);
+        const TByte x = (i < partial.Bytes()? partial[i] : 0);
+        aMsg.Append((TByte)(p ^ x));
+    }
+
+    // sanity check the rebuilt msg before anyone tries to parse it
+    const TUint frame = group.MissingFrame();
+    if (aMsg[kOffsetAudioHeaderBytes] != OhmHeaderAudio::kHeaderBytes
+        || Converter::BeUint32At(aMsg, kOffsetAudioFrame) != frame) {
+        return false;
+    }
+    (void)group.Add(frame, aMsg);
+    aFrame = frame;
+    return true;
+}
+
+OhmFecGroup& OhmFecDecoder::GroupFor(TUint aFrame)
+{
+    return iGroups[(aFrame / iGroupFrames) % kMaxGroups];
+}
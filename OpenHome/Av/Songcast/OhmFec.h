@@ -0,0 +1,87 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Av/Songcast/Ohm.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+
+namespace OpenHome {
+namespace Av {
+
+/*
+ * XOR of a group of consecutive serialised audio msgs.
+ * Groups start at a multiple of their frame count, so sender and receivers agree on their
+ * boundaries without any further negotiation.
+ * The resent flag is masked out so a resent copy of a frame contributes the same bytes as the original.
+ */
+class OhmFecGroup
+{
+public:
+    static const TUint kMaxFrames = 32;
+    static const TUint kMaxFrameBytes = OhmMsgAudio::kStreamHeaderBytes + OhmMsgAudio::kMaxSampleBytes;
+public:
+    OhmFecGroup();
+    void Reset(TUint aFirstFrame, TUint aFrameCount);
+    TBool Contains(TUint aFrame) const;
+    TBool Add(TUint aFrame, const Brx& aMsg); // returns false if aFrame is outside this group or was already added
+    TUint FirstFrame() const;
+    TUint FrameCount() const;
+    TUint FramesAdded() const;
+    TBool Complete() const;
+    TUint MissingFrame() const; // only valid when exactly one frame hasn't been added
+    TUint BytesXor() const;
+    const Brx& Xor() const;
+private:
+    TUint iFirstFrame;
+    TUint iFrameCount;
+    TUint iAddedMask;
+    TUint iFramesAdded;
+    TUint iBytesXor;
+    Bws<kMaxFrameBytes> iXor;
+};
+
+/*
+ * Sender side.  Produces a OhmHeader::kMsgTypeParity msg after every aGroupFrames audio msgs.
+ */
+class OhmFecEncoder : private INonCopyable
+{
+public:
+    OhmFecEncoder();
+    void SetGroupFrames(TUint aGroupFrames); // 0 disables parity
+    TUint GroupFrames() const;
+    void Reset();
+    TBool Add(TUint aFrame, const Brx& aMsg); // returns true if Parity() holds a msg ready to send
+    const Brx& Parity() const;
+private:
+    TUint iGroupFrames;
+    OhmFecGroup iGroup;
+    Bws<OhmHeader::kHeaderBytes + OhmHeaderParity::kHeaderBytes + OhmFecGroup::kMaxFrameBytes> iParity;
+};
+
+/*
+ * Receiver side.  Tracks the last few groups of audio msgs received so that a single missing
+ * frame from any of them can be rebuilt when its parity msg arrives.
+ * The group size is learnt from parity msgs so needs no configuration.
+ */
+class OhmFecDecoder : private INonCopyable
+{
+    static const TUint kMaxGroups = 3;
+public:
+    OhmFecDecoder();
+    void Reset();
+    void Add(TUint aFrame, const Brx& aMsg);
+    /*
+     * Returns true if aParity allows a single missing frame to be rebuilt, setting aFrame and aMsg
+     * (a complete serialised audio msg).  Returns false for malformed parity msgs.
+     */
+    TBool Recover(const OhmHeaderParity& aHeader, const Brx& aParity, TUint& aFrame, Bwx& aMsg);
+private:
+    OhmFecGroup& GroupFor(TUint aFrame);
+private:
+    TUint iGroupFrames;
+    OhmFecGroup iGroups[kMaxGroups];
+};
+
+} // namespace Av
+} // namespace OpenHome
@@ -0,0 +1,393 @@
+#include <OpenHome/Av/Songcast/OhmLossless.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Av/Songcast/Ohm.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace OpenHome {
+namespace Av {
+
+class OhmBitWriter
+{
+public:
+    OhmBitWriter(Bwx& aBuf, TUint aMaxBytes);
+    void Write(TUint aValue, TUint aBits); // aBits <= 32
+    void WriteUnary(TUint aOnes);          // aOnes (<32) one bits followed by a zero
+    TBool Flush();                         // returns false if more than aMaxBytes were required
+private:
+    void Output();
+private:
+    Bwx& iBuf;
+    const TUint iMaxBytes;
+    TUint64 iAcc;
+    TUint iAccBits;
+    TBool iOverflow;
+};
+
+class OhmBitReader
+{
+public:
+    OhmBitReader(const Brx& aBuf);
+    TUint Read(TUint aBits); // aBits <= 32; throws OhmError if aBuf is exhausted
+    TUint ReadUnary(TUint aMax); // returns aMax without reading the terminating zero if aMax ones are read
+private:
+    TUint ReadBit();
+private:
+    const Brx& iBuf;
+    TUint iIndex;
+    TUint64 iAcc;
+    TUint iAccBits;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+// OhmBitWriter
+
+OhmBitWriter::OhmBitWriter(Bwx& aBuf, TUint aMaxBytes)
+    : iBuf(aBuf)
+    , iMaxBytes(std::min(aMaxBytes, aBuf.MaxBytes()))
+    , iAcc(0)
+    , iAccBits(0)
+    , iOverflow(false)
+{
+    iBuf.SetBytes(0);
+}
+
+void OhmBitWriter::Write(TUint aValue, TUint aBits)
+{
+    if (aBits == 0) {
+        return;
+    }
+    const TUint64 mask = (aBits == 32? 0xffffffffull : ((1ull << aBits) - 1));
+    iAcc = (iAcc << aBits) | (aValue & mask);
+    iAccBits += aBits;
+    Output();
+}
+
+void OhmBitWriter::WriteUnary(TUint aOnes)
+{
+    ASSERT(aOnes < 32);
+    Write(((1u << aOnes) - 1) << 1, aOnes + 1);
+}
+
+TBool OhmBitWriter::Flush()
+{
+    if (iAccBits > 0) {
+        Write(0, 8 - iAccBits);
+    }
+    return !iOverflow;
+}
+
+void OhmBitWriter::Output()
+{
+    while (iAccBits >= 8) {
+        iAccBits -= 8;
+        if (iBuf.Bytes() < iMaxBytes) {
+            iBuf.Append((TByte)(iAcc >> iAccBits));
+        }
+        else {
+            iOverflow = true;
+        }
+    }
+    iAcc &= ((1ull << iAccBits) - 1);
+}
+
+
+// OhmBitReader
+
+OhmBitReader::OhmBitReader(const Brx& aBuf)
+    : iBuf(aBuf)
+    , iIndex(0)
+    , iAcc(0)
+    , iAccBits(0)
+{
+}
+
+TUint OhmBitReader::Read(TUint aBits)
+{
+    while (iAccBits < aBits) {
+        if (iIndex == iBuf.Bytes()) {
+            THROW(OhmError);
+        }
+        iAcc = (iAcc << 8) | iBuf[iIndex++];
+        iAccBits += 8;
+    }
+    iAccBits -= aBits;
+    const TUint64 mask = (aBits == 32? 0xffffffffull : ((1ull << aBits) - 1));
+    const TUint val = (TUint)((iAcc >> iAccBits) & mask);
+    iAcc &= ((1ull << iAccBits) - 1);
+    return val;
+}
+
+TUint OhmBitReader::ReadUnary(TUint aMax)
+{
+    TUint ones = 0;
+    while (ones < aMax && ReadBit() == 1) {
+        ones++;
+    }
+    return ones;
+}
+
+TUint OhmBitReader::ReadBit()
+{
+    return Read(1);
+}
+
+
+// OhmLosslessCodec
+
+OhmLosslessCodec::OhmLosslessCodec()
+    : iSamples(2 * OhmMsgAudio::kMaxSampleBytes)
+{
+}
+
+TBool OhmLosslessCodec::IsSupported(TUint aChannels, TUint aBitDepth)
+{ // static
+    if (aChannels == 0 || aChannels > kMaxChannels) {
+        return false;
+    }
+    // 32-bit audio could overflow 32-bit residuals
+    return (aBitDepth == 8 || aBitDepth == 16 || aBitDepth == 24);
+}
+
+TBool OhmLosslessCodec::Encode(const Brx& aPcm, TUint aChannels, TUint aBitDepth, Bwx& aEncoded)
+{
+    if (!IsSupported(aChannels, aBitDepth)) {
+        return false;
+    }
+    const TUint bytesPerSample = aBitDepth / 8;
+    const TUint frameBytes = aChannels * bytesPerSample;
+    const TUint samples = aPcm.Bytes() / frameBytes;
+    if (samples == 0 || samples * frameBytes != aPcm.Bytes() || samples * (aChannels + 1) > iSamples.size()) {
+        return false;
+    }
+
+    // de-interleave, sign extending each subsample
+    const TByte* pcm = aPcm.Ptr();
+    const TUint shift = 32 - aBitDepth;
+    for (TUint i=0; i<samples; i++) {
+        for (TUint ch=0; ch<aChannels; ch++) {
+            TUint val = 0;
+            for (TUint b=0; b<bytesPerSample; b++) {
+                val = (val << 8) | *pcm++;
+            }
+            Channel(ch, samples)[i] = ((TInt)(val << shift)) >> shift;
+        }
+    }
+
+    // pick the cheapest predictor for each channel and, for stereo, the cheapest channel pairing
+    TUint mode = kModeIndependent;
+    TUint orders[kMaxChannels + 1];
+    TUint64 costs[kMaxChannels + 1];
+    for (TUint ch=0; ch<aChannels; ch++) {
+        orders[ch] = ChooseOrder(Channel(ch, samples), samples, costs[ch]);
+    }
+    TInt* side = Channel(aChannels, samples);
+    if (aChannels == 2) {
+        const TInt* left = Channel(0, samples);
+        const TInt* right = Channel(1, samples);
+        for (TUint i=0; i<samples; i++) {
+            side[i] = left[i] - right[i];
+        }
+        orders[2] = ChooseOrder(side, samples, costs[2]);
+        const TUint64 costIndependent = costs[0] + costs[1];
+        const TUint64 costLeftSide = costs[0] + costs[2];
+        const TUint64 costSideRight = costs[2] + costs[1];
+        if (costLeftSide < costIndependent && costLeftSide <= costSideRight) {
+            mode = kModeLeftSide;
+        }
+        else if (costSideRight < costIndependent) {
+            mode = kModeSideRight;
+        }
+    }
+
+    OhmBitWriter writer(aEncoded, aPcm.Bytes() - 1);
+    writer.Write(kFormatVersion, 8);
+    writer.Write(mode, 8);
+    for (TUint ch=0; ch<aChannels; ch++) {
+        TUint index = ch;
+        TUint bitDepth = aBitDepth;
+        if ((mode == kModeLeftSide && ch == 1) || (mode == kModeSideRight && ch == 0)) {
+            index = aChannels;
+            bitDepth++;
+        }
+        const TInt* data = Channel(index, samples);
+        const TUint order = orders[index];
+        const TUint k = ChooseRiceParam(data, samples, order);
+        writer.Write(order, 2);
+        writer.Write(k, 5);
+        for (TUint i=0; i<order; i++) {
+            writer.Write((TUint)data[i], bitDepth);
+        }
+        for (TUint i=order; i<samples; i++) {
+            const TInt residual = Residual(data, i, order);
+            const TUint zigzag = ((TUint)residual << 1) ^ (TUint)(residual >> 31);
+            const TUint quotient = zigzag >> k;
+            if (quotient >= kEscapeQuotient) {
+                writer.Write((1u << kEscapeQuotient) - 1, kEscapeQuotient); // no terminating zero
+                writer.Write(zigzag, 32);
+            }
+            else {
+                writer.WriteUnary(quotient);
+                writer.Write(zigzag, k);
+            }
+        }
+    }
+    return writer.Flush();
+}
+
+void OhmLosslessCodec::Decode(const Brx& aEncoded, TUint aSamples, TUint aChannels, TUint aBitDepth, Bwx& aPcm)
+{
+    if (!IsSupported(aChannels, aBitDepth)) {
+        THROW(OhmError);
+    }
+    const TUint bytesPerSample = aBitDepth / 8;
+    const TUint pcmBytes = aSamples * aChannels * bytesPerSample;
+    if (aSamples * (aChannels + 1) > iSamples.size() || pcmBytes > aPcm.MaxBytes()) {
+        THROW(OhmError);
+    }
+
+    OhmBitReader reader(aEncoded);
+    if (reader.Read(8) != kFormatVersion) {
+        THROW(OhmError);
+    }
+    const TUint mode = reader.Read(8);
+    if (mode > kModeSideRight || (mode != kModeIndependent && aChannels != 2)) {
+        THROW(OhmError);
+    }
+    for (TUint ch=0; ch<aChannels; ch++) {
+        TUint bitDepth = aBitDepth;
+        if ((mode == kModeLeftSide && ch == 1) || (mode == kModeSideRight && ch == 0)) {
+            bitDepth++;
+        }
+        TInt* data = Channel(ch, aSamples);
+        const TUint order = reader.Read(2);
+        const TUint k = reader.Read(5);
+        if (order > aSamples) {
+            THROW(OhmError);
+        }
+        const TUint shift = 32 - bitDepth;
+        for (TUint i=0; i<order; i++) {
+            data[i] = ((TInt)(reader.Read(bitDepth) << shift)) >> shift;
+        }
+        for (TUint i=order; i<aSamples; i++) {
+            const TUint quotient = reader.ReadUnary(kEscapeQuotient);
+            TUint zigzag;
+            if (quotient == kEscapeQuotient) {
+                zigzag = reader.Read(32);
+            }
+            else {
+                zigzag = (k == 0? 0 : reader.Read(k));
+                zigzag |= (quotient << k);
+            }
+            const TInt residual = (TInt)(zigzag >> 1) ^ -(TInt)(zigzag & 1);
+            data[i] = (TInt)((TUint)Predict(data, i, order) + (TUint)residual); // wraps (rather than overflowing) on corrupt input
+        }
+    }
+
+    if (mode == kModeLeftSide) {
+        const TInt* left = Channel(0, aSamples);
+        TInt* side = Channel(1, aSamples);
+        for (TUint i=0; i<aSamples; i++) {
+            side[i] = (TInt)((TUint)left[i] - (TUint)side[i]);
+        }
+    }
+    else if (mode == kModeSideRight) {
+        TInt* side = Channel(0, aSamples);
+        const TInt* right = Channel(1, aSamples);
+        for (TUint i=0; i<aSamples; i++) {
+            side[i] = (TInt)((TUint)side[i] + (TUint)right[i]);
+        }
+    }
+
+    aPcm.SetBytes(pcmBytes);
+    TByte* pcm = const_cast<TByte*>(aPcm.Ptr());
+    for (TUint i=0; i<aSamples; i++) {
+        for (TUint ch=0; ch<aChannels; ch++) {
+            const TUint val = (TUint)Channel(ch, aSamples)[i];
+            for (TUint b=bytesPerSample; b>0; b--) {
+                *pcm++ = (TByte)(val >> (8 * (b-1)));
+            }
+        }
+    }
+}
+
+TInt* OhmLosslessCodec::Channel(TUint aIndex, TUint aSamples)
+{
+    return &iSamples[aIndex * aSamples];
+}
+
+TUint OhmLosslessCodec::ChooseOrder(const TInt* aSamples, TUint aCount, TUint64& aCost)
+{ // static
+    if (aCount <= kMaxOrder) {
+        aCost = 0;
+        for (TUint i=0; i<aCount; i++) {
+            aCost += (TUint64)std::abs((TInt64)aSamples[i]);
+        }
+        return 0;
+    }
+    TUint64 cost[kMaxOrder + 1] = { 0, 0, 0, 0 };
+    for (TUint i=kMaxOrder; i<aCount; i++) {
+        const TInt64 x0 = aSamples[i];
+        const TInt64 x1 = aSamples[i-1];
+        const TInt64 x2 = aSamples[i-2];
+        const TInt64 x3 = aSamples[i-3];
+        cost[0] += (TUint64)std::abs(x0);
+        cost[1] += (TUint64)std::abs(x0 - x1);
+        cost[2] += (TUint64)std::abs(x0 - 2*x1 + x2);
+        cost[3] += (TUint64)std::abs(x0 - 3*x1 + 3*x2 - x3);
+    }
+    TUint order = 0;
+    for (TUint i=1; i<=kMaxOrder; i++) {
+        if (cost[i] < cost[order]) {
+            order = i;
+        }
+    }
+    aCost = cost[order];
+    return order;
+}
+
+TUint OhmLosslessCodec::ChooseRiceParam(const TInt* aSamples, TUint aCount, TUint aOrder)
+{ // static
+    if (aCount <= aOrder) {
+        return 0;
+    }
+    TUint64 sum = 0;
+    for (TUint i=aOrder; i<aCount; i++) {
+        const TInt residual = Residual(aSamples, i, aOrder);
+        sum += ((TUint)residual << 1) ^ (TUint)(residual >> 31);
+    }
+    const TUint64 count = aCount - aOrder;
+    TUint k = 0;
+    while (k < kMaxRiceParam && (count << (k + 1)) <= sum) {
+        k++;
+    }
+    return k;
+}
+
+inline TInt OhmLosslessCodec::Residual(const TInt* aSamples, TUint aIndex, TUint aOrder)
+{ // static
+    return aSamples[aIndex] - Predict(aSamples, aIndex, aOrder);
+}
+
+inline TInt OhmLosslessCodec::Predict(const TInt* aSamples, TUint aIndex, TUint aOrder)
+{ // static
+    switch (aOrder)
+    {
+    case 0:
+        return 0;
+    case 1:
+        return aSamples[aIndex-1];
+    case 2:
+        return (TInt)(2*(TUint)aSamples[aIndex-1] - (TUint)aSamples[aIndex-2]);
+    default:
+        return (TInt)(3*(TUint)aSamples[aIndex-1] - 3*(TUint)aSamples[aIndex-2] + (TUint)aSamples[aIndex-3]);
+    }
+}
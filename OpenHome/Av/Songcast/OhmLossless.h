@@ -0,0 +1,52 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+
+#include <vector>
+
+namespace OpenHome {
+namespace Av {
+
+/*
+ * Lossless compression of a single Songcast frame of PCM (big endian, interleaved).
+ * Each channel (or, for stereo, left/side or side/right) is coded using the cheapest fixed
+ * polynomial predictor (order 0-3) with residuals Rice coded.
+ * Frames are self-contained so can be decoded in any order (e.g. following a resend).
+ */
+class OhmLosslessCodec : private INonCopyable
+{
+    static const TUint kFormatVersion = 1;
+    static const TUint kMaxOrder = 3;
+    static const TUint kMaxRiceParam = 31;
+    static const TUint kEscapeQuotient = 24; // quotients this large are written as raw 32-bit values
+    static const TUint kModeIndependent = 0;
+    static const TUint kModeLeftSide = 1;
+    static const TUint kModeSideRight = 2;
+public:
+    static const TUint kMaxChannels = 8;
+public:
+    OhmLosslessCodec();
+    static TBool IsSupported(TUint aChannels, TUint aBitDepth);
+    /*
+     * Returns false (leaving aEncoded undefined) if the format isn't supported or if the
+     * encoded frame wouldn't be smaller than aPcm.
+     */
+    TBool Encode(const Brx& aPcm, TUint aChannels, TUint aBitDepth, Bwx& aEncoded);
+    /*
+     * Throws OhmError if aEncoded is malformed or aPcm is too small.
+     */
+    void Decode(const Brx& aEncoded, TUint aSamples, TUint aChannels, TUint aBitDepth, Bwx& aPcm);
+private:
+    TInt* Channel(TUint aIndex, TUint aSamples);
+    static TUint ChooseOrder(const TInt* aSamples, TUint aCount, TUint64& aCost);
+    static TUint ChooseRiceParam(const TInt* aSamples, TUint aCount, TUint aOrder);
+    static TInt Residual(const TInt* aSamples, TUint aIndex, TUint aOrder);
+    static TInt Predict(const TInt* aSamples, TUint aIndex, TUint aOrder);
+private:
+    std::vector<TInt> iSamples; // planar; kMaxChannels+1 channels (the extra one holds side for stereo)
+};
+
+} // namespace Av
+} // namespace OpenHome
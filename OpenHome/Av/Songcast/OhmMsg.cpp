@@ -123,6 +123,7 @@ void OhmMsgAudio::Create(IReader& aReader, const OhmHeader& aHeader)
     iTimestamped = false;
     iTimestamped2 = false;
     iResent = false;
+    iCompressed = false;
     const TUint flags = reader2.ReadUintBe(1);
     if (flags & kFlagHalt) {
         iHalt = true;
@@ -139,6 +140,9 @@ void OhmMsgAudio::Create(IReader& aReader, const OhmHeader& aHeader)
     if (flags & kFlagResent) {
         iResent = true;
     }
+    if (flags & kFlagCompressed) {
+        iCompressed = true;
+    }
 
     iSamples = reader2.ReadUintBe(2);
     iFrame = reader2.ReadUintBe(4);
@@ -173,6 +177,7 @@ void OhmMsgAudio::Create(TBool aHalt, TBool aLossless, TBool aTimestamped, TBool
     iTimestamped = aTimestamped;
     iTimestamped2 = iTimestamped; // assume that all senders other than original Linn have accurate timestamps
     iResent = aResent;
+    iCompressed = false;
     iSamples = aSamples;
     iFrame = aFrame;
     iNetworkTimestamp = aNetworkTimestamp;
@@ -197,6 +202,7 @@ void OhmMsgAudio::ReinitialiseFields(TBool aHalt, TBool aLossless, TBool aTimest
     iTimestamped = aTimestamped;
     iTimestamped2 = iTimestamped; // assume that all senders other than original Linn have accurate timestamps
     iResent = aResent;
+    iCompressed = false;
     iSamples = aSamples;
     iFrame = aFrame;
     iNetworkTimestamp = aNetworkTimestamp;
@@ -253,6 +259,11 @@ TBool OhmMsgAudio::Resent() const
     return iResent;
 }
 
+TBool OhmMsgAudio::Compressed() const
+{
+    return iCompressed;
+}
+
 TUint OhmMsgAudio::Samples() const
 {
     return iSamples;
@@ -332,10 +343,16 @@ void OhmMsgAudio::SetResent(TBool aValue)
 {
     iResent = aValue;
     const TUint flagsIndex = iStreamHeaderOffset + 8 + 1; // +8 for Ohm header, +1 to skip audio header length
-    ASSERT((iUnifiedBuffer[flagsIndex] & 0xE8) == 0); // check that kFlagResent and unused bits aren't set (implying flagsIndex is wrong)
+    ASSERT((iUnifiedBuffer[flagsIndex] & 0xC8) == 0); // check that kFlagResent and unused bits aren't set (implying flagsIndex is wrong)
     iUnifiedBuffer[flagsIndex] |= kFlagResent;
 }
 
+void OhmMsgAudio::SetCompressed(TBool aValue)
+{
+    ASSERT(!iHeaderSerialised);
+    iCompressed = aValue;
+}
+
 void OhmMsgAudio::Process(IOhmMsgProcessor& aProcessor)
 {
     aProcessor.Process(*this);
@@ -386,6 +403,9 @@ void OhmMsgAudio::Serialise()
     if (iTimestamped2) {
         flags |= kFlagTimestamped2;
     }
+    if (iCompressed) {
+        flags |= kFlagCompressed;
+    }
 
     writer.WriteUint8(kHeaderBytes);
     writer.WriteUint8(flags);
@@ -70,6 +70,7 @@ public:
     static const TUint kFlagTimestamped   = 1 << 2;
     static const TUint kFlagResent        = 1 << 3;
     static const TUint kFlagTimestamped2  = 1 << 4;
+    static const TUint kFlagCompressed    = 1 << 5; // Audio() is OhmLosslessCodec encoded, not PCM
     static const TUint kStreamHeaderBytes = 88; // 8 bytes Ohm header, 50 bytes audio header, 30 bytes codec name
 private:
     static const TUint kHeaderBytes = 50; // not including codec name
@@ -83,6 +84,7 @@ public:
     TBool Timestamped() const; // NetworkTimestamp is present but may not be accurate until MediaLatency after clock family change
     TBool Timestamped2() const; // NetworkTimestamp is present and accurate one frame after clock family change
     TBool Resent() const;
+    TBool Compressed() const;
     TUint Samples() const;
     TUint Frame() const;
     TUint NetworkTimestamp() const;
@@ -100,6 +102,7 @@ public:
     Bwx& Audio();
 
     void SetResent(TBool aValue);
+    void SetCompressed(TBool aValue); // must be called before Serialise()
     void Serialise();
     Brn SendableBuffer();
 public: // from OhmMsg
@@ -121,6 +124,7 @@ private:
     TBool iTimestamped;
     TBool iTimestamped2;
     TBool iResent;
+    TBool iCompressed;
     TUint iSamples;
     TUint iFrame;
     TUint iNetworkTimestamp;
@@ -0,0 +1,239 @@
+#include <OpenHome/Av/Songcast/OhmReceiverStats.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Json.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+// Smoothing applied to interarrival jitter, as RFC 3550
+static const TInt64 kJitterGain = 16;
+
+// OhmReceiverStats
+
+OhmReceiverStats::OhmReceiverStats(const TChar* aScheme, Optional<Media::IClockPullerTimestamp> aClockPuller)
+    : iScheme(aScheme)
+    , iClockPuller(aClockPuller.Ptr())
+    , iLock("OHRS")
+{
+    Start();
+    iValues.iActive = false;
+}
+
+void OhmReceiverStats::Start()
+{
+    AutoMutex _(iLock);
+    iValues = Values();
+    iValues.iActive = true;
+    ResetTimingLocked();
+}
+
+void OhmReceiverStats::Stop()
+{
+    AutoMutex _(iLock);
+    iValues.iActive = false;
+}
+
+void OhmReceiverStats::NotifyAudio(TUint64 aSampleStart, TUint aSampleRate, TUint aLatencyMs, TUint64 aNowUs, TBool aRecovered)
+{
+    AutoMutex _(iLock);
+    iValues.iFramesReceived++;
+    iValues.iLastAudioUs = aNowUs;
+    iValues.iLatencyMs = aLatencyMs;
+    if (aRecovered || aSampleRate == 0) {
+        return;
+    }
+    if (!iTimingValid || aSampleRate != iSampleRate || aSampleStart < iLastSampleStart) {
+        // new stream (or the sender restarted); previous timings don't apply
+        ResetTimingLocked();
+        iTimingValid = true;
+        iSampleRate = aSampleRate;
+        iBaseSample = aSampleStart;
+        iBaseUs = aNowUs;
+        iWindowStartUs = aNowUs;
+    }
+    iLastSampleStart = aSampleStart;
+
+    const TInt64 senderUs = static_cast<TInt64>((aSampleStart - iBaseSample) * 1000000 / iSampleRate);
+    const TInt64 offsetUs = static_cast<TInt64>(aNowUs - iBaseUs) - senderUs;
+    if (iLastOffsetValid) {
+        const TInt64 diff = std::llabs(offsetUs - iLastOffsetUs);
+        const TInt64 jitter = static_cast<TInt64>(iValues.iJitterUs);
+        iValues.iJitterUs = static_cast<TUint>(jitter + (diff - jitter) / kJitterGain);
+    }
+    iLastOffsetValid = true;
+    iLastOffsetUs = offsetUs;
+
+    iWindowMinOffsetUs = std::min(iWindowMinOffsetUs, offsetUs);
+    const TInt64 bestUs = (iPrevMinOffsetValid? std::min(iPrevMinOffsetUs, iWindowMinOffsetUs) : iWindowMinOffsetUs);
+    const TUint delayMs = static_cast<TUint>((offsetUs - bestUs) / 1000);
+    iValues.iOccupancyMs = (delayMs >= aLatencyMs? 0 : aLatencyMs - delayMs);
+    if (aLatencyMs > 0 && delayMs > aLatencyMs) {
+        iValues.iFramesLate++;
+    }
+
+    if (aNowUs - iWindowStartUs < static_cast<TUint64>(kWindowMs) * 1000) {
+        return;
+    }
+    iPrevMinOffsetUs = iWindowMinOffsetUs;
+    iPrevMinOffsetValid = true;
+    iWindowMinOffsetUs = LLONG_MAX;
+    iWindowStartUs = aNowUs;
+}
+
+void OhmReceiverStats::NotifyMissing(TUint aFrames)
+{
+    AutoMutex _(iLock);
+    iValues.iFramesMissing += aFrames;
+}
+
+void OhmReceiverStats::NotifyLate()
+{
+    AutoMutex _(iLock);
+    iValues.iFramesLate++;
+}
+
+void OhmReceiverStats::NotifyRecoveredFec()
+{
+    AutoMutex _(iLock);
+    iValues.iFramesRecoveredFec++;
+}
+
+void OhmReceiverStats::NotifyRecoveredResend()
+{
+    AutoMutex _(iLock);
+    iValues.iFramesRecoveredResend++;
+}
+
+void OhmReceiverStats::NotifyConcealed(TUint aFrames)
+{
+    AutoMutex _(iLock);
+    iValues.iFramesConcealed += aFrames;
+}
+
+void OhmReceiverStats::NotifyResendRequested(TUint aFrames)
+{
+    AutoMutex _(iLock);
+    iValues.iResendRequests++;
+    iValues.iResendFramesRequested += aFrames;
+}
+
+void OhmReceiverStats::NotifyResendSuppressed(TUint aFrames)
+{
+    AutoMutex _(iLock);
+    iValues.iResendFramesSuppressed += aFrames;
+}
+
+void OhmReceiverStats::NotifyRtt(TUint aRttUs)
+{
+    AutoMutex _(iLock);
+    iValues.iRttValid = true;
+    iValues.iRttUs = aRttUs;
+}
+
+void OhmReceiverStats::Get(Values& aValues) const
+{
+    {
+        AutoMutex _(iLock);
+        aValues = iValues;
+    }
+    aValues.iClockValid = false;
+    aValues.iClockPpm = 0;
+    if (aValues.iActive && iClockPuller != nullptr) {
+        aValues.iClockValid = iClockPuller->TryGetDriftPpm(aValues.iClockPpm);
+    }
+}
+
+void OhmReceiverStats::WriteInfo(IWriter& aWriter) const
+{
+    Values v;
+    Get(v);
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("    Songcast ("));
+    writer.Write(iScheme);
+    writer.Write(Brn(") frames received:"));
+    writer.WriteUint(v.iFramesReceived);
+    writer.Write(Brn(", late:"));
+    writer.WriteUint(v.iFramesLate);
+    writer.Write(Brn(", missing:"));
+    writer.WriteUint(v.iFramesMissing);
+    writer.Write(Brn(", recovered by FEC:"));
+    writer.WriteUint(v.iFramesRecoveredFec);
+    writer.Write(Brn(", by resend:"));
+    writer.WriteUint(v.iFramesRecoveredResend);
+    writer.Write(Brn(", concealed:"));
+    writer.WriteUint(v.iFramesConcealed);
+    writer.Write(Brn("\n    Songcast ("));
+    writer.Write(iScheme);
+    writer.Write(Brn(") resend requests:"));
+    writer.WriteUint(v.iResendRequests);
+    writer.Write(Brn(" ("));
+    writer.WriteUint(v.iResendFramesRequested);
+    writer.Write(Brn(" frames, "));
+    writer.WriteUint(v.iResendFramesSuppressed);
+    writer.Write(Brn(" suppressed), rtt:"));
+    writer.WriteUint(v.iRttUs);
+    writer.Write(Brn("us, jitter:"));
+    writer.WriteUint(v.iJitterUs);
+    writer.Write(Brn("us, occupancy:"));
+    writer.WriteUint(v.iOccupancyMs);
+    writer.Write(Brn("/"));
+    writer.WriteUint(v.iLatencyMs);
+    writer.Write(Brn("ms, clock:"));
+    if (v.iClockValid) {
+        writer.WriteInt(v.iClockPpm);
+        writer.Write(Brn("ppm\n"));
+    }
+    else {
+        writer.Write(Brn("unknown\n"));
+    }
+}
+
+void OhmReceiverStats::WriteJson(IWriter& aWriter) const
+{
+    Values v;
+    Get(v);
+    WriterJsonObject json(aWriter);
+    json.WriteString("scheme", iScheme);
+    json.WriteBool("active", v.iActive);
+    json.WriteInt("framesReceived", v.iFramesReceived);
+    json.WriteInt("framesLate", v.iFramesLate);
+    json.WriteInt("framesMissing", v.iFramesMissing);
+    json.WriteInt("framesRecoveredFec", v.iFramesRecoveredFec);
+    json.WriteInt("framesRecoveredResend", v.iFramesRecoveredResend);
+    json.WriteInt("framesConcealed", v.iFramesConcealed);
+    json.WriteInt("resendRequests", v.iResendRequests);
+    json.WriteInt("resendFramesRequested", v.iResendFramesRequested);
+    json.WriteInt("resendFramesSuppressed", v.iResendFramesSuppressed);
+    json.WriteBool("rttValid", v.iRttValid);
+    json.WriteInt("rttUs", v.iRttUs);
+    json.WriteInt("jitterUs", v.iJitterUs);
+    json.WriteInt("latencyMs", v.iLatencyMs);
+    json.WriteInt("occupancyMs", v.iOccupancyMs);
+    json.WriteBool("clockValid", v.iClockValid);
+    json.WriteInt("clockPpm", v.iClockPpm);
+    json.WriteEnd();
+}
+
+void OhmReceiverStats::ResetTimingLocked()
+{
+    iTimingValid = false;
+    iSampleRate = 0;
+    iBaseSample = 0;
+    iBaseUs = 0;
+    iWindowStartUs = 0;
+    iWindowMinOffsetUs = LLONG_MAX;
+    iPrevMinOffsetValid = false;
+    iPrevMinOffsetUs = 0;
+    iLastOffsetValid = false;
+    iLastOffsetUs = 0;
+    iLastSampleStart = 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Optional.h>
+
+namespace OpenHome {
+    class IWriter;
+namespace Media {
+    class IClockPullerTimestamp;
+}
+namespace Av {
+
+/*
+ * Live statistics for a Songcast receiver, intended to help tell network loss apart from
+ * local starvation.
+ *
+ * Arrival timing is judged by comparing the local time each (non-resent) frame arrives with
+ * the sender's sample position.  The smallest such offset over a window is taken as the
+ * network's best case.  The delay of later frames beyond that best case eats into the
+ * stream's latency so 'occupancy' is an estimate, from the network side, of how much of the
+ * target latency is still available as buffered audio.  The sender's clock rate relative to
+ * ours is read from the clock puller, if there is one.
+ *
+ * All functions are thread safe.
+ */
+class OhmReceiverStats : private INonCopyable
+{
+public:
+    static const TUint kWindowMs = 10000;
+    class Values
+    {
+    public:
+        TBool iActive;
+        TUint iFramesReceived;
+        TUint iFramesLate;
+        TUint iFramesMissing;
+        TUint iFramesRecoveredFec;
+        TUint iFramesRecoveredResend;
+        TUint iFramesConcealed;
+        TUint iResendRequests;
+        TUint iResendFramesRequested;
+        TUint iResendFramesSuppressed;
+        TBool iRttValid;
+        TUint iRttUs;
+        TUint iJitterUs;
+        TUint iLatencyMs;
+        TUint iOccupancyMs;
+        TBool iClockValid;
+        TInt iClockPpm; // positive if the sender's clock runs faster than ours
+        TUint64 iLastAudioUs;
+    };
+public:
+    OhmReceiverStats(const TChar* aScheme, Optional<Media::IClockPullerTimestamp> aClockPuller);
+    void Start(); // clears all values
+    void Stop();
+    void NotifyAudio(TUint64 aSampleStart, TUint aSampleRate, TUint aLatencyMs, TUint64 aNowUs, TBool aRecovered); // aRecovered => resent or rebuilt from parity, so not used for timing
+    void NotifyMissing(TUint aFrames);
+    void NotifyLate();
+    void NotifyRecoveredFec();
+    void NotifyRecoveredResend();
+    void NotifyConcealed(TUint aFrames);
+    void NotifyResendRequested(TUint aFrames);
+    void NotifyResendSuppressed(TUint aFrames);
+    void NotifyRtt(TUint aRttUs);
+    void Get(Values& aValues) const;
+    void WriteInfo(IWriter& aWriter) const;
+    void WriteJson(IWriter& aWriter) const;
+private:
+    void ResetTimingLocked();
+private:
+    Brn iScheme;
+    Media::IClockPullerTimestamp* iClockPuller;
+    mutable Mutex iLock;
+    Values iValues;
+    TBool iTimingValid;
+    TUint iSampleRate;
+    TUint64 iBaseSample;
+    TUint64 iBaseUs;
+    TUint64 iWindowStartUs;
+    TInt64 iWindowMinOffsetUs;
+    TBool iPrevMinOffsetValid;
+    TInt64 iPrevMinOffsetUs;
+    TBool iLastOffsetValid;
+    TInt64 iLastOffsetUs;
+    TUint64 iLastSampleStart;
+};
+
+} // namespace Av
+} // namespace OpenHome
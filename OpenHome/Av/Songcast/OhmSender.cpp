@@ -15,6 +15,7 @@
 #include <OpenHome/Optional.h>
 
 #include <stdio.h>
+#include <algorithm>
 
 namespace OpenHome {
 class Environment;
@@ -172,9 +173,113 @@ void ProviderSender::NotifyAudioPlaying(TBool aPlaying)
 }
 
 
+// OhmSenderHistory
+
+OhmSenderHistory::OhmSenderHistory(TUint aMaxFrames)
+    : iSlots(aMaxFrames, nullptr)
+    , iDepth(aMaxFrames)
+    , iLatestFrame(0)
+    , iCount(0)
+{
+    ASSERT(aMaxFrames > 0);
+}
+
+OhmSenderHistory::~OhmSenderHistory()
+{
+    Clear();
+}
+
+TUint OhmSenderHistory::MaxFrames() const
+{
+    return (TUint)iSlots.size();
+}
+
+TUint OhmSenderHistory::Depth() const
+{
+    return iDepth;
+}
+
+void OhmSenderHistory::SetDepth(TUint aFrames)
+{
+    ASSERT(aFrames > 0 && aFrames <= MaxFrames());
+    iDepth = aFrames;
+    EvictExpired();
+}
+
+void OhmSenderHistory::Add(OhmMsgAudio* aMsg)
+{
+    const TUint frame = aMsg->Frame();
+    OhmMsgAudio*& slot = iSlots[frame % iSlots.size()];
+    if (slot != nullptr) {
+        slot->RemoveRef();
+        iCount--;
+    }
+    slot = aMsg;
+    iCount++;
+    iLatestFrame = frame;
+
+    // frames are normally consecutive so only the one that just fell out of our depth needs removing
+    const TUint expired = frame - iDepth;
+    OhmMsgAudio*& expiredSlot = iSlots[expired % iSlots.size()];
+    if (expiredSlot != nullptr && expiredSlot->Frame() == expired) {
+        expiredSlot->RemoveRef();
+        expiredSlot = nullptr;
+        iCount--;
+    }
+}
+
+OhmMsgAudio* OhmSenderHistory::Find(TUint aFrame) const
+{
+    OhmMsgAudio* msg = iSlots[aFrame % iSlots.size()];
+    if (msg == nullptr || msg->Frame() != aFrame || (iLatestFrame - aFrame) >= iDepth) {
+        return nullptr;
+    }
+    return msg;
+}
+
+void OhmSenderHistory::Replace(OhmMsgAudio& aOld, OhmMsgAudio* aNew)
+{
+    OhmMsgAudio*& slot = iSlots[aOld.Frame() % iSlots.size()];
+    ASSERT(slot == &aOld);
+    ASSERT(aNew == nullptr || aNew->Frame() == aOld.Frame());
+    slot = aNew;
+    aOld.RemoveRef();
+    if (aNew == nullptr) {
+        iCount--;
+    }
+}
+
+TUint OhmSenderHistory::Count() const
+{
+    return iCount;
+}
+
+void OhmSenderHistory::Clear()
+{
+    for (auto& slot : iSlots) {
+        if (slot != nullptr) {
+            slot->RemoveRef();
+            slot = nullptr;
+        }
+    }
+    iCount = 0;
+}
+
+void OhmSenderHistory::EvictExpired()
+{
+    for (auto& slot : iSlots) {
+        if (slot != nullptr && (iLatestFrame - slot->Frame()) >= iDepth) {
+            slot->RemoveRef();
+            slot = nullptr;
+            iCount--;
+        }
+    }
+}
+
+
 // OhmSenderDriver
 
-OhmSenderDriver::OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper)
+OhmSenderDriver::OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper, TUint aMaxLatencyMs)
     : iMutex("OHMD")
     , iEnabled(false)
     , iActive(false)
@@ -183,16 +288,29 @@ OhmSenderDriver::OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aT
     , iSampleRate(0)
     , iTimestampMultiplier(0)
     , iBytesPerSample(0)
+    , iChannels(0)
+    , iBitDepth(0)
     , iLossless(false)
+    , iCompress(false)
+    , iMutexDecompress("OHMC")
+    , iDecompressFrame(0)
+    , iDecompressChannels(0)
+    , iDecompressBitDepth(0)
     , iSamplesTotal(0)
     , iSampleStart(0)
     , iLatencyMs(0)
     , iLatencyOhm(0)
     , iSocket(aEnv)
-    , iFactory(110, 10, 10) // FIXME - rationale for msg counts??
+    , iMaxHistoryFrames(std::max(HistoryFrames(aMaxLatencyMs), (TUint)kMinHistoryFrames))
+    , iFactory(iMaxHistoryFrames + 10, 10, 10) // history plus the msg being filled by our client
+    , iHistory(iMaxHistoryFrames)
+    , iResendHits(0)
+    , iResendMisses(0)
+    , iResendBytes(0)
     , iTimestamper(aTimestamper.Ptr())
     , iFirstFrame(true)
 {
+    UpdateHistoryDepth();
 }
 
 inline void OhmSenderDriver::UpdateLatencyOhm()
@@ -200,33 +318,62 @@ inline void OhmSenderDriver::UpdateLatencyOhm()
     iLatencyOhm = iLatencyMs * iTimestampMultiplier / 1000;
 }
 
-void OhmSenderDriver::SetAudioFormat(TUint aSampleRate, TUint aBitRate, TUint aChannels, TUint aBitDepth, TBool aLossless, const Brx& aCodecName, TUint64 aSampleStart)
+TUint OhmSenderDriver::HistoryFrames(TUint aLatencyMs)
 {
-    AutoMutex mutex(iMutex);
+    // receivers can request a resend at any point until a frame is due to be played
+    return (aLatencyMs + kNominalFrameMs - 1) / kNominalFrameMs + kHistoryMarginFrames;
+}
 
-    iSampleRate = aSampleRate;
-    iTimestampMultiplier = Media::Jiffies::SongcastTicksPerSecond(aSampleRate);
-    UpdateLatencyOhm();
-    iBytesPerSample = aChannels * aBitDepth / 8;
-    iLossless = aLossless;
-    iSampleStart = aSampleStart;
+void OhmSenderDriver::UpdateHistoryDepth()
+{
+    TUint frames = std::max(HistoryFrames(iLatencyMs), (TUint)kMinHistoryFrames);
+    if (frames > iMaxHistoryFrames) {
+        LOG(kSongcast, "OHM SENDER DRIVER LATENCY %ums EXCEEDS MAXIMUM, HISTORY LIMITED TO %u FRAMES\n", iLatencyMs, iMaxHistoryFrames);
+        frames = iMaxHistoryFrames;
+    }
+    if (frames != iHistory.Depth()) {
+        iHistory.SetDepth(frames);
+        LOG(kSongcast, "OHM SENDER DRIVER HISTORY %u FRAMES\n", frames);
+    }
+}
 
-    iStreamHeader.Replace(Brx::Empty());
-    OhmMsgAudio::GetStreamHeader(iStreamHeader, iSamplesTotal, aSampleRate, aBitRate, 0/*VolumeOffset*/, aBitDepth, aChannels, aCodecName);
+void OhmSenderDriver::SetAudioFormat(TUint aSampleRate, TUint aBitRate, TUint aChannels, TUint aBitDepth, TBool aLossless, const Brx& aCodecName, TUint64 aSampleStart)
+{
+    AutoMutex _(iMutexDecompress);
+    TBool decompress = false;
+    {
+        AutoMutex mutex(iMutex);
 
-    if (iTimestamper != nullptr) {
-        // ignore return value below - false just implies iTimestamper->Timestamp will throw
-        // ...and we already have to deal with this
-        (void)iTimestamper->SetSampleRate(iSampleRate);
+        if (iCompress && (aChannels != iChannels || aBitDepth != iBitDepth)) {
+            // history can then always be decompressed using the current format, should receivers stop supporting compression
+            PrepareDecompressLocked();
+            decompress = true;
+        }
+        iSampleRate = aSampleRate;
+        iTimestampMultiplier = Media::Jiffies::SongcastTicksPerSecond(aSampleRate);
+        UpdateLatencyOhm();
+        iBytesPerSample = aChannels * aBitDepth / 8;
+        iChannels = aChannels;
+        iBitDepth = aBitDepth;
+        iLossless = aLossless;
+        iSampleStart = aSampleStart;
+
+        iStreamHeader.Replace(Brx::Empty());
+        OhmMsgAudio::GetStreamHeader(iStreamHeader, iSamplesTotal, aSampleRate, aBitRate, 0/*VolumeOffset*/, aBitDepth, aChannels, aCodecName);
+
+        if (iTimestamper != nullptr) {
+            // ignore return value below - false just implies iTimestamper->Timestamp will throw
+            // ...and we already have to deal with this
+            (void)iTimestamper->SetSampleRate(iSampleRate);
+        }
+    }
+    if (decompress) {
+        DecompressHistory();
     }
 }
 
 OhmMsgAudio* OhmSenderDriver::CreateAudio()
 {
-    AutoMutex mutex(iMutex);
-    if (iFifoHistory.SlotsUsed() == kMaxHistoryFrames) {
-        iFifoHistory.Read()->RemoveRef();
-    }
     return iFactory.CreateAudio();
 }
 
@@ -249,9 +396,6 @@ void OhmSenderDriver::SendAudio(const TByte* aData, TUint aBytes, TBool aHalt)
         // nothing to usefully communicate to receivers
         return;
     }
-    if (iFifoHistory.SlotsUsed() == kMaxHistoryFrames) {
-        iFifoHistory.Read()->RemoveRef();
-    }
 
     TBool isTimeStamped = false;
     TUint timeStamp = 0;
@@ -266,6 +410,11 @@ void OhmSenderDriver::SendAudio(const TByte* aData, TUint aBytes, TBool aHalt)
         catch (OhmTimestampNotFound&) {}
     }
 
+    Brn audio(aData, aBytes);
+    const TBool compressed = Compress(audio);
+    if (compressed) {
+        audio.Set(iCompressed);
+    }
     OhmMsgAudio* msg = iFactory.CreateAudio(
         aHalt,
         iLossless,
@@ -277,16 +426,18 @@ void OhmSenderDriver::SendAudio(const TByte* aData, TUint aBytes, TBool aHalt)
         iLatencyOhm,
         iSampleStart,
         iStreamHeader,
-        Brn(aData, aBytes)
+        audio
     );
 
+    msg->SetCompressed(compressed);
     msg->Serialise();
-    iFifoHistory.Write(msg);
+    iHistory.Add(msg);
     try {
         iSocket.Send(msg->SendableBuffer(), iEndpoint);
     }
     catch (NetworkError&) {
     }
+    SendParity(*msg);
 
     msg->SetResent(true);
     iSampleStart += samples;
@@ -314,9 +465,6 @@ void OhmSenderDriver::SendAudio(OhmMsgAudio* aMsg, TBool aHalt)
         aMsg->RemoveRef();
         return;
     }
-    if (iFifoHistory.SlotsUsed() == kMaxHistoryFrames) {
-        iFifoHistory.Read()->RemoveRef();
-    }
 
     TBool isTimeStamped = false;
     TUint timeStamp = 0;
@@ -331,6 +479,10 @@ void OhmSenderDriver::SendAudio(OhmMsgAudio* aMsg, TBool aHalt)
         catch (OhmTimestampNotFound&) {}
     }
 
+    const TBool compressed = Compress(aMsg->Audio());
+    if (compressed) {
+        aMsg->Audio().Replace(iCompressed);
+    }
     aMsg->ReinitialiseFields(
         aHalt,
         iLossless,
@@ -344,19 +496,31 @@ void OhmSenderDriver::SendAudio(OhmMsgAudio* aMsg, TBool aHalt)
         iStreamHeader
     );
 
+    aMsg->SetCompressed(compressed);
     aMsg->Serialise();
-    iFifoHistory.Write(aMsg);
+    iHistory.Add(aMsg);
     try {
         iSocket.Send(aMsg->SendableBuffer(), iEndpoint);
     }
     catch (NetworkError&) {
     }
+    SendParity(*aMsg);
 
     aMsg->SetResent(true);
     iSampleStart += samples;
     iFrame++;
 }
 
+TBool OhmSenderDriver::TrySkipAudio(TUint aSamples)
+{
+    AutoMutex mutex(iMutex);
+    if (iSend) {
+        return false;
+    }
+    iSampleStart += aSamples;
+    return true;
+}
+
 void OhmSenderDriver::SetEnabled(TBool aValue)
 {
     AutoMutex mutex(iMutex);
@@ -416,6 +580,35 @@ void OhmSenderDriver::SetLatency(TUint aValue)
     AutoMutex mutex(iMutex);
     iLatencyMs = aValue;
     UpdateLatencyOhm();
+    UpdateHistoryDepth();
+}
+
+void OhmSenderDriver::SetCompression(TBool aEnable)
+{
+    AutoMutex _(iMutexDecompress);
+    {
+        AutoMutex mutex(iMutex);
+        if (iCompress == aEnable) {
+            return;
+        }
+        iCompress = aEnable;
+        LOG(kSongcast, "OHM SENDER DRIVER COMPRESSION %u\n", aEnable);
+        if (aEnable) {
+            return;
+        }
+        // don't answer resend requests from receivers that can't decode them with compressed frames
+        PrepareDecompressLocked();
+    }
+    DecompressHistory();
+}
+
+void OhmSenderDriver::SetFec(TUint aGroupFrames)
+{
+    AutoMutex mutex(iMutex);
+    if (iFec.GroupFrames() != aGroupFrames) {
+        iFec.SetGroupFrames(aGroupFrames);
+        LOG(kSongcast, "OHM SENDER DRIVER FEC %u\n", aGroupFrames);
+    }
 }
 
 void OhmSenderDriver::SetTrackPosition(TUint64 aSamplesTotal, TUint64 aSampleStart)
@@ -429,7 +622,9 @@ void OhmSenderDriver::Resend(OhmMsgAudio& aMsg)
 {
     try {
         aMsg.Serialise();
-        iSocket.Send(aMsg.SendableBuffer(), iEndpoint);
+        const Brn buf = aMsg.SendableBuffer();
+        iSocket.Send(buf, iEndpoint);
+        iResendBytes += buf.Bytes();
     }
     catch (NetworkError&) {
     }
@@ -442,52 +637,108 @@ void OhmSenderDriver::Resend(const Brx& aFrames)
 
     ReaderBuffer buffer(aFrames);
     ReaderBinary reader(buffer);
-    TUint frames = aFrames.Bytes() / 4;
-    TUint frame = reader.ReadUintBe(4);
-    frames--;
-    LOG(kSongcast, " %lu", (unsigned long)frame);
-    TBool found = false;
-    TUint count = iFifoHistory.SlotsUsed();
-    for (TUint i = 0; i < count; i++) {
-        OhmMsgAudio* msg = iFifoHistory.Read();
-        if (!found) {
-            TInt diff = frame - msg->Frame();
-            if (diff == 0) {
-                Resend(*msg);
-                if (frames-- > 0) {
-                    frame = reader.ReadUintBe(4);
-                }
-                else {
-                    found = true;
+    const TUint frames = aFrames.Bytes() / 4;
+    for (TUint i = 0; i < frames; i++) {
+        const TUint frame = reader.ReadUintBe(4);
+        OhmMsgAudio* msg = iHistory.Find(frame);
+        if (msg == nullptr) {
+            LOG(kSongcast, " %lu(missed)", (unsigned long)frame);
+            iResendMisses++;
+        }
+        else {
+            LOG(kSongcast, " %lu", (unsigned long)frame);
+            iResendHits++;
+            Resend(*msg);
+        }
+    }
+    LOG(kSongcast, "\n");
+}
+
+TBool OhmSenderDriver::Compress(const Brx& aAudio)
+{
+    // falls back to PCM for any frame that doesn't get smaller
+    return iCompress && aAudio.Bytes() > 0 && iCodec.Encode(aAudio, iChannels, iBitDepth, iCompressed);
+}
+
+void OhmSenderDriver::PrepareDecompressLocked()
+{
+    // called with iMutexDecompress and iMutex locked
+    iDecompressFrame = iFrame;
+    iDecompressChannels = iChannels;
+    iDecompressBitDepth = iBitDepth;
+    iDecompressHeader.Replace(iStreamHeader);
+}
+
+void OhmSenderDriver::DecompressHistory()
+{
+    /* Called with iMutexDecompress locked, after PrepareDecompressLocked().  Each frame is decoded
+       without iMutex held so that audio can still be sent (and resends answered) meanwhile. */
+    TUint decompressed = 0;
+    TBool replaced = false;
+    iMutex.Wait();
+    const TUint depth = iHistory.Depth();
+    iMutex.Signal();
+    for (TUint i = 1; i <= depth; i++) {
+        const TUint frame = iDecompressFrame - i;
+        OhmMsgAudio* msg = nullptr;
+        {
+            AutoMutex mutex(iMutex);
+            msg = iHistory.Find(frame);
+            if (msg == nullptr || !msg->Compressed()) {
+                continue;
+            }
+            msg->AddRef();
+        }
+        OhmMsgAudio* pcm = nullptr;
+        try {
+            iDecompressCodec.Decode(msg->Audio(), msg->Samples(), iDecompressChannels, iDecompressBitDepth, iDecompressed);
+            pcm = iFactory.CreateAudio(msg->Halt(), msg->Lossless(), msg->Timestamped(), false, msg->Samples(),
+                                       msg->Frame(), msg->NetworkTimestamp(), msg->MediaLatency(),
+                                       msg->SampleStart(), iDecompressHeader, iDecompressed);
+            pcm->Serialise();
+            pcm->SetResent(true);
+        }
+        catch (OhmError&) {
+            LOG2(kSongcast, kError, "OhmSenderDriver: failed to decompress frame %u, dropping it from history\n", frame);
+        }
+        {
+            AutoMutex mutex(iMutex);
+            if (iHistory.Find(frame) != msg) { // evicted (or history cleared) while we decoded it
+                if (pcm != nullptr) {
+                    pcm->RemoveRef();
                 }
             }
             else {
-                while (diff < 0) {
-                    if (frames-- > 0) {
-                        frame = reader.ReadUintBe(4);
-                    }
-                    else {
-                        found = true;
-                        break;
-                    }
-                    diff = frame - msg->Frame();
-                    if (diff == 0) {
-                        Resend(*msg);
-                        if (frames-- > 0) {
-                            frame = reader.ReadUintBe(4);
-                        }
-                        else {
-                            found = true;
-                        }
-                        break;
-                    }
+                if (!replaced) {
+                    /* Parity covers the compressed frames.  Receivers only attempt recovery as
+                       parity arrives so a decompressed resend can only be combined with the
+                       parity for the group still being built.  Don't send that. */
+                    iFec.Reset();
+                    replaced = true;
+                }
+                iHistory.Replace(*msg, pcm);
+                if (pcm != nullptr) {
+                    decompressed++;
                 }
             }
         }
+        msg->RemoveRef();
+    }
+    if (decompressed > 0) {
+        LOG(kSongcast, "OHM SENDER DRIVER DECOMPRESSED %u HISTORY FRAMES\n", decompressed);
+    }
+}
 
-        iFifoHistory.Write(msg);
+void OhmSenderDriver::SendParity(OhmMsgAudio& aMsg)
+{
+    // must be called before aMsg is flagged as resent
+    if (iFec.Add(aMsg.Frame(), aMsg.SendableBuffer())) {
+        try {
+            iSocket.Send(iFec.Parity(), iEndpoint);
+        }
+        catch (NetworkError&) {
+        }
     }
-    LOG(kSongcast, "\n");
 }
 
 void OhmSenderDriver::ResetLocked()
@@ -495,12 +746,197 @@ void OhmSenderDriver::ResetLocked()
     iSend = false;
     iFrame = 0;
     iFirstFrame = true;
+    iFec.Reset();
     if (iTimestamper != nullptr) {
         iTimestamper->Stop();
     }
-    const TUint count = iFifoHistory.SlotsUsed();
+    iHistory.Clear();
+    LOG(kSongcast, "OHM SENDER DRIVER RESENT %u FRAMES (%llu BYTES), %u REQUESTED FRAMES NO LONGER IN HISTORY\n",
+                   iResendHits, iResendBytes, iResendMisses);
+}
+
+
+// OhmSenderSlaves::Slave
+
+OhmSenderSlaves::Slave::Slave()
+    : iExpiry(0)
+    , iCapabilities(0)
+    , iResendRequests(0)
+    , iFramesRequested(0)
+{
+}
+
+const Endpoint& OhmSenderSlaves::Slave::GetEndpoint() const
+{
+    return iEndpoint;
+}
+
+TUint OhmSenderSlaves::Slave::Expiry() const
+{
+    return iExpiry;
+}
+
+TUint OhmSenderSlaves::Slave::Capabilities() const
+{
+    return iCapabilities;
+}
+
+TUint OhmSenderSlaves::Slave::ResendRequests() const
+{
+    return iResendRequests;
+}
+
+TUint OhmSenderSlaves::Slave::FramesRequested() const
+{
+    return iFramesRequested;
+}
+
+void OhmSenderSlaves::Slave::Set(const Endpoint& aEndpoint, TUint aExpiry, TUint aCapabilities)
+{
+    iEndpoint.Replace(aEndpoint);
+    iExpiry = aExpiry;
+    iCapabilities = aCapabilities;
+    iResendRequests = 0;
+    iFramesRequested = 0;
+}
+
+void OhmSenderSlaves::Slave::Set(const Slave& aSlave)
+{
+    iEndpoint.Replace(aSlave.iEndpoint);
+    iExpiry = aSlave.iExpiry;
+    iCapabilities = aSlave.iCapabilities;
+    iResendRequests = aSlave.iResendRequests;
+    iFramesRequested = aSlave.iFramesRequested;
+}
+
+
+// OhmSenderSlaves
+
+OhmSenderSlaves::OhmSenderSlaves()
+    : iCount(0)
+{
+}
+
+void OhmSenderSlaves::Clear()
+{
+    iCount = 0;
+}
+
+TUint OhmSenderSlaves::Count() const
+{
+    return iCount;
+}
+
+const OhmSenderSlaves::Slave& OhmSenderSlaves::At(TUint aIndex) const
+{
+    ASSERT(aIndex < iCount);
+    return iSlaves[aIndex];
+}
+
+TBool OhmSenderSlaves::Refresh(const Endpoint& aEndpoint, TUint aExpiry, TUint aCapabilities)
+{
+    const TUint index = Find(aEndpoint);
+    if (index == iCount) {
+        return false;
+    }
+    iSlaves[index].iExpiry = aExpiry;
+    iSlaves[index].iCapabilities = aCapabilities;
+    return true;
+}
+
+TBool OhmSenderSlaves::Add(const Endpoint& aEndpoint, TUint aExpiry, TUint aCapabilities)
+{
+    ASSERT(Find(aEndpoint) == iCount);
+    if (iCount == kMaxSlaves) {
+        return false;
+    }
+    iSlaves[iCount++].Set(aEndpoint, aExpiry, aCapabilities);
+    return true;
+}
+
+TBool OhmSenderSlaves::Remove(const Endpoint& aEndpoint)
+{
+    const TUint index = Find(aEndpoint);
+    if (index == iCount) {
+        return false;
+    }
+    RemoveAt(index, "left");
+    return true;
+}
+
+TBool OhmSenderSlaves::RemoveExpired(TUint aNow)
+{
+    TBool changed = false;
+    for (TUint i = 0; i < iCount;) {
+        if ((TInt)(iSlaves[i].iExpiry - aNow) <= 0) {
+            RemoveAt(i, "expired");
+            changed = true;
+            continue;
+        }
+        i++;
+    }
+    return changed;
+}
+
+void OhmSenderSlaves::RemoveLast(Endpoint& aEndpoint, TUint& aExpiry, TUint& aCapabilities)
+{
+    ASSERT(iCount > 0);
+    const Slave& slave = iSlaves[iCount - 1];
+    aEndpoint.Replace(slave.iEndpoint);
+    aExpiry = slave.iExpiry;
+    aCapabilities = slave.iCapabilities;
+    RemoveAt(iCount - 1, "promoted to master");
+}
+
+TBool OhmSenderSlaves::TryEvictLast(TUint aMaxCount, Endpoint& aEndpoint)
+{
+    if (iCount <= aMaxCount) {
+        return false;
+    }
+    aEndpoint.Replace(iSlaves[iCount - 1].iEndpoint);
+    RemoveAt(iCount - 1, "evicted - master receiver can't forward to it");
+    return true;
+}
+
+void OhmSenderSlaves::NotifyResend(const Endpoint& aEndpoint, TUint aFrames)
+{
+    const TUint index = Find(aEndpoint);
+    if (index < iCount) {
+        iSlaves[index].iResendRequests++;
+        iSlaves[index].iFramesRequested += aFrames;
+    }
+}
+
+void OhmSenderSlaves::Externalise(IWriter& aWriter, TUint aMaxCount) const
+{
+    WriterBinary writer(aWriter);
+    const TUint count = (iCount < aMaxCount? iCount : aMaxCount);
     for (TUint i = 0; i < count; i++) {
-        iFifoHistory.Read()->RemoveRef();
+        writer.WriteUint32Be(iSlaves[i].iEndpoint.Address());
+        writer.WriteUint16Be(iSlaves[i].iEndpoint.Port());
+    }
+}
+
+TUint OhmSenderSlaves::Find(const Endpoint& aEndpoint) const
+{
+    for (TUint i = 0; i < iCount; i++) {
+        if (aEndpoint.Equals(iSlaves[i].iEndpoint)) {
+            return i;
+        }
+    }
+    return iCount;
+}
+
+void OhmSenderSlaves::RemoveAt(TUint aIndex, const TChar* aReason)
+{
+    const Slave& slave = iSlaves[aIndex];
+    Endpoint::EndpointBuf buf;
+    slave.iEndpoint.AppendEndpoint(buf);
+    LOG(kSongcast, "OhmSenderSlaves: %s %s (resend requests: %u, frames: %u)\n",
+                   buf.Ptr(), aReason, slave.iResendRequests, slave.iFramesRequested);
+    iCount--;
+    for (TUint i = aIndex; i < iCount; i++) {
+        iSlaves[i].Set(iSlaves[i + 1]);
     }
 }
 
@@ -531,9 +967,12 @@ OhmSender::OhmSender(Environment& aEnv, Net::DvDeviceStandard& aDevice, IOhmSend
     , iActive(false)
     , iAliveJoined(false)
     , iAliveBlocked(false)
+    , iMasterCapabilities(0)
     , iSequenceTrack(0)
     , iSequenceMetatext(0)
     , iClientControllingTrackMetadata(false)
+    , iReceiverCapabilitiesSeen(0)
+    , iReceiverCapabilitiesMissing(0)
 {
     iProvider = new ProviderSender(iDevice);
     CurrentSubnetChanged(); // roundabout way of initialising iInterface
@@ -821,6 +1260,7 @@ void OhmSender::RunMulticast()
         LOG(kSongcast, "OhmSender::RunMulticast wait\n");
         iThreadMulticast->Wait();
         LOG(kSongcast, "OhmSender::RunMulticast go\n");
+        ResetReceiverCapabilities();
         iDriver.SetEndpoint(iTargetEndpoint, iTargetInterface);
         LOG(kSongcast, "OHM SENDER DRIVER ENDPOINT %x:%d\n", iTargetEndpoint.Address(), iTargetEndpoint.Port());
         try {
@@ -831,6 +1271,7 @@ void OhmSender::RunMulticast()
                     
                     if (header.MsgType() <= OhmHeader::kMsgTypeListen) {
                         LOG(kSongcast, "OhmSender::RunMulticast join/listen received\n");
+                        UpdateReceiverCapabilities(header);
                         
                         AutoMutex mutex(iMutexActive);
                         
@@ -920,6 +1361,7 @@ void OhmSender::RunUnicast()
         LOG(kSongcast, "OhmSender::RunUnicast wait\n");
         iThreadUnicast->Wait();
         LOG(kSongcast, "OhmSender::RunUnicast go\n");
+        ResetReceiverCapabilities();
         try {
             for (;;) {
                 // wait for first receiver to join
@@ -932,6 +1374,7 @@ void OhmSender::RunUnicast()
                         
                         if (header.MsgType() <= OhmHeader::kMsgTypeListen) {
                             LOG(kSongcast, "OhmSender::RunUnicast ready/join or listen (%u)\n", header.MsgType());
+                            iMasterCapabilities = UpdateReceiverCapabilities(header);
                             break;                        
                         }
                     }
@@ -947,7 +1390,8 @@ void OhmSender::RunUnicast()
                 LOG(kSongcast, "OHM SENDER DRIVER ENDPOINT %x:%d\n", iTargetEndpoint.Address(), iTargetEndpoint.Port());
                 SendTrack();
                 SendMetatext();
-                iSlaveCount = 0;
+                iSlaves.Clear();
+                UpdateCompression();
                 { // scope for AutoMutex
                     AutoMutex mutex(iMutexActive);
                     iActive = true;
@@ -964,30 +1408,19 @@ void OhmSender::RunUnicast()
                         
                         if (header.MsgType() == OhmHeader::kMsgTypeJoin) {
                             LOG(kSongcast, "OhmSender::RunUnicast sending/join\n");
+                            const TUint capabilities = UpdateReceiverCapabilities(header);
                             Endpoint sender(iSocketOhm.Sender());
                             if (sender.Equals(iTargetEndpoint)) {
+                                iMasterCapabilities = capabilities;
                                 iTimerExpiry->FireIn(kTimerExpiryTimeoutMs);
                             }
-                            else {
-                                TUint slave = FindSlave(sender);
-                                if (slave >= iSlaveCount) {
-                                    if (slave < kMaxSlaveCount) {
-                                        iSlaveList[slave].Replace(sender);
-                                        iSlaveExpiry[slave] = Time::Now(iEnv) + kTimerExpiryTimeoutMs;
-                                        iSlaveCount++;
-
-                                        Endpoint::EndpointBuf buf;
-                                        sender.AppendEndpoint(buf);
-                                        LOG(kSongcast, "OhmSender::RunUnicast new slave: %s (#%u)\n", buf.Ptr(), iSlaveCount);
-
-                                        AutoMutex mutex(iMutexActive);
-                                        SendListen(sender);
-                                    }
-                                }
-                                else {
-                                    iSlaveExpiry[slave] = Time::Now(iEnv) + kTimerExpiryTimeoutMs;
+                            else if (!iSlaves.Refresh(sender, Time::Now(iEnv) + kTimerExpiryTimeoutMs, capabilities)) {
+                                if (AddSlave(sender, capabilities)) {
+                                    AutoMutex mutex(iMutexActive);
+                                    SendListen(sender);
                                 }
                             }
+                            UpdateCompression(); // before the master receiver can start forwarding audio to any new slave
 
                             AutoMutex mutex(iMutexActive);
                             SendSlaveList();
@@ -995,6 +1428,7 @@ void OhmSender::RunUnicast()
                             SendMetatext();
                         }
                         else if (header.MsgType() == OhmHeader::kMsgTypeListen) {
+                            const TUint capabilities = UpdateReceiverCapabilities(header);
                             Endpoint sender(iSocketOhm.Sender());
 
                             Endpoint::EndpointBuf endptBuf;
@@ -1002,32 +1436,27 @@ void OhmSender::RunUnicast()
                             LOG(kSongcast, "OhmSender::RunUnicast sending/listen from %s\n", endptBuf.Ptr());
 
                             if (sender.Equals(iTargetEndpoint)) {
+                                iMasterCapabilities = capabilities;
                                 iTimerExpiry->FireIn(kTimerExpiryTimeoutMs);
-                                if (CheckSlaveExpiry()) {
+                                const TBool expired = iSlaves.RemoveExpired(Time::Now(iEnv));
+                                UpdateCompression();
+                                if (expired || iSlaves.Count() > MaxSlaveCount()) { // SendSlaveList evicts any the master can no longer support
                                     AutoMutex mutex(iMutexActive);
                                     SendSlaveList();
                                 }
                             }
+                            else if (iSlaves.Refresh(sender, Time::Now(iEnv) + kTimerExpiryTimeoutMs, capabilities)) {
+                                UpdateCompression();
+                            }
                             else {
-                                TUint slave = FindSlave(sender);
-                                if (slave < iSlaveCount) {
-                                    iSlaveExpiry[slave] = Time::Now(iEnv) + kTimerExpiryTimeoutMs;
-                                }
-                                else {
-                                    // unknown slave, probably temporarily physically disconnected receiver
-                                    if (slave < kMaxSlaveCount) {
-                                        iSlaveList[slave].Replace(sender);
-                                        iSlaveExpiry[slave] = Time::Now(iEnv) + kTimerExpiryTimeoutMs;
-                                        iSlaveCount++;
-
-                                        LOG(kSongcast, "OhmSender::RunUnicast new slave: %s (#%u)\n", endptBuf.Ptr(), iSlaveCount);
-
-                                        AutoMutex mutex(iMutexActive);
-                                        SendListen(sender);
-                                        SendSlaveList();
-                                        SendTrack();
-                                        SendMetatext();
-                                    }
+                                // unknown slave, probably temporarily physically disconnected receiver
+                                if (AddSlave(sender, capabilities)) {
+                                    UpdateCompression();
+                                    AutoMutex mutex(iMutexActive);
+                                    SendListen(sender);
+                                    SendSlaveList();
+                                    SendTrack();
+                                    SendMetatext();
                                 }
                             }
                         }
@@ -1038,28 +1467,27 @@ void OhmSender::RunUnicast()
                             LOG(kSongcast, "OhmSender::RunUnicast LEAVE from %s\n", endptBuf.Ptr());
                             if (sender.Equals(iTargetEndpoint) || sender.Equals(iSocketOhm.This())) {
                                 iTimerExpiry->Cancel();
-                                if (iSlaveCount == 0) {
+                                if (iSlaves.Count() == 0) {
                                     break;
                                 }
                                 else {
                                     AutoMutex mutex(iMutexActive);
-                                    iTargetEndpoint.Replace(iSlaveList[--iSlaveCount]);
-                                    iTimerExpiry->FireAt(iSlaveExpiry[iSlaveCount]);
-                                    if (iSlaveCount > 0) {
+                                    TUint expiry;
+                                    iSlaves.RemoveLast(iTargetEndpoint, expiry, iMasterCapabilities);
+                                    UpdateCompression();
+                                    iTimerExpiry->FireAt(expiry);
+                                    if (iSlaves.Count() > 0) {
                                         SendSlaveList();
                                     }
                                     iDriver.SetEndpoint(iTargetEndpoint, iTargetInterface);
                                     LOG(kSongcast, "OHM SENDER DRIVER ENDPOINT %x:%d\n", iTargetEndpoint.Address(), iTargetEndpoint.Port());
                                 }
                             }
-                            else {
-                                TUint slave = FindSlave(sender);
-                                if (slave < iSlaveCount) {
-                                    RemoveSlave(slave);
-                                    AutoMutex mutex(iMutexActive);
-                                    SendLeave(sender);
-                                    SendSlaveList();
-                                }
+                            else if (iSlaves.Remove(sender)) {
+                                UpdateCompression();
+                                AutoMutex mutex(iMutexActive);
+                                SendLeave(sender);
+                                SendSlaveList();
                             }
                         }
                         else if (header.MsgType() == OhmHeader::kMsgTypeResend) {
@@ -1068,6 +1496,7 @@ void OhmSender::RunUnicast()
                             headerResend.Internalise(iRxBuffer, header);
                             TUint frames = headerResend.FramesCount();
                             if (frames > 0) {
+                                iSlaves.NotifyResend(iSocketOhm.Sender(), frames);
                                 iDriver.Resend(iRxBuffer.Read(frames * 4));
                             }
                         }
@@ -1258,17 +1687,27 @@ void OhmSender::SendMetatext()
 void OhmSender::SendSlaveList()
 {
     // called with alive mutex locked;
-    OhmHeaderSlave headerSlave(iSlaveCount);
+    // older master receivers copy the list into a fixed array of OhmHeaderSlave::kMaxSlaveCountLegacy entries without checking its size.
+    // Slaves that don't fit (e.g. after a legacy slave is promoted to master) would get no audio so are told to leave.
+    const TUint maxCount = MaxSlaveCount();
+    Endpoint evicted;
+    TBool anyEvicted = false;
+    while (iSlaves.TryEvictLast(maxCount, evicted)) {
+        LOG2(kSongcast, kError, "OhmSender: master receiver only supports %u slaves\n", maxCount);
+        SendLeave(evicted);
+        anyEvicted = true;
+    }
+    if (anyEvicted) {
+        UpdateCompression();
+    }
+    const TUint count = iSlaves.Count();
+    OhmHeaderSlave headerSlave(count);
     OhmHeader header(OhmHeader::kMsgTypeSlave, headerSlave.MsgBytes());
     WriterBuffer writer(iTxBuffer);
     writer.Flush();
     header.Externalise(writer);
     headerSlave.Externalise(writer);
-    WriterBinary binary(writer);
-    for (TUint i = 0; i < iSlaveCount; i++) {
-        binary.WriteUint32Be(iSlaveList[i].Address());
-        binary.WriteUint16Be(iSlaveList[i].Port());
-    }
+    iSlaves.Externalise(writer, count);
     Send();
 }
 
@@ -1306,39 +1745,68 @@ void OhmSender::SendLeave(const Endpoint& aEndpoint)
     }
 }
 
-TBool OhmSender::CheckSlaveExpiry()
+TBool OhmSender::AddSlave(const Endpoint& aEndpoint, TUint aCapabilities)
 {
-    TBool changed = false;
-    for (TUint i = 0; i < iSlaveCount;) {
-        if (Time::IsInPastOrNow(iEnv, iSlaveExpiry[i])) {
-            RemoveSlave(i);
-            changed = true;
-            continue;
-        }
-        i++;
+    Endpoint::EndpointBuf buf;
+    aEndpoint.AppendEndpoint(buf);
+    if (iSlaves.Count() >= MaxSlaveCount() || !iSlaves.Add(aEndpoint, Time::Now(iEnv) + kTimerExpiryTimeoutMs, aCapabilities)) {
+        LOG2(kSongcast, kError, "OhmSender: ignoring slave %s - already have %u\n", buf.Ptr(), iSlaves.Count());
+        return false;
     }
-    
-    return changed;
+    LOG(kSongcast, "OhmSender::RunUnicast new slave: %s (#%u)\n", buf.Ptr(), iSlaves.Count());
+    return true;
 }
 
-void OhmSender::RemoveSlave(TUint aIndex)
+TUint OhmSender::MaxSlaveCount() const
 {
-    iSlaveCount--;
-    for (TUint i = aIndex; i < iSlaveCount; i++) {
-        iSlaveList[i].Replace(iSlaveList[i + 1]);
-        iSlaveExpiry[i] = iSlaveExpiry[i + 1];
+    if ((iMasterCapabilities & OhmHeaderJoin::kCapabilitySlaves) != 0) {
+        return OhmSenderSlaves::kMaxSlaves;
     }
+    return OhmHeaderSlave::kMaxSlaveCountLegacy;
 }
 
-// Returns index of supplied endpoint, or index of empty slot if not found
-// distinguish between the two by comparing returned value with iSlaveCount
-  
-TUint OhmSender::FindSlave(const Endpoint& aEndpoint)
+void OhmSender::ResetReceiverCapabilities()
 {
-    for (TUint i = 0; i < iSlaveCount; i++) {
-        if (aEndpoint.Equals(iSlaveList[i])) {
-            return i;
+    iMasterCapabilities = 0;
+    iReceiverCapabilitiesSeen = 0;
+    iReceiverCapabilitiesMissing = 0;
+    iDriver.SetCompression(false);
+    iDriver.SetFec(0);
+}
+
+TUint OhmSender::UpdateReceiverCapabilities(const OhmHeader& aHeader)
+{
+    /* Receivers don't identify themselves in multicast mode so we can't track them individually.
+       Only use a capability while no receiver has joined/listened without advertising
+       support for it for as long as it'd take us to notice that receiver had gone.
+       Compression isn't enabled here - see UpdateCompression(). */
+    OhmHeaderJoin headerJoin;
+    headerJoin.Internalise(iRxBuffer, aHeader);
+    const TUint capabilities = headerJoin.Capabilities();
+    const TUint now = Time::Now(iEnv);
+    iReceiverCapabilitiesSeen |= capabilities;
+    for (TUint i=0; i<kReceiverCapabilityCount; i++) {
+        const TUint capability = 1 << i;
+        if ((capabilities & capability) == 0) {
+            iReceiverCapabilitiesMissing |= capability;
+            iReceiverCapabilityMissingExpiry[i] = now + kTimerAliveJoinTimeoutMs;
         }
+        else if ((iReceiverCapabilitiesMissing & capability) != 0 && (TInt)(iReceiverCapabilityMissingExpiry[i] - now) <= 0) {
+            iReceiverCapabilitiesMissing &= ~capability;
+        }
+    }
+    const TUint enabled = iReceiverCapabilitiesSeen & ~iReceiverCapabilitiesMissing;
+    iDriver.SetFec((enabled & OhmHeaderJoin::kCapabilityFec) != 0? kFecGroupFrames : 0);
+    return capabilities;
+}
+
+void OhmSender::UpdateCompression()
+{
+    /* Unicast only.  A multicast receiver that lost a join could still be listening so compressed
+       audio is only sent once the master receiver and every slave it forwards audio to have opted in. */
+    TBool compress = ((iMasterCapabilities & OhmHeaderJoin::kCapabilityLossless) != 0);
+    for (TUint i = 0; compress && i < iSlaves.Count(); i++) {
+        compress = ((iSlaves.At(i).Capabilities() & OhmHeaderJoin::kCapabilityLossless) != 0);
     }
-    return iSlaveCount;
+    iDriver.SetCompression(compress);
 }
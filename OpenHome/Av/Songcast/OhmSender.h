@@ -15,6 +15,10 @@
 #include "OhmMsg.h"
 #include "OhmSocket.h"
 #include "OhmSenderDriver.h"
+#include "OhmLossless.h"
+#include "OhmFec.h"
+
+#include <vector>
 
 namespace OpenHome {
 class Environment;
@@ -23,26 +27,65 @@ namespace Av {
 class ProviderSender;
 class IOhmTimestamper;
 
+/*
+ * Audio msgs recently sent, indexed by frame number so that resend requests can be answered
+ * without searching.  Holds a reference to each msg.
+ * Depth (the number of most recent frames retained) can be changed at any time up to the
+ * capacity passed to the constructor.
+ */
+class OhmSenderHistory : private INonCopyable
+{
+public:
+    OhmSenderHistory(TUint aMaxFrames);
+    ~OhmSenderHistory();
+    TUint MaxFrames() const;
+    TUint Depth() const;
+    void SetDepth(TUint aFrames);
+    void Add(OhmMsgAudio* aMsg);           // takes ownership of caller's ref
+    OhmMsgAudio* Find(TUint aFrame) const; // returns nullptr if aFrame has been evicted (or was never added)
+    void Replace(OhmMsgAudio& aOld, OhmMsgAudio* aNew); // aOld must have been returned by Find(); takes ownership of caller's ref to aNew (which may be nullptr)
+    TUint Count() const;
+    void Clear();
+private:
+    void EvictExpired();
+private:
+    std::vector<OhmMsgAudio*> iSlots;
+    TUint iDepth;
+    TUint iLatestFrame;
+    TUint iCount;
+};
+
 class OhmSenderDriver : public IOhmSenderDriver
 {
     static const TUint kMaxAudioFrameBytes = 6 * 1024;
-    static const TUint kMaxHistoryFrames = 100;
+    static const TUint kNominalFrameMs = 5;      // see Sender::kSongcastPacketMs
+    static const TUint kHistoryMarginFrames = 20; // allow for resend requests being sent/processed after a frame's deadline
+    static const TUint kMinHistoryFrames = 100;
 public:
-    OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper);
+    OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper, TUint aMaxLatencyMs);
     void SetAudioFormat(TUint aSampleRate, TUint aBitRate, TUint aChannels, TUint aBitDepth, TBool aLossless, const Brx& aCodecName, TUint64 aSampleStart);
     void SendAudio(const TByte* aData, TUint aBytes, TBool aHalt = false);
     OhmMsgAudio* CreateAudio();
     void SendAudio(OhmMsgAudio* aMsg, TBool aHalt = false);
+    TBool TrySkipAudio(TUint aSamples); // accounts for aSamples without sending them iff there are no receivers
 private: // from IOhmSenderDriver
     void SetEnabled(TBool aValue) override;
     void SetActive(TBool aValue) override;
     void SetEndpoint(const Endpoint& aEndpoint, TIpAddress aAdapter) override;
     void SetTtl(TUint aValue) override;
     void SetLatency(TUint aValue) override;
+    void SetCompression(TBool aEnable) override;
+    void SetFec(TUint aGroupFrames) override;
     void SetTrackPosition(TUint64 aSampleStart, TUint64 aSamplesTotal) override;
     void Resend(const Brx& aFrames) override;
 private:
     inline void UpdateLatencyOhm();
+    static TUint HistoryFrames(TUint aLatencyMs);
+    void UpdateHistoryDepth();
+    TBool Compress(const Brx& aAudio);
+    void PrepareDecompressLocked();
+    void DecompressHistory();
+    void SendParity(OhmMsgAudio& aMsg);
     void ResetLocked();
     void Resend(OhmMsgAudio& aMsg);
 private:
@@ -57,18 +100,87 @@ private:
     TUint iSampleRate;
     TUint iTimestampMultiplier;
     TUint iBytesPerSample;
+    TUint iChannels;
+    TUint iBitDepth;
     TBool iLossless;
+    TBool iCompress;
+    OhmLosslessCodec iCodec;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iCompressed;
+    // guarded by iMutexDecompress; history frames before iDecompressFrame may be compressed in the format described
+    Mutex iMutexDecompress;
+    OhmLosslessCodec iDecompressCodec;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iDecompressed;
+    Bws<OhmMsgAudio::kStreamHeaderBytes> iDecompressHeader;
+    TUint iDecompressFrame;
+    TUint iDecompressChannels;
+    TUint iDecompressBitDepth;
+    OhmFecEncoder iFec;
     TUint64 iSamplesTotal;
     TUint64 iSampleStart;
     TUint iLatencyMs;
     TUint iLatencyOhm;
     SocketUdp iSocket;
+    const TUint iMaxHistoryFrames;
     OhmMsgFactory iFactory;
-    FifoLite<OhmMsgAudio*, kMaxHistoryFrames> iFifoHistory;
+    OhmSenderHistory iHistory;
+    TUint iResendHits;      // frames resent
+    TUint iResendMisses;    // frames requested that had already been evicted from history
+    TUint64 iResendBytes;
     IOhmTimestamper* iTimestamper;
     TBool iFirstFrame;
 };
 
+/*
+ * Unicast receivers that are fed audio by the master receiver rather than directly by OhmSender.
+ * Each slave has its own expiry time, capabilities (as advertised in its last join/listen) and
+ * resend (loss) statistics.
+ * Times are in ms, as returned by Time::Now().
+ */
+class OhmSenderSlaves : private INonCopyable
+{
+public:
+    static const TUint kMaxSlaves = OhmHeaderSlave::kMaxSlaveCount;
+    class Slave
+    {
+        friend class OhmSenderSlaves;
+    public:
+        Slave();
+        const Endpoint& GetEndpoint() const;
+        TUint Expiry() const;
+        TUint Capabilities() const;
+        TUint ResendRequests() const;
+        TUint FramesRequested() const;
+    private:
+        void Set(const Endpoint& aEndpoint, TUint aExpiry, TUint aCapabilities);
+        void Set(const Slave& aSlave);
+    private:
+        Endpoint iEndpoint;
+        TUint iExpiry;
+        TUint iCapabilities;
+        TUint iResendRequests;
+        TUint iFramesRequested;
+    };
+public:
+    OhmSenderSlaves();
+    void Clear();
+    TUint Count() const;
+    const Slave& At(TUint aIndex) const;
+    TBool Refresh(const Endpoint& aEndpoint, TUint aExpiry, TUint aCapabilities); // returns false if aEndpoint isn't a slave
+    TBool Add(const Endpoint& aEndpoint, TUint aExpiry, TUint aCapabilities);     // returns false if there are already kMaxSlaves
+    TBool Remove(const Endpoint& aEndpoint);                 // returns false if aEndpoint isn't a slave
+    TBool RemoveExpired(TUint aNow);                         // returns true if any slaves were removed
+    void RemoveLast(Endpoint& aEndpoint, TUint& aExpiry, TUint& aCapabilities);
+    TBool TryEvictLast(TUint aMaxCount, Endpoint& aEndpoint); // removes the last slave iff there are more than aMaxCount
+    void NotifyResend(const Endpoint& aEndpoint, TUint aFrames);
+    void Externalise(IWriter& aWriter, TUint aMaxCount) const; // address/port list of the first aMaxCount slaves, as sent in OhmHeader::kMsgTypeSlave
+private:
+    TUint Find(const Endpoint& aEndpoint) const; // returns Count() if not found
+    void RemoveAt(TUint aIndex, const TChar* aReason);
+private:
+    Slave iSlaves[kMaxSlaves];
+    TUint iCount;
+};
+
 class OhmSender
 {
     static const TUint kMaxMetadataBytes = 1000;
@@ -77,8 +189,9 @@ class OhmSender
     static const TUint kTimerAliveJoinTimeoutMs = 10000;
     static const TUint kTimerAliveAudioTimeoutMs = 3000;
     static const TUint kTimerExpiryTimeoutMs = 10000;
-    static const TUint kMaxSlaveCount = 4;
     static const TUint kTtl = 1;
+    static const TUint kFecGroupFrames = 10;
+    static const TUint kReceiverCapabilityCount = 2; // OhmHeaderJoin bits (lossless, fec) tracked across all receivers
 public:
     static const TUint kMaxNameBytes = 64;
     static const TUint kMaxTrackUriBytes = Ohm::kMaxTrackUriBytes;
@@ -123,9 +236,11 @@ private:
     void SendSlaveList();
     void SendListen(const Endpoint& aEndpoint);
     void SendLeave(const Endpoint& aEndpoint);
-    TUint FindSlave(const Endpoint& aEndpoint);
-    void RemoveSlave(TUint aIndex);
-    TBool CheckSlaveExpiry();
+    TBool AddSlave(const Endpoint& aEndpoint, TUint aCapabilities);
+    TUint MaxSlaveCount() const;
+    void ResetReceiverCapabilities();
+    TUint UpdateReceiverCapabilities(const OhmHeader& aHeader); // returns capabilities advertised in aHeader
+    void UpdateCompression();
 private:
     Environment& iEnv;
     Net::DvDeviceStandard& iDevice;
@@ -160,9 +275,8 @@ private:
     TUint iNacnId;
     Uri iSenderUri;
     Bws<kMaxMetadataBytes> iSenderMetadata;
-    TUint iSlaveCount;
-    Endpoint iSlaveList[kMaxSlaveCount];
-    TUint iSlaveExpiry[kMaxSlaveCount];
+    OhmSenderSlaves iSlaves;
+    TUint iMasterCapabilities; // as advertised by the unicast receiver iTargetEndpoint
     Timer* iTimerAliveJoin;
     Timer* iTimerAliveAudio;
     Timer* iTimerExpiry;
@@ -172,6 +286,9 @@ private:
     TUint iSequenceTrack;
     TUint iSequenceMetatext;
     TBool iClientControllingTrackMetadata;
+    TUint iReceiverCapabilitiesSeen;
+    TUint iReceiverCapabilitiesMissing;
+    TUint iReceiverCapabilityMissingExpiry[kReceiverCapabilityCount];
 };
 
 } // namespace Av
@@ -15,6 +15,8 @@ public:
     virtual void SetActive(TBool aValue) = 0;
     virtual void SetTtl(TUint aValue) = 0;
     virtual void SetLatency(TUint aValue) = 0;
+    virtual void SetCompression(TBool aEnable) = 0; // only enabled when all receivers can decode compressed audio
+    virtual void SetFec(TUint aGroupFrames) = 0;    // parity msg every aGroupFrames audio msgs; 0 disables
     virtual void SetTrackPosition(TUint64 aSampleStart, TUint64 aSamplesTotal) = 0;
     virtual void Resend(const Brx& aFrames) = 0;
     virtual ~IOhmSenderDriver() {}
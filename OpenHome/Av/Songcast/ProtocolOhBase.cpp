@@ -5,24 +5,28 @@
 #include <OpenHome/Av/Songcast/OhmMsg.h>
 #include <OpenHome/Av/Songcast/Ohm.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/ClockPuller.h>
 #include <OpenHome/Av/Debug.h>
 #include <OpenHome/Private/Timer.h>
 #include <OpenHome/Private/Uri.h>
 #include <OpenHome/Private/Ascii.h>
 #include <OpenHome/Private/Parser.h>
 #include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Converter.h>
 #include <OpenHome/Private/Env.h>
 #include <OpenHome/OsWrapper.h>
 #include <OpenHome/Private/NetworkAdapterList.h>
 
+#include <algorithm>
+
 using namespace OpenHome;
 using namespace OpenHome::Av;
 using namespace OpenHome::Media;
 
 ProtocolOhBase::ProtocolOhBase(Environment& aEnv, IOhmMsgFactory& aFactory, Media::TrackFactory& aTrackFactory,
-                               Optional<IOhmTimestamper> aTimestamper, const TChar* aSupportedScheme, const Brx& aMode,
-                               Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
-    : Protocol(aEnv)
+                               Optional<IOhmTimestamper> aTimestamper, Optional<Media::IClockPullerTimestamp> aClockPuller,
+                               const TChar* aSupportedScheme, const Brx& aMode, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
+    : Protocol(aEnv, aSupportedScheme)
     , iEnv(aEnv)
     , iMsgFactory(aFactory)
     , iSupply(nullptr)
@@ -47,15 +51,20 @@ ProtocolOhBase::ProtocolOhBase(Environment& aEnv, IOhmMsgFactory& aFactory, Medi
     , iSampleRate(0)
     , iNumChannels(0)
     , iLatency(0)
-    , iRepairFirst(nullptr)
+    , iStats(aSupportedScheme, aClockPuller)
+    , iRecoveringFec(false)
+    , iClockPuller(aClockPuller.Ptr())
+    , iClockPullerRxValid(false)
+    , iClockPullerRxFrame(0)
+    , iClockPullerRxTimestamp(0)
     , iPipelineEmpty("OHBS", 0)
     , iOhmMsgProcessor(aOhmMsgProcessor)
 {
     iNacnId = iEnv.NetworkAdapterList().AddCurrentChangeListener(MakeFunctor(*this, &ProtocolOhBase::CurrentSubnetChanged), "ProtocolOhBase", false);
     iTimerRepair = new Timer(aEnv, MakeFunctor(*this, &ProtocolOhBase::TimerRepairExpired), "ProtocolOhBaseRepair");
-    iRepairFrames.reserve(kMaxRepairBacklogFrames);
     iTimerJoin = new Timer(aEnv, MakeFunctor(*this, &ProtocolOhBase::SendJoin), "ProtocolOhBaseJoin");
     iTimerListen = new Timer(aEnv, MakeFunctor(*this, &ProtocolOhBase::SendListen), "ProtocolOhBaseListen");
+    ClearRequested();
 
     AutoNetworkAdapterRef ref(iEnv, "Songcast");
     const auto current = ref.Adapter();
@@ -71,6 +80,11 @@ ProtocolOhBase::~ProtocolOhBase()
     delete iSupply;
 }
 
+const OhmReceiverStats& ProtocolOhBase::ReceiverStats() const
+{
+    return iStats;
+}
+
 void ProtocolOhBase::Add(OhmMsg* aMsg)
 {
     aMsg->Process(*this);
@@ -79,13 +93,31 @@ void ProtocolOhBase::Add(OhmMsg* aMsg)
     }
 }
 
-void ProtocolOhBase::ResendSeen()
+void ProtocolOhBase::ResendSeen(const OhmHeader& aHeader)
 {
-    iMutexTransport.Wait();
-    if (iRepairing) {
-        iTimerRepair->FireIn(kSubsequentRepairTimeoutMs);
+    OhmHeaderResend headerResend;
+    headerResend.Internalise(iReadBuffer, aHeader);
+    if (iSocket.Sender().Address() == iAddr) {
+        return; // our own request, looped back by the multicast group
+    }
+    const TUint maxFrames = ResendPacer::kMaxHeardFrames;
+    const TUint count = std::min(headerResend.FramesCount(), maxFrames);
+    const Brn frames = iReadBuffer.Read(count * 4);
+    const TUint64 now = OsTimeInUs(iEnv.OsCtx());
+
+    AutoMutex _(iMutexTransport);
+    TBool backoff = false;
+    for (TUint i=0; i<count; i++) {
+        const TUint frame = Converter::BeUint32At(frames, i * 4);
+        iResendPacer.NotifyHeard(frame, now);
+        if (iRepairing && frame == iRepairBuffer.Next()) {
+            backoff = true;
+        }
+    }
+    if (backoff) {
+        // another receiver is missing the same audio; give the sender time to answer them before we ask too
+        iTimerRepair->FireIn(iResendPacer.TimeoutMs());
     }
-    iMutexTransport.Signal();
 }
 
 void ProtocolOhBase::RequestResend(const Brx& aFrames)
@@ -123,10 +155,19 @@ void ProtocolOhBase::SendListen()
 
 void ProtocolOhBase::Send(TUint aType)
 {
-    Bws<OhmHeader::kHeaderBytes> buffer;
+    Bws<OhmHeader::kHeaderBytes + OhmHeaderJoin::kHeaderBytes> buffer;
     WriterBuffer writer(buffer);
-    OhmHeader msg(aType, 0);
-    msg.Externalise(writer);
+    if (aType == OhmHeader::kMsgTypeJoin || aType == OhmHeader::kMsgTypeListen) {
+        // advertise that we can decode compressed audio, use parity msgs and forward to a full slave list; older senders ignore this
+        OhmHeaderJoin headerJoin(OhmHeaderJoin::kCapabilityLossless | OhmHeaderJoin::kCapabilityFec | OhmHeaderJoin::kCapabilitySlaves);
+        OhmHeader msg(aType, headerJoin.MsgBytes());
+        msg.Externalise(writer);
+        headerJoin.Externalise(writer);
+    }
+    else {
+        OhmHeader msg(aType, 0);
+        msg.Externalise(writer);
+    }
     try {
         iSocket.Send(buffer, iEndpoint);
     }
@@ -172,6 +213,13 @@ ProtocolStreamResult ProtocolOhBase::Stream(const Brx& aUri)
     }
     iStarving = false;
     iSocket.Interrupt(false);
+    iFecDecoder.Reset();
+    iStats.Start();
+    {
+        AutoMutex _(iMutexTransport);
+        iResendPacer.Reset();
+        ClearRequested();
+    }
     Endpoint ep;
     try {
         ep.SetPort(iUri.Port());
@@ -194,7 +242,6 @@ ProtocolStreamResult ProtocolOhBase::Stream(const Brx& aUri)
 
     iMutexTransport.Wait();
     RepairReset();
-    iFrame = 0;
     iTrackMsgDue = false;
     iStreamMsgDue = true;
     iMetatextMsgDue = false;
@@ -206,6 +253,11 @@ ProtocolStreamResult ProtocolOhBase::Stream(const Brx& aUri)
     iLatency = 0;
     iStreamId = IPipelineIdProvider::kStreamIdInvalid;
     iMutexTransport.Signal();
+    iStats.Stop();
+    OhmReceiverStats::Values stats;
+    iStats.Get(stats);
+    LOG(kSongcast, "ProtocolOhBase: frames received: %u, missing: %u, recovered by FEC: %u, by resend: %u, concealed: %u\n",
+                   stats.iFramesReceived, stats.iFramesMissing, stats.iFramesRecoveredFec, stats.iFramesRecoveredResend, stats.iFramesConcealed);
 
     return res;
 }
@@ -215,6 +267,11 @@ ProtocolGetResult ProtocolOhBase::Get(IWriter& /*aWriter*/, const Brx& /*aUri*/,
     return EProtocolGetErrorNotSupported;
 }
 
+void ProtocolOhBase::WriteInfo(IWriter& aWriter)
+{
+    iStats.WriteInfo(aWriter);
+}
+
 EStreamPlay ProtocolOhBase::OkToPlay(TUint aStreamId)
 {
     auto canPlay = iIdProvider->OkToPlay(aStreamId);
@@ -244,8 +301,13 @@ void ProtocolOhBase::CurrentSubnetChanged()
 TBool ProtocolOhBase::RepairBegin(OhmMsgAudio& aMsg)
 {
     LOG(kSongcast, "BEGIN ON %d\n", aMsg.Frame());
-    iRepairFirst = &aMsg;
-    iTimerRepair->FireIn(iEnv.Random(kInitialRepairTimeoutMs)); 
+    if (iRepairBuffer.Insert(aMsg, aMsg.Frame()) != RepairBuffer::eStored) {
+        // too far ahead of the last frame output to ever repair; treat this as a discontinuity
+        RepairReset();
+        aMsg.RemoveRef();
+        return false;
+    }
+    iTimerRepair->FireIn(iEnv.Random(iResendPacer.InitialTimeoutMs()));
     return true;
 }
 
@@ -257,14 +319,10 @@ void ProtocolOhBase::RepairReset()
     iMutexTransport.Signal();
     iTimerRepair->Cancel();
     iMutexTransport.Wait();
-    if (iRepairFirst != nullptr) {
-        iRepairFirst->RemoveRef();
-        iRepairFirst = nullptr;
-    }
-    for (TUint i=0; i<iRepairFrames.size(); i++) {
-        iRepairFrames[i]->RemoveRef();
+    while (!iRepairBuffer.Empty()) {
+        iRepairBuffer.SkipGap();
+        iRepairBuffer.Pop()->RemoveRef();
     }
-    iRepairFrames.clear();
     iRunning = false;
     iRepairing = false; // FIXME - not absolutely required as test for iRunning takes precedence in Process(OhmMsgAudio&
     iStreamMsgDue = true; // a failed repair implies a discontinuity in audio.  This should be noted as a new stream.
@@ -277,10 +335,15 @@ TBool ProtocolOhBase::Repair(OhmMsgAudio& aMsg)
     LOG(kSongcast, "GOT %d\n", frame);
 
     // get difference between this and the last frame sent down the pipeline
-    TInt diff = frame - iFrame;
+    TInt diff = RepairBuffer::Diff(frame, iRepairBuffer.Last());
     if (diff < 1) {
         TBool repairing = true;
-        if (!aMsg.Resent()) {
+        if (aMsg.Resent()) {
+            if (WasRequested(frame)) { // not just resent for another receiver
+                iStats.NotifyLate();
+            }
+        }
+        else {
             // A frame in the past that is not a resend implies that the sender has reset their frame count
             RepairReset();
             repairing = false;
@@ -290,149 +353,143 @@ TBool ProtocolOhBase::Repair(OhmMsgAudio& aMsg)
         aMsg.RemoveRef();
         return repairing;
     }
-    if (diff > (TInt)kMaxRepairBacklogFrames) {
-        // we're so far behind that we can't fit all the missing frames into iRepairFrames
-        RepairReset();
-        aMsg.RemoveRef();
-        return false;
+    const TInt ahead = RepairBuffer::Diff(frame, iRepairBuffer.Newest());
+    if (ahead > 1) {
+        iStats.NotifyMissing(ahead - 1);
     }
-    if (diff == 1) {
-        // incoming frame is one greater than the last frame sent down the pipeline, so send this ...
-        iFrame++;
-        OutputAudio(aMsg);
-        // ... and see if the current first waiting frame is now also ready to be sent
-        while (iRepairFirst->Frame() == iFrame + 1) {
-            // ... yes, it is, so send it
-            iFrame++;
-            OutputAudio(*iRepairFirst);
-            // ... and see if there are further messages waiting
-            if (iRepairFrames.size() == 0) {
-                // ... no, so we have completed the repair
-                iRepairFirst = nullptr;
-                LOG(kSongcast, "END\n");
+    if (diff > (TInt)kMaxRepairBacklogFrames) {
+        // we're so far behind that we can't fit all the missing frames into iRepairBuffer
+        if (ahead > (TInt)kMaxRepairBacklogFrames) {
+            // ...and never will; treat this as a discontinuity
+            RepairReset();
+            aMsg.RemoveRef();
+            return false;
+        }
+        // ...so give up on the oldest gaps, rather than everything we've buffered, until this frame fits
+        TBool repairing = true;
+        while (repairing && diff > (TInt)kMaxRepairBacklogFrames) {
+            repairing = RepairAbandonOldest();
+            diff = RepairBuffer::Diff(frame, iRepairBuffer.Last());
+        }
+        if (!repairing) {
+            if (diff == 1) {
+                iRepairBuffer.SetLast(frame);
+                OutputAudio(aMsg);
                 return false;
             }
-            // ... yes, so update the current first waiting frame and continue testing to see if this can also be sent
-            iRepairFirst = iRepairFrames[0];
-            iRepairFrames.erase(iRepairFrames.begin());
+            return RepairBegin(aMsg);
         }
-        // ... we're done
-        return true;
     }
 
-    // Ok, its a frame that needs to be put into the backlog, but where?
-    // compare it to the current first waiting frame
-    diff = frame - iRepairFirst->Frame();
-    if (diff == 0) {
-        // it's equal to the currently first waiting frame, so discard it - it's a duplicate
+    // in multicast mode we also see frames resent for other receivers; only count those that filled one of our gaps
+    const TBool recovered = aMsg.Resent() && (ahead < 0 || WasRequested(frame));
+    if (iRepairBuffer.Insert(aMsg, frame) == RepairBuffer::eDuplicate) {
         aMsg.RemoveRef();
         return true;
     }
-    if (diff < 0) {
-        // it's earlier than the current first waiting message, so it should become the new current first waiting frame
-        // and the old first waiting frame needs to be injected into the start of the backlog, so inject it into the end
-        // and rotate the others (if there is space to add another frame)
-        if (iRepairFrames.size() == kMaxRepairBacklogFrames) {
-            // can't fit another frame into the backlog
-            RepairReset();
-            aMsg.RemoveRef();
-            return false;
-        }
-        iRepairFrames.insert(iRepairFrames.begin(), iRepairFirst);
-        iRepairFirst = &aMsg;
-        return true;
+    if (recovered) {
+        iStats.NotifyRecoveredResend();
     }
-    // ok, it's after the currently first waiting frame, so it needs to go into the backlog
-    // first check if the backlog is empty
-    if (iRepairFrames.size() == 0) {
-        // ... yes, so just inject it
-        iRepairFrames.insert(iRepairFrames.begin(), &aMsg);
-        return true;
+    // send every frame that's now ready, in order
+    OhmMsgAudio* msg;
+    while ((msg = iRepairBuffer.Pop()) != nullptr) {
+        OutputAudio(*msg);
     }
-    // ok, so the backlog is not empty
-    // is it a duplicate of the last frame in the backlog?
-    diff = frame - iRepairFrames[iRepairFrames.size()-1]->Frame();
-    if (diff == 0) {
-        // ... yes, so discard
-        aMsg.RemoveRef();
-        return true;
+    if (iRepairBuffer.Empty()) {
+        // ... we have completed the repair
+        LOG(kSongcast, "END\n");
+        return false;
     }
-    // is the incoming frame later than the last one currently in the backlog?
-    if (diff > 0) {
-        // ... yes, so, again, just inject it (if there is space)
-        if (iRepairFrames.size() == kMaxRepairBacklogFrames) {
-            // can't fit another frame into the backlog
-            RepairReset();
-            aMsg.RemoveRef();
-            return false;
-        }
-        iRepairFrames.push_back(&aMsg);
-        return true;
+    return true;
+}
+
+TBool ProtocolOhBase::RepairAbandonOldest()
+{
+    // must be called with iMutexTransport held.  Returns false if there's nothing left to repair
+    const TUint missing = iRepairBuffer.SkipGap();
+    OhmMsgAudio* msg = iRepairBuffer.Pop();
+    LOG(kSongcast, "ABANDON %u BEFORE %d\n", missing, msg->Frame());
+    iStats.NotifyConcealed(missing);
+    OutputSilence(*msg, missing);
+    do {
+        OutputAudio(*msg);
+    } while ((msg = iRepairBuffer.Pop()) != nullptr);
+    if (iRepairBuffer.Empty()) {
+        LOG(kSongcast, "END\n");
+        return false;
     }
-    // ... no, so it has to go somewhere in the middle of the backlog, so iterate through and inject it at the right place (if there is space)
-    TUint count = iRepairFrames.size();
-    for (auto it = iRepairFrames.begin(); it != iRepairFrames.end(); ++it) {
-        diff = frame - (*it)->Frame();
-        if (diff > 0) {
-            continue;
-        }
-        if (diff == 0) {
-            aMsg.RemoveRef();
-        }
-        else {
-            if (count == kMaxRepairBacklogFrames) {
-                // can't fit another frame into the backlog
-                aMsg.RemoveRef();
-                RepairReset();
-                return false;
-            }
-            iRepairFrames.insert(it, &aMsg);
-        }
-        break;
+    return true;
+}
+
+TBool ProtocolOhBase::IsFrameMissing(TUint aFrame) const
+{
+    // must be called with iMutexTransport held
+    if (!iRunning) {
+        return false;
+    }
+    if (RepairBuffer::Diff(aFrame, iRepairBuffer.Last()) < 1) {
+        return false;
     }
+    return !iRepairBuffer.Contains(aFrame);
+}
 
-    return true;
+void ProtocolOhBase::ClearRequested()
+{
+    // must be called with iMutexTransport held
+    for (TUint i = 0; i < kMaxRepairBacklogFrames; i++) {
+        iRequested[i] = i + 1; // never matches a frame that maps to slot i
+    }
+}
+
+TBool ProtocolOhBase::WasRequested(TUint aFrame) const
+{
+    // must be called with iMutexTransport held
+    return iRequested[aFrame & (kMaxRepairBacklogFrames - 1)] == aFrame;
 }
 
 void ProtocolOhBase::TimerRepairExpired()
 {
     AutoMutex a(iMutexTransport);
-    if (iRepairing) {
+    if (iRepairing && !iRepairBuffer.Empty()) {
+        const TUint64 now = OsTimeInUs(iEnv.OsCtx());
         LOG(kSongcast, "REQUEST RESEND");
         Bws<kMaxRepairMissedFrames * 4> missed;
         WriterBuffer buffer(missed);
         WriterBinary writer(buffer);
 
         TUint count = 0;
-        TUint start = iFrame + 1;
-        TUint end = iRepairFirst->Frame();
-
-        // phase 1 - request the frames between the last sent down the pipeline and the first waiting frame
-        for (TUint i = start; i < end; i++) {
-            writer.WriteUint32Be(i);
-            LOG(kSongcast, " %d", i);
-            if (++count == kMaxRepairMissedFrames) {
-                break;
-            }
-        }
-
-        // phase 2 - if there is room add the missing frames in the backlog
-        for (TUint j = 0; count < kMaxRepairMissedFrames && j < iRepairFrames.size(); j++) {
-            OhmMsgAudio* msg = iRepairFrames[j];
-            start = end + 1;
-            end = msg->Frame();
-            for (TUint i = start; i < end; i++) {
-                writer.WriteUint32Be(i);
-                LOG(kSongcast, " %d", i);
-                if (++count == kMaxRepairMissedFrames) {
+        TUint suppressed = 0;
+        TUint from = iRepairBuffer.Next();
+        TUint start, end;
+
+        // request missing frames, oldest first, until the request is full
+        while (count < kMaxRepairMissedFrames && iRepairBuffer.FindMissing(from, start, end)) {
+            for (TUint i = start; ; i++) {
+                if (iResendPacer.RecentlyRequested(i, now)) {
+                    // another receiver has just asked for this; the sender's reply will reach us too
+                    suppressed++;
+                }
+                else {
+                    writer.WriteUint32Be(i);
+                    LOG(kSongcast, " %d", i);
+                    iRequested[i & (kMaxRepairBacklogFrames - 1)] = i;
+                    count++;
+                }
+                if (i == end || count == kMaxRepairMissedFrames) {
                     break;
                 }
             }
+            from = end + 1;
         }
-        LOG(kSongcast, "\n");
+        LOG(kSongcast, " (%u suppressed)\n", suppressed);
+        iStats.NotifyResendSuppressed(suppressed);
 
-        RequestResend(missed);
-        iTimerRepair->FireIn(kSubsequentRepairTimeoutMs);
+        if (count > 0) {
+            iStats.NotifyResendRequested(count);
+            iResendPacer.NotifyRequested(Converter::BeUint32At(missed, 0), now);
+            RequestResend(missed);
+        }
+        iTimerRepair->FireIn(iResendPacer.TimeoutMs());
     }
 }
 
@@ -448,6 +505,80 @@ void ProtocolOhBase::AddRxTimestamp(OhmMsgAudio& aMsg)
     }
 }
 
+void ProtocolOhBase::ResetClockPuller()
+{
+    iClockPullerRxValid = false;
+    if (iClockPuller != nullptr) {
+        iClockPuller->Reset();
+    }
+}
+
+void ProtocolOhBase::NotifyClockPuller(const OhmMsgAudio& aMsg)
+{
+    /* Each audio msg carries the sender's timestamp for the previous frame.
+       Pair that with our rx timestamp for the previous frame, ignoring resent frames
+       whose rx timestamps don't reflect when they were originally sent. */
+    if (aMsg.Resent()) {
+        return;
+    }
+    if (iClockPullerRxValid && aMsg.Timestamped2() && aMsg.Frame() == iClockPullerRxFrame + 1) {
+        iClockPuller->NotifyTimestamp(aMsg.NetworkTimestamp(), iClockPullerRxTimestamp, aMsg.SampleRate());
+    }
+    iClockPullerRxValid = aMsg.RxTimestamped();
+    iClockPullerRxFrame = aMsg.Frame();
+    iClockPullerRxTimestamp = aMsg.RxTimestamp();
+}
+
+Brn ProtocolOhBase::ReadParity(const OhmHeader& aHeader, OhmHeaderParity& aHeaderParity)
+{
+    aHeaderParity.Internalise(iReadBuffer, aHeader);
+    if (aHeaderParity.ParityBytes() > OhmFecGroup::kMaxFrameBytes) {
+        THROW(OhmError);
+    }
+    return iReadBuffer.Read(aHeaderParity.ParityBytes());
+}
+
+void ProtocolOhBase::ProcessParity(const OhmHeader& aHeader)
+{
+    OhmHeaderParity headerParity;
+    const Brn parity = ReadParity(aHeader, headerParity);
+    ProcessParity(headerParity, parity);
+}
+
+void ProtocolOhBase::ProcessParity(const OhmHeaderParity& aHeader, const Brx& aParity)
+{
+    TUint frame;
+    if (!iFecDecoder.Recover(aHeader, aParity, frame, iFecFrame)) {
+        return;
+    }
+    {
+        AutoMutex _(iMutexTransport);
+        if (!IsFrameMissing(frame)) {
+            return;
+        }
+    }
+    OhmMsg* msg = nullptr;
+    try {
+        ReaderBuffer reader(iFecFrame);
+        OhmHeader header;
+        header.Internalise(reader);
+        if (header.MsgType() != OhmHeader::kMsgTypeAudio) {
+            return;
+        }
+        msg = iMsgFactory.CreateAudio(reader, header);
+    }
+    catch (OhmError&) {
+        return;
+    }
+    catch (ReaderError&) {
+        return;
+    }
+    LOG(kSongcast, "FEC %u\n", frame);
+    iStats.NotifyRecoveredFec();
+    iRecoveringFec = true; // cleared by Process(OhmMsgAudio&)
+    Add(msg);
+}
+
 void ProtocolOhBase::OutputAudio(OhmMsgAudio& aMsg)
 {
     TBool startOfStream = false;
@@ -490,7 +621,21 @@ void ProtocolOhBase::OutputAudio(OhmMsgAudio& aMsg)
         iPendingMetatext.Replace(Brx::Empty());
         iMetatextMsgDue = false;
     }
-    iSupply->OutputData(aMsg.Audio());
+    if (aMsg.Compressed()) {
+        try {
+            iCodec.Decode(aMsg.Audio(), aMsg.Samples(), aMsg.Channels(), aMsg.BitDepth(), iDecodedAudio);
+        }
+        catch (OhmError&) {
+            LOG2(kSongcast, kError, "ProtocolOhBase: failed to decode compressed frame %u, outputting silence\n", aMsg.Frame());
+            const TUint bytes = aMsg.Samples() * aMsg.Channels() * (aMsg.BitDepth() / 8);
+            iDecodedAudio.SetBytes(std::min(bytes, iDecodedAudio.MaxBytes()));
+            iDecodedAudio.Fill(0);
+        }
+        iSupply->OutputData(iDecodedAudio);
+    }
+    else {
+        iSupply->OutputData(aMsg.Audio());
+    }
     const TBool halt = aMsg.Halt();
     if (halt) {
         iSupply->OutputWait();
@@ -502,15 +647,45 @@ void ProtocolOhBase::OutputAudio(OhmMsgAudio& aMsg)
     }
 }
 
+void ProtocolOhBase::OutputSilence(const OhmMsgAudio& aMsg, TUint aFrames)
+{
+    // conceals aFrames lost frames, assumed to be the same size as aMsg
+    if (iStreamMsgDue || iBitDepth != aMsg.BitDepth() ||
+        iSampleRate != aMsg.SampleRate() || iNumChannels != aMsg.Channels()) {
+        return; // can't tell what format the lost audio was in
+    }
+    const TUint bytes = aMsg.Samples() * aMsg.Channels() * (aMsg.BitDepth() / 8);
+    iDecodedAudio.SetBytes(std::min(bytes, iDecodedAudio.MaxBytes()));
+    iDecodedAudio.Fill(0);
+    for (TUint i=0; i<aFrames; i++) {
+        iSupply->OutputData(iDecodedAudio);
+    }
+}
+
 void ProtocolOhBase::Process(OhmMsgAudio& aMsg)
 {
     AddRxTimestamp(aMsg);
+    if (iClockPuller != nullptr) {
+        NotifyClockPuller(aMsg);
+    }
+    iFecDecoder.Add(aMsg.Frame(), aMsg.SendableBuffer());
+    const TUint64 now = OsTimeInUs(iEnv.OsCtx());
+    const TUint sampleRate = aMsg.SampleRate();
+    const TUint latencyMs = (sampleRate == 0? 0 : static_cast<TUint>(Jiffies::FromSongcastTime(aMsg.MediaLatency(), sampleRate) / Jiffies::kPerMs));
+    iStats.NotifyAudio(aMsg.SampleStart(), sampleRate, latencyMs, now, aMsg.Resent() || iRecoveringFec);
+    iRecoveringFec = false;
 
     TBool outputAudio = false;
     {
         AutoMutex _(iMutexTransport);
+        if (aMsg.Resent()) {
+            iResendPacer.NotifyResent(aMsg.Frame(), now);
+            if (iResendPacer.RttValid()) {
+                iStats.NotifyRtt(iResendPacer.RttUs());
+            }
+        }
         if (!iRunning) {
-            iFrame = aMsg.Frame();
+            iRepairBuffer.SetLast(aMsg.Frame());
             iRunning = true;
             outputAudio = true;
         }
@@ -518,21 +693,29 @@ void ProtocolOhBase::Process(OhmMsgAudio& aMsg)
             iRepairing = Repair(aMsg);
         }
         else {
-            const TInt diff = aMsg.Frame() - iFrame;
+            const TInt diff = RepairBuffer::Diff(aMsg.Frame(), iRepairBuffer.Last());
             if (diff == 1) {
-                iFrame++;
+                if (aMsg.Resent() && WasRequested(aMsg.Frame())) {
+                    iStats.NotifyRecoveredResend();
+                }
+                iRepairBuffer.SetLast(aMsg.Frame());
                 outputAudio = true;
             }
             else if (diff < 1) {
                 const TBool resent = aMsg.Resent();
+                const TBool late = resent && WasRequested(aMsg.Frame()); // not just resent for another receiver
                 aMsg.RemoveRef();
-                if (!resent) {
+                if (late) {
+                    iStats.NotifyLate();
+                }
+                else if (!resent) {
                     // A frame in the past that is not a resend implies that the sender has reset their frame count
                     // force recently output audio to ramp down
                     THROW(ReaderError);
                 }
             }
             else {
+                iStats.NotifyMissing(diff - 1);
                 iRepairing = RepairBegin(aMsg);
             }
         }
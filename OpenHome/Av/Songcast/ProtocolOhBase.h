@@ -10,33 +10,39 @@
 #include <OpenHome/Av/Songcast/OhmMsg.h>
 #include <OpenHome/Av/Songcast/OhmSocket.h>
 #include <OpenHome/Av/Songcast/OhmTimestamp.h>
+#include <OpenHome/Av/Songcast/OhmLossless.h>
+#include <OpenHome/Av/Songcast/OhmFec.h>
+#include <OpenHome/Av/Utils/ResendPacer.h>
+#include <OpenHome/Av/Utils/SequenceRepairBuffer.h>
+#include <OpenHome/Av/Songcast/OhmReceiverStats.h>
 #include <OpenHome/Private/Stream.h>
 #include <OpenHome/Media/Supply.h>
 
-#include <vector>
-
 EXCEPTION(OhmDiscontinuity);
 
 namespace OpenHome {
     class Environment;
     class Timer;
+namespace Media {
+    class IClockPullerTimestamp;
+}
 namespace Av {
 
 class ProtocolOhBase : public Media::Protocol, private IOhmMsgProcessor
 {
-    static const TUint kMaxRepairBacklogFrames = 200;
+    static const TUint kMaxRepairBacklogFrames = 256; // must be a power of two
     static const TUint kMaxRepairMissedFrames = 20;
-    static const TUint kInitialRepairTimeoutMs = 10;
-    static const TUint kSubsequentRepairTimeoutMs = 30;
     static const TUint kTimerJoinTimeoutMs = 300;
     static const TUint kTtl = 2;
+public:
+    const OhmReceiverStats& ReceiverStats() const;
 protected:
     ProtocolOhBase(Environment& aEnv, IOhmMsgFactory& aFactory, Media::TrackFactory& aTrackFactory,
-                   Optional<IOhmTimestamper> aTimestamper, const TChar* aSupportedScheme, const Brx& aMode,
-                   Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
+                   Optional<IOhmTimestamper> aTimestamper, Optional<Media::IClockPullerTimestamp> aClockPuller,
+                   const TChar* aSupportedScheme, const Brx& aMode, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
     ~ProtocolOhBase();
     void Add(OhmMsg* aMsg);
-    void ResendSeen();
+    void ResendSeen(const OhmHeader& aHeader); // reads the rest of a kMsgTypeResend msg from iReadBuffer
     void RequestResend(const Brx& aFrames);
     void SendJoin();
     void SendListen();
@@ -44,6 +50,10 @@ protected:
     TBool IsCurrentStream(TUint aStreamId) const;
     void WaitForPipelineToEmpty();
     void AddRxTimestamp(OhmMsgAudio& aMsg);
+    void ResetClockPuller();
+    Brn ReadParity(const OhmHeader& aHeader, OhmHeaderParity& aHeaderParity); // reads the rest of a kMsgTypeParity msg from iReadBuffer
+    void ProcessParity(const OhmHeader& aHeader);
+    void ProcessParity(const OhmHeaderParity& aHeader, const Brx& aParity);
 private:
     virtual Media::ProtocolStreamResult Play(TIpAddress aInterface, TUint aTtl, const Endpoint& aEndpoint) = 0;
 protected: // from Media::Protocol
@@ -52,16 +62,25 @@ private: // from Media::Protocol
     void Initialise(Media::MsgFactory& aMsgFactory, Media::IPipelineElementDownstream& aDownstream) override;
     Media::ProtocolStreamResult Stream(const Brx& aUri) override;
     Media::ProtocolGetResult Get(IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes) override;
+    void WriteInfo(IWriter& aWriter) override;
 private: // from IStreamHandler
     Media::EStreamPlay OkToPlay(TUint aStreamId) override;
     void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
+private:
+    typedef SequenceRepairBuffer<OhmMsgAudio, kMaxRepairBacklogFrames, 32> RepairBuffer;
 private:
     void CurrentSubnetChanged();
     void RepairReset();
     void TimerRepairExpired();
     TBool RepairBegin(OhmMsgAudio& aMsg);
     TBool Repair(OhmMsgAudio& aMsg);
+    TBool RepairAbandonOldest();
+    TBool IsFrameMissing(TUint aFrame) const;
+    void ClearRequested();
+    TBool WasRequested(TUint aFrame) const;
     void OutputAudio(OhmMsgAudio& aMsg);
+    void OutputSilence(const OhmMsgAudio& aMsg, TUint aFrames);
+    void NotifyClockPuller(const OhmMsgAudio& aMsg);
 private: // from IOhmMsgProcessor
     void Process(OhmMsgAudio& aMsg) override;
     void Process(OhmMsgTrack& aMsg) override;
@@ -89,7 +108,6 @@ private:
     Brn iSupportedScheme;
     TUint iNacnId;
     Uri iUri; // only used inside Stream() but too large to put on the stack
-    TUint iFrame;
     TBool iRunning;
     TBool iRepairing;
     TBool iTrackMsgDue;
@@ -104,11 +122,22 @@ private:
     TUint iSampleRate;
     TUint iNumChannels;
     TUint64 iLatency;
-    OhmMsgAudio* iRepairFirst;
-    std::vector<OhmMsgAudio*> iRepairFrames;
+    RepairBuffer iRepairBuffer;
     Timer* iTimerRepair;
+    ResendPacer iResendPacer;
+    TUint iRequested[kMaxRepairBacklogFrames]; // frames we've asked to be resent, indexed by frame % kMaxRepairBacklogFrames
     Media::BwsTrackUri iTrackUri;
     Media::BwsTrackMetaData iTrackMetadata;
+    OhmLosslessCodec iCodec;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iDecodedAudio;
+    OhmFecDecoder iFecDecoder;
+    Bws<OhmFecGroup::kMaxFrameBytes> iFecFrame;
+    OhmReceiverStats iStats;
+    TBool iRecoveringFec;
+    Media::IClockPullerTimestamp* iClockPuller;
+    TBool iClockPullerRxValid;
+    TUint iClockPullerRxFrame;
+    TUint iClockPullerRxTimestamp;
     Semaphore iPipelineEmpty;
     Optional<Av::IOhmMsgProcessor> iOhmMsgProcessor;
 };
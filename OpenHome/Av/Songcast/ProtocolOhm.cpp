@@ -49,9 +49,9 @@ using namespace OpenHome::Media;
 // ProtocolOhm
 
 ProtocolOhm::ProtocolOhm(Environment& aEnv, IOhmMsgFactory& aMsgFactory, TrackFactory& aTrackFactory,
-                         Optional<IOhmTimestamper> aTimestamper, const Brx& aMode,
-                         Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
-    : ProtocolOhBase(aEnv, aMsgFactory, aTrackFactory, aTimestamper, "ohm", aMode, aOhmMsgProcessor)
+                         Optional<IOhmTimestamper> aTimestamper, Optional<Media::IClockPullerTimestamp> aClockPuller,
+                         const Brx& aMode, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
+    : ProtocolOhBase(aEnv, aMsgFactory, aTrackFactory, aTimestamper, aClockPuller, "ohm", aMode, aOhmMsgProcessor)
     , iStoppedLock("POHM")
     , iSemSenderUnicastOverride("POM2", 0)
     , iSenderUnicastOverrideEnabled(false)
@@ -113,6 +113,7 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
                 iTimestamper->Stop();
                 iTimestamper->Start(iEndpoint);
             }
+            ResetClockPuller();
 
             OhmHeader header;
             SendJoin();
@@ -132,6 +133,7 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
                     case OhmHeader::kMsgTypeListen:
                     case OhmHeader::kMsgTypeLeave:
                     case OhmHeader::kMsgTypeSlave:
+                    case OhmHeader::kMsgTypeParity:
                         break;
                     case OhmHeader::kMsgTypeAudio:
                     {
@@ -155,7 +157,7 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
                         joinComplete = receivedTrack;
                         break;
                     case OhmHeader::kMsgTypeResend:
-                        ResendSeen();
+                        ResendSeen(header);
                         break;
                     }
 
@@ -199,7 +201,10 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
                         Add(iMsgFactory.CreateMetatext(iReadBuffer, header));
                         break;
                     case OhmHeader::kMsgTypeResend:
-                        ResendSeen();
+                        ResendSeen(header);
+                        break;
+                    case OhmHeader::kMsgTypeParity:
+                        ProcessParity(header);
                         break;
                     }
 
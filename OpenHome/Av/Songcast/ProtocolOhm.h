@@ -28,8 +28,8 @@ class ProtocolOhm : public ProtocolOhBase, public IUnicastOverrideObserver
 {
 public:
     ProtocolOhm(Environment& aEnv, IOhmMsgFactory& aMsgFactory, Media::TrackFactory& aTrackFactory,
-                Optional<IOhmTimestamper> aTimestamper, const Brx& aMode,
-                Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
+                Optional<IOhmTimestamper> aTimestamper, Optional<Media::IClockPullerTimestamp> aClockPuller,
+                const Brx& aMode, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
 private: // from IUnicastOverrideObserver
     void UnicastOverrideEnabled() override;
     void UnicastOverrideDisabled() override;
@@ -39,8 +39,6 @@ private: // from Media::Protocol
     void Interrupt(TBool aInterrupt) override;
 private: // from IStreamHandler
     TUint TryStop(TUint aStreamId) override;
-private:
-    void ResetClockPuller();
 private:
     TUint iNextFlushId;
     TBool iStopped;
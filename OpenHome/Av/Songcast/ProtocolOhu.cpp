@@ -21,8 +21,8 @@ using namespace OpenHome::Media;
 
 // ProtocolOhu
 
-ProtocolOhu::ProtocolOhu(Environment& aEnv, IOhmMsgFactory& aMsgFactory, Media::TrackFactory& aTrackFactory, Optional<IOhmTimestamper> aTimestamper, const Brx& aMode, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
-    : ProtocolOhBase(aEnv, aMsgFactory, aTrackFactory, aTimestamper, "ohu", aMode, aOhmMsgProcessor)
+ProtocolOhu::ProtocolOhu(Environment& aEnv, IOhmMsgFactory& aMsgFactory, Media::TrackFactory& aTrackFactory, Optional<IOhmTimestamper> aTimestamper, Optional<Media::IClockPullerTimestamp> aClockPuller, const Brx& aMode, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
+    : ProtocolOhBase(aEnv, aMsgFactory, aTrackFactory, aTimestamper, aClockPuller, "ohu", aMode, aOhmMsgProcessor)
     , iLeaveLock("POHU")
 {
     iTimerLeave = new Timer(aEnv, MakeFunctor(*this, &ProtocolOhu::TimerLeaveExpired), "ProtocolOhuLeave");
@@ -59,36 +59,69 @@ void ProtocolOhu::HandleSlave(const OhmHeader& aHeader)
 {
     OhmHeaderSlave headerSlave;
     headerSlave.Internalise(iReadBuffer, aHeader);
-    iSlaveCount = headerSlave.SlaveCount();
+    const TUint count = headerSlave.SlaveCount();
+    if (count > kMaxSlaveCount) {
+        LOG2(kSongcast, kError, "OHU: sender listed %u slaves, only forwarding to %u\n", count, kMaxSlaveCount);
+    }
+    iSlaveCount = 0;
 
     ReaderBinary reader(iReadBuffer);
-    for (TUint i = 0; i < iSlaveCount; i++) {
+    for (TUint i = 0; i < count; i++) {
         TIpAddress address = reader.ReadUintBe(4);
         TUint port = reader.ReadUintBe(2);
-        iSlaveList[i].SetAddress(address);
-        iSlaveList[i].SetPort(port);
+        if (iSlaveCount < kMaxSlaveCount) {
+            iSlaveList[iSlaveCount].SetAddress(address);
+            iSlaveList[iSlaveCount].SetPort(port);
+            iSlaveSendErrors[iSlaveCount] = 0;
+            iSlaveCount++;
+        }
+    }
+}
+
+void ProtocolOhu::HandleParity(const OhmHeader& aHeader)
+{
+    OhmHeaderParity headerParity;
+    const Brn parity = ReadParity(aHeader, headerParity);
+    if (iSlaveCount > 0) {
+        // slaves lose whatever we lose so forward parity so they can recover the same frames
+        WriterBuffer writer(iMessageBuffer);
+        writer.Flush();
+        aHeader.Externalise(writer);
+        headerParity.Externalise(writer);
+        writer.Write(parity);
+        SendToSlaves();
     }
+    ProcessParity(headerParity, parity);
 }
 
 void ProtocolOhu::Broadcast(OhmMsg* aMsg)
 {
     if (iSlaveCount > 0) {
+        // serialise once, regardless of the number of slaves
         WriterBuffer writer(iMessageBuffer);
         writer.Flush();
         aMsg->Externalise(writer);
-        for (TUint i = 0; i < iSlaveCount; i++) {
-            try {
-                iSocket.Send(iMessageBuffer, iSlaveList[i]);
-            }
-            catch (NetworkError&) {
+        SendToSlaves();
+    }
+
+    Add(aMsg);
+}
+
+void ProtocolOhu::SendToSlaves()
+{
+    for (TUint i = 0; i < iSlaveCount; i++) {
+        try {
+            iSocket.Send(iMessageBuffer, iSlaveList[i]);
+        }
+        catch (NetworkError&) {
+            // only log the first failure for each slave to avoid flooding the log once per frame
+            if (iSlaveSendErrors[i]++ == 0) {
                 Endpoint::EndpointBuf buf;
                 iSlaveList[i].AppendEndpoint(buf);
-                LOG(kError, "NetworkError in ProtocolOhu::Broadcast for slave %s\n", buf.Ptr());
+                LOG(kError, "NetworkError in ProtocolOhu::SendToSlaves for slave %s\n", buf.Ptr());
             }
         }
     }
-
-    Add(aMsg);
 }
 
 ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, const Endpoint& aEndpoint)
@@ -140,6 +173,7 @@ ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, co
             iTimestamper->Stop();
             iTimestamper->Start(iSocket.This());
         }
+        ResetClockPuller();
 
         iLeaveLock.Signal();
         try {
@@ -160,6 +194,7 @@ ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, co
                     case OhmHeader::kMsgTypeJoin:
                     case OhmHeader::kMsgTypeListen:
                     case OhmHeader::kMsgTypeLeave:
+                    case OhmHeader::kMsgTypeParity:
                         break;
                     case OhmHeader::kMsgTypeAudio:
                     {
@@ -188,7 +223,7 @@ ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, co
                         HandleSlave(header);
                         break;
                     case OhmHeader::kMsgTypeResend:
-                        ResendSeen();
+                        ResendSeen(header);
                         break;
                     default:
                         ASSERTS();
@@ -238,7 +273,10 @@ ProtocolStreamResult ProtocolOhu::Play(TIpAddress /*aInterface*/, TUint aTtl, co
                         HandleSlave(header);
                         break;
                     case OhmHeader::kMsgTypeResend:
-                        ResendSeen();
+                        ResendSeen(header);
+                        break;
+                    case OhmHeader::kMsgTypeParity:
+                        HandleParity(header);
                         break;
                     default:
                         ASSERTS();
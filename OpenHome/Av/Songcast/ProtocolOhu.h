@@ -3,6 +3,7 @@
 #include <OpenHome/Types.h>
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Av/Songcast/ProtocolOhBase.h>
+#include <OpenHome/Av/Songcast/Ohm.h>
 #include <OpenHome/Private/Network.h>
 
 namespace OpenHome {
@@ -10,6 +11,7 @@ namespace OpenHome {
     class Timer;
 namespace Media {
     class TrackFactory;
+    class IClockPullerTimestamp;
 }
 namespace Av {
 
@@ -18,11 +20,11 @@ class IOhmMsgFactory;
 class ProtocolOhu : public ProtocolOhBase
 {
     static const TUint kTimerLeaveTimeoutMs = 50;
-    static const TUint kMaxSlaveCount = 4;
+    static const TUint kMaxSlaveCount = OhmHeaderSlave::kMaxSlaveCount;
 public:
     ProtocolOhu(Environment& aEnv, IOhmMsgFactory& aFactory, Media::TrackFactory& aTrackFactory,
-                Optional<IOhmTimestamper> aTimestamper, const Brx& aMode,
-                Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
+                Optional<IOhmTimestamper> aTimestamper, Optional<Media::IClockPullerTimestamp> aClockPuller,
+                const Brx& aMode, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
     ~ProtocolOhu();
 private: // from ProtocolOhBase
     Media::ProtocolStreamResult Play(TIpAddress aInterface, TUint aTtl, const Endpoint& aEndpoint) override;
@@ -35,7 +37,9 @@ private:
     void HandleTrack(const OhmHeader& aHeader);
     void HandleMetatext(const OhmHeader& aHeader);
     void HandleSlave(const OhmHeader& aHeader);
+    void HandleParity(const OhmHeader& aHeader);
     void Broadcast(OhmMsg* aMsg);
+    void SendToSlaves(); // sends iMessageBuffer
     void SendLeave();
     void TimerLeaveExpired();
 private:
@@ -45,6 +49,7 @@ private:
     TBool iStopped;
     TUint iSlaveCount;
     Endpoint iSlaveList[kMaxSlaveCount];
+    TUint iSlaveSendErrors[kMaxSlaveCount];
     Bws<kMaxFrameBytes> iMessageBuffer;
     TUint iNextFlushId;
 };
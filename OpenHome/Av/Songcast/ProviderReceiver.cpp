@@ -6,6 +6,7 @@
 #include <Generated/DvAvOpenhomeOrgReceiver1.h>
 #include <OpenHome/Net/Core/DvInvocationResponse.h>
 #include <OpenHome/Private/Uri.h>
+#include <OpenHome/Private/Stream.h>
 #include <OpenHome/Media/PipelineObserver.h>
 
 using namespace OpenHome;
@@ -32,6 +33,7 @@ ProviderReceiver::ProviderReceiver(Net::DvDevice& aDevice, ISourceReceiver& aSou
     EnableActionSender();
     EnableActionProtocolInfo();
     EnableActionTransportState();
+    EnableActionStats();
 
     SetPropertyUri(Brx::Empty());
     SetPropertyMetadata(Brx::Empty());
@@ -108,3 +110,17 @@ void ProviderReceiver::TransportState(IDvInvocation& aInvocation, IDvInvocationR
     aValue.WriteFlush();
     aInvocation.EndResponse();
 }
+
+void ProviderReceiver::Stats(IDvInvocation& aInvocation, IDvInvocationResponseString& aValue)
+{
+    aInvocation.StartResponse();
+    {
+        AutoMutex a(iLock);
+        iStats.SetBytes(0);
+        WriterBuffer writer(iStats);
+        iSource.WriteStats(writer);
+        aValue.Write(iStats);
+    }
+    aValue.WriteFlush();
+    aInvocation.EndResponse();
+}
@@ -4,6 +4,7 @@
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Standard.h>
 #include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Stream.h>
 #include <Generated/DvAvOpenhomeOrgReceiver1.h>
 #include <OpenHome/Net/Core/DvInvocationResponse.h>
 #include <OpenHome/Media/PipelineObserver.h>
@@ -19,6 +20,7 @@ public:
     virtual void Play() = 0;
     virtual void Stop() = 0;
     virtual void SetSender(const Brx& aUri, const Brx& aMetadata) = 0;
+    virtual void WriteStats(IWriter& aWriter) = 0; // json object
 };
 
 class ProviderReceiver : public Net::DvProviderAvOpenhomeOrgReceiver1
@@ -33,6 +35,9 @@ private: // from DvProviderAvOpenhomeOrgReceiver1
     void Sender(Net::IDvInvocation& aInvocation, Net::IDvInvocationResponseString& aUri, Net::IDvInvocationResponseString& aMetadata) override;
     void ProtocolInfo(Net::IDvInvocation& aInvocation, Net::IDvInvocationResponseString& aValue) override;
     void TransportState(Net::IDvInvocation& aInvocation, Net::IDvInvocationResponseString& aValue) override;
+    void Stats(Net::IDvInvocation& aInvocation, Net::IDvInvocationResponseString& aValue) override;
+private:
+    static const TUint kMaxStatsBytes = 1024;
 private:
     Mutex iLock;
     ISourceReceiver& iSource;
@@ -40,6 +45,7 @@ private:
     Brn iTransportState;
     Media::BwsTrackUri iSenderUri;
     Media::BwsTrackMetaData iSenderMetadata;
+    Bws<kMaxStatsBytes> iStats;
 };
 
 } // namespace Av
@@ -41,6 +41,7 @@ Sender::Sender(Environment& aEnv,
                TUint aThreadPriority,
                const Brx& aName,
                TUint aMinLatencyMs,
+               TUint aMaxLatencyMs,
                const Brx& aSongcastMode,
                IUnicastOverrideObserver& aUnicastOverrideObserver)
     : iAudioBuf(nullptr)
@@ -55,7 +56,7 @@ Sender::Sender(Environment& aEnv,
     , iFirstChannelIndex(0)
 {
     const TInt defaultChannel = (TInt)aEnv.Random(kChannelMax, kChannelMin);
-    iOhmSenderDriver = new OhmSenderDriver(aEnv, aTimestamper);
+    iOhmSenderDriver = new OhmSenderDriver(aEnv, aTimestamper, aMaxLatencyMs);
     // create sender with default configuration.  CongfigVals below will each call back on construction, allowing these to be updated
     iOhmSender = new OhmSender(aEnv, aDevice, *iOhmSenderDriver, aZoneHandler, aThreadPriority,
                                aName, defaultChannel, aMinLatencyMs, false/*unicast*/);
@@ -299,6 +300,23 @@ void Sender::ProcessAudio(MsgAudio* aMsg)
 
 void Sender::SendPendingAudio(TBool aHalt)
 {
+    if (iPendingAudio.size() == 0 && !aHalt) {
+        return;
+    }
+    if (iSampleRate != 0) {
+        TUint jiffies = 0;
+        for (TUint i=0; i<iPendingAudio.size(); i++) {
+            jiffies += iPendingAudio[i]->Jiffies();
+        }
+        if (iOhmSenderDriver->TrySkipAudio(jiffies / Jiffies::PerSample(iSampleRate))) {
+            // no receivers so don't pay for reading/copying audio that would only be discarded
+            for (TUint i=0; i<iPendingAudio.size(); i++) {
+                iPendingAudio[i]->RemoveRef();
+            }
+            iPendingAudio.clear();
+            return;
+        }
+    }
     auto msg = iOhmSenderDriver->CreateAudio();
     iAudioBuf = &(msg->Audio());
     iAudioBuf->SetBytes(0);
@@ -358,6 +376,12 @@ void Sender::ProcessFragment(const Brx& aData, TUint aNumChannels, TUint aBytesP
 
     ASSERT(iAudioBuf->BytesRemaining() >= totalBytesToCopy);
 
+    if (stride == 2 * dstBytesPerSample) {
+        // stereo, no truncation: decoded audio is already in the layout Songcast sends
+        memcpy(dst, src, totalBytesToCopy);
+        iAudioBuf->SetBytes(iAudioBuf->Bytes() + totalBytesToCopy);
+        return;
+    }
     for (TUint i=0; i<numSamples; i++) {
         memcpy(dst, src, dstBytesPerSample);
         memcpy(dst + dstBytesPerSample, src + aBytesPerSample, dstBytesPerSample);
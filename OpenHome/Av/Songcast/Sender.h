@@ -44,6 +44,7 @@ public:
            TUint aThreadPriority,
            const Brx& aName,
            TUint aMinLatencyMs,
+           TUint aMaxLatencyMs,
            const Brx& aSongcastMode,
            IUnicastOverrideObserver& aUnicastOverrideObserver);
     ~Sender();
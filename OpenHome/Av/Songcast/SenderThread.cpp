@@ -3,8 +3,8 @@
 #include <OpenHome/Types.h>
 #include <OpenHome/Private/Thread.h>
 #include <OpenHome/Private/Printer.h>
-
-#include <vector>
+#include <OpenHome/Private/Debug.h>
+#include <OpenHome/Av/Debug.h>
 
 using namespace OpenHome;
 using namespace OpenHome::Av;
@@ -15,13 +15,19 @@ const TUint SenderThread::kMaxMsgBacklog = 100;
 SenderThread::SenderThread(IPipelineElementDownstream& aDownstream,
                            TUint aThreadPriority)
     : iDownstream(aDownstream)
-    , iLock("SCST")
     , iFifo(kMaxMsgBacklog)
-    , iFifoSlotsUsed(0)
+    , iSemSpace("SGSS", 0)
+    , iWaitingForSpace(false)
+    , iDropping(false)
+    , iDropCount(0)
+    , iDropJiffies(0)
+    , iDropJiffiesTotal(0)
+    , iHighWaterMark(0)
+    , iAudioMsgsDropped(0)
+    , iStalls(0)
     , iShutdownSem("SGSN", 0)
     , iQuit(false)
 {
-    ASSERT(iFifoSlotsUsed.is_lock_free());
     iThread = new ThreadFunctor("SongcastSender", MakeFunctor(*this, &SenderThread::Run), aThreadPriority);
     iThread->Start();
 }
@@ -30,25 +36,87 @@ SenderThread::~SenderThread()
 {
     iShutdownSem.Wait();
     delete iThread;
+    if (iAudioMsgsDropped > 0 || iStalls > 0) {
+        LOG(kSongcast, "SenderThread: backlog high water mark %u/%u, dropped %u audio msgs (%ums), %u stalls\n",
+                       iHighWaterMark, kMaxMsgBacklog, iAudioMsgsDropped,
+                       static_cast<TUint>(iDropJiffiesTotal / Jiffies::kPerMs), iStalls);
+    }
 }
 
 void SenderThread::Push(Msg* aMsg)
 {
-    AutoMutex _(iLock);
-    ASSERT(iFifoSlotsUsed < kMaxMsgBacklog);
-    iFifo.Write(aMsg);
-    iFifoSlotsUsed++;
+    if (iDropping && iFifo.SlotsUsed() <= kMaxMsgBacklog / 2) {
+        iDropping = false;
+        LOG(kSongcast, "SenderThread: backlog drained, dropped %u audio msgs (%ums)\n",
+                       iDropCount, static_cast<TUint>(iDropJiffies / Jiffies::kPerMs));
+    }
+    if (iDropping && TryDrop(aMsg)) {
+        return;
+    }
+    if (!iFifo.TryWrite(aMsg)) {
+        if (!iDropping) {
+            iDropping = true;
+            iDropCount = 0;
+            iDropJiffies = 0;
+            LOG2(kSongcast, kError, "SenderThread: backlog full (%u msgs), dropping audio\n", kMaxMsgBacklog);
+        }
+        if (TryDrop(aMsg)) {
+            return;
+        }
+        WaitForSpace(aMsg);
+    }
+    UpdateHighWaterMark();
     iThread->Signal();
 }
 
+TBool SenderThread::TryDrop(Msg* aMsg)
+{
+    MsgAudio* audio = iAudioDetector.Audio(aMsg);
+    if (audio == nullptr) {
+        return false;
+    }
+    const TUint jiffies = audio->Jiffies();
+    iDropCount++;
+    iDropJiffies += jiffies;
+    iDropJiffiesTotal += jiffies;
+    iAudioMsgsDropped++;
+    aMsg->RemoveRef();
+    return true;
+}
+
+void SenderThread::WaitForSpace(Msg* aMsg)
+{
+    iStalls++;
+    LOG2(kSongcast, kError, "SenderThread: backlog full, waiting to queue non-audio msg\n");
+    iWaitingForSpace = true;
+    while (!iFifo.TryWrite(aMsg)) {
+        iSemSpace.Wait();
+    }
+    iWaitingForSpace = false;
+    (void)iSemSpace.Clear();
+}
+
+void SenderThread::UpdateHighWaterMark()
+{
+    const TUint used = iFifo.SlotsUsed();
+    if (used > iHighWaterMark) {
+        iHighWaterMark = used;
+        if (used > kMaxMsgBacklog / 2) {
+            LOG(kSongcast, "SenderThread: backlog high water mark now %u/%u\n", used, kMaxMsgBacklog);
+        }
+    }
+}
+
 void SenderThread::Run()
 {
     do {
         iThread->Wait();
-        iLock.Wait();
-        auto msg = iFifo.Read();
-        iFifoSlotsUsed--;
-        iLock.Signal();
+        Msg* msg = nullptr;
+        const TBool read = iFifo.TryRead(msg);
+        ASSERT(read); // every Signal() follows a successful write
+        if (iWaitingForSpace) {
+            iSemSpace.Signal();
+        }
         msg = msg->Process(*this);
         iDownstream.Push(msg);
     } while (!iQuit);
@@ -76,3 +144,36 @@ Msg* SenderThread::ProcessMsg(MsgQuit* aMsg)
     iQuit = true;
     return aMsg;
 }
+
+
+// SenderThread::AudioDetector
+
+SenderThread::AudioDetector::AudioDetector()
+    : iAudio(nullptr)
+{
+}
+
+MsgAudio* SenderThread::AudioDetector::Audio(Msg* aMsg)
+{
+    iAudio = nullptr;
+    (void)aMsg->Process(*this);
+    return iAudio;
+}
+
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgMode* aMsg)              { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgTrack* aMsg)             { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgDrain* aMsg)             { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgDelay* aMsg)             { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgEncodedStream* aMsg)     { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgAudioEncoded* aMsg)      { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgMetaText* aMsg)          { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgStreamInterrupted* aMsg) { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgHalt* aMsg)              { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgFlush* aMsg)             { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgWait* aMsg)              { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgDecodedStream* aMsg)     { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgBitRate* aMsg)           { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgAudioPcm* aMsg)          { iAudio = aMsg; return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgSilence* aMsg)           { iAudio = aMsg; return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgPlayable* aMsg)          { return aMsg; }
+Msg* SenderThread::AudioDetector::ProcessMsg(MsgQuit* aMsg)              { return aMsg; }
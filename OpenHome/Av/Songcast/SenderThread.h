@@ -2,8 +2,9 @@
 
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Types.h>
-#include <OpenHome/Private/Fifo.h>
 #include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Av/Songcast/FifoSpsc.h>
 
 #include <atomic>
 
@@ -11,11 +12,21 @@ namespace OpenHome {
     class ThreadFunctor;
 namespace Av {
 
+/*
+ * Hands msgs from the pipeline thread to a dedicated Songcast sender thread.
+ *
+ * If the sender thread stalls (e.g. blocked on a socket during wifi roaming) the backlog can fill.
+ * Audio is then dropped rather than blocking the pipeline (which would glitch local playback too).
+ * Once dropping starts, it continues until the backlog has drained to half full so that receivers
+ * see one gap rather than many.  Any other msg waits for space, as losing it could leave the
+ * sender in the wrong state.
+ */
 class SenderThread : public Media::IPipelineElementDownstream
                    , private Media::IMsgProcessor
                    , private INonCopyable
 {
-    static const TUint kMaxMsgBacklog; // asserts if ever exceeded
+public:
+    static const TUint kMaxMsgBacklog;
 public:
     SenderThread(Media::IPipelineElementDownstream& aDownstream,
                  TUint aThreadPriority);
@@ -24,6 +35,36 @@ private: // from Media::IPipelineElementDownstream
     void Push(Media::Msg* aMsg) override;
 private:
     void Run();
+    TBool TryDrop(Media::Msg* aMsg);
+    void WaitForSpace(Media::Msg* aMsg);
+    void UpdateHighWaterMark();
+private:
+    class AudioDetector : public Media::IMsgProcessor, private INonCopyable
+    {
+    public:
+        AudioDetector();
+        Media::MsgAudio* Audio(Media::Msg* aMsg); // returns nullptr if aMsg isn't audio
+    private: // from Media::IMsgProcessor
+        Media::Msg* ProcessMsg(Media::MsgMode* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgTrack* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgDrain* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgDelay* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgEncodedStream* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgAudioEncoded* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgMetaText* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgStreamInterrupted* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgHalt* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgFlush* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgWait* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgDecodedStream* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgBitRate* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgAudioPcm* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgSilence* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgPlayable* aMsg) override;
+        Media::Msg* ProcessMsg(Media::MsgQuit* aMsg) override;
+    private:
+        Media::MsgAudio* iAudio;
+    };
 private: // from Media::IMsgProcessor
     Media::Msg* ProcessMsg(Media::MsgMode* aMsg) override;
     Media::Msg* ProcessMsg(Media::MsgTrack* aMsg) override;
@@ -45,9 +86,18 @@ private: // from Media::IMsgProcessor
 private:
     Media::IPipelineElementDownstream& iDownstream;
     ThreadFunctor* iThread;
-    Mutex iLock;
-    FifoLiteDynamic<Media::Msg*> iFifo;
-    std::atomic<TUint> iFifoSlotsUsed;
+    FifoSpsc<Media::Msg*> iFifo;
+    AudioDetector iAudioDetector;
+    Semaphore iSemSpace;
+    std::atomic<TBool> iWaitingForSpace;
+    // only accessed from Push(), then logged on destruction
+    TBool iDropping;
+    TUint iDropCount;        // msgs, current episode
+    TUint64 iDropJiffies;    // current episode
+    TUint64 iDropJiffiesTotal;
+    TUint iHighWaterMark;
+    TUint iAudioMsgsDropped;
+    TUint iStalls;           // number of times Push() had to wait for space for a non-audio msg
     Semaphore iShutdownSem;
     TBool iQuit;
 };
@@ -52,6 +52,7 @@ class SourceReceiver : public Source, private ISourceReceiver, private IZoneList
 public:
     SourceReceiver(IMediaPlayer& aMediaPlayer,
                    Optional<Media::IClockPuller> aClockPuller,
+                   Optional<Media::IClockPullerTimestamp> aClockPullerTimestamp,
                    Optional<IOhmTimestamper> aTxTimestamper,
                    Optional<IOhmTimestamper> aRxTimestamper,
                    Optional<IOhmMsgProcessor> aOhmMsgObserver);
@@ -65,6 +66,7 @@ private: // from ISourceReceiver
     void Play() override;
     void Stop() override;
     void SetSender(const Brx& aUri, const Brx& aMetadata) override;
+    void WriteStats(IWriter& aWriter) override;
 private: // from IZoneListener
     void ZoneUriChanged(const Brx& aZone, const Brx& aUri) override;
     void NotifyPresetInfo(TUint aPreset, const Brx& aMetadata) override;
@@ -90,6 +92,8 @@ private:
     ProviderReceiver* iProviderReceiver;
     UriProviderSongcast* iUriProvider;
     OhmMsgFactory* iOhmMsgFactory;
+    ProtocolOhm* iProtocolOhm; // owned by pipeline
+    ProtocolOhu* iProtocolOhu; // owned by pipeline
     Uri iUri; // allocated here as stack requirements are too high for an automatic variable
     Bws<ZoneHandler::kMaxZoneBytes> iZone;
     Media::BwsTrackUri iTrackUri;
@@ -156,11 +160,12 @@ using namespace OpenHome::Configuration;
 
 ISource* SourceFactory::NewReceiver(IMediaPlayer& aMediaPlayer,
                                     Optional<IClockPuller> aClockPuller,
+                                    Optional<IClockPullerTimestamp> aClockPullerTimestamp,
                                     Optional<IOhmTimestamper> aTxTimestamper,
                                     Optional<IOhmTimestamper> aRxTimestamper,
                                     Optional<IOhmMsgProcessor> aOhmMsgObserver)
 { // static
-    return new SourceReceiver(aMediaPlayer, aClockPuller, aTxTimestamper, aRxTimestamper, aOhmMsgObserver);
+    return new SourceReceiver(aMediaPlayer, aClockPuller, aClockPullerTimestamp, aTxTimestamper, aRxTimestamper, aOhmMsgObserver);
 }
 
 const TChar* SourceFactory::kSourceTypeReceiver = "Receiver";
@@ -187,6 +192,7 @@ const TChar* SourceReceiver::kProtocolInfo = "ohz:*:*:*,ohm:*:*:*,ohu:*.*.*";
 
 SourceReceiver::SourceReceiver(IMediaPlayer& aMediaPlayer,
                                Optional<Media::IClockPuller> aClockPuller,
+                               Optional<Media::IClockPullerTimestamp> aClockPullerTimestamp,
                                Optional<IOhmTimestamper> aTxTimestamper,
                                Optional<IOhmTimestamper> aRxTimestamper,
                                Optional<IOhmMsgProcessor> aOhmMsgObserver)
@@ -210,11 +216,12 @@ SourceReceiver::SourceReceiver(IMediaPlayer& aMediaPlayer,
     iProviderReceiver = new ProviderReceiver(device, *this, kProtocolInfo);
     iUriProvider = new UriProviderSongcast(aMediaPlayer, aClockPuller);
     iPipeline.Add(iUriProvider);
-    iOhmMsgFactory = new OhmMsgFactory(210, 10, 10);
+    iOhmMsgFactory = new OhmMsgFactory(266, 10, 10); // enough audio msgs to fill ProtocolOhBase's repair buffer
     TrackFactory& trackFactory = aMediaPlayer.TrackFactory();
-    auto protocolOhm = new ProtocolOhm(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, iUriProvider->Mode(), aOhmMsgObserver);
-    iPipeline.Add(protocolOhm);
-    iPipeline.Add(new ProtocolOhu(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, iUriProvider->Mode(), aOhmMsgObserver));
+    iProtocolOhm = new ProtocolOhm(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, aClockPullerTimestamp, iUriProvider->Mode(), aOhmMsgObserver);
+    iPipeline.Add(iProtocolOhm);
+    iProtocolOhu = new ProtocolOhu(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, aClockPullerTimestamp, iUriProvider->Mode(), aOhmMsgObserver);
+    iPipeline.Add(iProtocolOhu);
     iStoreZone = new StoreText(aMediaPlayer.ReadWriteStore(), aMediaPlayer.PowerManager(), kPowerPriorityNormal,
                                Brn("Receiver.Zone"), Brx::Empty(), iZone.MaxBytes());
     iStoreZone->Get(iZone);
@@ -223,7 +230,7 @@ SourceReceiver::SourceReceiver(IMediaPlayer& aMediaPlayer,
     iNacnId = iEnv.NetworkAdapterList().AddCurrentChangeListener(MakeFunctor(*this, &SourceReceiver::CurrentAdapterChanged), "SourceReceiver", false);
 
     // Sender
-    iSender = new SongcastSender(aMediaPlayer, *iZoneHandler, aTxTimestamper, iUriProvider->Mode(), *protocolOhm);
+    iSender = new SongcastSender(aMediaPlayer, *iZoneHandler, aTxTimestamper, iUriProvider->Mode(), *iProtocolOhm);
 }
 
 SourceReceiver::~SourceReceiver()
@@ -363,6 +370,24 @@ void SourceReceiver::SetSender(const Brx& aUri, const Brx& aMetadata)
     }
 }
 
+void SourceReceiver::WriteStats(IWriter& aWriter)
+{
+    // report whichever protocol is streaming or, if neither is, the one that last received audio
+    OhmReceiverStats::Values ohm;
+    OhmReceiverStats::Values ohu;
+    iProtocolOhm->ReceiverStats().Get(ohm);
+    iProtocolOhu->ReceiverStats().Get(ohu);
+    TBool useOhu;
+    if (ohm.iActive != ohu.iActive) {
+        useOhu = ohu.iActive;
+    }
+    else {
+        useOhu = (ohu.iLastAudioUs > ohm.iLastAudioUs);
+    }
+    const OhmReceiverStats& stats = (useOhu? iProtocolOhu->ReceiverStats() : iProtocolOhm->ReceiverStats());
+    stats.WriteJson(aWriter);
+}
+
 void SourceReceiver::ZoneUriChanged(const Brx& aZone, const Brx& aUri)
 {
     LOG(kSongcast, "SourceReceiver::ZoneUriChanged(%.*s, %.*s)\n",
@@ -486,7 +511,7 @@ SongcastSender::SongcastSender(IMediaPlayer& aMediaPlayer, ZoneHandler& aZoneHan
     const TUint senderThreadPriority = priorityFiller;
     iSender = new Sender(aMediaPlayer.Env(), aMediaPlayer.Device(), aZoneHandler,
                          aTxTimestamper, aMediaPlayer.ConfigInitialiser(), senderThreadPriority,
-                         Brx::Empty(), pipeline.SenderMinLatencyMs(), aMode,
+                         Brx::Empty(), pipeline.SenderMinLatencyMs(), pipeline.SenderMaxLatencyMs(), aMode,
                          aUnicastOverrideObserver);
     iLoggerSender = new Logger("Sender", *iSender);
     //iLoggerSender->SetEnabled(true);
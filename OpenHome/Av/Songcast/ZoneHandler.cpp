@@ -123,6 +123,12 @@ void ZoneHandler::SetHomeSenderUri(const Brx& aUri)
     SendZoneUri(3);
 }
 
+void ZoneHandler::GetHomeSenderUri(Bwx& aUri)
+{
+    AutoMutex _(iLockTxData);
+    aUri.Replace(iSenderUriHome);
+}
+
 void ZoneHandler::SetCurrentSenderUri(const Brx& aUri)
 {
     if (aUri.Bytes() > iSenderUriCurrent.MaxBytes()) {
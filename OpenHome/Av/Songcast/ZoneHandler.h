@@ -43,6 +43,7 @@ public:
     void StartMonitoring(const Brx& aZone);
     void StopMonitoring();
     void SetHomeSenderUri(const Brx& aUri);
+    void GetHomeSenderUri(Bwx& aUri);
     void SetCurrentSenderUri(const Brx& aUri);
     void ClearCurrentSenderUri();
     void SetSenderMetadata(const Brx& aMetadata);
@@ -154,6 +154,10 @@ void SourceBase::Initialise(IProduct& aProduct, IConfigInitialiser& aConfigInit,
 
 }
 
+void SourceBase::ProductStarted()
+{
+}
+
 void SourceBase::NameChanged(KeyValuePair<const Brx&>& aName)
 {
     iLock.Wait();
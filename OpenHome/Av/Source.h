@@ -34,6 +34,7 @@ public:
     virtual void PipelineStopped() = 0;
 private:
     virtual void Initialise(IProduct& aProduct, Configuration::IConfigInitialiser& aConfigInit, Configuration::IConfigManager& aConfigManagerReader, TUint aId) = 0;
+    virtual void ProductStarted() = 0; // called once, from Product::Start(), after the pipeline has started
 };
 
 class SourceBase : public ISource
@@ -63,6 +64,7 @@ protected:
     void DoActivate();
 private: // from ISource
     void Initialise(IProduct& aProduct, Configuration::IConfigInitialiser& aConfigInit, Configuration::IConfigManager& aConfigManagerReader, TUint aId) override;
+    void ProductStarted() override;
 private:
     static void GetSourceKey(const Brx& aSystemName, const Brx& aSuffix, Bwx& aBuf);
     void NameChanged(Configuration::KeyValuePair<const Brx&>& aName);
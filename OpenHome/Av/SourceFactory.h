@@ -8,8 +8,12 @@ namespace OpenHome {
 namespace Net {
     class DvDevice;
 }
+namespace Configuration {
+    class IStoreReadWrite;
+}
 namespace Media {
     class IClockPuller;
+    class IClockPullerTimestamp;
 }
 namespace Av {
 
@@ -22,12 +26,18 @@ class SourceFactory
 {
 public:
     static ISource* NewPlaylist(IMediaPlayer& aMediaPlayer);
+    static ISource* NewPlaylist(IMediaPlayer& aMediaPlayer, Configuration::IStoreReadWrite& aStore); // playlist is persisted to aStore
+    // aMaxTracks must not exceed aMediaPlayer.MaxPlaylistTracks() (the default for the overloads above)
+    static ISource* NewPlaylist(IMediaPlayer& aMediaPlayer, TUint aMaxTracks);
+    static ISource* NewPlaylist(IMediaPlayer& aMediaPlayer, Configuration::IStoreReadWrite& aStore, TUint aMaxTracks);
     static ISource* NewRadio(IMediaPlayer& aMediaPlayer);
     static ISource* NewRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId);
+    static ISource* NewRadio(IMediaPlayer& aMediaPlayer, const Brx& aTuneInPartnerId, TUint aMaxPresets);
     static ISource* NewUpnpAv(IMediaPlayer& aMediaPlayer, Net::DvDevice& aDevice);
     static ISource* NewRaop(IMediaPlayer& aMediaPlayer, Optional<Media::IClockPuller> aClockPuller, const Brx& aMacAddr, TUint aUdpThreadPriority);
     static ISource* NewReceiver(IMediaPlayer& aMediaPlayer,
                                 Optional<Media::IClockPuller> aClockPuller,
+                                Optional<Media::IClockPullerTimestamp> aClockPullerTimestamp,
                                 Optional<IOhmTimestamper> aTxTimestamper,
                                 Optional<IOhmTimestamper> aRxTimestamper,
                                 Optional<IOhmMsgProcessor> aOhmMsgObserver);
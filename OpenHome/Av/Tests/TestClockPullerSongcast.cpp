@@ -0,0 +1,273 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Songcast/ClockPullerSongcast.h>
+#include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <cstdlib>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Av {
+
+class PullableClockRecorder : public IPullableClock
+{
+public:
+    PullableClockRecorder();
+    TUint Multiplier() const;
+    TUint PullCount() const;
+private: // from IPullableClock
+    void PullClock(TUint aMultiplier) override;
+private:
+    TUint iMultiplier;
+    TUint iPullCount;
+};
+
+class SuiteClockPullerSongcast : public SuiteUnitTest
+{
+    static const TUint kSampleRate = 48000;
+    static const TUint kStepMs = 5;
+    static const TUint kInitialBufferMs = 100;
+    static const TUint kMaxJitterMs = 2;
+public:
+    SuiteClockPullerSongcast();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Simulate(TInt aSenderPpm, TUint aSeconds, TBool aBuffer, TBool aTimestamps);
+    TUint NextRandom();
+    void TestNoPullBeforeStart();
+    void TestBufferLevelFastSender();
+    void TestBufferLevelSlowSender();
+    void TestTimestampsOnly();
+    void TestTimestampGlitchIgnored();
+    void TestPullClamped();
+    void TestStopRestoresNominal();
+    void TestDriftEstimate();
+    void TestDriftEstimateTimestamps();
+private:
+    PullableClockRecorder* iClock;
+    ClockPullerSongcast* iPuller;
+    double iNetTicks;
+    double iRxTicks;
+    double iConsumeRemainder;
+    TUint iNetJump;
+    TUint iRandom;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// PullableClockRecorder
+
+PullableClockRecorder::PullableClockRecorder()
+    : iMultiplier(IPullableClock::kNominalFreq)
+    , iPullCount(0)
+{
+}
+
+TUint PullableClockRecorder::Multiplier() const
+{
+    return iMultiplier;
+}
+
+TUint PullableClockRecorder::PullCount() const
+{
+    return iPullCount;
+}
+
+void PullableClockRecorder::PullClock(TUint aMultiplier)
+{
+    iMultiplier = aMultiplier;
+    iPullCount++;
+}
+
+
+// SuiteClockPullerSongcast
+
+SuiteClockPullerSongcast::SuiteClockPullerSongcast()
+    : SuiteUnitTest("SuiteClockPullerSongcast")
+{
+    AddTest(MakeFunctor(*this, &SuiteClockPullerSongcast::TestNoPullBeforeStart), "TestNoPullBeforeStart");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerSongcast::TestBufferLevelFastSender), "TestBufferLevelFastSender");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerSongcast::TestBufferLevelSlowSender), "TestBufferLevelSlowSender");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerSongcast::TestTimestampsOnly), "TestTimestampsOnly");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerSongcast::TestTimestampGlitchIgnored), "TestTimestampGlitchIgnored");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerSongcast::TestPullClamped), "TestPullClamped");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerSongcast::TestStopRestoresNominal), "TestStopRestoresNominal");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerSongcast::TestDriftEstimate), "TestDriftEstimate");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerSongcast::TestDriftEstimateTimestamps), "TestDriftEstimateTimestamps");
+}
+
+void SuiteClockPullerSongcast::Setup()
+{
+    iClock = new PullableClockRecorder();
+    iPuller = new ClockPullerSongcast(*iClock);
+    iNetTicks = 0;
+    iRxTicks = 0;
+    iConsumeRemainder = 0;
+    iNetJump = 0;
+    iRandom = 12345;
+    // start with the level the pipeline would have buffered before playback began
+    static_cast<IClockPuller*>(iPuller)->Update(static_cast<TInt>(kInitialBufferMs * Jiffies::kPerMs));
+}
+
+void SuiteClockPullerSongcast::TearDown()
+{
+    delete iPuller;
+    delete iClock;
+}
+
+TUint SuiteClockPullerSongcast::NextRandom()
+{
+    iRandom = iRandom * 1103515245 + 12345;
+    return iRandom >> 8;
+}
+
+void SuiteClockPullerSongcast::Simulate(TInt aSenderPpm, TUint aSeconds, TBool aBuffer, TBool aTimestamps)
+{
+    /* The sender produces one frame every kStepMs of its own clock.
+       The receiver plays audio (and timestamps arrivals) using its own, pulled, clock. */
+    IClockPuller& puller = *iPuller;
+    IClockPullerTimestamp& timestamps = *iPuller;
+    const TUint ticksPerSec = Jiffies::SongcastTicksPerSecond(kSampleRate);
+    const TUint stepJiffies = kStepMs * Jiffies::kPerMs;
+    const double sender = 1.0 + aSenderPpm / 1000000.0;
+    const TUint steps = aSeconds * 1000 / kStepMs;
+    for (TUint i=0; i<steps; i++) {
+        const double local = static_cast<double>(iClock->Multiplier()) / IPullableClock::kNominalFreq;
+        const double secs = (kStepMs / 1000.0) / sender; // real time between frames
+        if (aBuffer) {
+            puller.Update(static_cast<TInt>(stepJiffies));
+            iConsumeRemainder += secs * local * Jiffies::kPerSecond;
+            const TInt consumed = static_cast<TInt>(iConsumeRemainder);
+            iConsumeRemainder -= consumed;
+            puller.Update(-consumed);
+        }
+        iNetTicks += secs * sender * ticksPerSec;
+        iRxTicks += secs * local * ticksPerSec;
+        if (aTimestamps) {
+            const TUint jitter = NextRandom() % (kMaxJitterMs * ticksPerSec / 1000);
+            const TUint net = static_cast<TUint>(static_cast<TUint64>(iNetTicks)) + iNetJump;
+            const TUint rx = static_cast<TUint>(static_cast<TUint64>(iRxTicks)) + jitter;
+            timestamps.NotifyTimestamp(net, rx, kSampleRate);
+        }
+    }
+}
+
+void SuiteClockPullerSongcast::TestNoPullBeforeStart()
+{
+    Simulate(500, 60, true, true);
+    TEST(iClock->PullCount() == 0);
+    TEST(iPuller->PullPpm() == 0);
+}
+
+void SuiteClockPullerSongcast::TestBufferLevelFastSender()
+{
+    static_cast<IClockPuller*>(iPuller)->Start();
+    Simulate(200, 600, true, false);
+    TEST(std::abs(iPuller->PullPpm() - 200) <= 5);
+    TEST(iClock->Multiplier() > IPullableClock::kNominalFreq);
+}
+
+void SuiteClockPullerSongcast::TestBufferLevelSlowSender()
+{
+    static_cast<IClockPuller*>(iPuller)->Start();
+    Simulate(-300, 600, true, true);
+    TEST(std::abs(iPuller->PullPpm() + 300) <= 5);
+    TEST(iClock->Multiplier() < IPullableClock::kNominalFreq);
+}
+
+void SuiteClockPullerSongcast::TestTimestampsOnly()
+{
+    // no buffer level updates; timestamps alone should still lock the clocks
+    static_cast<IClockPuller*>(iPuller)->Start();
+    Simulate(150, 300, false, true);
+    TEST(std::abs(iPuller->PullPpm() - 150) <= 10);
+}
+
+void SuiteClockPullerSongcast::TestTimestampGlitchIgnored()
+{
+    static_cast<IClockPuller*>(iPuller)->Start();
+    Simulate(0, 60, false, true);
+    TEST(std::abs(iPuller->PullPpm()) <= 10);
+    // sender restarts its timestamper, jumping 1s ahead
+    iNetJump = Jiffies::SongcastTicksPerSecond(kSampleRate);
+    Simulate(0, 60, false, true);
+    TEST(std::abs(iPuller->PullPpm()) <= 10);
+    // ...or we're told to discard timestamps before it happens again
+    static_cast<IClockPullerTimestamp*>(iPuller)->Reset();
+    iNetJump = 0;
+    Simulate(0, 60, false, true);
+    TEST(std::abs(iPuller->PullPpm()) <= 10);
+}
+
+void SuiteClockPullerSongcast::TestPullClamped()
+{
+    static_cast<IClockPuller*>(iPuller)->Start();
+    Simulate(5000, 120, true, true);
+    TEST(iPuller->PullPpm() == static_cast<TInt>(ClockPullerSongcast::kMaxPullPpm));
+    const TUint maxMultiplier = IPullableClock::kNominalFreq + IPullableClock::kNominalFreq / 1000000 * ClockPullerSongcast::kMaxPullPpm;
+    TEST(iClock->Multiplier() <= maxMultiplier + ClockPullerSongcast::kMaxPullPpm);
+    TEST(iClock->Multiplier() >= maxMultiplier);
+}
+
+void SuiteClockPullerSongcast::TestStopRestoresNominal()
+{
+    IClockPuller& puller = *iPuller;
+    puller.Start();
+    Simulate(200, 120, true, true);
+    TEST(iClock->Multiplier() != IPullableClock::kNominalFreq);
+    const TUint pullCount = iClock->PullCount();
+    puller.Stop();
+    TEST(iClock->Multiplier() == IPullableClock::kNominalFreq);
+    TEST(iClock->PullCount() == pullCount + 1);
+    TEST(iPuller->PullPpm() == 0);
+    // buffer changes while stopped are tracked but don't pull the clock
+    Simulate(200, 60, true, true);
+    TEST(iClock->PullCount() == pullCount + 1);
+}
+
+void SuiteClockPullerSongcast::TestDriftEstimate()
+{
+    const IClockPullerTimestamp& timestamps = *iPuller;
+    TInt ppm = 0;
+    TEST(!timestamps.TryGetDriftPpm(ppm));
+    static_cast<IClockPuller*>(iPuller)->Start();
+    Simulate(250, ClockPullerSongcast::kMinDriftEstimateSecs - 1, true, false);
+    TEST(!timestamps.TryGetDriftPpm(ppm));
+    Simulate(250, 600, true, false);
+    TEST(timestamps.TryGetDriftPpm(ppm));
+    TEST(std::abs(ppm - 250) <= 5);
+    static_cast<IClockPuller*>(iPuller)->Stop();
+    TEST(!timestamps.TryGetDriftPpm(ppm));
+}
+
+void SuiteClockPullerSongcast::TestDriftEstimateTimestamps()
+{
+    // timestamps give an estimate sooner than the buffer level alone
+    const IClockPullerTimestamp& timestamps = *iPuller;
+    TInt ppm = 0;
+    static_cast<IClockPuller*>(iPuller)->Start();
+    Simulate(-200, 2 * ClockPullerSongcast::kTimestampWindowSecs + 1, false, true);
+    TEST(timestamps.TryGetDriftPpm(ppm));
+    TEST(ppm < 0);
+    Simulate(-200, 300, false, true);
+    TEST(timestamps.TryGetDriftPpm(ppm));
+    TEST(std::abs(ppm + 200) <= 10);
+}
+
+
+
+void TestClockPullerSongcast()
+{
+    Runner runner("ClockPullerSongcast tests\n");
+    runner.Add(new SuiteClockPullerSongcast());
+    runner.Run();
+}
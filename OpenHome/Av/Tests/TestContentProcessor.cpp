@@ -1,6 +1,7 @@
 #include <OpenHome/Private/TestFramework.h>
 #include <OpenHome/Media/Protocol/Protocol.h>
 #include <OpenHome/Av/Radio/ContentProcessorFactory.h>
+#include <OpenHome/Av/Radio/UriRacer.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Types.h>
 #include <OpenHome/Buffer.h>
@@ -64,6 +65,30 @@ private:
     void TestParse();
 };
 
+class SuiteRaced : public SuiteContent, private IUriRacer
+{
+public:
+    SuiteRaced();
+    ~SuiteRaced();
+private: // from Suite
+    void Test() override;
+private: // from IUriRacer
+    void Race(UriList& aUris) override;
+    void Interrupt(TBool aInterrupt) override;
+private:
+    void TestPlsStreamsRacedOrder();
+    void TestM3uStreamsRacedOrder();
+    void TestOnlyFirstEntriesRaced();
+    void TestInterruptReachesRacer();
+private:
+    ContentProcessor* iPls;
+    ContentProcessor* iM3u;
+    TUint iRaceCount;
+    TUint iRaceEntries;
+    TUint iInterruptCount;
+    TBool iInterrupted;
+};
+
 class SuiteM3uX : public SuiteContent
 {
 public:
@@ -510,6 +535,161 @@ void SuiteM3u::TestParse()
 }
 
 
+// SuiteRaced
+
+SuiteRaced::SuiteRaced()
+    : SuiteContent("Raced playlist tests")
+    , iRaceCount(0)
+    , iRaceEntries(0)
+    , iInterruptCount(0)
+    , iInterrupted(false)
+{
+    iPls = ContentProcessorFactory::NewPls(*this, *this);
+    iPls->Initialise(*this);
+    iM3u = ContentProcessorFactory::NewM3u(*this, *this);
+    iM3u->Initialise(*this);
+}
+
+SuiteRaced::~SuiteRaced()
+{
+    delete iPls;
+    delete iM3u;
+}
+
+void SuiteRaced::Test()
+{
+    TestPlsStreamsRacedOrder();
+    TestM3uStreamsRacedOrder();
+    TestOnlyFirstEntriesRaced();
+    TestInterruptReachesRacer();
+}
+
+void SuiteRaced::Race(UriList& aUris)
+{
+    // pretend the last entry won and the first failed
+    iRaceCount++;
+    iRaceEntries = aUris.Count();
+    std::vector<TUint> order;
+    for (TUint i=aUris.Count(); i>0; i--) {
+        order.push_back(i-1);
+    }
+    aUris.Reorder(order);
+}
+
+void SuiteRaced::Interrupt(TBool aInterrupt)
+{
+    iInterruptCount++;
+    iInterrupted = aInterrupt;
+}
+
+void SuiteRaced::TestPlsStreamsRacedOrder()
+{
+    static const TChar* kFile =
+        "[playlist]\n"
+        "NumberOfEntries=3\n"
+        "File1=http://mirror1.example.com:80\n"
+        "File2=http://mirror2.example.com:80\n"
+        "File3=http://mirror3.example.com:80\n"
+        "Version=2";
+    FileBrx file(kFile);
+    iFileStream.SetFile(&file);
+    iPls->Reset();
+    iReadBuffer->ReadFlush();
+    const char* expected[] = {"http://mirror3.example.com:80",
+        "http://mirror2.example.com:80",
+        "http://mirror1.example.com:80"};
+    iExpectedStreams = expected;
+    iIndex = 0;
+    iNextResult = EProtocolStreamErrorUnrecoverable;
+    TEST(iPls->Stream(*this, iFileStream.Bytes()) == EProtocolStreamErrorUnrecoverable);
+    TEST(iRaceCount == 1);
+    TEST(iRaceEntries == 3);
+    TEST(iIndex == 3);
+
+    // a stopped stream isn't followed by attempts at the remaining entries
+    iPls->Reset();
+    file.Seek(0);
+    iReadBuffer->ReadFlush();
+    iIndex = 0;
+    iNextResult = EProtocolStreamStopped;
+    TEST(iPls->Stream(*this, iFileStream.Bytes()) == EProtocolStreamStopped);
+    TEST(iRaceCount == 2);
+    TEST(iIndex == 1);
+}
+
+void SuiteRaced::TestM3uStreamsRacedOrder()
+{
+    static const TChar* kFile =
+        "#EXTM3U\n"
+        "#EXTINF:-1,Mirror 1\n"
+        "http://mirror1.example.com/stream\n"
+        "#EXTINF:-1,Mirror 2\n"
+        "http://mirror2.example.com/stream\n";
+    FileBrx file(kFile);
+    iFileStream.SetFile(&file);
+    iM3u->Reset();
+    iReadBuffer->ReadFlush();
+    const char* expected[] = {"http://mirror2.example.com/stream",
+        "http://mirror1.example.com/stream"};
+    iExpectedStreams = expected;
+    iIndex = 0;
+    iRaceCount = 0;
+    iNextResult = EProtocolStreamSuccess;
+    TEST(iM3u->Stream(*this, iFileStream.Bytes()) == EProtocolStreamSuccess);
+    TEST(iRaceCount == 1);
+    TEST(iRaceEntries == 2);
+    TEST(iIndex == 2);
+}
+
+void SuiteRaced::TestOnlyFirstEntriesRaced()
+{
+    // entries beyond those that can be raced are streamed in playlist order as they're read
+    static const TChar* kFile =
+        "#EXTM3U\n"
+        "http://mirror1.example.com/stream\n"
+        "http://mirror2.example.com/stream\n"
+        "http://mirror3.example.com/stream\n"
+        "http://mirror4.example.com/stream\n"
+        "http://mirror5.example.com/stream\n";
+    FileBrx file(kFile);
+    iFileStream.SetFile(&file);
+    iM3u->Reset();
+    iReadBuffer->ReadFlush();
+    const char* expected[] = {"http://mirror3.example.com/stream",
+        "http://mirror2.example.com/stream",
+        "http://mirror1.example.com/stream",
+        "http://mirror4.example.com/stream",
+        "http://mirror5.example.com/stream"};
+    iExpectedStreams = expected;
+    iIndex = 0;
+    iRaceCount = 0;
+    iNextResult = EProtocolStreamErrorUnrecoverable;
+    TEST(iM3u->Stream(*this, iFileStream.Bytes()) == EProtocolStreamErrorUnrecoverable);
+    TEST(iRaceCount == 1);
+    TEST(iRaceEntries == UriRacer::kMaxRacers);
+    TEST(iIndex == 5);
+
+    // a stopped stream isn't followed by reading the remaining entries
+    iM3u->Reset();
+    file.Seek(0);
+    iReadBuffer->ReadFlush();
+    iIndex = 0;
+    iNextResult = EProtocolStreamStopped;
+    TEST(iM3u->Stream(*this, iFileStream.Bytes()) == EProtocolStreamStopped);
+    TEST(iIndex == 1);
+}
+
+void SuiteRaced::TestInterruptReachesRacer()
+{
+    iPls->Interrupt(true);
+    TEST(iInterruptCount == 1);
+    TEST(iInterrupted);
+    iM3u->Interrupt(false);
+    TEST(iInterruptCount == 2);
+    TEST(!iInterrupted);
+}
+
+
 // SuiteM3uX
 
 SuiteM3uX::SuiteM3uX()
@@ -1204,6 +1384,7 @@ void TestContentProcessor()
     Runner runner("Content Processor tests\n");
     runner.Add(new SuitePls());
     runner.Add(new SuiteM3u());
+    runner.Add(new SuiteRaced());
     runner.Add(new SuiteM3uX());
     runner.Add(new SuiteOpml());
     runner.Add(new SuiteAsx());
@@ -0,0 +1,157 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Songcast/FifoSpsc.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Functor.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteFifoSpsc : public SuiteUnitTest
+{
+    static const TUint kSlots = 4;
+    static const TUint kStressEntries = 50000;
+public:
+    SuiteFifoSpsc();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Fill(TUint aFirst, TUint aCount);
+    void StressWriter();
+    void TestEmpty();
+    void TestFull();
+    void TestOrderAcrossWrap();
+    void TestSlotsUsed();
+    void TestConcurrentWriterReader();
+private:
+    FifoSpsc<TUint>* iFifo;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteFifoSpsc
+
+SuiteFifoSpsc::SuiteFifoSpsc()
+    : SuiteUnitTest("SuiteFifoSpsc")
+{
+    AddTest(MakeFunctor(*this, &SuiteFifoSpsc::TestEmpty), "TestEmpty");
+    AddTest(MakeFunctor(*this, &SuiteFifoSpsc::TestFull), "TestFull");
+    AddTest(MakeFunctor(*this, &SuiteFifoSpsc::TestOrderAcrossWrap), "TestOrderAcrossWrap");
+    AddTest(MakeFunctor(*this, &SuiteFifoSpsc::TestSlotsUsed), "TestSlotsUsed");
+    AddTest(MakeFunctor(*this, &SuiteFifoSpsc::TestConcurrentWriterReader), "TestConcurrentWriterReader");
+}
+
+void SuiteFifoSpsc::Setup()
+{
+    iFifo = new FifoSpsc<TUint>(kSlots);
+}
+
+void SuiteFifoSpsc::TearDown()
+{
+    delete iFifo;
+}
+
+void SuiteFifoSpsc::Fill(TUint aFirst, TUint aCount)
+{
+    for (TUint i=0; i<aCount; i++) {
+        TEST(iFifo->TryWrite(aFirst + i));
+    }
+}
+
+void SuiteFifoSpsc::TestEmpty()
+{
+    TUint val = 99;
+    TEST(iFifo->Slots() == kSlots);
+    TEST(iFifo->SlotsUsed() == 0);
+    TEST(!iFifo->TryRead(val));
+    TEST(val == 99);
+}
+
+void SuiteFifoSpsc::TestFull()
+{
+    Fill(0, kSlots);
+    TEST(iFifo->SlotsUsed() == kSlots);
+    TEST(!iFifo->TryWrite(kSlots));
+    TUint val;
+    TEST(iFifo->TryRead(val));
+    TEST(val == 0);
+    TEST(iFifo->TryWrite(kSlots));
+    TEST(!iFifo->TryWrite(kSlots + 1));
+}
+
+void SuiteFifoSpsc::TestOrderAcrossWrap()
+{
+    TUint next = 0;
+    TUint expected = 0;
+    for (TUint round=0; round<10; round++) {
+        const TUint count = 1 + (round % kSlots);
+        Fill(next, count);
+        next += count;
+        for (TUint i=0; i<count; i++) {
+            TUint val;
+            TEST(iFifo->TryRead(val));
+            TEST(val == expected++);
+        }
+        TEST(iFifo->SlotsUsed() == 0);
+    }
+}
+
+void SuiteFifoSpsc::TestSlotsUsed()
+{
+    TUint val;
+    for (TUint i=0; i<kSlots * 3; i++) {
+        TEST(iFifo->TryWrite(i));
+        TEST(iFifo->SlotsUsed() == 1);
+        TEST(iFifo->TryRead(val));
+        TEST(iFifo->SlotsUsed() == 0);
+    }
+    Fill(0, kSlots - 1);
+    TEST(iFifo->SlotsUsed() == kSlots - 1);
+}
+
+void SuiteFifoSpsc::StressWriter()
+{
+    for (TUint i=0; i<kStressEntries; i++) {
+        while (!iFifo->TryWrite(i)) {
+            Thread::Sleep(0);
+        }
+    }
+}
+
+void SuiteFifoSpsc::TestConcurrentWriterReader()
+{
+    ThreadFunctor* writer = new ThreadFunctor("FifoSpscWriter", MakeFunctor(*this, &SuiteFifoSpsc::StressWriter));
+    writer->Start();
+    TUint expected = 0;
+    TBool inOrder = true;
+    while (expected < kStressEntries) {
+        TUint val;
+        if (!iFifo->TryRead(val)) {
+            Thread::Sleep(0);
+            continue;
+        }
+        if (val != expected) {
+            inOrder = false;
+        }
+        expected++;
+    }
+    delete writer;
+    TEST(inOrder);
+    TEST(iFifo->SlotsUsed() == 0);
+}
+
+
+
+void TestFifoSpsc()
+{
+    Runner runner("FifoSpsc tests\n");
+    runner.Add(new SuiteFifoSpsc());
+    runner.Run();
+}
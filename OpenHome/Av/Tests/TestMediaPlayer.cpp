@@ -27,6 +27,7 @@
 #include <OpenHome/Web/ConfigUi/ConfigUiMediaPlayer.h>
 #include <OpenHome/Web/ConfigUi/FileResourceHandler.h>
 #include <OpenHome/Av/UpnpAv/FriendlyNameUpnpAv.h>
+#include <OpenHome/Av/Songcast/ClockPullerSongcast.h>
 
 #undef LPEC_ENABLE
 
@@ -139,6 +140,7 @@ TestMediaPlayer::TestMediaPlayer(Net::DvStack& aDvStack, const Brx& aUdn, const
     , iUserAgent(aUserAgent)
     , iTxTimestamper(nullptr)
     , iRxTimestamper(nullptr)
+    , iClockPullerSongcast(nullptr)
     , iMinWebUiResourceThreads(aMinWebUiResourceThreads)
     , iMaxWebUiTabs(aMaxWebUiTabs)
     , iUiSendQueueSize(aUiSendQueueSize)
@@ -227,6 +229,7 @@ TestMediaPlayer::~TestMediaPlayer()
     delete iFnManagerUpnpAv;
     ASSERT(!iDevice->Enabled());
     delete iMediaPlayer;
+    delete iClockPullerSongcast;
     delete iPipelineObserver;
     delete iInfoLogger;
     delete iDevice;
@@ -410,8 +413,12 @@ void TestMediaPlayer::RegisterPlugins(Environment& aEnv)
     const TUint raopUdpPriority = priorityFiller;
     iMediaPlayer->Add(SourceFactory::NewRaop(*iMediaPlayer, Optional<IClockPuller>(nullptr), macAddr, raopUdpPriority));
 
+    if (iPullableClock != nullptr) {
+        iClockPullerSongcast = new ClockPullerSongcast(*iPullableClock);
+    }
     iMediaPlayer->Add(SourceFactory::NewReceiver(*iMediaPlayer,
-                                                 Optional<IClockPuller>(nullptr),
+                                                 Optional<IClockPuller>(iClockPullerSongcast),
+                                                 Optional<IClockPullerTimestamp>(iClockPullerSongcast),
                                                  Optional<IOhmTimestamper>(iTxTimestamper),
                                                  Optional<IOhmTimestamper>(iRxTimestamper),
                                                  Optional<IOhmMsgProcessor>()));
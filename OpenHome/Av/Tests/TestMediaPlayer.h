@@ -50,6 +50,7 @@ namespace Web {
 namespace Av {
     class FriendlyNameHandler;
     class RamStore;
+    class ClockPullerSongcast;
 namespace Test {
 
 class VolumeProfile : public IVolumeProfile
@@ -158,6 +159,7 @@ private:
     const Brh iUserAgent;
     IOhmTimestamper* iTxTimestamper;
     IOhmTimestamper* iRxTimestamper;
+    Av::ClockPullerSongcast* iClockPullerSongcast;
     VolumeSinkLogger iVolumeLogger;
     Bws<Uri::kMaxUriBytes+1> iPresentationUrl;
     Media::LoggingPipelineObserver* iPipelineObserver;
@@ -0,0 +1,300 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Songcast/OhmFec.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+#include <OpenHome/Av/Songcast/Ohm.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Stream.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteOhmFec : public SuiteUnitTest
+{
+    static const TUint kGroupFrames = 4;
+    static const TUint kMaxFrames = 3 * kGroupFrames;
+    static const TUint kSamplesPerFrame = 240;
+public:
+    SuiteOhmFec();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void CreateFrame(TUint aFrame, TUint aSamples, TBool aResent = false);
+    TBool EncodeGroup(TUint aFirstFrame); // returns true if the last frame of the group produced parity
+    void ParseParity();
+    void StartDecoder(); // teaches the decoder the group size
+    void TestParityHeaderRoundTrip();
+    void TestEncoderWaitsForGroupBoundary();
+    void TestEncoderDisabled();
+    void TestRecoverSingleMissing();
+    void TestRecoverVaryingFrameSizes();
+    void TestResentFlagIgnored();
+    void TestTwoMissingNotRecovered();
+    void TestNothingMissingNotRecovered();
+    void TestMalformedParityIgnored();
+private:
+    OhmMsgFactory* iFactory;
+    OhmFecEncoder* iEncoder;
+    OhmFecDecoder* iDecoder;
+    Bws<OhmFecGroup::kMaxFrameBytes> iFrames[kMaxFrames];
+    Bws<OhmFecGroup::kMaxFrameBytes> iRecovered;
+    OhmHeaderParity iHeaderParity;
+    Bws<OhmFecGroup::kMaxFrameBytes> iParity;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteOhmFec
+
+SuiteOhmFec::SuiteOhmFec()
+    : SuiteUnitTest("SuiteOhmFec")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmFec::TestParityHeaderRoundTrip), "TestParityHeaderRoundTrip");
+    AddTest(MakeFunctor(*this, &SuiteOhmFec::TestEncoderWaitsForGroupBoundary), "TestEncoderWaitsForGroupBoundary");
+    AddTest(MakeFunctor(*this, &SuiteOhmFec::TestEncoderDisabled), "TestEncoderDisabled");
+    AddTest(MakeFunctor(*this, &SuiteOhmFec::TestRecoverSingleMissing), "TestRecoverSingleMissing");
+    AddTest(MakeFunctor(*this, &SuiteOhmFec::TestRecoverVaryingFrameSizes), "TestRecoverVaryingFrameSizes");
+    AddTest(MakeFunctor(*this, &SuiteOhmFec::TestResentFlagIgnored), "TestResentFlagIgnored");
+    AddTest(MakeFunctor(*this, &SuiteOhmFec::TestTwoMissingNotRecovered), "TestTwoMissingNotRecovered");
+    AddTest(MakeFunctor(*this, &SuiteOhmFec::TestNothingMissingNotRecovered), "TestNothingMissingNotRecovered");
+    AddTest(MakeFunctor(*this, &SuiteOhmFec::TestMalformedParityIgnored), "TestMalformedParityIgnored");
+}
+
+void SuiteOhmFec::Setup()
+{
+    iFactory = new OhmMsgFactory(2, 1, 1);
+    iEncoder = new OhmFecEncoder();
+    iEncoder->SetGroupFrames(kGroupFrames);
+    iDecoder = new OhmFecDecoder();
+    for (TUint i=0; i<kMaxFrames; i++) {
+        CreateFrame(i, kSamplesPerFrame);
+    }
+}
+
+void SuiteOhmFec::TearDown()
+{
+    delete iDecoder;
+    delete iEncoder;
+    delete iFactory;
+}
+
+void SuiteOhmFec::CreateFrame(TUint aFrame, TUint aSamples, TBool aResent)
+{
+    Bws<OhmMsgAudio::kStreamHeaderBytes> streamHeader;
+    OhmMsgAudio::GetStreamHeader(streamHeader, 0, 48000, 1536000, 0, 16, 2, Brn("PCM"));
+    Bws<OhmMsgAudio::kMaxSampleBytes> audio;
+    for (TUint i=0; i<aSamples*4; i++) {
+        audio.Append((TByte)(aFrame * 37 + i));
+    }
+    OhmMsgAudio* msg = iFactory->CreateAudio(false, true, false, false, aSamples, aFrame, 0, 0, aFrame * kSamplesPerFrame, streamHeader, audio);
+    msg->Serialise();
+    if (aResent) {
+        msg->SetResent(true);
+    }
+    iFrames[aFrame % kMaxFrames].Replace(msg->SendableBuffer());
+    msg->RemoveRef();
+}
+
+TBool SuiteOhmFec::EncodeGroup(TUint aFirstFrame)
+{
+    TBool parity = false;
+    for (TUint i=0; i<kGroupFrames; i++) {
+        parity = iEncoder->Add(aFirstFrame + i, iFrames[(aFirstFrame + i) % kMaxFrames]);
+        if (i < kGroupFrames - 1) {
+            TEST(!parity);
+        }
+    }
+    if (parity) {
+        ParseParity();
+    }
+    return parity;
+}
+
+void SuiteOhmFec::ParseParity()
+{
+    ReaderBuffer reader(iEncoder->Parity());
+    OhmHeader header;
+    header.Internalise(reader);
+    TEST(header.MsgType() == OhmHeader::kMsgTypeParity);
+    iHeaderParity.Internalise(reader, header);
+    iParity.Replace(reader.Read(iHeaderParity.ParityBytes()));
+}
+
+void SuiteOhmFec::StartDecoder()
+{
+    TEST(EncodeGroup(0));
+    TUint frame;
+    TEST(!iDecoder->Recover(iHeaderParity, iParity, frame, iRecovered));
+}
+
+void SuiteOhmFec::TestParityHeaderRoundTrip()
+{
+    TEST(EncodeGroup(0));
+    TEST(iHeaderParity.FirstFrame() == 0);
+    TEST(iHeaderParity.FrameCount() == kGroupFrames);
+    TEST(iHeaderParity.FrameBytesXor() == 0); // even number of identically sized frames
+    TEST(iHeaderParity.ParityBytes() == iFrames[0].Bytes());
+    TEST(iParity.Bytes() == iHeaderParity.ParityBytes());
+    TEST(iEncoder->Parity().Bytes() == OhmHeader::kHeaderBytes + iHeaderParity.MsgBytes());
+}
+
+void SuiteOhmFec::TestEncoderWaitsForGroupBoundary()
+{
+    for (TUint i=1; i<kGroupFrames; i++) {
+        TEST(!iEncoder->Add(i, iFrames[i]));
+    }
+    TEST(EncodeGroup(kGroupFrames));
+    TEST(iHeaderParity.FirstFrame() == kGroupFrames);
+
+    // skipping a frame abandons the group
+    TEST(!iEncoder->Add(2 * kGroupFrames, iFrames[2 * kGroupFrames]));
+    for (TUint i=2; i<kGroupFrames; i++) {
+        TEST(!iEncoder->Add(2 * kGroupFrames + i, iFrames[2 * kGroupFrames + i]));
+    }
+}
+
+void SuiteOhmFec::TestEncoderDisabled()
+{
+    iEncoder->SetGroupFrames(0);
+    for (TUint i=0; i<kMaxFrames; i++) {
+        TEST(!iEncoder->Add(i, iFrames[i]));
+    }
+}
+
+void SuiteOhmFec::TestRecoverSingleMissing()
+{
+    StartDecoder();
+    for (TUint missing=0; missing<kGroupFrames; missing++) {
+        const TUint first = kGroupFrames;
+        for (TUint i=0; i<kGroupFrames; i++) {
+            if (i != missing) {
+                iDecoder->Add(first + i, iFrames[first + i]);
+            }
+        }
+        TEST(EncodeGroup(first));
+        TUint frame = 0;
+        TEST(iDecoder->Recover(iHeaderParity, iParity, frame, iRecovered));
+        TEST(frame == first + missing);
+        TEST(iRecovered == iFrames[first + missing]);
+        // the group is now complete so the same parity can't be used again
+        TEST(!iDecoder->Recover(iHeaderParity, iParity, frame, iRecovered));
+
+        // recovered frame parses as audio
+        ReaderBuffer reader(iRecovered);
+        OhmHeader header;
+        header.Internalise(reader);
+        TEST(header.MsgType() == OhmHeader::kMsgTypeAudio);
+        OhmMsgAudio* msg = iFactory->CreateAudio(reader, header);
+        TEST(msg->Frame() == first + missing);
+        TEST(!msg->Resent());
+        TEST(msg->Samples() == kSamplesPerFrame);
+        msg->RemoveRef();
+        iDecoder->Reset();
+        StartDecoder();
+    }
+}
+
+void SuiteOhmFec::TestRecoverVaryingFrameSizes()
+{
+    StartDecoder();
+    const TUint first = kGroupFrames;
+    CreateFrame(first, kSamplesPerFrame / 2);
+    CreateFrame(first + 1, kSamplesPerFrame);
+    CreateFrame(first + 2, 17);
+    CreateFrame(first + 3, kSamplesPerFrame / 3);
+    TEST(EncodeGroup(first));
+    TEST(iHeaderParity.ParityBytes() == iFrames[first + 1].Bytes());
+
+    iDecoder->Add(first, iFrames[first]);
+    iDecoder->Add(first + 1, iFrames[first + 1]);
+    iDecoder->Add(first + 3, iFrames[first + 3]);
+    TUint frame = 0;
+    TEST(iDecoder->Recover(iHeaderParity, iParity, frame, iRecovered));
+    TEST(frame == first + 2);
+    TEST(iRecovered == iFrames[first + 2]);
+}
+
+void SuiteOhmFec::TestResentFlagIgnored()
+{
+    StartDecoder();
+    const TUint first = kGroupFrames;
+    TEST(EncodeGroup(first));
+    CreateFrame(first + 1, kSamplesPerFrame, true);
+    iDecoder->Add(first, iFrames[first]);
+    iDecoder->Add(first + 1, iFrames[first + 1]);
+    iDecoder->Add(first + 2, iFrames[first + 2]);
+    TUint frame = 0;
+    TEST(iDecoder->Recover(iHeaderParity, iParity, frame, iRecovered));
+    TEST(frame == first + 3);
+    TEST(iRecovered == iFrames[first + 3]);
+}
+
+void SuiteOhmFec::TestTwoMissingNotRecovered()
+{
+    StartDecoder();
+    const TUint first = kGroupFrames;
+    iDecoder->Add(first, iFrames[first]);
+    iDecoder->Add(first + 3, iFrames[first + 3]);
+    TEST(EncodeGroup(first));
+    TUint frame;
+    TEST(!iDecoder->Recover(iHeaderParity, iParity, frame, iRecovered));
+    // a late arrival leaves a single frame missing
+    iDecoder->Add(first + 2, iFrames[first + 2]);
+    TEST(iDecoder->Recover(iHeaderParity, iParity, frame, iRecovered));
+    TEST(frame == first + 1);
+    TEST(iRecovered == iFrames[first + 1]);
+}
+
+void SuiteOhmFec::TestNothingMissingNotRecovered()
+{
+    StartDecoder();
+    const TUint first = kGroupFrames;
+    for (TUint i=0; i<kGroupFrames; i++) {
+        iDecoder->Add(first + i, iFrames[first + i]);
+        iDecoder->Add(first + i, iFrames[first + i]); // duplicates are ignored
+    }
+    TEST(EncodeGroup(first));
+    TUint frame;
+    TEST(!iDecoder->Recover(iHeaderParity, iParity, frame, iRecovered));
+}
+
+void SuiteOhmFec::TestMalformedParityIgnored()
+{
+    StartDecoder();
+    const TUint first = kGroupFrames;
+    for (TUint i=1; i<kGroupFrames; i++) {
+        iDecoder->Add(first + i, iFrames[first + i]);
+    }
+    TEST(EncodeGroup(first));
+    TUint frame;
+
+    OhmHeaderParity misaligned(first + 1, kGroupFrames, iHeaderParity.FrameBytesXor(), iHeaderParity.ParityBytes());
+    TEST(!iDecoder->Recover(misaligned, iParity, frame, iRecovered));
+    OhmHeaderParity tooManyFrames(0, OhmFecGroup::kMaxFrames + 1, iHeaderParity.FrameBytesXor(), iHeaderParity.ParityBytes());
+    TEST(!iDecoder->Recover(tooManyFrames, iParity, frame, iRecovered));
+    TEST(!iDecoder->Recover(iHeaderParity, iParity.Split(0, iParity.Bytes() - 1), frame, iRecovered));
+
+    Bws<OhmFecGroup::kMaxFrameBytes> corrupt(iParity);
+    corrupt[OhmHeader::kHeaderBytes + 4] ^= 0xff; // frame number
+    TEST(!iDecoder->Recover(iHeaderParity, corrupt, frame, iRecovered));
+
+    // the genuine parity still works
+    TEST(iDecoder->Recover(iHeaderParity, iParity, frame, iRecovered));
+    TEST(frame == first);
+}
+
+
+
+void TestOhmFec()
+{
+    Runner runner("OhmFec tests\n");
+    runner.Add(new SuiteOhmFec());
+    runner.Run();
+}
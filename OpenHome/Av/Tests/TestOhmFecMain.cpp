@@ -0,0 +1,14 @@
+#include <OpenHome/Private/TestFramework.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+
+extern void TestOhmFec();
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::UpnpLibrary::InitialiseMinimal(aInitParams);
+    TestOhmFec();
+    delete aInitParams;
+    Net::UpnpLibrary::Close();
+}
@@ -0,0 +1,251 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Songcast/OhmLossless.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+#include <OpenHome/Av/Songcast/Ohm.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Stream.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteOhmLossless : public SuiteUnitTest
+{
+    static const TUint kSamplesPerFrame = 240; // 5ms at 48kHz
+    enum ESignal
+    {
+        eSine
+       ,eSilence
+       ,eNoise
+       ,eImpulses
+    };
+public:
+    SuiteOhmLossless();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Generate(ESignal aSignal, TUint aSamples, TUint aChannels, TUint aBitDepth);
+    TBool RoundTrip(TUint aSamples, TUint aChannels, TUint aBitDepth);
+    TUint NextRandom();
+    void TestSineRoundTrip();
+    void TestImpulsesRoundTrip();
+    void TestSilenceCompressesWell();
+    void TestIdenticalChannelsUseSide();
+    void TestNoiseNotCompressed();
+    void TestUnsupportedFormats();
+    void TestTruncatedThrows();
+    void TestOutputTooSmallThrows();
+    void TestCompressedFlagSerialised();
+private:
+    OhmLosslessCodec* iCodec;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iPcm;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iEncoded;
+    Bws<OhmMsgAudio::kMaxSampleBytes> iDecoded;
+    TUint iRandom;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteOhmLossless
+
+SuiteOhmLossless::SuiteOhmLossless()
+    : SuiteUnitTest("SuiteOhmLossless")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestSineRoundTrip), "TestSineRoundTrip");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestImpulsesRoundTrip), "TestImpulsesRoundTrip");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestSilenceCompressesWell), "TestSilenceCompressesWell");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestIdenticalChannelsUseSide), "TestIdenticalChannelsUseSide");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestNoiseNotCompressed), "TestNoiseNotCompressed");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestUnsupportedFormats), "TestUnsupportedFormats");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestTruncatedThrows), "TestTruncatedThrows");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestOutputTooSmallThrows), "TestOutputTooSmallThrows");
+    AddTest(MakeFunctor(*this, &SuiteOhmLossless::TestCompressedFlagSerialised), "TestCompressedFlagSerialised");
+}
+
+void SuiteOhmLossless::Setup()
+{
+    iCodec = new OhmLosslessCodec();
+    iRandom = 12345;
+}
+
+void SuiteOhmLossless::TearDown()
+{
+    delete iCodec;
+}
+
+TUint SuiteOhmLossless::NextRandom()
+{
+    iRandom = iRandom * 1103515245 + 12345;
+    return iRandom >> 8;
+}
+
+void SuiteOhmLossless::Generate(ESignal aSignal, TUint aSamples, TUint aChannels, TUint aBitDepth)
+{
+    const TUint bytesPerSample = aBitDepth / 8;
+    const TInt max = (1 << (aBitDepth - 1)) - 1;
+    iPcm.SetBytes(0);
+    for (TUint i=0; i<aSamples; i++) {
+        for (TUint ch=0; ch<aChannels; ch++) {
+            TInt val = 0;
+            switch (aSignal)
+            {
+            case eSine:
+                val = (TInt)(0.8 * max * sin(0.05 * i + 0.3 * ch));
+                break;
+            case eSilence:
+                break;
+            case eNoise:
+                val = (TInt)(NextRandom() & ((1u << aBitDepth) - 1)) - max - 1;
+                break;
+            case eImpulses:
+                val = ((i % 17) == 0? -max - 1 : (((i % 17) == 1)? max : 0));
+                break;
+            }
+            for (TUint b=bytesPerSample; b>0; b--) {
+                iPcm.Append((TByte)((TUint)val >> (8 * (b-1))));
+            }
+        }
+    }
+}
+
+TBool SuiteOhmLossless::RoundTrip(TUint aSamples, TUint aChannels, TUint aBitDepth)
+{
+    if (!iCodec->Encode(iPcm, aChannels, aBitDepth, iEncoded)) {
+        return false;
+    }
+    TEST(iEncoded.Bytes() < iPcm.Bytes());
+    iCodec->Decode(iEncoded, aSamples, aChannels, aBitDepth, iDecoded);
+    return iDecoded == iPcm;
+}
+
+void SuiteOhmLossless::TestSineRoundTrip()
+{
+    static const TUint kBitDepths[] = { 8, 16, 24 };
+    for (TUint bitDepth : kBitDepths) {
+        for (TUint channels=1; channels<=6; channels++) {
+            const TUint samples = std::min(kSamplesPerFrame, OhmMsgAudio::kMaxSampleBytes / (channels * bitDepth / 8));
+            Generate(eSine, samples, channels, bitDepth);
+            TEST(RoundTrip(samples, channels, bitDepth));
+        }
+    }
+    // a single sample is too short to compress
+    Generate(eSine, 1, 2, 16);
+    TEST(!iCodec->Encode(iPcm, 2, 16, iEncoded));
+}
+
+void SuiteOhmLossless::TestImpulsesRoundTrip()
+{
+    // full scale steps produce residuals that need escaping
+    Generate(eImpulses, kSamplesPerFrame * 4, 2, 24);
+    TEST(RoundTrip(kSamplesPerFrame * 4, 2, 24));
+    Generate(eImpulses, kSamplesPerFrame, 1, 16);
+    TEST(RoundTrip(kSamplesPerFrame, 1, 16));
+}
+
+void SuiteOhmLossless::TestSilenceCompressesWell()
+{
+    Generate(eSilence, kSamplesPerFrame, 2, 24);
+    TEST(RoundTrip(kSamplesPerFrame, 2, 24));
+    TEST(iEncoded.Bytes() < iPcm.Bytes() / 8);
+}
+
+void SuiteOhmLossless::TestIdenticalChannelsUseSide()
+{
+    Generate(eSine, kSamplesPerFrame, 1, 16);
+    Bws<OhmMsgAudio::kMaxSampleBytes> mono(iPcm);
+    TEST(iCodec->Encode(mono, 1, 16, iEncoded));
+    const TUint monoBytes = iEncoded.Bytes();
+    iPcm.SetBytes(0);
+    for (TUint i=0; i<mono.Bytes(); i+=2) {
+        iPcm.Append(mono.Split(i, 2));
+        iPcm.Append(mono.Split(i, 2));
+    }
+    TEST(RoundTrip(kSamplesPerFrame, 2, 16));
+    // side channel is all zeros so costs little more than the mono stream
+    TEST(iEncoded.Bytes() < monoBytes + monoBytes / 4);
+}
+
+void SuiteOhmLossless::TestNoiseNotCompressed()
+{
+    Generate(eNoise, kSamplesPerFrame, 2, 16);
+    TEST(!iCodec->Encode(iPcm, 2, 16, iEncoded));
+}
+
+void SuiteOhmLossless::TestUnsupportedFormats()
+{
+    TEST(!OhmLosslessCodec::IsSupported(2, 32));
+    TEST(!OhmLosslessCodec::IsSupported(0, 16));
+    TEST(!OhmLosslessCodec::IsSupported(OhmLosslessCodec::kMaxChannels + 1, 16));
+    Generate(eSilence, kSamplesPerFrame, 2, 16);
+    TEST(!iCodec->Encode(iPcm, 1, 32, iEncoded));
+    TEST(!iCodec->Encode(Brx::Empty(), 2, 16, iEncoded));
+    // partial samples
+    TEST(!iCodec->Encode(iPcm.Split(0, iPcm.Bytes() - 1), 2, 16, iEncoded));
+}
+
+void SuiteOhmLossless::TestTruncatedThrows()
+{
+    Generate(eSine, kSamplesPerFrame, 2, 16);
+    TEST(iCodec->Encode(iPcm, 2, 16, iEncoded));
+    Brn truncated(iEncoded.Ptr(), iEncoded.Bytes() / 2);
+    TEST_THROWS(iCodec->Decode(truncated, kSamplesPerFrame, 2, 16, iDecoded), OhmError);
+    TEST_THROWS(iCodec->Decode(Brx::Empty(), kSamplesPerFrame, 2, 16, iDecoded), OhmError);
+    Bws<OhmMsgAudio::kMaxSampleBytes> badVersion(iEncoded);
+    badVersion[0] = 0xff;
+    TEST_THROWS(iCodec->Decode(badVersion, kSamplesPerFrame, 2, 16, iDecoded), OhmError);
+}
+
+void SuiteOhmLossless::TestOutputTooSmallThrows()
+{
+    Generate(eSine, kSamplesPerFrame, 2, 16);
+    TEST(iCodec->Encode(iPcm, 2, 16, iEncoded));
+    Bws<kSamplesPerFrame> small;
+    TEST_THROWS(iCodec->Decode(iEncoded, kSamplesPerFrame, 2, 16, small), OhmError);
+}
+
+void SuiteOhmLossless::TestCompressedFlagSerialised()
+{
+    OhmMsgFactory factory(2, 1, 1);
+    Bws<OhmMsgAudio::kStreamHeaderBytes> streamHeader;
+    OhmMsgAudio::GetStreamHeader(streamHeader, 0, 48000, 1536000, 0, 16, 2, Brn("PCM"));
+    Generate(eSine, kSamplesPerFrame, 2, 16);
+    TEST(iCodec->Encode(iPcm, 2, 16, iEncoded));
+    OhmMsgAudio* msg = factory.CreateAudio(false, true, false, false, kSamplesPerFrame, 7, 0, 0, 0, streamHeader, iEncoded);
+    TEST(!msg->Compressed());
+    msg->SetCompressed(true);
+    msg->Serialise();
+    msg->SetResent(true);
+    Bws<OhmMsgAudio::kStreamHeaderBytes + OhmMsgAudio::kMaxSampleBytes> buf(msg->SendableBuffer());
+    msg->RemoveRef();
+
+    ReaderBuffer reader(buf);
+    OhmHeader header;
+    header.Internalise(reader);
+    msg = factory.CreateAudio(reader, header);
+    TEST(msg->Compressed());
+    TEST(msg->Resent());
+    TEST(msg->Lossless());
+    TEST(msg->Samples() == kSamplesPerFrame);
+    iCodec->Decode(msg->Audio(), msg->Samples(), msg->Channels(), msg->BitDepth(), iDecoded);
+    TEST(iDecoded == iPcm);
+    msg->RemoveRef();
+}
+
+
+
+void TestOhmLossless()
+{
+    Runner runner("OhmLossless tests\n");
+    runner.Add(new SuiteOhmLossless());
+    runner.Run();
+}
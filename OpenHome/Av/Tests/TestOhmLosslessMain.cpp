@@ -0,0 +1,14 @@
+#include <OpenHome/Private/TestFramework.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+
+extern void TestOhmLossless();
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::UpnpLibrary::InitialiseMinimal(aInitParams);
+    TestOhmLossless();
+    delete aInitParams;
+    Net::UpnpLibrary::Close();
+}
@@ -0,0 +1,299 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Songcast/OhmReceiverStats.h>
+#include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Json.h>
+
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteOhmReceiverStats : public SuiteUnitTest, private IClockPullerTimestamp
+{
+    static const TUint kSampleRate = 48000;
+    static const TUint kSamplesPerFrame = 240; // 5ms
+    static const TUint kLatencyMs = 100;
+    static const TUint64 kStartUs = 5000000;
+public:
+    SuiteOhmReceiverStats();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IClockPullerTimestamp
+    void Reset() override;
+    void NotifyTimestamp(TUint aNetworkTimestamp, TUint aRxTimestamp, TUint aSampleRate) override;
+    TBool TryGetDriftPpm(TInt& aPpm) const override;
+private:
+    void Frames(TUint aCount, TInt aSenderPpm, TUint aMaxJitterUs);
+    void Frame(TUint aExtraDelayUs, TBool aRecovered);
+    TUint NextRandom();
+    void TestCounters();
+    void TestStartClears();
+    void TestSteadyArrival();
+    void TestDelayReducesOccupancy();
+    void TestRecoveredIgnoredForTiming();
+    void TestJitter();
+    void TestClockFromPuller();
+    void TestClockUnknownWithoutPuller();
+    void TestSenderRestart();
+    void TestJson();
+private:
+    OhmReceiverStats* iStats;
+    TUint64 iSampleStart;
+    double iNowUs;
+    TUint iRandom;
+    TBool iDriftValid;
+    TInt iDriftPpm;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteOhmReceiverStats
+
+SuiteOhmReceiverStats::SuiteOhmReceiverStats()
+    : SuiteUnitTest("SuiteOhmReceiverStats")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverStats::TestCounters), "TestCounters");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverStats::TestStartClears), "TestStartClears");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverStats::TestSteadyArrival), "TestSteadyArrival");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverStats::TestDelayReducesOccupancy), "TestDelayReducesOccupancy");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverStats::TestRecoveredIgnoredForTiming), "TestRecoveredIgnoredForTiming");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverStats::TestJitter), "TestJitter");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverStats::TestClockFromPuller), "TestClockFromPuller");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverStats::TestClockUnknownWithoutPuller), "TestClockUnknownWithoutPuller");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverStats::TestSenderRestart), "TestSenderRestart");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiverStats::TestJson), "TestJson");
+}
+
+void SuiteOhmReceiverStats::Setup()
+{
+    iStats = new OhmReceiverStats("ohm", *this);
+    iStats->Start();
+    iSampleStart = 1000;
+    iNowUs = static_cast<double>(kStartUs);
+    iRandom = 98765;
+    iDriftValid = false;
+    iDriftPpm = 0;
+}
+
+void SuiteOhmReceiverStats::TearDown()
+{
+    delete iStats;
+}
+
+void SuiteOhmReceiverStats::Reset()
+{
+}
+
+void SuiteOhmReceiverStats::NotifyTimestamp(TUint /*aNetworkTimestamp*/, TUint /*aRxTimestamp*/, TUint /*aSampleRate*/)
+{
+}
+
+TBool SuiteOhmReceiverStats::TryGetDriftPpm(TInt& aPpm) const
+{
+    if (iDriftValid) {
+        aPpm = iDriftPpm;
+    }
+    return iDriftValid;
+}
+
+TUint SuiteOhmReceiverStats::NextRandom()
+{
+    iRandom = iRandom * 1103515245 + 12345;
+    return iRandom >> 8;
+}
+
+void SuiteOhmReceiverStats::Frames(TUint aCount, TInt aSenderPpm, TUint aMaxJitterUs)
+{
+    const double frameUs = kSamplesPerFrame * 1000000.0 / kSampleRate / (1.0 + aSenderPpm / 1000000.0);
+    for (TUint i=0; i<aCount; i++) {
+        const TUint jitter = (aMaxJitterUs == 0? 0 : NextRandom() % aMaxJitterUs);
+        Frame(jitter, false);
+        iNowUs += frameUs;
+        iSampleStart += kSamplesPerFrame;
+    }
+}
+
+void SuiteOhmReceiverStats::Frame(TUint aExtraDelayUs, TBool aRecovered)
+{
+    const TUint64 now = static_cast<TUint64>(iNowUs) + aExtraDelayUs;
+    iStats->NotifyAudio(iSampleStart, kSampleRate, kLatencyMs, now, aRecovered);
+}
+
+void SuiteOhmReceiverStats::TestCounters()
+{
+    iStats->NotifyMissing(3);
+    iStats->NotifyMissing(2);
+    iStats->NotifyLate();
+    iStats->NotifyRecoveredFec();
+    iStats->NotifyRecoveredResend();
+    iStats->NotifyRecoveredResend();
+    iStats->NotifyConcealed(4);
+    iStats->NotifyResendRequested(5);
+    iStats->NotifyResendRequested(1);
+    iStats->NotifyResendSuppressed(7);
+    iStats->NotifyRtt(2500);
+
+    OhmReceiverStats::Values v;
+    iStats->Get(v);
+    TEST(v.iActive);
+    TEST(v.iFramesMissing == 5);
+    TEST(v.iFramesLate == 1);
+    TEST(v.iFramesRecoveredFec == 1);
+    TEST(v.iFramesRecoveredResend == 2);
+    TEST(v.iFramesConcealed == 4);
+    TEST(v.iResendRequests == 2);
+    TEST(v.iResendFramesRequested == 6);
+    TEST(v.iResendFramesSuppressed == 7);
+    TEST(v.iRttValid);
+    TEST(v.iRttUs == 2500);
+
+    iStats->Stop();
+    iStats->Get(v);
+    TEST(!v.iActive);
+    TEST(v.iFramesMissing == 5);
+}
+
+void SuiteOhmReceiverStats::TestStartClears()
+{
+    Frames(10, 0, 0);
+    iStats->NotifyMissing(3);
+    iStats->Stop();
+    iStats->Start();
+    OhmReceiverStats::Values v;
+    iStats->Get(v);
+    TEST(v.iActive);
+    TEST(v.iFramesReceived == 0);
+    TEST(v.iFramesMissing == 0);
+    TEST(!v.iClockValid);
+}
+
+void SuiteOhmReceiverStats::TestSteadyArrival()
+{
+    Frames(200, 0, 0);
+    OhmReceiverStats::Values v;
+    iStats->Get(v);
+    TEST(v.iFramesReceived == 200);
+    TEST(v.iFramesLate == 0);
+    TEST(v.iJitterUs == 0);
+    TEST(v.iLatencyMs == kLatencyMs);
+    TEST(v.iOccupancyMs == kLatencyMs);
+}
+
+void SuiteOhmReceiverStats::TestDelayReducesOccupancy()
+{
+    Frames(20, 0, 0);
+    OhmReceiverStats::Values v;
+    Frame(30000, false);
+    iStats->Get(v);
+    TEST(v.iOccupancyMs == kLatencyMs - 30);
+    TEST(v.iFramesLate == 0);
+
+    Frame(150000, false);
+    iStats->Get(v);
+    TEST(v.iOccupancyMs == 0);
+    TEST(v.iFramesLate == 1);
+
+    // arrivals back on time restore occupancy
+    Frames(1, 0, 0);
+    iStats->Get(v);
+    TEST(v.iOccupancyMs == kLatencyMs);
+}
+
+void SuiteOhmReceiverStats::TestRecoveredIgnoredForTiming()
+{
+    Frames(20, 0, 0);
+    Frame(150000, true);
+    OhmReceiverStats::Values v;
+    iStats->Get(v);
+    TEST(v.iFramesReceived == 21);
+    TEST(v.iFramesLate == 0);
+    TEST(v.iOccupancyMs == kLatencyMs);
+    TEST(v.iJitterUs == 0);
+}
+
+void SuiteOhmReceiverStats::TestJitter()
+{
+    Frames(2000, 0, 4000);
+    OhmReceiverStats::Values v;
+    iStats->Get(v);
+    // mean |difference| of two uniform [0,4000) values is ~1333us
+    TEST(v.iJitterUs > 800 && v.iJitterUs < 2000);
+    TEST(v.iOccupancyMs > kLatencyMs - 5);
+    TEST(v.iFramesLate == 0);
+}
+
+void SuiteOhmReceiverStats::TestClockFromPuller()
+{
+    OhmReceiverStats::Values v;
+    iStats->Get(v);
+    TEST(!v.iClockValid);
+    iDriftValid = true;
+    iDriftPpm = -300;
+    iStats->Get(v);
+    TEST(v.iClockValid);
+    TEST(v.iClockPpm == -300);
+    iStats->Stop();
+    iStats->Get(v);
+    TEST(!v.iClockValid);
+}
+
+void SuiteOhmReceiverStats::TestClockUnknownWithoutPuller()
+{
+    OhmReceiverStats stats("ohu", Optional<IClockPullerTimestamp>());
+    stats.Start();
+    stats.NotifyAudio(0, kSampleRate, kLatencyMs, kStartUs, false);
+    OhmReceiverStats::Values v;
+    stats.Get(v);
+    TEST(v.iFramesReceived == 1);
+    TEST(!v.iClockValid);
+}
+
+void SuiteOhmReceiverStats::TestSenderRestart()
+{
+    Frames(100, 0, 0);
+    // sender restarts its sample count; arrivals relative to the new stream are on time
+    iSampleStart = 0;
+    iNowUs += 500000;
+    Frames(100, 0, 0);
+    OhmReceiverStats::Values v;
+    iStats->Get(v);
+    TEST(v.iFramesReceived == 200);
+    TEST(v.iFramesLate == 0);
+    TEST(v.iOccupancyMs == kLatencyMs);
+}
+
+void SuiteOhmReceiverStats::TestJson()
+{
+    Frames(3, 0, 0);
+    iStats->NotifyMissing(2);
+    Bws<1024> buf;
+    WriterBuffer writer(buf);
+    iStats->WriteJson(writer);
+    JsonParser parser;
+    parser.Parse(buf);
+    TEST(parser.String("scheme") == Brn("ohm"));
+    TEST(parser.Bool("active"));
+    TEST(parser.Num("framesReceived") == 3);
+    TEST(parser.Num("framesMissing") == 2);
+    TEST(parser.Num("latencyMs") == (TInt)kLatencyMs);
+    TEST(!parser.Bool("clockValid"));
+}
+
+
+
+void TestOhmReceiverStats()
+{
+    Runner runner("OhmReceiverStats tests\n");
+    runner.Add(new SuiteOhmReceiverStats());
+    runner.Run();
+}
@@ -0,0 +1,203 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Songcast/OhmSender.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+#include <OpenHome/Buffer.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteOhmSenderHistory : public SuiteUnitTest
+{
+    static const TUint kMaxFrames = 16;
+public:
+    SuiteOhmSenderHistory();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Add(TUint aFrame);
+    void AddRange(TUint aFirst, TUint aLast); // inclusive
+    void TestAddFind();
+    void TestDepthEvicts();
+    void TestCapacityWraps();
+    void TestReduceDepth();
+    void TestGapInFrames();
+    void TestFrameCountReset();
+    void TestClearReleasesMsgs();
+    void TestReplace();
+private:
+    OhmMsgFactory* iFactory;
+    OhmSenderHistory* iHistory;
+    Bws<OhmMsgAudio::kStreamHeaderBytes> iStreamHeader;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteOhmSenderHistory
+
+SuiteOhmSenderHistory::SuiteOhmSenderHistory()
+    : SuiteUnitTest("SuiteOhmSenderHistory")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestAddFind), "TestAddFind");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestDepthEvicts), "TestDepthEvicts");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestCapacityWraps), "TestCapacityWraps");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestReduceDepth), "TestReduceDepth");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestGapInFrames), "TestGapInFrames");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestFrameCountReset), "TestFrameCountReset");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestClearReleasesMsgs), "TestClearReleasesMsgs");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderHistory::TestReplace), "TestReplace");
+}
+
+void SuiteOhmSenderHistory::Setup()
+{
+    iFactory = new OhmMsgFactory(kMaxFrames + 1, 1, 1);
+    iHistory = new OhmSenderHistory(kMaxFrames);
+    iStreamHeader.SetBytes(0);
+    OhmMsgAudio::GetStreamHeader(iStreamHeader, 0, 48000, 1536000, 0, 16, 2, Brn("PCM"));
+}
+
+void SuiteOhmSenderHistory::TearDown()
+{
+    delete iHistory;
+    delete iFactory;
+}
+
+void SuiteOhmSenderHistory::Add(TUint aFrame)
+{
+    OhmMsgAudio* msg = iFactory->CreateAudio(false, true, false, false, 0, aFrame, 0, 0, 0, iStreamHeader, Brx::Empty());
+    iHistory->Add(msg);
+}
+
+void SuiteOhmSenderHistory::AddRange(TUint aFirst, TUint aLast)
+{
+    for (TUint i=aFirst; i!=aLast+1; i++) {
+        Add(i);
+    }
+}
+
+void SuiteOhmSenderHistory::TestAddFind()
+{
+    TEST(iHistory->MaxFrames() == kMaxFrames);
+    TEST(iHistory->Depth() == kMaxFrames);
+    TEST(iHistory->Find(0) == nullptr);
+    AddRange(0, 4);
+    TEST(iHistory->Count() == 5);
+    for (TUint i=0; i<=4; i++) {
+        OhmMsgAudio* msg = iHistory->Find(i);
+        TEST(msg != nullptr);
+        TEST(msg->Frame() == i);
+    }
+    TEST(iHistory->Find(5) == nullptr);
+}
+
+void SuiteOhmSenderHistory::TestDepthEvicts()
+{
+    iHistory->SetDepth(4);
+    AddRange(0, 9);
+    TEST(iHistory->Count() == 4);
+    for (TUint i=0; i<=5; i++) {
+        TEST(iHistory->Find(i) == nullptr);
+    }
+    for (TUint i=6; i<=9; i++) {
+        TEST(iHistory->Find(i) != nullptr);
+    }
+}
+
+void SuiteOhmSenderHistory::TestCapacityWraps()
+{
+    // would exhaust iFactory if evicted msgs weren't released
+    AddRange(0, 3 * kMaxFrames);
+    TEST(iHistory->Count() == kMaxFrames);
+    TEST(iHistory->Find(2 * kMaxFrames) == nullptr);
+    TEST(iHistory->Find(2 * kMaxFrames + 1) != nullptr);
+    TEST(iHistory->Find(3 * kMaxFrames) != nullptr);
+}
+
+void SuiteOhmSenderHistory::TestReduceDepth()
+{
+    AddRange(0, 9);
+    iHistory->SetDepth(3);
+    TEST(iHistory->Count() == 3);
+    TEST(iHistory->Find(6) == nullptr);
+    TEST(iHistory->Find(7) != nullptr);
+    // increasing depth doesn't resurrect evicted frames...
+    iHistory->SetDepth(kMaxFrames);
+    TEST(iHistory->Find(6) == nullptr);
+    // ...but does retain more new ones
+    AddRange(10, 20);
+    TEST(iHistory->Count() == 14);
+    TEST(iHistory->Find(7) != nullptr);
+}
+
+void SuiteOhmSenderHistory::TestGapInFrames()
+{
+    iHistory->SetDepth(4);
+    AddRange(0, 1);
+    Add(5);
+    TEST(iHistory->Find(0) == nullptr);
+    TEST(iHistory->Find(1) == nullptr);
+    TEST(iHistory->Find(5) != nullptr);
+}
+
+void SuiteOhmSenderHistory::TestFrameCountReset()
+{
+    AddRange(0, 9);
+    Add(0); // sender restarted its frame count
+    OhmMsgAudio* msg = iHistory->Find(0);
+    TEST(msg != nullptr);
+    TEST(msg->Frame() == 0);
+    TEST(iHistory->Find(9) == nullptr);
+    TEST(iHistory->Find(1) == nullptr);
+}
+
+void SuiteOhmSenderHistory::TestClearReleasesMsgs()
+{
+    AddRange(0, kMaxFrames - 1);
+    iHistory->Clear();
+    TEST(iHistory->Count() == 0);
+    TEST(iHistory->Find(kMaxFrames - 1) == nullptr);
+    std::vector<OhmMsgAudio*> msgs;
+    for (TUint i=0; i<kMaxFrames+1; i++) {
+        msgs.push_back(iFactory->CreateAudio());
+    }
+    for (auto msg : msgs) {
+        msg->RemoveRef();
+    }
+}
+
+void SuiteOhmSenderHistory::TestReplace()
+{
+    AddRange(0, 4);
+    OhmMsgAudio* msg = iHistory->Find(2);
+    OhmMsgAudio* replacement = iFactory->CreateAudio(false, true, false, false, 0, 2, 0, 0, 0, iStreamHeader, Brx::Empty());
+    iHistory->Replace(*msg, replacement);
+    TEST(iHistory->Find(2) == replacement);
+    TEST(iHistory->Count() == 5);
+
+    // replacing with nullptr removes a frame without affecting its neighbours
+    iHistory->Replace(*replacement, nullptr);
+    TEST(iHistory->Find(2) == nullptr);
+    TEST(iHistory->Find(1) != nullptr);
+    TEST(iHistory->Find(3) != nullptr);
+    TEST(iHistory->Count() == 4);
+    AddRange(5, kMaxFrames + 2);
+    TEST(iHistory->Count() == kMaxFrames);
+}
+
+
+
+void TestOhmSenderHistory()
+{
+    Runner runner("OhmSenderHistory tests\n");
+    runner.Add(new SuiteOhmSenderHistory());
+    runner.Run();
+}
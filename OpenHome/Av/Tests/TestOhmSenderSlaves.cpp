@@ -0,0 +1,207 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Songcast/OhmSender.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Converter.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteOhmSenderSlaves : public SuiteUnitTest
+{
+    static const TUint kExpiry = 10000;
+public:
+    SuiteOhmSenderSlaves();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    static Endpoint MakeEndpoint(TUint aIndex);
+    void TestAddFind();
+    void TestCapacity();
+    void TestRemovePreservesOrder();
+    void TestRemoveExpired();
+    void TestExpiryWraps();
+    void TestRemoveLast();
+    void TestEvictLast();
+    void TestResendStats();
+    void TestExternalise();
+private:
+    OhmSenderSlaves* iSlaves;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteOhmSenderSlaves
+
+SuiteOhmSenderSlaves::SuiteOhmSenderSlaves()
+    : SuiteUnitTest("SuiteOhmSenderSlaves")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderSlaves::TestAddFind), "TestAddFind");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderSlaves::TestCapacity), "TestCapacity");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderSlaves::TestRemovePreservesOrder), "TestRemovePreservesOrder");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderSlaves::TestRemoveExpired), "TestRemoveExpired");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderSlaves::TestExpiryWraps), "TestExpiryWraps");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderSlaves::TestRemoveLast), "TestRemoveLast");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderSlaves::TestEvictLast), "TestEvictLast");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderSlaves::TestResendStats), "TestResendStats");
+    AddTest(MakeFunctor(*this, &SuiteOhmSenderSlaves::TestExternalise), "TestExternalise");
+}
+
+void SuiteOhmSenderSlaves::Setup()
+{
+    iSlaves = new OhmSenderSlaves();
+}
+
+void SuiteOhmSenderSlaves::TearDown()
+{
+    delete iSlaves;
+}
+
+Endpoint SuiteOhmSenderSlaves::MakeEndpoint(TUint aIndex)
+{ // static
+    return Endpoint(51972 + aIndex, 0x0a000001 + aIndex);
+}
+
+void SuiteOhmSenderSlaves::TestAddFind()
+{
+    TEST(iSlaves->Count() == 0);
+    TEST(!iSlaves->Refresh(MakeEndpoint(0), kExpiry, 0));
+    TEST(iSlaves->Add(MakeEndpoint(0), kExpiry, 0));
+    TEST(iSlaves->Count() == 1);
+    TEST(iSlaves->Refresh(MakeEndpoint(0), kExpiry + 1, OhmHeaderJoin::kCapabilitySlaves));
+    TEST(iSlaves->At(0).Expiry() == kExpiry + 1);
+    TEST(iSlaves->At(0).Capabilities() == OhmHeaderJoin::kCapabilitySlaves);
+    TEST(!iSlaves->Refresh(MakeEndpoint(1), kExpiry, 0));
+}
+
+void SuiteOhmSenderSlaves::TestCapacity()
+{
+    for (TUint i=0; i<OhmSenderSlaves::kMaxSlaves; i++) {
+        TEST(iSlaves->Add(MakeEndpoint(i), kExpiry, 0));
+    }
+    TEST(iSlaves->Count() == OhmSenderSlaves::kMaxSlaves);
+    TEST(OhmSenderSlaves::kMaxSlaves >= 32);
+    TEST(!iSlaves->Add(MakeEndpoint(OhmSenderSlaves::kMaxSlaves), kExpiry, 0));
+    TEST(iSlaves->Count() == OhmSenderSlaves::kMaxSlaves);
+    iSlaves->Clear();
+    TEST(iSlaves->Count() == 0);
+}
+
+void SuiteOhmSenderSlaves::TestRemovePreservesOrder()
+{
+    for (TUint i=0; i<4; i++) {
+        TEST(iSlaves->Add(MakeEndpoint(i), kExpiry, 0));
+    }
+    TEST(iSlaves->Remove(MakeEndpoint(1)));
+    TEST(!iSlaves->Remove(MakeEndpoint(1)));
+    TEST(iSlaves->Count() == 3);
+    TEST(iSlaves->At(0).GetEndpoint().Equals(MakeEndpoint(0)));
+    TEST(iSlaves->At(1).GetEndpoint().Equals(MakeEndpoint(2)));
+    TEST(iSlaves->At(2).GetEndpoint().Equals(MakeEndpoint(3)));
+    // slaves keep their stats as later entries are shuffled down
+    iSlaves->NotifyResend(MakeEndpoint(3), 4);
+    TEST(iSlaves->Remove(MakeEndpoint(0)));
+    TEST(iSlaves->At(1).GetEndpoint().Equals(MakeEndpoint(3)));
+    TEST(iSlaves->At(1).FramesRequested() == 4);
+}
+
+void SuiteOhmSenderSlaves::TestRemoveExpired()
+{
+    TEST(iSlaves->Add(MakeEndpoint(0), 100, 0));
+    TEST(iSlaves->Add(MakeEndpoint(1), 200, 0));
+    TEST(iSlaves->Add(MakeEndpoint(2), 100, 0));
+    TEST(!iSlaves->RemoveExpired(99));
+    TEST(iSlaves->RemoveExpired(100));
+    TEST(iSlaves->Count() == 1);
+    TEST(iSlaves->At(0).GetEndpoint().Equals(MakeEndpoint(1)));
+}
+
+void SuiteOhmSenderSlaves::TestExpiryWraps()
+{
+    const TUint now = 0xffffff00;
+    TEST(iSlaves->Add(MakeEndpoint(0), now + kExpiry, 0)); // wraps
+    TEST(!iSlaves->RemoveExpired(now));
+    TEST(iSlaves->RemoveExpired(now + kExpiry));
+}
+
+void SuiteOhmSenderSlaves::TestRemoveLast()
+{
+    TEST(iSlaves->Add(MakeEndpoint(0), 100, 0));
+    TEST(iSlaves->Add(MakeEndpoint(1), 200, OhmHeaderJoin::kCapabilitySlaves));
+    Endpoint ep;
+    TUint expiry = 0;
+    TUint capabilities = 0;
+    iSlaves->RemoveLast(ep, expiry, capabilities);
+    TEST(ep.Equals(MakeEndpoint(1)));
+    TEST(expiry == 200);
+    TEST(capabilities == OhmHeaderJoin::kCapabilitySlaves);
+    TEST(iSlaves->Count() == 1);
+}
+
+void SuiteOhmSenderSlaves::TestEvictLast()
+{
+    for (TUint i = 0; i < 4; i++) {
+        TEST(iSlaves->Add(MakeEndpoint(i), kExpiry, 0));
+    }
+    Endpoint ep;
+    TEST(!iSlaves->TryEvictLast(4, ep));
+    TEST(iSlaves->TryEvictLast(2, ep));
+    TEST(ep.Equals(MakeEndpoint(3)));
+    TEST(iSlaves->TryEvictLast(2, ep));
+    TEST(ep.Equals(MakeEndpoint(2)));
+    TEST(!iSlaves->TryEvictLast(2, ep));
+    TEST(iSlaves->Count() == 2);
+    TEST(iSlaves->At(1).GetEndpoint().Equals(MakeEndpoint(1)));
+}
+
+void SuiteOhmSenderSlaves::TestResendStats()
+{
+    TEST(iSlaves->Add(MakeEndpoint(0), kExpiry, 0));
+    TEST(iSlaves->Add(MakeEndpoint(1), kExpiry, 0));
+    iSlaves->NotifyResend(MakeEndpoint(1), 3);
+    iSlaves->NotifyResend(MakeEndpoint(1), 2);
+    iSlaves->NotifyResend(MakeEndpoint(2), 7); // not a slave - ignored
+    TEST(iSlaves->At(0).ResendRequests() == 0);
+    TEST(iSlaves->At(0).FramesRequested() == 0);
+    TEST(iSlaves->At(1).ResendRequests() == 2);
+    TEST(iSlaves->At(1).FramesRequested() == 5);
+}
+
+void SuiteOhmSenderSlaves::TestExternalise()
+{
+    TEST(iSlaves->Add(MakeEndpoint(0), kExpiry, 0));
+    TEST(iSlaves->Add(MakeEndpoint(1), kExpiry, 0));
+    TEST(iSlaves->Add(MakeEndpoint(2), kExpiry, 0));
+    Bws<3 * 6> buf;
+    WriterBuffer writer(buf);
+    iSlaves->Externalise(writer, OhmSenderSlaves::kMaxSlaves);
+    TEST(buf.Bytes() == 3 * 6);
+    for (TUint i=0; i<3; i++) {
+        const Endpoint ep = MakeEndpoint(i);
+        TEST(Converter::BeUint32At(buf, i * 6) == ep.Address());
+        TEST(Converter::BeUint16At(buf, i * 6 + 4) == ep.Port());
+    }
+
+    // list can be limited to the size an older master receiver supports
+    writer.Flush();
+    iSlaves->Externalise(writer, 2);
+    TEST(buf.Bytes() == 2 * 6);
+    TEST(Converter::BeUint32At(buf, 6) == MakeEndpoint(1).Address());
+}
+
+
+
+void TestOhmSenderSlaves()
+{
+    Runner runner("OhmSenderSlaves tests\n");
+    runner.Add(new SuiteOhmSenderSlaves());
+    runner.Run();
+}
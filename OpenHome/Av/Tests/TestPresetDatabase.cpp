@@ -0,0 +1,461 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Radio/PresetDatabase.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Configuration/Tests/ConfigRamStore.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+using namespace OpenHome::Media;
+using namespace OpenHome::Configuration;
+
+namespace OpenHome {
+namespace Av {
+
+class SuitePresetDatabase : public SuiteUnitTest, private IPresetDatabaseObserver
+{
+    static const TUint kMaxPresets = 1000;
+public:
+    SuitePresetDatabase();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IPresetDatabaseObserver
+    void PresetDatabaseChanged() override;
+private:
+    TUint Set(TUint aIndex, TUint aVal, TUint aMetaDataBytes = 32);
+    TBool Matches(TUint aId, TUint aVal);
+    void TestEmpty();
+    void TestSetAndRead();
+    void TestUnchangedKeepsId();
+    void TestClear();
+    void TestIdArray();
+    void TestNextPrev();
+    void TestMetaDataTruncated();
+    void TestTruncatedMetaDataCompared();
+    void TestArenaCompacts();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    TrackFactory* iTrackFactory;
+    PresetDatabase* iDb;
+    TUint iChangedCount;
+};
+
+class SuitePresetCache : public SuiteUnitTest
+{
+public:
+    SuitePresetCache();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestRoundTrip();
+    void TestMissing();
+    void TestDelete();
+    void TestMetaDataTruncated();
+    void TestCorruptIgnored();
+    void TestUndersizedBuffersIgnored();
+    void TestPrefixesIndependent();
+private:
+    ConfigRamStore* iStore;
+    PresetCache* iCache;
+    BwsTrackUri iUri;
+    Bws<IPresetDatabaseWriter::kMaxMetaDataBytes> iMetaData;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuitePresetDatabase
+
+SuitePresetDatabase::SuitePresetDatabase()
+    : SuiteUnitTest("SuitePresetDatabase")
+{
+    AddTest(MakeFunctor(*this, &SuitePresetDatabase::TestEmpty), "TestEmpty");
+    AddTest(MakeFunctor(*this, &SuitePresetDatabase::TestSetAndRead), "TestSetAndRead");
+    AddTest(MakeFunctor(*this, &SuitePresetDatabase::TestUnchangedKeepsId), "TestUnchangedKeepsId");
+    AddTest(MakeFunctor(*this, &SuitePresetDatabase::TestClear), "TestClear");
+    AddTest(MakeFunctor(*this, &SuitePresetDatabase::TestIdArray), "TestIdArray");
+    AddTest(MakeFunctor(*this, &SuitePresetDatabase::TestNextPrev), "TestNextPrev");
+    AddTest(MakeFunctor(*this, &SuitePresetDatabase::TestMetaDataTruncated), "TestMetaDataTruncated");
+    AddTest(MakeFunctor(*this, &SuitePresetDatabase::TestTruncatedMetaDataCompared), "TestTruncatedMetaDataCompared");
+    AddTest(MakeFunctor(*this, &SuitePresetDatabase::TestArenaCompacts), "TestArenaCompacts");
+}
+
+void SuitePresetDatabase::Setup()
+{
+    iTrackFactory = new TrackFactory(iInfoAggregator, 10);
+    iDb = new PresetDatabase(*iTrackFactory, kMaxPresets);
+    iDb->AddObserver(*this);
+    iChangedCount = 0;
+}
+
+void SuitePresetDatabase::TearDown()
+{
+    delete iDb;
+    delete iTrackFactory;
+}
+
+void SuitePresetDatabase::PresetDatabaseChanged()
+{
+    iChangedCount++;
+}
+
+TUint SuitePresetDatabase::Set(TUint aIndex, TUint aVal, TUint aMetaDataBytes)
+{
+    Bws<32> uri("uri");
+    Ascii::AppendDec(uri, aVal);
+    Bwh metaData(aMetaDataBytes);
+    metaData.Replace(uri);
+    while (metaData.Bytes() < aMetaDataBytes) {
+        metaData.Append('m');
+    }
+    TUint id;
+    iDb->SetPreset(aIndex, uri, metaData, id);
+    return id;
+}
+
+TBool SuitePresetDatabase::Matches(TUint aId, TUint aVal)
+{
+    Bws<32> expected("uri");
+    Ascii::AppendDec(expected, aVal);
+    BwsTrackUri uri;
+    BwsTrackMetaData metaData;
+    if (!iDb->TryGetPresetById(aId, uri, metaData)) {
+        return false;
+    }
+    return (uri == expected && metaData.BeginsWith(expected));
+}
+
+void SuitePresetDatabase::TestEmpty()
+{
+    TEST(iDb->MaxNumPresets() == kMaxPresets);
+    TEST(iDb->GetPresetId(1) == IPresetDatabaseReader::kPresetIdNone);
+    TEST(iDb->GetPresetId(kMaxPresets + 1) == IPresetDatabaseReader::kPresetIdNone);
+    TEST(iDb->FirstTrackRef() == nullptr);
+    TEST(iDb->LastTrackRef() == nullptr);
+    TEST(iDb->TrackRefById(1) == nullptr);
+    TEST(iDb->iArena.size() == 0);
+}
+
+void SuitePresetDatabase::TestSetAndRead()
+{
+    const TUint id = Set(kMaxPresets - 1, 7);
+    TEST(id != IPresetDatabaseReader::kPresetIdNone);
+    TEST(Matches(id, 7));
+    TEST(iDb->GetPresetId(kMaxPresets) == id);
+    TEST(iDb->GetPresetNumber(id) == kMaxPresets);
+    TUint index = 0;
+    BwsTrackMetaData metaData;
+    TEST(iDb->TryGetPresetById(id, 0, metaData, index));
+    TEST(index == kMaxPresets - 1);
+    TUint foundId;
+    TEST(iDb->TryGetPresetByMetaData(metaData, foundId));
+    TEST(foundId == id);
+    Track* track = iDb->TrackRefById(id);
+    TEST(track != nullptr);
+    TEST(track->Uri() == Brn("uri7"));
+    track->RemoveRef();
+    // arena holds only what is used
+    TEST(iDb->iArena.size() == 4 + 32);
+}
+
+void SuitePresetDatabase::TestUnchangedKeepsId()
+{
+    const TUint id = Set(3, 1);
+    iDb->EndSetPresets();
+    TEST(iChangedCount == 1);
+    TEST(Set(3, 1) == id);
+    iDb->EndSetPresets();
+    TEST(iChangedCount == 1);
+    const TUint id2 = Set(3, 2);
+    TEST(id2 != id);
+    TEST(!Matches(id, 1));
+    TEST(Matches(id2, 2));
+    iDb->EndSetPresets();
+    TEST(iChangedCount == 2);
+}
+
+void SuitePresetDatabase::TestClear()
+{
+    const TUint id = Set(0, 1);
+    iDb->ClearPreset(0);
+    TEST(iDb->GetPresetId(1) == IPresetDatabaseReader::kPresetIdNone);
+    TEST(iDb->GetPresetNumber(id) == IPresetDatabaseReader::kPresetIdNone);
+    TEST(iDb->TrackRefById(id) == nullptr);
+    BwsTrackUri uri;
+    BwsTrackMetaData metaData;
+    iDb->ReadPreset(0, uri, metaData);
+    TEST(uri.Bytes() == 0);
+    TEST(metaData.Bytes() == 0);
+}
+
+void SuitePresetDatabase::TestIdArray()
+{
+    std::vector<TUint32> ids;
+    TUint seq;
+    iDb->GetIdArray(ids, seq);
+    TEST(ids.size() == kMaxPresets);
+    const TUint seqInitial = seq;
+    const TUint id1 = Set(1, 1);
+    const TUint id2 = Set(500, 2);
+    iDb->GetIdArray(ids, seq);
+    TEST(seq != seqInitial);
+    for (TUint i=0; i<kMaxPresets; i++) {
+        const TUint expected = (i == 1? id1 : (i == 500? id2 : IPresetDatabaseReader::kPresetIdNone));
+        if (ids[i] != expected) {
+            TEST(ids[i] == expected);
+            break;
+        }
+    }
+}
+
+void SuitePresetDatabase::TestNextPrev()
+{
+    const TUint id1 = Set(2, 1);
+    const TUint id2 = Set(40, 2);
+    const TUint id3 = Set(900, 3);
+
+    Track* track = iDb->FirstTrackRef();
+    TEST(track->Uri() == Brn("uri1"));
+    track->RemoveRef();
+    track = iDb->LastTrackRef();
+    TEST(track->Uri() == Brn("uri3"));
+    track->RemoveRef();
+
+    // empty presets are skipped
+    track = iDb->NextTrackRef(id1);
+    TEST(track->Uri() == Brn("uri2"));
+    track->RemoveRef();
+    track = iDb->PrevTrackRef(id3);
+    TEST(track->Uri() == Brn("uri2"));
+    track->RemoveRef();
+    TEST(iDb->NextTrackRef(id3) == nullptr);
+    TEST(iDb->PrevTrackRef(id1) == nullptr);
+    (void)id2;
+}
+
+void SuitePresetDatabase::TestMetaDataTruncated()
+{
+    const TUint bytes = IPresetDatabaseWriter::kMaxMetaDataBytes + 100;
+    const TUint id = Set(0, 1, bytes);
+    BwsTrackUri uri;
+    BwsTrackMetaData metaData;
+    iDb->ReadPreset(0, uri, metaData);
+    TEST(metaData.Bytes() == IPresetDatabaseWriter::kMaxMetaDataBytes);
+    // re-setting the same (over-long) metadata is not a change
+    iDb->EndSetPresets();
+    const TUint changed = iChangedCount;
+    TEST(Set(0, 1, bytes) == id);
+    iDb->EndSetPresets();
+    TEST(iChangedCount == changed);
+}
+
+void SuitePresetDatabase::TestTruncatedMetaDataCompared()
+{
+    const TUint max = IPresetDatabaseWriter::kMaxMetaDataBytes;
+    Bwh metaData(max + 16);
+    metaData.SetBytes(max + 16);
+    memset(const_cast<TByte*>(metaData.Ptr()), 'a', metaData.Bytes());
+    TUint id;
+    iDb->SetPreset(0, Brn("uri"), metaData, id);
+    iDb->EndSetPresets();
+    TEST(iChangedCount == 1);
+
+    // differences beyond the limit are discarded by truncation so aren't a change
+    metaData[max + 8] = 'b';
+    TUint id2;
+    iDb->SetPreset(0, Brn("uri"), metaData, id2);
+    iDb->EndSetPresets();
+    TEST(id2 == id);
+    TEST(iChangedCount == 1);
+
+    // metadata that is exactly the truncated form isn't a change either
+    iDb->SetPreset(0, Brn("uri"), Brn(metaData.Ptr(), max), id2);
+    iDb->EndSetPresets();
+    TEST(id2 == id);
+    TEST(iChangedCount == 1);
+
+    // ...but differences before the limit are
+    metaData[max - 1] = 'b';
+    iDb->SetPreset(0, Brn("uri"), metaData, id2);
+    iDb->EndSetPresets();
+    TEST(id2 != id);
+    TEST(iChangedCount == 2);
+    BwsTrackUri uri;
+    BwsTrackMetaData readMetaData;
+    iDb->ReadPreset(0, uri, readMetaData);
+    TEST(readMetaData == Brn(metaData.Ptr(), max));
+}
+
+void SuitePresetDatabase::TestArenaCompacts()
+{
+    // repeatedly replacing every preset should not grow the arena without limit
+    std::vector<TUint> ids(kMaxPresets);
+    for (TUint round=0; round<10; round++) {
+        for (TUint i=0; i<kMaxPresets; i++) {
+            ids[i] = Set(i, round * kMaxPresets + i, 100 + (i % 7) * 50);
+        }
+    }
+    TUint live = 0;
+    for (TUint i=0; i<kMaxPresets; i++) {
+        Bws<32> uri("uri");
+        Ascii::AppendDec(uri, 9 * kMaxPresets + i);
+        live += uri.Bytes() + 100 + (i % 7) * 50;
+    }
+    TEST(iDb->iArena.size() <= 2 * live + IPresetDatabaseWriter::kMaxMetaDataBytes);
+    TBool ok = true;
+    for (TUint i=0; i<kMaxPresets && ok; i++) {
+        ok = Matches(ids[i], 9 * kMaxPresets + i);
+    }
+    TEST(ok);
+
+    for (TUint i=0; i<kMaxPresets; i+=2) {
+        iDb->ClearPreset(i);
+    }
+    ok = true;
+    for (TUint i=1; i<kMaxPresets && ok; i+=2) {
+        ok = Matches(ids[i], 9 * kMaxPresets + i);
+    }
+    TEST(ok);
+    TEST(iDb->iArena.size() <= 2 * live);
+}
+
+
+
+// SuitePresetCache
+
+SuitePresetCache::SuitePresetCache()
+    : SuiteUnitTest("SuitePresetCache")
+{
+    AddTest(MakeFunctor(*this, &SuitePresetCache::TestRoundTrip), "TestRoundTrip");
+    AddTest(MakeFunctor(*this, &SuitePresetCache::TestMissing), "TestMissing");
+    AddTest(MakeFunctor(*this, &SuitePresetCache::TestDelete), "TestDelete");
+    AddTest(MakeFunctor(*this, &SuitePresetCache::TestMetaDataTruncated), "TestMetaDataTruncated");
+    AddTest(MakeFunctor(*this, &SuitePresetCache::TestCorruptIgnored), "TestCorruptIgnored");
+    AddTest(MakeFunctor(*this, &SuitePresetCache::TestUndersizedBuffersIgnored), "TestUndersizedBuffersIgnored");
+    AddTest(MakeFunctor(*this, &SuitePresetCache::TestPrefixesIndependent), "TestPrefixesIndependent");
+}
+
+void SuitePresetCache::Setup()
+{
+    iStore = new ConfigRamStore();
+    iCache = new PresetCache(*iStore, Brn("Test.Preset."));
+}
+
+void SuitePresetCache::TearDown()
+{
+    delete iCache;
+    delete iStore;
+}
+
+void SuitePresetCache::TestRoundTrip()
+{
+    iCache->Write(3, Brn("http://example.com/stream"), Brn("<DIDL-Lite>station</DIDL-Lite>"));
+    TEST(iCache->TryRead(3, iUri, iMetaData));
+    TEST(iUri == Brn("http://example.com/stream"));
+    TEST(iMetaData == Brn("<DIDL-Lite>station</DIDL-Lite>"));
+
+    // entries are independent and can be replaced
+    iCache->Write(4, Brn("http://example.com/other"), Brx::Empty());
+    iCache->Write(3, Brn("http://example.com/new"), Brn("new"));
+    TEST(iCache->TryRead(4, iUri, iMetaData));
+    TEST(iUri == Brn("http://example.com/other"));
+    TEST(iMetaData.Bytes() == 0);
+    TEST(iCache->TryRead(3, iUri, iMetaData));
+    TEST(iUri == Brn("http://example.com/new"));
+    TEST(iMetaData == Brn("new"));
+
+    // longest uri and metadata
+    Bwh uri(kTrackUriMaxBytes, kTrackUriMaxBytes);
+    uri.SetBytes(kTrackUriMaxBytes);
+    memset(const_cast<TByte*>(uri.Ptr()), 'u', uri.Bytes());
+    Bwh metaData(IPresetDatabaseWriter::kMaxMetaDataBytes);
+    metaData.SetBytes(IPresetDatabaseWriter::kMaxMetaDataBytes);
+    memset(const_cast<TByte*>(metaData.Ptr()), 'm', metaData.Bytes());
+    iCache->Write(0, uri, metaData);
+    TEST(iCache->TryRead(0, iUri, iMetaData));
+    TEST(iUri == uri);
+    TEST(iMetaData == metaData);
+}
+
+void SuitePresetCache::TestMissing()
+{
+    TEST(!iCache->TryRead(0, iUri, iMetaData));
+    iCache->Write(1, Brn("uri"), Brn("metadata"));
+    TEST(!iCache->TryRead(0, iUri, iMetaData));
+    TEST(!iCache->TryRead(10, iUri, iMetaData));
+}
+
+void SuitePresetCache::TestDelete()
+{
+    iCache->Write(2, Brn("uri"), Brn("metadata"));
+    iCache->Delete(2);
+    TEST(!iCache->TryRead(2, iUri, iMetaData));
+    iCache->Delete(2); // deleting a missing entry is harmless
+    iCache->Delete(5);
+}
+
+void SuitePresetCache::TestMetaDataTruncated()
+{
+    const TUint max = IPresetDatabaseWriter::kMaxMetaDataBytes;
+    Bwh metaData(max + 100);
+    metaData.SetBytes(max + 100);
+    memset(const_cast<TByte*>(metaData.Ptr()), 'm', metaData.Bytes());
+    iCache->Write(0, Brn("uri"), metaData);
+    TEST(iCache->TryRead(0, iUri, iMetaData));
+    TEST(iUri == Brn("uri"));
+    TEST(iMetaData == Brn(metaData.Ptr(), max));
+}
+
+void SuitePresetCache::TestCorruptIgnored()
+{
+    iStore->Write(Brn("Test.Preset.0"), Brx::Empty());
+    TEST(!iCache->TryRead(0, iUri, iMetaData));
+    iStore->Write(Brn("Test.Preset.1"), Brn("\x01"));
+    TEST(!iCache->TryRead(1, iUri, iMetaData));
+    // uri length exceeds the entry
+    iStore->Write(Brn("Test.Preset.2"), Brn("\x00\x10uri"));
+    TEST(!iCache->TryRead(2, iUri, iMetaData));
+    // the format is [uriBytes:2][uri][metadata]
+    const TByte entry[] = { 0, 3, 'u', 'r', 'i', 'm', 'd' };
+    iStore->Write(Brn("Test.Preset.3"), Brn(entry, sizeof(entry)));
+    TEST(iCache->TryRead(3, iUri, iMetaData));
+    TEST(iUri == Brn("uri"));
+    TEST(iMetaData == Brn("md"));
+}
+
+void SuitePresetCache::TestUndersizedBuffersIgnored()
+{
+    iCache->Write(0, Brn("http://example.com/stream"), Brn("metadata"));
+    Bws<4> uri;
+    TEST(!iCache->TryRead(0, uri, iMetaData));
+    Bws<4> metaData;
+    TEST(!iCache->TryRead(0, iUri, metaData));
+}
+
+void SuitePresetCache::TestPrefixesIndependent()
+{
+    PresetCache other(*iStore, Brn("Other.Preset."));
+    iCache->Write(0, Brn("uri"), Brn("metadata"));
+    TEST(!other.TryRead(0, iUri, iMetaData));
+    other.Write(0, Brn("uri2"), Brn("metadata2"));
+    TEST(iCache->TryRead(0, iUri, iMetaData));
+    TEST(iUri == Brn("uri"));
+}
+
+
+
+void TestPresetDatabase()
+{
+    Runner runner("PresetDatabase tests\n");
+    runner.Add(new SuitePresetDatabase());
+    runner.Add(new SuitePresetCache());
+    runner.Run();
+}
@@ -113,7 +113,8 @@ private:
 class SuiteRaopResend : public TestFramework::SuiteUnitTest, private INonCopyable
 {
 private:
-    static const TUint kMaxFrames = 5;
+    static const TUint kMaxFrames = 8;
+    static const TUint kMaxRanges = 2;
     static const TUint kMaxFrameBytes = 5;  // Only expect to store string vals 0..65535.
     static const TUint kMaxTestPipeMessages = 50;
 public:
@@ -129,9 +130,10 @@ private:
     void TestResendBeyondMultipleRangeLimit();
     void TestMultipleResendRecover();
     void TestResendRequest();
-    void TestResendPacketBufferOverflowFirst();
-    void TestResendPacketBufferOverflowMiddle();
-    void TestResendPacketBufferOverflowLast();
+    void TestResendPacketBufferFullFirst();
+    void TestResendPacketBufferFullMiddle();
+    void TestResendPacketBufferFullLast();
+    void TestResendArrivesWithBufferFull();
     void TestResendBufferOverflowRecover();
     void TestResendPacketsOutOfOrder();
     void TestDropPacketWhileAwaitingResend();
@@ -148,7 +150,24 @@ private:
     MockAudioSupply* iAudioSupply;
     MockRepairerTimer* iTimer;
     MockRepairableAllocator* iAllocator;
-    Repairer<kMaxFrames>* iRepairer;
+    Repairer<kMaxFrames, kMaxRanges>* iRepairer;
+};
+
+class SuiteRaopAudioDecryptor : public TestFramework::SuiteUnitTest, private INonCopyable
+{
+public:
+    SuiteRaopAudioDecryptor();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestDecryptBlocks();
+    void TestPartialBlockUnchanged();
+    void TestShortPayloadUnchanged();
+    void TestEachPacketRestartsFromIv();
+    void TestReinit();
+private:
+    RaopAudioDecryptor* iDecryptor;
 };
 
 } // namespace Av
@@ -395,9 +414,10 @@ SuiteRaopResend::SuiteRaopResend(Environment& aEnv)
     AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendBeyondMultipleRangeLimit), "TestResendBeyondMultipleRangeLimit");
     AddTest(MakeFunctor(*this, &SuiteRaopResend::TestMultipleResendRecover), "TestMultipleResendRecover");
     AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendRequest), "TestResendRequest");
-    AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendPacketBufferOverflowFirst), "TestResendPacketBufferOverflowFirst");
-    AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendPacketBufferOverflowMiddle), "TestResendPacketBufferOverflowMiddle");
-    AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendPacketBufferOverflowLast), "TestResendPacketBufferOverflowLast");
+    AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendPacketBufferFullFirst), "TestResendPacketBufferFullFirst");
+    AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendPacketBufferFullMiddle), "TestResendPacketBufferFullMiddle");
+    AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendPacketBufferFullLast), "TestResendPacketBufferFullLast");
+    AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendArrivesWithBufferFull), "TestResendArrivesWithBufferFull");
     AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendBufferOverflowRecover), "TestResendBufferOverflowRecover");
     AddTest(MakeFunctor(*this, &SuiteRaopResend::TestResendPacketsOutOfOrder), "TestResendPacketsOutOfOrder");
     AddTest(MakeFunctor(*this, &SuiteRaopResend::TestDropPacketWhileAwaitingResend), "TestDropPacketWhileAwaitingResend");
@@ -415,10 +435,10 @@ void SuiteRaopResend::Setup()
     iResendRequester = new MockResendRequester(*iTestPipe);
     iAudioSupply = new MockAudioSupply(*iTestPipe);
     iTimer = new MockRepairerTimer(*iTestPipe);
-    // Repair buffer stashes first discontinuity frame in a pointer, then proceeds to fill a buffer of kMaxFrameBytes.
-    // So, need kMaxFrames+2 to overflow repair buffer.
-    iAllocator = new MockRepairableAllocator(*iTestPipe, kMaxFrames+2, kMaxFrameBytes);
-    iRepairer = new Repairer<kMaxFrames>(iEnv, *iResendRequester, *iAudioSupply, *iTimer);
+    // Repair buffer holds up to kMaxFrames-1 frames, plus a frame from each of the audio and control channels.
+    // No margin, so that tests fail if the repairer ever holds more than this.
+    iAllocator = new MockRepairableAllocator(*iTestPipe, kMaxFrames+1, kMaxFrameBytes);
+    iRepairer = new Repairer<kMaxFrames, kMaxRanges>(iEnv, *iResendRequester, *iAudioSupply, *iTimer);
 }
 
 void SuiteRaopResend::TearDown()
@@ -567,7 +587,7 @@ void SuiteRaopResend::TestResendBeyondMultipleRangeLimit()
     // Miss another packet.
     iRepairer->OutputAudio(*iAllocator->Allocate(4, false, Brn("4")));
     // Miss another packet.
-    // Can only fit (at most) kMaxFrames/2 resend packet in repair buffer
+    // Can only request (at most) kMaxRanges ranges at a time
     // so packet 5 won't be in initial resend request.
     iRepairer->OutputAudio(*iAllocator->Allocate(6, false, Brn("6")));
 
@@ -730,9 +750,9 @@ void SuiteRaopResend::TestResendRequest()
     TEST(iTestPipe->ExpectEmpty());
 }
 
-void SuiteRaopResend::TestResendPacketBufferOverflowFirst()
+void SuiteRaopResend::TestResendPacketBufferFullFirst()
 {
-    // An initial resend packet arrives, but will cause buffer to overflow.
+    // Repair buffer is full when the first packet being waited on arrives.
     iRepairer->OutputAudio(*iAllocator->Allocate(0, false, Brn("0")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 0")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 0")));
@@ -747,29 +767,31 @@ void SuiteRaopResend::TestResendPacketBufferOverflowFirst()
     TEST(iTestPipe->Expect(Brn("MRT::Start")));
 
     // Fill buffer with packets.
-    iRepairer->OutputAudio(*iAllocator->Allocate(4, false, Brn("4")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(5, false, Brn("5")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(6, false, Brn("6")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(7, false, Brn("7")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(8, false, Brn("8")));
+    for (TUint i=4; i<=kMaxFrames; i++) {
+        Bws<kMaxFrameBytes> buf;
+        Ascii::AppendDec(buf, i);
+        iRepairer->OutputAudio(*iAllocator->Allocate(i, false, buf));
+    }
+    TEST(iTestPipe->ExpectEmpty());
 
-    // Receive the first packet being waited on. Should cause overflow.
-    TEST_THROWS(iRepairer->OutputAudio(*iAllocator->Allocate(2, true, Brn("2"))), RepairerBufferFull);
-    TEST(iTestPipe->Expect(Brn("MRT::Cancel")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 6")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 7")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 8")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
+    // Receive the second packet being waited on. Should still be accepted.
+    iRepairer->OutputAudio(*iAllocator->Allocate(2, true, Brn("2")));
+    TEST(iTestPipe->ExpectEmpty());
+
+    // Receive the first packet being waited on. Everything buffered should be output.
+    iRepairer->OutputAudio(*iAllocator->Allocate(1, true, Brn("1")));
+    for (TUint i=1; i<=kMaxFrames; i++) {
+        TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 "), i));
+        TEST(iTestPipe->Expect(Brn("MR::Destroy "), i));
+    }
 
     TEST(iTestPipe->ExpectEmpty());
 }
 
-void SuiteRaopResend::TestResendPacketBufferOverflowMiddle()
+void SuiteRaopResend::TestResendPacketBufferFullMiddle()
 {
-    // A resend request has arrived for somewhere in middle of repair buffer, but subsequent frames have already arrived and filled buffer.
+    // A resend has arrived for somewhere in middle of repair buffer, but subsequent frames have already arrived and filled buffer.
+    // The next frame can't fit so the gap at the start of the buffer is given up on.
 
     iRepairer->OutputAudio(*iAllocator->Allocate(0, false, Brn("0")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 0")));
@@ -794,28 +816,36 @@ void SuiteRaopResend::TestResendPacketBufferOverflowMiddle()
 
     // Now, send in some more packets to fill buffer.
     // So, have a packet missing at start and middle of repair buffer.
-    iRepairer->OutputAudio(*iAllocator->Allocate(5, false, Brn("5")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(6, false, Brn("6")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(7, false, Brn("7")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(8, false, Brn("8")));
+    for (TUint i=5; i<=kMaxFrames; i++) {
+        Bws<kMaxFrameBytes> buf;
+        Ascii::AppendDec(buf, i);
+        iRepairer->OutputAudio(*iAllocator->Allocate(i, false, buf));
+    }
 
     // Now, send in packet that was missing from middle of sequence (first packet still hasn't arrived).
-    TEST_THROWS(iRepairer->OutputAudio(*iAllocator->Allocate(3, true, Brn("3"))), RepairerBufferFull);
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
-    TEST(iTestPipe->Expect(Brn("MRT::Cancel")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 6")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 7")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 8")));
+    iRepairer->OutputAudio(*iAllocator->Allocate(3, true, Brn("3")));
+    TEST(iTestPipe->ExpectEmpty());
+
+    // Next packet doesn't fit. Packet 1 is given up on and everything buffered is output.
+    iRepairer->OutputAudio(*iAllocator->Allocate(kMaxFrames+1, false, Brn("9")));
+    for (TUint i=2; i<=kMaxFrames+1; i++) {
+        TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 "), i));
+        TEST(iTestPipe->Expect(Brn("MR::Destroy "), i));
+    }
+
+    // Repair is complete so timer firing has no effect.
+    iTimer->Fire();
+    // Late resend is discarded.
+    iRepairer->OutputAudio(*iAllocator->Allocate(1, true, Brn("1")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 1")));
 
     TEST(iTestPipe->ExpectEmpty());
 }
 
-void SuiteRaopResend::TestResendPacketBufferOverflowLast()
+void SuiteRaopResend::TestResendPacketBufferFullLast()
 {
-    // Packet is missed and packets are pushed in at end of repair buffer until buffer overflows.
+    // Packets are missed and packets are pushed in at end of repair buffer until it is full.
+    // Only the oldest gap should be given up on when another packet arrives.
 
     iRepairer->OutputAudio(*iAllocator->Allocate(0, false, Brn("0")));
     TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 0")));
@@ -830,22 +860,69 @@ void SuiteRaopResend::TestResendPacketBufferOverflowLast()
     TEST(iTestPipe->Expect(Brn("MRR::ReqestResend 1->1")));
     TEST(iTestPipe->Expect(Brn("MRT::Start")));
 
-    // Send in packets that should be appended to end of buffer until buffer overflows.
+    // Send in packets that should be appended to end of buffer until it is full (missing packet 5).
     iRepairer->OutputAudio(*iAllocator->Allocate(3, false, Brn("3")));
     iRepairer->OutputAudio(*iAllocator->Allocate(4, false, Brn("4")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(5, false, Brn("5")));
     iRepairer->OutputAudio(*iAllocator->Allocate(6, false, Brn("6")));
     iRepairer->OutputAudio(*iAllocator->Allocate(7, false, Brn("7")));
+    iRepairer->OutputAudio(*iAllocator->Allocate(8, false, Brn("8")));
+    TEST(iTestPipe->ExpectEmpty());
 
-    TEST_THROWS(iRepairer->OutputAudio(*iAllocator->Allocate(8, false, Brn("8"))), RepairerBufferFull);
-    TEST(iTestPipe->Expect(Brn("MRT::Cancel")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 6")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 7")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 8")));
+    // Packet 1 is given up on, packets up to the next gap are output and packet 9 is buffered.
+    iRepairer->OutputAudio(*iAllocator->Allocate(9, false, Brn("9")));
+    for (TUint i=2; i<=4; i++) {
+        TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 "), i));
+        TEST(iTestPipe->Expect(Brn("MR::Destroy "), i));
+    }
+    TEST(iTestPipe->ExpectEmpty());
+
+    // Repair of the remaining gap continues.
+    iTimer->Fire();
+    TEST(iTestPipe->Expect(Brn("MRR::ReqestResend 5->5")));
+    TEST(iTestPipe->Expect(Brn("MRT::Start")));
+    iRepairer->OutputAudio(*iAllocator->Allocate(5, true, Brn("5")));
+    for (TUint i=5; i<=9; i++) {
+        TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 "), i));
+        TEST(iTestPipe->Expect(Brn("MR::Destroy "), i));
+    }
+
+    TEST(iTestPipe->ExpectEmpty());
+}
+
+void SuiteRaopResend::TestResendArrivesWithBufferFull()
+{
+    // Repair buffer is as full as it can be when a resend and the next audio packet are both allocated.
+
+    iRepairer->OutputAudio(*iAllocator->Allocate(0, false, Brn("0")));
+    TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 0")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 0")));
+
+    // Miss a packet.
+    iRepairer->OutputAudio(*iAllocator->Allocate(2, false, Brn("2")));
+    TEST(iTestPipe->Expect(Brn("MRT::Start")));
+    iTimer->Fire();
+    TEST(iTestPipe->Expect(Brn("MRR::ReqestResend 1->1")));
+    TEST(iTestPipe->Expect(Brn("MRT::Start")));
+
+    // Fill buffer.
+    for (TUint i=3; i<=kMaxFrames; i++) {
+        Bws<Ascii::kMaxUintStringBytes> buf;
+        Ascii::AppendDec(buf, i);
+        iRepairer->OutputAudio(*iAllocator->Allocate(i, false, buf));
+    }
+    TEST(iTestPipe->ExpectEmpty());
+
+    // Resend arrives on the control channel while the audio channel has allocated the following packet.
+    IRepairable* resend = iAllocator->Allocate(1, true, Brn("1"));
+    IRepairable* audio = iAllocator->Allocate(kMaxFrames+1, false, Brn("9"));
+    iRepairer->OutputAudio(*resend);
+    for (TUint i=1; i<=kMaxFrames; i++) {
+        TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 "), i));
+        TEST(iTestPipe->Expect(Brn("MR::Destroy "), i));
+    }
+    iRepairer->OutputAudio(*audio);
+    TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 "), kMaxFrames+1));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy "), kMaxFrames+1));
 
     TEST(iTestPipe->ExpectEmpty());
 }
@@ -865,30 +942,26 @@ void SuiteRaopResend::TestResendBufferOverflowRecover()
     TEST(iTestPipe->Expect(Brn("MRR::ReqestResend 1->1")));
     TEST(iTestPipe->Expect(Brn("MRT::Start")));
 
-    // Send in packets that should be appended to end of buffer until buffer overflows.
-    iRepairer->OutputAudio(*iAllocator->Allocate(3, false, Brn("3")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(4, false, Brn("4")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(5, false, Brn("5")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(6, false, Brn("6")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(7, false, Brn("7")));
-
-    TEST_THROWS(iRepairer->OutputAudio(*iAllocator->Allocate(8, false, Brn("8"))), RepairerBufferFull);
+    // Send in a packet so far ahead that it wouldn't fit even if all gaps were given up on.
+    TEST_THROWS(iRepairer->OutputAudio(*iAllocator->Allocate(20, false, Brn("20"))), RepairerBufferFull);
     TEST(iTestPipe->Expect(Brn("MRT::Cancel")));
     TEST(iTestPipe->Expect(Brn("MR::Destroy 2")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 3")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 4")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 5")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 6")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 7")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 8")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 20")));
 
     // Now, continue packet sequence. Should be passed on as normal.
-    iRepairer->OutputAudio(*iAllocator->Allocate(9, false, Brn("9")));
-    TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 1 9")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 9")));
-    iRepairer->OutputAudio(*iAllocator->Allocate(10, false, Brn("10")));
-    TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 2 10")));
-    TEST(iTestPipe->Expect(Brn("MR::Destroy 10")));
+    iRepairer->OutputAudio(*iAllocator->Allocate(21, false, Brn("21")));
+    TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 2 21")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 21")));
+    iRepairer->OutputAudio(*iAllocator->Allocate(22, false, Brn("22")));
+    TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 2 22")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 22")));
+
+    // A jump that large without a repair in progress is also a restart.
+    TEST_THROWS(iRepairer->OutputAudio(*iAllocator->Allocate(40, false, Brn("40"))), RepairerBufferFull);
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 40")));
+    iRepairer->OutputAudio(*iAllocator->Allocate(41, false, Brn("41")));
+    TEST(iTestPipe->Expect(Brn("MAS::OutputAudio 2 41")));
+    TEST(iTestPipe->Expect(Brn("MR::Destroy 41")));
 
     TEST(iTestPipe->ExpectEmpty());
 }
@@ -1167,10 +1240,92 @@ void SuiteRaopResend::TestSequenceNumberWrappingDuringRepair()
 }
 
 
+// SuiteRaopAudioDecryptor
+
+// AES-128-CBC test vectors from NIST SP 800-38A, F.2.2
+static const TByte kAesKey[] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+static const TByte kAesIv[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+static const TByte kAesCipherText[] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2 };
+static const TByte kAesPlainText[] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51 };
+
+SuiteRaopAudioDecryptor::SuiteRaopAudioDecryptor()
+    : SuiteUnitTest("SuiteRaopAudioDecryptor")
+{
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestDecryptBlocks), "TestDecryptBlocks");
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestPartialBlockUnchanged), "TestPartialBlockUnchanged");
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestShortPayloadUnchanged), "TestShortPayloadUnchanged");
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestEachPacketRestartsFromIv), "TestEachPacketRestartsFromIv");
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestReinit), "TestReinit");
+}
+
+void SuiteRaopAudioDecryptor::Setup()
+{
+    iDecryptor = new RaopAudioDecryptor();
+    iDecryptor->Init(Brn(kAesKey, sizeof(kAesKey)), Brn(kAesIv, sizeof(kAesIv)));
+}
+
+void SuiteRaopAudioDecryptor::TearDown()
+{
+    delete iDecryptor;
+}
+
+void SuiteRaopAudioDecryptor::TestDecryptBlocks()
+{
+    Bws<64> buf(Brn(kAesCipherText, sizeof(kAesCipherText)));
+    iDecryptor->Decrypt(buf);
+    TEST(buf == Brn(kAesPlainText, sizeof(kAesPlainText)));
+}
+
+void SuiteRaopAudioDecryptor::TestPartialBlockUnchanged()
+{
+    // trailing bytes that don't fill a block are sent unencrypted
+    Bws<64> buf(Brn(kAesCipherText, sizeof(kAesCipherText)));
+    buf.Append(Brn("abcde"));
+    iDecryptor->Decrypt(buf);
+    TEST(buf.Bytes() == sizeof(kAesPlainText) + 5);
+    TEST(buf.Split(0, sizeof(kAesPlainText)) == Brn(kAesPlainText, sizeof(kAesPlainText)));
+    TEST(buf.Split(sizeof(kAesPlainText)) == Brn("abcde"));
+}
+
+void SuiteRaopAudioDecryptor::TestShortPayloadUnchanged()
+{
+    Bws<16> buf("0123456789");
+    iDecryptor->Decrypt(buf);
+    TEST(buf == Brn("0123456789"));
+}
+
+void SuiteRaopAudioDecryptor::TestEachPacketRestartsFromIv()
+{
+    // the second block on its own must not be chained from the first block of an earlier packet
+    Bws<64> buf(Brn(kAesCipherText, sizeof(kAesCipherText)));
+    iDecryptor->Decrypt(buf);
+    buf.Replace(Brn(kAesCipherText, sizeof(kAesCipherText)));
+    iDecryptor->Decrypt(buf);
+    TEST(buf == Brn(kAesPlainText, sizeof(kAesPlainText)));
+}
+
+void SuiteRaopAudioDecryptor::TestReinit()
+{
+    // a new session's IV applies to all later packets
+    Bws<RaopAudioDecryptor::kAesInitVectorBytes> iv(Brn(kAesCipherText, 16));
+    iDecryptor->Init(Brn(kAesKey, sizeof(kAesKey)), iv);
+    Bws<64> buf(Brn(kAesCipherText + 16, 16));
+    iDecryptor->Decrypt(buf);
+    TEST(buf == Brn(kAesPlainText + 16, 16));
+}
+
+
 
 void TestRaop(Environment& aEnv)
 {
     Runner runner("RAOP tests\n");
     runner.Add(new SuiteRaopResend(aEnv));
+    runner.Add(new SuiteRaopAudioDecryptor());
     runner.Run();
 }
@@ -0,0 +1,203 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Utils/ResendPacer.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteResendPacer : public SuiteUnitTest
+{
+    static const TUint64 kStartUs = 1000000;
+public:
+    SuiteResendPacer();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Sample(TUint aFrame, TUint aRttUs);
+    void TestDefaults();
+    void TestFirstSample();
+    void TestConvergence();
+    void TestRetriedRequestNotSampled();
+    void TestUnrequestedFrameNotSampled();
+    void TestTimeoutClamped();
+    void TestHeardSuppresses();
+    void TestHeardExpires();
+    void TestHeardOverwritten();
+    void TestReset();
+private:
+    ResendPacer* iPacer;
+    TUint64 iNowUs;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteResendPacer
+
+SuiteResendPacer::SuiteResendPacer()
+    : SuiteUnitTest("SuiteResendPacer")
+{
+    AddTest(MakeFunctor(*this, &SuiteResendPacer::TestDefaults), "TestDefaults");
+    AddTest(MakeFunctor(*this, &SuiteResendPacer::TestFirstSample), "TestFirstSample");
+    AddTest(MakeFunctor(*this, &SuiteResendPacer::TestConvergence), "TestConvergence");
+    AddTest(MakeFunctor(*this, &SuiteResendPacer::TestRetriedRequestNotSampled), "TestRetriedRequestNotSampled");
+    AddTest(MakeFunctor(*this, &SuiteResendPacer::TestUnrequestedFrameNotSampled), "TestUnrequestedFrameNotSampled");
+    AddTest(MakeFunctor(*this, &SuiteResendPacer::TestTimeoutClamped), "TestTimeoutClamped");
+    AddTest(MakeFunctor(*this, &SuiteResendPacer::TestHeardSuppresses), "TestHeardSuppresses");
+    AddTest(MakeFunctor(*this, &SuiteResendPacer::TestHeardExpires), "TestHeardExpires");
+    AddTest(MakeFunctor(*this, &SuiteResendPacer::TestHeardOverwritten), "TestHeardOverwritten");
+    AddTest(MakeFunctor(*this, &SuiteResendPacer::TestReset), "TestReset");
+}
+
+void SuiteResendPacer::Setup()
+{
+    iPacer = new ResendPacer();
+    iNowUs = kStartUs;
+}
+
+void SuiteResendPacer::TearDown()
+{
+    delete iPacer;
+}
+
+void SuiteResendPacer::Sample(TUint aFrame, TUint aRttUs)
+{
+    iPacer->NotifyRequested(aFrame, iNowUs);
+    iNowUs += aRttUs;
+    iPacer->NotifyResent(aFrame, iNowUs);
+}
+
+void SuiteResendPacer::TestDefaults()
+{
+    TEST(!iPacer->RttValid());
+    TEST(iPacer->TimeoutMs() == ResendPacer::kDefaultTimeoutMs);
+    TEST(iPacer->InitialTimeoutMs() == ResendPacer::kMinInitialTimeoutMs);
+    TEST(!iPacer->RecentlyRequested(1, iNowUs));
+}
+
+void SuiteResendPacer::TestFirstSample()
+{
+    Sample(100, 4000);
+    TEST(iPacer->RttValid());
+    TEST(iPacer->RttUs() == 4000);
+    // srtt + 4 * (srtt / 2)
+    TEST(iPacer->TimeoutMs() == 12);
+    TEST(iPacer->InitialTimeoutMs() == ResendPacer::kMinInitialTimeoutMs);
+}
+
+void SuiteResendPacer::TestConvergence()
+{
+    Sample(1, 40000);
+    for (TUint i=2; i<100; i++) {
+        Sample(i, 2000);
+    }
+    TEST(iPacer->RttUs() >= 2000 && iPacer->RttUs() < 2100);
+    TEST(iPacer->TimeoutMs() == ResendPacer::kMinTimeoutMs);
+
+    for (TUint i=100; i<200; i++) {
+        Sample(i, 60000);
+    }
+    TEST(iPacer->RttUs() > 59000 && iPacer->RttUs() <= 60000);
+    TEST(iPacer->TimeoutMs() >= 60 && iPacer->TimeoutMs() < 70);
+    TEST(iPacer->InitialTimeoutMs() == 60);
+}
+
+void SuiteResendPacer::TestRetriedRequestNotSampled()
+{
+    iPacer->NotifyRequested(10, iNowUs);
+    iNowUs += 30000;
+    iPacer->NotifyRequested(10, iNowUs);
+    iNowUs += 1000;
+    iPacer->NotifyResent(10, iNowUs);
+    TEST(!iPacer->RttValid());
+
+    // a later, unambiguous, request is sampled
+    Sample(11, 3000);
+    TEST(iPacer->RttValid());
+    TEST(iPacer->RttUs() == 3000);
+}
+
+void SuiteResendPacer::TestUnrequestedFrameNotSampled()
+{
+    iPacer->NotifyRequested(10, iNowUs);
+    iNowUs += 5000;
+    iPacer->NotifyResent(9, iNowUs);
+    TEST(!iPacer->RttValid());
+    iPacer->NotifyResent(10, iNowUs);
+    TEST(iPacer->RttValid());
+    // only the first copy of a resent frame is a sample
+    iNowUs += 50000;
+    iPacer->NotifyResent(10, iNowUs);
+    TEST(iPacer->RttUs() == 5000);
+}
+
+void SuiteResendPacer::TestTimeoutClamped()
+{
+    Sample(1, 100);
+    TEST(iPacer->TimeoutMs() == ResendPacer::kMinTimeoutMs);
+    iPacer->Reset();
+    Sample(1, 5000000);
+    TEST(iPacer->TimeoutMs() == ResendPacer::kMaxTimeoutMs);
+    TEST(iPacer->InitialTimeoutMs() == ResendPacer::kMaxTimeoutMs);
+}
+
+void SuiteResendPacer::TestHeardSuppresses()
+{
+    iPacer->NotifyHeard(20, iNowUs);
+    iPacer->NotifyHeard(22, iNowUs);
+    TEST(iPacer->RecentlyRequested(20, iNowUs));
+    TEST(!iPacer->RecentlyRequested(21, iNowUs));
+    TEST(iPacer->RecentlyRequested(22, iNowUs + 1000));
+}
+
+void SuiteResendPacer::TestHeardExpires()
+{
+    iPacer->NotifyHeard(20, iNowUs);
+    const TUint64 timeoutUs = (TUint64)ResendPacer::kDefaultTimeoutMs * 1000;
+    TEST(iPacer->RecentlyRequested(20, iNowUs + timeoutUs - 1));
+    TEST(!iPacer->RecentlyRequested(20, iNowUs + timeoutUs));
+
+    // the suppression window follows the measured rtt
+    Sample(1, 2000);
+    iPacer->NotifyHeard(30, iNowUs);
+    const TUint64 shortTimeoutUs = (TUint64)iPacer->TimeoutMs() * 1000;
+    TEST(shortTimeoutUs < timeoutUs);
+    TEST(!iPacer->RecentlyRequested(30, iNowUs + shortTimeoutUs));
+}
+
+void SuiteResendPacer::TestHeardOverwritten()
+{
+    for (TUint i=0; i<ResendPacer::kMaxHeardFrames; i++) {
+        iPacer->NotifyHeard(i, iNowUs);
+    }
+    TEST(iPacer->RecentlyRequested(0, iNowUs));
+    iPacer->NotifyHeard(1000, iNowUs);
+    TEST(!iPacer->RecentlyRequested(0, iNowUs));
+    TEST(iPacer->RecentlyRequested(1, iNowUs));
+    TEST(iPacer->RecentlyRequested(1000, iNowUs));
+}
+
+void SuiteResendPacer::TestReset()
+{
+    Sample(1, 8000);
+    iPacer->NotifyHeard(5, iNowUs);
+    iPacer->Reset();
+    TEST(!iPacer->RttValid());
+    TEST(iPacer->TimeoutMs() == ResendPacer::kDefaultTimeoutMs);
+    TEST(!iPacer->RecentlyRequested(5, iNowUs));
+}
+
+
+
+void TestResendPacer()
+{
+    Runner runner("ResendPacer tests\n");
+    runner.Add(new SuiteResendPacer());
+    runner.Run();
+}
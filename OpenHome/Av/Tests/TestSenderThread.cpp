@@ -0,0 +1,214 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Songcast/SenderThread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Functor.h>
+
+#include <atomic>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteSenderThread : public SuiteUnitTest
+                        , private IPipelineElementDownstream
+                        , private IMsgProcessor
+                        , private INonCopyable
+{
+public:
+    SuiteSenderThread();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgTrack* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgDelay* aMsg) override;
+    Msg* ProcessMsg(MsgEncodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+    Msg* ProcessMsg(MsgMetaText* aMsg) override;
+    Msg* ProcessMsg(MsgStreamInterrupted* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgFlush* aMsg) override;
+    Msg* ProcessMsg(MsgWait* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgBitRate* aMsg) override;
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+    Msg* ProcessMsg(MsgSilence* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private:
+    void PushSilence(TUint aCount);
+    void Release(TUint aCount); // let aCount blocked msgs through, waiting until the next is blocked
+    void PushHalt();
+    void TestAudioDroppedUntilHalfDrained();
+    void TestNonAudioWaitsForSpace();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    SenderThread* iSenderThread;
+    Semaphore iSemReceived;
+    Semaphore iSemRelease;
+    Semaphore iSemHaltPushed;
+    std::atomic<TBool> iBlock;
+    std::atomic<TBool> iHaltPushed;
+    std::atomic<TUint> iAudioReceived;
+    std::atomic<TUint> iHaltsReceived;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteSenderThread
+
+SuiteSenderThread::SuiteSenderThread()
+    : SuiteUnitTest("SenderThread")
+    , iSemReceived("STRC", 0)
+    , iSemRelease("STRL", 0)
+    , iSemHaltPushed("STHP", 0)
+{
+    AddTest(MakeFunctor(*this, &SuiteSenderThread::TestAudioDroppedUntilHalfDrained), "TestAudioDroppedUntilHalfDrained");
+    AddTest(MakeFunctor(*this, &SuiteSenderThread::TestNonAudioWaitsForSpace), "TestNonAudioWaitsForSpace");
+}
+
+void SuiteSenderThread::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgSilenceCount(2 * SenderThread::kMaxMsgBacklog);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iBlock = true;
+    iHaltPushed = false;
+    iAudioReceived = 0;
+    iHaltsReceived = 0;
+    (void)iSemReceived.Clear();
+    (void)iSemRelease.Clear();
+    (void)iSemHaltPushed.Clear();
+    iSenderThread = new SenderThread(*this, kPriorityNormal);
+
+    // park the sender thread in our Push() so that msgs back up behind it
+    PushSilence(1);
+    iSemReceived.Wait();
+}
+
+void SuiteSenderThread::TearDown()
+{
+    iBlock = false;
+    iSemRelease.Signal();
+    iSenderThread->Push(iMsgFactory->CreateMsgQuit());
+    delete iSenderThread;
+    delete iMsgFactory;
+}
+
+void SuiteSenderThread::Push(Msg* aMsg)
+{
+    aMsg = aMsg->Process(*this);
+    aMsg->RemoveRef();
+    if (iBlock) {
+        iSemReceived.Signal();
+        iSemRelease.Wait();
+    }
+}
+
+Msg* SuiteSenderThread::ProcessMsg(MsgMode* aMsg)              { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgTrack* aMsg)             { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgDrain* aMsg)             { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgDelay* aMsg)             { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgEncodedStream* aMsg)     { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgAudioEncoded* aMsg)      { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgMetaText* aMsg)          { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgStreamInterrupted* aMsg) { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgHalt* aMsg)              { iHaltsReceived++; return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgFlush* aMsg)             { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgWait* aMsg)              { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgDecodedStream* aMsg)     { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgBitRate* aMsg)           { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgAudioPcm* aMsg)          { iAudioReceived++; return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgSilence* aMsg)           { iAudioReceived++; return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgPlayable* aMsg)          { return aMsg; }
+Msg* SuiteSenderThread::ProcessMsg(MsgQuit* aMsg)              { return aMsg; }
+
+void SuiteSenderThread::PushSilence(TUint aCount)
+{
+    for (TUint i=0; i<aCount; i++) {
+        TUint size = Jiffies::kPerMs;
+        iSenderThread->Push(iMsgFactory->CreateMsgSilence(size, 44100, 16, 2));
+    }
+}
+
+void SuiteSenderThread::Release(TUint aCount)
+{
+    for (TUint i=0; i<aCount; i++) {
+        iSemRelease.Signal();
+        iSemReceived.Wait();
+    }
+}
+
+void SuiteSenderThread::PushHalt()
+{
+    iSenderThread->Push(iMsgFactory->CreateMsgHalt());
+    iHaltPushed = true;
+    iSemHaltPushed.Signal();
+}
+
+void SuiteSenderThread::TestAudioDroppedUntilHalfDrained()
+{
+    const TUint backlog = SenderThread::kMaxMsgBacklog;
+    PushSilence(backlog);       // fills the backlog
+    PushSilence(5);             // dropped
+    Release(backlog / 2 - 1);   // backlog now one over half full
+    PushSilence(1);             // still dropped, despite there being space
+    Release(1);                 // backlog half full
+    PushSilence(1);             // queued
+    iBlock = false;
+    iSemRelease.Signal();
+    iSenderThread->Push(iMsgFactory->CreateMsgHalt());
+    // wait for the halt to prove everything queued ahead of it has been passed on
+    while (iHaltsReceived == 0) {
+        Thread::Sleep(10);
+    }
+    TEST(iAudioReceived == 1 + backlog + 1);
+}
+
+void SuiteSenderThread::TestNonAudioWaitsForSpace()
+{
+    const TUint backlog = SenderThread::kMaxMsgBacklog;
+    PushSilence(backlog);
+    ThreadFunctor* pusher = new ThreadFunctor("TestSenderThreadHalt", MakeFunctor(*this, &SuiteSenderThread::PushHalt));
+    pusher->Start();
+    try {
+        iSemHaltPushed.Wait(100);
+    }
+    catch (Timeout&) {
+    }
+    TEST(!iHaltPushed);         // blocked rather than dropped
+    Release(1);                 // sender thread takes one msg, making space
+    iSemHaltPushed.Wait();
+    TEST(iHaltPushed);
+    delete pusher;
+
+    iBlock = false;
+    iSemRelease.Signal();
+    while (iHaltsReceived == 0) {
+        Thread::Sleep(10);
+    }
+    TEST(iAudioReceived == 1 + backlog);
+}
+
+
+
+void TestSenderThread()
+{
+    Runner runner("SenderThread tests\n");
+    runner.Add(new SuiteSenderThread());
+    runner.Run();
+}
@@ -0,0 +1,259 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Utils/SequenceRepairBuffer.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteSequenceRepairBuffer : public SuiteUnitTest
+{
+    static const TUint kCapacity = 8;
+    typedef SequenceRepairBuffer<TUint, kCapacity, 16> Buffer;
+public:
+    SuiteSequenceRepairBuffer();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    Buffer::EInsert Insert(TUint aSeq);
+    TBool PopExpect(TUint aSeq);
+    void TestDiff();
+    void TestInOrder();
+    void TestReorder();
+    void TestDuplicateAndLate();
+    void TestTooFar();
+    void TestSkipGap();
+    void TestFindMissing();
+    void TestContains();
+    void TestWrap();
+    void TestDiff32();
+private:
+    Buffer* iBuffer;
+    TUint iItems[1 << 16];
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteSequenceRepairBuffer
+
+SuiteSequenceRepairBuffer::SuiteSequenceRepairBuffer()
+    : SuiteUnitTest("SuiteSequenceRepairBuffer")
+{
+    AddTest(MakeFunctor(*this, &SuiteSequenceRepairBuffer::TestDiff), "TestDiff");
+    AddTest(MakeFunctor(*this, &SuiteSequenceRepairBuffer::TestInOrder), "TestInOrder");
+    AddTest(MakeFunctor(*this, &SuiteSequenceRepairBuffer::TestReorder), "TestReorder");
+    AddTest(MakeFunctor(*this, &SuiteSequenceRepairBuffer::TestDuplicateAndLate), "TestDuplicateAndLate");
+    AddTest(MakeFunctor(*this, &SuiteSequenceRepairBuffer::TestTooFar), "TestTooFar");
+    AddTest(MakeFunctor(*this, &SuiteSequenceRepairBuffer::TestSkipGap), "TestSkipGap");
+    AddTest(MakeFunctor(*this, &SuiteSequenceRepairBuffer::TestFindMissing), "TestFindMissing");
+    AddTest(MakeFunctor(*this, &SuiteSequenceRepairBuffer::TestContains), "TestContains");
+    AddTest(MakeFunctor(*this, &SuiteSequenceRepairBuffer::TestWrap), "TestWrap");
+    AddTest(MakeFunctor(*this, &SuiteSequenceRepairBuffer::TestDiff32), "TestDiff32");
+}
+
+void SuiteSequenceRepairBuffer::Setup()
+{
+    iBuffer = new Buffer();
+    for (TUint i=0; i<(1 << 16); i++) {
+        iItems[i] = i;
+    }
+    iBuffer->SetLast(0);
+}
+
+void SuiteSequenceRepairBuffer::TearDown()
+{
+    delete iBuffer;
+}
+
+SuiteSequenceRepairBuffer::Buffer::EInsert SuiteSequenceRepairBuffer::Insert(TUint aSeq)
+{
+    return iBuffer->Insert(iItems[aSeq], aSeq);
+}
+
+TBool SuiteSequenceRepairBuffer::PopExpect(TUint aSeq)
+{
+    TUint* item = iBuffer->Pop();
+    return item != nullptr && *item == aSeq && iBuffer->Last() == aSeq;
+}
+
+void SuiteSequenceRepairBuffer::TestDiff()
+{
+    TEST(Buffer::Diff(5, 3) == 2);
+    TEST(Buffer::Diff(3, 5) == -2);
+    TEST(Buffer::Diff(0, 65535) == 1);
+    TEST(Buffer::Diff(65535, 0) == -1);
+    TEST(Buffer::Diff(32767, 0) == 32767);
+    TEST(Buffer::Diff(32768, 0) == -32768);
+    // bits above SeqBits are ignored
+    TEST(Buffer::Diff(0x10002, 1) == 1);
+}
+
+void SuiteSequenceRepairBuffer::TestInOrder()
+{
+    TEST(iBuffer->Empty());
+    TEST(iBuffer->Pop() == nullptr);
+    for (TUint i=1; i<20; i++) {
+        TEST(Insert(i) == Buffer::eStored);
+        TEST(iBuffer->Count() == 1);
+        TEST(PopExpect(i));
+        TEST(iBuffer->Empty());
+    }
+    TEST(iBuffer->Next() == 20);
+}
+
+void SuiteSequenceRepairBuffer::TestReorder()
+{
+    TEST(Insert(3) == Buffer::eStored);
+    TEST(Insert(5) == Buffer::eStored);
+    TEST(iBuffer->Newest() == 5);
+    TEST(iBuffer->Pop() == nullptr);
+    TEST(Insert(2) == Buffer::eStored);
+    TEST(Insert(4) == Buffer::eStored);
+    TEST(iBuffer->Newest() == 5);
+    TEST(iBuffer->Count() == 4);
+    TEST(iBuffer->Pop() == nullptr);
+    TEST(Insert(1) == Buffer::eStored);
+    for (TUint i=1; i<=5; i++) {
+        TEST(PopExpect(i));
+    }
+    TEST(iBuffer->Pop() == nullptr);
+    TEST(iBuffer->Empty());
+    TEST(iBuffer->Newest() == 5);
+}
+
+void SuiteSequenceRepairBuffer::TestDuplicateAndLate()
+{
+    TEST(Insert(0) == Buffer::eLate);
+    TEST(Insert(65535) == Buffer::eLate);
+    TEST(Insert(3) == Buffer::eStored);
+    TEST(Insert(3) == Buffer::eDuplicate);
+    TEST(iBuffer->Count() == 1);
+    TEST(Insert(1) == Buffer::eStored);
+    TEST(PopExpect(1));
+    TEST(Insert(1) == Buffer::eLate);
+}
+
+void SuiteSequenceRepairBuffer::TestTooFar()
+{
+    TEST(Insert(kCapacity) == Buffer::eStored);
+    TEST(Insert(kCapacity + 1) == Buffer::eTooFar);
+    TEST(iBuffer->Count() == 1);
+    TEST(iBuffer->Newest() == kCapacity);
+    // once earlier frames are output, later ones fit
+    TEST(Insert(1) == Buffer::eStored);
+    TEST(PopExpect(1));
+    TEST(Insert(kCapacity + 1) == Buffer::eStored);
+}
+
+void SuiteSequenceRepairBuffer::TestSkipGap()
+{
+    TEST(iBuffer->SkipGap() == 0);
+    TEST(iBuffer->Last() == 0);
+    TEST(Insert(4) == Buffer::eStored);
+    TEST(Insert(5) == Buffer::eStored);
+    TEST(Insert(7) == Buffer::eStored);
+    TEST(iBuffer->SkipGap() == 3);
+    TEST(iBuffer->Last() == 3);
+    TEST(iBuffer->SkipGap() == 0);
+    TEST(PopExpect(4));
+    TEST(PopExpect(5));
+    TEST(iBuffer->Pop() == nullptr);
+    TEST(iBuffer->SkipGap() == 1);
+    TEST(PopExpect(7));
+    TEST(iBuffer->Empty());
+}
+
+void SuiteSequenceRepairBuffer::TestFindMissing()
+{
+    TUint start = 0;
+    TUint end = 0;
+    TEST(!iBuffer->FindMissing(iBuffer->Next(), start, end));
+    TEST(Insert(3) == Buffer::eStored);
+    TEST(Insert(4) == Buffer::eStored);
+    TEST(Insert(6) == Buffer::eStored);
+    TEST(Insert(8) == Buffer::eStored);
+
+    TEST(iBuffer->FindMissing(iBuffer->Next(), start, end));
+    TEST(start == 1 && end == 2);
+    TEST(iBuffer->FindMissing(end + 1, start, end));
+    TEST(start == 5 && end == 5);
+    TEST(iBuffer->FindMissing(end + 1, start, end));
+    TEST(start == 7 && end == 7);
+    TEST(!iBuffer->FindMissing(end + 1, start, end));
+
+    // searches start no earlier than the next frame due
+    TEST(iBuffer->FindMissing(0, start, end));
+    TEST(start == 1 && end == 2);
+    // ...and may start part way through a gap
+    TEST(iBuffer->FindMissing(2, start, end));
+    TEST(start == 2 && end == 2);
+}
+
+void SuiteSequenceRepairBuffer::TestContains()
+{
+    TEST(!iBuffer->Contains(1));
+    TEST(Insert(2) == Buffer::eStored);
+    TEST(!iBuffer->Contains(1));
+    TEST(iBuffer->Contains(2));
+    TEST(!iBuffer->Contains(2 + kCapacity)); // shares a slot with 2 but is outside the window
+    TEST(!iBuffer->Contains(0));
+}
+
+void SuiteSequenceRepairBuffer::TestWrap()
+{
+    iBuffer->SetLast(65533);
+    TEST(Insert(65535) == Buffer::eStored);
+    TEST(Insert(1) == Buffer::eStored);
+    TEST(iBuffer->Newest() == 1);
+    TUint start = 0;
+    TUint end = 0;
+    TEST(iBuffer->FindMissing(iBuffer->Next(), start, end));
+    TEST(start == 65534 && end == 65534);
+    TEST(iBuffer->FindMissing(end + 1, start, end));
+    TEST(start == 0 && end == 0);
+    TEST(!iBuffer->FindMissing(end + 1, start, end));
+
+    TEST(Insert(0) == Buffer::eStored);
+    TEST(Insert(65534) == Buffer::eStored);
+    TEST(PopExpect(65534));
+    TEST(PopExpect(65535));
+    TEST(PopExpect(0));
+    TEST(PopExpect(1));
+    TEST(iBuffer->Empty());
+}
+
+void SuiteSequenceRepairBuffer::TestDiff32()
+{
+    typedef SequenceRepairBuffer<TUint, 256, 32> Buffer32;
+    TEST(Buffer32::Diff(5, 3) == 2);
+    TEST(Buffer32::Diff(3, 5) == -2);
+    TEST(Buffer32::Diff(0, 0xffffffff) == 1);
+    TEST(Buffer32::Diff(0xffffffff, 0) == -1);
+
+    Buffer32 buffer;
+    buffer.SetLast(0xfffffffe);
+    TUint item = 0;
+    TEST(buffer.Insert(item, 1) == Buffer32::eStored);
+    TUint start = 0;
+    TUint end = 0;
+    TEST(buffer.FindMissing(buffer.Next(), start, end));
+    TEST(start == 0xffffffff && end == 0);
+    TEST(buffer.Pop() == nullptr);
+    TEST(buffer.SkipGap() == 2);
+    TEST(buffer.Pop() == &item);
+}
+
+
+
+void TestSequenceRepairBuffer()
+{
+    Runner runner("SequenceRepairBuffer tests\n");
+    runner.Add(new SuiteSequenceRepairBuffer());
+    runner.Run();
+}
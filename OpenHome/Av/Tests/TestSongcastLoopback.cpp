@@ -0,0 +1,880 @@
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Optional.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Converter.h>
+#include <OpenHome/Private/Uri.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Functor.h>
+#include <OpenHome/Net/Core/DvDevice.h>
+#include <OpenHome/Net/Private/DviStack.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Av/Songcast/OhmSender.h>
+#include <OpenHome/Av/Songcast/OhmMsg.h>
+#include <OpenHome/Av/Songcast/ProtocolOhu.h>
+#include <OpenHome/Av/Songcast/ZoneHandler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <vector>
+#include <time.h>
+
+/*
+ * Manual benchmark for Songcast under load and packet loss.
+ *
+ * An OhmSender and a number of in-process ProtocolOhu receivers are run over the loopback
+ * interface.  Each receiver talks to the sender via its own UDP relay which drops, reorders
+ * and delays packets in both directions.  Each audio frame carries its sequence number and
+ * send time so that receivers can measure end-to-end latency and detect frames that were lost
+ * for good or arrived too late to be played.
+ *
+ * Runs entirely offline; no other Songcast devices are involved.
+ */
+
+namespace OpenHome {
+namespace Av {
+
+class LoopbackImpairment
+{
+public:
+    LoopbackImpairment(TUint aLossPercent, TUint aReorderPercent, TUint aDelayMs, TUint aJitterMs);
+public:
+    const TUint iLossPercent;
+    const TUint iReorderPercent;
+    const TUint iDelayMs;
+    const TUint iJitterMs;
+};
+
+class LoopbackRelay : private INonCopyable
+{
+    static const TUint kMaxPacketBytes = 8 * 1024;
+    static const TUint kMaxPendingPackets = 256;
+    static const TUint kReorderHoldMs = 15; // 3 frames
+public:
+    LoopbackRelay(Environment& aEnv, TIpAddress aInterface, const Endpoint& aSender,
+                  const LoopbackImpairment& aImpairment, TUint aSeed);
+    ~LoopbackRelay();
+    void AppendUri(Bwx& aUri);
+    TUint PacketsForwarded() const;
+    TUint PacketsDropped() const;
+    TUint PacketsReordered() const;
+private:
+    class Packet
+    {
+    public:
+        TBool iToReceiver;
+        Bws<kMaxPacketBytes> iData;
+    };
+private:
+    void ReceiverSideRun();
+    void NetworkSideRun();
+    void DeliveryRun();
+    void Schedule(const Brx& aData, TBool aToReceiver);
+    TUint NextRandom();
+private:
+    Environment& iEnv;
+    const LoopbackImpairment& iImpairment;
+    const TIpAddress iInterface;
+    const Endpoint iSender;
+    SocketUdp iSocketReceiver; // faces the receiver; its endpoint is the receiver's ohu uri
+    SocketUdp iSocketNetwork;  // faces the sender (and any master receiver forwarding audio)
+    Bws<kMaxPacketBytes> iBufReceiverSide;
+    Bws<kMaxPacketBytes> iBufNetworkSide;
+    Mutex iLock;
+    Semaphore iSemPending;
+    Endpoint iReceiver;
+    TBool iReceiverKnown;
+    TUint iRandom;
+    std::vector<Packet*> iFree;
+    std::multimap<TUint64, Packet*> iPending; // keyed by delivery time (us)
+    TUint iForwarded;
+    TUint iDropped;
+    TUint iReordered;
+    std::atomic<TBool> iQuit;
+    ThreadFunctor* iThreadReceiverSide;
+    ThreadFunctor* iThreadNetworkSide;
+    ThreadFunctor* iThreadDelivery;
+};
+
+class LoopbackSink : public Media::IPipelineElementDownstream, private Media::PipelineElement
+{
+    static const TUint kSupportedMsgTypes;
+    static const TUint kMaxHistogramMs = 1000;
+public:
+    static const TUint kMagic = 0x4c4f4f50; // "LOOP"
+    static const TUint kHeaderBytes = 16;   // magic, sequence number, send time (us)
+public:
+    LoopbackSink(Environment& aEnv, TUint aLatencyMs);
+    void Report(TUint aIndex, TUint64 aCpuUs, TUint64 aElapsedUs) const;
+private: // from IPipelineElementDownstream
+    void Push(Media::Msg* aMsg) override;
+private: // from PipelineElement
+    Media::Msg* ProcessMsg(Media::MsgDrain* aMsg) override;
+    Media::Msg* ProcessMsg(Media::MsgEncodedStream* aMsg) override;
+    Media::Msg* ProcessMsg(Media::MsgAudioEncoded* aMsg) override;
+    Media::Msg* ProcessMsg(Media::MsgStreamInterrupted* aMsg) override;
+    Media::Msg* ProcessMsg(Media::MsgHalt* aMsg) override;
+private:
+    void Dropout();
+private:
+    Environment& iEnv;
+    const TUint64 iDeadlineUs;
+    TByte iAudio[Media::EncodedAudio::kMaxBytes];
+    TBool iSeqValid;
+    TUint iNextSeq;
+    TUint iFrames;
+    TUint iMissing;
+    TUint iLate;
+    TUint iStarvationEvents;
+    TBool iInDropout;
+    TUint iStreams;
+    TUint iInterruptions;
+    TUint64 iLatencyTotalUs;
+    TUint64 iLatencyMaxUs;
+    std::vector<TUint> iLatencyHistogram; // 1ms buckets
+};
+
+class LoopbackReceiver : private Media::IPipelineIdProvider, private Media::IFlushIdProvider,
+                         private IInfoAggregator, private IWriter, private INonCopyable
+{
+public:
+    LoopbackReceiver(Environment& aEnv, const Brx& aUri, TUint aLatencyMs, TUint aIndex);
+    ~LoopbackReceiver();
+    void Start();
+    void Stop();
+    void Report(TUint64 aElapsedUs);
+private:
+    void Run();
+    static TUint64 ThreadCpuUs();
+private: // from Media::IPipelineIdProvider
+    TUint NextStreamId() override;
+    Media::EStreamPlay OkToPlay(TUint aStreamId) override;
+private: // from Media::IFlushIdProvider
+    TUint NextFlushId() override;
+private: // from IInfoAggregator
+    void Register(IInfoProvider& aProvider, std::vector<Brn>& aSupportedQueries) override;
+private: // from IWriter
+    void Write(TByte aValue) override;
+    void Write(const Brx& aBuffer) override;
+    void WriteFlush() override;
+private:
+    const TUint iIndex;
+    Bws<64> iUri;
+    TUint iNextStreamId;
+    TUint iNextFlushId;
+    IInfoProvider* iProtocolInfo;
+    LoopbackSink iSink;
+    Media::MsgFactory* iMsgFactory;
+    Media::TrackFactory* iTrackFactory;
+    OhmMsgFactory iOhmMsgFactory;
+    Media::ProtocolManager* iProtocolManager;
+    std::atomic<TBool> iQuit;
+    Semaphore iSemStopped;
+    TUint64 iCpuUs;
+    ThreadFunctor* iThread;
+};
+
+class SongcastLoopbackBench : private INonCopyable
+{
+    static const TUint kSampleRate = 48000;
+    static const TUint kChannels = 2;
+    static const TUint kBitDepth = 16;
+    static const TUint kFrameMs = 5;
+    static const TUint kFrameBytes = (kSampleRate / 1000) * kFrameMs * kChannels * (kBitDepth / 8);
+    static const TUint kSenderStartTimeoutMs = 5000;
+public:
+    SongcastLoopbackBench(Environment& aEnv, Net::DvStack& aDvStack, TUint aLatencyMs);
+    ~SongcastLoopbackBench();
+    void Run(TUint aReceivers, const LoopbackImpairment& aImpairment, TUint aSeed, TUint aDurationSecs);
+private:
+    void FeederRun();
+    void DeviceDisabled();
+private:
+    Environment& iEnv;
+    const TUint iLatencyMs;
+    Net::DvDeviceStandard* iDevice;
+    ZoneHandler* iZoneHandler;
+    OhmSenderDriver* iDriver;
+    OhmSender* iSender;
+    Semaphore iSemDeviceDisabled;
+    Bws<kFrameBytes> iFrame;
+    std::atomic<TBool> iFeederQuit;
+    TUint iFramesSent;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+using namespace OpenHome::Media;
+
+
+// LoopbackImpairment
+
+LoopbackImpairment::LoopbackImpairment(TUint aLossPercent, TUint aReorderPercent, TUint aDelayMs, TUint aJitterMs)
+    : iLossPercent(aLossPercent)
+    , iReorderPercent(aReorderPercent)
+    , iDelayMs(aDelayMs)
+    , iJitterMs(aJitterMs)
+{
+}
+
+
+// LoopbackRelay
+
+LoopbackRelay::LoopbackRelay(Environment& aEnv, TIpAddress aInterface, const Endpoint& aSender,
+                             const LoopbackImpairment& aImpairment, TUint aSeed)
+    : iEnv(aEnv)
+    , iImpairment(aImpairment)
+    , iInterface(aInterface)
+    , iSender(aSender)
+    , iSocketReceiver(aEnv, 0, aInterface)
+    , iSocketNetwork(aEnv, 0, aInterface)
+    , iLock("LRLY")
+    , iSemPending("LRLY", 0)
+    , iReceiverKnown(false)
+    , iRandom(aSeed)
+    , iForwarded(0)
+    , iDropped(0)
+    , iReordered(0)
+    , iQuit(false)
+{
+    for (TUint i=0; i<kMaxPendingPackets; i++) {
+        iFree.push_back(new Packet());
+    }
+    iThreadReceiverSide = new ThreadFunctor("LoopbackRelayRx", MakeFunctor(*this, &LoopbackRelay::ReceiverSideRun), kPriorityHigh);
+    iThreadNetworkSide = new ThreadFunctor("LoopbackRelayNet", MakeFunctor(*this, &LoopbackRelay::NetworkSideRun), kPriorityHigh);
+    iThreadDelivery = new ThreadFunctor("LoopbackRelayTx", MakeFunctor(*this, &LoopbackRelay::DeliveryRun), kPriorityHigh);
+    iThreadReceiverSide->Start();
+    iThreadNetworkSide->Start();
+    iThreadDelivery->Start();
+}
+
+LoopbackRelay::~LoopbackRelay()
+{
+    iQuit = true;
+    iSocketReceiver.Interrupt(true);
+    iSocketNetwork.Interrupt(true);
+    iSemPending.Signal();
+    delete iThreadDelivery;
+    delete iThreadNetworkSide;
+    delete iThreadReceiverSide;
+    for (auto it=iPending.begin(); it!=iPending.end(); ++it) {
+        delete it->second;
+    }
+    for (auto it=iFree.begin(); it!=iFree.end(); ++it) {
+        delete *it;
+    }
+}
+
+void LoopbackRelay::AppendUri(Bwx& aUri)
+{
+    aUri.Append("ohu://");
+    Endpoint(iSocketReceiver.Port(), iInterface).AppendEndpoint(aUri);
+}
+
+TUint LoopbackRelay::PacketsForwarded() const
+{
+    AutoMutex _(iLock);
+    return iForwarded;
+}
+
+TUint LoopbackRelay::PacketsDropped() const
+{
+    AutoMutex _(iLock);
+    return iDropped;
+}
+
+TUint LoopbackRelay::PacketsReordered() const
+{
+    AutoMutex _(iLock);
+    return iReordered;
+}
+
+void LoopbackRelay::ReceiverSideRun()
+{
+    // join/listen/resend/leave from our receiver; always destined for the sender
+    while (!iQuit) {
+        try {
+            const Endpoint ep = iSocketReceiver.Receive(iBufReceiverSide);
+            {
+                AutoMutex _(iLock);
+                iReceiver.Replace(ep);
+                iReceiverKnown = true;
+            }
+            Schedule(iBufReceiverSide, false);
+        }
+        catch (NetworkError&) {
+        }
+    }
+}
+
+void LoopbackRelay::NetworkSideRun()
+{
+    // audio, track, metatext, slave lists etc from the sender or a master receiver
+    while (!iQuit) {
+        try {
+            (void)iSocketNetwork.Receive(iBufNetworkSide);
+            Schedule(iBufNetworkSide, true);
+        }
+        catch (NetworkError&) {
+        }
+    }
+}
+
+void LoopbackRelay::Schedule(const Brx& aData, TBool aToReceiver)
+{
+    AutoMutex _(iLock);
+    if (NextRandom() % 100 < iImpairment.iLossPercent || iFree.size() == 0) {
+        iDropped++;
+        return;
+    }
+    TUint64 delayUs = iImpairment.iDelayMs * 1000;
+    if (iImpairment.iJitterMs > 0) {
+        delayUs += NextRandom() % (iImpairment.iJitterMs * 1000);
+    }
+    if (NextRandom() % 100 < iImpairment.iReorderPercent) {
+        delayUs += kReorderHoldMs * 1000;
+        iReordered++;
+    }
+    Packet* packet = iFree.back();
+    iFree.pop_back();
+    packet->iToReceiver = aToReceiver;
+    packet->iData.Replace(aData);
+    const TUint64 due = OsTimeInUs(iEnv.OsCtx()) + delayUs;
+    (void)iPending.insert(std::pair<TUint64, Packet*>(due, packet));
+    iSemPending.Signal();
+}
+
+void LoopbackRelay::DeliveryRun()
+{
+    for (;;) {
+        TUint waitMs = 0;
+        Packet* packet = nullptr;
+        Endpoint ep;
+        {
+            AutoMutex _(iLock);
+            if (iQuit) {
+                break;
+            }
+            if (iPending.size() > 0) {
+                auto first = iPending.begin();
+                const TUint64 now = OsTimeInUs(iEnv.OsCtx());
+                if (first->first <= now) {
+                    packet = first->second;
+                    iPending.erase(first);
+                    if (packet->iToReceiver) {
+                        if (!iReceiverKnown) {
+                            iFree.push_back(packet);
+                            continue;
+                        }
+                        ep.Replace(iReceiver);
+                    }
+                    else {
+                        ep.Replace(iSender);
+                    }
+                }
+                else {
+                    waitMs = static_cast<TUint>((first->first - now + 999) / 1000);
+                }
+            }
+        }
+        if (packet != nullptr) {
+            try {
+                if (packet->iToReceiver) {
+                    iSocketReceiver.Send(packet->iData, ep);
+                }
+                else {
+                    iSocketNetwork.Send(packet->iData, ep);
+                }
+            }
+            catch (NetworkError&) {
+            }
+            AutoMutex _(iLock);
+            iForwarded++;
+            iFree.push_back(packet);
+        }
+        else if (waitMs == 0) {
+            iSemPending.Wait();
+        }
+        else {
+            try {
+                iSemPending.Wait(waitMs);
+            }
+            catch (Timeout&) {
+            }
+        }
+    }
+}
+
+TUint LoopbackRelay::NextRandom()
+{
+    // deterministic so that runs with the same seed see the same pattern of impairments
+    iRandom = iRandom * 1103515245 + 12345;
+    return iRandom >> 8;
+}
+
+
+// LoopbackSink
+
+const TUint LoopbackSink::kSupportedMsgTypes =   eMode
+                                               | eTrack
+                                               | eDrain
+                                               | eDelay
+                                               | eEncodedStream
+                                               | eAudioEncoded
+                                               | eMetatext
+                                               | eStreamInterrupted
+                                               | eHalt
+                                               | eFlush
+                                               | eWait;
+
+LoopbackSink::LoopbackSink(Environment& aEnv, TUint aLatencyMs)
+    : PipelineElement(kSupportedMsgTypes)
+    , iEnv(aEnv)
+    , iDeadlineUs(static_cast<TUint64>(aLatencyMs) * 1000)
+    , iSeqValid(false)
+    , iNextSeq(0)
+    , iFrames(0)
+    , iMissing(0)
+    , iLate(0)
+    , iStarvationEvents(0)
+    , iInDropout(false)
+    , iStreams(0)
+    , iInterruptions(0)
+    , iLatencyTotalUs(0)
+    , iLatencyMaxUs(0)
+    , iLatencyHistogram(kMaxHistogramMs + 1, 0)
+{
+}
+
+void LoopbackSink::Report(TUint aIndex, TUint64 aCpuUs, TUint64 aElapsedUs) const
+{
+    TUint64 meanUs = 0;
+    TUint p99Ms = 0;
+    if (iFrames > 0) {
+        meanUs = iLatencyTotalUs / iFrames;
+        const TUint threshold = iFrames - iFrames / 100;
+        TUint count = 0;
+        for (TUint i=0; i<iLatencyHistogram.size(); i++) {
+            count += iLatencyHistogram[i];
+            if (count >= threshold) {
+                p99Ms = i;
+                break;
+            }
+        }
+    }
+    Log::Print("Receiver %u: frames=%u, missing=%u, late=%u, starvation events=%u, streams=%u, interruptions=%u\n",
+               aIndex, iFrames, iMissing, iLate, iStarvationEvents, iStreams, iInterruptions);
+    Log::Print("    latency: mean=%u.%03ums, p99=%ums, max=%u.%03ums\n",
+               static_cast<TUint>(meanUs / 1000), static_cast<TUint>(meanUs % 1000), p99Ms,
+               static_cast<TUint>(iLatencyMaxUs / 1000), static_cast<TUint>(iLatencyMaxUs % 1000));
+    if (aCpuUs > 0 && aElapsedUs > 0) {
+        const TUint permille = static_cast<TUint>((aCpuUs * 1000) / aElapsedUs);
+        Log::Print("    cpu: %ums (%u.%u%%)\n", static_cast<TUint>(aCpuUs / 1000), permille / 10, permille % 10);
+    }
+    else {
+        Log::Print("    cpu: not available\n");
+    }
+}
+
+void LoopbackSink::Push(Msg* aMsg)
+{
+    Msg* msg = aMsg->Process(*this);
+    if (msg != nullptr) {
+        msg->RemoveRef();
+    }
+}
+
+Msg* LoopbackSink::ProcessMsg(MsgDrain* aMsg)
+{
+    aMsg->ReportDrained();
+    return aMsg;
+}
+
+Msg* LoopbackSink::ProcessMsg(MsgEncodedStream* aMsg)
+{
+    iStreams++;
+    iSeqValid = false; // a new stream starts wherever the sender currently is
+    return aMsg;
+}
+
+Msg* LoopbackSink::ProcessMsg(MsgAudioEncoded* aMsg)
+{
+    const TUint64 now = OsTimeInUs(iEnv.OsCtx());
+    aMsg->CopyTo(iAudio);
+    const Brn audio(iAudio, aMsg->Bytes());
+    if (audio.Bytes() < kHeaderBytes || Converter::BeUint32At(audio, 0) != kMagic) {
+        return aMsg;
+    }
+    const TUint seq = Converter::BeUint32At(audio, 4);
+    const TUint64 sentUs = Converter::BeUint64At(audio, 8);
+
+    if (iSeqValid) {
+        const TInt gap = static_cast<TInt>(seq - iNextSeq);
+        if (gap < 0) {
+            return aMsg; // stale duplicate; the protocol shouldn't output these
+        }
+        if (gap > 0) {
+            iMissing += gap;
+            Dropout();
+        }
+    }
+    iSeqValid = true;
+    iNextSeq = seq + 1;
+    iFrames++;
+
+    const TUint64 latencyUs = (now > sentUs? now - sentUs : 0);
+    iLatencyTotalUs += latencyUs;
+    if (latencyUs > iLatencyMaxUs) {
+        iLatencyMaxUs = latencyUs;
+    }
+    const TUint bucket = static_cast<TUint>(std::min<TUint64>(latencyUs / 1000, kMaxHistogramMs));
+    iLatencyHistogram[bucket]++;
+    if (latencyUs > iDeadlineUs) {
+        // arrived after the point the sender expected it to be played
+        iLate++;
+        Dropout();
+    }
+    else {
+        iInDropout = false;
+    }
+    return aMsg;
+}
+
+Msg* LoopbackSink::ProcessMsg(MsgStreamInterrupted* aMsg)
+{
+    iInterruptions++;
+    return aMsg;
+}
+
+Msg* LoopbackSink::ProcessMsg(MsgHalt* aMsg)
+{
+    iInterruptions++;
+    return aMsg;
+}
+
+void LoopbackSink::Dropout()
+{
+    // consecutive missing/late frames would be heard as a single dropout
+    if (!iInDropout) {
+        iInDropout = true;
+        iStarvationEvents++;
+    }
+}
+
+
+// LoopbackReceiver
+
+LoopbackReceiver::LoopbackReceiver(Environment& aEnv, const Brx& aUri, TUint aLatencyMs, TUint aIndex)
+    : iIndex(aIndex)
+    , iUri(aUri)
+    , iNextStreamId(IPipelineIdProvider::kStreamIdInvalid + 1)
+    , iNextFlushId(MsgFlush::kIdInvalid + 1)
+    , iProtocolInfo(nullptr)
+    , iSink(aEnv, aLatencyMs)
+    , iOhmMsgFactory(266, 10, 10)
+    , iQuit(false)
+    , iSemStopped("LRCV", 0)
+    , iCpuUs(0)
+    , iThread(nullptr)
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(20, 20);
+    init.SetMsgEncodedStreamCount(4);
+    init.SetMsgTrackCount(4);
+    init.SetMsgDrainCount(4);
+    init.SetMsgDelayCount(4);
+    init.SetMsgMetaTextCount(4);
+    init.SetMsgHaltCount(4);
+    init.SetMsgFlushCount(4);
+    init.SetMsgWaitCount(4);
+    init.SetMsgStreamInterruptedCount(4);
+    iMsgFactory = new MsgFactory(*this, init);
+    iTrackFactory = new TrackFactory(*this, 4);
+    iProtocolManager = new ProtocolManager(iSink, *iMsgFactory, *this, *this);
+    iProtocolManager->Add(new ProtocolOhu(aEnv, iOhmMsgFactory, *iTrackFactory, Optional<IOhmTimestamper>(),
+                                          Optional<IClockPullerTimestamp>(), Brn("LoopbackReceiver"), Optional<IOhmMsgProcessor>()));
+    iProtocolManager->RegisterInfo(*this);
+}
+
+LoopbackReceiver::~LoopbackReceiver()
+{
+    Stop();
+    delete iProtocolManager;
+    delete iTrackFactory;
+    delete iMsgFactory;
+}
+
+void LoopbackReceiver::Start()
+{
+    iThread = new ThreadFunctor("LoopbackReceiver", MakeFunctor(*this, &LoopbackReceiver::Run), kPriorityHigh);
+    iThread->Start();
+}
+
+void LoopbackReceiver::Stop()
+{
+    if (iThread == nullptr) {
+        return;
+    }
+    iQuit = true;
+    for (;;) {
+        // the protocol clears interrupts as it (re)starts a stream so keep interrupting until it notices
+        iProtocolManager->Interrupt(true);
+        try {
+            iSemStopped.Wait(100);
+            break;
+        }
+        catch (Timeout&) {
+        }
+    }
+    delete iThread;
+    iThread = nullptr;
+}
+
+void LoopbackReceiver::Report(TUint64 aElapsedUs)
+{
+    iSink.Report(iIndex, iCpuUs, aElapsedUs);
+    if (iProtocolInfo != nullptr) {
+        iProtocolInfo->QueryInfo(ProtocolManager::kQueryProtocols, *this);
+    }
+}
+
+void LoopbackReceiver::Run()
+{
+    const TUint64 cpuStart = ThreadCpuUs();
+    Track* track = iTrackFactory->CreateTrack(iUri, Brx::Empty());
+    while (!iQuit) {
+        const ProtocolStreamResult res = iProtocolManager->DoStream(*track);
+        if (res != EProtocolStreamStopped && !iQuit) {
+            Thread::Sleep(50);
+        }
+    }
+    track->RemoveRef();
+    iCpuUs = ThreadCpuUs() - cpuStart;
+    iSemStopped.Signal();
+}
+
+TUint64 LoopbackReceiver::ThreadCpuUs()
+{ // static
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return static_cast<TUint64>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+#endif
+    return 0;
+}
+
+TUint LoopbackReceiver::NextStreamId()
+{
+    return iNextStreamId++;
+}
+
+EStreamPlay LoopbackReceiver::OkToPlay(TUint /*aStreamId*/)
+{
+    return ePlayYes;
+}
+
+TUint LoopbackReceiver::NextFlushId()
+{
+    return iNextFlushId++;
+}
+
+void LoopbackReceiver::Register(IInfoProvider& aProvider, std::vector<Brn>& aSupportedQueries)
+{
+    for (auto it=aSupportedQueries.begin(); it!=aSupportedQueries.end(); ++it) {
+        if (*it == ProtocolManager::kQueryProtocols) {
+            iProtocolInfo = &aProvider;
+        }
+    }
+}
+
+void LoopbackReceiver::Write(TByte aValue)
+{
+    Log::Print("%c", aValue);
+}
+
+void LoopbackReceiver::Write(const Brx& aBuffer)
+{
+    Log::Print(aBuffer);
+}
+
+void LoopbackReceiver::WriteFlush()
+{
+}
+
+
+// SongcastLoopbackBench
+
+SongcastLoopbackBench::SongcastLoopbackBench(Environment& aEnv, Net::DvStack& aDvStack, TUint aLatencyMs)
+    : iEnv(aEnv)
+    , iLatencyMs(aLatencyMs)
+    , iSemDeviceDisabled("SLBD", 0)
+    , iFeederQuit(false)
+    , iFramesSent(0)
+{
+    Brn udn("SongcastLoopbackBench");
+    iDevice = new Net::DvDeviceStandard(aDvStack, udn);
+    iDevice->SetAttribute("Upnp.Domain", "av.openhome.org");
+    iDevice->SetAttribute("Upnp.Type", "Songcast");
+    iDevice->SetAttribute("Upnp.Version", "1");
+    iDevice->SetAttribute("Upnp.FriendlyName", "Songcast loopback bench");
+    iDevice->SetAttribute("Upnp.Manufacturer", "Openhome");
+    iDevice->SetAttribute("Upnp.ModelName", "ohMediaPlayer");
+    iZoneHandler = new ZoneHandler(aEnv, udn);
+    iDriver = new OhmSenderDriver(aEnv, Optional<IOhmTimestamper>(), aLatencyMs);
+    iSender = new OhmSender(aEnv, *iDevice, *iDriver, *iZoneHandler, kPriorityHigh, udn, 0, aLatencyMs, false/*unicast*/);
+    iDriver->SetAudioFormat(kSampleRate, kSampleRate * kChannels * kBitDepth, kChannels, kBitDepth, true, Brn("PCM"), 0);
+    iSender->SetEnabled(true);
+    iDevice->SetEnabled();
+}
+
+SongcastLoopbackBench::~SongcastLoopbackBench()
+{
+    iDevice->SetDisabled(MakeFunctor(*this, &SongcastLoopbackBench::DeviceDisabled));
+    iSemDeviceDisabled.Wait();
+    delete iSender;
+    delete iDriver;
+    delete iDevice;
+    delete iZoneHandler;
+}
+
+void SongcastLoopbackBench::Run(TUint aReceivers, const LoopbackImpairment& aImpairment, TUint aSeed, TUint aDurationSecs)
+{
+    Bws<64> senderUri;
+    Uri uri;
+    for (TUint waitedMs=0; ; waitedMs+=10) {
+        iZoneHandler->GetHomeSenderUri(senderUri);
+        if (senderUri.Bytes() > 0) {
+            uri.Replace(senderUri);
+            if (uri.Port() != 0) {
+                break;
+            }
+        }
+        if (waitedMs >= kSenderStartTimeoutMs) {
+            Log::Print("ERROR: sender failed to start\n");
+            return;
+        }
+        Thread::Sleep(10);
+    }
+    Endpoint sender(uri.Port(), uri.Host());
+    Log::Print("Sender: %.*s, %u receivers, loss=%u%%, reorder=%u%%, delay=%ums, jitter=%ums, latency=%ums, %us\n",
+               PBUF(senderUri), aReceivers, aImpairment.iLossPercent, aImpairment.iReorderPercent,
+               aImpairment.iDelayMs, aImpairment.iJitterMs, iLatencyMs, aDurationSecs);
+
+    std::vector<LoopbackRelay*> relays;
+    std::vector<LoopbackReceiver*> receivers;
+    for (TUint i=0; i<aReceivers; i++) {
+        auto relay = new LoopbackRelay(iEnv, sender.Address(), sender, aImpairment, aSeed + i);
+        Bws<64> receiverUri;
+        relay->AppendUri(receiverUri);
+        relays.push_back(relay);
+        receivers.push_back(new LoopbackReceiver(iEnv, receiverUri, iLatencyMs, i));
+    }
+
+    ThreadFunctor* feeder = new ThreadFunctor("LoopbackFeeder", MakeFunctor(*this, &SongcastLoopbackBench::FeederRun), kPrioritySystemHighest);
+    feeder->Start();
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    for (auto it=receivers.begin(); it!=receivers.end(); ++it) {
+        (*it)->Start();
+    }
+    Thread::Sleep(aDurationSecs * 1000);
+    for (auto it=receivers.begin(); it!=receivers.end(); ++it) {
+        (*it)->Stop();
+    }
+    const TUint64 elapsedUs = OsTimeInUs(iEnv.OsCtx()) - start;
+    iFeederQuit = true;
+    delete feeder;
+
+    Log::Print("\nSender: frames=%u\n", iFramesSent);
+    for (TUint i=0; i<receivers.size(); i++) {
+        receivers[i]->Report(elapsedUs);
+        Log::Print("    relay: forwarded=%u, dropped=%u, reordered=%u\n",
+                   relays[i]->PacketsForwarded(), relays[i]->PacketsDropped(), relays[i]->PacketsReordered());
+    }
+
+    for (TUint i=0; i<receivers.size(); i++) {
+        delete receivers[i];
+        delete relays[i];
+    }
+}
+
+void SongcastLoopbackBench::FeederRun()
+{
+    iFrame.SetBytes(kFrameBytes);
+    iFrame.Fill(0);
+    TUint64 next = OsTimeInUs(iEnv.OsCtx());
+    for (TUint seq=0; !iFeederQuit; seq++) {
+        const TUint64 now = OsTimeInUs(iEnv.OsCtx());
+        iFrame.SetBytes(0);
+        WriterBuffer writerBuf(iFrame);
+        WriterBinary writer(writerBuf);
+        writer.WriteUint32Be(LoopbackSink::kMagic);
+        writer.WriteUint32Be(seq);
+        writer.WriteUint64Be(now);
+        iFrame.SetBytes(kFrameBytes);
+        iDriver->SendAudio(iFrame.Ptr(), iFrame.Bytes());
+        iFramesSent++;
+
+        next += kFrameMs * 1000;
+        const TUint64 after = OsTimeInUs(iEnv.OsCtx());
+        if (next > after) {
+            Thread::Sleep(static_cast<TUint>((next - after) / 1000));
+        }
+    }
+}
+
+void SongcastLoopbackBench::DeviceDisabled()
+{
+    iSemDeviceDisabled.Signal();
+}
+
+
+
+void TestSongcastLoopback(Environment& aEnv, Net::DvStack& aDvStack, const std::vector<Brn>& aArgs)
+{
+    OptionParser parser;
+    OptionUint optionReceivers("-r", "--receivers", 4, "number of receivers");
+    parser.AddOption(&optionReceivers);
+    OptionUint optionLoss("-l", "--loss", 1, "percentage of packets dropped (each direction)");
+    parser.AddOption(&optionLoss);
+    OptionUint optionReorder("-o", "--reorder", 1, "percentage of packets delivered out of order");
+    parser.AddOption(&optionReorder);
+    OptionUint optionDelay("-d", "--delay", 2, "one way network delay (ms)");
+    parser.AddOption(&optionDelay);
+    OptionUint optionJitter("-j", "--jitter", 2, "maximum additional random delay (ms)");
+    parser.AddOption(&optionJitter);
+    OptionUint optionLatency("-a", "--latency", 100, "sender latency (ms)");
+    parser.AddOption(&optionLatency);
+    OptionUint optionDuration("-t", "--time", 30, "duration of run (s)");
+    parser.AddOption(&optionDuration);
+    OptionUint optionSeed("-s", "--seed", 1, "seed for loss/reorder/jitter patterns");
+    parser.AddOption(&optionSeed);
+    if (!parser.Parse(aArgs) || parser.HelpDisplayed()) {
+        return;
+    }
+    const TUint maxReceivers = OhmHeaderSlave::kMaxSlaveCount + 1;
+    if (optionReceivers.Value() == 0 || optionReceivers.Value() > maxReceivers) {
+        Log::Print("ERROR: receivers must be in the range 1..%u\n", maxReceivers);
+        return;
+    }
+    if (optionLoss.Value() > 100 || optionReorder.Value() > 100) {
+        Log::Print("ERROR: loss and reorder are percentages\n");
+        return;
+    }
+
+    LoopbackImpairment impairment(optionLoss.Value(), optionReorder.Value(), optionDelay.Value(), optionJitter.Value());
+    auto bench = new SongcastLoopbackBench(aEnv, aDvStack, optionLatency.Value());
+    bench->Run(optionReceivers.Value(), impairment, optionSeed.Value(), optionDuration.Value());
+    delete bench;
+}
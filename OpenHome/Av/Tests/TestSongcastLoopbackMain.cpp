@@ -0,0 +1,28 @@
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Net/Core/OhNet.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Net;
+
+extern void TestSongcastLoopback(Environment& aEnv, DvStack& aDvStack, const std::vector<Brn>& aArgs);
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    aInitParams->SetDvUpnpServerPort(0);
+    aInitParams->SetUseLoopbackNetworkAdapter();
+    Library* lib = new Library(aInitParams);
+    std::vector<NetworkAdapter*>* subnetList = lib->CreateSubnetList();
+    TIpAddress subnet = (*subnetList)[0]->Subnet();
+    Library::DestroySubnetList(subnetList);
+    lib->SetCurrentSubnet(subnet);
+    DvStack* dvStack = lib->StartDv();
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+
+    TestSongcastLoopback(lib->Env(), *dvStack, args);
+
+    delete lib;
+}
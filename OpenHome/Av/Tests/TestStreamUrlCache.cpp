@@ -0,0 +1,304 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Utils/StreamUrlCache.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Ascii.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteStreamUrlCache : public SuiteUnitTest, private IStreamUrlResolver, private INonCopyable
+{
+    static const TUint kExpiryMs = 60 * 1000;
+    static const TUint kShortExpiryMs = 20;
+    static const TUint kResolveTimeoutMs = 5 * 1000;
+public:
+    SuiteStreamUrlCache(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IStreamUrlResolver
+    TBool TryResolveStreamUrl(const Brx& aTrackUri, Bwx& aStreamUrl) override;
+private:
+    void CreateCache(TUint aExpiryMs);
+    void NotifyUpcoming(const std::vector<const TChar*>& aUris);
+    void TestMissThenHit();
+    void TestCountersUpdated();
+    void TestEntryExpires();
+    void TestRemove();
+    void TestClear();
+    void TestOldestEntryEvicted();
+    void TestLookAheadResolvesMatchingScheme();
+    void TestLookAheadSkipsCachedUris();
+    void TestLookAheadFailureNotCached();
+    void TestLookAheadDiscardedAfterClear();
+private:
+    Environment& iEnv;
+    AllocatorInfoLogger iInfoAggregator;
+    TrackFactory* iTrackFactory;
+    StreamUrlCache* iCache;
+    Semaphore iSemResolved;
+    Semaphore iSemResolveStarted;
+    Semaphore iSemResolveRelease;
+    Mutex iLock;
+    std::vector<Bws<StreamUrlCache::kMaxTrackUriBytes>> iResolved;
+    TBool iResolveSucceeds;
+    TBool iResolveBlocks;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteStreamUrlCache
+
+SuiteStreamUrlCache::SuiteStreamUrlCache(Environment& aEnv)
+    : SuiteUnitTest("SuiteStreamUrlCache")
+    , iEnv(aEnv)
+    , iSemResolved("SSUC", 0)
+    , iSemResolveStarted("SSUS", 0)
+    , iSemResolveRelease("SSUR", 0)
+    , iLock("SSUL")
+{
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlCache::TestMissThenHit), "TestMissThenHit");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlCache::TestCountersUpdated), "TestCountersUpdated");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlCache::TestEntryExpires), "TestEntryExpires");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlCache::TestRemove), "TestRemove");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlCache::TestClear), "TestClear");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlCache::TestOldestEntryEvicted), "TestOldestEntryEvicted");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlCache::TestLookAheadResolvesMatchingScheme), "TestLookAheadResolvesMatchingScheme");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlCache::TestLookAheadSkipsCachedUris), "TestLookAheadSkipsCachedUris");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlCache::TestLookAheadFailureNotCached), "TestLookAheadFailureNotCached");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlCache::TestLookAheadDiscardedAfterClear), "TestLookAheadDiscardedAfterClear");
+}
+
+void SuiteStreamUrlCache::Setup()
+{
+    iTrackFactory = new TrackFactory(iInfoAggregator, 5);
+    iCache = nullptr;
+    iResolved.clear();
+    iResolveSucceeds = true;
+    iResolveBlocks = false;
+    (void)iSemResolved.Clear();
+    (void)iSemResolveStarted.Clear();
+    (void)iSemResolveRelease.Clear();
+}
+
+void SuiteStreamUrlCache::TearDown()
+{
+    delete iCache;
+    delete iTrackFactory;
+}
+
+TBool SuiteStreamUrlCache::TryResolveStreamUrl(const Brx& aTrackUri, Bwx& aStreamUrl)
+{
+    iLock.Wait();
+    iResolved.push_back(Bws<StreamUrlCache::kMaxTrackUriBytes>(aTrackUri));
+    const TBool success = iResolveSucceeds;
+    const TBool block = iResolveBlocks;
+    iLock.Signal();
+    if (block) {
+        iSemResolveStarted.Signal();
+        iSemResolveRelease.Wait();
+    }
+    if (success) {
+        aStreamUrl.Replace("http://cdn/");
+        aStreamUrl.Append(aTrackUri);
+    }
+    iSemResolved.Signal();
+    return success;
+}
+
+void SuiteStreamUrlCache::CreateCache(TUint aExpiryMs)
+{
+    iCache = new StreamUrlCache(iEnv, "TestStreamUrlCache", Brn("tidal"), *this, aExpiryMs);
+}
+
+void SuiteStreamUrlCache::NotifyUpcoming(const std::vector<const TChar*>& aUris)
+{
+    std::vector<Track*> tracks;
+    for (auto it=aUris.begin(); it!=aUris.end(); ++it) {
+        tracks.push_back(iTrackFactory->CreateTrack(Brn(*it), Brx::Empty()));
+    }
+    static_cast<ITrackLookAheadObserver*>(iCache)->NotifyUpcomingTracks(tracks);
+    for (auto it=tracks.begin(); it!=tracks.end(); ++it) {
+        (*it)->RemoveRef();
+    }
+}
+
+void SuiteStreamUrlCache::TestMissThenHit()
+{
+    CreateCache(kExpiryMs);
+    const Brn trackUri("tidal://track?version=1&trackId=1");
+    Bws<StreamUrlCache::kMaxStreamUrlBytes> url;
+    TEST(!iCache->TryGet(trackUri, url));
+    iCache->Add(trackUri, Brn("http://cdn/1"));
+    TEST(iCache->TryGet(trackUri, url));
+    TEST(url == Brn("http://cdn/1"));
+    TEST(!iCache->TryGet(Brn("tidal://track?version=1&trackId=2"), url));
+}
+
+void SuiteStreamUrlCache::TestCountersUpdated()
+{
+    CreateCache(kExpiryMs);
+    const Brn trackUri("tidal://track?version=1&trackId=1");
+    Bws<StreamUrlCache::kMaxStreamUrlBytes> url;
+    TEST(iCache->Hits() == 0);
+    TEST(iCache->Misses() == 0);
+    (void)iCache->TryGet(trackUri, url);
+    TEST(iCache->Hits() == 0);
+    TEST(iCache->Misses() == 1);
+    iCache->Add(trackUri, Brn("http://cdn/1"));
+    (void)iCache->TryGet(trackUri, url);
+    (void)iCache->TryGet(trackUri, url);
+    TEST(iCache->Hits() == 2);
+    TEST(iCache->Misses() == 1);
+}
+
+void SuiteStreamUrlCache::TestEntryExpires()
+{
+    CreateCache(kShortExpiryMs);
+    const Brn trackUri("tidal://track?version=1&trackId=1");
+    Bws<StreamUrlCache::kMaxStreamUrlBytes> url;
+    iCache->Add(trackUri, Brn("http://cdn/1"));
+    Thread::Sleep(kShortExpiryMs * 3);
+    TEST(!iCache->TryGet(trackUri, url));
+}
+
+void SuiteStreamUrlCache::TestRemove()
+{
+    CreateCache(kExpiryMs);
+    const Brn trackUri1("tidal://track?version=1&trackId=1");
+    const Brn trackUri2("tidal://track?version=1&trackId=2");
+    Bws<StreamUrlCache::kMaxStreamUrlBytes> url;
+    iCache->Add(trackUri1, Brn("http://cdn/1"));
+    iCache->Add(trackUri2, Brn("http://cdn/2"));
+    iCache->Remove(trackUri1);
+    TEST(!iCache->TryGet(trackUri1, url));
+    TEST(iCache->TryGet(trackUri2, url));
+}
+
+void SuiteStreamUrlCache::TestClear()
+{
+    CreateCache(kExpiryMs);
+    const Brn trackUri1("tidal://track?version=1&trackId=1");
+    const Brn trackUri2("tidal://track?version=1&trackId=2");
+    Bws<StreamUrlCache::kMaxStreamUrlBytes> url;
+    iCache->Add(trackUri1, Brn("http://cdn/1"));
+    iCache->Add(trackUri2, Brn("http://cdn/2"));
+    iCache->Clear();
+    TEST(!iCache->TryGet(trackUri1, url));
+    TEST(!iCache->TryGet(trackUri2, url));
+}
+
+void SuiteStreamUrlCache::TestOldestEntryEvicted()
+{
+    CreateCache(kExpiryMs);
+    Bws<StreamUrlCache::kMaxTrackUriBytes> trackUri;
+    for (TUint i=0; i<=StreamUrlCache::kMaxEntries; i++) {
+        trackUri.Replace("tidal://track?version=1&trackId=");
+        Ascii::AppendDec(trackUri, i);
+        iCache->Add(trackUri, Brn("http://cdn/"));
+        Thread::Sleep(2); // ensure each entry has a distinct age
+    }
+    Bws<StreamUrlCache::kMaxStreamUrlBytes> url;
+    TEST(!iCache->TryGet(Brn("tidal://track?version=1&trackId=0"), url));
+    for (TUint i=1; i<=StreamUrlCache::kMaxEntries; i++) {
+        trackUri.Replace("tidal://track?version=1&trackId=");
+        Ascii::AppendDec(trackUri, i);
+        TEST(iCache->TryGet(trackUri, url));
+    }
+}
+
+void SuiteStreamUrlCache::TestLookAheadResolvesMatchingScheme()
+{
+    CreateCache(kExpiryMs);
+    std::vector<const TChar*> uris;
+    uris.push_back("http://radio/1");
+    uris.push_back("tidal://track?version=1&trackId=2");
+    uris.push_back("tidalx://track?version=1&trackId=3");
+    uris.push_back("tidal://track?version=1&trackId=4");
+    NotifyUpcoming(uris);
+    iSemResolved.Wait(kResolveTimeoutMs);
+    iSemResolved.Wait(kResolveTimeoutMs);
+    TEST(!iSemResolved.Clear());
+
+    iLock.Wait();
+    TEST(iResolved.size() == 2);
+    TEST(iResolved[0] == Brn("tidal://track?version=1&trackId=2"));
+    TEST(iResolved[1] == Brn("tidal://track?version=1&trackId=4"));
+    iLock.Signal();
+
+    Thread::Sleep(50); // allow resolver thread to add its final result
+    Bws<StreamUrlCache::kMaxStreamUrlBytes> url;
+    TEST(iCache->TryGet(Brn("tidal://track?version=1&trackId=2"), url));
+    TEST(url == Brn("http://cdn/tidal://track?version=1&trackId=2"));
+    TEST(iCache->TryGet(Brn("tidal://track?version=1&trackId=4"), url));
+    TEST(iCache->LookAheadResolved() == 2);
+}
+
+void SuiteStreamUrlCache::TestLookAheadSkipsCachedUris()
+{
+    CreateCache(kExpiryMs);
+    iCache->Add(Brn("tidal://track?version=1&trackId=1"), Brn("http://cdn/1"));
+    std::vector<const TChar*> uris;
+    uris.push_back("tidal://track?version=1&trackId=1");
+    uris.push_back("tidal://track?version=1&trackId=2");
+    NotifyUpcoming(uris);
+    iSemResolved.Wait(kResolveTimeoutMs);
+    Thread::Sleep(50);
+    TEST(!iSemResolved.Clear());
+    iLock.Wait();
+    TEST(iResolved.size() == 1);
+    TEST(iResolved[0] == Brn("tidal://track?version=1&trackId=2"));
+    iLock.Signal();
+}
+
+void SuiteStreamUrlCache::TestLookAheadFailureNotCached()
+{
+    CreateCache(kExpiryMs);
+    iResolveSucceeds = false;
+    std::vector<const TChar*> uris;
+    uris.push_back("tidal://track?version=1&trackId=1");
+    NotifyUpcoming(uris);
+    iSemResolved.Wait(kResolveTimeoutMs);
+    Thread::Sleep(50);
+    Bws<StreamUrlCache::kMaxStreamUrlBytes> url;
+    TEST(!iCache->TryGet(Brn("tidal://track?version=1&trackId=1"), url));
+    TEST(iCache->LookAheadResolved() == 0);
+}
+
+void SuiteStreamUrlCache::TestLookAheadDiscardedAfterClear()
+{
+    CreateCache(kExpiryMs);
+    iResolveBlocks = true;
+    std::vector<const TChar*> uris;
+    uris.push_back("tidal://track?version=1&trackId=1");
+    NotifyUpcoming(uris);
+    iSemResolveStarted.Wait(kResolveTimeoutMs);
+    iCache->Clear(); // e.g. sound quality changed while the old quality's url was being fetched
+    iSemResolveRelease.Signal();
+    iSemResolved.Wait(kResolveTimeoutMs);
+    Thread::Sleep(50);
+    Bws<StreamUrlCache::kMaxStreamUrlBytes> url;
+    TEST(!iCache->TryGet(Brn("tidal://track?version=1&trackId=1"), url));
+    TEST(iCache->LookAheadResolved() == 0);
+}
+
+
+
+void TestStreamUrlCache(Environment& aEnv)
+{
+    Runner runner("StreamUrlCache tests\n");
+    runner.Add(new SuiteStreamUrlCache(aEnv));
+    runner.Run();
+}
@@ -7,6 +7,7 @@
 
 #include <limits.h>
 #include <array>
+#include <vector>
 #include <algorithm>
 
 using namespace OpenHome;
@@ -32,9 +33,11 @@ private:
     void InsertInitialTrack();
     void InsertFailsWhenIdAfterInvalid();
     void InsertFailsWhenFull();
+    void InsertFailsWhenFullCustomMax();
     void GetIdArrayDbEmpty();
     void GetIdArrayDbPartiallyFull();
     void GetIdArrayDbFull();
+    void GetIdArrayAfterChanges();
     void InsertAtStart();
     void InsertInMiddle();
     void InsertAtEnd();
@@ -42,6 +45,9 @@ private:
     void DeleteInvalidId();
     void DeleteAll();
     void SeqUpdatesOnChanges();
+    void GetChangesSinceToken();
+    void GetChangesCurrentToken();
+    void GetChangesTokenExpired();
     void GetTrackByValidId();
     void GetTrackByInvalidIdFails();
     void GetTrackByIdValidSeq();
@@ -52,7 +58,7 @@ private:
     TrackFactory* iTrackFactory;
     TrackDatabase* iDb;
     ITrackDatabase* iTrackDatabase;
-    std::array<TUint32, ITrackDatabase::kMaxTracks> iIdArray;
+    std::vector<TUint32> iIdArray;
     TUint iInsertedCount;
     TUint iIdLastInserted;
     TUint iIdLastInsertedBefore;
@@ -121,6 +127,12 @@ private:
     void TrackRefByIndexSortedShuffleOn();
     void ModeToggleReshuffles();
     void NextTrackBeyondEndReshuffles();
+    void PeekNextTrackLeavesShuffle();
+    void SeededShuffleRepeats();
+    void InsertedTrackNotYetPlayed();
+    void MoveToStartPlaysNext();
+private:
+    void ShuffledIds(std::vector<TUint32>& aIds);
 private:
     static const TUint kNumTracks = 16; // gives us ~1 in 21 trillion chance of shuffling tracks into their original order
     Media::AllocatorInfoLogger iInfoAggregator;
@@ -175,9 +187,11 @@ SuiteTrackDatabase::SuiteTrackDatabase()
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::InsertInitialTrack), "InsertInitialTrack");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::InsertFailsWhenIdAfterInvalid), "InsertFailsWhenIdAfterInvalid");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::InsertFailsWhenFull), "InsertFailsWhenFull");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabase::InsertFailsWhenFullCustomMax), "InsertFailsWhenFullCustomMax");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::GetIdArrayDbEmpty), "GetIdArrayDbEmpty");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::GetIdArrayDbPartiallyFull), "GetIdArrayDbPartiallyFull");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::GetIdArrayDbFull), "GetIdArrayDbFull");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabase::GetIdArrayAfterChanges), "GetIdArrayAfterChanges");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::InsertAtStart), "InsertAtStart");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::InsertInMiddle), "InsertInMiddle");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::InsertAtEnd), "InsertAtEnd");
@@ -185,6 +199,9 @@ SuiteTrackDatabase::SuiteTrackDatabase()
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::DeleteInvalidId), "DeleteInvalidId");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::DeleteAll), "DeleteAll");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::SeqUpdatesOnChanges), "SeqUpdatesOnChanges");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabase::GetChangesSinceToken), "GetChangesSinceToken");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabase::GetChangesCurrentToken), "GetChangesCurrentToken");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabase::GetChangesTokenExpired), "GetChangesTokenExpired");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::GetTrackByValidId), "GetTrackByValidId");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::GetTrackByInvalidIdFails), "GetTrackByInvalidIdFails");
     AddTest(MakeFunctor(*this, &SuiteTrackDatabase::GetTrackByIdValidSeq), "GetTrackByIdValidSeq");
@@ -260,13 +277,28 @@ void SuiteTrackDatabase::InsertFailsWhenFull()
     TEST_THROWS(iTrackDatabase->Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), newId), TrackDbFull);
 }
 
+void SuiteTrackDatabase::InsertFailsWhenFullCustomMax()
+{
+    static const TUint kMaxTracks = 5;
+    TrackDatabase db(*iTrackFactory, kMaxTracks);
+    ITrackDatabase& trackDatabase = db;
+    TEST(trackDatabase.TracksMax() == kMaxTracks);
+    TEST(iTrackDatabase->TracksMax() == ITrackDatabase::kMaxTracks);
+    TUint newId;
+    for (TUint i=0; i<kMaxTracks; i++) {
+        trackDatabase.Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), newId);
+    }
+    TEST_THROWS(trackDatabase.Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), newId), TrackDbFull);
+    trackDatabase.DeleteId(newId);
+    trackDatabase.Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), newId);
+}
+
 void SuiteTrackDatabase::GetIdArrayDbEmpty()
 {
     TUint seq;
+    iIdArray.assign(3, 1);
     iTrackDatabase->GetIdArray(iIdArray, seq);
-    for (TUint i=0; i<ITrackDatabase::kMaxTracks; i++) {
-        TEST_QUIETLY(iIdArray[i] == ITrackDatabase::kTrackIdNone);
-    }
+    TEST(iIdArray.size() == 0);
 }
 
 void SuiteTrackDatabase::GetIdArrayDbPartiallyFull()
@@ -281,6 +313,7 @@ void SuiteTrackDatabase::GetIdArrayDbPartiallyFull()
     }
     TUint seq;
     iTrackDatabase->GetIdArray(iIdArray, seq);
+    TEST(iIdArray.size() == kTrackCount);
     std::array<TUint32, kTrackCount> trackIds;
     trackIds.fill((TUint)ITrackDatabase::kTrackIdNone);
     for (i=0; i<kTrackCount; i++) {
@@ -290,9 +323,6 @@ void SuiteTrackDatabase::GetIdArrayDbPartiallyFull()
         TEST(it == trackIds.end()); // check that each track id is unique
         trackIds[i] = id;
     }
-    for (i=kTrackCount; i<ITrackDatabase::kMaxTracks; i++) {
-        TEST_QUIETLY(iIdArray[i] == ITrackDatabase::kTrackIdNone);
-    }
 }
 
 void SuiteTrackDatabase::GetIdArrayDbFull()
@@ -305,11 +335,42 @@ void SuiteTrackDatabase::GetIdArrayDbFull()
     }
     TUint seq;
     iTrackDatabase->GetIdArray(iIdArray, seq);
+    TEST(iIdArray.size() == ITrackDatabase::kMaxTracks);
     for (TUint i=0; i<ITrackDatabase::kMaxTracks; i++) {
         TEST_QUIETLY(iIdArray[i] != ITrackDatabase::kTrackIdNone);
     }
 }
 
+void SuiteTrackDatabase::GetIdArrayAfterChanges()
+{
+    // successive snapshots only refresh what changed; check each still describes the whole list
+    TUint ids[5];
+    TUint seq;
+    iTrackDatabase->Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), ids[0]);
+    iTrackDatabase->Insert(ids[0], Brx::Empty(), Brx::Empty(), ids[1]);
+    iTrackDatabase->GetIdArray(iIdArray, seq);
+    TEST(iIdArray == std::vector<TUint32>({ids[0], ids[1]}));
+
+    iTrackDatabase->Insert(ids[1], Brx::Empty(), Brx::Empty(), ids[2]);
+    iTrackDatabase->Insert(ids[2], Brx::Empty(), Brx::Empty(), ids[3]);
+    iTrackDatabase->GetIdArray(iIdArray, seq);
+    TEST(iIdArray == std::vector<TUint32>({ids[0], ids[1], ids[2], ids[3]}));
+
+    iTrackDatabase->Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), ids[4]);
+    iTrackDatabase->DeleteId(ids[2]);
+    iTrackDatabase->GetIdArray(iIdArray, seq);
+    TEST(iIdArray == std::vector<TUint32>({ids[4], ids[0], ids[1], ids[3]}));
+
+    iTrackDatabase->DeleteId(ids[3]);
+    iTrackDatabase->GetIdArray(iIdArray, seq);
+    TEST(iIdArray == std::vector<TUint32>({ids[4], ids[0], ids[1]}));
+
+    iTrackDatabase->DeleteAll();
+    iTrackDatabase->Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), ids[0]);
+    iTrackDatabase->GetIdArray(iIdArray, seq);
+    TEST(iIdArray == std::vector<TUint32>({ids[0]}));
+}
+
 void SuiteTrackDatabase::InsertAtStart()
 {
     TUint ids[2];
@@ -319,6 +380,10 @@ void SuiteTrackDatabase::InsertAtStart()
     TEST(iIdLastInserted == ids[1]);
     TEST(iIdLastInsertedBefore == ITrackDatabase::kTrackIdNone);
     TEST(iIdLastInsertedAfter == ids[0]);
+
+    TUint id;
+    iTrackDatabase->Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), id);
+    TEST(iIdLastInsertedAfter == ids[1]);
 }
 
 void SuiteTrackDatabase::InsertInMiddle()
@@ -443,6 +508,83 @@ void SuiteTrackDatabase::SeqUpdatesOnChanges()
     TEST(seq == prevSeq+1);
 }
 
+void SuiteTrackDatabase::GetChangesSinceToken()
+{
+    TUint token;
+    iTrackDatabase->GetIdArray(iIdArray, token);
+    TUint id1, id2, id3;
+    iTrackDatabase->Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), id1);
+    iTrackDatabase->Insert(id1, Brx::Empty(), Brx::Empty(), id2);
+    iTrackDatabase->Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), id3);
+    iTrackDatabase->DeleteId(id1);
+
+    std::vector<TrackDbChange> changes;
+    TUint seq;
+    TEST(iTrackDatabase->GetChanges(token, changes, seq));
+    TEST(seq == token + 4);
+    TEST(changes.size() == 4);
+    TEST(changes[0].iType == TrackDbChange::eInsert);
+    TEST(changes[0].iId == id1);
+    TEST(changes[0].iIdAfter == ITrackDatabase::kTrackIdNone);
+    TEST(changes[1].iType == TrackDbChange::eInsert);
+    TEST(changes[1].iId == id2);
+    TEST(changes[1].iIdAfter == id1);
+    TEST(changes[2].iType == TrackDbChange::eInsert);
+    TEST(changes[2].iId == id3);
+    TEST(changes[2].iIdAfter == ITrackDatabase::kTrackIdNone);
+    TEST(changes[3].iType == TrackDbChange::eDelete);
+    TEST(changes[3].iId == id1);
+
+    // a later token only returns the changes made after it
+    TEST(iTrackDatabase->GetChanges(token + 3, changes, seq));
+    TEST(changes.size() == 1);
+    TEST(changes[0].iType == TrackDbChange::eDelete);
+
+    iTrackDatabase->DeleteAll();
+    TEST(iTrackDatabase->GetChanges(token + 4, changes, seq));
+    TEST(seq == token + 5);
+    TEST(changes.size() == 1);
+    TEST(changes[0].iType == TrackDbChange::eClear);
+}
+
+void SuiteTrackDatabase::GetChangesCurrentToken()
+{
+    TUint id;
+    iTrackDatabase->Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), id);
+    TUint token;
+    iTrackDatabase->GetIdArray(iIdArray, token);
+    std::vector<TrackDbChange> changes;
+    TUint seq;
+    TEST(iTrackDatabase->GetChanges(token, changes, seq));
+    TEST(seq == token);
+    TEST(changes.size() == 0);
+    // tokens the database hasn't issued yet are rejected
+    TEST(!iTrackDatabase->GetChanges(token + 1, changes, seq));
+    TEST(changes.size() == 0);
+}
+
+void SuiteTrackDatabase::GetChangesTokenExpired()
+{
+    TUint token;
+    iTrackDatabase->GetIdArray(iIdArray, token);
+    TUint id;
+    for (TUint i=0; i<1100; i++) {
+        iTrackDatabase->Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), id);
+        iTrackDatabase->DeleteId(id);
+    }
+    std::vector<TrackDbChange> changes;
+    TUint seq;
+    TEST(!iTrackDatabase->GetChanges(token, changes, seq));
+    TEST(seq == token + 2200);
+    // the most recent changes are still available
+    TEST(iTrackDatabase->GetChanges(seq - 2, changes, seq));
+    TEST(changes.size() == 2);
+    TEST(changes[0].iType == TrackDbChange::eInsert);
+    TEST(changes[0].iId == id);
+    TEST(changes[1].iType == TrackDbChange::eDelete);
+    TEST(changes[1].iId == id);
+}
+
 void SuiteTrackDatabase::GetTrackByValidId()
 {
     TUint id;
@@ -718,6 +860,10 @@ SuiteShuffler::SuiteShuffler()
     AddTest(MakeFunctor(*this, &SuiteShuffler::TrackRefByIndexSortedShuffleOn), "TrackRefByIndexSortedShuffleOn");
     AddTest(MakeFunctor(*this, &SuiteShuffler::ModeToggleReshuffles), "ModeToggleReshuffles");
     AddTest(MakeFunctor(*this, &SuiteShuffler::NextTrackBeyondEndReshuffles), "NextTrackBeyondEndReshuffles");
+    AddTest(MakeFunctor(*this, &SuiteShuffler::PeekNextTrackLeavesShuffle), "PeekNextTrackLeavesShuffle");
+    AddTest(MakeFunctor(*this, &SuiteShuffler::SeededShuffleRepeats), "SeededShuffleRepeats");
+    AddTest(MakeFunctor(*this, &SuiteShuffler::InsertedTrackNotYetPlayed), "InsertedTrackNotYetPlayed");
+    AddTest(MakeFunctor(*this, &SuiteShuffler::MoveToStartPlaysNext), "MoveToStartPlaysNext");
 }
 
 void SuiteShuffler::Setup()
@@ -842,7 +988,7 @@ void SuiteShuffler::PrevTrackRefShuffleOn()
     iShuffler->SetShuffle(true);
 
     // find id of last shuffled track
-    TUint id = iShuffler->iShuffleList[iShuffler->iShuffleList.size()-1]->Id();
+    TUint id = iShuffler->iShuffleList.At(iShuffler->iShuffleList.Count()-1)->Id();
 
     TBool shuffled = false;
     for (TInt i=kNumTracks-1; i>=0; i--) {
@@ -926,7 +1072,7 @@ void SuiteShuffler::TrackRefByIndexSortedShuffleOn()
     for (TUint i=0; i<kNumTracks; i++) {
         track = iReader->TrackRefByIndexSorted(i);
         TEST(track != nullptr);
-        TEST(track->Id() == iShuffler->iShuffleList[i]->Id());
+        TEST(track->Id() == iShuffler->iShuffleList.At(i)->Id());
         track->RemoveRef();
     }
     track = iReader->TrackRefByIndexSorted(kNumTracks+1);
@@ -986,6 +1132,132 @@ void SuiteShuffler::NextTrackBeyondEndReshuffles()
     TEST(reshuffled);
 }
 
+void SuiteShuffler::PeekNextTrackLeavesShuffle()
+{
+    iShuffler->SetShuffle(true);
+    std::vector<TUint32> before;
+    ShuffledIds(before);
+
+    // peeking past the end of the list returns nullptr rather than reshuffling
+    TUint id = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<kNumTracks; i++) {
+        Track* track = iReader->PeekNextTrackRef(id);
+        TEST(track->Id() == before[i]);
+        id = track->Id();
+        track->RemoveRef();
+    }
+    TEST(iReader->PeekNextTrackRef(id) == nullptr);
+    std::vector<TUint32> after;
+    ShuffledIds(after);
+    TEST(after == before);
+
+    // NextTrackRef still follows the order that was peeked
+    Track* track = iReader->NextTrackRef(ITrackDatabase::kTrackIdNone);
+    TEST(track->Id() == before[0]);
+    track->RemoveRef();
+}
+
+void SuiteShuffler::ShuffledIds(std::vector<TUint32>& aIds)
+{
+    iShuffler->iShuffleList.CopyIds(aIds, 0);
+}
+
+void SuiteShuffler::SeededShuffleRepeats()
+{
+    /* A second database given the same tracks and edits should be shuffled identically.
+       Track ids are unique across databases so orders are compared by the sequence in which
+       tracks were inserted. */
+    TrackDatabase* db = new TrackDatabase(*iTrackFactory);
+    Shuffler* shuffler = new Shuffler(*gEnv, *db);
+    shuffler->SetObserver(*this);
+    std::vector<TUint> inserted[2];
+    inserted[0].assign(iIds.begin(), iIds.end());
+    TUint insertAfter = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<kNumTracks; i++) {
+        static_cast<ITrackDatabase*>(db)->Insert(insertAfter, Brx::Empty(), Brx::Empty(), insertAfter);
+        inserted[1].push_back(insertAfter);
+    }
+    Shuffler* shufflers[] = { iShuffler, shuffler };
+    ITrackDatabase* writers[] = { iDb, db };
+    std::vector<TUint> orders[2];
+    auto order = [&](TUint aIndex) {
+        std::vector<TUint32> ids;
+        shufflers[aIndex]->iShuffleList.CopyIds(ids, 0);
+        orders[aIndex].clear();
+        for (auto id : ids) {
+            auto it = std::find(inserted[aIndex].begin(), inserted[aIndex].end(), id);
+            orders[aIndex].push_back(it - inserted[aIndex].begin());
+        }
+    };
+    for (TUint i=0; i<2; i++) {
+        shufflers[i]->SetSeed(1234);
+        shufflers[i]->SetShuffle(true);
+        for (TUint j=0; j<kNumTracks; j++) {
+            TUint id;
+            writers[i]->Insert(ITrackDatabase::kTrackIdNone, Brx::Empty(), Brx::Empty(), id);
+            inserted[i].push_back(id);
+        }
+        order(i);
+    }
+    TEST(orders[0] == orders[1]);
+
+    shuffler->SetSeed(4321);
+    shuffler->Reshuffle();
+    order(1);
+    TEST(orders[0] != orders[1]);
+
+    delete shuffler;
+    delete db;
+}
+
+void SuiteShuffler::InsertedTrackNotYetPlayed()
+{
+    iShuffler->SetShuffle(true);
+    TUint id = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<kNumTracks/2; i++) {
+        Track* track = iReader->NextTrackRef(id);
+        id = track->Id();
+        track->RemoveRef();
+    }
+    const TUint current = id;
+    ITrackDatabase* writer = static_cast<ITrackDatabase*>(iDb);
+    for (TUint i=0; i<50; i++) {
+        TUint idNew;
+        writer->Insert(iIds[0], Brx::Empty(), Brx::Empty(), idNew);
+        std::vector<TUint32> ids;
+        ShuffledIds(ids);
+        const auto itCurrent = std::find(ids.begin(), ids.end(), current);
+        const auto itNew = std::find(ids.begin(), ids.end(), idNew);
+        TEST(itCurrent != ids.end());
+        TEST(itNew != ids.end());
+        TEST(itNew > itCurrent);
+    }
+}
+
+void SuiteShuffler::MoveToStartPlaysNext()
+{
+    TEST(!iShuffler->TryMoveToStart(iIds[0])); // no effect unless shuffling
+    iShuffler->SetShuffle(true);
+    std::vector<TUint32> initial;
+    ShuffledIds(initial);
+    TUint id = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<4; i++) {
+        Track* track = iReader->NextTrackRef(id);
+        id = track->Id();
+        track->RemoveRef();
+    }
+    TEST(id == initial[3]);
+
+    const TUint moved = initial[kNumTracks-1];
+    TEST(iShuffler->TryMoveToStart(moved));
+    std::vector<TUint32> expected(initial.begin(), initial.begin() + 3);
+    expected.push_back(moved);
+    expected.insert(expected.end(), initial.begin() + 3, initial.end() - 1);
+    std::vector<TUint32> ids;
+    ShuffledIds(ids);
+    TEST(ids == expected);
+}
+
 
 // SuiteRepeater
 
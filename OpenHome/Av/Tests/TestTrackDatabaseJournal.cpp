@@ -0,0 +1,322 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Playlist/TrackDatabase.h>
+#include <OpenHome/Av/Playlist/TrackDatabaseJournal.h>
+#include <OpenHome/Configuration/Tests/ConfigRamStore.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Private/Ascii.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+using namespace OpenHome::Configuration;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Av {
+
+class SuiteTrackDatabaseJournal : public SuiteUnitTest
+{
+    static const TUint kMaxTracks = 2000;
+    static const Brn kKeyPrefix;
+public:
+    SuiteTrackDatabaseJournal();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Boot();     // creates a database, restoring it from iStore
+    void Shutdown(); // flushes then destroys the current database
+    TUint Insert(TUint aIdAfter, TUint aUri, TUint aMetaDataBytes = 16);
+    TBool Matches(const std::vector<TUint>& aUris);
+    void ReadHeader(Bwx& aHeader);
+    void TestEmptyStore();
+    void TestRestoreInserts();
+    void TestRestoreDeletes();
+    void TestRestoreClear();
+    void TestRestoreRepeatedly();
+    void TestRestoreDoesNotCompact();
+    void TestCompaction();
+    void TestRestoreLimitedByCapacity();
+    void TestLargePlaylist();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    ConfigRamStore* iStore;
+    TrackFactory* iTrackFactory;
+    TrackDatabase* iDb;
+    ITrackDatabase* iTrackDatabase;
+    TrackDatabaseJournal* iJournal;
+    TUint iMaxTracks;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteTrackDatabaseJournal
+
+const Brn SuiteTrackDatabaseJournal::kKeyPrefix("Test.Tracks");
+
+SuiteTrackDatabaseJournal::SuiteTrackDatabaseJournal()
+    : SuiteUnitTest("SuiteTrackDatabaseJournal")
+{
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabaseJournal::TestEmptyStore), "TestEmptyStore");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabaseJournal::TestRestoreInserts), "TestRestoreInserts");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabaseJournal::TestRestoreDeletes), "TestRestoreDeletes");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabaseJournal::TestRestoreClear), "TestRestoreClear");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabaseJournal::TestRestoreRepeatedly), "TestRestoreRepeatedly");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabaseJournal::TestRestoreDoesNotCompact), "TestRestoreDoesNotCompact");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabaseJournal::TestCompaction), "TestCompaction");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabaseJournal::TestRestoreLimitedByCapacity), "TestRestoreLimitedByCapacity");
+    AddTest(MakeFunctor(*this, &SuiteTrackDatabaseJournal::TestLargePlaylist), "TestLargePlaylist");
+}
+
+void SuiteTrackDatabaseJournal::Setup()
+{
+    iStore = new ConfigRamStore();
+    iDb = nullptr;
+    iJournal = nullptr;
+    iMaxTracks = kMaxTracks;
+    Boot();
+}
+
+void SuiteTrackDatabaseJournal::TearDown()
+{
+    Shutdown();
+    delete iStore;
+}
+
+void SuiteTrackDatabaseJournal::Boot()
+{
+    // a new factory restarts track ids from 1, as happens after a real reboot
+    iTrackFactory = new TrackFactory(iInfoAggregator, kMaxTracks);
+    iDb = new TrackDatabase(*iTrackFactory, iMaxTracks);
+    iTrackDatabase = static_cast<ITrackDatabase*>(iDb);
+    iJournal = new TrackDatabaseJournal(*iStore, *iTrackDatabase, kKeyPrefix);
+    iJournal->Start();
+    iJournal->Flush();
+}
+
+void SuiteTrackDatabaseJournal::Shutdown()
+{
+    iJournal->Flush();
+    delete iJournal;
+    iJournal = nullptr;
+    delete iDb;
+    iDb = nullptr;
+    delete iTrackFactory;
+}
+
+TUint SuiteTrackDatabaseJournal::Insert(TUint aIdAfter, TUint aUri, TUint aMetaDataBytes)
+{
+    Bws<32> uri("uri");
+    Ascii::AppendDec(uri, aUri);
+    Bwh metaData(aMetaDataBytes);
+    metaData.Replace(uri);
+    while (metaData.Bytes() < aMetaDataBytes) {
+        metaData.Append('m');
+    }
+    TUint id;
+    iTrackDatabase->Insert(aIdAfter, uri, metaData, id);
+    return id;
+}
+
+TBool SuiteTrackDatabaseJournal::Matches(const std::vector<TUint>& aUris)
+{
+    std::vector<TUint32> ids;
+    TUint seq;
+    iTrackDatabase->GetIdArray(ids, seq);
+    if (ids.size() != aUris.size()) {
+        return false;
+    }
+    for (TUint i=0; i<ids.size(); i++) {
+        Bws<32> uri("uri");
+        Ascii::AppendDec(uri, aUris[i]);
+        Track* track;
+        iTrackDatabase->GetTrackById(ids[i], track);
+        const TBool match = (track->Uri() == uri && track->MetaData().BeginsWith(uri));
+        track->RemoveRef();
+        if (!match) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SuiteTrackDatabaseJournal::ReadHeader(Bwx& aHeader)
+{
+    Bws<64> key(kKeyPrefix);
+    key.Append(".Header");
+    iStore->Read(key, aHeader);
+}
+
+void SuiteTrackDatabaseJournal::TestEmptyStore()
+{
+    TEST(iTrackDatabase->TrackCount() == 0);
+    Shutdown();
+    Boot();
+    TEST(iTrackDatabase->TrackCount() == 0);
+}
+
+void SuiteTrackDatabaseJournal::TestRestoreInserts()
+{
+    const TUint id1 = Insert(ITrackDatabase::kTrackIdNone, 1);
+    const TUint id2 = Insert(id1, 2, 1000);
+    (void)Insert(ITrackDatabase::kTrackIdNone, 3);
+    (void)Insert(id2, 4);
+    TEST(Matches({3, 1, 2, 4}));
+    Shutdown();
+    Boot();
+    TEST(Matches({3, 1, 2, 4}));
+}
+
+void SuiteTrackDatabaseJournal::TestRestoreDeletes()
+{
+    TUint ids[5];
+    TUint idAfter = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<5; i++) {
+        ids[i] = idAfter = Insert(idAfter, i);
+    }
+    iTrackDatabase->DeleteId(ids[0]);
+    iTrackDatabase->DeleteId(ids[3]);
+    Shutdown();
+    Boot();
+    TEST(Matches({1, 2, 4}));
+}
+
+void SuiteTrackDatabaseJournal::TestRestoreClear()
+{
+    (void)Insert(ITrackDatabase::kTrackIdNone, 1);
+    (void)Insert(ITrackDatabase::kTrackIdNone, 2);
+    iTrackDatabase->DeleteAll();
+    (void)Insert(ITrackDatabase::kTrackIdNone, 3);
+    Shutdown();
+    Boot();
+    TEST(Matches({3}));
+
+    iTrackDatabase->DeleteAll();
+    Shutdown();
+    Boot();
+    TEST(iTrackDatabase->TrackCount() == 0);
+}
+
+void SuiteTrackDatabaseJournal::TestRestoreRepeatedly()
+{
+    // restored tracks are given new ids; edits after a restore must still apply to them
+    TUint idAfter = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<4; i++) {
+        idAfter = Insert(idAfter, i);
+    }
+    Shutdown();
+    Boot();
+    TEST(Matches({0, 1, 2, 3}));
+    std::vector<TUint32> ids;
+    TUint seq;
+    iTrackDatabase->GetIdArray(ids, seq);
+    iTrackDatabase->DeleteId(ids[1]);
+    (void)Insert(ids[2], 4);
+    Shutdown();
+    Boot();
+    TEST(Matches({0, 2, 4, 3}));
+    iTrackDatabase->GetIdArray(ids, seq);
+    iTrackDatabase->DeleteId(ids[0]);
+    Shutdown();
+    Boot();
+    TEST(Matches({2, 4, 3}));
+}
+
+void SuiteTrackDatabaseJournal::TestRestoreDoesNotCompact()
+{
+    // a compaction switches slot so an unchanged header shows that restoring didn't rewrite the store
+    TUint idAfter = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<4; i++) {
+        idAfter = Insert(idAfter, i);
+    }
+    Shutdown();
+    Bws<12> header1;
+    ReadHeader(header1);
+    Boot();
+    TEST(Matches({0, 1, 2, 3}));
+    (void)Insert(ITrackDatabase::kTrackIdNone, 4);
+    Shutdown();
+    Boot();
+    TEST(Matches({4, 0, 1, 2, 3}));
+    Shutdown();
+    Bws<12> header2;
+    ReadHeader(header2);
+    TEST(header1 == header2);
+    Boot();
+}
+
+void SuiteTrackDatabaseJournal::TestCompaction()
+{
+    // write several times more journal than the compaction threshold, flushing as we go
+    std::vector<TUint> expected;
+    TUint idAfter = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<600; i++) {
+        const TUint id = Insert(idAfter, i, 4000);
+        if (i % 3 == 0) {
+            idAfter = id;
+            expected.push_back(i);
+        }
+        else {
+            iTrackDatabase->DeleteId(id);
+        }
+        if (i % 50 == 0) {
+            iJournal->Flush();
+        }
+    }
+    TEST(Matches(expected));
+    Shutdown();
+    Boot();
+    TEST(Matches(expected));
+}
+
+void SuiteTrackDatabaseJournal::TestRestoreLimitedByCapacity()
+{
+    for (TUint i=0; i<10; i++) {
+        (void)Insert(ITrackDatabase::kTrackIdNone, i);
+    }
+    Shutdown();
+    iMaxTracks = 4;
+    Boot();
+    TEST(Matches({9, 8, 7, 6}));
+}
+
+void SuiteTrackDatabaseJournal::TestLargePlaylist()
+{
+    std::vector<TUint> expected;
+    TUint idAfter = ITrackDatabase::kTrackIdNone;
+    for (TUint i=0; i<kMaxTracks; i++) {
+        idAfter = Insert(idAfter, i, 200);
+        expected.push_back(i);
+    }
+    Shutdown();
+    Boot();
+    TEST(Matches(expected));
+
+    // edits after restoring a playlist that needs several renumber records
+    std::vector<TUint32> ids;
+    TUint seq;
+    iTrackDatabase->GetIdArray(ids, seq);
+    iTrackDatabase->DeleteId(ids[1500]);
+    const TUint uri = kMaxTracks;
+    (void)Insert(ids[0], uri);
+    expected.erase(expected.begin() + 1500);
+    expected.insert(expected.begin() + 1, uri);
+    Shutdown();
+    Boot();
+    TEST(Matches(expected));
+}
+
+
+
+void TestTrackDatabaseJournal()
+{
+    Runner runner("TrackDatabaseJournal tests\n");
+    runner.Add(new SuiteTrackDatabaseJournal());
+    runner.Run();
+}
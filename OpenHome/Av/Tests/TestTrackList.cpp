@@ -0,0 +1,304 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Playlist/TrackList.h>
+
+#include <climits>
+#include <vector>
+#include <algorithm>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class TestListItem
+{
+public:
+    TestListItem(TUint aId) : iId(aId) {}
+    TUint Id() const { return iId; }
+private:
+    TUint iId;
+};
+
+class SuiteTrackList : public SuiteUnitTest
+{
+    static const TUint kMaxItems = 100000;
+public:
+    SuiteTrackList();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    TestListItem& Item(TUint aId);
+    TBool Matches(const std::vector<TUint>& aExpected);
+    TUint NextRandom();
+    void TestEmpty();
+    void TestAppend();
+    void TestInsertAtStart();
+    void TestInsertInMiddle();
+    void TestRemove();
+    void TestRemoveInvalid();
+    void TestClear();
+    void TestAssign();
+    void TestCopyIdsIncremental();
+    void TestRandomOperations();
+    void TestLargeList();
+private:
+    TrackList<TestListItem>* iList;
+    std::vector<TestListItem*> iItems;
+    TUint iRandom;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteTrackList
+
+SuiteTrackList::SuiteTrackList()
+    : SuiteUnitTest("SuiteTrackList")
+{
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestEmpty), "TestEmpty");
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestAppend), "TestAppend");
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestInsertAtStart), "TestInsertAtStart");
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestInsertInMiddle), "TestInsertInMiddle");
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestRemove), "TestRemove");
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestRemoveInvalid), "TestRemoveInvalid");
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestClear), "TestClear");
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestAssign), "TestAssign");
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestCopyIdsIncremental), "TestCopyIdsIncremental");
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestRandomOperations), "TestRandomOperations");
+    AddTest(MakeFunctor(*this, &SuiteTrackList::TestLargeList), "TestLargeList");
+}
+
+void SuiteTrackList::Setup()
+{
+    iList = new TrackList<TestListItem>();
+    iItems.reserve(kMaxItems + 1);
+    for (TUint i=0; i<=kMaxItems; i++) {
+        iItems.push_back(new TestListItem(i));
+    }
+    iRandom = 12345;
+}
+
+void SuiteTrackList::TearDown()
+{
+    delete iList;
+    for (auto item : iItems) {
+        delete item;
+    }
+    iItems.clear();
+}
+
+TestListItem& SuiteTrackList::Item(TUint aId)
+{
+    return *iItems[aId];
+}
+
+TBool SuiteTrackList::Matches(const std::vector<TUint>& aExpected)
+{
+    if (iList->Count() != aExpected.size()) {
+        return false;
+    }
+    std::vector<TUint32> ids;
+    iList->CopyIds(ids, 0);
+    for (TUint i=0; i<aExpected.size(); i++) {
+        TUint index = UINT_MAX;
+        if (ids[i] != aExpected[i]
+            || iList->At(i) != &Item(aExpected[i])
+            || !iList->TryGetIndex(aExpected[i], index)
+            || index != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TUint SuiteTrackList::NextRandom()
+{
+    iRandom = iRandom * 1103515245 + 12345;
+    return iRandom >> 8;
+}
+
+void SuiteTrackList::TestEmpty()
+{
+    TEST(iList->Count() == 0);
+    TEST(iList->Find(1) == nullptr);
+    TEST(iList->At(0) == nullptr);
+    TUint index;
+    TEST(!iList->TryGetIndex(1, index));
+    std::vector<TUint32> ids(3, 1);
+    iList->CopyIds(ids, 0);
+    TEST(ids.size() == 0);
+}
+
+void SuiteTrackList::TestAppend()
+{
+    for (TUint i=1; i<=10; i++) {
+        iList->Insert(iList->Count(), Item(i));
+    }
+    TEST(Matches({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}));
+    TEST(iList->Find(5) == &Item(5));
+    TEST(iList->At(10) == nullptr);
+}
+
+void SuiteTrackList::TestInsertAtStart()
+{
+    for (TUint i=1; i<=5; i++) {
+        iList->Insert(0, Item(i));
+    }
+    TEST(Matches({5, 4, 3, 2, 1}));
+}
+
+void SuiteTrackList::TestInsertInMiddle()
+{
+    iList->Insert(0, Item(1));
+    iList->Insert(1, Item(2));
+    iList->Insert(1, Item(3));
+    iList->Insert(2, Item(4));
+    TEST(Matches({1, 3, 4, 2}));
+}
+
+void SuiteTrackList::TestRemove()
+{
+    for (TUint i=1; i<=6; i++) {
+        iList->Insert(iList->Count(), Item(i));
+    }
+    TEST(iList->Remove(3) == &Item(3));
+    TEST(Matches({1, 2, 4, 5, 6}));
+    TEST(iList->Remove(1) == &Item(1));
+    TEST(Matches({2, 4, 5, 6}));
+    TEST(iList->Remove(6) == &Item(6));
+    TEST(Matches({2, 4, 5}));
+    TEST(iList->Find(6) == nullptr);
+    // a removed item may be inserted again
+    iList->Insert(0, Item(6));
+    TEST(Matches({6, 2, 4, 5}));
+}
+
+void SuiteTrackList::TestRemoveInvalid()
+{
+    TEST(iList->Remove(1) == nullptr);
+    iList->Insert(0, Item(1));
+    TEST(iList->Remove(2) == nullptr);
+    TEST(Matches({1}));
+}
+
+void SuiteTrackList::TestClear()
+{
+    for (TUint i=1; i<=4; i++) {
+        iList->Insert(0, Item(i));
+    }
+    iList->Clear();
+    TEST(iList->Count() == 0);
+    TEST(iList->Find(1) == nullptr);
+    iList->Insert(0, Item(1));
+    TEST(Matches({1}));
+}
+
+void SuiteTrackList::TestAssign()
+{
+    iList->Insert(0, Item(1));
+    std::vector<TestListItem*> items;
+    iList->Assign(items);
+    TEST(iList->Count() == 0);
+
+    std::vector<TUint> expected;
+    for (TUint i=1; i<=1000; i++) {
+        const TUint id = (i * 7919) % 1000 + 1; // each of 1..1000 once, in a scrambled order
+        items.push_back(&Item(id));
+        expected.push_back(id);
+    }
+    iList->Assign(items);
+    TEST(Matches(expected));
+    // the list remains fully usable
+    TEST(iList->Remove(expected[500]) == &Item(expected[500]));
+    expected.erase(expected.begin() + 500);
+    iList->Insert(10, Item(1001));
+    expected.insert(expected.begin() + 10, 1001);
+    TEST(Matches(expected));
+}
+
+void SuiteTrackList::TestCopyIdsIncremental()
+{
+    for (TUint i=1; i<=4; i++) {
+        iList->Insert(iList->Count(), Item(i));
+    }
+    std::vector<TUint32> ids;
+    iList->CopyIds(ids, 0);
+    iList->Insert(4, Item(5));
+    iList->Insert(5, Item(6));
+    ids[0] = 99; // entries before aFrom are left alone
+    iList->CopyIds(ids, 4);
+    TEST(ids.size() == 6);
+    TEST(ids[0] == 99);
+    TEST(ids[1] == 2 && ids[2] == 3 && ids[3] == 4);
+    TEST(ids[4] == 5 && ids[5] == 6);
+
+    iList->Remove(6);
+    iList->CopyIds(ids, 5);
+    TEST(ids.size() == 5);
+    TEST(ids[4] == 5);
+}
+
+void SuiteTrackList::TestRandomOperations()
+{
+    // compare against a vector over a long run of mixed operations
+    std::vector<TUint> expected;
+    std::vector<TUint> absent;
+    for (TUint i=1; i<=1000; i++) {
+        absent.push_back(i);
+    }
+    TBool ok = true;
+    for (TUint i=0; i<20000 && ok; i++) {
+        const TBool insert = (expected.size() == 0 || (absent.size() > 0 && NextRandom() % 3 != 0));
+        if (insert) {
+            const TUint absentIndex = NextRandom() % absent.size();
+            const TUint id = absent[absentIndex];
+            absent.erase(absent.begin() + absentIndex);
+            const TUint index = NextRandom() % (expected.size() + 1);
+            iList->Insert(index, Item(id));
+            expected.insert(expected.begin() + index, id);
+        }
+        else {
+            const TUint index = NextRandom() % expected.size();
+            const TUint id = expected[index];
+            ok = (iList->Remove(id) == &Item(id));
+            expected.erase(expected.begin() + index);
+            absent.push_back(id);
+        }
+        if (i % 500 == 0) {
+            ok = ok && Matches(expected);
+        }
+    }
+    TEST(ok);
+    TEST(Matches(expected));
+}
+
+void SuiteTrackList::TestLargeList()
+{
+    std::vector<TUint> expected;
+    expected.reserve(kMaxItems);
+    for (TUint i=1; i<=kMaxItems; i++) {
+        const TUint index = (i % 4 == 0? NextRandom() % (iList->Count() + 1) : iList->Count());
+        iList->Insert(index, Item(i));
+        expected.insert(expected.begin() + index, i);
+    }
+    TEST(Matches(expected));
+    for (TUint i=1; i<=kMaxItems; i+=3) {
+        iList->Remove(i);
+    }
+    expected.erase(std::remove_if(expected.begin(), expected.end(), [](TUint aId) { return aId % 3 == 1; }), expected.end());
+    TEST(Matches(expected));
+}
+
+
+
+void TestTrackList()
+{
+    Runner runner("TrackList tests\n");
+    runner.Add(new SuiteTrackList());
+    runner.Run();
+}
@@ -66,6 +66,128 @@ void SuiteMsgUdp::TestRead()
 }
 
 
+// SuiteUdpPacketRing
+class SuiteUdpPacketRing : public SuiteUnitTest, public INonCopyable
+{
+public:
+    SuiteUdpPacketRing();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestEmpty();
+    void TestWriteRead();
+    void TestFull();
+    void TestWrapAround();
+    void TestClear();
+private:
+    static const TUint kMaxMsgSize = 64;
+    static const TUint kMaxMsgCount = 4;
+    UdpPacketRing* iRing;
+};
+
+SuiteUdpPacketRing::SuiteUdpPacketRing()
+    : SuiteUnitTest("SuiteUdpPacketRing")
+{
+    AddTest(MakeFunctor(*this, &SuiteUdpPacketRing::TestEmpty), "TestEmpty");
+    AddTest(MakeFunctor(*this, &SuiteUdpPacketRing::TestWriteRead), "TestWriteRead");
+    AddTest(MakeFunctor(*this, &SuiteUdpPacketRing::TestFull), "TestFull");
+    AddTest(MakeFunctor(*this, &SuiteUdpPacketRing::TestWrapAround), "TestWrapAround");
+    AddTest(MakeFunctor(*this, &SuiteUdpPacketRing::TestClear), "TestClear");
+}
+
+void SuiteUdpPacketRing::Setup()
+{
+    iRing = new UdpPacketRing(kMaxMsgSize, kMaxMsgCount);
+}
+
+void SuiteUdpPacketRing::TearDown()
+{
+    delete iRing;
+}
+
+void SuiteUdpPacketRing::TestEmpty()
+{
+    TUint64 timeUs;
+    TEST(iRing->Slots() == kMaxMsgCount);
+    TEST(iRing->SlotsUsed() == 0);
+    TEST(iRing->TryRead(timeUs) == nullptr);
+    TEST(iRing->WriteSlot().Buffer().Bytes() == 0);
+}
+
+void SuiteUdpPacketRing::TestWriteRead()
+{
+    // packets are only visible to the reader once committed, and are read in place
+    MsgUdp* written = &iRing->WriteSlot();
+    TUint64 timeUs = 0;
+    TEST(iRing->TryRead(timeUs) == nullptr);
+    TEST(iRing->TryWriteCommit(123));
+    TEST(iRing->SlotsUsed() == 1);
+    TEST(&iRing->WriteSlot() != written);
+
+    TEST(iRing->TryRead(timeUs) == written);
+    TEST(timeUs == 123);
+    TEST(iRing->SlotsUsed() == 1); // not released until ReadCommit()
+    iRing->ReadCommit();
+    TEST(iRing->SlotsUsed() == 0);
+    TEST(iRing->TryRead(timeUs) == nullptr);
+}
+
+void SuiteUdpPacketRing::TestFull()
+{
+    for (TUint i=0; i<kMaxMsgCount; i++) {
+        TEST(iRing->TryWriteCommit(i));
+    }
+    TEST(iRing->SlotsUsed() == kMaxMsgCount);
+
+    // writer keeps its slot when the ring is full; the next packet overwrites it
+    MsgUdp* scratch = &iRing->WriteSlot();
+    TEST(!iRing->TryWriteCommit(kMaxMsgCount));
+    TEST(&iRing->WriteSlot() == scratch);
+    TEST(iRing->SlotsUsed() == kMaxMsgCount);
+
+    TUint64 timeUs;
+    for (TUint i=0; i<kMaxMsgCount; i++) {
+        TEST(iRing->TryRead(timeUs) != scratch);
+        TEST(timeUs == i);
+        iRing->ReadCommit();
+    }
+    TEST(iRing->TryRead(timeUs) == nullptr);
+    TEST_THROWS(iRing->ReadCommit(), AssertionFailed);
+}
+
+void SuiteUdpPacketRing::TestWrapAround()
+{
+    TUint64 timeUs;
+    for (TUint i=0; i<kMaxMsgCount*3; i++) {
+        MsgUdp* written = &iRing->WriteSlot();
+        TEST(iRing->TryWriteCommit(i));
+        TEST(iRing->TryWriteCommit(i+1000));
+        TEST(iRing->TryRead(timeUs) == written);
+        TEST(timeUs == i);
+        iRing->ReadCommit();
+        TEST(iRing->TryRead(timeUs) != nullptr);
+        TEST(timeUs == i+1000);
+        iRing->ReadCommit();
+    }
+    TEST(iRing->SlotsUsed() == 0);
+}
+
+void SuiteUdpPacketRing::TestClear()
+{
+    TEST(iRing->TryWriteCommit(1));
+    TEST(iRing->TryWriteCommit(2));
+    iRing->Clear();
+    TUint64 timeUs;
+    TEST(iRing->SlotsUsed() == 0);
+    TEST(iRing->TryRead(timeUs) == nullptr);
+    for (TUint i=0; i<kMaxMsgCount; i++) {
+        TEST(iRing->TryWriteCommit(i));
+    }
+    TEST(iRing->SlotsUsed() == kMaxMsgCount);
+}
+
+
 // SuiteSocketUdpServer
 
 /**
@@ -106,6 +228,7 @@ private:
     void TestSend();
     void TestPort();
     void TestSender();
+    void TestStats();
     //void TestSubnetChanged();
 private:
     static const TUint kUdpRecvBufSize = 8192;
@@ -151,6 +274,7 @@ SuiteSocketUdpServer::SuiteSocketUdpServer(Environment& aEnv, TIpAddress aInterf
     AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestSend), "TestSend");
     AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestPort), "TestPort");
     AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestSender), "TestSender");
+    AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestStats), "TestStats");
     //AddTest(MakeFunctor(*this, &SuiteSocketUdpServer::TestSubnetChanged));
 }
 
@@ -473,6 +597,11 @@ void SuiteSocketUdpServer::TestMsgsDisposedCapacityExceeded()
         CheckMsgValue(iInBuf, iMsgCount++);
         ASSERT(notDisposed < kDisposedCount);
     }
+
+    SocketUdpServer::Stats stats;
+    iServer->GetStats(stats);
+    TEST(stats.iOverflows > 0);
+    TEST(stats.iMaxQueued == kMaxMsgCount);
 }
 
 void SuiteSocketUdpServer::TestSend()
@@ -531,6 +660,36 @@ void SuiteSocketUdpServer::TestSender()
     TEST(ep.Port() == expected.Port());
 }
 
+void SuiteSocketUdpServer::TestStats()
+{
+    SocketUdpServer::Stats stats;
+    iServer->GetStats(stats);
+    TEST(stats.iReceived == 0);
+    TEST(stats.iDiscarded == 0);
+    TEST(stats.iOverflows == 0);
+    TEST(stats.iLatencyAvgUs == 0);
+
+    iServer->Open();
+    for (TUint i=0; i<kDisposedCount; i++) {
+        SendNextMsg(iOutBuf);
+        iServer->Read(iInBuf);
+        CheckMsgValue(iInBuf, iMsgCount++);
+    }
+    iServer->GetStats(stats);
+    TEST(stats.iReceived == kDisposedCount);
+    TEST(stats.iOverflows == 0);
+    TEST(stats.iMaxQueued >= 1);
+    TEST(stats.iLatencyAvgUs <= stats.iLatencyMaxUs);
+
+    iServer->Close();
+    for (TUint i=0; i<kDisposedCount; i++) {
+        SendNextMsg(iOutBuf);
+    }
+    iServer->GetStats(stats);
+    TEST(stats.iDiscarded > 0);
+    TEST(stats.iReceived == kDisposedCount);
+}
+
 //void SuiteSocketUdpServer::TestSubnetChanged()
 //{
 //    // test that attempting to change the subnet adapter succeeds.
@@ -652,6 +811,7 @@ void TestUdpServer(Environment& aEnv)
 
     Runner runner("UdpServer tests");
     runner.Add(new SuiteMsgUdp(aEnv, current->Address()));
+    runner.Add(new SuiteUdpPacketRing());
     runner.Add(new SuiteSocketUdpServer(aEnv, current->Address()));
     runner.Add(new SuiteUdpServerManager(aEnv, current->Address()));
     runner.Run();
@@ -0,0 +1,210 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Radio/UriRacer.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Net/Private/Globals.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+namespace OpenHome {
+namespace Av {
+
+class RacerSession : public SocketTcpSession
+{
+private: // from SocketTcpSession
+    void Run() override {} // accepting the connection is all that's required
+};
+
+class SuiteUriRacer : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kMaxUriBytes = 64;
+public:
+    SuiteUriRacer(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void MakeUri(Bwx& aUri, TUint aPort, const TChar* aPath);
+    void GetStats();
+    void TestWinnerMovedToFront();
+    void TestFirstWinnerKeepsOrder();
+    void TestFailuresMovedToBack();
+    void TestSingleCandidateNotRaced();
+    void TestInterruptedNotRaced();
+private:
+    Environment& iEnv;
+    TIpAddress iAddr;
+    SocketTcpServer* iServer;
+    UriRacer* iRacer;
+    UriList* iUris;
+    Bws<kMaxUriBytes> iUriOpen;
+    Bws<kMaxUriBytes> iUriClosed;
+    Bws<kMaxUriBytes> iUriClosed2;
+    TUint iRaces;
+    TUint iReordered;
+    TUint iLost;
+    TUint iFailed;
+    TUint iCancelled;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+// SuiteUriRacer
+
+SuiteUriRacer::SuiteUriRacer(Environment& aEnv)
+    : SuiteUnitTest("SuiteUriRacer")
+    , iEnv(aEnv)
+{
+    AddTest(MakeFunctor(*this, &SuiteUriRacer::TestWinnerMovedToFront), "TestWinnerMovedToFront");
+    AddTest(MakeFunctor(*this, &SuiteUriRacer::TestFirstWinnerKeepsOrder), "TestFirstWinnerKeepsOrder");
+    AddTest(MakeFunctor(*this, &SuiteUriRacer::TestFailuresMovedToBack), "TestFailuresMovedToBack");
+    AddTest(MakeFunctor(*this, &SuiteUriRacer::TestSingleCandidateNotRaced), "TestSingleCandidateNotRaced");
+    AddTest(MakeFunctor(*this, &SuiteUriRacer::TestInterruptedNotRaced), "TestInterruptedNotRaced");
+}
+
+void SuiteUriRacer::Setup()
+{
+    std::vector<NetworkAdapter*>* ifs = Os::NetworkListAdapters(iEnv, Net::InitialisationParams::ELoopbackUse, "SuiteUriRacer");
+    iAddr = (*ifs)[0]->Address();
+    for (TUint i=0; i<ifs->size(); i++) {
+        (*ifs)[i]->RemoveRef("SuiteUriRacer");
+    }
+    delete ifs;
+
+    // find two ports nothing is listening on by briefly opening then closing servers
+    SocketTcpServer* server = new SocketTcpServer(iEnv, "URS1", 0, iAddr);
+    MakeUri(iUriClosed, server->Port(), "/closed");
+    SocketTcpServer* server2 = new SocketTcpServer(iEnv, "URS2", 0, iAddr);
+    MakeUri(iUriClosed2, server2->Port(), "/closed2");
+    delete server;
+    delete server2;
+
+    iServer = new SocketTcpServer(iEnv, "URS3", 0, iAddr);
+    iServer->Add("URS3", new RacerSession());
+    MakeUri(iUriOpen, iServer->Port(), "/open");
+
+    iRacer = new UriRacer(iEnv);
+    iUris = new UriList();
+}
+
+void SuiteUriRacer::TearDown()
+{
+    delete iUris;
+    delete iRacer;
+    delete iServer;
+}
+
+void SuiteUriRacer::MakeUri(Bwx& aUri, TUint aPort, const TChar* aPath)
+{
+    aUri.Replace("http://");
+    Endpoint endpoint(aPort, iAddr);
+    endpoint.AppendEndpoint(aUri);
+    aUri.Append(aPath);
+}
+
+void SuiteUriRacer::GetStats()
+{
+    iRacer->GetStats(iRaces, iReordered, iLost, iFailed, iCancelled);
+}
+
+void SuiteUriRacer::TestWinnerMovedToFront()
+{
+    iUris->Add(iUriClosed);
+    iUris->Add(Brn("/home/myaccount/album.flac"));
+    iUris->Add(iUriOpen);
+    iRacer->Race(*iUris);
+    TEST(iUris->Count() == 3);
+    TEST(iUris->At(0) == iUriOpen);
+    TEST(iRacer->Outcome(0) == UriRacer::eWon);
+    // the closed port may or may not have refused the connection before the race was decided
+    GetStats();
+    TEST(iRaces == 1);
+    TEST(iReordered == 1);
+    TEST(iFailed + iCancelled == 1);
+}
+
+void SuiteUriRacer::TestFirstWinnerKeepsOrder()
+{
+    iUris->Add(iUriOpen);
+    iUris->Add(iUriClosed);
+    iRacer->Race(*iUris);
+    TEST(iUris->At(0) == iUriOpen);
+    TEST(iUris->At(1) == iUriClosed);
+    TEST(iRacer->Outcome(0) == UriRacer::eWon);
+    GetStats();
+    TEST(iRaces == 1);
+    TEST(iReordered == 0);
+
+    // racer can be re-used
+    iUris->Clear();
+    iUris->Add(iUriClosed);
+    iUris->Add(iUriOpen);
+    iRacer->Race(*iUris);
+    TEST(iUris->At(0) == iUriOpen);
+    GetStats();
+    TEST(iRaces == 2);
+    TEST(iReordered == 1);
+}
+
+void SuiteUriRacer::TestFailuresMovedToBack()
+{
+    iUris->Add(iUriClosed);
+    iUris->Add(Brn("/home/myaccount/album.flac"));
+    iUris->Add(iUriClosed2);
+    iRacer->Race(*iUris);
+    TEST(iUris->At(0) == Brn("/home/myaccount/album.flac"));
+    TEST(iUris->At(1) == iUriClosed);
+    TEST(iUris->At(2) == iUriClosed2);
+    TEST(iRacer->Outcome(0) == UriRacer::eNotRaced);
+    TEST(iRacer->Outcome(1) == UriRacer::eFailed);
+    TEST(iRacer->Outcome(2) == UriRacer::eFailed);
+    GetStats();
+    TEST(iRaces == 1);
+    TEST(iReordered == 0);
+    TEST(iFailed == 2);
+}
+
+void SuiteUriRacer::TestSingleCandidateNotRaced()
+{
+    iUris->Add(iUriClosed);
+    iUris->Add(Brn("/home/myaccount/album.flac"));
+    iRacer->Race(*iUris);
+    TEST(iUris->At(0) == iUriClosed);
+    TEST(iRacer->Outcome(0) == UriRacer::eNotRaced);
+    GetStats();
+    TEST(iRaces == 0);
+}
+
+void SuiteUriRacer::TestInterruptedNotRaced()
+{
+    iRacer->Interrupt(true);
+    iUris->Add(iUriClosed);
+    iUris->Add(iUriOpen);
+    iRacer->Race(*iUris);
+    TEST(iUris->At(0) == iUriClosed);
+    TEST(iRacer->Outcome(0) == UriRacer::eNotRaced);
+    GetStats();
+    TEST(iRaces == 0);
+
+    iRacer->Interrupt(false);
+    iRacer->Race(*iUris);
+    TEST(iUris->At(0) == iUriOpen);
+    GetStats();
+    TEST(iRaces == 1);
+}
+
+
+
+void TestUriRacer(Environment& aEnv)
+{
+    Runner runner("UriRacer tests\n");
+    runner.Add(new SuiteUriRacer(aEnv));
+    runner.Run();
+}
@@ -0,0 +1,13 @@
+#include <OpenHome/Private/TestFramework.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+
+extern void TestUriRacer(OpenHome::Environment& aEnv);
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::Library* lib = new Net::Library(aInitParams);
+    TestUriRacer(lib->Env());
+    delete lib;
+}
@@ -12,6 +12,8 @@
 #include <OpenHome/Private/Parser.h>
 #include <OpenHome/Private/Ascii.h>
 #include <OpenHome/Av/Tidal/Tidal.h>
+#include <OpenHome/Av/TrackLookAhead.h>
+#include <OpenHome/Av/Utils/StreamUrlCache.h>
 #include <OpenHome/Media/SupplyAggregator.h>
         
 namespace OpenHome {
@@ -21,7 +23,8 @@ class ProtocolTidal : public Media::ProtocolNetwork, private IReader
 {
     static const TUint kTcpConnectTimeoutMs = 10 * 1000;
 public:
-    ProtocolTidal(Environment& aEnv, const Brx& aToken, Credentials& aCredentialsManager, Configuration::IConfigInitialiser& aConfigInitialiser);
+    ProtocolTidal(Environment& aEnv, const Brx& aToken, Credentials& aCredentialsManager,
+                  Configuration::IConfigInitialiser& aConfigInitialiser, ITrackLookAhead& aTrackLookAhead);
     ~ProtocolTidal();
 private: // from Media::Protocol
     void Initialise(Media::MsgFactory& aMsgFactory, Media::IPipelineElementDownstream& aDownstream) override;
@@ -38,7 +41,7 @@ private: // from IReader
     void ReadFlush() override;
     void ReadInterrupt() override;
 private:
-    static TBool TryGetTrackId(const Brx& aQuery, Bwx& aTrackId);
+    TBool TryGetStreamUrl(const Brx& aTrackUri);
     Media::ProtocolStreamResult DoStream();
     Media::ProtocolStreamResult DoSeek(TUint64 aOffset);
     TUint WriteRequest(TUint64 aOffset);
@@ -49,7 +52,7 @@ private:
     Tidal* iTidal;
     Media::SupplyAggregator* iSupply;
     Uri iUri;
-    Bws<12> iTrackId;
+    Bws<Tidal::kMaxTrackIdBytes> iTrackId;
     Bws<1024> iStreamUrl;
     Bws<64> iSessionId;
     WriterHttpRequest iWriterRequest;
@@ -80,14 +83,15 @@ using namespace OpenHome::Configuration;
 
 Protocol* ProtocolFactory::NewTidal(Environment& aEnv, const Brx& aToken, Av::IMediaPlayer& aMediaPlayer)
 { // static
-    return new ProtocolTidal(aEnv, aToken, aMediaPlayer.CredentialsManager(), aMediaPlayer.ConfigInitialiser());
+    return new ProtocolTidal(aEnv, aToken, aMediaPlayer.CredentialsManager(), aMediaPlayer.ConfigInitialiser(), aMediaPlayer.TrackLookAhead());
 }
 
 
 // ProtocolTidal
 
-ProtocolTidal::ProtocolTidal(Environment& aEnv, const Brx& aToken, Credentials& aCredentialsManager, IConfigInitialiser& aConfigInitialiser)
-    : ProtocolNetwork(aEnv)
+ProtocolTidal::ProtocolTidal(Environment& aEnv, const Brx& aToken, Credentials& aCredentialsManager,
+                             IConfigInitialiser& aConfigInitialiser, ITrackLookAhead& aTrackLookAhead)
+    : ProtocolNetwork(aEnv, "tidal")
     , iSupply(nullptr)
     , iWriterRequest(iWriterBuf)
     , iReaderUntil(iReaderBuf)
@@ -100,6 +104,7 @@ ProtocolTidal::ProtocolTidal(Environment& aEnv, const Brx& aToken, Credentials&
 
     iTidal = new Tidal(aEnv, aToken, aCredentialsManager, aConfigInitialiser);
     aCredentialsManager.Add(iTidal);
+    aTrackLookAhead.AddObserver(iTidal->StreamUrls());
 }
 
 ProtocolTidal::~ProtocolTidal()
@@ -140,25 +145,29 @@ ProtocolStreamResult ProtocolTidal::Stream(const Brx& aUri)
         return EProtocolErrorNotSupported;
     }
     LOG(kMedia, "ProtocolTidal::Stream(%.*s)\n", PBUF(aUri));
-    if (!TryGetTrackId(iUri.Query(), iTrackId)) {
+    if (!Tidal::TryGetTrackId(iUri.Query(), iTrackId)) {
         return EProtocolStreamErrorUnrecoverable;
     }
 
     ProtocolStreamResult res = EProtocolStreamErrorUnrecoverable;
-    if (iSessionId.Bytes() == 0 && !iTidal->TryLogin(iSessionId)) {
+    StreamUrlCache& cache = iTidal->StreamUrls();
+    const TBool cached = cache.TryGet(aUri, iStreamUrl);
+    if (!cached && !TryGetStreamUrl(aUri)) {
         return EProtocolStreamErrorUnrecoverable;
     }
-    if (!iTidal->TryGetStreamUrl(iTrackId, iStreamUrl)) {
-        // any error might be due to our session having expired
-        // attempt logout, login, getStreamUrl to see if that fixes things
-        (void)iTidal->TryLogout(iSessionId);
-        if (!iTidal->TryLogin(iSessionId) || !iTidal->TryGetStreamUrl(iTrackId, iStreamUrl)) {
-            return EProtocolStreamErrorUnrecoverable;
-        }
-    }
     iUri.Replace(iStreamUrl);
 
     res = DoStream();
+    if (res == EProtocolStreamErrorUnrecoverable && cached && !iStarted && !iStopped) {
+        // cached url may have been revoked early by the service; fall back to requesting a new one
+        LOG(kMedia, "ProtocolTidal - cached url failed, re-requesting\n");
+        cache.Remove(aUri);
+        if (!TryGetStreamUrl(aUri)) {
+            return EProtocolStreamErrorUnrecoverable;
+        }
+        iUri.Replace(iStreamUrl);
+        res = DoStream();
+    }
     if (res == EProtocolStreamErrorUnrecoverable) {
         return res;
     }
@@ -282,37 +291,20 @@ void ProtocolTidal::ReadInterrupt()
     iReaderUntil.ReadInterrupt();
 }
 
-TBool ProtocolTidal::TryGetTrackId(const Brx& aQuery, Bwx& aTrackId)
-{ // static
-    Parser parser(aQuery);
-    (void)parser.Next('?');
-    Brn buf = parser.Next('=');
-    if (buf != Brn("version")) {
-        LOG2(kPipeline, kError, "TryGetTrackId failed - no version\n");
+TBool ProtocolTidal::TryGetStreamUrl(const Brx& aTrackUri)
+{
+    if (iSessionId.Bytes() == 0 && !iTidal->TryLogin(iSessionId)) {
         return false;
     }
-    Brn verBuf = parser.Next('&');
-    try {
-        const TUint ver = Ascii::Uint(verBuf);
-        if (ver != 1) {
-            LOG2(kPipeline, kError, "TryGetTrackId failed - unsupported version - %d\n", ver);
+    if (!iTidal->TryGetStreamUrl(iTrackId, iStreamUrl)) {
+        // any error might be due to our session having expired
+        // attempt logout, login, getStreamUrl to see if that fixes things
+        (void)iTidal->TryLogout(iSessionId);
+        if (!iTidal->TryLogin(iSessionId) || !iTidal->TryGetStreamUrl(iTrackId, iStreamUrl)) {
             return false;
         }
     }
-    catch (AsciiError&) {
-        LOG2(kPipeline, kError, "TryGetTrackId failed - invalid version\n");
-        return false;
-    }
-    buf.Set(parser.Next('='));
-    if (buf != Brn("trackId")) {
-        LOG2(kPipeline, kError, "TryGetTrackId failed - no track id tag\n");
-        return false;
-    }
-    aTrackId.Replace(parser.Remaining());
-    if (aTrackId.Bytes() == 0) {
-        LOG2(kPipeline, kError, "TryGetTrackId failed - no track id value\n");
-        return false;
-    }
+    iTidal->StreamUrls().Add(aTrackUri, iStreamUrl);
     return true;
 }
 
@@ -11,6 +11,9 @@
 #include <OpenHome/Private/Uri.h>
 #include <OpenHome/Media/Debug.h>
 #include <OpenHome/Av/Utils/FormUrl.h>
+#include <OpenHome/Av/Utils/StreamUrlCache.h>
+#include <OpenHome/Private/Parser.h>
+#include <OpenHome/Private/Ascii.h>
 
 #include <algorithm>
 
@@ -26,30 +29,46 @@ const Brn Tidal::kHost("api.tidalhifi.com");
 const Brn Tidal::kId("tidalhifi.com");
 const Brn Tidal::kConfigKeySoundQuality("tidalhifi.com.SoundQuality");
 
-Tidal::Tidal(Environment& aEnv, const Brx& aToken, ICredentialsState& aCredentialsState, Configuration::IConfigInitialiser& aConfigInitialiser)
-    : iLock("TDL1")
-    , iLockConfig("TDL2")
-    , iCredentialsState(aCredentialsState)
-    , iSocket(aEnv, kReadBufferBytes)
+
+// Tidal::Connection
+
+Tidal::Connection::Connection(Environment& aEnv)
+    : iSocket(aEnv, kReadBufferBytes)
     , iReaderBuf(iSocket)
     , iReaderUntil(iReaderBuf)
     , iWriterBuf(iSocket)
     , iWriterRequest(iSocket)
     , iReaderResponse(aEnv, iReaderUntil)
+{
+    iReaderResponse.AddHeader(iHeaderContentLength);
+}
+
+
+// Tidal
+
+Tidal::Tidal(Environment& aEnv, const Brx& aToken, ICredentialsState& aCredentialsState, Configuration::IConfigInitialiser& aConfigInitialiser)
+    : iLock("TDL1")
+    , iLockConfig("TDL2")
+    , iCredentialsState(aCredentialsState)
+    , iConnection(aEnv)
     , iToken(aToken)
     , iUsername(kGranularityUsername)
     , iPassword(kGranularityPassword)
+    , iLockLookAhead("TDL3")
+    , iConnectionLookAhead(aEnv)
 {
-    iReaderResponse.AddHeader(iHeaderContentLength);
     const int arr[] = {0, 1, 2};
     std::vector<TUint> qualities(arr, arr + sizeof(arr)/sizeof(arr[0]));
     iConfigQuality = new ConfigChoice(aConfigInitialiser, kConfigKeySoundQuality, qualities, 2);
     iMaxSoundQuality = kNumSoundQualities - 1;
+    iStreamUrlCache = new StreamUrlCache(aEnv, "TidalLookAhead", Brn("tidal"), *this, kStreamUrlExpiryMs);
     iSubscriberIdQuality = iConfigQuality->Subscribe(MakeFunctorConfigChoice(*this, &Tidal::QualityChanged));
 }
 
 Tidal::~Tidal()
 {
+    iConnectionLookAhead.iSocket.Interrupt(true);
+    delete iStreamUrlCache;
     iConfigQuality->Unsubscribe(iSubscriberIdQuality);
     delete iConfigQuality;
 }
@@ -78,36 +97,41 @@ TBool Tidal::TryReLogin(const Brx& aCurrentToken, Bwx& aNewToken)
 TBool Tidal::TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl)
 {
     AutoMutex _(iLock);
+    return TryGetStreamUrl(iConnection, aTrackId, iSessionId, iCountryCode, aStreamUrl);
+}
+
+TBool Tidal::TryGetStreamUrl(Connection& aConnection, const Brx& aTrackId, const Brx& aSessionId, const Brx& aCountryCode, Bwx& aStreamUrl)
+{
     TBool success = false;
-    if (!TryConnect(kPort)) {
+    if (!TryConnect(aConnection, kPort)) {
         LOG2(kMedia, kError, "Tidal::TryGetStreamUrl - connection failure\n");
         return false;
     }
-    AutoSocketSsl __(iSocket);
+    AutoSocketSsl _(aConnection.iSocket);
     Bws<128> pathAndQuery("/v1/tracks/");
     pathAndQuery.Append(aTrackId);
     pathAndQuery.Append("/streamurl?sessionId=");
-    pathAndQuery.Append(iSessionId);
+    pathAndQuery.Append(aSessionId);
     pathAndQuery.Append("&countryCode=");
-    pathAndQuery.Append(iCountryCode);
+    pathAndQuery.Append(aCountryCode);
     pathAndQuery.Append("&soundQuality=");
     iLockConfig.Wait();
     pathAndQuery.Append(Brn(kSoundQualities[iSoundQuality]));
     iLockConfig.Signal();
     Brn url;
     try {
-        WriteRequestHeaders(Http::kMethodGet, pathAndQuery, kPort);
+        WriteRequestHeaders(aConnection, Http::kMethodGet, pathAndQuery, kPort);
 
-        iReaderResponse.Read();
-        const TUint code = iReaderResponse.Status().Code();
+        aConnection.iReaderResponse.Read();
+        const TUint code = aConnection.iReaderResponse.Status().Code();
         if (code != 200) {
             LOG2(kPipeline, kError, "Http error - %d - in response to Tidal GetStreamUrl.  Some/all of response is:\n", code);
-            Brn buf = iReaderUntil.Read(kReadBufferBytes);
+            Brn buf = aConnection.iReaderUntil.Read(kReadBufferBytes);
             LOG2(kPipeline, kError, "%.*s\n", PBUF(buf));
             THROW(ReaderError);
         }
 
-        aStreamUrl.Replace(ReadString(iReaderUntil, Brn("url")));
+        aStreamUrl.Replace(ReadString(aConnection.iReaderUntil, Brn("url")));
         LOG(kMedia, "Tidal::TryGetStreamUrl aStreamUrl: %.*s\n", PBUF(aStreamUrl));
         success = true;
     }
@@ -131,7 +155,46 @@ TBool Tidal::TryLogout(const Brx& aSessionId)
 
 void Tidal::Interrupt(TBool aInterrupt)
 {
-    iSocket.Interrupt(aInterrupt);
+    iConnection.iSocket.Interrupt(aInterrupt);
+}
+
+StreamUrlCache& Tidal::StreamUrls()
+{
+    return *iStreamUrlCache;
+}
+
+TBool Tidal::TryGetTrackId(const Brx& aQuery, Bwx& aTrackId)
+{ // static
+    Parser parser(aQuery);
+    (void)parser.Next('?');
+    Brn buf = parser.Next('=');
+    if (buf != Brn("version")) {
+        LOG2(kPipeline, kError, "TryGetTrackId failed - no version\n");
+        return false;
+    }
+    Brn verBuf = parser.Next('&');
+    try {
+        const TUint ver = Ascii::Uint(verBuf);
+        if (ver != 1) {
+            LOG2(kPipeline, kError, "TryGetTrackId failed - unsupported version - %d\n", ver);
+            return false;
+        }
+    }
+    catch (AsciiError&) {
+        LOG2(kPipeline, kError, "TryGetTrackId failed - invalid version\n");
+        return false;
+    }
+    buf.Set(parser.Next('='));
+    if (buf != Brn("trackId")) {
+        LOG2(kPipeline, kError, "TryGetTrackId failed - no track id tag\n");
+        return false;
+    }
+    aTrackId.Replace(parser.Remaining());
+    if (aTrackId.Bytes() == 0) {
+        LOG2(kPipeline, kError, "TryGetTrackId failed - no track id value\n");
+        return false;
+    }
+    return true;
 }
 
 const Brx& Tidal::Id() const
@@ -146,6 +209,7 @@ void Tidal::CredentialsChanged(const Brx& aUsername, const Brx& aPassword)
     iUsername.Write(aUsername);
     iPassword.Reset();
     iPassword.Write(aPassword);
+    iStreamUrlCache->Clear();
 }
 
 void Tidal::UpdateStatus()
@@ -182,13 +246,36 @@ void Tidal::ReLogin(const Brx& aCurrentToken, Bwx& aNewToken)
     }
 }
 
-TBool Tidal::TryConnect(TUint aPort)
+TBool Tidal::TryResolveStreamUrl(const Brx& aTrackUri, Bwx& aStreamUrl)
+{
+    AutoMutex _(iLockLookAhead);
+    {
+        AutoMutex __(iLock);
+        if (iSessionId.Bytes() == 0) {
+            return false; // don't log in on a speculative request; wait for ProtocolTidal to do so
+        }
+        iLookAheadSessionId.Replace(iSessionId);
+        iLookAheadCountryCode.Replace(iCountryCode);
+    }
+    try {
+        iLookAheadUri.Replace(aTrackUri);
+    }
+    catch (UriError&) {
+        return false;
+    }
+    if (!TryGetTrackId(iLookAheadUri.Query(), iLookAheadTrackId)) {
+        return false;
+    }
+    return TryGetStreamUrl(iConnectionLookAhead, iLookAheadTrackId, iLookAheadSessionId, iLookAheadCountryCode, aStreamUrl);
+}
+
+TBool Tidal::TryConnect(Connection& aConnection, TUint aPort)
 {
     Endpoint ep;
     try {
         ep.SetAddress(kHost);
         ep.SetPort(aPort);
-        iSocket.Connect(ep, kConnectTimeoutMs);
+        aConnection.iSocket.Connect(ep, kConnectTimeoutMs);
     }
     catch (NetworkTimeout&) {
         return false;
@@ -215,13 +302,13 @@ TBool Tidal::TryLoginLocked()
     Bws<80> error;
     iSessionId.SetBytes(0);
     TBool success = false;
-    if (!TryConnect(kPort)) {
+    if (!TryConnect(iConnection, kPort)) {
         LOG2(kPipeline, kError, "Tidal::TryLogin - connection failure\n");
         iCredentialsState.SetState(kId, Brn("Login Error (Connection Failed): Please Try Again."), Brx::Empty());
         return false;
     }
     {
-        AutoSocketSsl _(iSocket);
+        AutoSocketSsl _(iConnection.iSocket);
         Bws<280> reqBody(Brn("username="));
         WriterBuffer writer(reqBody);
         iLockConfig.Wait();
@@ -233,17 +320,17 @@ TBool Tidal::TryLoginLocked()
         Bws<128> pathAndQuery("/v1/login/username?token=");
         pathAndQuery.Append(iToken);
         try {
-            WriteRequestHeaders(Http::kMethodPost, pathAndQuery, kPort, reqBody.Bytes());
-            iWriterBuf.Write(reqBody);
-            iWriterBuf.WriteFlush();
+            WriteRequestHeaders(iConnection, Http::kMethodPost, pathAndQuery, kPort, reqBody.Bytes());
+            iConnection.iWriterBuf.Write(reqBody);
+            iConnection.iWriterBuf.WriteFlush();
 
-            iReaderResponse.Read();
-            const TUint code = iReaderResponse.Status().Code();
+            iConnection.iReaderResponse.Read();
+            const TUint code = iConnection.iReaderResponse.Status().Code();
             if (code != 200) {
                 Bws<kMaxStatusBytes> status;
-                const TUint len = std::min(status.MaxBytes(), iHeaderContentLength.ContentLength());
+                const TUint len = std::min(status.MaxBytes(), iConnection.iHeaderContentLength.ContentLength());
                 if (len > 0) {
-                    status.Replace(iReaderUntil.Read(len));
+                    status.Replace(iConnection.iReaderUntil.Read(len));
                     iCredentialsState.SetState(kId, status, Brx::Empty());
                 }
                 else {
@@ -256,9 +343,9 @@ TBool Tidal::TryLoginLocked()
                 THROW(ReaderError);
             }
 
-            iUserId.Replace(ReadInt(iReaderUntil, Brn("userId")));
-            iSessionId.Replace(ReadString(iReaderUntil, Brn("sessionId")));
-            iCountryCode.Replace(ReadString(iReaderUntil, Brn("countryCode")));
+            iUserId.Replace(ReadInt(iConnection.iReaderUntil, Brn("userId")));
+            iSessionId.Replace(ReadString(iConnection.iReaderUntil, Brn("sessionId")));
+            iCountryCode.Replace(ReadString(iConnection.iReaderUntil, Brn("countryCode")));
             iCredentialsState.SetState(kId, Brx::Empty(), iCountryCode);
             updatedStatus = true;
             success = true;
@@ -294,21 +381,21 @@ TBool Tidal::TryLogoutLocked(const Brx& aSessionId)
         return true;
     }
     TBool success = false;
-    if (!TryConnect(kPort)) {
+    if (!TryConnect(iConnection, kPort)) {
         LOG2(kError, kPipeline, "Tidal: connection failure\n");
         return false;
     }
-    AutoSocketSsl _(iSocket);
+    AutoSocketSsl _(iConnection.iSocket);
     Bws<128> pathAndQuery("/v1/logout?sessionId=");
     pathAndQuery.Append(aSessionId);
     try {
-        WriteRequestHeaders(Http::kMethodPost, pathAndQuery, kPort);
+        WriteRequestHeaders(iConnection, Http::kMethodPost, pathAndQuery, kPort);
 
-        iReaderResponse.Read();
-        const TUint code = iReaderResponse.Status().Code();
+        iConnection.iReaderResponse.Read();
+        const TUint code = iConnection.iReaderResponse.Status().Code();
         if (code < 200 || code >= 300) {
             LOG2(kPipeline, kError, "Http error - %d - in response to Tidal logout.  Some/all of response is:\n", code);
-            Brn buf = iReaderUntil.Read(kReadBufferBytes);
+            Brn buf = iConnection.iReaderUntil.Read(kReadBufferBytes);
             LOG2(kPipeline, kError, "%.*s\n", PBUF(buf));
             THROW(ReaderError);
         }
@@ -332,12 +419,12 @@ TBool Tidal::TryGetSubscriptionLocked()
     TBool updateStatus = false;
     Bws<kMaxStatusBytes> error;
     TBool success = false;
-    if (!TryConnect(kPort)) {
+    if (!TryConnect(iConnection, kPort)) {
         LOG2(kMedia, kError, "Tidal::TryGetSubscriptionLocked - connection failure\n");
         iCredentialsState.SetState(kId, Brn("Subscription Error (Connection Failed): Please Try Again."), Brx::Empty());
         return false;
     }
-    AutoSocketSsl _(iSocket);
+    AutoSocketSsl _(iConnection.iSocket);
 
     Bws<128> pathAndQuery("/v1/users/");
     pathAndQuery.Append(iUserId);
@@ -345,15 +432,15 @@ TBool Tidal::TryGetSubscriptionLocked()
     pathAndQuery.Append(iSessionId);
 
     try {
-        WriteRequestHeaders(Http::kMethodGet, pathAndQuery, kPort, 0);
+        WriteRequestHeaders(iConnection, Http::kMethodGet, pathAndQuery, kPort, 0);
 
-        iReaderResponse.Read();
-        const TUint code = iReaderResponse.Status().Code();
+        iConnection.iReaderResponse.Read();
+        const TUint code = iConnection.iReaderResponse.Status().Code();
         if (code != 200) {
             Bws<kMaxStatusBytes> status;
-            const TUint len = std::min(status.MaxBytes(), iHeaderContentLength.ContentLength());
+            const TUint len = std::min(status.MaxBytes(), iConnection.iHeaderContentLength.ContentLength());
             if (len > 0) {
-                error.Replace(iReaderUntil.Read(len));
+                error.Replace(iConnection.iReaderUntil.Read(len));
             }
             else {
                 error.AppendPrintf("Subscription Error (Response Code %d): Please Try Again.", code);
@@ -362,7 +449,7 @@ TBool Tidal::TryGetSubscriptionLocked()
             LOG2(kPipeline, kError, "Http error - %d - in response to Tidal subscription.  Some/all of response is:\n%.*s\n", code, PBUF(status));
             THROW(ReaderError);
         }
-        Brn quality = ReadString(iReaderUntil, Brn("highestSoundQuality"));
+        Brn quality = ReadString(iConnection.iReaderUntil, Brn("highestSoundQuality"));
         for (TUint i=0; i<kNumSoundQualities; i++) {
             if (Brn(kSoundQualities[i]) == quality) {
                 iMaxSoundQuality = i;
@@ -391,16 +478,17 @@ TBool Tidal::TryGetSubscriptionLocked()
     return success;
 }
 
-void Tidal::WriteRequestHeaders(const Brx& aMethod, const Brx& aPathAndQuery, TUint aPort, TUint aContentLength)
+void Tidal::WriteRequestHeaders(Connection& aConnection, const Brx& aMethod, const Brx& aPathAndQuery, TUint aPort, TUint aContentLength)
 {
-    iWriterRequest.WriteMethod(aMethod, aPathAndQuery, Http::eHttp11);
-    Http::WriteHeaderHostAndPort(iWriterRequest, kHost, aPort);
+    WriterHttpRequest& writer = aConnection.iWriterRequest;
+    writer.WriteMethod(aMethod, aPathAndQuery, Http::eHttp11);
+    Http::WriteHeaderHostAndPort(writer, kHost, aPort);
     if (aContentLength > 0) {
-        Http::WriteHeaderContentLength(iWriterRequest, aContentLength);
+        Http::WriteHeaderContentLength(writer, aContentLength);
     }
-    Http::WriteHeaderContentType(iWriterRequest, Brn("application/x-www-form-urlencoded"));
-    Http::WriteHeaderConnectionClose(iWriterRequest);
-    iWriterRequest.WriteFlush();
+    Http::WriteHeaderContentType(writer, Brn("application/x-www-form-urlencoded"));
+    Http::WriteHeaderConnectionClose(writer);
+    writer.WriteFlush();
 }
 
 
@@ -438,4 +526,5 @@ void Tidal::QualityChanged(Configuration::KeyValuePair<TUint>& aKvp)
     iLockConfig.Wait();
     iSoundQuality = std::min(aKvp.Value(), iMaxSoundQuality);
     iLockConfig.Signal();
+    iStreamUrlCache->Clear(); // cached urls were for the previous quality
 }
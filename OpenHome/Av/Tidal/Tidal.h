@@ -1,11 +1,13 @@
 #pragma once
 
 #include <OpenHome/Av/Credentials.h>
+#include <OpenHome/Av/Utils/StreamUrlCache.h>
 #include <OpenHome/Types.h>
 #include <OpenHome/SocketSsl.h>
 #include <OpenHome/Configuration/ConfigManager.h>
 #include <OpenHome/Private/Http.h>
 #include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Uri.h>
 #include <OpenHome/Buffer.h>
         
 namespace OpenHome {
@@ -16,7 +18,7 @@ namespace Configuration {
 }
 namespace Av {
 
-class Tidal : public ICredentialConsumer
+class Tidal : public ICredentialConsumer, private IStreamUrlResolver
 {
     friend class TestTidal;
     static const TUint kReadBufferBytes = 4 * 1024;
@@ -28,8 +30,10 @@ class Tidal : public ICredentialConsumer
     static const TUint kGranularityPassword = 128;
     static const Brn kId;
     static const TUint kMaxStatusBytes = 512;
+    static const TUint kStreamUrlExpiryMs = 10 * 60 * 1000; // conservative; stream urls are signed for a limited period
 public:
     static const Brn kConfigKeySoundQuality;
+    static const TUint kMaxTrackIdBytes = 12;
 public:
     Tidal(Environment& aEnv, const Brx& aToken, ICredentialsState& aCredentialsState, Configuration::IConfigInitialiser& aConfigInitialiser);
     ~Tidal();
@@ -38,19 +42,38 @@ public:
     TBool TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl);
     TBool TryLogout(const Brx& aSessionId);
     void Interrupt(TBool aInterrupt);
+    StreamUrlCache& StreamUrls();
+    static TBool TryGetTrackId(const Brx& aQuery, Bwx& aTrackId);
 private: // from ICredentialConsumer
     const Brx& Id() const override;
     void CredentialsChanged(const Brx& aUsername, const Brx& aPassword) override;
     void UpdateStatus() override;
     void Login(Bwx& aToken) override;
     void ReLogin(const Brx& aCurrentToken, Bwx& aNewToken) override;
+private: // from IStreamUrlResolver
+    TBool TryResolveStreamUrl(const Brx& aTrackUri, Bwx& aStreamUrl) override;
 private:
-    TBool TryConnect(TUint aPort);
+    class Connection : private INonCopyable
+    {
+    public:
+        Connection(Environment& aEnv);
+    public:
+        SocketSsl iSocket;
+        Srs<1024> iReaderBuf;
+        ReaderUntilS<kReadBufferBytes> iReaderUntil;
+        Sws<kWriteBufferBytes> iWriterBuf;
+        WriterHttpRequest iWriterRequest;
+        ReaderHttpResponse iReaderResponse;
+        HttpHeaderContentLength iHeaderContentLength;
+    };
+private:
+    TBool TryConnect(Connection& aConnection, TUint aPort);
+    TBool TryGetStreamUrl(Connection& aConnection, const Brx& aTrackId, const Brx& aSessionId, const Brx& aCountryCode, Bwx& aStreamUrl);
     TBool TryLoginLocked();
     TBool TryLoginLocked(Bwx& aSessionId);
     TBool TryLogoutLocked(const Brx& aSessionId);
     TBool TryGetSubscriptionLocked();
-    void WriteRequestHeaders(const Brx& aMethod, const Brx& aPathAndQuery, TUint aPort, TUint aContentLength = 0);
+    void WriteRequestHeaders(Connection& aConnection, const Brx& aMethod, const Brx& aPathAndQuery, TUint aPort, TUint aContentLength = 0);
     static Brn ReadInt(ReaderUntil& aReader, const Brx& aTag);
     static Brn ReadString(ReaderUntil& aReader, const Brx& aTag);
     void QualityChanged(Configuration::KeyValuePair<TUint>& aKvp);
@@ -58,13 +81,7 @@ private:
     Mutex iLock;
     Mutex iLockConfig;
     ICredentialsState& iCredentialsState;
-    SocketSsl iSocket;
-    Srs<1024> iReaderBuf;
-    ReaderUntilS<kReadBufferBytes> iReaderUntil;
-    Sws<kWriteBufferBytes> iWriterBuf;
-    WriterHttpRequest iWriterRequest;
-    ReaderHttpResponse iReaderResponse;
-    HttpHeaderContentLength iHeaderContentLength;
+    Connection iConnection;
     const Bws<32> iToken;
     WriterBwh iUsername;
     WriterBwh iPassword;
@@ -76,6 +93,14 @@ private:
     Bws<1024> iStreamUrl;
     Configuration::ConfigChoice* iConfigQuality;
     TUint iSubscriberIdQuality;
+    StreamUrlCache* iStreamUrlCache;
+    // look-ahead resolves use their own connection so never delay (or get interrupted by) ProtocolTidal
+    Mutex iLockLookAhead;
+    Connection iConnectionLookAhead;
+    Uri iLookAheadUri;
+    Bws<kMaxTrackIdBytes> iLookAheadTrackId;
+    Bws<64> iLookAheadSessionId;
+    Bws<8> iLookAheadCountryCode;
 };
 
 };  // namespace Av
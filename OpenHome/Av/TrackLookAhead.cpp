@@ -0,0 +1,39 @@
+#include <OpenHome/Av/TrackLookAhead.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+using namespace OpenHome::Media;
+
+// TrackLookAhead
+
+TrackLookAhead::TrackLookAhead()
+    : iLock("TLAH")
+    , iStopped(false)
+{
+}
+
+void TrackLookAhead::Stop()
+{
+    AutoMutex _(iLock);
+    iStopped = true;
+    iObservers.clear();
+}
+
+void TrackLookAhead::AddObserver(ITrackLookAheadObserver& aObserver)
+{
+    AutoMutex _(iLock);
+    if (!iStopped) {
+        iObservers.push_back(&aObserver);
+    }
+}
+
+void TrackLookAhead::NotifyUpcomingTracks(const std::vector<Track*>& aTracks)
+{
+    AutoMutex _(iLock);
+    for (auto it=iObservers.begin(); it!=iObservers.end(); ++it) {
+        (*it)->NotifyUpcomingTracks(aTracks);
+    }
+}
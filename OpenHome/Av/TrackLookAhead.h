@@ -0,0 +1,53 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+
+#include <vector>
+
+namespace OpenHome {
+namespace Media {
+    class Track;
+}
+namespace Av {
+
+class ITrackLookAheadObserver
+{
+public:
+    virtual ~ITrackLookAheadObserver() {}
+    // aTracks lists the tracks expected to be played next, in order.  Refs are only valid for the duration of this call.
+    virtual void NotifyUpcomingTracks(const std::vector<Media::Track*>& aTracks) = 0;
+};
+
+/*
+ * UriProviders report upcoming tracks via NotifyUpcomingTracks(); these are relayed to all observers.
+ */
+class ITrackLookAhead : public ITrackLookAheadObserver
+{
+public:
+    virtual ~ITrackLookAhead() {}
+    virtual void AddObserver(ITrackLookAheadObserver& aObserver) = 0; // no removal - observers must outlive all UriProviders
+};
+
+/*
+ * Relays upcoming tracks from UriProviders that can predict their future output (e.g. playlist)
+ * to components that can prepare for them (e.g. protocols which resolve their uris via a remote service).
+ */
+class TrackLookAhead : public ITrackLookAhead, private INonCopyable
+{
+public:
+    TrackLookAhead();
+    void Stop(); // stop relaying to (and forget) all observers; called before their owners are destroyed
+public: // from ITrackLookAhead
+    void AddObserver(ITrackLookAheadObserver& aObserver) override;
+public: // from ITrackLookAheadObserver
+    void NotifyUpcomingTracks(const std::vector<Media::Track*>& aTracks) override;
+private:
+    Mutex iLock;
+    std::vector<ITrackLookAheadObserver*> iObservers;
+    TBool iStopped;
+};
+
+} // namespace Av
+} // namespace OpenHome
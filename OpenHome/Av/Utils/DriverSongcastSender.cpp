@@ -7,7 +7,6 @@
 #include <OpenHome/OsWrapper.h>
 #include <OpenHome/Av/Songcast/OhmSender.h>
 #include <OpenHome/Private/Timer.h>
-#include <OpenHome/Media/Utils/ProcessorPcmUtils.h>
 #include <OpenHome/Net/Private/DviStack.h>
 #include <OpenHome/Private/Env.h>
 #include <OpenHome/Av/Songcast/ZoneHandler.h>
@@ -42,11 +41,12 @@ DriverSongcastSender::DriverSongcastSender(IPipelineElementUpstream& aPipeline,
     , iLastTimeUs(0)
     , iTimeOffsetUs(0)
     , iPlayable(nullptr)
+    , iAudioBuf(nullptr)
     , iAudioSent(false)
     , iQuit(false)
 {
     ASSERT(aMaxMsgSizeJiffies % Jiffies::kPerMs == 0);
-    iOhmSenderDriver = new OhmSenderDriver(iEnv, Optional<IOhmTimestamper>());
+    iOhmSenderDriver = new OhmSenderDriver(iEnv, Optional<IOhmTimestamper>(), kSongcastLatencyMs);
 
     Bws<64> udn("Driver-");
     udn.Append(aName);
@@ -189,12 +189,47 @@ void DriverSongcastSender::SendAudio(MsgPlayable* aMsg)
         }
     }
     iJiffiesToSend -= jiffies;
-    ProcessorPcmBufTest pcmProcessor;
-    aMsg->Read(pcmProcessor);
-    Brn buf = pcmProcessor.Buf();
-    const TUint numSubsamples = buf.Bytes() / (iBitDepth/8);
-    iOhmSenderDriver->SendAudio(buf.Ptr(), numSubsamples * (iBitDepth/8));
+    // read straight into the frame that will be sent rather than via an intermediate buffer
+    OhmMsgAudio* audio = iOhmSenderDriver->CreateAudio();
+    iAudioBuf = &audio->Audio();
+    iAudioBuf->SetBytes(0);
+    aMsg->Read(*this);
     aMsg->RemoveRef();
+    iAudioBuf = nullptr;
+    iOhmSenderDriver->SendAudio(audio);
+}
+
+void DriverSongcastSender::BeginBlock()
+{
+    ASSERT(iAudioBuf != nullptr);
+}
+
+void DriverSongcastSender::ProcessFragment8(const Brx& aData, TUint /*aNumChannels*/)
+{
+    iAudioBuf->Append(aData);
+}
+
+void DriverSongcastSender::ProcessFragment16(const Brx& aData, TUint /*aNumChannels*/)
+{
+    iAudioBuf->Append(aData);
+}
+
+void DriverSongcastSender::ProcessFragment24(const Brx& aData, TUint /*aNumChannels*/)
+{
+    iAudioBuf->Append(aData);
+}
+
+void DriverSongcastSender::ProcessFragment32(const Brx& aData, TUint /*aNumChannels*/)
+{
+    iAudioBuf->Append(aData);
+}
+
+void DriverSongcastSender::EndBlock()
+{
+}
+
+void DriverSongcastSender::Flush()
+{
 }
 
 void DriverSongcastSender::DeviceDisabled()
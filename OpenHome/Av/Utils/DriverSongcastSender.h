@@ -15,7 +15,7 @@ namespace Av {
 }
 namespace Av {
 
-class DriverSongcastSender : public Media::PipelineElement, private Net::IResourceManager
+class DriverSongcastSender : public Media::PipelineElement, private Media::IPcmProcessor, private Net::IResourceManager
 {
     static const TUint kSongcastTtl = 1;
     static const TUint kSongcastLatencyMs = 300;
@@ -37,6 +37,14 @@ private: // from Media::IMsgProcessor
     Media::Msg* ProcessMsg(Media::MsgDecodedStream* aMsg) override;
     Media::Msg* ProcessMsg(Media::MsgPlayable* aMsg) override;
     Media::Msg* ProcessMsg(Media::MsgQuit* aMsg) override;
+private: // from Media::IPcmProcessor
+    void BeginBlock() override;
+    void ProcessFragment8(const Brx& aData, TUint aNumChannels) override;
+    void ProcessFragment16(const Brx& aData, TUint aNumChannels) override;
+    void ProcessFragment24(const Brx& aData, TUint aNumChannels) override;
+    void ProcessFragment32(const Brx& aData, TUint aNumChannels) override;
+    void EndBlock() override;
+    void Flush() override;
 private: // from Net::IResourceManager
     void WriteResource(const Brx& aUriTail, TIpAddress aInterface, std::vector<char*>& aLanguageList, Net::IResourceWriter& aResourceWriter) override;
 private:
@@ -61,6 +69,7 @@ private:
                             //  <0 means sender is behind
                             //  >0 means sender is ahead
     Media::MsgPlayable* iPlayable;
+    Bwx* iAudioBuf;
     TBool iAudioSent;
     TBool iQuit;
 };
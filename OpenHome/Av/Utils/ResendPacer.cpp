@@ -0,0 +1,126 @@
+#include <OpenHome/Av/Utils/ResendPacer.h>
+#include <OpenHome/Types.h>
+
+#include <algorithm>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+// ResendPacer
+
+ResendPacer::ResendPacer()
+{
+    Reset();
+}
+
+void ResendPacer::Reset()
+{
+    iRttValid = false;
+    iRttUs = 0;
+    iRttVarUs = 0;
+    iProbeValid = false;
+    iProbeRetried = false;
+    iProbeFrame = 0;
+    iProbeTimeUs = 0;
+    iHeardCount = 0;
+    iHeardNext = 0;
+}
+
+void ResendPacer::NotifyRequested(TUint aFirstFrame, TUint64 aTimeUs)
+{
+    if (iProbeValid && iProbeFrame == aFirstFrame) {
+        iProbeRetried = true;
+        return;
+    }
+    iProbeValid = true;
+    iProbeRetried = false;
+    iProbeFrame = aFirstFrame;
+    iProbeTimeUs = aTimeUs;
+}
+
+void ResendPacer::NotifyResent(TUint aFrame, TUint64 aTimeUs)
+{
+    if (!iProbeValid || aFrame != iProbeFrame) {
+        return;
+    }
+    iProbeValid = false;
+    if (iProbeRetried || aTimeUs < iProbeTimeUs) {
+        return;
+    }
+    const TUint64 maxUs = (TUint64)kMaxTimeoutMs * 1000;
+    const TUint sample = (TUint)std::min(aTimeUs - iProbeTimeUs, maxUs);
+    if (!iRttValid) {
+        iRttValid = true;
+        iRttUs = sample;
+        iRttVarUs = sample / 2;
+    }
+    else {
+        // RFC 6298 gains; alpha = 1/8, beta = 1/4
+        const TUint err = (sample > iRttUs? sample - iRttUs : iRttUs - sample);
+        iRttVarUs = (3 * iRttVarUs + err) / 4;
+        iRttUs = (7 * iRttUs + sample) / 8;
+    }
+}
+
+void ResendPacer::NotifyHeard(TUint aFrame, TUint64 aTimeUs)
+{
+    iHeard[iHeardNext].iFrame = aFrame;
+    iHeard[iHeardNext].iTimeUs = aTimeUs;
+    iHeardNext = (iHeardNext + 1) % kMaxHeardFrames;
+    if (iHeardCount < kMaxHeardFrames) {
+        iHeardCount++;
+    }
+}
+
+TBool ResendPacer::RecentlyRequested(TUint aFrame, TUint64 aTimeUs) const
+{
+    const TUint64 windowUs = (TUint64)TimeoutMs() * 1000;
+    for (TUint i=0; i<iHeardCount; i++) {
+        const HeardFrame& heard = iHeard[i];
+        if (heard.iFrame == aFrame && aTimeUs >= heard.iTimeUs && aTimeUs - heard.iTimeUs < windowUs) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TUint ResendPacer::TimeoutMs() const
+{
+    if (!iRttValid) {
+        return kDefaultTimeoutMs;
+    }
+    const TUint ms = (iRttUs + 4 * iRttVarUs + 999) / 1000;
+    return Clamp(ms, kMinTimeoutMs);
+}
+
+TUint ResendPacer::InitialTimeoutMs() const
+{
+    /* Spread first requests over at least one rtt so that, in multicast mode, the earliest
+       request has a chance to reach other receivers before their own timers expire. */
+    if (!iRttValid) {
+        return kMinInitialTimeoutMs;
+    }
+    const TUint ms = (iRttUs + 999) / 1000;
+    return Clamp(ms, kMinInitialTimeoutMs);
+}
+
+TUint ResendPacer::Clamp(TUint aMs, TUint aMinMs)
+{ // static
+    if (aMs < aMinMs) {
+        return aMinMs;
+    }
+    if (aMs > kMaxTimeoutMs) {
+        return kMaxTimeoutMs;
+    }
+    return aMs;
+}
+
+TBool ResendPacer::RttValid() const
+{
+    return iRttValid;
+}
+
+TUint ResendPacer::RttUs() const
+{
+    return iRttUs;
+}
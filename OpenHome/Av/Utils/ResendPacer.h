@@ -0,0 +1,64 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+
+namespace OpenHome {
+namespace Av {
+
+/*
+ * Decides when a receiver of a sequenced stream (Songcast, AirPlay) should (re)request
+ * missing frames.
+ *
+ * Round trip time to the sender is measured from resend requests to the arrival of the first
+ * frame each one asked for.  As with TCP, frames that were requested more than once aren't used
+ * as samples since we can't tell which request they're a response to.  Repair timeouts then
+ * follow the smoothed rtt rather than being fixed.
+ *
+ * In Songcast's multicast mode all receivers hear each other's resend requests.  Frames someone else has
+ * asked for recently are already on their way so needn't be requested again.  Without this, a
+ * network glitch that affects many receivers leads to them all requesting the same frames.
+ *
+ * Not thread safe; callers are expected to serialise access.
+ */
+class ResendPacer
+{
+public:
+    static const TUint kDefaultTimeoutMs = 30; // used until we have an rtt sample
+    static const TUint kMinTimeoutMs = 5;
+    static const TUint kMaxTimeoutMs = 200;
+    static const TUint kMinInitialTimeoutMs = 10;
+    static const TUint kMaxHeardFrames = 64;
+public:
+    ResendPacer();
+    void Reset();
+    void NotifyRequested(TUint aFirstFrame, TUint64 aTimeUs);
+    void NotifyResent(TUint aFrame, TUint64 aTimeUs);
+    void NotifyHeard(TUint aFrame, TUint64 aTimeUs);
+    TBool RecentlyRequested(TUint aFrame, TUint64 aTimeUs) const;
+    TUint TimeoutMs() const;
+    TUint InitialTimeoutMs() const; // upper bound for randomised delay before a repair's first request
+    TBool RttValid() const;
+    TUint RttUs() const;
+private:
+    static TUint Clamp(TUint aMs, TUint aMinMs);
+private:
+    struct HeardFrame
+    {
+        TUint iFrame;
+        TUint64 iTimeUs;
+    };
+private:
+    TBool iRttValid;
+    TUint iRttUs;       // smoothed
+    TUint iRttVarUs;
+    TBool iProbeValid;
+    TBool iProbeRetried;
+    TUint iProbeFrame;
+    TUint64 iProbeTimeUs;
+    HeardFrame iHeard[kMaxHeardFrames];
+    TUint iHeardCount;
+    TUint iHeardNext;
+};
+
+} // namespace Av
+} // namespace OpenHome
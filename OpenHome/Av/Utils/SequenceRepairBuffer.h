@@ -0,0 +1,216 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+namespace OpenHome {
+namespace Av {
+
+/*
+ * Holds frames that arrived ahead of a gap in a sequenced stream until the gap is repaired.
+ *
+ * Frames are stored in a ring indexed by sequence number so inserting a frame, whether in
+ * order, late or duplicated, is O(1).  The ring covers the Capacity sequence numbers following
+ * the last frame output; a frame further ahead than that doesn't fit until older gaps are
+ * either repaired or given up on (SkipGap()).
+ *
+ * Sequence numbers are SeqBits wide and compared modulo 2^SeqBits so a stream may wrap.
+ * Items are not owned; callers remain responsible for disposing of anything they Pop().
+ *
+ * Not thread safe; callers are expected to serialise access.
+ */
+template <class T, TUint Capacity, TUint SeqBits>
+class SequenceRepairBuffer : private INonCopyable
+{
+    static const TUint kSeqMask = static_cast<TUint>((static_cast<TUint64>(1) << SeqBits) - 1);
+    static const TUint kIndexMask = Capacity - 1;
+    static_assert(SeqBits >= 8 && SeqBits <= 32, "SequenceRepairBuffer supports 8 to 32 bit sequence numbers");
+    static_assert(Capacity > 1 && (Capacity & kIndexMask) == 0, "SequenceRepairBuffer capacity must be a power of two");
+    static_assert(Capacity <= (kSeqMask >> 1), "SequenceRepairBuffer capacity must be less than half the sequence space");
+public:
+    enum EInsert
+    {
+        eStored
+       ,eDuplicate // already held
+       ,eLate      // at or before Last()
+       ,eTooFar    // more than Capacity frames after Last()
+    };
+public:
+    SequenceRepairBuffer();
+    static TInt Diff(TUint aSeq, TUint aFrom); // signed distance from aFrom to aSeq
+    void SetLast(TUint aSeq); // only valid when Empty()
+    TUint Last() const;       // last frame output (or skipped)
+    TUint Next() const;       // frame needed to continue output
+    TUint Newest() const;     // latest frame held; Last() if Empty()
+    TUint Count() const;
+    TBool Empty() const;
+    TBool Contains(TUint aSeq) const;
+    EInsert Insert(T& aItem, TUint aSeq);
+    T* Pop();       // returns the frame following Last() and advances past it, or nullptr if it is missing
+    TUint SkipGap(); // gives up on frames missing before the oldest held frame; returns the number given up
+    /*
+     * Finds the first run of missing frames at or after aFrom and before Newest().
+     * Returns false if there are none.  aStart and aEnd are inclusive.
+     */
+    TBool FindMissing(TUint aFrom, TUint& aStart, TUint& aEnd) const;
+private:
+    static TUint Inc(TUint aSeq);
+private:
+    T* iSlots[Capacity];
+    TUint iLast;
+    TUint iNewest;
+    TUint iCount;
+};
+
+// SequenceRepairBuffer
+
+template <class T, TUint Capacity, TUint SeqBits>
+SequenceRepairBuffer<T, Capacity, SeqBits>::SequenceRepairBuffer()
+    : iLast(0)
+    , iNewest(0)
+    , iCount(0)
+{
+    for (TUint i=0; i<Capacity; i++) {
+        iSlots[i] = nullptr;
+    }
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+TInt SequenceRepairBuffer<T, Capacity, SeqBits>::Diff(TUint aSeq, TUint aFrom)
+{ // static
+    const TUint diff = (aSeq - aFrom) & kSeqMask;
+    if (diff > (kSeqMask >> 1)) {
+        return static_cast<TInt>(static_cast<TInt64>(diff) - kSeqMask - 1);
+    }
+    return static_cast<TInt>(diff);
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+TUint SequenceRepairBuffer<T, Capacity, SeqBits>::Inc(TUint aSeq)
+{ // static
+    return (aSeq + 1) & kSeqMask;
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+void SequenceRepairBuffer<T, Capacity, SeqBits>::SetLast(TUint aSeq)
+{
+    ASSERT(iCount == 0);
+    iLast = aSeq & kSeqMask;
+    iNewest = iLast;
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+TUint SequenceRepairBuffer<T, Capacity, SeqBits>::Last() const
+{
+    return iLast;
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+TUint SequenceRepairBuffer<T, Capacity, SeqBits>::Next() const
+{
+    return Inc(iLast);
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+TUint SequenceRepairBuffer<T, Capacity, SeqBits>::Newest() const
+{
+    return (iCount == 0? iLast : iNewest);
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+TUint SequenceRepairBuffer<T, Capacity, SeqBits>::Count() const
+{
+    return iCount;
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+TBool SequenceRepairBuffer<T, Capacity, SeqBits>::Empty() const
+{
+    return iCount == 0;
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+TBool SequenceRepairBuffer<T, Capacity, SeqBits>::Contains(TUint aSeq) const
+{
+    const TInt diff = Diff(aSeq, iLast);
+    if (diff < 1 || diff > static_cast<TInt>(Capacity)) {
+        return false;
+    }
+    return iSlots[aSeq & kIndexMask] != nullptr;
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+typename SequenceRepairBuffer<T, Capacity, SeqBits>::EInsert SequenceRepairBuffer<T, Capacity, SeqBits>::Insert(T& aItem, TUint aSeq)
+{
+    const TInt diff = Diff(aSeq, iLast);
+    if (diff < 1) {
+        return eLate;
+    }
+    if (diff > static_cast<TInt>(Capacity)) {
+        return eTooFar;
+    }
+    T*& slot = iSlots[aSeq & kIndexMask];
+    if (slot != nullptr) {
+        return eDuplicate;
+    }
+    slot = &aItem;
+    if (iCount == 0 || Diff(aSeq, iNewest) > 0) {
+        iNewest = aSeq & kSeqMask;
+    }
+    iCount++;
+    return eStored;
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+T* SequenceRepairBuffer<T, Capacity, SeqBits>::Pop()
+{
+    if (iCount == 0) {
+        return nullptr;
+    }
+    const TUint next = Next();
+    T*& slot = iSlots[next & kIndexMask];
+    T* item = slot;
+    if (item != nullptr) {
+        slot = nullptr;
+        iLast = next;
+        iCount--;
+    }
+    return item;
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+TUint SequenceRepairBuffer<T, Capacity, SeqBits>::SkipGap()
+{
+    TUint skipped = 0;
+    if (iCount > 0) {
+        while (iSlots[Next() & kIndexMask] == nullptr) {
+            iLast = Next();
+            skipped++;
+        }
+    }
+    return skipped;
+}
+
+template <class T, TUint Capacity, TUint SeqBits>
+TBool SequenceRepairBuffer<T, Capacity, SeqBits>::FindMissing(TUint aFrom, TUint& aStart, TUint& aEnd) const
+{
+    if (iCount == 0) {
+        return false;
+    }
+    TUint seq = (Diff(aFrom, iLast) < 1? Next() : aFrom & kSeqMask);
+    for (; Diff(iNewest, seq) > 0; seq = Inc(seq)) {
+        if (iSlots[seq & kIndexMask] == nullptr) {
+            aStart = seq;
+            // iNewest is held so this terminates before reaching it
+            while (iSlots[Inc(seq) & kIndexMask] == nullptr) {
+                seq = Inc(seq);
+            }
+            aEnd = seq;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace Av
+} // namespace OpenHome
@@ -0,0 +1,240 @@
+#include <OpenHome/Av/Utils/StreamUrlCache.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Debug.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Debug.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+using namespace OpenHome::Media;
+
+// StreamUrlCache::Entry
+
+StreamUrlCache::Entry::Entry()
+    : iResolvedAtMs(0)
+    , iValid(false)
+{
+}
+
+void StreamUrlCache::Entry::Set(const Brx& aTrackUri, const Brx& aStreamUrl, TUint aTimeMs)
+{
+    iTrackUri.Replace(aTrackUri);
+    iStreamUrl.Replace(aStreamUrl);
+    iResolvedAtMs = aTimeMs;
+    iValid = true;
+}
+
+void StreamUrlCache::Entry::Clear()
+{
+    iTrackUri.SetBytes(0);
+    iStreamUrl.SetBytes(0);
+    iValid = false;
+}
+
+TBool StreamUrlCache::Entry::IsValid() const
+{
+    return iValid;
+}
+
+const Brx& StreamUrlCache::Entry::TrackUri() const
+{
+    return iTrackUri;
+}
+
+const Brx& StreamUrlCache::Entry::StreamUrl() const
+{
+    return iStreamUrl;
+}
+
+TUint StreamUrlCache::Entry::Age(TUint aNowMs) const
+{
+    return aNowMs - iResolvedAtMs; // unsigned arithmetic copes with Time::Now wrapping
+}
+
+
+// StreamUrlCache
+
+StreamUrlCache::StreamUrlCache(Environment& aEnv, const TChar* aId, const Brx& aScheme,
+                               IStreamUrlResolver& aResolver, TUint aExpiryMs)
+    : iEnv(aEnv)
+    , iLock("SURC")
+    , iScheme(aScheme)
+    , iResolver(aResolver)
+    , iExpiryMs(aExpiryMs)
+    , iPendingCount(0)
+    , iGeneration(0)
+    , iHits(0)
+    , iMisses(0)
+    , iLookAheadResolved(0)
+{
+    iThread = new ThreadFunctor(aId, MakeFunctor(*this, &StreamUrlCache::LookAheadThread), kPriorityLow);
+    iThread->Start();
+}
+
+StreamUrlCache::~StreamUrlCache()
+{
+    delete iThread;
+}
+
+TBool StreamUrlCache::TryGet(const Brx& aTrackUri, Bwx& aStreamUrl)
+{
+    AutoMutex _(iLock);
+    Entry* entry = FindLocked(aTrackUri);
+    if (entry == nullptr || entry->StreamUrl().Bytes() > aStreamUrl.MaxBytes()) {
+        iMisses++;
+        return false;
+    }
+    aStreamUrl.Replace(entry->StreamUrl());
+    iHits++;
+    LOG(kMedia, "StreamUrlCache::TryGet(%.*s) hit (hits=%u, misses=%u)\n", PBUF(aTrackUri), iHits, iMisses);
+    return true;
+}
+
+void StreamUrlCache::Add(const Brx& aTrackUri, const Brx& aStreamUrl)
+{
+    if (aTrackUri.Bytes() > kMaxTrackUriBytes || aStreamUrl.Bytes() > kMaxStreamUrlBytes) {
+        return;
+    }
+    AutoMutex _(iLock);
+    AddLocked(aTrackUri, aStreamUrl);
+}
+
+void StreamUrlCache::AddLocked(const Brx& aTrackUri, const Brx& aStreamUrl)
+{
+    const TUint now = Time::Now(iEnv);
+    Entry* entry = FindLocked(aTrackUri);
+    if (entry == nullptr) {
+        // use an empty slot if available, otherwise replace the oldest entry
+        entry = &iEntries[0];
+        for (TUint i=0; i<kMaxEntries; i++) {
+            if (!iEntries[i].IsValid()) {
+                entry = &iEntries[i];
+                break;
+            }
+            if (iEntries[i].Age(now) > entry->Age(now)) {
+                entry = &iEntries[i];
+            }
+        }
+    }
+    entry->Set(aTrackUri, aStreamUrl, now);
+}
+
+void StreamUrlCache::Remove(const Brx& aTrackUri)
+{
+    AutoMutex _(iLock);
+    Entry* entry = FindLocked(aTrackUri);
+    if (entry != nullptr) {
+        entry->Clear();
+    }
+}
+
+void StreamUrlCache::Clear()
+{
+    AutoMutex _(iLock);
+    for (TUint i=0; i<kMaxEntries; i++) {
+        iEntries[i].Clear();
+    }
+    iPendingCount = 0;
+    iGeneration++;
+}
+
+TUint StreamUrlCache::Hits() const
+{
+    AutoMutex _(iLock);
+    return iHits;
+}
+
+TUint StreamUrlCache::Misses() const
+{
+    AutoMutex _(iLock);
+    return iMisses;
+}
+
+TUint StreamUrlCache::LookAheadResolved() const
+{
+    AutoMutex _(iLock);
+    return iLookAheadResolved;
+}
+
+void StreamUrlCache::NotifyUpcomingTracks(const std::vector<Track*>& aTracks)
+{
+    TBool signal = false;
+    {
+        AutoMutex _(iLock);
+        // newer predictions replace any we haven't yet got round to resolving
+        iPendingCount = 0;
+        for (auto it=aTracks.begin(); it!=aTracks.end() && iPendingCount<kMaxLookAhead; ++it) {
+            const Brx& uri = (*it)->Uri();
+            if (uri.Bytes() <= iScheme.Bytes() || uri.Bytes() > kMaxTrackUriBytes ||
+                !uri.BeginsWith(iScheme) || uri[iScheme.Bytes()] != ':') {
+                continue;
+            }
+            if (FindLocked(uri) != nullptr) {
+                continue;
+            }
+            iPending[iPendingCount++].Replace(uri);
+        }
+        signal = (iPendingCount > 0);
+    }
+    if (signal) {
+        iThread->Signal();
+    }
+}
+
+StreamUrlCache::Entry* StreamUrlCache::FindLocked(const Brx& aTrackUri)
+{
+    const TUint now = Time::Now(iEnv);
+    for (TUint i=0; i<kMaxEntries; i++) {
+        Entry& entry = iEntries[i];
+        if (!entry.IsValid()) {
+            continue;
+        }
+        if (entry.Age(now) >= iExpiryMs) {
+            entry.Clear();
+            continue;
+        }
+        if (entry.TrackUri() == aTrackUri) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void StreamUrlCache::LookAheadThread()
+{
+    for (;;) {
+        iThread->Wait();
+        for (;;) {
+            TUint generation;
+            {
+                AutoMutex _(iLock);
+                if (iPendingCount == 0) {
+                    break;
+                }
+                iLookAheadUri.Replace(iPending[0]);
+                for (TUint i=1; i<iPendingCount; i++) {
+                    iPending[i-1].Replace(iPending[i]);
+                }
+                iPendingCount--;
+                if (FindLocked(iLookAheadUri) != nullptr) {
+                    continue;
+                }
+                generation = iGeneration;
+            }
+            if (iResolver.TryResolveStreamUrl(iLookAheadUri, iLookAheadUrl)) {
+                AutoMutex _(iLock);
+                if (generation != iGeneration) {
+                    // Clear() was called while we were resolving (e.g. credentials or quality changed)
+                    LOG(kMedia, "StreamUrlCache - discarding stale url for %.*s\n", PBUF(iLookAheadUri));
+                    continue;
+                }
+                AddLocked(iLookAheadUri, iLookAheadUrl);
+                iLookAheadResolved++;
+                LOG(kMedia, "StreamUrlCache - resolved %.*s in advance\n", PBUF(iLookAheadUri));
+            }
+        }
+    }
+}
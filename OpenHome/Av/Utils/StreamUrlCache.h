@@ -0,0 +1,89 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Av/TrackLookAhead.h>
+
+#include <vector>
+
+namespace OpenHome {
+    class Environment;
+namespace Av {
+
+class IStreamUrlResolver
+{
+public:
+    virtual ~IStreamUrlResolver() {}
+    virtual TBool TryResolveStreamUrl(const Brx& aTrackUri, Bwx& aStreamUrl) = 0;
+};
+
+/*
+ * Caches stream urls for services (Tidal, Qobuz, ...) that require an api call to convert
+ * a track uri into a url that can be streamed.
+ * Urls are only valid for a service-specific period so each entry is discarded aExpiryMs after being resolved.
+ * Upcoming tracks reported via ITrackLookAheadObserver are resolved in advance on a low priority thread.
+ * Clear() discards the result of any resolve that is already in progress.
+ */
+class StreamUrlCache : public ITrackLookAheadObserver, private INonCopyable
+{
+public:
+    static const TUint kMaxEntries = 8;
+    static const TUint kMaxLookAhead = 3;
+    static const TUint kMaxTrackUriBytes = 128;
+    static const TUint kMaxStreamUrlBytes = 1024;
+public:
+    StreamUrlCache(Environment& aEnv, const TChar* aId, const Brx& aScheme,
+                   IStreamUrlResolver& aResolver, TUint aExpiryMs);
+    ~StreamUrlCache();
+    TBool TryGet(const Brx& aTrackUri, Bwx& aStreamUrl);
+    void Add(const Brx& aTrackUri, const Brx& aStreamUrl);
+    void Remove(const Brx& aTrackUri);
+    void Clear();
+    TUint Hits() const;
+    TUint Misses() const;
+    TUint LookAheadResolved() const;
+private: // from ITrackLookAheadObserver
+    void NotifyUpcomingTracks(const std::vector<Media::Track*>& aTracks) override;
+private:
+    class Entry
+    {
+    public:
+        Entry();
+        void Set(const Brx& aTrackUri, const Brx& aStreamUrl, TUint aTimeMs);
+        void Clear();
+        TBool IsValid() const;
+        const Brx& TrackUri() const;
+        const Brx& StreamUrl() const;
+        TUint Age(TUint aNowMs) const;
+    private:
+        Bws<kMaxTrackUriBytes> iTrackUri;
+        Bws<kMaxStreamUrlBytes> iStreamUrl;
+        TUint iResolvedAtMs;
+        TBool iValid;
+    };
+private:
+    Entry* FindLocked(const Brx& aTrackUri);
+    void AddLocked(const Brx& aTrackUri, const Brx& aStreamUrl);
+    void LookAheadThread();
+private:
+    Environment& iEnv;
+    mutable Mutex iLock;
+    const Bws<16> iScheme;
+    IStreamUrlResolver& iResolver;
+    const TUint iExpiryMs;
+    Entry iEntries[kMaxEntries];
+    Bws<kMaxTrackUriBytes> iPending[kMaxLookAhead];
+    TUint iPendingCount;
+    TUint iGeneration; // incremented by Clear()
+    Bws<kMaxTrackUriBytes> iLookAheadUri;
+    Bws<kMaxStreamUrlBytes> iLookAheadUrl;
+    ThreadFunctor* iThread;
+    TUint iHits;
+    TUint iMisses;
+    TUint iLookAheadResolved;
+};
+
+} // namespace Av
+} // namespace OpenHome
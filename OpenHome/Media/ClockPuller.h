@@ -14,6 +14,35 @@ public:
     virtual void Stop() = 0;
 };
 
+/**
+ * Optional companion to IClockPuller for sources whose packets carry sender timestamps.
+ */
+class IClockPullerTimestamp
+{
+public:
+    virtual ~IClockPullerTimestamp() {}
+    /**
+     * Discard any timestamps reported so far.  Called when either end restarts its timestamper.
+     */
+    virtual void Reset() = 0;
+    /**
+     * Report when a single packet was sent and received.
+     *
+     * @param[in] aNetworkTimestamp  Sender's timestamp for the packet.
+     * @param[in] aRxTimestamp       Local timestamp for the packet, measured against the clock being pulled.
+     * @param[in] aSampleRate        Sample rate of the stream.  Both timestamps tick at Jiffies::SongcastTicksPerSecond(aSampleRate).
+     */
+    virtual void NotifyTimestamp(TUint aNetworkTimestamp, TUint aRxTimestamp, TUint aSampleRate) = 0;
+    /**
+     * Report the puller's estimate of the sender's clock rate relative to the (unpulled) local clock.
+     *
+     * @param[out] aPpm  Positive if the sender's clock runs faster than ours.
+     *
+     * @return  false if there isn't an estimate yet (e.g. not enough audio has been played).
+     */
+    virtual TBool TryGetDriftPpm(TInt& aPpm) const = 0;
+};
+
 class IPullableClock
 {
 public:
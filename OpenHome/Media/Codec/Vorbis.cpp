@@ -9,6 +9,7 @@
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Media/Debug.h>
 #include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Media/Utils/IcyMetadata.h>
 
 extern "C" {
 #include <ivorbisfile.h>
@@ -27,7 +28,6 @@ private:
     static const TUint kHeaderBytesReq = 14; // granule pos is byte 6:13 inclusive
     static const TUint kSearchChunkSize = 1024;
     static const TInt kInvalidBitstream;
-    static const TUint kIcyMetadataBytes = 255 * 16;
     static const TUint kBitDepth = 16;  // Bit depth always 16 for Vorbis.
 public:
     static const Brn kCodecVorbis;
@@ -77,8 +77,7 @@ private:
     TUint64 iTrackOffset;
     TUint64 iReadOffset;
     TInt iBitstream;
-    Bws<kIcyMetadataBytes> iIcyMetadata;
-    Bws<kIcyMetadataBytes> iNewIcyMetadata;
+    IcyMetadata iIcyMetadata;
 
     TBool iStreamEnded;
     TBool iNewStreamStarted;
@@ -252,7 +251,7 @@ void CodecVorbis::StreamInitialise()
     iBytesPerSec = iBitrateAverage/8; // bitrate of raw data rather than the output bitrate
     iTrackLengthJiffies = 0;
     iTrackOffset = 0;
-    iIcyMetadata.Replace(Brx::Empty());
+    iIcyMetadata.Reset();
 
     if (iController->StreamLength() > 0) {
         // Try do an out-of-band read and parse the final Ogg page ourselves to
@@ -573,22 +572,8 @@ void CodecVorbis::OutputMetaData()
     }
 
     if (artist != Brx::Empty() || title != Brx::Empty()) {
-        iNewIcyMetadata.Replace("<DIDL-Lite xmlns:dc='http://purl.org/dc/elements/1.1/' ");
-        iNewIcyMetadata.Append("xmlns:upnp='urn:schemas-upnp-org:metadata-1-0/upnp/' ");
-        iNewIcyMetadata.Append("xmlns='urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/'>");
-        iNewIcyMetadata.Append("<item id='' parentID='' restricted='True'><dc:title>");
-
-        iNewIcyMetadata.Append(artist);
-        if (artist != Brx::Empty() && title != Brx::Empty()) {
-            iNewIcyMetadata.Append(" - ");
-        }
-        iNewIcyMetadata.Append(title);
-
-        iNewIcyMetadata.Append("</dc:title><upnp:albumArtURI></upnp:albumArtURI>");
-        iNewIcyMetadata.Append("<upnp:class>object.item</upnp:class></item></DIDL-Lite>");
-        if (iNewIcyMetadata != iIcyMetadata) {
-            iIcyMetadata.Replace(iNewIcyMetadata);
-            iController->OutputMetaText(iIcyMetadata);
+        if (iIcyMetadata.SetTitle(artist, title)) {
+            iController->OutputMetaText(iIcyMetadata.Didl());
         }
     }
 }
@@ -1311,6 +1311,13 @@ public:
     virtual TUint NextFlushId() = 0;
 };
 
+class IPipelineBufferLevel
+{
+public:
+    virtual ~IPipelineBufferLevel() {}
+    virtual TUint BufferedJiffies() = 0; // estimate of audio that can be played before the pipeline starves
+};
+
 enum EStreamPlay
 {
     ePlayYes
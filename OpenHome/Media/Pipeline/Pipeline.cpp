@@ -36,6 +36,7 @@
 #include <OpenHome/Media/Debug.h>
 
 #include <algorithm>
+#include <climits>
 
 using namespace OpenHome;
 using namespace OpenHome::Media;
@@ -233,6 +234,7 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     , iWaiting(false)
     , iQuitting(false)
     , iNextFlushId(MsgFlush::kIdInvalid + 1)
+    , iStreamBitRate(0)
 {
     const TUint perStreamMsgCount = aInitParams->MaxStreamsPerReservoir() * kReservoirCount;
     TUint encodedAudioCount = ((aInitParams->EncodedReservoirBytes() + EncodedAudio::kMaxBytes - 1) / EncodedAudio::kMaxBytes); // this may only be required on platforms that don't guarantee priority based thread scheduling
@@ -786,6 +788,11 @@ TUint Pipeline::SenderMinLatencyMs() const
     return Jiffies::ToMs(kSenderMinLatency);
 }
 
+TUint Pipeline::SenderMaxLatencyMs() const
+{
+    return Jiffies::ToMs(iInitParams->MaxLatencyJiffies());
+}
+
 void Pipeline::GetThreadPriorityRange(TUint& aMin, TUint& aMax) const
 {
     aMax = iInitParams->ThreadPriorityStarvationRamper();
@@ -866,6 +873,19 @@ TUint Pipeline::NextFlushId()
     return id;
 }
 
+TUint Pipeline::BufferedJiffies()
+{
+    TUint64 jiffies = iDecodedAudioReservoir->SizeInJiffies();
+    jiffies += iStarvationRamper->SizeInJiffies();
+    const TUint bitRate = iStreamBitRate.load();
+    if (bitRate != 0) {
+        // encoded audio is only measured in bytes; convert using the bit rate of the current stream
+        const TUint64 encodedBits = static_cast<TUint64>(iEncodedAudioReservoir->SizeInBytes()) * 8;
+        jiffies += (encodedBits * Jiffies::kPerSecond) / bitRate;
+    }
+    return static_cast<TUint>(std::min(jiffies, static_cast<TUint64>(UINT_MAX)));
+}
+
 void Pipeline::PipelineWaiting(TBool aWaiting)
 {
     iLock.Wait();
@@ -926,6 +946,7 @@ void Pipeline::NotifyTime(TUint aSeconds, TUint aTrackDurationSeconds)
 
 void Pipeline::NotifyStreamInfo(const DecodedStreamInfo& aStreamInfo)
 {
+    iStreamBitRate.store(aStreamInfo.BitRate());
     iObserver.NotifyStreamInfo(aStreamInfo);
 }
 
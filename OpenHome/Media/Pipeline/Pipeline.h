@@ -12,6 +12,8 @@
 #include <OpenHome/Media/MuteManager.h>
 #include <OpenHome/Media/Pipeline/Attenuator.h>
 
+#include <atomic>
+
 EXCEPTION(PipelineStreamNotPausable)
 
 namespace OpenHome {
@@ -142,6 +144,7 @@ class IAnalogBypassVolumeRamper;
 class Pipeline : public IPipelineElementDownstream
                , public IPipeline
                , public IFlushIdProvider
+               , public IPipelineBufferLevel
                , public IWaiterObserver
                , public IStopper
                , public IMute
@@ -189,6 +192,7 @@ public:
     ITrackChangeObserver& TrackChangeObserver() const;
     IPipelineElementUpstream& InsertElements(IPipelineElementUpstream& aTail);
     TUint SenderMinLatencyMs() const;
+    TUint SenderMaxLatencyMs() const;
     void GetThreadPriorityRange(TUint& aMin, TUint& aMax) const;
     void GetThreadPriorities(TUint& aFlywheelRamper, TUint& aStarvationRamper, TUint& aCodec, TUint& aEvent);
     void LogBuffers() const;
@@ -199,6 +203,8 @@ public: // from IPipeline
     void SetAnimator(IPipelineAnimator& aAnimator) override;
 private: // from IFlushIdProvider
     TUint NextFlushId() override;
+public: // from IPipelineBufferLevel
+    TUint BufferedJiffies() override;
 private: // from IWaiterObserver
     void PipelineWaiting(TBool aWaiting) override;
 private: // from IStopper
@@ -318,6 +324,7 @@ private:
     TBool iWaiting;
     TBool iQuitting;
     TUint iNextFlushId;
+    std::atomic<TUint> iStreamBitRate;
 };
 
 } // namespace Media
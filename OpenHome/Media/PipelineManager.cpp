@@ -59,6 +59,8 @@ PipelineManager::PipelineManager(PipelineInitParams* aInitParams, IInfoAggregato
                          iPipeline->Factory(), aTrackFactory, *iPrefetchObserver,
                          *iIdManager, iFillerPriority, iPipeline->SenderMinLatencyMs() * Jiffies::kPerMs);
     iProtocolManager = new ProtocolManager(*iFiller, iPipeline->Factory(), *iIdManager, *iPipeline);
+    iProtocolManager->RegisterInfo(aInfoAggregator);
+    iProtocolManager->SetBufferLevel(*iPipeline);
     iFiller->Start(*iProtocolManager);
 }
 
@@ -285,6 +287,11 @@ TUint PipelineManager::SenderMinLatencyMs() const
     return iPipeline->SenderMinLatencyMs();
 }
 
+TUint PipelineManager::SenderMaxLatencyMs() const
+{
+    return iPipeline->SenderMaxLatencyMs();
+}
+
 void PipelineManager::GetThreadPriorityRange(TUint& aMin, TUint& aMax) const
 {
     iPipeline->GetThreadPriorityRange(aMin, aMax);
@@ -3,7 +3,11 @@
 #include <OpenHome/Exception.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Parser.h>
 #include <OpenHome/Media/Debug.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Timer.h>
+#include <OpenHome/Private/InfoProvider.h>
 
 #include <algorithm>
 
@@ -12,13 +16,18 @@ using namespace OpenHome::Media;
 
 // Protocol
 
-Protocol::Protocol(Environment& aEnv)
+Protocol::Protocol(Environment& aEnv, const TChar* aName)
     : iEnv(aEnv)
     , iProtocolManager(nullptr)
     , iIdProvider(nullptr)
     , iFlushIdProvider(nullptr)
     , iActive(false)
+    , iName(aName)
     , iLockActive("PROT")
+    , iStreams(0)
+    , iDispatchMs(0)
+    , iRejected(0)
+    , iRejectedMs(0)
 {
 }
 
@@ -40,10 +49,23 @@ ProtocolGetResult Protocol::DoGet(IWriter& aWriter, const Brx& aUri, TUint64 aOf
     return Get(aWriter, aUri, aOffset, aBytes);
 }
 
-ProtocolStreamResult Protocol::TryStream(const Brx& aUri)
+ProtocolStreamResult Protocol::TryStream(const Brx& aUri, TUint& aDispatchMs)
 {
     AutoStream a(*this);
-    return Stream(aUri);
+    const TUint startMs = Time::Now(iEnv);
+    const ProtocolStreamResult res = Stream(aUri);
+    AutoMutex _(iLockActive);
+    if (res == EProtocolErrorNotSupported) {
+        const TUint rejectedMs = Time::Now(iEnv) - startMs;
+        iRejected++;
+        iRejectedMs += rejectedMs;
+        aDispatchMs += rejectedMs;
+    }
+    else {
+        iStreams++;
+        iDispatchMs += aDispatchMs;
+    }
+    return res;
 }
 
 TBool Protocol::TrySetActive()
@@ -56,6 +78,24 @@ TBool Protocol::TrySetActive()
     return true;
 }
 
+const Brx& Protocol::Name() const
+{
+    return iName;
+}
+
+void Protocol::GetDispatchStats(TUint& aStreams, TUint& aDispatchMs, TUint& aRejected, TUint& aRejectedMs)
+{
+    AutoMutex _(iLockActive);
+    aStreams = iStreams;
+    aDispatchMs = iDispatchMs;
+    aRejected = iRejected;
+    aRejectedMs = iRejectedMs;
+}
+
+void Protocol::WriteInfo(IWriter& /*aWriter*/)
+{
+}
+
 EStreamPlay Protocol::OkToPlay(TUint aStreamId)
 {
     return iIdProvider->OkToPlay(aStreamId);
@@ -100,8 +140,8 @@ Protocol::AutoStream::~AutoStream()
 
 // ProtocolNetwork  
 
-ProtocolNetwork::ProtocolNetwork(Environment& aEnv)
-    : Protocol(aEnv)
+ProtocolNetwork::ProtocolNetwork(Environment& aEnv, const TChar* aName)
+    : Protocol(aEnv, aName)
     , iReaderBuf(iTcpClient)
     , iWriterBuf(iTcpClient)
     , iLock("PRNW")
@@ -219,6 +259,10 @@ void ContentProcessor::Reset()
     iReader = nullptr;
 }
 
+void ContentProcessor::Interrupt(TBool /*aInterrupt*/)
+{
+}
+
 void ContentProcessor::SetStream(IReader& aStream)
 {
     iReader = &aStream;
@@ -372,12 +416,17 @@ void ContentRecogBuf::ReadInterrupt()
 
 // ProtocolManager
 
+const Brn ProtocolManager::kQueryProtocols("protocols");
+
 ProtocolManager::ProtocolManager(IPipelineElementDownstream& aDownstream, MsgFactory& aMsgFactory, IPipelineIdProvider& aIdProvider, IFlushIdProvider& aFlushIdProvider)
     : iDownstream(aDownstream)
     , iMsgFactory(aMsgFactory)
     , iIdProvider(aIdProvider)
     , iFlushIdProvider(aFlushIdProvider)
+    , iBufferLevel(nullptr)
     , iLock("PMGR")
+    , iProtocolRouter(iLock)
+    , iContentRouter(iLock)
 {
     iAudioProcessor = new ContentAudio(aMsgFactory, aDownstream);
 }
@@ -397,24 +446,41 @@ ProtocolManager::~ProtocolManager()
 
 void ProtocolManager::Add(Protocol* aProtocol)
 {
+    ASSERT(iProtocols.size() < kMaxRouteTargets);
     iProtocols.push_back(aProtocol);
     aProtocol->Initialise(*this, iIdProvider, iMsgFactory, iDownstream, iFlushIdProvider);
 }
 
 void ProtocolManager::Add(ContentProcessor* aProcessor)
 {
+    ASSERT(iContentProcessors.size() < kMaxRouteTargets);
     iContentProcessors.push_back(aProcessor);
     aProcessor->Initialise(*this);
 }
 
+void ProtocolManager::RegisterInfo(IInfoAggregator& aInfoAggregator)
+{
+    std::vector<Brn> infoQueries;
+    infoQueries.push_back(kQueryProtocols);
+    aInfoAggregator.Register(*this, infoQueries);
+}
+
+void ProtocolManager::SetBufferLevel(IPipelineBufferLevel& aBufferLevel)
+{
+    iBufferLevel = &aBufferLevel;
+}
+
 void ProtocolManager::Interrupt(TBool aInterrupt)
 {
     /* Deliberately don't take iLock.  Avoids any possibility of deadlock with protocols
        who're holding a local lock while calling IProtocolManager::Stream.  iProtocols
-       never changes size/order so we can safely access it without locks. */
+       and iContentProcessors never change size/order so we can safely access them without locks. */
     for (auto it=iProtocols.begin(); it!=iProtocols.end(); ++it) {
         (*it)->Interrupt(aInterrupt);
     }
+    for (auto it=iContentProcessors.begin(); it!=iContentProcessors.end(); ++it) {
+        (*it)->Interrupt(aInterrupt);
+    }
 }
 
 TBool ProtocolManager::TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes)
@@ -433,15 +499,16 @@ ProtocolStreamResult ProtocolManager::DoStream(Track& aTrack)
 ProtocolStreamResult ProtocolManager::Stream(const Brx& aUri)
 {
     ProtocolStreamResult res = EProtocolErrorNotSupported;
+    const Brn scheme = SchemeKey(aUri);
+    const TUint64 deferred = iProtocolRouter.Deferred(scheme);
     const TUint count = iProtocols.size();
-    for (TUint i=0; i<count && res==EProtocolErrorNotSupported; i++) {
-        Protocol* protocol = iProtocols[i];
-        if (protocol->TrySetActive()) {
-            try {
-                res = protocol->TryStream(aUri);
+    TUint dispatchMs = 0;
+    // offer aUri in registration order, leaving protocols that have only ever rejected its scheme until last
+    for (TUint pass=0; pass<2; pass++) {
+        for (TUint i=0; i<count; i++) {
+            if (InPass(pass, deferred, i) && TryStream(i, scheme, aUri, dispatchMs, res)) {
+                return res;
             }
-            catch (UriError&) {}
-            ASSERT(res != EProtocolStreamErrorRecoverable);
         }
     }
     return res;
@@ -449,12 +516,14 @@ ProtocolStreamResult ProtocolManager::Stream(const Brx& aUri)
 
 ContentProcessor* ProtocolManager::GetContentProcessor(const Brx& aUri, const Brx& aMimeType, const Brx& aData) const
 {
+    const Brn key = ContentKey(aUri, aMimeType);
+    const TUint64 deferred = iContentRouter.Deferred(key);
     const TUint count = iContentProcessors.size();
-    for (TUint i=0; i<count; i++) {
-        ContentProcessor* processor = iContentProcessors[i];
-        if (!processor->IsActive() && processor->Recognise(aUri, aMimeType, aData)) {
-            processor->SetActive();
-            return processor;
+    for (TUint pass=0; pass<2; pass++) {
+        for (TUint i=0; i<count; i++) {
+            if (InPass(pass, deferred, i) && TryRecognise(i, key, aUri, aMimeType, aData)) {
+                return iContentProcessors[i];
+            }
         }
     }
     // unrecognised content (may well be audio)
@@ -466,18 +535,285 @@ ContentProcessor* ProtocolManager::GetAudioProcessor() const
     return iAudioProcessor;
 }
 
+TUint ProtocolManager::BufferedJiffies() const
+{
+    if (iBufferLevel == nullptr) {
+        return 0;
+    }
+    return iBufferLevel->BufferedJiffies();
+}
+
 TBool ProtocolManager::Get(IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes)
 {
     ProtocolGetResult res = EProtocolGetErrorNotSupported;
+    const Brn scheme = SchemeKey(aUri);
+    const TUint64 deferred = iProtocolRouter.Deferred(scheme);
     const TUint count = iProtocols.size();
-    for (TUint i=0; i<count && res==EProtocolGetErrorNotSupported; i++) {
-        Protocol* protocol = iProtocols[i];
-        if (protocol->TrySetActive()) {
-            try {
-                res = protocol->DoGet(aWriter, aUri, aOffset, aBytes);
+    for (TUint pass=0; pass<2; pass++) {
+        for (TUint i=0; i<count; i++) {
+            if (InPass(pass, deferred, i) && TryGet(i, scheme, aWriter, aUri, aOffset, aBytes, res)) {
+                return (res == EProtocolGetSuccess);
             }
-            catch (UriError&) {}
         }
     }
-    return (res == EProtocolGetSuccess);
+    return false;
+}
+
+void ProtocolManager::QueryInfo(const Brx& aQuery, IWriter& aWriter)
+{
+    if (aQuery != kQueryProtocols) {
+        return;
+    }
+    WriterAscii writer(aWriter);
+    std::vector<Brn> names;
+    for (TUint i=0; i<iProtocols.size(); i++) {
+        TUint streams, dispatchMs, rejected, rejectedMs;
+        iProtocols[i]->GetDispatchStats(streams, dispatchMs, rejected, rejectedMs);
+        names.push_back(Brn(iProtocols[i]->Name()));
+        writer.Write(iProtocols[i]->Name());
+        writer.Write(Brn(": streams:"));
+        writer.WriteUint(streams);
+        writer.Write(Brn(" ("));
+        writer.WriteUint(dispatchMs);
+        writer.Write(Brn("ms dispatching), rejected:"));
+        writer.WriteUint(rejected);
+        writer.Write(Brn(" ("));
+        writer.WriteUint(rejectedMs);
+        writer.Write(Brn("ms)\n"));
+        iProtocols[i]->WriteInfo(aWriter);
+    }
+    writer.Write(Brn("Scheme routes - "));
+    iProtocolRouter.Write(aWriter, names);
+    writer.Write(Brn("Content routes - "));
+    iContentRouter.Write(aWriter, std::vector<Brn>()); // processors are unnamed so are listed by index
+}
+
+Brn ProtocolManager::SchemeKey(const Brx& aUri)
+{ // static
+    for (TUint i=0; i<aUri.Bytes() && i<=kMaxRouteKeyBytes; i++) {
+        if (aUri[i] == ':') {
+            return aUri.Split(0, i);
+        }
+    }
+    return Brn(Brx::Empty());
+}
+
+Brn ProtocolManager::ContentKey(const Brx& aUri, const Brx& aMimeType)
+{ // static
+    if (aMimeType.Bytes() > 0) {
+        // discard any parameters (e.g. "; charset=utf-8")
+        Parser parser(aMimeType);
+        Brn mimeType = parser.Next(';');
+        if (mimeType.Bytes() <= kMaxRouteKeyBytes) {
+            return mimeType;
+        }
+        return Brn(Brx::Empty());
+    }
+    // no mime type (e.g. file protocol) so use extension from path instead
+    TUint end = aUri.Bytes();
+    for (TUint i=0; i<aUri.Bytes(); i++) {
+        if (aUri[i] == '?' || aUri[i] == '#') {
+            end = i;
+            break;
+        }
+    }
+    for (TUint i=end; i>0; i--) {
+        const TByte ch = aUri[i-1];
+        if (ch == '/') {
+            break;
+        }
+        if (ch == '.') {
+            const TUint bytes = end - (i-1);
+            if (bytes > 1 && bytes <= kMaxRouteKeyBytes) {
+                return aUri.Split(i-1, bytes);
+            }
+            break;
+        }
+    }
+    return Brn(Brx::Empty());
+}
+
+TBool ProtocolManager::InPass(TUint aPass, TUint64 aDeferred, TUint aIndex)
+{ // static
+    // pass 0 offers everything that hasn't been deferred; pass 1 only the deferred
+    return (((aDeferred >> aIndex) & 1) == aPass);
+}
+
+TBool ProtocolManager::TryStream(TUint aIndex, const Brx& aScheme, const Brx& aUri, TUint& aDispatchMs, ProtocolStreamResult& aResult)
+{
+    Protocol* protocol = iProtocols[aIndex];
+    if (!protocol->TrySetActive()) {
+        return false;
+    }
+    aResult = EProtocolErrorNotSupported;
+    try {
+        aResult = protocol->TryStream(aUri, aDispatchMs);
+    }
+    catch (UriError&) {}
+    ASSERT(aResult != EProtocolStreamErrorRecoverable);
+    const TBool accepted = (aResult != EProtocolErrorNotSupported);
+    iProtocolRouter.Learn(aScheme, aIndex, accepted);
+    return accepted;
+}
+
+TBool ProtocolManager::TryGet(TUint aIndex, const Brx& aScheme, IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes, ProtocolGetResult& aResult)
+{
+    Protocol* protocol = iProtocols[aIndex];
+    if (!protocol->TrySetActive()) {
+        return false;
+    }
+    aResult = EProtocolGetErrorNotSupported;
+    try {
+        aResult = protocol->DoGet(aWriter, aUri, aOffset, aBytes);
+    }
+    catch (UriError&) {}
+    const TBool accepted = (aResult != EProtocolGetErrorNotSupported);
+    iProtocolRouter.Learn(aScheme, aIndex, accepted);
+    return accepted;
+}
+
+TBool ProtocolManager::TryRecognise(TUint aIndex, const Brx& aKey, const Brx& aUri, const Brx& aMimeType, const Brx& aData) const
+{
+    ContentProcessor* processor = iContentProcessors[aIndex];
+    if (processor->IsActive()) {
+        return false; // busy rather than rejecting aKey so don't learn anything
+    }
+    const TBool recognised = processor->Recognise(aUri, aMimeType, aData);
+    iContentRouter.Learn(aKey, aIndex, recognised);
+    if (recognised) {
+        processor->SetActive();
+    }
+    return recognised;
+}
+
+
+// ProtocolManager::Route
+
+ProtocolManager::Route::Route()
+    : iAccepted(0)
+    , iRejected(0)
+{
+}
+
+void ProtocolManager::Route::Set(const Brx& aKey)
+{
+    iKey.Replace(aKey);
+    iAccepted = 0;
+    iRejected = 0;
+}
+
+const Brx& ProtocolManager::Route::Key() const
+{
+    return iKey;
+}
+
+TUint64 ProtocolManager::Route::Accepted() const
+{
+    return iAccepted;
+}
+
+TUint64 ProtocolManager::Route::Deferred() const
+{
+    return iRejected & ~iAccepted;
+}
+
+void ProtocolManager::Route::Learn(TUint aIndex, TBool aAccepted)
+{
+    if (aAccepted) {
+        iAccepted |= (1ULL << aIndex);
+    }
+    else {
+        iRejected |= (1ULL << aIndex);
+    }
+}
+
+
+// ProtocolManager::Router
+
+ProtocolManager::Router::Router(Mutex& aLock)
+    : iLock(aLock)
+    , iCount(0)
+    , iHits(0)
+    , iMisses(0)
+{
+}
+
+TUint64 ProtocolManager::Router::Deferred(const Brx& aKey) const
+{
+    AutoMutex _(iLock);
+    const TUint index = Find(aKey);
+    return (index == kRouteNotFound? 0 : iRoutes[index].Deferred());
+}
+
+void ProtocolManager::Router::Learn(const Brx& aKey, TUint aIndex, TBool aAccepted)
+{
+    if (aKey.Bytes() == 0) {
+        return;
+    }
+    AutoMutex _(iLock);
+    TUint index = Find(aKey);
+    if (index == kRouteNotFound) {
+        if (iCount == kMaxRoutes) {
+            // unusual; uris/content for this key will continue to be offered to everything in order
+            if (aAccepted) {
+                iMisses++;
+            }
+            return;
+        }
+        index = iCount++;
+        iRoutes[index].Set(aKey);
+    }
+    Route& route = iRoutes[index];
+    if (aAccepted) {
+        // a hit means the target that accepted aKey had done so before
+        if ((route.Accepted() & (1ULL << aIndex)) != 0) {
+            iHits++;
+        }
+        else {
+            iMisses++;
+        }
+    }
+    route.Learn(aIndex, aAccepted);
+}
+
+void ProtocolManager::Router::Write(IWriter& aWriter, const std::vector<Brn>& aNames) const
+{
+    AutoMutex _(iLock);
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("hits:"));
+    writer.WriteUint(iHits);
+    writer.Write(Brn(", misses:"));
+    writer.WriteUint(iMisses);
+    writer.Write(Brn("\n"));
+    for (TUint i=0; i<iCount; i++) {
+        writer.Write(Brn("    "));
+        writer.Write(iRoutes[i].Key());
+        writer.Write(Brn(" ->"));
+        const TUint64 mask = iRoutes[i].Accepted();
+        for (TUint j=0; j<kMaxRouteTargets; j++) {
+            if ((mask & (1ULL << j)) != 0) {
+                writer.Write(Brn(" "));
+                if (j < aNames.size()) {
+                    writer.Write(aNames[j]);
+                }
+                else {
+                    writer.WriteUint(j);
+                }
+            }
+        }
+        writer.Write(Brn("\n"));
+    }
+}
+
+TUint ProtocolManager::Router::Find(const Brx& aKey) const
+{
+    if (aKey.Bytes() == 0) {
+        return kRouteNotFound;
+    }
+    for (TUint i=0; i<iCount; i++) {
+        if (Ascii::CaseInsensitiveEquals(iRoutes[i].Key(), aKey)) {
+            return i;
+        }
+    }
+    return kRouteNotFound;
 }
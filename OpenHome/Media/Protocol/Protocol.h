@@ -50,6 +50,8 @@ public:
     virtual ContentProcessor* GetContentProcessor(const Brx& aUri, const Brx& aMimeType, const Brx& aData) const = 0;
     virtual ContentProcessor* GetAudioProcessor() const = 0;
     virtual TBool Get(IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes) = 0;
+    // Estimate of audio already buffered downstream.  Returns 0 if unknown.
+    virtual TUint BufferedJiffies() const { return 0; }
 };
 
 /**
@@ -63,9 +65,32 @@ class Protocol : protected IStreamHandler, protected INonCopyable
 public:
     virtual ~Protocol();
     ProtocolGetResult DoGet(IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes);
-    ProtocolStreamResult TryStream(const Brx& aUri);
+    /**
+     * Offer a uri to Stream(), recording dispatch statistics.
+     *
+     * @param[in] aUri             Resource to be streamed.
+     * @param[in,out] aDispatchMs  Time already spent offering aUri to other protocols.  Any
+     *                             time spent here rejecting aUri is added to it.
+     */
+    ProtocolStreamResult TryStream(const Brx& aUri, TUint& aDispatchMs);
     void Initialise(IProtocolManager& aProtocolManager, IPipelineIdProvider& aIdProvider, MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream, IFlushIdProvider& aFlushIdProvider);
     TBool TrySetActive();
+    const Brx& Name() const;
+    /**
+     * Report dispatch statistics.
+     *
+     * @param[out] aStreams        Number of Stream() calls this protocol accepted.
+     * @param[out] aDispatchMs     Total time spent offering those streams to other protocols first.
+     * @param[out] aRejected       Number of Stream() calls that returned EProtocolErrorNotSupported.
+     * @param[out] aRejectedMs     Total time spent in rejected Stream() calls.
+     */
+    void GetDispatchStats(TUint& aStreams, TUint& aDispatchMs, TUint& aRejected, TUint& aRejectedMs);
+    /**
+     * Append any protocol-specific diagnostics to the response to an info query.
+     *
+     * This may be called from a different thread.  Default implementation writes nothing.
+     */
+    virtual void WriteInfo(IWriter& aWriter);
     /**
      * Interrupt any stream that is currently in-progress, or cancel a previous interruption.
      *
@@ -76,7 +101,7 @@ public:
      */
     virtual void Interrupt(TBool aInterrupt) = 0;
 protected:
-    Protocol(Environment& aEnv);
+    Protocol(Environment& aEnv, const TChar* aName); // aName is only used for diagnostics
 private: // from IStreamHandler
     EStreamPlay OkToPlay(TUint aStreamId) override;
     TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
@@ -131,7 +156,12 @@ protected:
     IFlushIdProvider* iFlushIdProvider;
     TBool iActive;
 private:
+    Brn iName;
     Mutex iLockActive;
+    TUint iStreams;
+    TUint iDispatchMs;
+    TUint iRejected;
+    TUint iRejectedMs;
 private:
     class AutoStream : private INonCopyable
     {
@@ -150,7 +180,7 @@ protected:
     static const TUint kWriteBufferBytes = 1024;
     static const TUint kConnectTimeoutMs = 3000;
 protected:
-    ProtocolNetwork(Environment& aEnv);
+    ProtocolNetwork(Environment& aEnv, const TChar* aName);
     TBool Connect(const OpenHome::Uri& aUri, TUint aDefaultPort, TUint aTimeoutMs = kConnectTimeoutMs);
 protected: // from Protocol
     void Interrupt(TBool aInterrupt) override;
@@ -180,6 +210,13 @@ public:
     virtual TBool Recognise(const Brx& aUri, const Brx& aMimeType, const Brx& aData) = 0;
     virtual void Reset();
     virtual ProtocolStreamResult Stream(IReader& aReader, TUint64 aTotalBytes) = 0;
+    /**
+     * Interrupt any blocking calls a Stream() call makes other than reads from its stream,
+     * or cancel a previous interruption.
+     *
+     * This may be called from a different thread.  Default implementation does nothing.
+     */
+    virtual void Interrupt(TBool aInterrupt);
 protected:
     void SetStream(IReader& aStream);
     Brn ReadLine(ReaderUntil& aReader, TUint64& aBytesRemaining);
@@ -215,14 +252,29 @@ private:
     TUint iBytesRemaining;
 };
 
-class ProtocolManager : public IUriStreamer, public IUrlBlockWriter, private IProtocolManager, private INonCopyable
+/**
+ * Owns all protocols and content processors.
+ *
+ * Uris (and content) are offered to protocols (and content processors) in the order they were
+ * added.  Each uri scheme, mime type (or file extension when no mime type is available) remembers
+ * which protocols/processors have accepted and rejected it.  Any that have only ever rejected a
+ * key are offered it last, after all others have rejected it too.
+ */
+class ProtocolManager : public IUriStreamer, public IUrlBlockWriter, private IProtocolManager, private IInfoProvider, private INonCopyable
 {
     static const TUint kMaxUriBytes = 1024;
+    static const TUint kMaxRouteKeyBytes = 64;
+    static const TUint kMaxRoutes = 32;
+    static const TUint kMaxRouteTargets = 64; // limited by bits in a route's mask
+public:
+    static const Brn kQueryProtocols;
 public:
     ProtocolManager(IPipelineElementDownstream& aDownstream, MsgFactory& aMsgFactory, IPipelineIdProvider& aIdProvider, IFlushIdProvider& aFlushIdProvider);
     virtual ~ProtocolManager();
     void Add(Protocol* aProtocol);
     void Add(ContentProcessor* aProcessor);
+    void RegisterInfo(IInfoAggregator& aInfoAggregator);
+    void SetBufferLevel(IPipelineBufferLevel& aBufferLevel);
 public: // from IUriStreamer
     ProtocolStreamResult DoStream(Track& aTrack) override;
     void Interrupt(TBool aInterrupt) override;
@@ -233,15 +285,60 @@ private: // from IProtocolManager
     ContentProcessor* GetContentProcessor(const Brx& aUri, const Brx& aMimeType, const Brx& aData) const override;
     ContentProcessor* GetAudioProcessor() const override;
     TBool Get(IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes) override;
+    TUint BufferedJiffies() const override;
+private: // from IInfoProvider
+    void QueryInfo(const Brx& aQuery, IWriter& aWriter) override;
+private:
+    class Route
+    {
+    public:
+        Route();
+        void Set(const Brx& aKey);
+        const Brx& Key() const;
+        TUint64 Accepted() const;
+        TUint64 Deferred() const; // targets that have only ever rejected this key
+        void Learn(TUint aIndex, TBool aAccepted);
+    private:
+        Bws<kMaxRouteKeyBytes> iKey;
+        TUint64 iAccepted;
+        TUint64 iRejected;
+    };
+    class Router : private INonCopyable
+    {
+        static const TUint kRouteNotFound = kMaxRoutes;
+    public:
+        Router(Mutex& aLock);
+        TUint64 Deferred(const Brx& aKey) const;
+        void Learn(const Brx& aKey, TUint aIndex, TBool aAccepted);
+        void Write(IWriter& aWriter, const std::vector<Brn>& aNames) const;
+    private:
+        TUint Find(const Brx& aKey) const;
+    private:
+        Mutex& iLock;
+        Route iRoutes[kMaxRoutes];
+        TUint iCount;
+        TUint iHits;
+        TUint iMisses;
+    };
+private:
+    static Brn SchemeKey(const Brx& aUri);
+    static Brn ContentKey(const Brx& aUri, const Brx& aMimeType);
+    static TBool InPass(TUint aPass, TUint64 aDeferred, TUint aIndex);
+    TBool TryStream(TUint aIndex, const Brx& aScheme, const Brx& aUri, TUint& aDispatchMs, ProtocolStreamResult& aResult);
+    TBool TryGet(TUint aIndex, const Brx& aScheme, IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes, ProtocolGetResult& aResult);
+    TBool TryRecognise(TUint aIndex, const Brx& aKey, const Brx& aUri, const Brx& aMimeType, const Brx& aData) const;
 private:
     IPipelineElementDownstream& iDownstream;
     MsgFactory& iMsgFactory;
     IPipelineIdProvider& iIdProvider;
     IFlushIdProvider& iFlushIdProvider;
+    IPipelineBufferLevel* iBufferLevel;
     mutable Mutex iLock;
     std::vector<Protocol*> iProtocols;
     std::vector<ContentProcessor*> iContentProcessors;
     ContentProcessor* iAudioProcessor;
+    Router iProtocolRouter;
+    mutable Router iContentRouter;
 };
 
 } // namespace Media
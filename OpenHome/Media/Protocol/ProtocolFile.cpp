@@ -67,7 +67,7 @@ Protocol* ProtocolFactory::NewFile(Environment& aEnv)
 // ProtocolFile
 
 ProtocolFile::ProtocolFile(Environment& aEnv)
-    : Protocol(aEnv)
+    : Protocol(aEnv, "file")
     , iLock("PRTF")
     , iSupply(nullptr)
     , iReaderBuf(iFileStream)
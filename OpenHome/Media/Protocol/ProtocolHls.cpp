@@ -776,7 +776,7 @@ void SegmentStreamer::EnsureSegmentIsReady()
 // ProtocolHls
 
 ProtocolHls::ProtocolHls(Environment& aEnv, IHlsReader* aReaderM3u, IHlsReader* aReaderSegment, IHlsTimer* aTimer, ISemaphore* aM3uReaderSem)
-    : Protocol(aEnv)
+    : Protocol(aEnv, "hls")
     , iHlsReaderM3u(aReaderM3u)
     , iHlsReaderSegment(aReaderSegment)
     , iSupply(nullptr)
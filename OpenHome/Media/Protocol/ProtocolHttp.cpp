@@ -7,9 +7,10 @@
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Uri.h>
 #include <OpenHome/Media/Debug.h>
-#include <OpenHome/Private/Parser.h>
 #include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Timer.h>
 #include <OpenHome/Media/SupplyAggregator.h>
+#include <OpenHome/Media/Utils/IcyMetadata.h>
 
 #include <algorithm>
 
@@ -30,9 +31,12 @@ private:
 
 class ProtocolHttp : public ProtocolNetwork, private IReader
 {
-    static const TUint kIcyMetadataBytes = 255 * 16;
     static const TUint kMaxUserAgentBytes = 64;
     static const TUint kMaxContentRecognitionBytes = 100;
+    static const TUint kResumeBackoffInitialMs = 50;
+    static const TUint kResumeBackoffMaxMs = 2000;
+    static const TUint kResumeBudgetMinMs = 2000;
+    static const TUint kResumeBudgetMaxMs = 30000;
 public:
     ProtocolHttp(Environment& aEnv, const Brx& aUserAgent);
     ~ProtocolHttp();
@@ -56,6 +60,7 @@ private:
     ProtocolGetResult DoGet(IWriter& aWriter, TUint64 aOffset, TUint aBytes);
     ProtocolStreamResult DoSeek(TUint64 aOffset);
     ProtocolStreamResult DoLiveStream();
+    ProtocolStreamResult DoResume();
     void StartStream();
     TUint WriteRequest(TUint64 aOffset);
     ProtocolStreamResult ProcessContent();
@@ -75,9 +80,7 @@ private:
     HttpHeaderTransferEncoding iHeaderTransferEncoding;
     HeaderIcyMetadata iHeaderIcyMetadata;
     Bws<kMaxUserAgentBytes> iUserAgent;
-    Bws<kIcyMetadataBytes> iIcyMetadata;
-    Bws<kIcyMetadataBytes> iNewIcyMetadata; // only used in a single function but too large to comfortably declare on the stack
-    Bws<kIcyMetadataBytes> iIcyData; // only used in a single function but too large to comfortably declare on the stack
+    IcyMetadata iIcyMetadata;
     OpenHome::Uri iUri;
     TUint64 iTotalStreamBytes;
     TUint64 iTotalBytes;
@@ -96,6 +99,8 @@ private:
     ContentProcessor* iContentProcessor;
     TUint iNextFlushId;
     Semaphore iSem;
+    Semaphore iResumeSem;
+    TUint iResumeCount;
 };
 
 };  // namespace Media
@@ -146,7 +151,7 @@ void HeaderIcyMetadata::Process(const Brx& aValue)
 // ProtocolHttp
 
 ProtocolHttp::ProtocolHttp(Environment& aEnv, const Brx& aUserAgent)
-    : ProtocolNetwork(aEnv)
+    : ProtocolNetwork(aEnv, "http")
     , iSupply(nullptr)
     , iWriterRequest(iWriterBuf)
     , iReaderUntil(iReaderBuf)
@@ -159,6 +164,8 @@ ProtocolHttp::ProtocolHttp(Environment& aEnv, const Brx& aUserAgent)
     , iStreamId(IPipelineIdProvider::kStreamIdInvalid)
     , iSeekable(false)
     , iSem("PRTH", 0)
+    , iResumeSem("PRTR", 0)
+    , iResumeCount(0)
 {
     iReaderResponse.AddHeader(iHeaderContentType);
     iReaderResponse.AddHeader(iHeaderContentLength);
@@ -185,6 +192,7 @@ void ProtocolHttp::Interrupt(TBool aInterrupt)
         if (aInterrupt) {
             iStopped = true;
             iSem.Signal(); // no need to check iLive - iSem will be cleared when this protocol is next reused anyway
+            iResumeSem.Signal();
         }
         iTcpClient.Interrupt(aInterrupt);
     }
@@ -234,14 +242,7 @@ ProtocolStreamResult ProtocolHttp::Stream(const Brx& aUri)
             res = DoSeek(iOffset);
         }
         else {
-            // FIXME - if stream is non-seekable, set ErrorUnrecoverable as soon as Connect succeeds
-            /* FIXME - reconnects should use extra http headers to check that content hasn't changed
-               since our first attempt at reading it.  Any change should result in ErrorUnrecoverable */
-            TUint code = WriteRequest(iOffset);
-            if (code != 0) {
-                iTotalBytes = iHeaderContentLength.ContentLength();
-                res = ProcessContent();
-            }
+            res = DoResume();
         }
         if (res == EProtocolStreamErrorUnrecoverable) {
             // FIXME - msg to indicate bad track
@@ -332,6 +333,7 @@ TUint ProtocolHttp::TrySeek(TUint aStreamId, TUint64 aOffset)
     }
 
     iTcpClient.Interrupt(true);
+    iResumeSem.Signal();
     return iNextFlushId;
 }
 
@@ -353,6 +355,7 @@ TUint ProtocolHttp::TryStop(TUint aStreamId)
     if (iLive) {
         iSem.Signal();
     }
+    iResumeSem.Signal();
     return iNextFlushId;
 }
 
@@ -394,9 +397,9 @@ void ProtocolHttp::Reinitialise(const Brx& aUri)
     iContentProcessor = nullptr;
     iNextFlushId = MsgFlush::kIdInvalid;
     (void)iSem.Clear();
+    (void)iResumeSem.Clear();
     iUri.Replace(aUri);
-    iIcyMetadata.SetBytes(0);
-    iNewIcyMetadata.SetBytes(0);
+    iIcyMetadata.Reset();
     iContentRecogBuf.ReadFlush();
 }
 
@@ -544,6 +547,52 @@ ProtocolStreamResult ProtocolHttp::DoLiveStream()
     return ProcessContent();
 }
 
+ProtocolStreamResult ProtocolHttp::DoResume()
+{
+    /* Reconnect at the first byte not yet delivered to the pipeline.  For seekable streams, the
+       server must return exactly the remainder of the content we were originally reading; any
+       other response implies the content has changed.  Seekable streams only retry for as long as
+       audio already buffered by the pipeline is likely to last - if we reconnect within this
+       budget the pipeline never starves and the drop is invisible downstream.
+       Non-seekable streams retry until stopped (as they always have). */
+    TUint budgetMs = Jiffies::ToMs(iProtocolManager->BufferedJiffies());
+    budgetMs = std::min(std::max(budgetMs, (TUint)kResumeBudgetMinMs), (TUint)kResumeBudgetMaxMs);
+    const TUint startMs = Time::Now(iEnv);
+    TUint delayMs = kResumeBackoffInitialMs;
+    for (TUint attempts=1;; attempts++) {
+        (void)iResumeSem.Clear();
+        if (iStopped || iSeek) {
+            return EProtocolStreamErrorRecoverable; // Stream() will handle the stop/seek
+        }
+        const TUint code = WriteRequest(iOffset);
+        if (code != 0) {
+            iTotalBytes = iHeaderContentLength.ContentLength();
+            // a range starting at byte 0 is the whole content so servers may reply with a plain 200
+            const TBool codeOk = (code == HttpStatus::kPartialContent.Code() ||
+                                  (iOffset == 0 && code == HttpStatus::kOk.Code()));
+            if (iSeekable && (!codeOk || iTotalBytes != iTotalStreamBytes - iOffset)) {
+                LOG(kMedia, "ProtocolHttp::DoResume content changed at offset %llu (code=%u, bytes=%llu)\n",
+                             iOffset, code, iTotalBytes);
+                return EProtocolStreamErrorUnrecoverable;
+            }
+            iResumeCount++;
+            LOG(kMedia, "ProtocolHttp::DoResume resumed at offset %llu after %u attempt(s), %ums (resumes=%u)\n",
+                         iOffset, attempts, Time::Now(iEnv) - startMs, iResumeCount);
+            return ProcessContent();
+        }
+        if (iSeekable && (Time::Now(iEnv) - startMs) + delayMs > budgetMs) {
+            LOG(kMedia, "ProtocolHttp::DoResume giving up at offset %llu after %u attempt(s) (budget=%ums)\n",
+                         iOffset, attempts, budgetMs);
+            return EProtocolStreamErrorUnrecoverable;
+        }
+        try {
+            iResumeSem.Wait(delayMs);
+        }
+        catch (Timeout&) {}
+        delayMs = std::min(delayMs * 2, (TUint)kResumeBackoffMaxMs);
+    }
+}
+
 void ProtocolHttp::StartStream()
 {
     LOG(kMedia, "ProtocolHttp::StartStream\n");
@@ -691,40 +740,17 @@ void ProtocolHttp::ExtractMetadata()
     TUint metadataBytes = metadata[0] * 16;
 
     if (metadataBytes != 0) {
-        iIcyData.SetBytes(0);
+        iIcyMetadata.BeginBlock();
         do {
             Brn buf = iContentRecogBuf.Read(metadataBytes);
             iOffset += buf.Bytes();
             metadataBytes -= buf.Bytes();
-            iIcyData.Append(buf);
+            iIcyMetadata.ProcessBlock(buf);
         } while (metadataBytes != 0);
 
-        iNewIcyMetadata.Replace("<DIDL-Lite xmlns:dc='http://purl.org/dc/elements/1.1/' ");
-        iNewIcyMetadata.Append("xmlns:upnp='urn:schemas-upnp-org:metadata-1-0/upnp/' ");
-        iNewIcyMetadata.Append("xmlns='urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/'>");
-        iNewIcyMetadata.Append("<item id='' parentID='' restricted='True'><dc:title>");
-
-        Parser data(iIcyData);
-        while(!data.Finished()) {
-            Brn name = data.Next('=');
-            if (name == Brn("StreamTitle")) {
-                // metadata is in the format: 'data';
-                // may contain single quote characters so seek to the semicolon and discard the trailing single quote
-                data.Next('\'');
-                Brn title = data.Next(';');
-                if (title.Bytes() > 1) {
-                    iNewIcyMetadata.Append(Brn(title.Ptr(), title.Bytes()-1));
-                }
-
-                iNewIcyMetadata.Append("</dc:title><upnp:albumArtURI></upnp:albumArtURI>");
-                iNewIcyMetadata.Append("<upnp:class>object.item</upnp:class></item></DIDL-Lite>");
-                if (iNewIcyMetadata != iIcyMetadata) {
-                    LOG(kMedia, "ProtocolHttp::ExtractMetadata() - %.*s\n", PBUF(iNewIcyMetadata));
-                    iIcyMetadata.Replace(iNewIcyMetadata);
-                    iSupply->OutputMetadata(iIcyMetadata);
-                }
-                break;
-            }
+        if (iIcyMetadata.EndBlock()) {
+            LOG(kMedia, "ProtocolHttp::ExtractMetadata() - %.*s\n", PBUF(iIcyMetadata.Didl()));
+            iSupply->OutputMetadata(iIcyMetadata.Didl());
         }
     }
 }
@@ -77,7 +77,7 @@ Protocol* ProtocolFactory::NewHttps(Environment& aEnv)
 // ProtocolHttps
 
 ProtocolHttps::ProtocolHttps(Environment& aEnv)
-    : Protocol(aEnv)
+    : Protocol(aEnv, "https")
     , iLock("PHTS")
     , iSupply(nullptr)
     , iSocket(aEnv, kReadBufferBytes)
@@ -2,6 +2,7 @@
 #include <OpenHome/Media/Protocol/ProtocolRtsp.h>
 #include <OpenHome/Media/Debug.h>
 #include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Stream.h>
 
 using namespace OpenHome;
 using namespace OpenHome::Media;
@@ -16,10 +17,11 @@ Protocol* ProtocolFactory::NewRtsp(Environment& aEnv, const Brx& aGuid)
 // ProtocolRtsp
 
 ProtocolRtsp::ProtocolRtsp(Environment& aEnv, const Brx& aGuid)
-    : ProtocolNetwork(aEnv)
+    : ProtocolNetwork(aEnv, "rtsp")
     , iEnv(aEnv)
     , iSupply(nullptr)
     , iRtspClient(iEnv, iReaderBuf, iWriterBuf, aGuid)
+    , iJitterBuffer(*this, kJitterBufferJiffies, kJitterBufferPackets, RtspClient::kReadBufferBytes)
 {
 }
 
@@ -57,6 +59,7 @@ ProtocolStreamResult ProtocolRtsp::Stream(const Brx& aUri)
     }
 
     ProtocolStreamResult res = DoStream();
+    iJitterBuffer.Reset(iSdpInfo.AudioClockRate());
 
     OutputStream();
 
@@ -91,7 +94,9 @@ ProtocolStreamResult ProtocolRtsp::Stream(const Brx& aUri)
         try {
             Brn data = iRtspClient.ReadRtsp(iSdpInfo);
             //Log::PrintHex(data);
-            iSupply->OutputData(data);
+            if (data.Bytes() > 0) {
+                iJitterBuffer.Push(iRtspClient.RtpSequenceNumber(), iRtspClient.RtpTimestamp(), data);
+            }
         }
         catch (ReaderError&) {
             LOG(kMedia, "<ProtocolRtsp::Stream Reader error\n");
@@ -102,6 +107,11 @@ ProtocolStreamResult ProtocolRtsp::Stream(const Brx& aUri)
             res = EProtocolStreamErrorUnrecoverable;
         }
     }
+    if (!iStopped) {
+        iJitterBuffer.Drain();
+    }
+    LOG(kMedia, "ProtocolRtsp::Stream RTP received=%u, lost=%u, reordered=%u, late=%u\n",
+                iJitterBuffer.Received(), iJitterBuffer.Lost(), iJitterBuffer.Reordered(), iJitterBuffer.Late());
     iSupply->Flush();
     iLock.Wait();
     if (iStopped) {
@@ -118,6 +128,32 @@ ProtocolGetResult ProtocolRtsp::Get(IWriter& /*aWriter*/, const Brx& /*aUri*/, T
     return EProtocolGetErrorNotSupported;
 }
 
+void ProtocolRtsp::WriteInfo(IWriter& aWriter)
+{
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("    RTP received:"));
+    writer.WriteUint(iJitterBuffer.Received());
+    writer.Write(Brn(", lost:"));
+    writer.WriteUint(iJitterBuffer.Lost());
+    writer.Write(Brn(", reordered:"));
+    writer.WriteUint(iJitterBuffer.Reordered());
+    writer.Write(Brn(", late:"));
+    writer.WriteUint(iJitterBuffer.Late());
+    writer.Write(Brn("\n"));
+}
+
+void ProtocolRtsp::OutputPacket(const Brx& aPayload)
+{
+    iSupply->OutputData(aPayload);
+}
+
+void ProtocolRtsp::OutputGap(TUint aPackets, TUint aJiffies)
+{
+    /* Payloads are encoded (ASF) so we can't splice silence into the stream here.
+       The codec resyncs on the next packet we output, skipping aJiffies of audio. */
+    LOG(kMedia, "ProtocolRtsp: %u RTP packet(s) lost (%ums)\n", aPackets, Jiffies::ToMs(aJiffies));
+}
+
 ProtocolStreamResult ProtocolRtsp::DoStream()
 {
     if (!Connect(iUri, kRtspPort))
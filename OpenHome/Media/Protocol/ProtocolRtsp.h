@@ -2,6 +2,7 @@
 
 #include <OpenHome/Media/Protocol/Protocol.h>
 #include <OpenHome/Media/Protocol/Rtsp.h>
+#include <OpenHome/Media/Protocol/RtpJitterBuffer.h>
 #include <OpenHome/Private/Env.h>
 #include <OpenHome/Private/Uri.h>
 #include <OpenHome/Media/SupplyAggregator.h>
@@ -9,8 +10,10 @@
 namespace OpenHome {
 namespace Media {
 
-class ProtocolRtsp : public ProtocolNetwork
+class ProtocolRtsp : public ProtocolNetwork, private IRtpPacketOutput
 {
+    static const TUint kJitterBufferJiffies = Jiffies::kPerMs * 500;
+    static const TUint kJitterBufferPackets = 32;
 public:
     static const TUint kRtspPort = 554;
 public:
@@ -20,6 +23,10 @@ private: // from Protocol
     void Initialise(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream) override;
     ProtocolStreamResult Stream(const Brx& aUri) override;
     ProtocolGetResult Get(IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes) override;
+    void WriteInfo(IWriter& aWriter) override;
+private: // from IRtpPacketOutput
+    void OutputPacket(const Brx& aPayload) override;
+    void OutputGap(TUint aPackets, TUint aJiffies) override;
 private:
     ProtocolStreamResult DoStream();
     void OutputStream();
@@ -31,6 +38,7 @@ private:
     Uri iUri;
     RtspClient iRtspClient;
     SdpInfo iSdpInfo;
+    RtpJitterBuffer iJitterBuffer;
     ReaderBuffer iAudio;
     ReaderBuffer iRtp;
     TUint iKeepAliveTime;
@@ -29,7 +29,7 @@ Protocol* ProtocolFactory::NewTone(Environment& aEnv)
 
 // ProtocolTone
 ProtocolTone::ProtocolTone(Environment& aEnv)
-    : Protocol(aEnv)
+    : Protocol(aEnv, "tone")
     , iLock("PRTN")
     , iSupply(nullptr)
     , iToneGenerators()
@@ -0,0 +1,252 @@
+#include <OpenHome/Media/Protocol/RtpJitterBuffer.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <algorithm>
+#include <climits>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// RtpJitterBuffer::Slot
+
+RtpJitterBuffer::Slot::Slot(TUint aMaxBytes)
+    : iPayload(std::min(aMaxBytes, (TUint)kInitialBytes))
+    , iMaxBytes(aMaxBytes)
+    , iSequenceNumber(0)
+    , iTimestamp(0)
+    , iFull(false)
+{
+}
+
+void RtpJitterBuffer::Slot::Set(TUint aSequenceNumber, TUint aTimestamp, const Brx& aPayload)
+{
+    if (aPayload.Bytes() > iPayload.MaxBytes()) {
+        ASSERT(aPayload.Bytes() <= iMaxBytes);
+        iPayload.Grow(aPayload.Bytes());
+    }
+    iPayload.Replace(aPayload);
+    iSequenceNumber = aSequenceNumber;
+    iTimestamp = aTimestamp;
+    iFull = true;
+}
+
+void RtpJitterBuffer::Slot::Clear()
+{
+    iPayload.SetBytes(0);
+    iFull = false;
+}
+
+TBool RtpJitterBuffer::Slot::IsFull() const
+{
+    return iFull;
+}
+
+TUint RtpJitterBuffer::Slot::SequenceNumber() const
+{
+    return iSequenceNumber;
+}
+
+TUint RtpJitterBuffer::Slot::Timestamp() const
+{
+    return iTimestamp;
+}
+
+const Brx& RtpJitterBuffer::Slot::Payload() const
+{
+    return iPayload;
+}
+
+
+// RtpJitterBuffer
+
+RtpJitterBuffer::RtpJitterBuffer(IRtpPacketOutput& aOutput, TUint aMaxJiffies, TUint aMaxPackets, TUint aMaxPacketBytes)
+    : iOutput(aOutput)
+    , iMaxJiffies(aMaxJiffies)
+    , iSlotMask(aMaxPackets - 1)
+{
+    ASSERT(aMaxPackets > 1);
+    ASSERT((aMaxPackets & iSlotMask) == 0); // power of two, so slots stay in step with sequence numbers as they wrap
+    ASSERT(aMaxPackets <= kSequenceNumberMask / 2);
+    iSlots.reserve(aMaxPackets);
+    for (TUint i=0; i<aMaxPackets; i++) {
+        iSlots.push_back(new Slot(aMaxPacketBytes));
+    }
+    Reset(1000);
+}
+
+RtpJitterBuffer::~RtpJitterBuffer()
+{
+    for (auto slot : iSlots) {
+        delete slot;
+    }
+}
+
+void RtpJitterBuffer::Reset(TUint aClockRate)
+{
+    ASSERT(aClockRate > 0);
+    for (auto slot : iSlots) {
+        slot->Clear();
+    }
+    iClockRate = aClockRate;
+    iStarted = false;
+    iNextSequenceNumber = iHighestSequenceNumber = 0;
+    iHighestTimestamp = iLastTimestamp = 0;
+    iBuffered = 0;
+    iReceived = iLost = iReordered = iLate = 0;
+}
+
+void RtpJitterBuffer::Push(TUint aSequenceNumber, TUint aTimestamp, const Brx& aPayload)
+{
+    const TUint seq = aSequenceNumber & kSequenceNumberMask;
+    iReceived++;
+    if (!iStarted) {
+        iStarted = true;
+        iNextSequenceNumber = iHighestSequenceNumber = seq;
+        iHighestTimestamp = iLastTimestamp = aTimestamp;
+    }
+
+    const TInt window = (TInt)iSlots.size();
+    TInt delta = SequenceDelta(iNextSequenceNumber, seq);
+    if (delta < 0 && delta > -window) {
+        iLate++;
+        return;
+    }
+    if (delta < 0 || delta >= window) {
+        // too far from the packets we're holding to be reordered - output what we have then restart from this packet
+        Drain();
+        delta = SequenceDelta(iNextSequenceNumber, seq);
+        if (delta > 0) {
+            iLost += (TUint)delta;
+            iOutput.OutputGap(delta, ToJiffies(aTimestamp - iLastTimestamp));
+        }
+        iNextSequenceNumber = iHighestSequenceNumber = seq;
+        iHighestTimestamp = iLastTimestamp = aTimestamp;
+    }
+
+    Slot& slot = SlotFor(seq);
+    if (slot.IsFull() && slot.SequenceNumber() == seq) { // duplicate
+        iLate++;
+        return;
+    }
+    ASSERT(!slot.IsFull()); // held packets all lie within iSlots.size() of iNextSequenceNumber so never share a slot
+    if (SequenceDelta(iHighestSequenceNumber, seq) < 0) {
+        iReordered++;
+    }
+    else {
+        iHighestSequenceNumber = seq;
+        iHighestTimestamp = aTimestamp;
+    }
+    if (seq == iNextSequenceNumber) {
+        // the packet we're waiting for; output it without copying it into its slot
+        iOutput.OutputPacket(aPayload);
+        iLastTimestamp = aTimestamp;
+        iNextSequenceNumber = (iNextSequenceNumber + 1) & kSequenceNumberMask;
+    }
+    else {
+        slot.Set(seq, aTimestamp, aPayload);
+        iBuffered++;
+    }
+
+    OutputReady();
+    while (iBuffered > 0 && HeldJiffies() > iMaxJiffies) {
+        SkipMissing();
+        OutputReady();
+    }
+}
+
+void RtpJitterBuffer::Drain()
+{
+    OutputReady();
+    while (iBuffered > 0) {
+        SkipMissing();
+        OutputReady();
+    }
+}
+
+TUint RtpJitterBuffer::Received() const
+{
+    return iReceived;
+}
+
+TUint RtpJitterBuffer::Lost() const
+{
+    return iLost;
+}
+
+TUint RtpJitterBuffer::Reordered() const
+{
+    return iReordered;
+}
+
+TUint RtpJitterBuffer::Late() const
+{
+    return iLate;
+}
+
+TUint RtpJitterBuffer::BufferedPackets() const
+{
+    return iBuffered;
+}
+
+TInt RtpJitterBuffer::SequenceDelta(TUint aFrom, TUint aTo)
+{ // static
+    TInt delta = (TInt)((aTo - aFrom) & kSequenceNumberMask);
+    if (delta > (TInt)(kSequenceNumberMask / 2)) {
+        delta -= (TInt)(kSequenceNumberMask + 1);
+    }
+    return delta;
+}
+
+RtpJitterBuffer::Slot& RtpJitterBuffer::SlotFor(TUint aSequenceNumber)
+{
+    return *iSlots[aSequenceNumber & iSlotMask];
+}
+
+TUint RtpJitterBuffer::HeldJiffies() const
+{
+    if (iBuffered == 0) {
+        return 0;
+    }
+    return ToJiffies(iHighestTimestamp - iLastTimestamp);
+}
+
+TUint RtpJitterBuffer::ToJiffies(TUint aTimestampDelta) const
+{
+    const TUint64 jiffies = ((TUint64)aTimestampDelta * Jiffies::kPerSecond) / iClockRate;
+    return (TUint)std::min(jiffies, (TUint64)UINT_MAX);
+}
+
+void RtpJitterBuffer::OutputReady()
+{
+    for (;;) {
+        Slot& slot = SlotFor(iNextSequenceNumber);
+        if (!slot.IsFull() || slot.SequenceNumber() != iNextSequenceNumber) {
+            break;
+        }
+        iOutput.OutputPacket(slot.Payload());
+        iLastTimestamp = slot.Timestamp();
+        slot.Clear();
+        iBuffered--;
+        iNextSequenceNumber = (iNextSequenceNumber + 1) & kSequenceNumberMask;
+    }
+}
+
+void RtpJitterBuffer::SkipMissing()
+{
+    // the packet at the head of the buffer is missing; give up waiting for it (and any that follow it)
+    const TUint count = (TUint)iSlots.size();
+    for (TUint missing=1; missing<count; missing++) {
+        const TUint seq = (iNextSequenceNumber + missing) & kSequenceNumberMask;
+        const Slot& slot = SlotFor(seq);
+        if (slot.IsFull() && slot.SequenceNumber() == seq) {
+            iLost += missing;
+            iOutput.OutputGap(missing, ToJiffies(slot.Timestamp() - iLastTimestamp));
+            iNextSequenceNumber = seq;
+            return;
+        }
+    }
+    ASSERTS(); // only called when iBuffered>0 so should always find a held packet
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+
+#include <atomic>
+#include <vector>
+
+namespace OpenHome {
+namespace Media {
+
+class IRtpPacketOutput
+{
+public:
+    virtual ~IRtpPacketOutput() {}
+    virtual void OutputPacket(const Brx& aPayload) = 0;
+    virtual void OutputGap(TUint aPackets, TUint aJiffies) = 0; // aPackets were lost, covering (approx) aJiffies of audio
+};
+
+/*
+ * Reorders RTP packets by sequence number.
+ * Packets that arrive in order are passed on immediately.  If a packet is missing, later packets
+ * are held back until either the missing one arrives or the packets held cover more than
+ * aMaxJiffies (or all slots are in use).  The missing packet is then reported as a gap.
+ * Packets that arrive after their slot has been output (or reported as lost) are discarded.
+ *
+ * aMaxPackets must be a power of two.  Slots only allocate space for the largest packet they've
+ * held, up to aMaxPacketBytes, so a buffer that rarely reorders stays small.
+ * Push(), Drain() and Reset() must be called from a single thread.  Statistics can be read
+ * from any thread.
+ */
+class RtpJitterBuffer : private INonCopyable
+{
+    static const TUint kSequenceNumberMask = 0xffff;
+public:
+    RtpJitterBuffer(IRtpPacketOutput& aOutput, TUint aMaxJiffies, TUint aMaxPackets, TUint aMaxPacketBytes);
+    ~RtpJitterBuffer();
+    void Reset(TUint aClockRate);
+    void Push(TUint aSequenceNumber, TUint aTimestamp, const Brx& aPayload);
+    void Drain(); // output all held packets, reporting any remaining gaps
+    TUint Received() const;
+    TUint Lost() const;
+    TUint Reordered() const;
+    TUint Late() const;
+    TUint BufferedPackets() const;
+private:
+    class Slot
+    {
+        static const TUint kInitialBytes = 1500; // typical packet (ethernet mtu)
+    public:
+        Slot(TUint aMaxBytes);
+        void Set(TUint aSequenceNumber, TUint aTimestamp, const Brx& aPayload);
+        void Clear();
+        TBool IsFull() const;
+        TUint SequenceNumber() const;
+        TUint Timestamp() const;
+        const Brx& Payload() const;
+    private:
+        Bwh iPayload;
+        const TUint iMaxBytes;
+        TUint iSequenceNumber;
+        TUint iTimestamp;
+        TBool iFull;
+    };
+private:
+    static TInt SequenceDelta(TUint aFrom, TUint aTo);
+    Slot& SlotFor(TUint aSequenceNumber);
+    TUint HeldJiffies() const;
+    TUint ToJiffies(TUint aTimestampDelta) const;
+    void OutputReady();
+    void SkipMissing();
+private:
+    IRtpPacketOutput& iOutput;
+    const TUint iMaxJiffies;
+    std::vector<Slot*> iSlots;
+    const TUint iSlotMask;
+    TUint iClockRate;
+    TBool iStarted;
+    TUint iNextSequenceNumber;  // next packet to be output
+    TUint iHighestSequenceNumber;
+    TUint iHighestTimestamp;
+    TUint iLastTimestamp;       // of last packet output
+    std::atomic<TUint> iBuffered;
+    std::atomic<TUint> iReceived;
+    std::atomic<TUint> iLost;
+    std::atomic<TUint> iReordered;
+    std::atomic<TUint> iLate;
+};
+
+} // namespace Media
+} // namespace OpenHome
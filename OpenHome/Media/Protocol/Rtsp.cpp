@@ -305,6 +305,8 @@ RtspClient::RtspClient(Environment& aEnv, IReader& aReader, IWriter& aWriter, co
     , iReaderRequest(aEnv, iReaderUntil)
     , iReaderResponse(aEnv, iReaderUntil)
     , iSeq(1)
+    , iRtpSequenceNumber(0)
+    , iRtpTimestamp(0)
     , iGuid(aGuid)
 {
     iReaderRequest.AddMethod(RtspMethod::kSetParameter);
@@ -523,10 +525,22 @@ Brn RtspClient::ReadRtp()
     (void)iReaderUntil.Read(1); // channel
     ReaderBinary rb(iReaderUntil);
     TUint bytes = rb.ReadUintBe(2);
-    (void)iReaderUntil.ReadProtocol(16);
+    Brn header = iReaderUntil.ReadProtocol(16);
+    iRtpSequenceNumber = Converter::BeUint16At(header, 2);
+    iRtpTimestamp = Converter::BeUint32At(header, 4);
     return iReaderUntil.ReadProtocol(bytes - 16);
 }
 
+TUint RtspClient::RtpSequenceNumber() const
+{
+    return iRtpSequenceNumber;
+}
+
+TUint RtspClient::RtpTimestamp() const
+{
+    return iRtpTimestamp;
+}
+
 void RtspClient::ReadSdp(ISdpHandler& aSdpHandler)
 {
     aSdpHandler.Reset();
@@ -660,6 +674,11 @@ TUint SdpInfo::AudioStream() const
 {
     return iAudioStream;
 }
+
+TUint SdpInfo::AudioClockRate() const
+{
+    return iAudioClockRate;
+}
         
 const Brx& SdpInfo::SessionControlUri() const
 {
@@ -678,6 +697,7 @@ void SdpInfo::Reset()
     iAudioPgmpu.Replace(Brx::Empty());
     iAudioControlUri.Replace(Brx::Empty());
     iAudioStream = 0;
+    iAudioClockRate = kDefaultClockRate;
     iSessionControlUri.Replace(Brx::Empty());
 }
         
@@ -724,6 +744,9 @@ void SdpInfo::DecodeA(const Brx& aValue)
         else if (attribute == Brn("stream")) {
             DecodeAttributeAudioStream(remaining);
         }
+        else if (attribute == Brn("rtpmap")) {
+            DecodeAttributeAudioRtpmap(remaining);
+        }
     }
 }
 
@@ -752,6 +775,22 @@ void SdpInfo::DecodeAttributeAudioStream(const Brx& aValue)
     }
 }
 
+// a=rtpmap:<payload type> <encoding name>/<clock rate>[/<encoding parameters>]
+
+void SdpInfo::DecodeAttributeAudioRtpmap(const Brx& aValue)
+{
+    Parser parser(aValue);
+    (void)parser.Next('/'); // payload type and encoding name
+    try {
+        const TUint clockRate = Ascii::Uint(parser.Next('/'));
+        if (clockRate > 0) {
+            iAudioClockRate = clockRate;
+        }
+    }
+    catch (AsciiError&) {
+    }
+}
+
 void SdpInfo::DecodeAttributeSessionControl(const Brx& aValue)
 {
     iSessionControlUri.ReplaceThrow(aValue);
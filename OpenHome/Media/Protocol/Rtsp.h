@@ -180,6 +180,7 @@ class SdpInfo : public ISdpHandler
     static const TUint kMaxFmtpBytes = 80;
     static const TUint kMaxRsaaeskeyBytes = 512; //actually 16 I think - ToDo
     static const TUint kMaxAesivBytes = 16;
+    static const TUint kDefaultClockRate = 1000; // used by Windows Media Services (x-asf-pf)
 
 public:
     SdpInfo();
@@ -198,6 +199,7 @@ public:
     const Brx& Rsaaeskey() const;
     const Brx& Aesiv() const;
     TUint AudioStream() const;
+    TUint AudioClockRate() const;
     const Brx& SessionControlUri() const;
 
 private:
@@ -210,6 +212,7 @@ private:
     void DecodeAttributeAudioPgmpu(const Brx& aValue);
     void DecodeAttributeAudioControl(const Brx& aValue);
     void DecodeAttributeAudioStream(const Brx& aValue);
+    void DecodeAttributeAudioRtpmap(const Brx& aValue);
     void DecodeAttributeSessionControl(const Brx& aValue);
     void DecodeAttributeFmtp(const Brx& aValue);
     void DecodeAttributeRsaaeskey(const Brx& aValue);
@@ -228,6 +231,7 @@ private:
     Bws<kMaxAudioPgmpuBytes> iAudioPgmpu;
     Bws<kMaxAudioControlUriBytes> iAudioControlUri;
     TUint iAudioStream;
+    TUint iAudioClockRate;
     Bws<kMaxSessionControlUriBytes> iSessionControlUri;
     Bws<kMaxFmtpBytes> iFmtp;
     Bws<kMaxRsaaeskeyBytes> iRsaaeskey;
@@ -298,10 +302,12 @@ public:
     void Flush();
     void Interrupt();
 
-    Brn ReadRtsp(SdpInfo& aSdpInfo);
+    Brn ReadRtsp(SdpInfo& aSdpInfo); // returns an empty buffer if no RTP packet was read
     Brn ReadRtp();
     void ReadSdp(ISdpHandler& aSdpHandler);
     TUint Timeout() const;
+    TUint RtpSequenceNumber() const; // of the packet most recently returned by ReadRtp()
+    TUint RtpTimestamp() const;      // of the packet most recently returned by ReadRtp()
 private:
     WriterRtspRequest iWriterRequest;
     ReaderRtp iReaderRtp;
@@ -312,6 +318,8 @@ private:
     TUint iSeq;
     HttpHeaderContentLength iHeaderContentLength;
     HeaderRtspSession iHeaderRtspSession;
+    TUint iRtpSequenceNumber;
+    TUint iRtpTimestamp;
     const Bws<100> iGuid;         // unique; same GUID must be used for all requests in a single streaming session
 };
 
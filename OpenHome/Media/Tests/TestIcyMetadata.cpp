@@ -0,0 +1,255 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Media/Utils/IcyMetadata.h>
+#include <OpenHome/Buffer.h>
+
+#include <algorithm>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SuiteIcyMetadata : public SuiteUnitTest
+{
+public:
+    SuiteIcyMetadata();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    TBool ProcessBlock(const TChar* aBlock);
+    TBool ProcessBlockFragmented(const TChar* aBlock, TUint aFragmentBytes);
+    TBool DidlContainsTitle(const Brx& aTitle) const;
+    void TestTitleExtracted();
+    void TestTitleNotFirstKey();
+    void TestTitleContainingQuotes();
+    void TestTitleWithoutTrailingSemicolon();
+    void TestFragmentedBlock();
+    void TestNoTitleNotReported();
+    void TestUnchangedTitleNotReported();
+    void TestChangedTitleReported();
+    void TestEmptyTitle();
+    void TestResetReportsRepeatedTitle();
+    void TestLongTitleTruncated();
+    void TestMaxIcyTitleNotTruncated();
+    void TestHashCollisionReported();
+    void TestSetTitle();
+    void TestSetTitleArtistOnly();
+private:
+    IcyMetadata* iIcyMetadata;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// SuiteIcyMetadata
+
+SuiteIcyMetadata::SuiteIcyMetadata()
+    : SuiteUnitTest("SuiteIcyMetadata")
+{
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestTitleExtracted), "TestTitleExtracted");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestTitleNotFirstKey), "TestTitleNotFirstKey");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestTitleContainingQuotes), "TestTitleContainingQuotes");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestTitleWithoutTrailingSemicolon), "TestTitleWithoutTrailingSemicolon");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestFragmentedBlock), "TestFragmentedBlock");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestNoTitleNotReported), "TestNoTitleNotReported");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestUnchangedTitleNotReported), "TestUnchangedTitleNotReported");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestChangedTitleReported), "TestChangedTitleReported");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestEmptyTitle), "TestEmptyTitle");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestResetReportsRepeatedTitle), "TestResetReportsRepeatedTitle");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestLongTitleTruncated), "TestLongTitleTruncated");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestMaxIcyTitleNotTruncated), "TestMaxIcyTitleNotTruncated");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestHashCollisionReported), "TestHashCollisionReported");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestSetTitle), "TestSetTitle");
+    AddTest(MakeFunctor(*this, &SuiteIcyMetadata::TestSetTitleArtistOnly), "TestSetTitleArtistOnly");
+}
+
+void SuiteIcyMetadata::Setup()
+{
+    iIcyMetadata = new IcyMetadata();
+}
+
+void SuiteIcyMetadata::TearDown()
+{
+    delete iIcyMetadata;
+}
+
+TBool SuiteIcyMetadata::ProcessBlock(const TChar* aBlock)
+{
+    iIcyMetadata->BeginBlock();
+    iIcyMetadata->ProcessBlock(Brn(aBlock));
+    return iIcyMetadata->EndBlock();
+}
+
+TBool SuiteIcyMetadata::ProcessBlockFragmented(const TChar* aBlock, TUint aFragmentBytes)
+{
+    Brn block(aBlock);
+    iIcyMetadata->BeginBlock();
+    for (TUint offset=0; offset<block.Bytes(); offset+=aFragmentBytes) {
+        const TUint bytes = std::min(aFragmentBytes, block.Bytes() - offset);
+        iIcyMetadata->ProcessBlock(Brn(block.Ptr() + offset, bytes));
+    }
+    return iIcyMetadata->EndBlock();
+}
+
+TBool SuiteIcyMetadata::DidlContainsTitle(const Brx& aTitle) const
+{
+    Bws<IcyMetadata::kMaxDidlBytes> expected("<dc:title>");
+    expected.Append(aTitle);
+    expected.Append("</dc:title>");
+    const Brx& didl = iIcyMetadata->Didl();
+    if (!didl.BeginsWith(Brn("<DIDL-Lite"))) {
+        return false;
+    }
+    for (TUint i=0; i+expected.Bytes()<=didl.Bytes(); i++) {
+        if (didl.Split(i, expected.Bytes()) == expected) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SuiteIcyMetadata::TestTitleExtracted()
+{
+    TEST(ProcessBlock("StreamTitle='Artist - Song';"));
+    TEST(DidlContainsTitle(Brn("Artist - Song")));
+}
+
+void SuiteIcyMetadata::TestTitleNotFirstKey()
+{
+    TEST(ProcessBlock("StreamUrl='http://a.b/c';StreamTitle='Artist - Song';"));
+    TEST(DidlContainsTitle(Brn("Artist - Song")));
+}
+
+void SuiteIcyMetadata::TestTitleContainingQuotes()
+{
+    TEST(ProcessBlock("StreamTitle='Guns N' Roses - Sweet Child O' Mine';StreamUrl='';"));
+    TEST(DidlContainsTitle(Brn("Guns N' Roses - Sweet Child O' Mine")));
+}
+
+void SuiteIcyMetadata::TestTitleWithoutTrailingSemicolon()
+{
+    TEST(ProcessBlock("StreamTitle='Artist - Song'"));
+    TEST(DidlContainsTitle(Brn("Artist - Song")));
+}
+
+void SuiteIcyMetadata::TestFragmentedBlock()
+{
+    static const TChar* kBlock = "StreamUrl='x';StreamTitle='Guns N' Roses - Paradise City';";
+    for (TUint fragmentBytes=1; fragmentBytes<8; fragmentBytes++) {
+        iIcyMetadata->Reset();
+        TEST(ProcessBlockFragmented(kBlock, fragmentBytes));
+        TEST(DidlContainsTitle(Brn("Guns N' Roses - Paradise City")));
+    }
+}
+
+void SuiteIcyMetadata::TestNoTitleNotReported()
+{
+    TEST(!ProcessBlock("StreamUrl='http://a.b/c';"));
+    TEST(!ProcessBlock(""));
+}
+
+void SuiteIcyMetadata::TestUnchangedTitleNotReported()
+{
+    TEST(ProcessBlock("StreamTitle='Artist - Song';"));
+    TEST(!ProcessBlock("StreamTitle='Artist - Song';"));
+    TEST(!ProcessBlock("StreamTitle='Artist - Song';StreamUrl='';"));
+}
+
+void SuiteIcyMetadata::TestChangedTitleReported()
+{
+    TEST(ProcessBlock("StreamTitle='Artist - Song';"));
+    TEST(ProcessBlock("StreamTitle='Artist - Song2';"));
+    TEST(DidlContainsTitle(Brn("Artist - Song2")));
+    TEST(ProcessBlock("StreamTitle='Artist - Song';"));
+    TEST(DidlContainsTitle(Brn("Artist - Song")));
+}
+
+void SuiteIcyMetadata::TestEmptyTitle()
+{
+    TEST(ProcessBlock("StreamTitle='';"));
+    TEST(DidlContainsTitle(Brx::Empty()));
+    TEST(!ProcessBlock("StreamTitle='';"));
+}
+
+void SuiteIcyMetadata::TestResetReportsRepeatedTitle()
+{
+    TEST(ProcessBlock("StreamTitle='Artist - Song';"));
+    iIcyMetadata->Reset();
+    TEST(ProcessBlock("StreamTitle='Artist - Song';"));
+}
+
+void SuiteIcyMetadata::TestLongTitleTruncated()
+{
+    Bwh block(IcyMetadata::kMaxTitleBytes * 2 + 32);
+    block.Append("StreamTitle='");
+    for (TUint i=0; i<IcyMetadata::kMaxTitleBytes + 10; i++) {
+        block.Append('a');
+    }
+    block.Append("';");
+    iIcyMetadata->BeginBlock();
+    iIcyMetadata->ProcessBlock(block);
+    TEST(iIcyMetadata->EndBlock());
+    TEST(iIcyMetadata->Didl().Bytes() <= IcyMetadata::kMaxDidlBytes);
+
+    // titles differing only after the truncation point are still treated as changes
+    block.SetBytes(block.Bytes() - 3);
+    block.Append("b';");
+    iIcyMetadata->BeginBlock();
+    iIcyMetadata->ProcessBlock(block);
+    TEST(iIcyMetadata->EndBlock());
+}
+
+void SuiteIcyMetadata::TestMaxIcyTitleNotTruncated()
+{
+    Bwh block(255 * 16);
+    block.Append("StreamTitle='");
+    const TUint titleBytes = block.MaxBytes() - block.Bytes() - 2;
+    for (TUint i=0; i<titleBytes; i++) {
+        block.Append('a');
+    }
+    block.Append("';");
+    iIcyMetadata->BeginBlock();
+    iIcyMetadata->ProcessBlock(block);
+    TEST(iIcyMetadata->EndBlock());
+    TEST(DidlContainsTitle(block.Split(13, titleBytes)));
+}
+
+void SuiteIcyMetadata::TestHashCollisionReported()
+{
+    // "glbvs" and "yacxa" have the same length and FNV-1a hash
+    TEST(ProcessBlock("StreamTitle='glbvs';"));
+    TEST(ProcessBlock("StreamTitle='yacxa';"));
+    TEST(DidlContainsTitle(Brn("yacxa")));
+    TEST(!ProcessBlock("StreamTitle='yacxa';"));
+}
+
+void SuiteIcyMetadata::TestSetTitle()
+{
+    TEST(iIcyMetadata->SetTitle(Brn("Artist"), Brn("Song")));
+    TEST(DidlContainsTitle(Brn("Artist - Song")));
+    TEST(!iIcyMetadata->SetTitle(Brn("Artist"), Brn("Song")));
+    TEST(iIcyMetadata->SetTitle(Brx::Empty(), Brn("Song")));
+    TEST(DidlContainsTitle(Brn("Song")));
+}
+
+void SuiteIcyMetadata::TestSetTitleArtistOnly()
+{
+    TEST(iIcyMetadata->SetTitle(Brn("Artist"), Brx::Empty()));
+    TEST(DidlContainsTitle(Brn("Artist")));
+    // ICY titles share change detection with tags from other sources
+    TEST(!ProcessBlock("StreamTitle='Artist';"));
+}
+
+
+
+void TestIcyMetadata()
+{
+    Runner runner("IcyMetadata tests\n");
+    runner.Add(new SuiteIcyMetadata());
+    runner.Run();
+}
@@ -119,7 +119,7 @@ private:
     };
 public:
     TestHttpSessionReconnect();
-private:
+protected:
     void WriteResponsePartialContent(TUint aStartPos, TUint aEndPos, TUint aTotalLength, TUint aLength);
 private: // from TestHttpSession
     void Respond();
@@ -127,6 +127,17 @@ private:
     EMode iMode;
 };
 
+class TestHttpSessionResume : public TestHttpSessionReconnect
+{
+public:
+    TestHttpSessionResume(TBool aContentChanged);
+private: // from TestHttpSessionReconnect
+    void Respond();
+private:
+    const TBool iContentChanged;
+    TBool iBroken;
+};
+
 class TestHttpSessionStreamLive : public TestHttpSessionStreamFull
 {
 private:
@@ -237,7 +248,9 @@ public:
         eReconnect        = 2,
         eStreamLive       = 3,
         eLiveReconnect    = 4,
-        eChunked          = 5
+        eChunked          = 5,
+        eResume           = 6,
+        eResumeChanged    = 7
     };
 public:
     static TestHttpSession* Create(ESession aSession);
@@ -393,6 +406,22 @@ private: // from SuiteHttp
     void Test();
 };
 
+class SuiteHttpResume : public SuiteHttpStreamBase
+{
+public:
+    SuiteHttpResume();
+private: // from SuiteHttp
+    void Test();
+};
+
+class SuiteHttpResumeContentChanged : public SuiteHttpStreamBase
+{
+public:
+    SuiteHttpResumeContentChanged();
+private: // from SuiteHttp
+    void Test();
+};
+
 class SuiteHttpStreamLive : public SuiteHttpStreamBase
 {
 public:
@@ -733,6 +762,38 @@ void TestHttpSessionReconnect::Respond()
 }
 
 
+// TestHttpSessionResume
+
+TestHttpSessionResume::TestHttpSessionResume(TBool aContentChanged)
+    : iContentChanged(aContentChanged)
+    , iBroken(false)
+{
+}
+
+void TestHttpSessionResume::Respond()
+{
+    if (!iBroken) {
+        // seekable response, connection drops half way through
+        WriteResponsePartialContent(0, kStreamLen-1, kStreamLen, kStreamLen);
+        Stream(0, kStreamLen/2);
+        iBroken = true;
+    }
+    else if (!iHeaderRange.Received()) {
+        ASSERTS();
+    }
+    else if (iContentChanged) {
+        // server ignores the range, returning the (possibly different) content from its start
+        WriteResponseContentLength(kStreamLen);
+        Stream(0, kStreamLen);
+    }
+    else {
+        const TUint startByte = iHeaderRange.Start();
+        WriteResponsePartialContent(startByte, kStreamLen-1, kStreamLen, kStreamLen-startByte);
+        Stream(startByte, kStreamLen);
+    }
+}
+
+
 // TestHttpSessionStreamLive
 
 TestHttpSessionStreamLive::TestHttpSessionStreamLive()
@@ -956,6 +1017,10 @@ TestHttpSession* SessionFactory::Create(ESession aSession)
         return new TestHttpSessionLiveReconnect();
     case eChunked:
         return new TestHttpSessionChunked();
+    case eResume:
+        return new TestHttpSessionResume(false);
+    case eResumeChanged:
+        return new TestHttpSessionResume(true);
     default:
         ASSERTS();
         return nullptr;    // Will never reach here.
@@ -1359,6 +1424,55 @@ void SuiteHttpReconnect::Test()
 }
 
 
+// SuiteHttpResume
+
+SuiteHttpResume::SuiteHttpResume()
+    : SuiteHttpStreamBase("HTTP seekable stream resume tests", SessionFactory::eResume)
+{
+}
+
+void SuiteHttpResume::Test()
+{
+    Track* track = iTrackFactory->CreateTrack(iServer->ServingUri().AbsoluteUri(), Brx::Empty());
+    ProtocolStreamResult res = iProtocolManager->DoStream(*track);
+    track->RemoveRef();
+    TEST(res == EProtocolStreamSuccess);
+
+    // Test that the dropped connection was invisible to the pipeline (no second stream).
+    TEST(iSupply->TrackCount() == 1);
+    TEST(iSupply->StreamCount() == 1);
+    TEST(iSupply->Live() == false);
+
+    // Test that resuming neither lost nor repeated any data.
+    TUint streamSize = iHttpSession->DataSize();
+    TUint dataTotal = iSupply->DataTotal();
+    TEST(streamSize == dataTotal);
+}
+
+
+// SuiteHttpResumeContentChanged
+
+SuiteHttpResumeContentChanged::SuiteHttpResumeContentChanged()
+    : SuiteHttpStreamBase("HTTP seekable stream resume with changed content tests", SessionFactory::eResumeChanged)
+{
+}
+
+void SuiteHttpResumeContentChanged::Test()
+{
+    Track* track = iTrackFactory->CreateTrack(iServer->ServingUri().AbsoluteUri(), Brx::Empty());
+    ProtocolStreamResult res = iProtocolManager->DoStream(*track);
+    track->RemoveRef();
+    TEST(res == EProtocolStreamErrorUnrecoverable);
+
+    TEST(iSupply->TrackCount() == 1);
+    TEST(iSupply->StreamCount() == 1);
+
+    // Test that no content from the mismatched response was passed on.
+    TUint dataTotal = iSupply->DataTotal();
+    TEST(dataTotal == TestHttpSession::kStreamLen/2);
+}
+
+
 // SuiteHttpStreamLive
 
 SuiteHttpStreamLive::SuiteHttpStreamLive()
@@ -1554,6 +1668,8 @@ void TestProtocolHttp()
     runner.Add(new SuiteHttpStreamFull());
     runner.Add(new SuiteHttpReject());
     runner.Add(new SuiteHttpReconnect());
+    runner.Add(new SuiteHttpResume());
+    runner.Add(new SuiteHttpResumeContentChanged());
     runner.Add(new SuiteHttpStreamLive());
     runner.Add(new SuiteHttpLiveReconnect());
     runner.Add(new SuiteHttpChunked());
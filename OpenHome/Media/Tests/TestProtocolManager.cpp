@@ -0,0 +1,421 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Stream.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+namespace TestProtocolManager {
+
+class MockProtocol : public Protocol
+{
+public:
+    MockProtocol(Environment& aEnv, const TChar* aScheme);
+    IProtocolManager& Manager();
+    void SetSupported(TBool aSupported);
+    TUint StreamCount() const;
+    TUint GetCount() const;
+private: // from Protocol
+    void Interrupt(TBool aInterrupt) override;
+    void Initialise(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream) override;
+    ProtocolStreamResult Stream(const Brx& aUri) override;
+    ProtocolGetResult Get(IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes) override;
+private: // from IStreamHandler
+    TUint TryStop(TUint aStreamId) override;
+private:
+    TBool Supports(const Brx& aUri) const;
+private:
+    Bws<16> iScheme;
+    TBool iSupported;
+    TUint iStreamCount;
+    TUint iGetCount;
+};
+
+class MockContentProcessor : public ContentProcessor
+{
+public:
+    MockContentProcessor(const TChar* aMimeType, const TChar* aSignature);
+    TUint RecogniseCount() const;
+    void Deactivate();
+private: // from ContentProcessor
+    TBool Recognise(const Brx& aUri, const Brx& aMimeType, const Brx& aData) override;
+    ProtocolStreamResult Stream(IReader& aReader, TUint64 aTotalBytes) override;
+private:
+    Brn iMimeType;
+    Brn iSignature;
+    TUint iRecogniseCount;
+};
+
+class SuiteProtocolManager : public SuiteUnitTest
+                           , private IPipelineElementDownstream
+                           , private IPipelineIdProvider
+                           , private IFlushIdProvider
+                           , private IInfoAggregator
+{
+public:
+    SuiteProtocolManager(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private: // from IPipelineIdProvider
+    TUint NextStreamId() override;
+    EStreamPlay OkToPlay(TUint aStreamId) override;
+private: // from IFlushIdProvider
+    TUint NextFlushId() override;
+private: // from IInfoAggregator
+    void Register(IInfoProvider& aProvider, std::vector<Brn>& aSupportedQueries) override;
+private:
+    void TestUnsupportedSchemeProbesAll();
+    void TestSchemeRouted();
+    void TestRoutedProtocolRejectsFallsBack();
+    void TestBusyRoutedProtocolFallsBack();
+    void TestGetRouted();
+    void TestContentRoutedByMimeType();
+    void TestContentRoutedByExtension();
+    void TestContentUnrecognised();
+    void TestRegistrationOrderKept();
+    void TestDispatchStatsReported();
+private:
+    Environment& iEnv;
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    ProtocolManager* iProtocolManager;
+    MockProtocol* iProtocolA;
+    MockProtocol* iProtocolB;
+    MockProtocol* iProtocolC;
+    MockContentProcessor* iContentPls;
+    MockContentProcessor* iContentM3u;
+    IInfoProvider* iInfoProvider;
+};
+
+} // namespace TestProtocolManager
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestProtocolManager;
+
+
+// MockProtocol
+
+MockProtocol::MockProtocol(Environment& aEnv, const TChar* aScheme)
+    : Protocol(aEnv, aScheme)
+    , iScheme(aScheme)
+    , iSupported(true)
+    , iStreamCount(0)
+    , iGetCount(0)
+{
+}
+
+IProtocolManager& MockProtocol::Manager()
+{
+    return *iProtocolManager;
+}
+
+void MockProtocol::SetSupported(TBool aSupported)
+{
+    iSupported = aSupported;
+}
+
+TUint MockProtocol::StreamCount() const
+{
+    return iStreamCount;
+}
+
+TUint MockProtocol::GetCount() const
+{
+    return iGetCount;
+}
+
+void MockProtocol::Interrupt(TBool /*aInterrupt*/)
+{
+}
+
+void MockProtocol::Initialise(MsgFactory& /*aMsgFactory*/, IPipelineElementDownstream& /*aDownstream*/)
+{
+}
+
+ProtocolStreamResult MockProtocol::Stream(const Brx& aUri)
+{
+    iStreamCount++;
+    return (Supports(aUri)? EProtocolStreamSuccess : EProtocolErrorNotSupported);
+}
+
+ProtocolGetResult MockProtocol::Get(IWriter& /*aWriter*/, const Brx& aUri, TUint64 /*aOffset*/, TUint /*aBytes*/)
+{
+    iGetCount++;
+    return (Supports(aUri)? EProtocolGetSuccess : EProtocolGetErrorNotSupported);
+}
+
+TUint MockProtocol::TryStop(TUint /*aStreamId*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+TBool MockProtocol::Supports(const Brx& aUri) const
+{
+    return (iSupported && aUri.Bytes() > iScheme.Bytes() && aUri.BeginsWith(iScheme) && aUri[iScheme.Bytes()] == ':');
+}
+
+
+// MockContentProcessor
+
+MockContentProcessor::MockContentProcessor(const TChar* aMimeType, const TChar* aSignature)
+    : iMimeType(aMimeType)
+    , iSignature(aSignature)
+    , iRecogniseCount(0)
+{
+}
+
+TUint MockContentProcessor::RecogniseCount() const
+{
+    return iRecogniseCount;
+}
+
+void MockContentProcessor::Deactivate()
+{
+    Reset();
+}
+
+TBool MockContentProcessor::Recognise(const Brx& /*aUri*/, const Brx& aMimeType, const Brx& aData)
+{
+    iRecogniseCount++;
+    return (aMimeType.BeginsWith(iMimeType) || aData.BeginsWith(iSignature));
+}
+
+ProtocolStreamResult MockContentProcessor::Stream(IReader& /*aReader*/, TUint64 /*aTotalBytes*/)
+{
+    return EProtocolStreamSuccess;
+}
+
+
+// SuiteProtocolManager
+
+SuiteProtocolManager::SuiteProtocolManager(Environment& aEnv)
+    : SuiteUnitTest("SuiteProtocolManager")
+    , iEnv(aEnv)
+{
+    AddTest(MakeFunctor(*this, &SuiteProtocolManager::TestUnsupportedSchemeProbesAll), "TestUnsupportedSchemeProbesAll");
+    AddTest(MakeFunctor(*this, &SuiteProtocolManager::TestSchemeRouted), "TestSchemeRouted");
+    AddTest(MakeFunctor(*this, &SuiteProtocolManager::TestRoutedProtocolRejectsFallsBack), "TestRoutedProtocolRejectsFallsBack");
+    AddTest(MakeFunctor(*this, &SuiteProtocolManager::TestBusyRoutedProtocolFallsBack), "TestBusyRoutedProtocolFallsBack");
+    AddTest(MakeFunctor(*this, &SuiteProtocolManager::TestGetRouted), "TestGetRouted");
+    AddTest(MakeFunctor(*this, &SuiteProtocolManager::TestContentRoutedByMimeType), "TestContentRoutedByMimeType");
+    AddTest(MakeFunctor(*this, &SuiteProtocolManager::TestContentRoutedByExtension), "TestContentRoutedByExtension");
+    AddTest(MakeFunctor(*this, &SuiteProtocolManager::TestContentUnrecognised), "TestContentUnrecognised");
+    AddTest(MakeFunctor(*this, &SuiteProtocolManager::TestRegistrationOrderKept), "TestRegistrationOrderKept");
+    AddTest(MakeFunctor(*this, &SuiteProtocolManager::TestDispatchStatsReported), "TestDispatchStatsReported");
+}
+
+void SuiteProtocolManager::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgTrackCount(2);
+    init.SetMsgMetaTextCount(2);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iProtocolManager = new ProtocolManager(*this, *iMsgFactory, *this, *this);
+    iProtocolA = new MockProtocol(iEnv, "a");
+    iProtocolB = new MockProtocol(iEnv, "b");
+    iProtocolC = new MockProtocol(iEnv, "c");
+    iProtocolManager->Add(iProtocolA);
+    iProtocolManager->Add(iProtocolB);
+    iProtocolManager->Add(iProtocolC);
+    iContentPls = new MockContentProcessor("audio/x-scpls", "[playlist]");
+    iContentM3u = new MockContentProcessor("audio/x-mpegurl", "#EXTM3U");
+    iProtocolManager->Add(iContentPls);
+    iProtocolManager->Add(iContentM3u);
+    iInfoProvider = nullptr;
+}
+
+void SuiteProtocolManager::TearDown()
+{
+    delete iProtocolManager;
+    delete iMsgFactory;
+}
+
+void SuiteProtocolManager::Push(Msg* aMsg)
+{
+    aMsg->RemoveRef();
+}
+
+TUint SuiteProtocolManager::NextStreamId()
+{
+    return 1;
+}
+
+EStreamPlay SuiteProtocolManager::OkToPlay(TUint /*aStreamId*/)
+{
+    return ePlayYes;
+}
+
+TUint SuiteProtocolManager::NextFlushId()
+{
+    return 1;
+}
+
+void SuiteProtocolManager::Register(IInfoProvider& aProvider, std::vector<Brn>& /*aSupportedQueries*/)
+{
+    iInfoProvider = &aProvider;
+}
+
+void SuiteProtocolManager::TestUnsupportedSchemeProbesAll()
+{
+    TEST(iProtocolA->Manager().Stream(Brn("x://foo")) == EProtocolErrorNotSupported);
+    TEST(iProtocolA->StreamCount() == 1);
+    TEST(iProtocolB->StreamCount() == 1);
+    TEST(iProtocolC->StreamCount() == 1);
+    TEST(iProtocolA->Manager().Stream(Brn("x://foo")) == EProtocolErrorNotSupported);
+    TEST(iProtocolA->StreamCount() == 2);
+    TEST(iProtocolB->StreamCount() == 2);
+    TEST(iProtocolC->StreamCount() == 2);
+}
+
+void SuiteProtocolManager::TestSchemeRouted()
+{
+    TEST(iProtocolA->Manager().Stream(Brn("c://foo")) == EProtocolStreamSuccess);
+    TEST(iProtocolA->StreamCount() == 1);
+    TEST(iProtocolB->StreamCount() == 1);
+    TEST(iProtocolC->StreamCount() == 1);
+    TEST(iProtocolA->Manager().Stream(Brn("c://bar")) == EProtocolStreamSuccess);
+    TEST(iProtocolA->StreamCount() == 1);
+    TEST(iProtocolB->StreamCount() == 1);
+    TEST(iProtocolC->StreamCount() == 2);
+    // routes ignore case; protocols still decide whether they support a uri
+    TEST(iProtocolA->Manager().Stream(Brn("C://bar")) == EProtocolErrorNotSupported);
+    TEST(iProtocolC->StreamCount() == 3);
+    TEST(iProtocolA->StreamCount() == 2);
+}
+
+void SuiteProtocolManager::TestRoutedProtocolRejectsFallsBack()
+{
+    TEST(iProtocolA->Manager().Stream(Brn("b://foo")) == EProtocolStreamSuccess);
+    TEST(iProtocolA->StreamCount() == 1);
+    TEST(iProtocolB->StreamCount() == 1);
+    TEST(iProtocolC->StreamCount() == 0);
+    // a uri that the routed protocol rejects is still offered to all others
+    iProtocolB->SetSupported(false);
+    TEST(iProtocolA->Manager().Stream(Brn("b://foo")) == EProtocolErrorNotSupported);
+    TEST(iProtocolA->StreamCount() == 2);
+    TEST(iProtocolB->StreamCount() == 2);
+    TEST(iProtocolC->StreamCount() == 1);
+    // uris without a scheme are offered to all protocols
+    TEST(iProtocolA->Manager().Stream(Brn("b")) == EProtocolErrorNotSupported);
+    TEST(iProtocolA->StreamCount() == 3);
+    TEST(iProtocolB->StreamCount() == 3);
+    TEST(iProtocolC->StreamCount() == 2);
+}
+
+void SuiteProtocolManager::TestBusyRoutedProtocolFallsBack()
+{
+    TEST(iProtocolA->Manager().Stream(Brn("c://foo")) == EProtocolStreamSuccess);
+    TEST(iProtocolC->TrySetActive());
+    TEST(iProtocolA->Manager().Stream(Brn("c://foo")) == EProtocolErrorNotSupported);
+    TEST(iProtocolC->StreamCount() == 1);
+    TEST(iProtocolA->StreamCount() == 2);
+    TEST(iProtocolB->StreamCount() == 2);
+}
+
+void SuiteProtocolManager::TestGetRouted()
+{
+    Bws<16> buf;
+    WriterBuffer writer(buf);
+    TEST(iProtocolA->Manager().Get(writer, Brn("c://foo"), 0, 1));
+    TEST(iProtocolA->GetCount() == 1);
+    TEST(iProtocolB->GetCount() == 1);
+    TEST(iProtocolC->GetCount() == 1);
+    TEST(iProtocolA->Manager().Get(writer, Brn("c://foo"), 0, 1));
+    TEST(iProtocolA->GetCount() == 1);
+    TEST(iProtocolB->GetCount() == 1);
+    TEST(iProtocolC->GetCount() == 2);
+    // streaming shares routes learned by Get
+    TEST(iProtocolA->Manager().Stream(Brn("c://foo")) == EProtocolStreamSuccess);
+    TEST(iProtocolA->StreamCount() == 0);
+    TEST(iProtocolC->StreamCount() == 1);
+}
+
+void SuiteProtocolManager::TestContentRoutedByMimeType()
+{
+    IProtocolManager& pm = iProtocolA->Manager();
+    TEST(pm.GetContentProcessor(Brn("a://foo"), Brn("audio/x-mpegurl; charset=utf-8"), Brx::Empty()) == iContentM3u);
+    TEST(iContentPls->RecogniseCount() == 1);
+    TEST(iContentM3u->RecogniseCount() == 1);
+    iContentM3u->Deactivate();
+    TEST(pm.GetContentProcessor(Brn("a://bar"), Brn("audio/x-mpegurl"), Brx::Empty()) == iContentM3u);
+    TEST(iContentPls->RecogniseCount() == 1);
+    TEST(iContentM3u->RecogniseCount() == 2);
+}
+
+void SuiteProtocolManager::TestContentRoutedByExtension()
+{
+    IProtocolManager& pm = iProtocolA->Manager();
+    TEST(pm.GetContentProcessor(Brn("a://foo/list.m3u?x=y.pls"), Brx::Empty(), Brn("#EXTM3U\n")) == iContentM3u);
+    TEST(iContentPls->RecogniseCount() == 1);
+    iContentM3u->Deactivate();
+    TEST(pm.GetContentProcessor(Brn("a://bar/other.m3u"), Brx::Empty(), Brn("#EXTM3U\n")) == iContentM3u);
+    TEST(iContentPls->RecogniseCount() == 1);
+    TEST(iContentM3u->RecogniseCount() == 2);
+    iContentM3u->Deactivate();
+    // routed processor that fails to recognise the data doesn't prevent others being tried
+    TEST(pm.GetContentProcessor(Brn("a://bar/odd.m3u"), Brx::Empty(), Brn("[playlist]\n")) == iContentPls);
+}
+
+void SuiteProtocolManager::TestContentUnrecognised()
+{
+    IProtocolManager& pm = iProtocolA->Manager();
+    TEST(pm.GetContentProcessor(Brn("a://foo/track.mp3"), Brn("audio/mpeg"), Brn("ID3")) == nullptr);
+    TEST(iContentPls->RecogniseCount() == 1);
+    TEST(iContentM3u->RecogniseCount() == 1);
+}
+
+void SuiteProtocolManager::TestRegistrationOrderKept()
+{
+    IProtocolManager& pm = iProtocolA->Manager();
+    TEST(pm.GetContentProcessor(Brn("a://foo"), Brn("audio/x-scpls"), Brx::Empty()) == iContentPls);
+    // pls is busy so m3u is the only processor to have accepted this mime type...
+    TEST(pm.GetContentProcessor(Brn("a://bar"), Brn("audio/x-mpegurl"), Brn("[playlist]")) == iContentM3u);
+    iContentPls->Deactivate();
+    iContentM3u->Deactivate();
+    // ...but pls was registered first and has never rejected it so still takes priority
+    TEST(pm.GetContentProcessor(Brn("a://bar"), Brn("audio/x-mpegurl"), Brn("[playlist]")) == iContentPls);
+    TEST(iContentM3u->RecogniseCount() == 1);
+}
+
+void SuiteProtocolManager::TestDispatchStatsReported()
+{
+    (void)iProtocolA->Manager().Stream(Brn("c://foo"));
+    (void)iProtocolA->Manager().Stream(Brn("c://foo"));
+    iProtocolManager->RegisterInfo(*this);
+    TEST(iInfoProvider != nullptr);
+    Bws<1024> buf;
+    WriterBuffer writer(buf);
+    iInfoProvider->QueryInfo(ProtocolManager::kQueryProtocols, writer);
+    TEST(Brn(buf).BeginsWith(Brn("a: streams:0 (")));
+    TEST(Ascii::Contains(buf, Brn("    c -> c\n")));
+    TUint streams, dispatchMs, rejected, rejectedMs;
+    iProtocolC->GetDispatchStats(streams, dispatchMs, rejected, rejectedMs);
+    TEST(streams == 2);
+    TEST(rejected == 0);
+    iProtocolB->GetDispatchStats(streams, dispatchMs, rejected, rejectedMs);
+    TEST(streams == 0);
+    TEST(rejected == 1);
+}
+
+
+
+void TestProtocolManager(Environment& aEnv)
+{
+    Runner runner("ProtocolManager tests\n");
+    runner.Add(new SuiteProtocolManager(aEnv));
+    runner.Run();
+}
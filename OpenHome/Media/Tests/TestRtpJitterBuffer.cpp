@@ -0,0 +1,254 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Media/Protocol/RtpJitterBuffer.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Converter.h>
+#include <OpenHome/Private/Stream.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SuiteRtpJitterBuffer : public SuiteUnitTest, private IRtpPacketOutput
+{
+    static const TUint kClockRate = 1000;
+    static const TUint kPacketMs = 20;
+    static const TUint kMaxJiffies = Jiffies::kPerMs * 100;
+    static const TUint kMaxPackets = 16;
+    static const TUint kMaxPacketBytes = 16;
+    static const TUint kGap = 0xffffffff;
+public:
+    SuiteRtpJitterBuffer();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IRtpPacketOutput
+    void OutputPacket(const Brx& aPayload) override;
+    void OutputGap(TUint aPackets, TUint aJiffies) override;
+private:
+    void Push(TUint aSequenceNumber);
+    void TestInOrderPassedThrough();
+    void TestReordered();
+    void TestDuplicateDiscarded();
+    void TestLateDiscarded();
+    void TestGapReportedAfterMaxJiffies();
+    void TestDrainReportsGaps();
+    void TestSequenceNumberWraps();
+    void TestReorderedAcrossWrap();
+    void TestLargeJumpResyncs();
+private:
+    RtpJitterBuffer* iJitterBuffer;
+    std::vector<TUint> iOutput; // sequence numbers (taken from payloads) or kGap
+    TUint iGapPackets;
+    TUint iGapJiffies;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// SuiteRtpJitterBuffer
+
+const TUint SuiteRtpJitterBuffer::kGap;
+
+SuiteRtpJitterBuffer::SuiteRtpJitterBuffer()
+    : SuiteUnitTest("SuiteRtpJitterBuffer")
+{
+    AddTest(MakeFunctor(*this, &SuiteRtpJitterBuffer::TestInOrderPassedThrough), "TestInOrderPassedThrough");
+    AddTest(MakeFunctor(*this, &SuiteRtpJitterBuffer::TestReordered), "TestReordered");
+    AddTest(MakeFunctor(*this, &SuiteRtpJitterBuffer::TestDuplicateDiscarded), "TestDuplicateDiscarded");
+    AddTest(MakeFunctor(*this, &SuiteRtpJitterBuffer::TestLateDiscarded), "TestLateDiscarded");
+    AddTest(MakeFunctor(*this, &SuiteRtpJitterBuffer::TestGapReportedAfterMaxJiffies), "TestGapReportedAfterMaxJiffies");
+    AddTest(MakeFunctor(*this, &SuiteRtpJitterBuffer::TestDrainReportsGaps), "TestDrainReportsGaps");
+    AddTest(MakeFunctor(*this, &SuiteRtpJitterBuffer::TestSequenceNumberWraps), "TestSequenceNumberWraps");
+    AddTest(MakeFunctor(*this, &SuiteRtpJitterBuffer::TestReorderedAcrossWrap), "TestReorderedAcrossWrap");
+    AddTest(MakeFunctor(*this, &SuiteRtpJitterBuffer::TestLargeJumpResyncs), "TestLargeJumpResyncs");
+}
+
+void SuiteRtpJitterBuffer::Setup()
+{
+    iJitterBuffer = new RtpJitterBuffer(*this, kMaxJiffies, kMaxPackets, kMaxPacketBytes);
+    iJitterBuffer->Reset(kClockRate);
+    iOutput.clear();
+    iGapPackets = iGapJiffies = 0;
+}
+
+void SuiteRtpJitterBuffer::TearDown()
+{
+    delete iJitterBuffer;
+}
+
+void SuiteRtpJitterBuffer::OutputPacket(const Brx& aPayload)
+{
+    iOutput.push_back(Converter::BeUint32At(aPayload, 0));
+}
+
+void SuiteRtpJitterBuffer::OutputGap(TUint aPackets, TUint aJiffies)
+{
+    iOutput.push_back(kGap);
+    iGapPackets += aPackets;
+    iGapJiffies += aJiffies;
+}
+
+void SuiteRtpJitterBuffer::Push(TUint aSequenceNumber)
+{
+    Bws<4> payload;
+    WriterBuffer writerBuf(payload);
+    WriterBinary writer(writerBuf);
+    writer.WriteUint32Be(aSequenceNumber);
+    iJitterBuffer->Push(aSequenceNumber, aSequenceNumber * kPacketMs, payload);
+}
+
+void SuiteRtpJitterBuffer::TestInOrderPassedThrough()
+{
+    for (TUint i=0; i<5; i++) {
+        Push(i);
+        TEST(iOutput.size() == i+1);
+        TEST(iOutput[i] == i);
+    }
+    TEST(iJitterBuffer->BufferedPackets() == 0);
+    TEST(iJitterBuffer->Received() == 5);
+    TEST(iJitterBuffer->Lost() == 0);
+    TEST(iJitterBuffer->Reordered() == 0);
+}
+
+void SuiteRtpJitterBuffer::TestReordered()
+{
+    Push(0);
+    Push(2);
+    Push(3);
+    TEST(iOutput.size() == 1);
+    TEST(iJitterBuffer->BufferedPackets() == 2);
+    Push(1);
+    TEST(iOutput.size() == 4);
+    for (TUint i=0; i<4; i++) {
+        TEST(iOutput[i] == i);
+    }
+    TEST(iJitterBuffer->Reordered() == 1);
+    TEST(iJitterBuffer->Lost() == 0);
+}
+
+void SuiteRtpJitterBuffer::TestDuplicateDiscarded()
+{
+    Push(0);
+    Push(2);
+    Push(2);
+    Push(1);
+    TEST(iOutput.size() == 3);
+    TEST(iJitterBuffer->Late() == 1);
+}
+
+void SuiteRtpJitterBuffer::TestLateDiscarded()
+{
+    Push(0);
+    Push(1);
+    Push(1);
+    Push(0);
+    TEST(iOutput.size() == 2);
+    TEST(iJitterBuffer->Late() == 2);
+}
+
+void SuiteRtpJitterBuffer::TestGapReportedAfterMaxJiffies()
+{
+    static const TUint kLastHeld = (kMaxJiffies / Jiffies::kPerMs) / kPacketMs; // last packet we'll hold behind a gap
+    Push(0);
+    for (TUint i=2; i<=kLastHeld; i++) {
+        Push(i);
+    }
+    TEST(iOutput.size() == 1);
+    TEST(iGapPackets == 0);
+    Push(kLastHeld + 1); // exceeds kMaxJiffies - give up on packet 1
+    TEST(iGapPackets == 1);
+    TEST(iGapJiffies == 2 * kPacketMs * Jiffies::kPerMs);
+    TEST(iOutput.size() == kLastHeld + 2);
+    TEST(iOutput[1] == kGap);
+    TEST(iOutput[2] == 2);
+    TEST(iJitterBuffer->BufferedPackets() == 0);
+
+    // packet that has already been reported lost is discarded
+    Push(1);
+    TEST(iJitterBuffer->Late() == 1);
+    TEST(iJitterBuffer->Lost() == 1);
+}
+
+void SuiteRtpJitterBuffer::TestDrainReportsGaps()
+{
+    Push(0);
+    Push(3);
+    Push(5);
+    TEST(iOutput.size() == 1);
+    iJitterBuffer->Drain();
+    TEST(iOutput.size() == 5);
+    TEST(iOutput[1] == kGap);
+    TEST(iOutput[2] == 3);
+    TEST(iOutput[3] == kGap);
+    TEST(iOutput[4] == 5);
+    TEST(iJitterBuffer->Lost() == 3);
+    TEST(iJitterBuffer->BufferedPackets() == 0);
+}
+
+void SuiteRtpJitterBuffer::TestSequenceNumberWraps()
+{
+    Push(0xfffe);
+    Push(0x10000); // wraps to 0
+    Push(0xffff);
+    TEST(iOutput.size() == 3);
+    TEST(iOutput[0] == 0xfffe);
+    TEST(iOutput[1] == 0xffff);
+    TEST(iOutput[2] == 0x10000);
+    TEST(iJitterBuffer->Reordered() == 1);
+    TEST(iJitterBuffer->Lost() == 0);
+}
+
+void SuiteRtpJitterBuffer::TestReorderedAcrossWrap()
+{
+    // packets held either side of the wrap map to distinct slots
+    Push(0xfffd);
+    Push(0x10001);
+    Push(0xffff);
+    Push(0x10000);
+    TEST(iOutput.size() == 1);
+    TEST(iJitterBuffer->BufferedPackets() == 3);
+    Push(0xfffe);
+    TEST(iOutput.size() == 5);
+    TEST(iOutput[1] == 0xfffe);
+    TEST(iOutput[2] == 0xffff);
+    TEST(iOutput[3] == 0x10000);
+    TEST(iOutput[4] == 0x10001);
+    TEST(iJitterBuffer->Lost() == 0);
+    TEST(iJitterBuffer->Late() == 0);
+}
+
+void SuiteRtpJitterBuffer::TestLargeJumpResyncs()
+{
+    Push(0);
+    Push(1000);
+    TEST(iOutput.size() == 3);
+    TEST(iOutput[1] == kGap);
+    TEST(iOutput[2] == 1000);
+    TEST(iGapPackets == 999);
+    Push(1001);
+    TEST(iOutput.size() == 4);
+
+    // a large jump backwards (e.g. server restart) restarts without reporting a gap
+    Push(10);
+    Push(11);
+    TEST(iOutput.size() == 6);
+    TEST(iOutput[5] == 11);
+    TEST(iGapPackets == 999);
+}
+
+
+
+void TestRtpJitterBuffer()
+{
+    Runner runner("RtpJitterBuffer tests\n");
+    runner.Add(new SuiteRtpJitterBuffer());
+    runner.Run();
+}
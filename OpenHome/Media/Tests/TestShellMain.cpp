@@ -17,6 +17,8 @@ SIMPLE_TEST_DECLARATION(TestContainer);
 SIMPLE_TEST_DECLARATION(TestContentProcessor);
 SIMPLE_TEST_DECLARATION(TestDecodedAudioAggregator);
 SIMPLE_TEST_DECLARATION(TestIdProvider);
+SIMPLE_TEST_DECLARATION(TestIcyMetadata);
+SIMPLE_TEST_DECLARATION(TestRtpJitterBuffer);
 SIMPLE_TEST_DECLARATION(TestFiller);
 SIMPLE_TEST_DECLARATION(TestToneGenerator);
 SIMPLE_TEST_DECLARATION(TestMuteManager);
@@ -25,6 +27,7 @@ SIMPLE_TEST_DECLARATION(TestPipeline);
 SIMPLE_TEST_DECLARATION(TestPipelineConfig);
 SIMPLE_TEST_DECLARATION(TestPreDriver);
 SIMPLE_TEST_DECLARATION(TestProtocolHttp);
+ENV_TEST_DECLARATION(TestProtocolManager);
 SIMPLE_TEST_DECLARATION(TestRamper);
 SIMPLE_TEST_DECLARATION(TestReporter);
 SIMPLE_TEST_DECLARATION(TestRewinder);
@@ -43,6 +46,9 @@ SIMPLE_TEST_DECLARATION(TestStore);
 SIMPLE_TEST_DECLARATION(TestSupply);
 SIMPLE_TEST_DECLARATION(TestSupplyAggregator);
 SIMPLE_TEST_DECLARATION(TestTrackDatabase);
+SIMPLE_TEST_DECLARATION(TestTrackList);
+SIMPLE_TEST_DECLARATION(TestTrackDatabaseJournal);
+SIMPLE_TEST_DECLARATION(TestPresetDatabase);
 SIMPLE_TEST_DECLARATION(TestTrackInspector);
 SIMPLE_TEST_DECLARATION(TestUriProviderRepeater);
 SIMPLE_TEST_DECLARATION(TestVariableDelay);
@@ -53,6 +59,18 @@ CP_DV_TEST_DECLARATION(TestFriendlyNameManager);
 SIMPLE_TEST_DECLARATION(TestVolumeManager);
 ENV_TEST_DECLARATION(TestFlywheelRamper);
 ENV_TEST_DECLARATION(TestRaop);
+ENV_TEST_DECLARATION(TestStreamUrlCache);
+ENV_TEST_DECLARATION(TestUriRacer);
+SIMPLE_TEST_DECLARATION(TestOhmSenderSlaves);
+SIMPLE_TEST_DECLARATION(TestOhmLossless);
+SIMPLE_TEST_DECLARATION(TestOhmFec);
+SIMPLE_TEST_DECLARATION(TestOhmSenderHistory);
+SIMPLE_TEST_DECLARATION(TestClockPullerSongcast);
+SIMPLE_TEST_DECLARATION(TestFifoSpsc);
+SIMPLE_TEST_DECLARATION(TestSenderThread);
+SIMPLE_TEST_DECLARATION(TestResendPacer);
+SIMPLE_TEST_DECLARATION(TestSequenceRepairBuffer);
+SIMPLE_TEST_DECLARATION(TestOhmReceiverStats);
 ENV_TEST_DECLARATION(TestUdpServer);
 SIMPLE_TEST_DECLARATION(TestPowerManager);
 ENV_TEST_DECLARATION(TestProtocolHls);
@@ -82,6 +100,8 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
     shellTests.push_back(ShellTest("TestContentProcessor", ShellTestContentProcessor));
     shellTests.push_back(ShellTest("TestDecodedAudioAggregator", ShellTestDecodedAudioAggregator));
     shellTests.push_back(ShellTest("TestIdProvider", ShellTestIdProvider));
+    shellTests.push_back(ShellTest("TestIcyMetadata", ShellTestIcyMetadata));
+    shellTests.push_back(ShellTest("TestRtpJitterBuffer", ShellTestRtpJitterBuffer));
     shellTests.push_back(ShellTest("TestFiller", ShellTestFiller));
     shellTests.push_back(ShellTest("TestToneGenerator", ShellTestToneGenerator));
     shellTests.push_back(ShellTest("TestMuteManager", ShellTestMuteManager));
@@ -93,6 +113,7 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
     shellTests.push_back(ShellTest("TestSsl", ShellTestSsl));
     shellTests.push_back(ShellTest("TestPreDriver", ShellTestPreDriver));
     shellTests.push_back(ShellTest("TestProtocolHttp", ShellTestProtocolHttp));
+    shellTests.push_back(ShellTest("TestProtocolManager", ShellTestProtocolManager));
     shellTests.push_back(ShellTest("TestRamper", ShellTestRamper));
     shellTests.push_back(ShellTest("TestReporter", ShellTestReporter));
     shellTests.push_back(ShellTest("TestSampleRateValidator", ShellTestSampleRateValidator));
@@ -110,6 +131,9 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
     shellTests.push_back(ShellTest("TestSupply", ShellTestSupply));
     shellTests.push_back(ShellTest("TestSupplyAggregator", ShellTestSupplyAggregator));
     shellTests.push_back(ShellTest("TestTrackDatabase", ShellTestTrackDatabase));
+    shellTests.push_back(ShellTest("TestTrackList", ShellTestTrackList));
+    shellTests.push_back(ShellTest("TestTrackDatabaseJournal", ShellTestTrackDatabaseJournal));
+    shellTests.push_back(ShellTest("TestPresetDatabase", ShellTestPresetDatabase));
     shellTests.push_back(ShellTest("TestTrackInspector", ShellTestTrackInspector));
     shellTests.push_back(ShellTest("TestUriProviderRepeater", ShellTestUriProviderRepeater));
     shellTests.push_back(ShellTest("TestVariableDelay", ShellTestVariableDelay));
@@ -125,6 +149,18 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
     shellTests.push_back(ShellTest("TestVolumeManager", ShellTestVolumeManager));
     shellTests.push_back(ShellTest("TestFlywheelRamper", ShellTestFlywheelRamper));
     shellTests.push_back(ShellTest("TestRaop", ShellTestRaop));
+    shellTests.push_back(ShellTest("TestStreamUrlCache", ShellTestStreamUrlCache));
+    shellTests.push_back(ShellTest("TestUriRacer", ShellTestUriRacer));
+    shellTests.push_back(ShellTest("TestOhmSenderSlaves", ShellTestOhmSenderSlaves));
+    shellTests.push_back(ShellTest("TestOhmLossless", ShellTestOhmLossless));
+    shellTests.push_back(ShellTest("TestOhmFec", ShellTestOhmFec));
+    shellTests.push_back(ShellTest("TestOhmSenderHistory", ShellTestOhmSenderHistory));
+    shellTests.push_back(ShellTest("TestClockPullerSongcast", ShellTestClockPullerSongcast));
+    shellTests.push_back(ShellTest("TestFifoSpsc", ShellTestFifoSpsc));
+    shellTests.push_back(ShellTest("TestSenderThread", ShellTestSenderThread));
+    shellTests.push_back(ShellTest("TestResendPacer", ShellTestResendPacer));
+    shellTests.push_back(ShellTest("TestSequenceRepairBuffer", ShellTestSequenceRepairBuffer));
+    shellTests.push_back(ShellTest("TestOhmReceiverStats", ShellTestOhmReceiverStats));
     shellTests.push_back(ShellTest("TestWebAppFramework", ShellTestWebAppFramework));
 
     OpenHome::Media::ExecuteTestShell(aInitParams, shellTests);
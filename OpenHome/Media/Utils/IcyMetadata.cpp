@@ -0,0 +1,181 @@
+#include <OpenHome/Media/Utils/IcyMetadata.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// FNV-1a
+static const TUint kHashOffsetBasis = 2166136261u;
+static const TUint kHashPrime = 16777619u;
+
+// IcyMetadata
+
+IcyMetadata::IcyMetadata()
+{
+    Reset();
+}
+
+void IcyMetadata::Reset()
+{
+    BeginBlock();
+    iTitle.SetBytes(0);
+    iTitleHash = kHashOffsetBasis;
+    iTitleBytes = 0;
+    iReportedHash = 0;
+    iReportedBytes = 0;
+    iReported = false;
+    iDidl.SetBytes(0);
+    iReportedTitle.Set(Brx::Empty());
+}
+
+void IcyMetadata::BeginBlock()
+{
+    iKey.SetBytes(0);
+    iKeyOverflow = false;
+    iKeyIsTitle = false;
+    iState = EState::eKey;
+    iTitleFound = false;
+}
+
+void IcyMetadata::ProcessBlock(const Brx& aData)
+{
+    /* metadata is in the format Key1='value1';Key2='value2';
+       Values may contain single quote characters so only treat a quote followed by a semicolon as terminating.
+       The block is padded to a multiple of 16 bytes with nulls. */
+    const TByte* ptr = aData.Ptr();
+    const TByte* end = ptr + aData.Bytes();
+    for (; ptr < end && iState != EState::eDone; ptr++) {
+        const TByte b = *ptr;
+        switch (iState)
+        {
+        case EState::eKey:
+            if (b == '=') {
+                iKeyIsTitle = (!iKeyOverflow && iKey == Brn("StreamTitle"));
+                iState = EState::eValueStart;
+            }
+            else if (b == '\0' || b == ';' || b == ' ') {
+                // padding or separator
+            }
+            else if (iKey.Bytes() < iKey.MaxBytes()) {
+                iKey.Append(b);
+            }
+            else {
+                iKeyOverflow = true;
+            }
+            break;
+        case EState::eValueStart:
+            if (b == '\'') {
+                if (iKeyIsTitle) {
+                    StartTitle();
+                }
+                iState = EState::eValue;
+            }
+            break;
+        case EState::eValue:
+            if (b == '\'') {
+                iState = EState::eValueQuote;
+            }
+            else if (iKeyIsTitle) {
+                AppendTitle(b);
+            }
+            break;
+        case EState::eValueQuote:
+            if (b == ';' || b == '\0') {
+                if (iKeyIsTitle) {
+                    iTitleFound = true;
+                    iState = EState::eDone;
+                }
+                else {
+                    iKey.SetBytes(0);
+                    iKeyOverflow = false;
+                    iState = EState::eKey;
+                }
+            }
+            else {
+                if (iKeyIsTitle) {
+                    AppendTitle('\'');
+                }
+                if (b != '\'') {
+                    if (iKeyIsTitle) {
+                        AppendTitle(b);
+                    }
+                    iState = EState::eValue;
+                }
+            }
+            break;
+        case EState::eDone:
+            break;
+        }
+    }
+}
+
+TBool IcyMetadata::EndBlock()
+{
+    if (iKeyIsTitle && (iState == EState::eValue || iState == EState::eValueQuote)) {
+        iTitleFound = true; // unterminated title - report whatever we received
+    }
+    if (!iTitleFound) {
+        return false;
+    }
+    return CompleteTitle();
+}
+
+TBool IcyMetadata::SetTitle(const Brx& aArtist, const Brx& aTitle)
+{
+    StartTitle();
+    AppendTitle(aArtist);
+    if (aArtist.Bytes() > 0 && aTitle.Bytes() > 0) {
+        AppendTitle(Brn(" - "));
+    }
+    AppendTitle(aTitle);
+    return CompleteTitle();
+}
+
+const Brx& IcyMetadata::Didl() const
+{
+    return iDidl;
+}
+
+void IcyMetadata::StartTitle()
+{
+    iTitle.SetBytes(0);
+    iTitleHash = kHashOffsetBasis;
+    iTitleBytes = 0;
+}
+
+void IcyMetadata::AppendTitle(const Brx& aData)
+{
+    for (TUint i=0; i<aData.Bytes(); i++) {
+        AppendTitle(aData[i]);
+    }
+}
+
+void IcyMetadata::AppendTitle(TByte aByte)
+{
+    iTitleHash = (iTitleHash ^ aByte) * kHashPrime;
+    iTitleBytes++;
+    if (iTitle.Bytes() < iTitle.MaxBytes()) {
+        iTitle.Append(aByte);
+    }
+}
+
+TBool IcyMetadata::CompleteTitle()
+{
+    if (iReported && iTitleHash == iReportedHash && iTitleBytes == iReportedBytes && iTitle == iReportedTitle) {
+        return false;
+    }
+    iReportedHash = iTitleHash;
+    iReportedBytes = iTitleBytes;
+    iReported = true;
+
+    iDidl.Replace("<DIDL-Lite xmlns:dc='http://purl.org/dc/elements/1.1/' ");
+    iDidl.Append("xmlns:upnp='urn:schemas-upnp-org:metadata-1-0/upnp/' ");
+    iDidl.Append("xmlns='urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/'>");
+    iDidl.Append("<item id='' parentID='' restricted='True'><dc:title>");
+    iReportedTitle.Set(iDidl.Ptr() + iDidl.Bytes(), iTitle.Bytes());
+    iDidl.Append(iTitle);
+    iDidl.Append("</dc:title><upnp:albumArtURI></upnp:albumArtURI>");
+    iDidl.Append("<upnp:class>object.item</upnp:class></item></DIDL-Lite>");
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+ * Converts in-stream track titles (ICY metadata blocks, Vorbis comments) into DIDL-Lite.
+ * ICY blocks are parsed incrementally as they are read so callers don't need to buffer a
+ * complete (up to 4080 byte) block.  Each title is hashed as it is parsed; DIDL-Lite is
+ * only generated when the title differs from the previous one.  Titles are only compared
+ * byte-by-byte when their hashes match.
+ */
+class IcyMetadata : private INonCopyable
+{
+public:
+    // Largest possible ICY block, so ICY titles are never truncated.  Longer titles from other
+    // sources are truncated in the DIDL-Lite (but still hashed in full).
+    static const TUint kMaxTitleBytes = 255 * 16;
+    static const TUint kMaxDidlBytes = kMaxTitleBytes + 320; // title plus fixed DIDL-Lite wrapper
+public:
+    IcyMetadata();
+    void Reset();
+    // ICY metadata.  Call ProcessBlock any number of times (with consecutive fragments) between BeginBlock/EndBlock.
+    // EndBlock returns true if the block contained a StreamTitle that differs from the last title reported.
+    void BeginBlock();
+    void ProcessBlock(const Brx& aData);
+    TBool EndBlock();
+    // Tags from other sources.  Returns true if artist/title differ from the last title reported.
+    TBool SetTitle(const Brx& aArtist, const Brx& aTitle);
+    const Brx& Didl() const; // only valid after EndBlock/SetTitle have returned true
+private:
+    enum class EState
+    {
+        eKey,
+        eValueStart,
+        eValue,
+        eValueQuote,
+        eDone
+    };
+    static const TUint kMaxKeyBytes = 16;
+private:
+    void StartTitle();
+    void AppendTitle(const Brx& aData);
+    void AppendTitle(TByte aByte);
+    TBool CompleteTitle();
+private:
+    Bws<kMaxKeyBytes> iKey;
+    TBool iKeyOverflow;
+    TBool iKeyIsTitle;
+    EState iState;
+    TBool iTitleFound;
+    Bws<kMaxTitleBytes> iTitle;
+    TUint iTitleHash;
+    TUint iTitleBytes;
+    TUint iReportedHash;
+    TUint iReportedBytes;
+    TBool iReported;
+    Bws<kMaxDidlBytes> iDidl;
+    Brn iReportedTitle; // points into iDidl
+};
+
+} // namespace Media
+} // namespace OpenHome